@@ -0,0 +1,536 @@
+/*
+ * Behaviour tests for zalloc.h.
+ * Build and run with `make test`; test_zalloc_spin.c re-runs them on the spinlocked shared pool.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ZALLOC_IMPLEMENTATION
+#include "zalloc.h"
+#define ZTHREAD_IMPLEMENTATION
+#include "zthread.h"
+
+#define MT_THREADS 4
+#define MT_ROUNDS  400
+#define MT_LIVE    100
+
+static uint32_t rng_next(uint32_t *s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+
+// Thread arenas.
+
+typedef struct
+{
+    zarena *arena;
+    int *block;
+    int ok;
+} arena_job;
+
+static void arena_worker(void *arg)
+{
+    arena_job *j = (arena_job *)arg;
+    j->arena = zarena_thread();
+    assert(j->arena == zarena_thread());
+    j->block = (int *)zarena_alloc(j->arena, 64 * sizeof(int));
+    for (int i = 0; i < 64; i++)
+    {
+        j->block[i] = i;
+    }
+    j->ok = 1;
+    for (int i = 0; i < 64; i++)
+    {
+        j->ok &= (j->block[i] == i);
+    }
+    zarena_thread_free();
+    j->ok &= (0 == zarena_thread()->total_alloc);
+}
+
+static void test_thread_arena(void)
+{
+    zarena *mine = zarena_thread();
+    assert(mine == zarena_thread());
+    void *p = zarena_alloc(mine, 32);
+    assert(p);
+
+    zthread_t threads[MT_THREADS];
+    arena_job jobs[MT_THREADS];
+    memset(jobs, 0, sizeof(jobs));
+    for (int t = 0; t < MT_THREADS; t++)
+    {
+        assert(Z_OK == zthread_create(&threads[t], arena_worker, &jobs[t]));
+    }
+    for (int t = 0; t < MT_THREADS; t++)
+    {
+        zthread_join(threads[t]);
+    }
+    for (int t = 0; t < MT_THREADS; t++)
+    {
+        assert(jobs[t].ok);
+        assert(jobs[t].arena != mine);
+    }
+
+    // The other threads never touched this one's arena.
+    assert(mine->total_alloc >= 32);
+    zarena_thread_free();
+    assert(0 == mine->total_alloc && NULL == mine->first);
+}
+
+// Arena blocks, large allocations and marks.
+
+static size_t arena_blocks(const zarena_block *b)
+{
+    size_t n = 0;
+    for (; b; b = b->next)
+    {
+        n++;
+    }
+    return n;
+}
+
+static void test_arena_growth(void)
+{
+    zarena a;
+    zarena_init(&a);
+    for (int i = 0; i < 20000; i++)
+    {
+        uint8_t *p = (uint8_t *)zarena_alloc(&a, 100);
+        assert(p && 0 == (uintptr_t)p % ZARENA_MAX_ALIGN);
+        memset(p, i & 0xFF, 100);
+    }
+    assert(20000 * 100 == a.total_alloc);
+
+    // Blocks double from the default size and stop at the maximum.
+    size_t expect = ZARENA_DEFAULT_BLOCK_SIZE;
+    for (zarena_block *b = a.first; b; b = b->next)
+    {
+        assert(expect == b->capacity);
+        expect = (expect * 2 > ZARENA_MAX_BLOCK_SIZE) ? ZARENA_MAX_BLOCK_SIZE : expect * 2;
+    }
+    assert(NULL == a.large);
+
+    // The latest allocation grows in place; older ones are copied.
+    char *x = (char *)zarena_alloc(&a, 16);
+    memcpy(x, "0123456789abcde", 16);
+    assert(x == zarena_realloc(&a, x, 16, 64));
+    char *y = (char *)zarena_alloc(&a, 8);
+    char *z = (char *)zarena_realloc(&a, x, 64, 128);
+    assert(z != x && z != y && 0 == memcmp(z, "0123456789abcde", 16));
+    zarena_free(&a);
+}
+
+static void test_arena_large(void)
+{
+    zarena a;
+    zarena_init(&a);
+    uint8_t *small = (uint8_t *)zarena_alloc(&a, 64);
+    size_t big_size = 2 * ZARENA_MAX_BLOCK_SIZE;
+    uint8_t *big = (uint8_t *)zarena_alloc_align(&a, big_size, 64);
+    assert(big && 0 == (uintptr_t)big % 64);
+    memset(big, 1, big_size);
+
+    // The big request got a block of its own: the head keeps its free space and its size.
+    assert(1 == arena_blocks(a.first) && 1 == arena_blocks(a.large));
+    assert(ZARENA_DEFAULT_BLOCK_SIZE == a.first->capacity);
+    uint8_t *next = (uint8_t *)zarena_alloc(&a, 64);
+    assert(next == small + 64);
+
+    // Reset parks it for reuse instead of freeing it.
+    zarena_reset(&a);
+    assert(NULL == a.large && 1 == arena_blocks(a.large_free));
+    assert(big == zarena_alloc_align(&a, big_size, 64));
+    assert(NULL == a.large_free);
+
+    // A request that does not fit the parked blocks allocates a new one.
+    zarena_reset(&a);
+    uint8_t *bigger = (uint8_t *)zarena_alloc(&a, 2 * big_size);
+    assert(bigger && 1 == arena_blocks(a.large) && 1 == arena_blocks(a.large_free));
+    zarena_free(&a);
+    assert(NULL == a.first && NULL == a.large && NULL == a.large_free);
+}
+
+static void test_arena_marks(void)
+{
+    zarena a;
+    zarena_init(&a);
+
+    // A mark taken on an empty arena rolls back to the first block.
+    zarena_mark empty = zarena_save(&a);
+    void *first = zarena_alloc(&a, 32);
+    zarena_restore(&a, empty);
+    assert(0 == a.total_alloc && first == zarena_alloc(&a, 32));
+
+    zarena_mark outer = zarena_save(&a);
+    void *o1 = zarena_alloc(&a, 40);
+    assert(o1);
+    size_t blocks = 0;
+    void *spilled = NULL;
+    ZARENA_SCOPE(&a)
+    {
+        // Spill over several blocks and a large allocation, then give it all back.
+        for (int i = 0; i < 1000; i++)
+        {
+            spilled = zarena_alloc(&a, 512);
+        }
+        assert(zarena_alloc(&a, 2 * ZARENA_MAX_BLOCK_SIZE));
+        blocks = arena_blocks(a.first);
+        assert(blocks > 1 && a.large);
+    }
+    assert(32 + 40 == a.total_alloc && NULL == a.large);
+
+    // The same work again reuses the blocks kept past the mark.
+    ZARENA_SCOPE(&a)
+    {
+        void *last = NULL;
+        for (int i = 0; i < 1000; i++)
+        {
+            last = zarena_alloc(&a, 512);
+        }
+        assert(last == spilled);
+        assert(zarena_alloc(&a, 2 * ZARENA_MAX_BLOCK_SIZE));
+        assert(NULL == a.large_free);
+    }
+    assert(blocks == arena_blocks(a.first));
+
+    zarena_restore(&a, outer);
+    assert(32 == a.total_alloc);
+    assert(o1 == zarena_alloc(&a, 40));
+    zarena_free(&a);
+}
+
+static void test_arena_virtual(void)
+{
+    zarena a;
+    assert(-1 == zarena_init_virtual(&a, 0));
+    size_t reserve = 64 * ZARENA_COMMIT_SIZE;
+    if (0 != zarena_init_virtual(&a, reserve))
+    {
+        printf("zalloc: virtual arenas unsupported, skipped\n");
+        return;
+    }
+    assert(reserve == a.vm_reserved && 0 == a.vm_committed);
+
+    // One contiguous region, committed in ZARENA_COMMIT_SIZE steps as it fills.
+    uint8_t *base = (uint8_t *)zarena_alloc(&a, 100);
+    assert(base == a.vm_base && ZARENA_COMMIT_SIZE == a.vm_committed);
+    size_t step = (100 + ZARENA_MAX_ALIGN - 1) / ZARENA_MAX_ALIGN * ZARENA_MAX_ALIGN;
+    uint8_t *p = base;
+    for (int i = 1; i < 4000; i++)
+    {
+        uint8_t *q = (uint8_t *)zarena_alloc(&a, 100);
+        assert(q == p + step);
+        memset(q, 0xCD, 100);
+        p = q;
+    }
+    assert(0 == a.vm_committed % ZARENA_COMMIT_SIZE && a.vm_committed >= a.vm_used);
+    assert(NULL == a.first && NULL == a.large);
+
+    // The tail grows in place.
+    assert(p == zarena_realloc(&a, p, 100, 10000));
+
+    zarena_mark m = zarena_save(&a);
+    uint8_t *t = (uint8_t *)zarena_alloc(&a, 4096);
+    zarena_restore(&a, m);
+    assert(t == zarena_alloc(&a, 4096));
+
+    // Past the reservation the arena fails instead of growing.
+    assert(NULL == zarena_alloc(&a, reserve));
+    size_t committed = a.vm_committed;
+    zarena_reset(&a);
+    assert(base == zarena_alloc(&a, 100) && committed == a.vm_committed);
+    zarena_free(&a);
+    assert(NULL == a.vm_base);
+}
+
+// Sampling profiler.
+
+#define PROF_BLOCKS 100000
+#define PROF_SIZE   64
+#define PROF_RATE   4096
+
+typedef struct
+{
+    int line;
+    size_t live;
+    size_t total;
+    size_t sites;
+} prof_find;
+
+static void prof_visit(const zprof_site_info *site, void *user)
+{
+    prof_find *f = (prof_find *)user;
+    if (site->line == f->line && strstr(site->file, "test_zalloc"))
+    {
+        f->live += site->live_bytes;
+        f->total += site->total_bytes;
+        f->sites++;
+    }
+}
+
+static prof_find prof_lookup(int line)
+{
+    prof_find f = {line, 0, 0, 0};
+    zprof_foreach(prof_visit, &f);
+    return f;
+}
+
+static void prof_worker(void *arg)
+{
+    void **keep = (void **)arg;
+    for (int i = 0; i < 1000; i++)
+    {
+        zprof_free(zprof_malloc(PROF_SIZE));
+    }
+    *keep = zprof_malloc(PROF_RATE);
+}
+
+static size_t prof_tables(void)
+{
+    size_t n = 0;
+    for (zprof_table *tb = (zprof_table *)(uintptr_t)g_zprof_tables; tb; tb = tb->next)
+    {
+        n++;
+    }
+    return n;
+}
+
+static void test_prof(void)
+{
+    zprof_set_rate(PROF_RATE);
+    size_t base = zprof_live_bytes();
+    void **blocks = (void **)malloc(PROF_BLOCKS * sizeof(void *));
+    assert(blocks);
+
+    int line = __LINE__ + 3;
+    for (int i = 0; i < PROF_BLOCKS; i++)
+    {
+        blocks[i] = zprof_malloc(PROF_SIZE);
+        assert(blocks[i] && 0 == (uintptr_t)blocks[i] % 16);
+        memset(blocks[i], i & 0xFF, PROF_SIZE);
+    }
+
+    // About 1500 samples: the estimate lands well within 10% of the real 6.4 MB.
+    double real = (double)PROF_BLOCKS * PROF_SIZE;
+    double live = (double)(zprof_live_bytes() - base);
+    assert(live > 0.9 * real && live < 1.1 * real);
+    assert(zprof_peak_bytes() >= zprof_live_bytes());
+    prof_find f = prof_lookup(line);
+    assert(1 == f.sites && f.live == (size_t)live && f.total == f.live);
+
+    // The collapsed dump has one "file:line bytes" line for the site.
+    const char *path = "tests/bin/zprof_collapsed.txt";
+    assert(0 == zprof_write_collapsed(path));
+    FILE *in = fopen(path, "r");
+    assert(in);
+    char row[512];
+    int found = 0;
+    while (fgets(row, sizeof(row), in))
+    {
+        char *colon = strrchr(row, ':');
+        int l = 0;
+        size_t bytes = 0;
+        assert(colon && 2 == sscanf(colon + 1, "%d %zu", &l, &bytes));
+        found += (l == line && bytes == f.live);
+    }
+    fclose(in);
+    remove(path);
+    assert(1 == found);
+
+    // Resizes keep the content, sampled or not.
+    for (int i = 0; i < PROF_BLOCKS; i += 100)
+    {
+        blocks[i] = zprof_realloc(blocks[i], 4 * PROF_SIZE);
+        assert(blocks[i]);
+        for (int k = 0; k < PROF_SIZE; k++)
+        {
+            assert((i & 0xFF) == ((uint8_t *)blocks[i])[k]);
+        }
+    }
+
+    // Freeing returns exactly what was counted.
+    for (int i = 0; i < PROF_BLOCKS; i++)
+    {
+        zprof_free(blocks[i]);
+    }
+    zprof_free(NULL);
+    assert(base == zprof_live_bytes());
+    assert(0 == prof_lookup(line).live);
+
+    // A rate of 0 stops sampling.
+    zprof_set_rate(0);
+    for (int i = 0; i < 1000; i++)
+    {
+        blocks[i] = zprof_calloc(1, PROF_SIZE);
+        assert(blocks[i] && 0 == ((uint8_t *)blocks[i])[PROF_SIZE - 1]);
+    }
+    assert(base == zprof_live_bytes());
+    for (int i = 0; i < 1000; i++)
+    {
+        zprof_free(blocks[i]);
+    }
+
+    // Threads started one after another reuse the table the last one left.
+    zprof_set_rate(1);
+    for (int t = 0; t < 8; t++)
+    {
+        zthread_t th;
+        assert(Z_OK == zthread_create(&th, prof_worker, &blocks[t]));
+        zthread_join(th);
+    }
+    assert(prof_tables() <= 2);
+    assert(zprof_live_bytes() > base);
+    for (int t = 0; t < 8; t++)
+    {
+        zprof_free(blocks[t]);
+    }
+    assert(base == zprof_live_bytes());
+    zprof_set_rate(ZPROF_SAMPLE_RATE);
+    free(blocks);
+}
+
+// Shared pool.
+
+typedef struct
+{
+    uint32_t owner;
+    uint32_t seq;
+    uint64_t pad[3];
+} mt_item;
+
+typedef struct
+{
+    zpool_mt *pool;
+    uint32_t id;
+} mt_job;
+
+static size_t mt_pages(const zpool_mt *p)
+{
+    size_t n = 0;
+    for (uint8_t *b = (uint8_t *)(uintptr_t)p->blocks; b; b = (uint8_t *)(uintptr_t)*(uint64_t *)b)
+    {
+        n++;
+    }
+    return n;
+}
+
+static void mt_worker(void *arg)
+{
+    mt_job *j = (mt_job *)arg;
+    zpool_cache c;
+    zpool_cache_init(&c, j->pool);
+    mt_item *live[MT_LIVE];
+    uint32_t s = 0x9E3779B9u ^ j->id;
+
+    for (uint32_t r = 0; r < MT_ROUNDS; r++)
+    {
+        int n = 1 + (int)(rng_next(&s) % MT_LIVE);
+        for (int i = 0; i < n; i++)
+        {
+            live[i] = (mt_item *)zpool_cache_alloc(&c);
+            assert(live[i]);
+            assert(0 == (uintptr_t)live[i] % ZPOOL_MAX_ALIGN);
+            live[i]->owner = j->id;
+            live[i]->seq = r * MT_LIVE + (uint32_t)i;
+        }
+        // Another thread writing into one of these would show up here.
+        for (int i = 0; i < n; i++)
+        {
+            assert(j->id == live[i]->owner && r * MT_LIVE + (uint32_t)i == live[i]->seq);
+        }
+        for (int i = n - 1; i > 0; i--)
+        {
+            int k = (int)(rng_next(&s) % (uint32_t)(i + 1));
+            mt_item *tmp = live[i];
+            live[i] = live[k];
+            live[k] = tmp;
+        }
+        for (int i = 0; i < n; i++)
+        {
+            if (0 == (i & 7))
+            {
+                zpool_mt_recycle(j->pool, live[i]);
+            }
+            else
+            {
+                zpool_cache_recycle(&c, live[i]);
+            }
+        }
+    }
+    zpool_cache_flush(&c);
+    assert(NULL == c.head && 0 == c.count);
+}
+
+static void test_pool_mt(void)
+{
+    zpool_mt p;
+    zpool_mt_init(&p, sizeof(mt_item), 64);
+    assert(p.item_size >= sizeof(mt_item));
+    assert(0 == p.item_size % ZPOOL_MAX_ALIGN);
+
+    // Direct use: recycled items come back before a new page.
+    void *a = zpool_mt_alloc(&p);
+    void *b = zpool_mt_alloc(&p);
+    assert(a && b && a != b);
+    zpool_mt_recycle(&p, a);
+    void *c = zpool_mt_alloc(&p);
+    assert(c == a);
+    zpool_mt_recycle(&p, b);
+    zpool_mt_recycle(&p, c);
+    zpool_mt_recycle(&p, NULL);
+    assert(1 == mt_pages(&p));
+
+    zthread_t threads[MT_THREADS];
+    mt_job jobs[MT_THREADS];
+    for (int t = 0; t < MT_THREADS; t++)
+    {
+        jobs[t].pool = &p;
+        jobs[t].id = (uint32_t)t + 1;
+        assert(Z_OK == zthread_create(&threads[t], mt_worker, &jobs[t]));
+    }
+    for (int t = 0; t < MT_THREADS; t++)
+    {
+        zthread_join(threads[t]);
+    }
+
+    // Every item is back on the shared list: taking them all needs no new page.
+    size_t pages = mt_pages(&p);
+    size_t total = pages * p.count_per_block;
+    void **all = (void **)malloc(total * sizeof(void *));
+    assert(all);
+    for (size_t i = 0; i < total; i++)
+    {
+        all[i] = zpool_mt_alloc(&p);
+        assert(all[i]);
+        memset(all[i], 0xAB, sizeof(mt_item));
+    }
+    assert(pages == mt_pages(&p));
+    for (size_t i = 0; i < total; i++)
+    {
+        zpool_mt_recycle(&p, all[i]);
+    }
+    free(all);
+
+    zpool_mt_free(&p);
+    assert(0 == p.blocks && 0 == p.free_batches);
+}
+
+int main(void)
+{
+    test_arena_growth();
+    test_arena_large();
+    test_arena_marks();
+    test_arena_virtual();
+    test_thread_arena();
+    test_prof();
+    test_pool_mt();
+    printf("zalloc: ok\n");
+    return 0;
+}
@@ -0,0 +1,315 @@
+/*
+ * Behaviour tests for the runtime allocator handle (Z_ALLOCATOR_HANDLE).
+ * Every container allocates through a counting allocator that checks the sizes it is handed back,
+ * then through an arena that one zarena_reset releases.
+ * Build and run with `make test`.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define Z_ALLOCATOR_HANDLE
+#define ZALLOC_IMPLEMENTATION
+#include "zalloc.h"
+
+#define REGISTER_ZVEC_TYPES(X) X(int, Int)
+#include "zvec.h"
+
+#define REGISTER_ZMAP_TYPES(X) X(int, int, std_ii)
+#define REGISTER_STABLE_MAPS(X) X(int, int, stable_ii)
+#define REGISTER_FLAT_MAPS(X) X(int, int, flat_ii)
+#define REGISTER_CONCURRENT_MAPS(X) X(int, int, conc_ii)
+#define ZTHREAD_IMPLEMENTATION
+#include "zmap.h"
+
+#define REGISTER_ZLIST_TYPES(X) X(int, ilist)
+#define REGISTER_ZLIST_UNROLLED_TYPES(X) X(int, ints)
+#include "zlist.h"
+
+static int cmp_ptr_int(const int *a, const int *b)
+{
+    return (*a > *b) - (*a < *b);
+}
+
+#define REGISTER_ZTREE_TYPES(X) X(int, int, itree, cmp_ptr_int)
+#define REGISTER_ZBTREE_TYPES(X) X(int, int, itree, cmp_ptr_int)
+#include "ztree.h"
+#include "zstr.h"
+
+#define N 5000
+
+// Counting allocator: a header records each block's size so every free and realloc can be checked.
+
+typedef struct
+{
+    size_t live;
+    size_t bytes;
+    size_t calls;
+} counter;
+
+typedef struct
+{
+    size_t size;
+    size_t pad;
+} block_hdr;
+
+static void *count_alloc(void *ctx, size_t size)
+{
+    counter *c = (counter *)ctx;
+    block_hdr *h = (block_hdr *)malloc(sizeof(block_hdr) + size);
+    if (!h) return NULL;
+    h->size = size;
+    c->live++;
+    c->bytes += size;
+    c->calls++;
+    return h + 1;
+}
+
+static void count_free(void *ctx, void *ptr, size_t size)
+{
+    counter *c = (counter *)ctx;
+    if (!ptr) return;
+    block_hdr *h = (block_hdr *)ptr - 1;
+    assert(h->size == size);
+    c->live--;
+    c->bytes -= size;
+    free(h);
+}
+
+static void *count_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size)
+{
+    counter *c = (counter *)ctx;
+    if (!ptr) return count_alloc(ctx, new_size);
+    block_hdr *h = (block_hdr *)ptr - 1;
+    assert(h->size == old_size);
+    block_hdr *n = (block_hdr *)realloc(h, sizeof(block_hdr) + new_size);
+    if (!n) return NULL;
+    n->size = new_size;
+    c->bytes += new_size - old_size;
+    c->calls++;
+    return n + 1;
+}
+
+static uint32_t hash_int(int k, uint32_t seed)
+{
+    uint32_t h = (uint32_t)k * 2654435761u ^ seed;
+    return h ^ (h >> 15);
+}
+
+static int cmp_int(int a, int b)
+{
+    return (a > b) - (a < b);
+}
+
+// Leaves the allocator with nothing outstanding, and checks it was used at all.
+static void check_drained(const counter *c)
+{
+    assert(c->calls > 0);
+    assert(0 == c->live && 0 == c->bytes);
+}
+
+static void test_vec(const zalloc_t *a, counter *c)
+{
+    zvec_Int v = zvec_init(Int);
+    zvec_set_allocator(&v, a);
+    for (int i = 0; i < N; i++)
+    {
+        assert(Z_OK == zvec_push(&v, i));
+    }
+    assert(N == v.length);
+    assert(N - 1 == *zvec_at(&v, N - 1));
+    zvec_shrink_to_fit(&v);
+    assert(1 == c->live);
+    zvec_free(&v);
+    check_drained(c);
+}
+
+static void test_maps(const zalloc_t *a, counter *c)
+{
+    zmap_std_ii m = zmap_init(std_ii, hash_int, cmp_int);
+    zmap_set_allocator(&m, a);
+    zmap_stable_stable_ii s = zmap_init_stable(stable_ii, hash_int, cmp_int);
+    zmap_set_allocator(&s, a);
+    zmap_flat_flat_ii f = zmap_init_flat(flat_ii, hash_int, cmp_int);
+    zmap_set_allocator(&f, a);
+    for (int i = 0; i < N; i++)
+    {
+        assert(Z_OK == zmap_put(&m, i, -i));
+        assert(Z_OK == zmap_put(&s, i, -i));
+        assert(Z_OK == zmap_put(&f, i, -i));
+    }
+    for (int i = 0; i < N; i += 2)
+    {
+        zmap_remove(&m, i);
+        zmap_remove(&s, i);
+        zmap_remove(&f, i);
+    }
+    for (int i = 1; i < N; i += 2)
+    {
+        assert(-i == *zmap_get(&m, i) && -i == *zmap_get(&s, i) && -i == *zmap_get(&f, i));
+    }
+    zmap_free(&m);
+    zmap_free(&s);
+    zmap_free(&f);
+    check_drained(c);
+
+    // The concurrent map allocates its shards at init: the setter moves them over.
+    zmap_concurrent_conc_ii k;
+    assert(Z_OK == zmap_init_concurrent_conc_ii(&k, 4, hash_int, cmp_int));
+    size_t before = c->calls;
+    assert(Z_OK == zmap_set_allocator(&k, a));
+    assert(c->calls > before && c->live > 0);
+    for (int i = 0; i < N; i++)
+    {
+        assert(Z_OK == zmap_put_concurrent_conc_ii(&k, i, i));
+    }
+    assert(N == zmap_size_concurrent_conc_ii(&k));
+    zmap_free_concurrent_conc_ii(&k);
+    check_drained(c);
+}
+
+static void test_lists(const zalloc_t *a, counter *c)
+{
+    zlist_ilist l = zlist_init(ilist);
+    zlist_set_allocator(&l, a);
+    zlist_ints u = zlist_init(ints);
+    zlist_set_allocator(&u, a);
+    for (int i = 0; i < N; i++)
+    {
+        assert(Z_OK == zlist_push_back(&l, i));
+        assert(Z_OK == zlist_push_back(&u, i));
+    }
+    for (int i = 0; i < N / 2; i++)
+    {
+        zlist_pop_front(&l);
+        zlist_pop_front(&u);
+    }
+    assert(N / 2 == zlist_head(&l)->value && N / 2 == *zlist_front(&u));
+    zlist_clear(&l);
+    zlist_clear(&u);
+    check_drained(c);
+}
+
+static void test_trees(const zalloc_t *a, counter *c)
+{
+    ztree_itree t = ztree_init(itree);
+    ztree_set_allocator(&t, a);
+    zbtree_itree b = zbtree_init(itree);
+    zbtree_set_allocator(&b, a);
+    for (int i = 0; i < N; i++)
+    {
+        int k = (i * 7919) % N;
+        assert(Z_OK == ztree_insert(&t, k, i));
+        assert(Z_OK == zbtree_insert(&b, k, i));
+    }
+    for (int i = 0; i < N; i += 3)
+    {
+        ztree_remove(&t, i);
+        zbtree_remove(&b, i);
+    }
+    assert(NULL == ztree_find(&t, 3) && NULL != ztree_find(&t, 4));
+    assert(!zbtree_contains(&b, 3) && zbtree_contains(&b, 4));
+    ztree_clear(&t);
+    zbtree_clear(&b);
+    check_drained(c);
+}
+
+static void test_strings(const zalloc_t *a, counter *c)
+{
+    zstr s = zstr_init();
+    zstr_set_allocator(&s, a);
+    for (int i = 0; i < 200; i++)
+    {
+        assert(Z_OK == zstr_cat(&s, "chunk "));
+    }
+    assert(1200 == zstr_len(&s));
+    assert(1 == c->live);
+    zstr_free(&s);
+
+    zstr_builder b = zstr_builder_init();
+    zstr_builder_set_allocator(&b, a);
+    for (int i = 0; i < 1000; i++)
+    {
+        assert(Z_OK == zstr_builder_fmt(&b, "%d,", i));
+    }
+    zstr joined = zstr_builder_to_str(&b);
+    assert(zstr_len(&joined) == zstr_builder_len(&b));
+    assert(0 == strncmp(zstr_cstr(&joined), "0,1,2,", 6));
+    zstr_free(&joined);
+    zstr_builder_free(&b);
+
+    zstr_intern_pool p = zstr_intern_init();
+    zstr_intern_set_allocator(&p, a);
+    char buf[32];
+    for (int i = 0; i < 2 * N; i++)
+    {
+        snprintf(buf, sizeof(buf), "key-%d", i % N);
+        zstr_intern_cstr(&p, buf);
+    }
+    assert(N == zstr_intern_count(&p));
+    zstr_intern_free(&p);
+    check_drained(c);
+}
+
+// One arena behind every container: a single reset releases the lot, and the next round reuses it.
+static void test_arena(void)
+{
+    zarena arena;
+    zarena_init(&arena);
+    zalloc_t a = zarena_allocator(&arena);
+    size_t first = 0;
+
+    for (int round = 0; round < 3; round++)
+    {
+        zvec_Int v = zvec_init(Int);
+        zvec_set_allocator(&v, &a);
+        zmap_flat_flat_ii f = zmap_init_flat(flat_ii, hash_int, cmp_int);
+        zmap_set_allocator(&f, &a);
+        ztree_itree t = ztree_init(itree);
+        ztree_set_allocator(&t, &a);
+        zstr s = zstr_init();
+        zstr_set_allocator(&s, &a);
+        for (int i = 0; i < N; i++)
+        {
+            assert(Z_OK == zvec_push(&v, i));
+            assert(Z_OK == zmap_put(&f, i, i));
+            assert(Z_OK == ztree_insert(&t, i, i));
+            assert(Z_OK == zstr_cat(&s, "x"));
+        }
+        assert(N == v.length && N == zstr_len(&s) && N - 1 == *zmap_get(&f, N - 1));
+        assert(arena.total_alloc > 0);
+
+        zarena_reset(&arena);
+        size_t blocks = 0;
+        for (zarena_block *blk = arena.first; blk; blk = blk->next)
+        {
+            blocks++;
+        }
+        if (0 == round)
+        {
+            first = blocks;
+        }
+        else
+        {
+            assert(first == blocks);
+        }
+    }
+    zarena_free(&arena);
+}
+
+int main(void)
+{
+    counter c = {0, 0, 0};
+    zalloc_t a = { count_alloc, count_realloc, count_free, &c };
+    test_vec(&a, &c);
+    test_maps(&a, &c);
+    test_lists(&a, &c);
+    test_trees(&a, &c);
+    test_strings(&a, &c);
+    test_arena();
+    printf("zalloc_handle: ok\n");
+    return 0;
+}
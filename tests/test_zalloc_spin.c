@@ -0,0 +1,3 @@
+// The zalloc tests again, with the shared pool's list behind the spinlock instead of the tagged head.
+#define ZPOOL_MT_PTR_BITS 64
+#include "test_zalloc.c"
@@ -0,0 +1,734 @@
+/*
+ * Behaviour tests for zfile.h, in a scratch directory under the system temp directory.
+ * test_zfile_mt.c runs them again with ZFILE_USE_ZTHREAD, test_zfile_scalar.c with ZFILE_NO_SIMD.
+ * Build and run with `make test`.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ZFILE_IMPLEMENTATION
+#include "zfile.h"
+
+#include <unistd.h>
+
+// Walk callbacks run on several threads at once with ZFILE_HAS_ZTHREAD.
+#ifdef ZFILE_HAS_ZTHREAD
+static zspinlock_t g_lock = ZSPINLOCK_INIT;
+#   define WALK_LOCK()   zspin_lock(&g_lock)
+#   define WALK_UNLOCK() zspin_unlock(&g_lock)
+#else
+#   define WALK_LOCK()   ((void)0)
+#   define WALK_UNLOCK() ((void)0)
+#endif
+
+static zstr g_dir;
+
+static zstr scratch(const char *name)
+{
+    return zfile_join(zstr_cstr(&g_dir), name);
+}
+
+static uint32_t g_seed = 12345;
+
+static uint32_t next_rand(void)
+{
+    g_seed = g_seed * 1664525u + 1013904223u;
+    return g_seed >> 8;
+}
+
+// Mappings.
+
+static void test_map(void)
+{
+    zstr path = scratch("map.bin");
+    static char content[10000];
+    for (size_t i = 0; i < sizeof(content); i++)
+    {
+        content[i] = (char)(i * 31 + 7);
+    }
+    assert(0 == zfile_write_all(zstr_cstr(&path), content, sizeof(content)));
+
+    zfile_map m;
+    assert(0 == zfile_map_open(zstr_cstr(&path), ZFILE_MAP_READ, &m));
+    assert(!m.writable && sizeof(content) == m.len);
+    zstr_view v = zfile_map_view(&m);
+    assert(v.data == m.data && 0 == memcmp(v.data, content, sizeof(content)));
+    // Hints may be ignored but must be accepted, also unaligned and past the end.
+    assert(0 == zfile_map_advise(&m, 0, 0, ZFILE_ADVISE_SEQUENTIAL));
+    assert(0 == zfile_map_advise(&m, 5000, 100, ZFILE_ADVISE_WILLNEED));
+    assert(0 == zfile_map_advise(&m, 123, 0, ZFILE_ADVISE_RANDOM));
+    assert(0 == zfile_map_advise(&m, sizeof(content) + 1, 10, ZFILE_ADVISE_NORMAL));
+    assert(0 == zfile_map_sync(&m));
+    zfile_map_close(&m);
+    assert(NULL == m.data && 0 == m.len);
+
+    // A writable view stores straight into the file.
+    assert(0 == zfile_map_open(zstr_cstr(&path), ZFILE_MAP_WRITE, &m));
+    assert(m.writable);
+    memcpy(m.data + 100, "patched", 7);
+    assert(0 == zfile_map_sync(&m));
+    zfile_map_close(&m);
+    memcpy(content + 100, "patched", 7);
+    zstr back = zfile_read_all(zstr_cstr(&path));
+    assert(sizeof(content) == zstr_len(&back) && 0 == memcmp(zstr_cstr(&back), content, sizeof(content)));
+    zstr_free(&back);
+
+    // The view outlives the file's name.
+    assert(0 == zfile_map_open(zstr_cstr(&path), ZFILE_MAP_READ, &m));
+    assert(0 == zfile_remove(zstr_cstr(&path)));
+    assert(!zfile_exists(zstr_cstr(&path)));
+    assert(0 == memcmp(m.data, content, sizeof(content)));
+    zfile_map_close(&m);
+
+    // Created maps start as zeros of the requested size.
+    assert(0 == zfile_map_create(zstr_cstr(&path), 3 * 4096 + 5, &m));
+    assert(m.writable && 3 * 4096 + 5 == m.len);
+    for (size_t i = 0; i < m.len; i++)
+    {
+        assert(0 == m.data[i]);
+        m.data[i] = (char)('a' + i % 26);
+    }
+    zfile_map_close(&m);
+    assert(3 * 4096 + 5 == zfile_size(zstr_cstr(&path)));
+    back = zfile_read_all(zstr_cstr(&path));
+    assert('a' == zstr_cstr(&back)[0] && (char)('a' + (3 * 4096 + 4) % 26) == zstr_cstr(&back)[3 * 4096 + 4]);
+    zstr_free(&back);
+    assert(0 == zfile_remove(zstr_cstr(&path)));
+
+    // An empty file maps to no memory but an empty, non-NULL view.
+    assert(0 == zfile_write_all(zstr_cstr(&path), "", 0));
+    assert(0 == zfile_map_open(zstr_cstr(&path), ZFILE_MAP_READ, &m));
+    assert(NULL == m.data && 0 == m.len);
+    v = zfile_map_view(&m);
+    assert(v.data && 0 == v.len);
+    assert(0 == zfile_map_advise(&m, 0, 0, ZFILE_ADVISE_SEQUENTIAL));
+    zfile_map_close(&m);
+    assert(0 == zfile_remove(zstr_cstr(&path)));
+
+    assert(0 != zfile_map_open(zstr_cstr(&path), ZFILE_MAP_READ, &m));
+    assert(NULL == m.data && 0 == m.len);
+    zstr_free(&path);
+}
+
+// Line readers.
+
+static void test_reader_lines(void)
+{
+    zstr path = scratch("lines.txt");
+    zstr text = zstr_init();
+    zstr_cat(&text, "alpha\nbeta\r\n\n");
+    for (int i = 0; i < 10000; i++)
+    {
+        zstr_push(&text, 'x');
+    }
+    zstr_cat(&text, "\nlast");
+    assert(0 == zfile_write_all(zstr_cstr(&path), zstr_cstr(&text), zstr_len(&text)));
+
+    // Mapped: lines are views into the mapping, of any length, \r dropped.
+    const char *want[] = { "alpha", "beta", "", NULL, "last" };
+    zfile_reader r = zfile_reader_open_map(zstr_cstr(&path));
+    assert(r.mapped);
+    zstr_view line;
+    for (int i = 0; i < 5; i++)
+    {
+        assert(zfile_reader_next_line(&r, &line));
+        assert(line.data >= r.map.data && line.data + line.len <= r.map.data + r.map.len);
+        if (want[i])
+        {
+            assert(zstr_view_eq(line, want[i]));
+        }
+        else
+        {
+            assert(10000 == line.len && 'x' == line.data[0] && 'x' == line.data[9999]);
+        }
+    }
+    assert(!zfile_reader_next_line(&r, &line));
+    assert(!zfile_reader_next_line(&r, &line));
+    zfile_reader_close(&r);
+
+    // Buffered: a line longer than the buffer comes back in buffer-sized pieces.
+    r = zfile_reader_open(zstr_cstr(&path));
+    assert(r.handle);
+    size_t pieces[] = { 5, 4, 0, 4096, 4096, 1808, 4 };
+    for (size_t i = 0; i < sizeof(pieces) / sizeof(pieces[0]); i++)
+    {
+        assert(zfile_reader_next_line(&r, &line));
+        assert(pieces[i] == line.len);
+    }
+    assert(!zfile_reader_next_line(&r, &line));
+    zfile_reader_close(&r);
+
+    // With a large enough caller buffer it agrees with the mapping.
+    static char buf[16384];
+    r = zfile_reader_open_buf(zstr_cstr(&path), buf, sizeof(buf));
+    int n = 0;
+    while (zfile_reader_next_line(&r, &line))
+    {
+        assert(want[n] ? zstr_view_eq(line, want[n]) : 10000 == line.len);
+        n++;
+    }
+    assert(5 == n);
+    zfile_reader_close(&r);
+
+    zstr_free(&text);
+    assert(0 == zfile_remove(zstr_cstr(&path)));
+    zstr_free(&path);
+}
+
+// Random line lengths and endings: the buffered and the mapped reader yield the same lines.
+static void test_reader_equivalence(void)
+{
+    zstr path = scratch("random.txt");
+    zstr text = zstr_init();
+    size_t lines = 0;
+    for (int i = 0; i < 3000; i++)
+    {
+        size_t len = next_rand() % 300;
+        for (size_t j = 0; j < len; j++)
+        {
+            zstr_push(&text, (char)(' ' + next_rand() % 90));
+        }
+        zstr_cat(&text, (next_rand() & 1) ? "\r\n" : "\n");
+        lines++;
+    }
+    assert(0 == zfile_write_all(zstr_cstr(&path), zstr_cstr(&text), zstr_len(&text)));
+
+    zfile_reader a = zfile_reader_open(zstr_cstr(&path));
+    zfile_reader b = zfile_reader_open_map(zstr_cstr(&path));
+    assert(a.handle && b.mapped);
+    zstr_view la, lb;
+    size_t n = 0;
+    while (zfile_reader_next_line(&a, &la))
+    {
+        assert(zfile_reader_next_line(&b, &lb));
+        assert(la.len == lb.len && 0 == memcmp(la.data, lb.data, la.len));
+        n++;
+    }
+    assert(!zfile_reader_next_line(&b, &lb));
+    assert(lines == n);
+    zfile_reader_close(&a);
+    zfile_reader_close(&b);
+
+    size_t counted = 0;
+    ZFILE_FOR_EACH_LINE_MAPPED(zstr_cstr(&path), l)
+    {
+        (void)l;
+        counted++;
+    }
+    assert(lines == counted);
+
+    // Empty and missing files run no iteration.
+    assert(0 == zfile_write_all(zstr_cstr(&path), "", 0));
+    ZFILE_FOR_EACH_LINE_MAPPED(zstr_cstr(&path), l)
+    {
+        (void)l;
+        assert(!"line in an empty file");
+    }
+    assert(0 == zfile_remove(zstr_cstr(&path)));
+    ZFILE_FOR_EACH_LINE_MAPPED(zstr_cstr(&path), l)
+    {
+        (void)l;
+        assert(!"line in a missing file");
+    }
+    zstr_free(&text);
+    zstr_free(&path);
+}
+
+// Directory walk.
+
+typedef struct
+{
+    const char *root;
+    int64_t files;
+    int64_t dirs;
+    int64_t links;
+    int64_t bad;
+    const char *skip;
+    char **paths;
+    size_t count;
+    size_t cap;
+} walk_probe;
+
+static bool on_entry(const zfile_walk_entry *e, void *user)
+{
+    walk_probe *w = (walk_probe *)user;
+    size_t root = strlen(w->root);
+    size_t seps = 0;
+    for (const char *p = e->path + root + 1; *p; p++)
+    {
+        seps += (ZFILE_SEP == *p);
+    }
+    bool ok = 0 == strncmp(e->path, w->root, root) && ZFILE_SEP == e->path[root] &&
+              0 == strcmp(e->path + strlen(e->path) - strlen(e->name), e->name) && seps == e->depth;
+    WALK_LOCK();
+    w->bad += !ok;
+    w->files += (ZDIR_FILE == e->type);
+    w->dirs += (ZDIR_DIR == e->type);
+    w->links += (ZDIR_UNKNOWN == e->type);
+    if (w->paths)
+    {
+        if (w->count == w->cap)
+        {
+            w->cap = w->cap ? 2 * w->cap : 64;
+            w->paths = (char **)realloc(w->paths, w->cap * sizeof(char *));
+            assert(w->paths);
+        }
+        w->paths[w->count] = (char *)malloc(strlen(e->path) + 1);
+        strcpy(w->paths[w->count++], e->path);
+    }
+    WALK_UNLOCK();
+    return !(w->skip && 0 == strcmp(e->name, w->skip));
+}
+
+static int longer_first(const void *a, const void *b)
+{
+    size_t la = strlen(*(char *const *)a), lb = strlen(*(char *const *)b);
+    return (la < lb) - (la > lb);
+}
+
+// Children have longer paths than their parents, so removing longest first empties every directory.
+static void remove_tree(const char *root)
+{
+    walk_probe w = { root, 0, 0, 0, 0, NULL, NULL, 0, 0 };
+    w.paths = (char **)malloc(sizeof(char *));
+    w.cap = 1;
+    assert(zfile_walk(root, on_entry, &w) >= 0);
+    qsort(w.paths, w.count, sizeof(char *), longer_first);
+    for (size_t i = 0; i < w.count; i++)
+    {
+        assert(0 == zfile_remove(w.paths[i]));
+        free(w.paths[i]);
+    }
+    free(w.paths);
+    assert(0 == zfile_remove(root));
+}
+
+// Four levels of three directories, each with four files: returns how many entries it made.
+static int64_t make_tree(const char *dir, int level)
+{
+    int64_t made = 0;
+    char name[32];
+    for (int f = 0; f < 4; f++)
+    {
+        snprintf(name, sizeof(name), "f%d.txt", f);
+        zstr p = zfile_join(dir, name);
+        assert(0 == zfile_write_all(zstr_cstr(&p), name, strlen(name)));
+        zstr_free(&p);
+        made++;
+    }
+    if (level < 3)
+    {
+        for (int d = 0; d < 3; d++)
+        {
+            snprintf(name, sizeof(name), "d%d", d);
+            zstr p = zfile_join(dir, name);
+            assert(0 == zfile_mkdir_recursive(zstr_cstr(&p)));
+            made += 1 + make_tree(zstr_cstr(&p), level + 1);
+            zstr_free(&p);
+        }
+    }
+    return made;
+}
+
+static void test_walk(void)
+{
+    zstr root = scratch("tree");
+    assert(0 == zfile_mkdir_recursive(zstr_cstr(&root)));
+    int64_t made = make_tree(zstr_cstr(&root), 0);
+    // A link back up is reported but never followed.
+    zstr link = zfile_join(zstr_cstr(&root), "up");
+    assert(0 == symlink("..", zstr_cstr(&link)));
+
+    walk_probe w = { zstr_cstr(&root), 0, 0, 0, 0, NULL, NULL, 0, 0 };
+    assert(made + 1 == zfile_walk(zstr_cstr(&root), on_entry, &w));
+    assert(0 == w.bad && 1 == w.links);
+    assert(3 + 9 + 27 == w.dirs && 4 * (1 + 3 + 9 + 27) == w.files);
+
+    // A false return for a directory skips everything below it, at every level it shows up.
+    walk_probe s = { zstr_cstr(&root), 0, 0, 0, 0, "d1", NULL, 0, 0 };
+    // Below a level 1, 2 and 3 directory sit 64, 19 and 4 entries; d0 and d2 keep their d1s.
+    int64_t skipped = 64 + 2 * 19 + 4 * 4;
+    assert(made + 1 - skipped == zfile_walk(zstr_cstr(&root), on_entry, &s));
+    assert(0 == s.bad);
+
+    zstr missing = scratch("no-such-dir");
+    walk_probe m = { zstr_cstr(&missing), 0, 0, 0, 0, NULL, NULL, 0, 0 };
+    assert(-1 == zfile_walk(zstr_cstr(&missing), on_entry, &m));
+    assert(0 == m.files + m.dirs + m.links);
+
+    remove_tree(zstr_cstr(&root));
+    assert(!zfile_exists(zstr_cstr(&root)));
+    zstr_free(&missing);
+    zstr_free(&link);
+    zstr_free(&root);
+}
+
+// Batched jobs.
+
+#define JOBS 48
+
+static void test_jobs(void)
+{
+    zstr dir = scratch("jobs");
+    assert(0 == zfile_mkdir_recursive(zstr_cstr(&dir)));
+    static zstr paths[JOBS];
+    static char bodies[JOBS][200];
+    zfile_job jobs[JOBS + 1];
+    memset(jobs, 0, sizeof(jobs));
+    for (int i = 0; i < JOBS; i++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "job%d.bin", i);
+        paths[i] = zfile_join(zstr_cstr(&dir), name);
+        memset(bodies[i], 'a' + i % 26, sizeof(bodies[i]));
+        jobs[i].path = zstr_cstr(&paths[i]);
+        jobs[i].data = bodies[i];
+        jobs[i].len = 1 + (size_t)i * 4;
+        jobs[i].content = zstr_init();
+    }
+    assert(0 == zfile_run_jobs(jobs, JOBS));
+
+    // Reads, in the background, with one missing file among them.
+    zstr missing = zfile_join(zstr_cstr(&dir), "missing.bin");
+    for (int i = 0; i < JOBS; i++)
+    {
+        jobs[i].data = NULL;
+    }
+    jobs[JOBS].path = zstr_cstr(&missing);
+    jobs[JOBS].content = zstr_init();
+    zfile_batch *b = zfile_batch_start(jobs, JOBS + 1);
+    assert(b);
+    assert(1 == zfile_batch_wait(b));
+    assert(0 != jobs[JOBS].result);
+    for (int i = 0; i < JOBS; i++)
+    {
+        assert(0 == jobs[i].result);
+        assert(1 + (size_t)i * 4 == zstr_len(&jobs[i].content));
+        assert(0 == memcmp(zstr_cstr(&jobs[i].content), bodies[i], zstr_len(&jobs[i].content)));
+    }
+    // Running again replaces the previous contents.
+    assert(1 == zfile_run_jobs(jobs, JOBS + 1));
+    for (int i = 0; i < JOBS + 1; i++)
+    {
+        zstr_free(&jobs[i].content);
+    }
+    for (int i = 0; i < JOBS; i++)
+    {
+        assert(0 == zfile_remove(zstr_cstr(&paths[i])));
+        zstr_free(&paths[i]);
+    }
+    assert(0 == zfile_remove(zstr_cstr(&dir)));
+    zstr_free(&missing);
+    zstr_free(&dir);
+}
+
+// Copy.
+
+static void check_copy(const char *src, const char *dst)
+{
+    assert(0 == zfile_copy(src, dst));
+    zstr a = zfile_read_all(src);
+    zstr b = zfile_read_all(dst);
+    assert(zstr_len(&a) == zstr_len(&b) && 0 == memcmp(zstr_cstr(&a), zstr_cstr(&b), zstr_len(&a)));
+    zstr_free(&a);
+    zstr_free(&b);
+}
+
+static void test_copy(void)
+{
+    zstr src = scratch("src.bin");
+    zstr dst = scratch("dst.bin");
+    size_t len = 3 * 1024 * 1024 + 17;
+    char *data = (char *)malloc(len);
+    assert(data);
+    for (size_t i = 0; i < len; i++)
+    {
+        data[i] = (char)next_rand();
+    }
+    assert(0 == zfile_write_all(zstr_cstr(&src), data, len));
+    check_copy(zstr_cstr(&src), zstr_cstr(&dst));
+
+    // Onto a longer file it truncates, and an empty source makes an empty copy.
+    assert(0 == zfile_write_all(zstr_cstr(&src), data, 100));
+    check_copy(zstr_cstr(&src), zstr_cstr(&dst));
+    assert(100 == zfile_size(zstr_cstr(&dst)));
+    assert(0 == zfile_write_all(zstr_cstr(&src), "", 0));
+    check_copy(zstr_cstr(&src), zstr_cstr(&dst));
+    assert(0 == zfile_size(zstr_cstr(&dst)));
+
+#   ifdef __linux__
+    // procfs reports size 0: the copy falls through to plain reads.
+    assert(0 == zfile_copy("/proc/self/status", zstr_cstr(&dst)));
+    assert(zfile_size(zstr_cstr(&dst)) > 0);
+#   endif
+
+    assert(0 == zfile_remove(zstr_cstr(&src)));
+    assert(0 != zfile_copy(zstr_cstr(&src), zstr_cstr(&dst)));
+    assert(0 == zfile_remove(zstr_cstr(&dst)));
+    free(data);
+    zstr_free(&src);
+    zstr_free(&dst);
+}
+
+// Delimited records.
+
+// Rows as "count:len=field;len=field;...\n", so two parses compare as strings.
+static void emit_row(zstr *out, const zstr_view *fields, size_t count)
+{
+    zstr_fmt(out, "%zu:", count);
+    for (size_t i = 0; i < count; i++)
+    {
+        zstr_fmt(out, "%zu=", fields[i].len);
+        zstr_cat_len(out, fields[i].data, fields[i].len);
+        zstr_push(out, ';');
+    }
+    zstr_push(out, '\n');
+}
+
+// Byte-at-a-time reference for the rules in zfile.h: a quote opens a field only at its start or
+// right after a closing quote, the row's \r goes, and a quoted field is unescaped.
+static void ref_finish(zstr *out, zstr_view *fields, size_t n, char quote, char *scratch)
+{
+    zstr_view *last = &fields[n - 1];
+    if (last->len > 0 && '\r' == last->data[last->len - 1])
+    {
+        last->len--;
+    }
+    for (size_t i = 0; i < n && quote; i++)
+    {
+        zstr_view *f = &fields[i];
+        if (0 == f->len || quote != f->data[0])
+        {
+            continue;
+        }
+        size_t k = 0;
+        for (size_t j = 1; j < f->len; j++)
+        {
+            if (quote != f->data[j])
+            {
+                scratch[k++] = f->data[j];
+            }
+            else if (j + 1 < f->len && quote == f->data[j + 1])
+            {
+                scratch[k++] = quote;
+                j++;
+            }
+        }
+        *f = (zstr_view){ scratch, k };
+        scratch += k;
+    }
+    emit_row(out, fields, n);
+}
+
+static size_t ref_parse(const char *p, size_t len, char delim, char quote, zstr *out)
+{
+    zstr_view *fields = (zstr_view *)malloc((len + 1) * sizeof(zstr_view));
+    char *scratch = (char *)malloc(len + 1);
+    assert(fields && scratch);
+    size_t n = 0, from = 0, rows = 0;
+    bool in = false, start = true, closed = false;
+    for (size_t i = 0; i < len; i++)
+    {
+        char ch = p[i];
+        bool reopen = closed;
+        closed = false;
+        if (quote && quote == ch)
+        {
+            if (in)
+            {
+                in = false;
+                closed = true;
+            }
+            else if (start || reopen)
+            {
+                in = true;
+            }
+        }
+        else if (!in && (delim == ch || '\n' == ch))
+        {
+            fields[n++] = (zstr_view){ p + from, i - from };
+            from = i + 1;
+            if ('\n' == ch)
+            {
+                ref_finish(out, fields, n, quote, scratch);
+                rows++;
+                n = 0;
+            }
+        }
+        start = (delim == ch || '\n' == ch);
+    }
+    if (from < len || n > 0)
+    {
+        fields[n++] = (zstr_view){ p + from, len - from };
+        ref_finish(out, fields, n, quote, scratch);
+        rows++;
+    }
+    free(fields);
+    free(scratch);
+    return rows;
+}
+
+static size_t csv_parse(const char *p, size_t len, char delim, char quote, zstr *out)
+{
+    zfile_csv c;
+    zfile_csv_init(&c, (zstr_view){ p, len }, delim, quote);
+    zfile_csv_row row;
+    size_t rows = 0;
+    while (zfile_csv_next(&c, &row))
+    {
+        emit_row(out, row.fields, row.count);
+        rows++;
+    }
+    assert(!zfile_csv_next(&c, &row));
+    zfile_csv_close(&c);
+    return rows;
+}
+
+static void check_csv(const char *text, char delim, char quote, const char *want)
+{
+    zstr got = zstr_init();
+    csv_parse(text, strlen(text), delim, quote, &got);
+    assert(0 == strcmp(zstr_cstr(&got), want));
+    zstr_free(&got);
+}
+
+static void test_csv_cases(void)
+{
+    check_csv("a,b,c\n", ',', '"', "3:1=a;1=b;1=c;\n");
+    check_csv("\"x,y\",z\n", ',', '"', "2:3=x,y;1=z;\n");
+    check_csv("\"he said \"\"hi\"\"\",2\r\n", ',', '"', "2:12=he said \"hi\";1=2;\n");
+    check_csv("ab\"c,d\n", ',', '"', "2:4=ab\"c;1=d;\n");
+    check_csv("\"two\nlines\",x", ',', '"', "2:9=two\nlines;1=x;\n");
+    check_csv("\n\na,\n", ',', '"', "1:0=;\n1:0=;\n2:1=a;0=;\n");
+    check_csv("a,", ',', '"', "2:1=a;0=;\n");
+    check_csv("", ',', '"', "");
+    check_csv("\"\"\n\"\"\"\"\n", ',', '"', "1:0=;\n1:1=\";\n");
+    check_csv("\"a\tb\"\tc\n", '\t', 0, "3:2=\"a;2=b\";1=c;\n");
+    check_csv("\"open,never closed\n", ',', '"', "1:18=open,never closed\n;\n");
+}
+
+static void random_csv(zstr *out, size_t len, char delim)
+{
+    static const char pool[] = "aaaaaaabbx  \"\"\"\"\n\n\n\r,,,,";
+    for (size_t i = 0; i < len; i++)
+    {
+        char ch = pool[next_rand() % (sizeof(pool) - 1)];
+        zstr_push(out, ',' == ch ? delim : ch);
+    }
+}
+
+// Random text crossing many 64-byte blocks: the parser (SIMD or, in test_zfile_scalar.c, scalar)
+// agrees with the reference row for row.
+static void test_csv_random(void)
+{
+    for (int round = 0; round < 2000; round++)
+    {
+        char delim = (round % 3) ? ',' : '\t';
+        char quote = (round % 7) ? '"' : 0;
+        zstr text = zstr_init();
+        random_csv(&text, next_rand() % 700, delim);
+        zstr want = zstr_init(), got = zstr_init();
+        size_t rows = ref_parse(zstr_cstr(&text), zstr_len(&text), delim, quote, &want);
+        assert(rows == csv_parse(zstr_cstr(&text), zstr_len(&text), delim, quote, &got));
+        assert(zstr_len(&want) == zstr_len(&got));
+        assert(0 == memcmp(zstr_cstr(&want), zstr_cstr(&got), zstr_len(&want)));
+        zstr_free(&text);
+        zstr_free(&want);
+        zstr_free(&got);
+    }
+}
+
+#define CSV_CHUNKS 6
+
+typedef struct
+{
+    zstr out[CSV_CHUNKS];
+    int64_t seen[CSV_CHUNKS];
+} chunk_probe;
+
+static bool on_row(const zfile_csv_row *row, size_t chunk, void *user)
+{
+    chunk_probe *p = (chunk_probe *)user;
+    assert(chunk < CSV_CHUNKS);
+    emit_row(&p->out[chunk], row->fields, row->count);
+    p->seen[chunk]++;
+    return true;
+}
+
+// Parallel chunks, stitched back in chunk order, give the serial parse; so does the mapped file.
+static void test_csv_parallel(void)
+{
+    zstr text = zstr_init();
+    random_csv(&text, 400000, ',');
+    zstr serial = zstr_init();
+    size_t rows = csv_parse(zstr_cstr(&text), zstr_len(&text), ',', '"', &serial);
+
+    for (size_t chunks = 1; chunks <= CSV_CHUNKS; chunks += 5)
+    {
+        chunk_probe p;
+        for (int i = 0; i < CSV_CHUNKS; i++)
+        {
+            p.out[i] = zstr_init();
+            p.seen[i] = 0;
+        }
+        assert((int64_t)rows == zfile_csv_parallel(zstr_as_view(&text), ',', '"', chunks, on_row, &p));
+        zstr joined = zstr_init();
+        int64_t total = 0;
+        for (int i = 0; i < CSV_CHUNKS; i++)
+        {
+            zstr_cat_len(&joined, zstr_cstr(&p.out[i]), zstr_len(&p.out[i]));
+            total += p.seen[i];
+            zstr_free(&p.out[i]);
+        }
+        assert((int64_t)rows == total);
+        assert(zstr_len(&joined) == zstr_len(&serial));
+        assert(0 == memcmp(zstr_cstr(&joined), zstr_cstr(&serial), zstr_len(&serial)));
+        zstr_free(&joined);
+    }
+
+    zstr path = scratch("data.csv");
+    assert(0 == zfile_write_all(zstr_cstr(&path), zstr_cstr(&text), zstr_len(&text)));
+    zfile_csv c;
+    assert(0 == zfile_csv_open(&c, zstr_cstr(&path), ',', '"'));
+    zstr mapped = zstr_init();
+    zfile_csv_row row;
+    while (zfile_csv_next(&c, &row))
+    {
+        emit_row(&mapped, row.fields, row.count);
+    }
+    zfile_csv_close(&c);
+    assert(zstr_len(&mapped) == zstr_len(&serial));
+    assert(0 == memcmp(zstr_cstr(&mapped), zstr_cstr(&serial), zstr_len(&serial)));
+    assert(0 == zfile_remove(zstr_cstr(&path)));
+    assert(0 != zfile_csv_open(&c, zstr_cstr(&path), ',', '"'));
+    assert(!zfile_csv_next(&c, &row));
+    zfile_csv_close(&c);
+
+    zstr_free(&mapped);
+    zstr_free(&path);
+    zstr_free(&serial);
+    zstr_free(&text);
+}
+
+int main(void)
+{
+    g_dir = zfile_tempname("zfile_test", NULL);
+    assert(0 == zfile_mkdir_recursive(zstr_cstr(&g_dir)));
+    test_map();
+    test_reader_lines();
+    test_reader_equivalence();
+    test_walk();
+    test_jobs();
+    test_copy();
+    test_csv_cases();
+    test_csv_random();
+    test_csv_parallel();
+    assert(0 == zfile_remove(zstr_cstr(&g_dir)));
+    zstr_free(&g_dir);
+    printf("zfile: ok\n");
+    return 0;
+}
@@ -0,0 +1,8 @@
+/*
+ * The zfile.h tests with ZFILE_USE_ZTHREAD: walks and batches run on zexec_default().
+ * Build and run with `make test`.
+ */
+
+#define ZFILE_USE_ZTHREAD
+#define ZTHREAD_IMPLEMENTATION
+#include "test_zfile.c"
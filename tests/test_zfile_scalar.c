@@ -0,0 +1,7 @@
+/*
+ * The zfile.h tests with ZFILE_NO_SIMD: the record parser scans a byte at a time.
+ * Build and run with `make test`.
+ */
+
+#define ZFILE_NO_SIMD
+#include "test_zfile.c"
@@ -0,0 +1,517 @@
+/*
+ * Behaviour tests for the intrusive and unrolled lists in zlist.h.
+ * Build and run with `make test`.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Counts chunk allocations and fails them once g_fail_after reaches zero.
+static long g_allocs = 0;
+static long g_fail_after = -1;
+
+static void *test_malloc(size_t sz)
+{
+    if (0 == g_fail_after) return NULL;
+    if (g_fail_after > 0) g_fail_after--;
+    g_allocs++;
+    return malloc(sz);
+}
+
+#define ZLIST_MALLOC(sz) test_malloc(sz)
+
+typedef struct item
+{
+    int id;
+    struct { struct item *prev, *next; } run;
+    struct { struct item *prev, *next; } all;
+} item;
+
+typedef struct
+{
+    int key;
+    char pad[96];
+} wide;
+
+#define REGISTER_ZLIST_INTRUSIVE_TYPES(X) X(item, run, run) X(item, all, all)
+#define REGISTER_ZLIST_UNROLLED_TYPES(X) X(int, ints) X(wide, wides)
+#include "zstr.h"
+#include "zlist.h"
+#include "zops.h"
+
+static uint64_t g_rng = 0x2545F4914F6CDD1DULL;
+
+static uint32_t rng_next(void)
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return (uint32_t)(g_rng >> 16);
+}
+
+/* Intrusive lists. */
+
+#define ITEMS 64
+
+static item g_items[ITEMS];
+static int g_in_run[ITEMS];
+static int ref_run[ITEMS];
+static int ref_len = 0;
+
+static void check_run(zlist_run *l)
+{
+    assert(l->length == (size_t)ref_len);
+    assert((NULL == l->head) == (0 == ref_len));
+    assert(zlist_is_empty(l) == (0 == ref_len));
+
+    // Forward, then backward through the links.
+    item *prev = NULL;
+    int i = 0;
+    zlist_foreach_intrusive(l, run, it)
+    {
+        assert(i < ref_len);
+        assert(it->id == ref_run[i]);
+        assert(it->run.prev == prev);
+        prev = it;
+        i++;
+    }
+    assert(i == ref_len);
+    assert(l->tail == prev);
+
+    for (item *it = l->tail; it; it = zlist_prev_run(it))
+    {
+        assert(it->id == ref_run[--i]);
+    }
+    assert(0 == i);
+
+    if (ref_len > 0)
+    {
+        size_t k = rng_next() % (size_t)ref_len;
+        assert(zlist_at(l, k)->id == ref_run[k]);
+    }
+    assert(NULL == zlist_at(l, (size_t)ref_len));
+}
+
+static int free_item(void)
+{
+    int start = (int)(rng_next() % ITEMS);
+    for (int k = 0; k < ITEMS; k++)
+    {
+        int id = (start + k) % ITEMS;
+        if (!g_in_run[id]) return id;
+    }
+    return -1;
+}
+
+static void ref_insert(int pos, int id)
+{
+    memmove(ref_run + pos + 1, ref_run + pos, (size_t)(ref_len - pos) * sizeof(int));
+    ref_run[pos] = id;
+    ref_len++;
+    g_in_run[id] = 1;
+}
+
+static void ref_erase(int pos)
+{
+    g_in_run[ref_run[pos]] = 0;
+    memmove(ref_run + pos, ref_run + pos + 1, (size_t)(ref_len - pos - 1) * sizeof(int));
+    ref_len--;
+}
+
+static void test_intrusive_fuzz(void)
+{
+    zlist_all all = zlist_init(all);
+    zlist_run l = zlist_init(run);
+    for (int i = 0; i < ITEMS; i++)
+    {
+        g_items[i].id = i;
+        zlist_push_back(&all, &g_items[i]);
+    }
+
+    long allocs = g_allocs;
+    for (int step = 0; step < 20000; step++)
+    {
+        int op = (int)(rng_next() % 16);
+        int id = free_item();
+        if (op < 3 && id >= 0)
+        {
+            zlist_push_back(&l, &g_items[id]);
+            ref_insert(ref_len, id);
+        }
+        else if (op < 6 && id >= 0)
+        {
+            zlist_push_front(&l, &g_items[id]);
+            ref_insert(0, id);
+        }
+        else if (op < 9 && id >= 0)
+        {
+            // Position 0 means insert at the head through a NULL anchor.
+            int pos = (int)(rng_next() % (uint32_t)(ref_len + 1));
+            zlist_insert_after(&l, pos ? &g_items[ref_run[pos - 1]] : NULL, &g_items[id]);
+            ref_insert(pos, id);
+        }
+        else if (op < 11 && ref_len > 0)
+        {
+            int pos = (int)(rng_next() % (uint32_t)ref_len);
+            item *e = &g_items[ref_run[pos]];
+            assert(zlist_detach_node(&l, e) == e);
+            assert(NULL == e->run.prev && NULL == e->run.next);
+            ref_erase(pos);
+        }
+        else if (op < 12)
+        {
+            item *e = zlist_pop_back(&l);
+            if (0 == ref_len) assert(NULL == e);
+            else
+            {
+                assert(e->id == ref_run[ref_len - 1]);
+                ref_erase(ref_len - 1);
+            }
+        }
+        else if (op < 13)
+        {
+            item *e = zlist_pop_front(&l);
+            if (0 == ref_len) assert(NULL == e);
+            else
+            {
+                assert(e->id == ref_run[0]);
+                ref_erase(0);
+            }
+        }
+        else if (op < 14)
+        {
+            zlist_reverse(&l);
+            for (int i = 0; i < ref_len / 2; i++)
+            {
+                int t = ref_run[i];
+                ref_run[i] = ref_run[ref_len - 1 - i];
+                ref_run[ref_len - 1 - i] = t;
+            }
+        }
+        else if (op < 15)
+        {
+            // Build a short second list out of free items and splice it on.
+            zlist_run other = zlist_init(run);
+            int n = (int)(rng_next() % 4);
+            for (int k = 0; k < n && (id = free_item()) >= 0; k++)
+            {
+                zlist_push_back(&other, &g_items[id]);
+                ref_insert(ref_len, id);
+            }
+            zlist_splice(&l, &other);
+            assert(zlist_is_empty(&other) && 0 == other.length && NULL == other.tail);
+            zlist_splice(&l, &l);
+        }
+        else
+        {
+            // Remove every odd id while walking.
+            zlist_foreach_intrusive_safe(&l, run, it, safe)
+            {
+                if (it->id & 1) zlist_remove_node(&l, it);
+            }
+            for (int i = ref_len - 1; i >= 0; i--)
+            {
+                if (ref_run[i] & 1) ref_erase(i);
+            }
+        }
+        check_run(&l);
+    }
+    assert(g_allocs == allocs);
+
+    // The second link was never touched.
+    int i = 0;
+    zlist_foreach_intrusive(&all, all, it)
+    {
+        assert(it->id == i++);
+    }
+    assert(ITEMS == i && ITEMS == (int)all.length);
+
+    zlist_clear(&l);
+    assert(zlist_is_empty(&l) && 0 == l.length);
+    zlist_clear(&all);
+    memset(g_in_run, 0, sizeof(g_in_run));
+    ref_len = 0;
+}
+
+static void test_intrusive_ops(void)
+{
+    item a = { 1, { NULL, NULL }, { NULL, NULL } };
+    item b = { 2, { NULL, NULL }, { NULL, NULL } };
+    item c = { 3, { NULL, NULL }, { NULL, NULL } };
+    zlist_run l = zlist_init(run);
+    assert(NULL == z_front(&l) && NULL == z_back(&l) && NULL == z_at(&l, 0));
+
+    z_push(&l, &a);
+    z_push(&l, &b);
+    zlist_push_front(&l, &c);
+    assert(z_front(&l) == &c && z_back(&l) == &b && z_at(&l, 1) == &a);
+    assert(zlist_head(&l) == &c && zlist_tail(&l) == &b);
+    assert(zlist_next_run(&c) == &a && zlist_prev_run(&a) == &c);
+
+    const zlist_run *cl = &l;
+    assert(z_front(cl) == &c && z_back(cl) == &b && z_at(cl, 2) == &b);
+
+    assert(z_pop(&l) == &b);
+    assert(zlist_pop_front(&l) == &c);
+    assert(zlist_pop_front(&l) == &a);
+    assert(NULL == z_pop(&l) && zlist_is_empty(&l));
+}
+
+/* Unrolled lists. */
+
+#define DEQUE 8192
+
+static int ref_q[2 * DEQUE];
+static int ref_head = DEQUE;
+static int ref_tail = DEQUE;
+
+static void check_chunks_ints(zlist_ints *l)
+{
+    size_t total = 0;
+    zlist_chunk_ints *prev = NULL;
+    for (zlist_chunk_ints *c = l->head; c; c = c->next)
+    {
+        assert(c->prev == prev);
+        assert(c->count > 0);
+        assert(c->start + c->count <= zlist_chunk_cap_ints);
+        total += c->count;
+        prev = c;
+    }
+    assert(l->tail == prev);
+    assert(total == l->length);
+}
+
+static void check_ints(zlist_ints *l)
+{
+    size_t n = (size_t)(ref_tail - ref_head);
+    assert(l->length == n);
+    assert(zlist_is_empty(l) == (0 == n));
+    check_chunks_ints(l);
+
+    size_t i = 0;
+    zlist_foreach_unrolled(l, it)
+    {
+        assert(*zlist_iter_value(&it) == ref_q[ref_head + (int)i]);
+        i++;
+    }
+    assert(i == n);
+
+    if (n > 0)
+    {
+        assert(*zlist_front(l) == ref_q[ref_head]);
+        assert(*zlist_back(l) == ref_q[ref_tail - 1]);
+        for (int k = 0; k < 4; k++)
+        {
+            size_t idx = rng_next() % n;
+            assert(*zlist_at(l, idx) == ref_q[ref_head + (int)idx]);
+        }
+    }
+    else
+    {
+        assert(NULL == zlist_front(l) && NULL == zlist_back(l));
+    }
+    assert(NULL == zlist_at(l, n));
+}
+
+static void test_unrolled_fuzz(void)
+{
+    zlist_ints l = zlist_init(ints);
+    int next = 0;
+
+    // A tracked element: its address must not move until it is popped.
+    int *pin = NULL;
+    int pin_val = 0;
+
+    for (int step = 0; step < 40000; step++)
+    {
+        int n = ref_tail - ref_head;
+        int op = (int)(rng_next() % 16);
+        // Drift up to a few thousand elements, then back down.
+        int grow = ((step / 10000) & 1) ? 5 : 9;
+        if (op < grow && ref_tail < 2 * DEQUE && ref_head > 0)
+        {
+            int v = next++;
+            if (op & 1)
+            {
+                assert(Z_OK == zlist_push_back(&l, v));
+                ref_q[ref_tail++] = v;
+            }
+            else
+            {
+                assert(Z_OK == zlist_push_front(&l, v));
+                ref_q[--ref_head] = v;
+            }
+        }
+        else if (op < 15 && n > 0)
+        {
+            int back = (int)(rng_next() & 1);
+            int v = back ? ref_q[ref_tail - 1] : ref_q[ref_head];
+            if (pin && v == pin_val) pin = NULL;
+            if (back)
+            {
+                zlist_pop_back(&l);
+                ref_tail--;
+            }
+            else
+            {
+                zlist_pop_front(&l);
+                ref_head++;
+            }
+        }
+        else if (n > 0 && 0 == (step & 7))
+        {
+            // Reversing swaps elements within their chunks, so the pin moves.
+            zlist_reverse(&l);
+            pin = NULL;
+            for (int i = 0; i < n / 2; i++)
+            {
+                int t = ref_q[ref_head + i];
+                ref_q[ref_head + i] = ref_q[ref_tail - 1 - i];
+                ref_q[ref_tail - 1 - i] = t;
+            }
+        }
+
+        if (!pin && ref_tail > ref_head)
+        {
+            size_t idx = rng_next() % (size_t)(ref_tail - ref_head);
+            pin = zlist_at(&l, idx);
+            pin_val = *pin;
+        }
+        if (pin) assert(*pin == pin_val);
+
+        if (0 == step % 64) check_ints(&l);
+        else check_chunks_ints(&l);
+
+        // Re-centre the reference once it drifts near an edge.
+        if (ref_head < 64 || ref_tail > 2 * DEQUE - 64)
+        {
+            int len = ref_tail - ref_head;
+            if (len <= DEQUE)
+            {
+                memmove(ref_q + DEQUE - len / 2, ref_q + ref_head, (size_t)len * sizeof(int));
+                ref_head = DEQUE - len / 2;
+                ref_tail = ref_head + len;
+            }
+        }
+    }
+    check_ints(&l);
+
+    zlist_clear(&l);
+    assert(zlist_is_empty(&l) && NULL == l.head && NULL == l.tail);
+    ref_head = ref_tail = DEQUE;
+    check_ints(&l);
+}
+
+static void test_unrolled_splice(void)
+{
+    zlist_ints a = zlist_init(ints);
+    zlist_ints b = zlist_init(ints);
+    for (int i = 0; i < 100; i++) assert(Z_OK == zlist_push_back(&a, i));
+    for (int i = 100; i < 250; i++) assert(Z_OK == zlist_push_back(&b, i));
+
+    // Splice hands the chunks over without allocating.
+    long allocs = g_allocs;
+    zlist_splice(&a, &b);
+    assert(g_allocs == allocs);
+    assert(250 == a.length && zlist_is_empty(&b) && NULL == b.head && NULL == b.tail);
+    for (int i = 0; i < 250; i++) assert(i == *zlist_at(&a, (size_t)i));
+    check_chunks_ints(&a);
+
+    // Splicing into an empty list, and an empty list into a full one.
+    zlist_splice(&b, &a);
+    assert(250 == b.length && zlist_is_empty(&a));
+    zlist_splice(&b, &a);
+    zlist_splice(&b, &b);
+    assert(250 == b.length);
+
+    // Pushing after a splice grows the inherited tail chunk.
+    assert(Z_OK == zlist_push_back(&b, 250));
+    assert(Z_OK == zlist_push_front(&b, -1));
+    assert(252 == b.length && -1 == *zlist_front(&b) && 250 == *zlist_back(&b));
+    check_chunks_ints(&b);
+
+    zlist_clear(&b);
+    zlist_clear(&a);
+}
+
+static void test_unrolled_wide(void)
+{
+    assert(4 == zlist_chunk_cap_wides);
+    zlist_wides l = zlist_init(wides);
+    long allocs = g_allocs;
+    for (int i = 0; i < 40; i++)
+    {
+        wide w;
+        memset(&w, 0, sizeof(w));
+        w.key = i;
+        assert(Z_OK == zlist_push_back(&l, w));
+    }
+    // Ten full chunks, allocated once each.
+    assert(10 == g_allocs - allocs);
+    for (int i = 0; i < 40; i++) assert(i == zlist_at(&l, (size_t)i)->key);
+
+    zlist_reverse(&l);
+    int expect = 39;
+    zlist_foreach_unrolled(&l, it)
+    {
+        assert(expect-- == zlist_iter_value(&it)->key);
+    }
+    assert(-1 == expect);
+    while (!zlist_is_empty(&l)) zlist_pop_front(&l);
+    assert(NULL == l.head && NULL == l.tail);
+}
+
+static void test_unrolled_ops(void)
+{
+    zlist_ints l = zlist_init(ints);
+    assert(NULL == z_front(&l) && NULL == z_back(&l));
+    for (int i = 0; i < 10; i++) assert(Z_OK == z_push(&l, i));
+    assert(0 == *z_front(&l) && 9 == *z_back(&l) && 4 == *z_at(&l, 4));
+    const zlist_ints *cl = &l;
+    assert(0 == *z_front(cl) && 9 == *z_back(cl) && 7 == *z_at(cl, 7));
+    z_pop(&l);
+    assert(8 == *z_back(&l) && 9 == l.length);
+    zlist_clear(&l);
+}
+
+static void test_unrolled_out_of_memory(void)
+{
+    zlist_ints l = zlist_init(ints);
+
+    // The first push needs a chunk.
+    g_fail_after = 0;
+    assert(Z_ENOMEM == zlist_push_back(&l, 1));
+    assert(Z_ENOMEM == zlist_push_front(&l, 1));
+    assert(zlist_is_empty(&l) && NULL == l.head);
+
+    // Fill one chunk, then fail at both ends once it is full.
+    g_fail_after = 1;
+    int cap = zlist_chunk_cap_ints;
+    for (int i = 0; i < cap; i++) assert(Z_OK == zlist_push_back(&l, i));
+    assert(Z_ENOMEM == zlist_push_back(&l, cap));
+    assert(Z_ENOMEM == zlist_push_front(&l, -1));
+    assert((size_t)cap == l.length && l.head == l.tail);
+    for (int i = 0; i < cap; i++) assert(i == *zlist_at(&l, (size_t)i));
+    check_chunks_ints(&l);
+
+    g_fail_after = -1;
+    assert(Z_OK == zlist_push_front(&l, -1));
+    assert((size_t)cap + 1 == l.length && -1 == *zlist_front(&l));
+    zlist_clear(&l);
+}
+
+int main(void)
+{
+    test_intrusive_fuzz();
+    test_intrusive_ops();
+    test_unrolled_fuzz();
+    test_unrolled_splice();
+    test_unrolled_wide();
+    test_unrolled_ops();
+    test_unrolled_out_of_memory();
+    printf("zlist: ok\n");
+    return 0;
+}
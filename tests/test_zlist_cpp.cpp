@@ -0,0 +1,77 @@
+/*
+ * Behaviour tests for zlist.h unrolled lists built as C++.
+ * Build and run with `make test`.
+ */
+
+#include <cassert>
+#include <cstdio>
+#include <deque>
+#include <string>
+
+#define REGISTER_ZLIST_UNROLLED_TYPES(X) X(std::string, strs)
+#include "zlist.h"
+
+// Non-trivial elements: chunks construct their slots, pops reset them, clear destroys them.
+static void test_unrolled_strings()
+{
+    zlist_strs l = zlist_init_strs();
+    std::deque<std::string> want;
+    for (int i = 0; i < 2000; i++)
+    {
+        // Long enough to live on the heap, so a missed destructor shows as a leak.
+        std::string s = "element number " + std::to_string(i) + " of the unrolled list";
+        if (i % 3)
+        {
+            assert(Z_OK == zlist_push_back_strs(&l, s));
+            want.push_back(s);
+        }
+        else
+        {
+            assert(Z_OK == zlist_push_front_strs(&l, s));
+            want.push_front(s);
+        }
+        if (0 == i % 5)
+        {
+            // The popped slot is reset unless its chunk was freed with it.
+            zlist_chunk_strs *c = l.tail;
+            bool kept = c->count > 1;
+            uint32_t slot = c->start + c->count - 1;
+            zlist_pop_back_strs(&l);
+            want.pop_back();
+            if (kept) assert(c->items[slot].empty());
+        }
+        if (0 == i % 7 && !want.empty())
+        {
+            zlist_pop_front_strs(&l);
+            want.pop_front();
+        }
+    }
+
+    assert(want.size() == l.length);
+    size_t i = 0;
+    for (zlist_iter_strs it = zlist_iter_begin_strs(&l); zlist_iter_valid_strs(&it); zlist_iter_next_strs(&it))
+    {
+        assert(want[i++] == *zlist_iter_value_strs(&it));
+    }
+    assert(want.front() == *zlist_front_strs(&l) && want.back() == *zlist_back_strs(&l));
+    assert(want[want.size() / 3] == *zlist_at_strs(&l, want.size() / 3));
+
+    zlist_reverse_strs(&l);
+    assert(want.back() == *zlist_front_strs(&l) && want.front() == *zlist_back_strs(&l));
+
+    zlist_strs other = zlist_init_strs();
+    assert(Z_OK == zlist_push_back_strs(&other, std::string(64, 'x')));
+    zlist_splice_strs(&l, &other);
+    assert(want.size() + 1 == l.length && zlist_is_empty_strs(&other));
+    assert(std::string(64, 'x') == *zlist_back_strs(&l));
+
+    zlist_clear_strs(&l);
+    assert(zlist_is_empty_strs(&l) && 0 == l.length);
+}
+
+int main()
+{
+    test_unrolled_strings();
+    std::printf("zlist_cpp: ok\n");
+    return 0;
+}
@@ -0,0 +1,585 @@
+/*
+ * Behaviour tests for zmap.h.
+ * Build and run with `make test`; test_zmap_scalar.c re-runs them without SIMD or compiler extensions.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+
+#define ZALLOC_IMPLEMENTATION
+#include "zalloc.h"
+
+typedef struct
+{
+    long double x;
+    char tag;
+} wide_val;
+
+#define REGISTER_ZMAP_TYPES(X) X(int, int, std_ii)
+#define REGISTER_STABLE_MAPS(X) X(int, int, stable_ii) X(int, wide_val, stable_iw)
+#define REGISTER_FLAT_MAPS(X) X(int, int, flat_ii)
+#define REGISTER_FLAT_CACHED_MAPS(X) X(int, int, cached_ii)
+#define REGISTER_CONCURRENT_MAPS(X) X(int, int, conc_ii)
+#define ZTHREAD_IMPLEMENTATION
+#include "zmap.h"
+
+#define FUZZ_KEYS 4096
+#define FUZZ_OPS  200000
+
+static uint32_t rng_state = 12345u;
+
+static uint32_t rng_next(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static uint32_t hash_int(int k, uint32_t seed)
+{
+    uint32_t h = (uint32_t)k * 2654435761u ^ seed;
+    return h ^ (h >> 15);
+}
+
+// Deliberately poor: every key lands in a handful of groups, so probing and tombstones get exercised.
+static uint32_t hash_int_weak(int k, uint32_t seed)
+{
+    (void)seed;
+    return (uint32_t)(k & 7) * 0x01010101u;
+}
+
+static int cmp_int(int a, int b)
+{
+    return (a > b) - (a < b);
+}
+
+static size_t hash_calls, cmp_calls;
+
+static uint32_t hash_int_counted(int k, uint32_t seed)
+{
+    hash_calls++;
+    return hash_int(k, seed);
+}
+
+static int cmp_int_counted(int a, int b)
+{
+    cmp_calls++;
+    return cmp_int(a, b);
+}
+
+// Random put/get/remove against a plain array, then a full sweep and an iterator pass.
+static void fuzz_flat(uint32_t (*h)(int, uint32_t))
+{
+    static int ref[FUZZ_KEYS];
+    static bool present[FUZZ_KEYS];
+    memset(present, 0, sizeof(present));
+    size_t live = 0;
+
+    zmap_flat_flat_ii m = zmap_init_flat(flat_ii, h, cmp_int);
+    for (int op = 0; op < FUZZ_OPS; op++)
+    {
+        int k = (int)(rng_next() % FUZZ_KEYS);
+        uint32_t what = rng_next() % 4;
+        if (what < 2)
+        {
+            int v = (int)rng_next();
+            assert(Z_OK == zmap_put(&m, k, v));
+            live += !present[k];
+            present[k] = true;
+            ref[k] = v;
+        }
+        else if (2 == what)
+        {
+            zmap_remove(&m, k);
+            live -= present[k];
+            present[k] = false;
+        }
+        else
+        {
+            int *v = zmap_get(&m, k);
+            assert((NULL != v) == present[k]);
+            assert(!v || *v == ref[k]);
+        }
+        assert(zmap_size(&m) == live);
+    }
+
+    for (int k = 0; k < FUZZ_KEYS; k++)
+    {
+        int *v = zmap_get(&m, k);
+        assert((NULL != v) == present[k]);
+        assert(!v || *v == ref[k]);
+    }
+
+    size_t seen = 0;
+    int key, val;
+    zmap_iter_flat_flat_ii it = zmap_iter_init(flat_ii, &m);
+    while (zmap_iter_next(&it, &key, &val))
+    {
+        assert(present[key] && ref[key] == val);
+        seen++;
+    }
+    assert(seen == live);
+
+    zmap_free(&m);
+    assert(0 == zmap_size(&m));
+    zmap_free(&m);
+}
+
+static void test_flat_basic(void)
+{
+    zmap_flat_flat_ii m = zmap_init_flat(flat_ii, hash_int, cmp_int);
+    assert(NULL == zmap_get(&m, 1));
+    zmap_remove(&m, 1);
+
+    for (int i = 0; i < 1000; i++)
+    {
+        assert(Z_OK == zmap_put(&m, i, i * 2));
+    }
+    assert(Z_OK == zmap_put(&m, 7, -7));
+    assert(1000 == zmap_size(&m));
+    assert(-7 == *zmap_get(&m, 7));
+    assert(m.count <= m.capacity * 7 / 8);
+
+    int *k, *v;
+    size_t n = 0;
+    zmap_foreach_flat(flat_ii, &m, k, v)
+    {
+        assert(*v == (7 == *k ? -7 : *k * 2));
+        n++;
+    }
+    assert(1000 == n);
+
+    zmap_clear(&m);
+    assert(0 == zmap_size(&m));
+    assert(NULL == zmap_get(&m, 7));
+    assert(Z_OK == zmap_put(&m, 7, 1));
+    zmap_free(&m);
+
+    // Out-of-range load factors fall back to the default.
+    zmap_flat_flat_ii e = zmap_init_ext_flat_flat_ii(hash_int, cmp_int, 2.0f);
+    assert(ZMAP_FLAT_DEFAULT_LOAD == e.load_factor);
+    e = zmap_init_ext_flat_flat_ii(hash_int, cmp_int, 0.5f);
+    for (int i = 0; i < 100; i++)
+    {
+        assert(Z_OK == zmap_put(&e, i, i));
+    }
+    assert(e.count <= e.capacity / 2);
+    zmap_free(&e);
+}
+
+static void test_flat_fuzz(void)
+{
+    fuzz_flat(hash_int);
+    fuzz_flat(hash_int_weak);
+}
+
+// Pinned outputs: the 128-bit multiply and its portable fallback (Z_NO_EXTENSIONS) must agree.
+static void test_wyhash(void)
+{
+    static const uint32_t expect[] =
+    {
+        0xF2DD051Bu, 0x1A2284C0u, 0x2A1D71F9u, 0x45C38BBAu, 0x1977D712u, 0x41C12FF7u, 0x32CD053Au,
+        0xC9ABB558u, 0x7A2FB96Cu, 0x111C7A2Du, 0x7C919269u, 0xCE2797BEu, 0x127C0595u, 0xFD5B9BFEu,
+    };
+    static const size_t lens[] = { 0, 1, 3, 4, 7, 8, 15, 16, 17, 31, 32, 33, 48, 100 };
+    unsigned char buf[128];
+    for (int i = 0; i < 128; i++)
+    {
+        buf[i] = (unsigned char)(i * 7 + 1);
+    }
+    for (size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++)
+    {
+        assert(expect[i] == zmap_wyhash(buf, lens[i], 0x1234u));
+    }
+
+    // Unaligned starts and exact-length reads (ASan catches any overread).
+    for (size_t len = 0; len <= 40; len++)
+    {
+        for (size_t off = 0; off < 8; off++)
+        {
+            unsigned char *copy = (unsigned char *)malloc(len ? len : 1);
+            memcpy(copy, buf + off, len);
+            assert(zmap_wyhash(buf + off, len, 7) == zmap_wyhash(copy, len, 7));
+            free(copy);
+        }
+    }
+
+    assert(zmap_wyhash("abc", 3, 1) != zmap_wyhash("abc", 3, 2));
+    assert(0xE40C292Cu == zmap_fnv1a_hash("a", 1, 0));
+}
+
+// Cached flat slots: resize never rehashes and a hash mismatch skips the key comparison.
+static void test_flat_cached(void)
+{
+    zmap_flat_cached_ii c = zmap_init_flat(cached_ii, hash_int_counted, cmp_int_counted);
+    zmap_flat_flat_ii p = zmap_init_flat(flat_ii, hash_int_counted, cmp_int_counted);
+    assert(sizeof(zmap_bucket_flat_cached_ii) > sizeof(zmap_bucket_flat_flat_ii));
+
+    hash_calls = 0;
+    for (int i = 0; i < 5000; i++)
+    {
+        assert(Z_OK == zmap_put(&c, i, i));
+    }
+    assert(5000 == hash_calls);
+
+    hash_calls = 0;
+    for (int i = 0; i < 5000; i++)
+    {
+        assert(Z_OK == zmap_put(&p, i, i));
+    }
+    assert(hash_calls > 5000);
+
+    cmp_calls = 0;
+    for (int i = 5000; i < 10000; i++)
+    {
+        assert(NULL == zmap_get(&c, i));
+    }
+    size_t cached_cmps = cmp_calls;
+    cmp_calls = 0;
+    for (int i = 5000; i < 10000; i++)
+    {
+        assert(NULL == zmap_get(&p, i));
+    }
+    assert(cached_cmps < cmp_calls);
+
+    for (int i = 0; i < 5000; i += 2)
+    {
+        zmap_remove(&c, i);
+    }
+    for (int i = 0; i < 5000; i++)
+    {
+        int *v = zmap_get(&c, i);
+        assert((i & 1) ? (v && *v == i) : !v);
+    }
+    zmap_free(&c);
+    zmap_free(&p);
+}
+
+#define CONC_THREADS 4
+#define CONC_PER     20000
+
+typedef struct
+{
+    zmap_concurrent_conc_ii *m;
+    int id;
+} conc_job;
+
+// Each writer owns a key range: insert it, overwrite it, drop the odd keys, checking its own view.
+static void conc_writer(void *arg)
+{
+    conc_job *j = (conc_job *)arg;
+    int base = j->id * CONC_PER;
+    for (int i = 0; i < CONC_PER; i++)
+    {
+        assert(Z_OK == zmap_put_concurrent_conc_ii(j->m, base + i, i));
+    }
+    for (int i = 0; i < CONC_PER; i++)
+    {
+        assert(Z_OK == zmap_put_concurrent_conc_ii(j->m, base + i, -i));
+    }
+    for (int i = 1; i < CONC_PER; i += 2)
+    {
+        zmap_remove_concurrent_conc_ii(j->m, base + i);
+    }
+    for (int i = 0; i < CONC_PER; i++)
+    {
+        int v = 1;
+        bool found = zmap_get_concurrent_conc_ii(j->m, base + i, &v);
+        assert(found == (0 == (i & 1)));
+        assert(!found || v == -i);
+    }
+}
+
+// Readers only ever see a key absent or holding one of the values its writer stores.
+static void conc_reader(void *arg)
+{
+    conc_job *j = (conc_job *)arg;
+    for (int round = 0; round < 4; round++)
+    {
+        for (int k = 0; k < CONC_THREADS * CONC_PER; k += 7)
+        {
+            int v;
+            if (zmap_get_concurrent_conc_ii(j->m, k, &v))
+            {
+                int i = k % CONC_PER;
+                assert(v == i || v == -i);
+            }
+        }
+    }
+}
+
+static void test_concurrent(void)
+{
+    zmap_concurrent_conc_ii m;
+    assert(Z_OK == zmap_init_concurrent_conc_ii(&m, 0, hash_int, cmp_int));
+    assert(ZMAP_CONCURRENT_DEFAULT_SHARDS == m.shard_count);
+    assert(0 == ((uintptr_t)m.shards & (ZMAP_CACHE_LINE - 1)));
+
+    zthread_t threads[CONC_THREADS + 1];
+    conc_job jobs[CONC_THREADS + 1];
+    for (int t = 0; t <= CONC_THREADS; t++)
+    {
+        jobs[t].m = &m;
+        jobs[t].id = t;
+        assert(Z_OK == zthread_create(&threads[t], t < CONC_THREADS ? conc_writer : conc_reader, &jobs[t]));
+    }
+    for (int t = 0; t <= CONC_THREADS; t++)
+    {
+        zthread_join(threads[t]);
+    }
+    assert((size_t)CONC_THREADS * CONC_PER / 2 == zmap_size_concurrent_conc_ii(&m));
+
+    zmap_clear_concurrent_conc_ii(&m);
+    assert(0 == zmap_size_concurrent_conc_ii(&m));
+    zmap_free_concurrent_conc_ii(&m);
+    zmap_free_concurrent_conc_ii(&m);
+
+    // Shard counts round up to a power of two and are capped.
+    assert(Z_OK == zmap_init_concurrent_conc_ii(&m, 3, hash_int, cmp_int));
+    assert(4 == m.shard_count);
+    zmap_free_concurrent_conc_ii(&m);
+}
+
+// Batched calls must match one-at-a-time calls, across batch boundaries and with duplicates.
+static void test_concurrent_batch(void)
+{
+    enum { N = 1000 };
+    static int keys[N], vals[N], out[N];
+    static bool found[N];
+    zmap_concurrent_conc_ii m;
+    assert(Z_OK == zmap_init_concurrent_conc_ii(&m, 16, hash_int, cmp_int));
+
+    for (int i = 0; i < N; i++)
+    {
+        keys[i] = (int)(rng_next() % 600);
+        vals[i] = i;
+    }
+    assert(Z_OK == zmap_put_many_concurrent_conc_ii(&m, keys, vals, N));
+    for (int i = 0; i < N; i++)
+    {
+        int v;
+        assert(zmap_get_concurrent_conc_ii(&m, keys[i], &v));
+        // Later duplicates win.
+        int last = i;
+        for (int k = i + 1; k < N; k++)
+        {
+            if (keys[k] == keys[i])
+            {
+                last = k;
+            }
+        }
+        assert(v == last);
+    }
+
+    for (int i = 0; i < N; i++)
+    {
+        keys[i] = (int)(rng_next() % 1200);
+        out[i] = -1;
+    }
+    size_t hits = zmap_get_many_concurrent_conc_ii(&m, keys, out, found, N);
+    size_t expect = 0;
+    for (int i = 0; i < N; i++)
+    {
+        int v = -1;
+        bool one = zmap_get_concurrent_conc_ii(&m, keys[i], &v);
+        assert(one == found[i]);
+        assert(out[i] == (one ? v : -1));
+        expect += one;
+    }
+    assert(hits == expect);
+    assert(0 == zmap_get_many_concurrent_conc_ii(&m, keys, out, NULL, 0));
+    zmap_free_concurrent_conc_ii(&m);
+}
+
+// Robin Hood layout: an entry displaced by d sits right after one displaced by at least d - 1.
+static void check_robin_hood(zmap_std_ii *m)
+{
+    for (size_t i = 0; i < m->capacity; i++)
+    {
+        if (ZMAP_OCCUPIED != m->buckets[i].state)
+        {
+            continue;
+        }
+        size_t d = zmap_dist(i, m->capacity, m->buckets[i].stored_hash, m->bits);
+        if (d > 0)
+        {
+            size_t prev = (i + m->capacity - 1) & (m->capacity - 1);
+            assert(ZMAP_OCCUPIED == m->buckets[prev].state);
+            assert(zmap_dist(prev, m->capacity, m->buckets[prev].stored_hash, m->bits) + 1 >= d);
+        }
+    }
+}
+
+static void test_reserve(void)
+{
+    zmap_std_ii a = zmap_init(std_ii, hash_int, cmp_int);
+    zmap_stable_stable_ii b = zmap_init_stable(stable_ii, hash_int, cmp_int);
+    zmap_flat_flat_ii c = zmap_init_flat(flat_ii, hash_int, cmp_int);
+    assert(Z_OK == zmap_reserve(&a, 3000));
+    assert(Z_OK == zmap_reserve(&b, 3000));
+    assert(Z_OK == zmap_reserve(&c, 3000));
+    size_t ca = a.capacity, cb = b.capacity, cc = c.capacity;
+    for (int i = 0; i < 3000; i++)
+    {
+        assert(Z_OK == zmap_put(&a, i, i));
+        assert(Z_OK == zmap_put(&b, i, i));
+        assert(Z_OK == zmap_put(&c, i, i));
+    }
+    assert(ca == a.capacity && cb == b.capacity && cc == c.capacity);
+    // Reserving less than the current size never shrinks.
+    assert(Z_OK == zmap_reserve(&a, 10));
+    assert(ca == a.capacity);
+    check_robin_hood(&a);
+    zmap_free(&a);
+    zmap_free(&b);
+    zmap_free(&c);
+}
+
+static void test_build(void)
+{
+    enum { N = 50000 };
+    static int keys[N], vals[N];
+    for (int i = 0; i < N; i++)
+    {
+        keys[i] = (int)(rng_next() % (N / 2));
+        vals[i] = i;
+    }
+
+    zmap_std_ii ref = zmap_init(std_ii, hash_int, cmp_int);
+    for (int i = 0; i < N; i++)
+    {
+        assert(Z_OK == zmap_put(&ref, keys[i], vals[i]));
+    }
+
+    zmap_std_ii one = zmap_init(std_ii, hash_int, cmp_int);
+    assert(Z_OK == zmap_build_std_ii(&one, keys, vals, N));
+    assert(zmap_size(&one) == zmap_size(&ref));
+    check_robin_hood(&one);
+
+    zmap_std_ii par = zmap_init(std_ii, hash_int, cmp_int);
+    assert(Z_OK == zmap_build_parallel_std_ii(&par, keys, vals, N, 8));
+    assert(zmap_size(&par) == zmap_size(&ref));
+    check_robin_hood(&par);
+
+    int k, v;
+    zmap_iter_std_ii it = zmap_iter_init(std_ii, &ref);
+    while (zmap_iter_next(&it, &k, &v))
+    {
+        // Serial builds keep the last duplicate; the parallel build keeps one of them.
+        assert(v == *zmap_get(&one, k));
+        int pv = *zmap_get(&par, k);
+        assert(pv >= 0 && pv < N && keys[pv] == k);
+    }
+
+    // Unique keys: the parallel build must reproduce every pair exactly.
+    zmap_free(&par);
+    par = zmap_init(std_ii, hash_int, cmp_int);
+    for (int i = 0; i < N; i++)
+    {
+        keys[i] = i * 3;
+    }
+    assert(Z_OK == zmap_build_parallel_std_ii(&par, keys, vals, N, 4));
+    assert(N == zmap_size(&par));
+    check_robin_hood(&par);
+    for (int i = 0; i < N; i++)
+    {
+        assert(vals[i] == *zmap_get(&par, i * 3));
+    }
+
+    // A non-empty map takes the serial path and merges.
+    assert(Z_OK == zmap_build_parallel_std_ii(&par, keys, vals, 10, 4));
+    assert(N == zmap_size(&par));
+
+    zmap_free(&ref);
+    zmap_free(&one);
+    zmap_free(&par);
+}
+
+static bool in_pool(const zpool *p, const void *ptr)
+{
+    size_t span = p->item_size * p->count_per_block + ZPOOL_MAX_ALIGN;
+    for (size_t b = 0; b < p->block_count; b++)
+    {
+        const char *lo = (const char *)p->blocks[b];
+        if ((const char *)ptr >= lo && (const char *)ptr < lo + span)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void test_stable_pool(void)
+{
+    enum { N = 3000, PER = 64 };
+    static wide_val *where[N];
+    zmap_stable_stable_iw m = zmap_init_stable_pool(stable_iw, hash_int, cmp_int, PER);
+    assert(m.pooled);
+    for (int i = 0; i < N; i++)
+    {
+        wide_val v = { (long double)i, (char)i };
+        assert(Z_OK == zmap_put(&m, i, v));
+        where[i] = zmap_get(&m, i);
+    }
+    // Values never move on table growth, come from the pool's slabs and keep max_align_t alignment.
+    for (int i = 0; i < N; i++)
+    {
+        wide_val *v = zmap_get(&m, i);
+        assert(v == where[i] && (long double)i == v->x);
+        assert(in_pool(&m.value_pool, v));
+        assert(0 == (uintptr_t)v % _Alignof(max_align_t));
+    }
+    size_t blocks = m.value_pool.block_count;
+    assert(blocks == (N + PER - 1) / PER);
+
+    // Removed slots are recycled before the pool grows.
+    for (int i = 0; i < N; i += 2)
+    {
+        zmap_remove(&m, i);
+    }
+    for (int i = 0; i < N; i += 2)
+    {
+        wide_val v = { -1.0L, 'x' };
+        assert(Z_OK == zmap_put(&m, N + i, v));
+    }
+    assert(blocks == m.value_pool.block_count);
+    assert(N == zmap_size(&m));
+
+    // Clear drops the slabs but the map stays usable with the same geometry.
+    zmap_clear(&m);
+    assert(0 == zmap_size(&m) && 0 == m.value_pool.block_count);
+    wide_val v = { 2.0L, 'y' };
+    assert(Z_OK == zmap_put(&m, 5, v));
+    assert('y' == zmap_get(&m, 5)->tag && PER == m.value_pool.count_per_block);
+    zmap_free(&m);
+    zmap_free(&m);
+
+    // 0 items per block means ZMAP_POOL_DEFAULT_BLOCK; a plain stable map is not pooled.
+    zmap_stable_stable_ii d = zmap_init_stable_pool(stable_ii, hash_int, cmp_int, 0);
+    assert(ZMAP_POOL_DEFAULT_BLOCK == d.value_pool.count_per_block);
+    zmap_free(&d);
+    zmap_stable_stable_ii u = zmap_init_stable(stable_ii, hash_int, cmp_int);
+    assert(!u.pooled);
+    assert(Z_OK == zmap_put(&u, 1, 1));
+    zmap_free(&u);
+}
+
+int main(void)
+{
+    test_flat_basic();
+    test_flat_fuzz();
+    test_wyhash();
+    test_flat_cached();
+    test_concurrent();
+    test_concurrent_batch();
+    test_reserve();
+    test_build();
+    test_stable_pool();
+    printf("zmap: ok\n");
+    return 0;
+}
@@ -0,0 +1,4 @@
+// The zmap tests again, on the scalar group probe and the portable 64x64 multiply.
+#define ZMAP_NO_SIMD
+#define Z_NO_EXTENSIONS
+#include "test_zmap.c"
@@ -0,0 +1,370 @@
+/*
+ * Behaviour tests for zmath.h: the batch and SoA stream kernels against the scalar API,
+ * and the zvec4/zmat4 helpers against plain references.
+ * Build and run with `make test`.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ZMATH_IMPLEMENTATION
+#include "zmath.h"
+
+#define N 67
+
+static uint64_t g_rng = 0x9E3779B97F4A7C15ULL;
+
+static float rng_float(float lo, float hi)
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return lo + (hi - lo) * (float)(g_rng >> 40) / (float)(1 << 24);
+}
+
+static int near(float a, float b, float tol)
+{
+    float scale = fabsf(b) > 1.0f ? fabsf(b) : 1.0f;
+    return fabsf(a - b) <= tol * scale;
+}
+
+/* Batch math. */
+
+static void test_batch(void)
+{
+    float in[N], out[N], copy[N], fresh[N];
+    for (int i = 0; i < N; i++) in[i] = rng_float(-100.0f, 100.0f);
+    // Exact multiples and the fold points.
+    in[0] = 0.0f;
+    in[1] = ZMATH_HALF_PI;
+    in[2] = -ZMATH_PI;
+    in[3] = ZMATH_TAU;
+
+    // Every length up to N, so each ragged tail goes through the padded block.
+    for (size_t n = 0; n <= N; n++)
+    {
+        memset(out, 0x7f, sizeof(out));
+        memset(fresh, 0x7f, sizeof(fresh));
+        zmath_sin_n(out, in, n);
+        for (size_t i = 0; i < n; i++)
+        {
+            assert(near(out[i], zmath_sin(in[i]), 1e-5f));
+            assert(fabsf(out[i] - sinf(in[i])) < 1e-4f);
+        }
+        // Nothing past n is written.
+        assert(0 == memcmp(out + n, fresh + n, (N - n) * sizeof(float)));
+
+        zmath_cos_n(out, in, n);
+        for (size_t i = 0; i < n; i++)
+        {
+            assert(near(out[i], zmath_cos(in[i]), 1e-5f));
+            assert(fabsf(out[i] - cosf(in[i])) < 1e-4f);
+        }
+    }
+
+    float ein[N];
+    for (int i = 0; i < N; i++) ein[i] = rng_float(-80.0f, 80.0f);
+    ein[0] = 0.0f;
+    ein[1] = 1.0f;
+    ein[2] = -1.0f;
+    for (size_t n = 0; n <= N; n++)
+    {
+        zmath_exp_n(out, ein, n);
+        for (size_t i = 0; i < n; i++)
+        {
+            float want = expf(ein[i]);
+            assert(near(out[i], zmath_exp(ein[i]), 1e-5f));
+            assert(fabsf(out[i] - want) <= 1e-3f * want);
+        }
+    }
+
+    // In place.
+    memcpy(copy, in, sizeof(in));
+    zmath_sin_n(copy, copy, N);
+    zmath_sin_n(out, in, N);
+    assert(0 == memcmp(copy, out, sizeof(out)));
+}
+
+/* SoA streams. */
+
+typedef struct
+{
+    float x[N], y[N], z[N], w[N];
+} soa;
+
+static zvec3_stream v3_of(soa *s, size_t n)
+{
+    zvec3_stream r = { s->x, s->y, s->z, n };
+    return r;
+}
+
+static zvec4_stream v4_of(soa *s, size_t n)
+{
+    zvec4_stream r = { s->x, s->y, s->z, s->w, n };
+    return r;
+}
+
+static zvec3 v3_at(const soa *s, size_t i)
+{
+    zvec3 r = { s->x[i], s->y[i], s->z[i] };
+    return r;
+}
+
+static zvec4 v4_at(const soa *s, size_t i)
+{
+    zvec4 r = { s->x[i], s->y[i], s->z[i], s->w[i] };
+    return r;
+}
+
+static void fill(soa *s)
+{
+    for (int i = 0; i < N; i++)
+    {
+        s->x[i] = rng_float(-10.0f, 10.0f);
+        s->y[i] = rng_float(-10.0f, 10.0f);
+        s->z[i] = rng_float(-10.0f, 10.0f);
+        s->w[i] = rng_float(-10.0f, 10.0f);
+    }
+}
+
+static void assert_v3_eq(zvec3 a, zvec3 b)
+{
+    assert(a.x == b.x && a.y == b.y && a.z == b.z);
+}
+
+static void assert_v3_near(zvec3 a, zvec3 b, float tol)
+{
+    assert(near(a.x, b.x, tol) && near(a.y, b.y, tol) && near(a.z, b.z, tol));
+}
+
+static void assert_v4_near(zvec4 a, zvec4 b, float tol)
+{
+    assert(near(a.x, b.x, tol) && near(a.y, b.y, tol) && near(a.z, b.z, tol) && near(a.w, b.w, tol));
+}
+
+static zmat4 test_matrix(void)
+{
+    zvec3 axis = { 1.0f, 2.0f, -0.5f };
+    zvec3 t = { 3.0f, -4.0f, 0.25f };
+    zvec3 sc = { 2.0f, 0.5f, 1.5f };
+    zmat4 r = zmath_m4_rotate(axis, 0.7f);
+    zmat4 tr = zmath_m4_translate(t);
+    zmat4 s = zmath_m4_scale(sc);
+    zmat4 rs = zmath_m4_mul(&r, &s);
+    zmat4 m = zmath_m4_mul(&tr, &rs);
+    // A projective bottom row, so the vec4 transforms use every entry.
+    m.m[3] = 0.1f;
+    m.m[7] = -0.2f;
+    m.m[11] = 0.3f;
+    return m;
+}
+
+static void test_v3_streams(void)
+{
+    static soa a, b, out;
+    fill(&a);
+    fill(&b);
+    // Zero vectors pass through normalisation.
+    a.x[5] = a.y[5] = a.z[5] = 0.0f;
+    a.x[N - 1] = a.y[N - 1] = a.z[N - 1] = 0.0f;
+    zmat4 m = test_matrix();
+    float d[N];
+
+    for (size_t n = 0; n <= N; n++)
+    {
+        zvec3_stream sa = v3_of(&a, n), sb = v3_of(&b, n), so = v3_of(&out, n);
+
+        zmath_v3_stream_add(&so, &sa, &sb);
+        for (size_t i = 0; i < n; i++) assert_v3_eq(v3_at(&out, i), zmath_v3_add(v3_at(&a, i), v3_at(&b, i)));
+
+        zmath_v3_stream_sub(&so, &sa, &sb);
+        for (size_t i = 0; i < n; i++) assert_v3_eq(v3_at(&out, i), zmath_v3_sub(v3_at(&a, i), v3_at(&b, i)));
+
+        zmath_v3_stream_scale(&so, &sa, -1.25f);
+        for (size_t i = 0; i < n; i++) assert_v3_eq(v3_at(&out, i), zmath_v3_scale(v3_at(&a, i), -1.25f));
+
+        zmath_v3_stream_madd(&so, &sa, &sb, 0.016f);
+        for (size_t i = 0; i < n; i++)
+        {
+            zvec3 want = zmath_v3_add(v3_at(&a, i), zmath_v3_scale(v3_at(&b, i), 0.016f));
+            assert_v3_near(v3_at(&out, i), want, 1e-6f);
+        }
+
+        zmath_v3_stream_dot(d, &sa, &sb);
+        for (size_t i = 0; i < n; i++) assert(near(d[i], zmath_v3_dot(v3_at(&a, i), v3_at(&b, i)), 1e-5f));
+
+        zmath_v3_stream_cross(&so, &sa, &sb);
+        for (size_t i = 0; i < n; i++) assert_v3_near(v3_at(&out, i), zmath_v3_cross(v3_at(&a, i), v3_at(&b, i)), 1e-5f);
+
+        // The scalar square root is an approximation; the vector one is exact.
+        zmath_v3_stream_len(d, &sa);
+        for (size_t i = 0; i < n; i++)
+        {
+            zvec3 v = v3_at(&a, i);
+            assert(near(d[i], zmath_v3_len(v), 1e-5f));
+            assert(near(d[i], sqrtf(v.x * v.x + v.y * v.y + v.z * v.z), 1e-5f));
+        }
+
+        zmath_v3_stream_norm(&so, &sa);
+        for (size_t i = 0; i < n; i++)
+        {
+            assert_v3_near(v3_at(&out, i), zmath_v3_norm(v3_at(&a, i)), 1e-5f);
+            if (5 == i || N - 1 == i) assert_v3_eq(v3_at(&out, i), v3_at(&a, i));
+        }
+
+        zmath_v3_stream_transform(&so, &m, &sa);
+        for (size_t i = 0; i < n; i++) assert_v3_near(v3_at(&out, i), zmath_m4_transform_point(&m, v3_at(&a, i)), 1e-5f);
+    }
+
+    // Outputs may alias inputs: pos += vel * dt in place.
+    static soa pos;
+    pos = a;
+    zvec3_stream sp = v3_of(&pos, N), sb = v3_of(&b, N), so = v3_of(&out, N), sa = v3_of(&a, N);
+    zmath_v3_stream_madd(&sp, &sp, &sb, 0.5f);
+    zmath_v3_stream_madd(&so, &sa, &sb, 0.5f);
+    assert(0 == memcmp(pos.x, out.x, sizeof(pos.x)) && 0 == memcmp(pos.z, out.z, sizeof(pos.z)));
+
+    pos = a;
+    zmath_v3_stream_cross(&sp, &sp, &sb);
+    zmath_v3_stream_cross(&so, &sa, &sb);
+    assert(0 == memcmp(pos.y, out.y, sizeof(pos.y)));
+}
+
+static void test_v4_streams(void)
+{
+    static soa a, b, out;
+    fill(&a);
+    fill(&b);
+    zmat4 m = test_matrix();
+    float d[N];
+
+    for (size_t n = 0; n <= N; n++)
+    {
+        zvec4_stream sa = v4_of(&a, n), sb = v4_of(&b, n), so = v4_of(&out, n);
+
+        zmath_v4_stream_add(&so, &sa, &sb);
+        for (size_t i = 0; i < n; i++) assert_v4_near(v4_at(&out, i), zmath_v4_add(v4_at(&a, i), v4_at(&b, i)), 0.0f);
+
+        zmath_v4_stream_scale(&so, &sa, 3.0f);
+        for (size_t i = 0; i < n; i++) assert_v4_near(v4_at(&out, i), zmath_v4_scale(v4_at(&a, i), 3.0f), 0.0f);
+
+        zmath_v4_stream_madd(&so, &sa, &sb, -0.75f);
+        for (size_t i = 0; i < n; i++)
+        {
+            zvec4 want = zmath_v4_add(v4_at(&a, i), zmath_v4_scale(v4_at(&b, i), -0.75f));
+            assert_v4_near(v4_at(&out, i), want, 1e-6f);
+        }
+
+        zmath_v4_stream_dot(d, &sa, &sb);
+        for (size_t i = 0; i < n; i++) assert(near(d[i], zmath_v4_dot(v4_at(&a, i), v4_at(&b, i)), 1e-5f));
+
+        zmath_v4_stream_transform(&so, &m, &sa);
+        for (size_t i = 0; i < n; i++) assert_v4_near(v4_at(&out, i), zmath_m4_mul_v4(&m, v4_at(&a, i)), 1e-5f);
+    }
+}
+
+/* Matrices. */
+
+static void ref_m4_mul(float *r, const float *a, const float *b)
+{
+    for (int c = 0; c < 4; c++)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            double s = 0.0;
+            for (int k = 0; k < 4; k++) s += (double)a[k * 4 + i] * b[c * 4 + k];
+            r[c * 4 + i] = (float)s;
+        }
+    }
+}
+
+static void test_matrices(void)
+{
+    assert(16 == sizeof(zvec4) && 0 == _Alignof(zvec4) % 16);
+    assert(64 == sizeof(zmat4) && 0 == _Alignof(zmat4) % 16);
+
+    zmat4 id = zmath_m4_identity();
+    for (int k = 0; k < 16; k++) assert(id.m[k] == ((0 == k % 5) ? 1.0f : 0.0f));
+
+    zmat4 a, b;
+    for (int k = 0; k < 16; k++)
+    {
+        a.m[k] = rng_float(-2.0f, 2.0f);
+        b.m[k] = rng_float(-2.0f, 2.0f);
+    }
+    zmat4 ab = zmath_m4_mul(&a, &b);
+    float want[16];
+    ref_m4_mul(want, a.m, b.m);
+    for (int k = 0; k < 16; k++) assert(near(ab.m[k], want[k], 1e-5f));
+
+    zmat4 ia = zmath_m4_mul(&id, &a);
+    assert(0 == memcmp(ia.m, a.m, sizeof(a.m)));
+
+    // (AB)^T = B^T A^T, and transposing twice is the identity.
+    zmat4 at = zmath_m4_transpose(&a), bt = zmath_m4_transpose(&b);
+    zmat4 abt = zmath_m4_transpose(&ab), btat = zmath_m4_mul(&bt, &at);
+    for (int k = 0; k < 16; k++) assert(near(abt.m[k], btat.m[k], 1e-5f));
+    zmat4 att = zmath_m4_transpose(&at);
+    assert(0 == memcmp(att.m, a.m, sizeof(a.m)));
+    assert(at.m[1] == a.m[4] && at.m[14] == a.m[11]);
+
+    // Rotations are orthonormal, and a quarter turn about z takes x to y.
+    zvec3 axis = { 0.3f, -1.0f, 2.0f };
+    zmat4 r = zmath_m4_rotate(axis, 1.1f);
+    zmat4 rt = zmath_m4_transpose(&r);
+    zmat4 rrt = zmath_m4_mul(&r, &rt);
+    for (int k = 0; k < 16; k++) assert(near(rrt.m[k], id.m[k], 1e-4f));
+
+    zvec3 z = { 0.0f, 0.0f, 1.0f }, x = { 1.0f, 0.0f, 0.0f }, y = { 0.0f, 1.0f, 0.0f };
+    zmat4 qz = zmath_m4_rotate(z, ZMATH_HALF_PI);
+    assert_v3_near(zmath_m4_transform_point(&qz, x), y, 1e-4f);
+
+    // Translate and scale act on points as expected; column-major translation lives in m[12..14].
+    zvec3 t = { 1.0f, 2.0f, 3.0f }, s = { 2.0f, 3.0f, 4.0f }, p = { 1.0f, -1.0f, 0.5f };
+    zmat4 tm = zmath_m4_translate(t), sm = zmath_m4_scale(s);
+    assert(1.0f == tm.m[12] && 2.0f == tm.m[13] && 3.0f == tm.m[14]);
+    zvec3 tp = { 2.0f, 1.0f, 3.5f }, sp = { 2.0f, -3.0f, 2.0f };
+    assert_v3_eq(zmath_m4_transform_point(&tm, p), tp);
+    assert_v3_eq(zmath_m4_transform_point(&sm, p), sp);
+
+    // mul_v4 against the definition, and transform_v4_many against mul_v4.
+    zmat4 m = test_matrix();
+    static zvec4 vin[N], vout[N];
+    for (int i = 0; i < N; i++)
+    {
+        zvec4 v = { rng_float(-5.0f, 5.0f), rng_float(-5.0f, 5.0f), rng_float(-5.0f, 5.0f), rng_float(-1.0f, 1.0f) };
+        vin[i] = v;
+    }
+    for (int i = 0; i < N; i++)
+    {
+        zvec4 v = vin[i], got = zmath_m4_mul_v4(&m, v);
+        zvec4 ref;
+        float *rp = &ref.x;
+        for (int row = 0; row < 4; row++)
+        {
+            rp[row] = m.m[row] * v.x + m.m[4 + row] * v.y + m.m[8 + row] * v.z + m.m[12 + row] * v.w;
+        }
+        assert_v4_near(got, ref, 1e-5f);
+    }
+    zmath_m4_transform_v4_many(&m, vout, vin, N);
+    for (int i = 0; i < N; i++) assert_v4_near(vout[i], zmath_m4_mul_v4(&m, vin[i]), 0.0f);
+
+    // In place.
+    zmath_m4_transform_v4_many(&m, vin, vin, N);
+    assert(0 == memcmp(vin, vout, sizeof(vin)));
+    zmath_m4_transform_v4_many(&m, vout, vin, 0);
+}
+
+int main(void)
+{
+    test_batch();
+    test_v3_streams();
+    test_v4_streams();
+    test_matrices();
+    printf("zmath: ok\n");
+    return 0;
+}
@@ -0,0 +1,25 @@
+/*
+ * The zmath tests again with AVX2 enabled for this file only, which selects the 8-wide batch
+ * and stream kernels. Machines without AVX2 skip it.
+ */
+
+#if defined(__GNUC__) && !defined(__clang__) && (defined(__x86_64__) || defined(__i386__))
+#   pragma GCC target("avx2")
+#   define ZMATH_TEST_AVX2 1
+#endif
+
+#define main zmath_test_main
+#include "test_zmath.c"
+#undef main
+
+int main(void)
+{
+#if defined(ZMATH_TEST_AVX2)
+    if (!__builtin_cpu_supports("avx2"))
+    {
+        printf("zmath (avx2): skipped\n");
+        return 0;
+    }
+#endif
+    return zmath_test_main();
+}
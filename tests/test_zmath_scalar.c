@@ -0,0 +1,6 @@
+/*
+ * The zmath tests again with ZMATH_NO_SIMD, so every kernel takes the scalar fallback.
+ */
+
+#define ZMATH_NO_SIMD
+#include "test_zmath.c"
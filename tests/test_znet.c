@@ -0,0 +1,978 @@
+/*
+ * Behaviour tests for znet.h, over loopback sockets.
+ * Build and run with `make test`; LeakSanitizer checks that destroying a busy loop frees everything.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Small enough to hit from the tests.
+#define ZNET_HTTP_MAX_BODY 4096
+#define ZNET_HTTP_IDLE_MS 200
+#define ZNET_IMPLEMENTATION
+#include "znet.h"
+#define ZTHREAD_IMPLEMENTATION
+#include "zthread.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <time.h>
+
+static void sleep_ms(int ms)
+{
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static uint16_t local_port(znet_socket s)
+{
+    struct sockaddr_in sa;
+    socklen_t len = sizeof(sa);
+    assert(0 == getsockname((int)s.handle, (struct sockaddr *)&sa, &len));
+    return ntohs(sa.sin_port);
+}
+
+// Listener on 127.0.0.1 with a kernel-chosen port.
+static uint16_t listen_local(znet_socket *out)
+{
+    znet_addr addr;
+    assert(znet_addr_from_str("127.0.0.1", 0, &addr));
+    *out = znet_socket_create(ZNET_IPV4, ZNET_TCP);
+    assert(out->valid);
+    assert(Z_OK == znet_bind(*out, addr));
+    assert(Z_OK == znet_listen(*out, 128));
+    return local_port(*out);
+}
+
+// Connected pair: *client dialled, *server accepted.
+static void tcp_pair(znet_socket listener, uint16_t port, znet_socket *client, znet_socket *server)
+{
+    znet_addr addr;
+    assert(znet_addr_from_str("127.0.0.1", port, &addr));
+    *client = znet_socket_create(ZNET_IPV4, ZNET_TCP);
+    assert(client->valid && Z_OK == znet_connect(*client, addr));
+    *server = znet_accept(listener, NULL);
+    assert(server->valid);
+}
+
+// Event loop.
+
+typedef struct
+{
+    int calls;
+    int events;
+    size_t bytes;
+    bool closed;
+    bool remove_self;
+} io_probe;
+
+static void on_io(znet_loop *loop, znet_watch *w, int events, void *user)
+{
+    io_probe *p = (io_probe *)user;
+    p->calls++;
+    p->events |= events;
+    if (events & ZNET_POLL_READ)
+    {
+        // Drains whatever is there, like an edge-triggered handler must.
+        char buf[256];
+        z_ssize_t n;
+        while ((n = znet_recv(znet_watch_socket(w), buf, sizeof(buf))) > 0)
+        {
+            p->bytes += (size_t)n;
+        }
+        if (0 == n)
+        {
+            p->closed = true;
+        }
+    }
+    if (p->remove_self)
+    {
+        znet_loop_remove(loop, w);
+    }
+}
+
+static void test_loop_io(void)
+{
+    znet_socket listener;
+    uint16_t port = listen_local(&listener);
+    znet_socket c, s;
+    tcp_pair(listener, port, &c, &s);
+    assert(Z_OK == znet_set_nonblocking(s, true));
+
+    znet_loop *loop = znet_loop_create();
+    assert(loop);
+    assert(NULL == znet_loop_add(loop, ZNET_INVALID_SOCKET, ZNET_POLL_READ, on_io, NULL));
+
+    // Nothing to read yet: a short poll times out.
+    io_probe p;
+    memset(&p, 0, sizeof(p));
+    znet_watch *w = znet_loop_add(loop, s, ZNET_POLL_READ, on_io, &p);
+    assert(w && s.handle == znet_watch_socket(w).handle);
+    assert(0 == znet_loop_poll(loop, 10));
+    assert(0 == p.calls);
+
+    assert(4 == znet_send(c, "ping", 4));
+    assert(1 == znet_loop_poll(loop, 1000));
+    assert(1 == p.calls && 4 == p.bytes && (p.events & ZNET_POLL_READ));
+
+    // Level-triggered read stays quiet once drained; write readiness fires at once.
+    assert(0 == znet_loop_poll(loop, 10));
+    assert(Z_OK == znet_loop_modify(loop, w, ZNET_POLL_READ | ZNET_POLL_WRITE));
+    assert(1 == znet_loop_poll(loop, 1000));
+    assert(2 == p.calls && (p.events & ZNET_POLL_WRITE));
+    assert(Z_OK == znet_loop_modify(loop, w, ZNET_POLL_READ | ZNET_POLL_EDGE));
+
+    // Edge-triggered: three sends before the poll still make one callback.
+    memset(&p, 0, sizeof(p));
+    for (int i = 0; i < 3; i++)
+    {
+        assert(5 == znet_send(c, "chunk", 5));
+    }
+    sleep_ms(20);
+    assert(1 == znet_loop_poll(loop, 1000));
+    assert(1 == p.calls && 15 == p.bytes);
+    assert(0 == znet_loop_poll(loop, 10));
+
+    // A peer close reads as end of stream; the callback may remove its own watch, which ends run.
+    p.remove_self = true;
+    znet_close(&c);
+    assert(1 == znet_loop_poll(loop, 1000));
+    assert(p.closed);
+    assert(Z_OK == znet_loop_run(loop));
+
+    znet_loop_destroy(loop);
+    znet_close(&s);
+    znet_close(&listener);
+}
+
+typedef struct
+{
+    int order[8];
+    int fired;
+    int ticks;
+    uint64_t first_at;
+    uint64_t last_at;
+} timer_probe;
+
+static timer_probe g_timers;
+
+static void on_timer(znet_loop *loop, znet_timer *t, void *user)
+{
+    (void)t;
+    g_timers.order[g_timers.fired++] = (int)(intptr_t)user;
+    g_timers.last_at = znet_loop_now(loop);
+}
+
+static void on_tick(znet_loop *loop, znet_timer *t, void *user)
+{
+    (void)user;
+    if (0 == g_timers.ticks++)
+    {
+        g_timers.first_at = znet_loop_now(loop);
+    }
+    if (5 == g_timers.ticks)
+    {
+        znet_loop_cancel(loop, t);
+    }
+}
+
+static void on_stop(znet_loop *loop, znet_timer *t, void *user)
+{
+    (void)t;
+    (void)user;
+    znet_loop_stop(loop);
+}
+
+static void test_loop_timers(void)
+{
+    znet_loop *loop = znet_loop_create();
+    assert(loop);
+    memset(&g_timers, 0, sizeof(g_timers));
+    uint64_t start = znet_loop_now(loop);
+
+    // Timers fire in deadline order whatever order they were armed in.
+    assert(znet_loop_timer(loop, 30, 0, on_timer, (void *)3));
+    assert(znet_loop_timer(loop, 10, 0, on_timer, (void *)1));
+    assert(znet_loop_timer(loop, 20, 0, on_timer, (void *)2));
+    znet_timer *never = znet_loop_timer(loop, 15, 0, on_timer, (void *)9);
+    assert(never);
+    znet_loop_cancel(loop, never);
+    assert(znet_loop_timer(loop, 5, 5, on_tick, NULL));
+    assert(Z_OK == znet_loop_run(loop));
+
+    assert(3 == g_timers.fired);
+    assert(1 == g_timers.order[0] && 2 == g_timers.order[1] && 3 == g_timers.order[2]);
+    assert(g_timers.last_at >= start + 30);
+    // The repeating timer cancelled itself from its fifth callback.
+    assert(5 == g_timers.ticks && g_timers.first_at >= start + 5);
+
+    // znet_loop_stop ends run even while timers are still armed.
+    znet_timer *later = znet_loop_timer(loop, 60000, 0, on_timer, (void *)7);
+    assert(later && znet_loop_timer(loop, 1, 0, on_stop, NULL));
+    assert(Z_OK == znet_loop_run(loop));
+    assert(3 == g_timers.fired);
+    znet_loop_cancel(loop, later);
+    znet_loop_destroy(loop);
+}
+
+#define MANY 200
+
+static void test_loop_many(void)
+{
+    znet_socket listener;
+    uint16_t port = listen_local(&listener);
+    znet_loop *loop = znet_loop_create();
+    assert(loop);
+
+    static znet_socket clients[MANY], servers[MANY];
+    static io_probe probes[MANY];
+    memset(probes, 0, sizeof(probes));
+    for (int i = 0; i < MANY; i++)
+    {
+        tcp_pair(listener, port, &clients[i], &servers[i]);
+        assert(Z_OK == znet_set_nonblocking(servers[i], true));
+        probes[i].remove_self = true;
+        int ev = ZNET_POLL_READ | ((i & 1) ? ZNET_POLL_EDGE : 0);
+        assert(znet_loop_add(loop, servers[i], ev, on_io, &probes[i]));
+    }
+    for (int i = MANY - 1; i >= 0; i--)
+    {
+        assert(1 == znet_send(clients[i], "x", 1));
+    }
+    // Every watch removes itself once served, so run returns when all have been.
+    assert(Z_OK == znet_loop_run(loop));
+    for (int i = 0; i < MANY; i++)
+    {
+        assert(1 == probes[i].calls && 1 == probes[i].bytes);
+        znet_close(&clients[i]);
+        znet_close(&servers[i]);
+    }
+    znet_loop_destroy(loop);
+    znet_close(&listener);
+}
+
+// Destroying a loop that still has watches (live and just removed) and timers frees them all.
+static void test_loop_destroy(void)
+{
+    znet_socket listener;
+    uint16_t port = listen_local(&listener);
+    znet_socket c, s;
+    tcp_pair(listener, port, &c, &s);
+
+    znet_loop *loop = znet_loop_create();
+    assert(loop);
+    io_probe p;
+    memset(&p, 0, sizeof(p));
+    assert(znet_loop_add(loop, s, ZNET_POLL_READ, on_io, &p));
+    assert(znet_loop_add(loop, c, ZNET_POLL_WRITE, on_io, &p));
+    znet_watch *gone = znet_loop_add(loop, listener, ZNET_POLL_READ, on_io, &p);
+    assert(gone);
+    znet_loop_remove(loop, gone);
+    znet_loop_remove(loop, gone);
+    for (int i = 0; i < 50; i++)
+    {
+        assert(znet_loop_timer(loop, 1000 + (uint64_t)i, (uint64_t)(i & 1), on_timer, NULL));
+    }
+    znet_loop_destroy(loop);
+    znet_loop_destroy(NULL);
+
+    znet_close(&c);
+    znet_close(&s);
+    znet_close(&listener);
+}
+
+// Completion I/O. The same tests run on io_uring in test_znet_uring.c.
+
+#define BIG (1 << 20)
+
+typedef struct
+{
+    znet_io *listener;
+    const char *expect;
+    size_t len;
+    size_t got;
+    bool mismatch;
+    int sent[2];
+    int sends;
+    int accepted;
+    int conns_closed;
+} echo_state;
+
+static echo_state g_echo;
+
+static void echo_sent(znet_io *io, z_ssize_t sent, void *user)
+{
+    (void)io;
+    assert(sent > 0);
+    free(user);
+}
+
+// Server side: sends back a copy of every chunk, and closes once the peer does.
+static void echo_recv(znet_io *io, const void *data, z_ssize_t len, void *user)
+{
+    (void)user;
+    if (len <= 0)
+    {
+        g_echo.conns_closed++;
+        znet_io_close(io);
+        return;
+    }
+    void *copy = malloc((size_t)len);
+    assert(copy);
+    memcpy(copy, data, (size_t)len);
+    assert(Z_OK == znet_io_send(io, copy, (size_t)len, echo_sent, copy));
+}
+
+static void echo_accept(znet_io *io, znet_socket client, void *user)
+{
+    (void)user;
+    assert(client.valid);
+    g_echo.accepted++;
+    znet_io *conn = znet_io_open(znet_io_loop(io), client);
+    assert(conn);
+    assert(Z_OK == znet_io_recv(conn, echo_recv, NULL));
+}
+
+static void client_sent(znet_io *io, z_ssize_t sent, void *user)
+{
+    (void)io;
+    g_echo.sent[g_echo.sends++] = (int)sent;
+    (void)user;
+}
+
+// Client side: checks the echo byte for byte, then shuts everything down from inside the callback.
+static void client_recv(znet_io *io, const void *data, z_ssize_t len, void *user)
+{
+    (void)user;
+    assert(len > 0);
+    assert(g_echo.got + (size_t)len <= g_echo.len);
+    if (0 != memcmp(g_echo.expect + g_echo.got, data, (size_t)len))
+    {
+        g_echo.mismatch = true;
+    }
+    g_echo.got += (size_t)len;
+    if (g_echo.got == g_echo.len)
+    {
+        znet_io_close(io);
+        znet_io_close(g_echo.listener);
+    }
+}
+
+static void never_sent(znet_io *io, z_ssize_t sent, void *user)
+{
+    (void)io;
+    (void)sent;
+    (void)user;
+    assert(!"send callback ran after znet_io_close");
+}
+
+static void test_io_echo(void)
+{
+    znet_socket listener;
+    uint16_t port = listen_local(&listener);
+    znet_loop *loop = znet_loop_create();
+    assert(loop);
+#   if !defined(ZNET_USE_URING)
+    assert(!znet_loop_uses_uring(loop));
+#   endif
+    assert(NULL == znet_io_open(loop, ZNET_INVALID_SOCKET));
+
+    // One small send, then one past ZNET_ZC_THRESHOLD that goes zero-copy on io_uring.
+    char *payload = (char *)malloc(5 + BIG);
+    assert(payload);
+    memcpy(payload, "hello", 5);
+    for (size_t i = 0; i < BIG; i++)
+    {
+        payload[5 + i] = (char)(i * 131 + (i >> 9));
+    }
+    memset(&g_echo, 0, sizeof(g_echo));
+    g_echo.expect = payload;
+    g_echo.len = 5 + BIG;
+
+    g_echo.listener = znet_io_open(loop, listener);
+    assert(g_echo.listener);
+    assert(Z_OK == znet_io_accept(g_echo.listener, echo_accept, NULL));
+
+    znet_addr addr;
+    assert(znet_addr_from_str("127.0.0.1", port, &addr));
+    znet_socket cs = znet_socket_create(ZNET_IPV4, ZNET_TCP);
+    assert(cs.valid && Z_OK == znet_connect(cs, addr));
+    znet_io *client = znet_io_open(loop, cs);
+    assert(client && znet_io_loop(client) == loop && cs.handle == znet_io_socket(client).handle);
+    assert(Z_OK == znet_io_recv(client, client_recv, NULL));
+    assert(Z_OK == znet_io_send(client, payload, 5, client_sent, NULL));
+    assert(Z_OK == znet_io_send(client, payload + 5, BIG, client_sent, NULL));
+
+    // run returns once the client, the listener and the server connection have all closed.
+    assert(Z_OK == znet_loop_run(loop));
+    assert(g_echo.got == g_echo.len && !g_echo.mismatch);
+    assert(2 == g_echo.sends && 5 == g_echo.sent[0] && BIG == g_echo.sent[1]);
+    assert(1 == g_echo.accepted && 1 == g_echo.conns_closed);
+    znet_loop_destroy(loop);
+    free(payload);
+}
+
+// Closing with operations still queued drops their callbacks and frees everything.
+static void test_io_close(void)
+{
+    znet_socket listener;
+    uint16_t port = listen_local(&listener);
+    znet_socket c, s;
+    tcp_pair(listener, port, &c, &s);
+    znet_close(&listener);
+
+    znet_loop *loop = znet_loop_create();
+    assert(loop);
+    znet_io *io = znet_io_open(loop, c);
+    assert(io);
+    static char big[BIG];
+    assert(Z_OK == znet_io_recv(io, client_recv, NULL));
+    assert(Z_OK == znet_io_send(io, big, sizeof(big), never_sent, NULL));
+    znet_io_close(io);
+    assert(Z_OK == znet_loop_run(loop));
+    znet_loop_destroy(loop);
+    znet_close(&s);
+}
+
+#define DGRAMS 40
+
+static void test_udp_batch(void)
+{
+    znet_addr any;
+    assert(znet_addr_from_str("127.0.0.1", 0, &any));
+    znet_socket rx = znet_socket_create(ZNET_IPV4, ZNET_UDP);
+    znet_socket tx = znet_socket_create(ZNET_IPV4, ZNET_UDP);
+    assert(rx.valid && tx.valid);
+    assert(Z_OK == znet_bind(rx, any) && Z_OK == znet_bind(tx, any));
+    assert(Z_OK == znet_set_timeout(rx, 2000));
+    znet_addr dest;
+    assert(znet_addr_from_str("127.0.0.1", local_port(rx), &dest));
+
+    char out[DGRAMS][16];
+    znet_msg send[DGRAMS];
+    for (int i = 0; i < DGRAMS; i++)
+    {
+        send[i].data = out[i];
+        send[i].len = (size_t)snprintf(out[i], sizeof(out[i]), "dgram-%d", i);
+        send[i].addr = dest;
+    }
+    int sent = 0;
+    while (sent < DGRAMS)
+    {
+        int n = znet_send_batch(tx, send + sent, DGRAMS - sent);
+        assert(n > 0);
+        sent += n;
+    }
+
+    // Loopback keeps order; the batch returns what is queued, at most the slots given.
+    char in[8][64];
+    int got = 0;
+    while (got < DGRAMS)
+    {
+        znet_msg recv[8];
+        for (int i = 0; i < 8; i++)
+        {
+            recv[i].data = in[i];
+            recv[i].len = sizeof(in[i]);
+        }
+        int n = znet_recv_batch(rx, recv, 8);
+        assert(n > 0 && n <= 8);
+        for (int i = 0; i < n; i++, got++)
+        {
+            assert(recv[i].len == send[got].len);
+            assert(0 == memcmp(in[i], out[got], recv[i].len));
+            assert(local_port(tx) == recv[i].addr.port);
+        }
+    }
+    znet_close(&rx);
+    znet_close(&tx);
+}
+
+// HTTP client, against a scripted server thread that answers by path.
+
+#define BIG_BODY 100000
+
+static int32_t g_accepted;
+
+static void send_all(znet_socket s, const char *data, size_t len)
+{
+    while (len > 0)
+    {
+        z_ssize_t n = send((int)s.handle, data, len, MSG_NOSIGNAL);
+        if (n <= 0)
+        {
+            return;     // The client hung up: fine for the abort test.
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+}
+
+static void send_str(znet_socket s, const char *str)
+{
+    send_all(s, str, strlen(str));
+}
+
+enum { KEEP, CLOSE, QUIT };
+
+static int script_reply(znet_socket c, const char *path, const char *body, size_t body_len)
+{
+    char line[128];
+    if (0 == strcmp(path, "/hello"))
+    {
+        send_str(c, "HTTP/1.1 200 OK\r\nContent-Length: 5\r\nX-Served: hello\r\n\r\nhello");
+    }
+    else if (0 == strcmp(path, "/chunked"))
+    {
+        send_str(c, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                    "4\r\nWiki\r\n5;ext=1\r\npedia\r\n0\r\nX-Trailer: t\r\n\r\n");
+    }
+    else if (0 == strcmp(path, "/echo"))
+    {
+        snprintf(line, sizeof(line), "HTTP/1.1 200 OK\r\nContent-Length: %zu\r\n\r\n", body_len);
+        send_str(c, line);
+        send_all(c, body, body_len);
+    }
+    else if (0 == strcmp(path, "/big"))
+    {
+        static char chunk[7000];
+        send_str(c, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n");
+        for (size_t off = 0; off < BIG_BODY; off += sizeof(chunk))
+        {
+            size_t n = BIG_BODY - off < sizeof(chunk) ? BIG_BODY - off : sizeof(chunk);
+            for (size_t i = 0; i < n; i++)
+            {
+                chunk[i] = (char)('a' + (off + i) % 26);
+            }
+            snprintf(line, sizeof(line), "%zx\r\n", n);
+            send_str(c, line);
+            send_all(c, chunk, n);
+            send_str(c, "\r\n");
+        }
+        send_str(c, "0\r\n\r\n");
+    }
+    else if (0 == strcmp(path, "/close") || 0 == strcmp(path, "/quit"))
+    {
+        send_str(c, "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 2\r\n\r\nok");
+        return ('q' == path[1]) ? QUIT : CLOSE;
+    }
+    else if (0 == strcmp(path, "/drop"))
+    {
+        // Promises keep-alive, then hangs up anyway.
+        send_str(c, "HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\ndrop");
+        return CLOSE;
+    }
+    else if (0 == strcmp(path, "/eof"))
+    {
+        send_str(c, "HTTP/1.0 200 OK\r\n\r\nuntil-eof");
+        return CLOSE;
+    }
+    else
+    {
+        send_str(c, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+    }
+    return KEEP;
+}
+
+// Serves one connection at a time, several requests per read when the client pipelines.
+static void script_server(void *arg)
+{
+    znet_socket listener = *(znet_socket *)arg;
+    static char buf[65536];
+    for (;;)
+    {
+        znet_socket c = znet_accept(listener, NULL);
+        assert(c.valid);
+        zatomic_fetch_add_i32(&g_accepted, 1, ZATOMIC_SEQ_CST);
+        size_t len = 0;
+        int state = KEEP;
+        while (KEEP == state)
+        {
+            buf[len] = '\0';
+            char *blank = strstr(buf, "\r\n\r\n");
+            size_t head = blank ? (size_t)(blank + 4 - buf) : 0;
+            const char *cl = blank ? strstr(buf, "Content-Length: ") : NULL;
+            size_t body_len = (cl && cl < blank) ? (size_t)strtoul(cl + 16, NULL, 10) : 0;
+            if (!blank || len < head + body_len)
+            {
+                z_ssize_t n = znet_recv(c, buf + len, sizeof(buf) - 1 - len);
+                if (n <= 0)
+                {
+                    break;
+                }
+                len += (size_t)n;
+                continue;
+            }
+            char path[64];
+            const char *sp = strchr(buf, ' ');
+            size_t plen = (size_t)(strchr(sp + 1, ' ') - (sp + 1));
+            assert(plen < sizeof(path));
+            memcpy(path, sp + 1, plen);
+            path[plen] = '\0';
+            state = script_reply(c, path, buf + head, body_len);
+            memmove(buf, buf + head + body_len, len - head - body_len);
+            len -= head + body_len;
+        }
+        znet_close(&c);
+        if (QUIT == state)
+        {
+            return;
+        }
+    }
+}
+
+static int32_t accepted(void)
+{
+    return zatomic_load_i32(&g_accepted, ZATOMIC_SEQ_CST);
+}
+
+typedef struct
+{
+    size_t bytes;
+    bool ordered;
+    size_t abort_after;
+} body_probe;
+
+static int on_body(const znet_http_response *res, const char *data, size_t len, void *user)
+{
+    body_probe *b = (body_probe *)user;
+    assert(200 == res->status && res->chunked);
+    for (size_t i = 0; i < len; i++)
+    {
+        b->ordered = b->ordered && data[i] == (char)('a' + (b->bytes + i) % 26);
+    }
+    b->bytes += len;
+    return (b->abort_after && b->bytes >= b->abort_after) ? 1 : 0;
+}
+
+static void test_http_parse(void)
+{
+    znet_http_response r;
+    const char *partial = "HTTP/1.1 200 OK\r\nContent-Le";
+    assert(0 == znet_http_parse_response(partial, strlen(partial), &r));
+
+    const char *ok = "HTTP/1.1 200 OK\r\nContent-Length: 3\r\nconnection: close\r\n\r\nabc";
+    assert((z_ssize_t)strlen(ok) - 3 == znet_http_parse_response(ok, strlen(ok), &r));
+    assert(200 == r.status && 11 == r.version && zstr_view_eq(r.reason, "OK"));
+    assert(3 == r.content_length && !r.chunked && !r.keep_alive && 2 == r.header_count);
+    // The views point into the buffer, and lookups ignore case.
+    zstr_view v = znet_http_header_get(r.headers, r.header_count, "CONTENT-LENGTH");
+    assert(zstr_view_eq(v, "3") && v.data > ok && v.data < ok + strlen(ok));
+    assert(0 == znet_http_header_get(r.headers, r.header_count, "x-missing").len);
+
+    const char *old = "HTTP/1.0 404 Not Found\r\nConnection: keep-alive\r\nContent-Length: 5, 5\r\n\r\n";
+    assert(znet_http_parse_response(old, strlen(old), &r) > 0);
+    assert(404 == r.status && 10 == r.version && r.keep_alive && 5 == r.content_length);
+    assert(zstr_view_eq(r.reason, "Not Found"));
+
+    const char *te = "HTTP/1.1 200 OK\r\nTransfer-Encoding: gzip, chunked\r\n\r\n";
+    assert(znet_http_parse_response(te, strlen(te), &r) > 0);
+    assert(r.chunked && -1 == r.content_length && r.keep_alive);
+
+    const char *bad[] = {
+        "HTP/1.1 200 OK\r\n\r\n",
+        "HTTP/1.1 2x0 OK\r\n\r\n",
+        "HTTP/1.1 200 OK\r\nno colon here\r\n\r\n",
+        "HTTP/1.1 200 OK\r\nContent-Length: 5\r\nContent-Length: 6\r\n\r\n",
+        "HTTP/1.1 200 OK\r\nContent-Length: -1\r\n\r\n",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+    {
+        assert(-1 == znet_http_parse_response(bad[i], strlen(bad[i]), &r));
+    }
+}
+
+static void test_http_client(void)
+{
+    znet_socket listener;
+    uint16_t port = listen_local(&listener);
+    zthread_t server;
+    assert(Z_OK == zthread_create(&server, script_server, &listener));
+
+    znet_http_client *c = znet_http_client_create(5000);
+    assert(c);
+    znet_http_response res;
+
+    // Keep-alive: both requests ride one connection.
+    znet_http_request hello = { .path = "/hello" };
+    for (int i = 0; i < 2; i++)
+    {
+        assert(Z_OK == znet_http_send(c, "127.0.0.1", port, &hello, &res));
+        assert(200 == res.status && 11 == res.version && res.keep_alive && 5 == res.content_length);
+        assert(zstr_view_eq(res.body, "hello"));
+        assert(zstr_view_eq(znet_http_header_get(res.headers, res.header_count, "x-served"), "hello"));
+    }
+    assert(1 == accepted());
+
+    // Chunked, with an extension and a trailer; the connection stays usable afterwards.
+    znet_http_request chunked = { .path = "/chunked" };
+    assert(Z_OK == znet_http_send(c, "127.0.0.1", port, &chunked, &res));
+    assert(res.chunked && -1 == res.content_length && zstr_view_eq(res.body, "Wikipedia"));
+    znet_http_request echo = { .method = "POST", .path = "/echo", .headers = "X-Test: 1\r\n",
+                               .body = "payload=1", .body_len = 9 };
+    assert(Z_OK == znet_http_send(c, "127.0.0.1", port, &echo, &res));
+    assert(200 == res.status && zstr_view_eq(res.body, "payload=1"));
+    assert(1 == accepted());
+
+    // Streaming: the callback sees every byte across chunk and buffer boundaries.
+    body_probe b = { 0, true, 0 };
+    znet_http_request big = { .path = "/big", .on_body = on_body, .user = &b };
+    assert(Z_OK == znet_http_send(c, "127.0.0.1", port, &big, &res));
+    assert(BIG_BODY == b.bytes && b.ordered && 0 == res.body.len);
+    assert(1 == accepted());
+
+    // Aborting from the callback fails the call and drops the connection.
+    b = (body_probe){ 0, true, 10000 };
+    assert(Z_ERR == znet_http_send(c, "127.0.0.1", port, &big, &res));
+    assert(Z_OK == znet_http_send(c, "127.0.0.1", port, &hello, &res));
+    assert(zstr_view_eq(res.body, "hello") && 2 == accepted());
+
+    // A pooled connection the server closed silently is retried once on a fresh one.
+    znet_http_request drop = { .path = "/drop" };
+    assert(Z_OK == znet_http_send(c, "127.0.0.1", port, &drop, &res));
+    assert(zstr_view_eq(res.body, "drop") && res.keep_alive);
+    assert(Z_OK == znet_http_send(c, "127.0.0.1", port, &hello, &res));
+    assert(zstr_view_eq(res.body, "hello") && 3 == accepted());
+
+    // Connection: close and a close-delimited HTTP/1.0 body end the connection.
+    znet_http_request closing = { .path = "/close" };
+    assert(Z_OK == znet_http_send(c, "127.0.0.1", port, &closing, &res));
+    assert(!res.keep_alive && zstr_view_eq(res.body, "ok"));
+    znet_http_request eof = { .path = "/eof" };
+    assert(Z_OK == znet_http_send(c, "127.0.0.1", port, &eof, &res));
+    assert(10 == res.version && !res.keep_alive && zstr_view_eq(res.body, "until-eof"));
+    assert(4 == accepted());
+
+    // Pipelining: every request goes out on one connection, answers come back in order.
+    znet_http_request reqs[] = { hello, chunked, echo, { .path = "/missing" }, hello };
+    znet_http_response outs[5];
+    assert(Z_OK == znet_http_pipeline(c, "127.0.0.1", port, reqs, outs, 5));
+    assert(zstr_view_eq(outs[0].body, "hello") && zstr_view_eq(outs[1].body, "Wikipedia"));
+    assert(zstr_view_eq(outs[2].body, "payload=1") && 404 == outs[3].status);
+    assert(zstr_view_eq(outs[4].body, "hello") && 5 == accepted());
+
+    znet_http_request quit = { .path = "/quit" };
+    assert(Z_OK == znet_http_send(c, "127.0.0.1", port, &quit, &res));
+    zthread_join(server);
+    znet_close(&listener);
+
+    // Nothing listens there any more.
+    assert(Z_ERR == znet_http_send(c, "127.0.0.1", port, &hello, &res));
+    znet_http_client_destroy(c);
+}
+
+// HTTP server, run on a loop in its own thread; the client above talks to it.
+
+typedef struct
+{
+    znet_socket listener;
+    FILE *file;
+    znet_loop *loop;
+    znet_http_conn *later;
+    int requests;
+    int peers;
+    uint16_t last_peer;
+} serve_state;
+
+static void answer_later(znet_loop *loop, znet_timer *t, void *user)
+{
+    (void)loop;
+    (void)t;
+    serve_state *st = (serve_state *)user;
+    znet_http_conn *conn = st->later;
+    st->later = NULL;
+    assert(Z_OK == znet_http_respond(conn, 200, NULL, "later", 5));
+}
+
+static void serve(znet_http_conn *conn, const znet_http_incoming *req, void *user)
+{
+    serve_state *st = (serve_state *)user;
+    st->requests++;
+    uint16_t peer = znet_http_conn_peer(conn).port;
+    if (peer != st->last_peer)
+    {
+        st->peers++;
+        st->last_peer = peer;
+    }
+    if (zstr_view_eq(req->path, "/hello"))
+    {
+        znet_http_respond(conn, 200, "X-Handler: hello\r\n", "hello", 5);
+    }
+    else if (zstr_view_eq(req->path, "/echo"))
+    {
+        assert(zstr_view_eq(req->method, "POST") && 11 == req->version);
+        assert(zstr_view_eq(znet_http_header_get(req->headers, req->header_count, "x-test"), "1"));
+        assert((int64_t)req->body.len == req->content_length);
+        znet_http_respond(conn, 200, NULL, req->body.data, req->body.len);
+    }
+    else if (zstr_view_eq(req->path, "/query"))
+    {
+        znet_http_respond(conn, 200, NULL, req->query.data, req->query.len);
+    }
+    else if (zstr_view_eq(req->path, "/file"))
+    {
+        znet_http_respond_file(conn, 200, NULL, fileno(st->file), 3, 1000);
+    }
+    else if (zstr_view_eq(req->path, "/later"))
+    {
+        // Answered from a timer; the next pipelined request waits its turn.
+        st->later = conn;
+        assert(znet_loop_timer(st->loop, 20, 0, answer_later, st));
+    }
+    else if (zstr_view_eq(req->path, "/stop"))
+    {
+        znet_http_respond(conn, 200, NULL, "bye", 3);
+        znet_loop_stop(st->loop);
+    }
+    else
+    {
+        znet_http_respond(conn, 404, NULL, NULL, 0);
+    }
+}
+
+static void serve_thread(void *arg)
+{
+    serve_state *st = (serve_state *)arg;
+    st->loop = znet_loop_create();
+    assert(st->loop);
+    znet_http_server *srv = znet_http_server_create(st->loop, st->listener, serve, st);
+    assert(srv);
+    assert(Z_OK == znet_loop_run(st->loop));
+    znet_http_server_destroy(srv);
+    znet_loop_destroy(st->loop);
+}
+
+// Raw request on a fresh connection; returns what came back up to the server's close.
+static size_t raw_exchange(uint16_t port, const char *request, char *out, size_t cap)
+{
+    znet_addr addr;
+    assert(znet_addr_from_str("127.0.0.1", port, &addr));
+    znet_socket s = znet_socket_create(ZNET_IPV4, ZNET_TCP);
+    assert(s.valid && Z_OK == znet_connect(s, addr));
+    assert(Z_OK == znet_set_timeout(s, 5000));
+    send_str(s, request);
+    size_t len = 0;
+    z_ssize_t n;
+    while (len + 1 < cap && (n = znet_recv(s, out + len, cap - 1 - len)) > 0)
+    {
+        len += (size_t)n;
+    }
+    assert(0 == n);     // Closed by the server, not timed out.
+    out[len] = '\0';
+    znet_close(&s);
+    return len;
+}
+
+static void test_http_server(void)
+{
+    serve_state st;
+    memset(&st, 0, sizeof(st));
+    uint16_t port = listen_local(&st.listener);
+    st.file = tmpfile();
+    assert(st.file);
+    static char content[2000];
+    for (size_t i = 0; i < sizeof(content); i++)
+    {
+        content[i] = (char)('A' + i % 23);
+    }
+    assert(sizeof(content) == fwrite(content, 1, sizeof(content), st.file));
+    fflush(st.file);
+    zthread_t thread;
+    assert(Z_OK == zthread_create(&thread, serve_thread, &st));
+
+    znet_http_client *c = znet_http_client_create(5000);
+    assert(c);
+    znet_http_response res;
+    znet_http_request hello = { .path = "/hello" };
+    for (int i = 0; i < 2; i++)
+    {
+        assert(Z_OK == znet_http_send(c, "127.0.0.1", port, &hello, &res));
+        assert(200 == res.status && res.keep_alive && zstr_view_eq(res.body, "hello"));
+        assert(zstr_view_eq(znet_http_header_get(res.headers, res.header_count, "x-handler"), "hello"));
+    }
+    znet_http_request head = { .method = "HEAD", .path = "/hello" };
+    assert(Z_OK == znet_http_send(c, "127.0.0.1", port, &head, &res));
+    assert(200 == res.status && 5 == res.content_length && 0 == res.body.len);
+
+    static char body[ZNET_HTTP_MAX_BODY + 1000];
+    for (size_t i = 0; i < sizeof(body); i++)
+    {
+        body[i] = (char)(i * 7);
+    }
+    znet_http_request echo = { .method = "POST", .path = "/echo", .headers = "X-Test: 1\r\n",
+                               .body = body, .body_len = 3000 };
+    assert(Z_OK == znet_http_send(c, "127.0.0.1", port, &echo, &res));
+    assert(3000 == res.body.len && 0 == memcmp(res.body.data, body, 3000));
+
+    znet_http_request query = { .path = "/query?a=1&b=two" };
+    assert(Z_OK == znet_http_send(c, "127.0.0.1", port, &query, &res));
+    assert(zstr_view_eq(res.body, "a=1&b=two"));
+
+    znet_http_request file = { .path = "/file" };
+    assert(Z_OK == znet_http_send(c, "127.0.0.1", port, &file, &res));
+    assert(1000 == res.body.len && 0 == memcmp(res.body.data, content + 3, 1000));
+
+    // Pipelined behind a deferred answer: responses still come back in request order.
+    znet_http_request reqs[] = { { .path = "/later" }, hello, { .path = "/query?x" }, { .path = "/nope" } };
+    znet_http_response outs[4];
+    assert(Z_OK == znet_http_pipeline(c, "127.0.0.1", port, reqs, outs, 4));
+    assert(zstr_view_eq(outs[0].body, "later") && zstr_view_eq(outs[1].body, "hello"));
+    assert(zstr_view_eq(outs[2].body, "x") && 404 == outs[3].status);
+
+    // Too large a body is refused, and that connection closed.
+    echo.body_len = sizeof(body);
+    assert(Z_OK == znet_http_send(c, "127.0.0.1", port, &echo, &res));
+    assert(413 == res.status && !res.keep_alive);
+
+    char raw[1024];
+    raw_exchange(port, "GET /hello HTTP/1.0\r\n\r\n", raw, sizeof(raw));
+    assert(strstr(raw, "HTTP/1.1 200 OK\r\n") == raw && strstr(raw, "Connection: close\r\n"));
+    assert(strstr(raw, "\r\n\r\nhello"));
+    raw_exchange(port, "GET /hello HTTP/1.1\nHost: x\n\n", raw, sizeof(raw));
+    assert(strstr(raw, "HTTP/1.1 400 ") == raw);
+    raw_exchange(port, "POST /echo HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n0\r\n\r\n", raw, sizeof(raw));
+    assert(strstr(raw, "HTTP/1.1 501 ") == raw);
+    raw_exchange(port, "POST /echo HTTP/1.1\r\nContent-Length: 3\r\nTransfer-Encoding: chunked\r\n\r\n", 
+                 raw, sizeof(raw));
+    assert(strstr(raw, "HTTP/1.1 400 ") == raw);
+    // A silent connection is closed after ZNET_HTTP_IDLE_MS.
+    assert(0 == raw_exchange(port, "", raw, sizeof(raw)));
+
+    // The pooled connection idled out too: the client notices and reconnects.
+    assert(Z_OK == znet_http_send(c, "127.0.0.1", port, &hello, &res));
+    sleep_ms(2 * ZNET_HTTP_IDLE_MS);
+    assert(Z_OK == znet_http_send(c, "127.0.0.1", port, &hello, &res));
+    assert(zstr_view_eq(res.body, "hello"));
+
+    znet_http_request stop = { .path = "/stop" };
+    assert(Z_OK == znet_http_send(c, "127.0.0.1", port, &stop, &res));
+    assert(zstr_view_eq(res.body, "bye"));
+    zthread_join(thread);
+    znet_http_client_destroy(c);
+    fclose(st.file);
+
+    // Rejected and raw requests never reach the handler.
+    assert(14 == st.requests && NULL == st.later);
+    assert(st.peers >= 3);
+}
+
+int main(void)
+{
+    assert(Z_OK == znet_init());
+    test_loop_io();
+    test_loop_timers();
+    test_loop_many();
+    test_loop_destroy();
+    test_io_echo();
+    test_io_close();
+    test_udp_batch();
+    test_http_parse();
+    test_http_client();
+    test_http_server();
+    znet_term();
+    printf("znet: ok\n");
+    return 0;
+}
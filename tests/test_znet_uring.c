@@ -0,0 +1,7 @@
+/*
+ * The znet.h tests with ZNET_USE_URING: znet_io runs on io_uring where the kernel allows it,
+ * and on the readiness loop otherwise. Build and run with `make test`.
+ */
+
+#define ZNET_USE_URING
+#include "test_znet.c"
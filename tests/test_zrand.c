@@ -0,0 +1,302 @@
+/*
+ * Behaviour tests for zrand.h: bulk fills against the serial calls, jump-ahead and stream
+ * splitting, and the ziggurat sampler's distribution.
+ * Build and run with `make test`.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ZRAND_IMPLEMENTATION
+#include "zrand.h"
+
+static int same_state(const zrand_rng *a, const zrand_rng *b)
+{
+    return a->state == b->state && a->inc == b->inc;
+}
+
+// Lengths around the lane count, the scratch block and their multiples.
+static const size_t LENGTHS[] = { 0, 1, 2, 7, 8, 15, 16, 17, 31, 32, 33, 47, 63, 64, 65, 100,
+                                  255, 256, 257, 511, 513, 1000, 4099 };
+#define NLENGTHS (sizeof(LENGTHS) / sizeof(LENGTHS[0]))
+#define MAXLEN 4099
+
+static void test_known_answer(void)
+{
+    // The PCG reference demo: pcg32_srandom_r(&rng, 42, 54).
+    static const uint32_t want[6] = { 0xa15c02b7, 0x7b47f409, 0xba1d3330, 0x83d2f293, 0xbfa4784b, 0xcbed606e };
+    zrand_rng r;
+    zrand_rng_init(&r, 42, 54);
+    for (int i = 0; i < 6; i++) assert(want[i] == zrand_rng_u32(&r));
+
+    // u64 is the high half first.
+    zrand_rng a, b;
+    zrand_rng_init(&a, 42, 54);
+    zrand_rng_init(&b, 42, 54);
+    uint64_t hi = zrand_rng_u32(&b);
+    uint64_t lo = zrand_rng_u32(&b);
+    assert(((hi << 32) | lo) == zrand_rng_u64(&a));
+}
+
+static void test_fills(void)
+{
+    static uint32_t u32[MAXLEN], s32[MAXLEN];
+    static uint64_t u64[MAXLEN];
+    static float f32[MAXLEN];
+    static double f64[MAXLEN];
+    static uint8_t bytes[MAXLEN + 8], sbytes[MAXLEN + 8];
+
+    for (size_t t = 0; t < NLENGTHS; t++)
+    {
+        size_t n = LENGTHS[t];
+        for (uint64_t seed = 1; seed <= 3; seed++)
+        {
+            zrand_rng fill, serial;
+            zrand_rng_init(&fill, seed * 0x9E3779B97F4A7C15ULL, seed + n);
+            serial = fill;
+
+            // Each fill matches the serial calls and leaves the same state.
+            zrand_rng_fill_u32(&fill, u32, n);
+            for (size_t i = 0; i < n; i++) assert(u32[i] == zrand_rng_u32(&serial));
+            assert(same_state(&fill, &serial));
+
+            zrand_rng_fill_u64(&fill, u64, n);
+            for (size_t i = 0; i < n; i++) assert(u64[i] == zrand_rng_u64(&serial));
+            assert(same_state(&fill, &serial));
+
+            zrand_rng_fill_f32(&fill, f32, n);
+            for (size_t i = 0; i < n; i++)
+            {
+                float want = (zrand_rng_u32(&serial) >> 8) * (1.0f / 16777216.0f);
+                assert(f32[i] == want && f32[i] >= 0.0f && f32[i] < 1.0f);
+            }
+            assert(same_state(&fill, &serial));
+
+            zrand_rng_fill_f64(&fill, f64, n);
+            for (size_t i = 0; i < n; i++)
+            {
+                assert(f64[i] == zrand_rng_f64(&serial));
+                assert(f64[i] >= 0.0 && f64[i] < 1.0);
+            }
+            assert(same_state(&fill, &serial));
+
+            // Bytes are whole draws in memory order; a ragged end still consumes one draw.
+            memset(bytes, 0xAA, sizeof(bytes));
+            memset(sbytes, 0xAA, sizeof(sbytes));
+            zrand_rng_fill_bytes(&fill, bytes, n);
+            for (size_t i = 0; i < n; i += 4)
+            {
+                uint32_t w = zrand_rng_u32(&serial);
+                memcpy(sbytes + i, &w, (n - i < 4) ? n - i : 4);
+            }
+            assert(0 == memcmp(bytes, sbytes, sizeof(bytes)));
+            assert(same_state(&fill, &serial));
+
+            // A fill that starts mid-stream still lines up.
+            (void)zrand_rng_u32(&fill);
+            (void)zrand_rng_u32(&serial);
+            zrand_rng_fill_u32(&fill, s32, n);
+            for (size_t i = 0; i < n; i++) assert(s32[i] == zrand_rng_u32(&serial));
+            assert(same_state(&fill, &serial));
+        }
+    }
+}
+
+static void test_fill_gaussian(void)
+{
+    static double out[20000];
+    static const size_t lens[] = { 0, 1, 5, 64, 255, 256, 257, 1000, 20000 };
+    for (size_t t = 0; t < sizeof(lens) / sizeof(lens[0]); t++)
+    {
+        size_t n = lens[t];
+        zrand_rng fill, serial;
+        zrand_rng_init(&fill, 1234 + n, 7);
+        serial = fill;
+        zrand_rng_fill_gaussian(&fill, out, n, 2.5, 0.5);
+        for (size_t i = 0; i < n; i++) assert(out[i] == zrand_rng_normal(&serial, 2.5, 0.5));
+        // Unread draws were handed back.
+        assert(same_state(&fill, &serial));
+        assert(zrand_rng_u32(&fill) == zrand_rng_u32(&serial));
+    }
+}
+
+static void test_advance(void)
+{
+    zrand_rng a, b;
+    zrand_rng_init(&a, 99, 3);
+    b = a;
+
+    zrand_rng_advance(&a, 0);
+    assert(same_state(&a, &b));
+
+    // Advancing k equals k calls.
+    for (uint64_t k = 1; k <= 1000; k += 37)
+    {
+        zrand_rng jumped = b;
+        zrand_rng_advance(&jumped, k);
+        for (uint64_t i = 0; i < k; i++) (void)zrand_rng_u32(&b);
+        assert(same_state(&jumped, &b));
+    }
+
+    // Stepping back returns to the earlier state, and the values repeat.
+    zrand_rng start = b;
+    uint32_t first[10];
+    for (int i = 0; i < 10; i++) first[i] = zrand_rng_u32(&b);
+    zrand_rng_advance(&b, (uint64_t)0 - 10);
+    assert(same_state(&b, &start));
+    for (int i = 0; i < 10; i++) assert(first[i] == zrand_rng_u32(&b));
+
+    // Jumps compose, including across the full period.
+    zrand_rng x = start, y = start;
+    zrand_rng_advance(&x, 0x123456789ABCDEFULL);
+    zrand_rng_advance(&x, 0xFEDCBA987654321ULL);
+    zrand_rng_advance(&y, 0x123456789ABCDEFULL + 0xFEDCBA987654321ULL);
+    assert(same_state(&x, &y));
+    zrand_rng_advance(&x, (uint64_t)1 << 63);
+    zrand_rng_advance(&x, (uint64_t)1 << 63);
+    assert(same_state(&x, &y));
+}
+
+static void test_split(void)
+{
+    zrand_rng parent;
+    zrand_rng_init(&parent, 2024, 11);
+    zrand_rng before = parent;
+
+    enum { STREAMS = 64 };
+    uint32_t heads[STREAMS];
+    for (uint64_t s = 0; s < STREAMS; s++)
+    {
+        zrand_rng c1, c2;
+        zrand_rng_split(&c1, &parent, s);
+        zrand_rng_split(&c2, &parent, s);
+        // Reproducible, odd increment, and the parent is left alone.
+        assert(same_state(&c1, &c2));
+        assert(1 == (c1.inc & 1));
+        assert(same_state(&parent, &before));
+        assert(c1.inc != parent.inc);
+        heads[s] = zrand_rng_u32(&c1);
+    }
+    for (int i = 0; i < STREAMS; i++)
+    {
+        for (int j = i + 1; j < STREAMS; j++) assert(heads[i] != heads[j]);
+    }
+
+    // Different parents give different children for the same index.
+    zrand_rng other = parent, c1, c2;
+    (void)zrand_rng_u32(&other);
+    zrand_rng_split(&c1, &parent, 5);
+    zrand_rng_split(&c2, &other, 5);
+    assert(!same_state(&c1, &c2));
+}
+
+static void test_normal_distribution(void)
+{
+    enum { SAMPLES = 400000 };
+    static double out[SAMPLES];
+    zrand_rng r;
+    zrand_rng_init(&r, 77, 1);
+    zrand_rng_fill_gaussian(&r, out, SAMPLES, 0.0, 1.0);
+
+    double sum = 0.0, sq = 0.0, quad = 0.0;
+    long within1 = 0, tail = 0, positive = 0;
+    for (int i = 0; i < SAMPLES; i++)
+    {
+        double x = out[i];
+        sum += x;
+        sq += x * x;
+        quad += x * x * x * x;
+        double ax = x < 0 ? -x : x;
+        if (ax < 1.0) within1++;
+        if (ax > ZRAND_ZIG_R) tail++;
+        if (x > 0) positive++;
+    }
+    double mean = sum / SAMPLES, var = sq / SAMPLES - mean * mean, kurt = quad / SAMPLES;
+    assert(mean > -0.01 && mean < 0.01);
+    assert(var > 0.99 && var < 1.01);
+    assert(kurt > 2.9 && kurt < 3.1);
+    // P(|x| < 1) = 0.6827, P(|x| > R) = 5.7e-4 (about 230 samples).
+    assert(within1 > (long)(0.678 * SAMPLES) && within1 < (long)(0.688 * SAMPLES));
+    assert(tail > 150 && tail < 330);
+    assert(positive > SAMPLES / 2 - 2000 && positive < SAMPLES / 2 + 2000);
+
+    // P(0 <= x < e) against the normal CDF for e = 0.5 .. 3.
+    static const double cdf_edges[] = { 0.5, 0.19146, 1.0, 0.34134, 1.5, 0.43319, 2.0, 0.47725,
+                                        2.5, 0.49379, 3.0, 0.49865 };
+    for (int e = 0; e < 6; e++)
+    {
+        long below = 0;
+        for (int i = 0; i < SAMPLES; i++) below += (out[i] >= 0 && out[i] < cdf_edges[2 * e]);
+        double p = (double)below / SAMPLES;
+        assert(p > cdf_edges[2 * e + 1] - 0.004 && p < cdf_edges[2 * e + 1] + 0.004);
+    }
+
+    // Mean and stddev are applied as an affine map.
+    zrand_rng a, b;
+    zrand_rng_init(&a, 5, 5);
+    b = a;
+    for (int i = 0; i < 100; i++)
+    {
+        double x = zrand_rng_normal(&a, 0.0, 1.0);
+        double y = zrand_rng_normal(&b, 10.0, 3.0);
+        assert(y == 10.0 + 3.0 * x);
+    }
+
+    // The polar method is still there and still normal.
+    sum = sq = 0.0;
+    for (int i = 0; i < 100000; i++)
+    {
+        double x = zrand_rng_gaussian(&r, 0.0, 1.0);
+        sum += x;
+        sq += x * x;
+    }
+    assert(sum / 100000 > -0.02 && sum / 100000 < 0.02);
+    assert(sq / 100000 > 0.98 && sq / 100000 < 1.02);
+}
+
+static void test_global(void)
+{
+    uint32_t u[100];
+    float f[100];
+    double g[1000];
+    zrand_fill_u32(u, 100);
+    zrand_fill_f32(f, 100);
+    zrand_fill_gaussian(g, 1000, 1.0, 0.0);
+    int distinct = 0;
+    for (int i = 1; i < 100; i++)
+    {
+        distinct += u[i] != u[0];
+        assert(f[i] >= 0.0f && f[i] < 1.0f);
+    }
+    assert(distinct > 90);
+    for (int i = 0; i < 1000; i++) assert(1.0 == g[i]);
+
+    // A UUID v4, properly formatted.
+    char id[37];
+    zrand_uuid(id);
+    assert(36 == strlen(id));
+    assert('-' == id[8] && '-' == id[13] && '-' == id[18] && '-' == id[23]);
+    assert('4' == id[14]);
+    assert(strchr("89ab", id[19]));
+
+    uint8_t buf[13];
+    memset(buf, 0, sizeof(buf));
+    zrand_bytes(buf, sizeof(buf));
+    (void)zrand_normal(0.0, 1.0);
+}
+
+int main(void)
+{
+    test_known_answer();
+    test_fills();
+    test_fill_gaussian();
+    test_advance();
+    test_split();
+    test_normal_distribution();
+    test_global();
+    printf("zrand: ok\n");
+    return 0;
+}
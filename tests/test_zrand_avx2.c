@@ -0,0 +1,25 @@
+/*
+ * The zrand tests again with AVX2 enabled for this file only, which selects the 16-lane
+ * vector fill. Machines without AVX2 skip it.
+ */
+
+#if defined(__GNUC__) && !defined(__clang__) && (defined(__x86_64__) || defined(__i386__))
+#   pragma GCC target("avx2")
+#   define ZRAND_TEST_AVX2 1
+#endif
+
+#define main zrand_test_main
+#include "test_zrand.c"
+#undef main
+
+int main(void)
+{
+#if defined(ZRAND_TEST_AVX2)
+    if (!__builtin_cpu_supports("avx2"))
+    {
+        printf("zrand (avx2): skipped\n");
+        return 0;
+    }
+#endif
+    return zrand_test_main();
+}
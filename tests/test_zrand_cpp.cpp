@@ -0,0 +1,55 @@
+/*
+ * Behaviour tests for the zrand.h C++ generator.
+ * Build and run with `make test`.
+ */
+
+#include <cassert>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#define ZRAND_IMPLEMENTATION
+#include "zrand.h"
+
+// Fills, advance and split on z_rand::generator match the serial calls.
+static void test_generator()
+{
+    z_rand::generator a(42, 54), b(42, 54);
+    std::vector<uint32_t> u(1000);
+    a.fill(u.data(), u.size());
+    for (uint32_t v : u) assert(v == b.u32());
+
+    std::vector<double> g(500);
+    a.fill_gaussian(g.data(), g.size(), 0.0, 1.0);
+    for (double v : g) assert(v == b.normal(0.0, 1.0));
+    assert(a.u64() == b.u64());
+
+    a.advance(12345);
+    for (int i = 0; i < 12345; i++) (void)b.u32();
+    assert(a.u32() == b.u32());
+    a.advance((uint64_t)0 - 1);
+    b.advance((uint64_t)0 - 1);
+    assert(a.u32() == b.u32());
+
+    // Children are reproducible and leave the parent alone.
+    z_rand::generator c1 = a.split(3), c2 = a.split(3), c3 = a.split(4);
+    uint32_t h1 = c1.u32();
+    assert(h1 == c2.u32());
+    assert(h1 != c3.u32());
+    assert(a.u32() == b.u32());
+
+    // Usable as a standard URBG.
+    std::uniform_int_distribution<int> dist(1, 6);
+    for (int i = 0; i < 1000; i++)
+    {
+        int d = dist(a);
+        assert(d >= 1 && d <= 6);
+    }
+}
+
+int main()
+{
+    test_generator();
+    std::printf("zrand_cpp: ok\n");
+    return 0;
+}
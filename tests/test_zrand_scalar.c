@@ -0,0 +1,6 @@
+/*
+ * The zrand tests again with ZRAND_NO_SIMD, so bulk fills run on the scalar lanes.
+ */
+
+#define ZRAND_NO_SIMD
+#include "test_zrand.c"
@@ -0,0 +1,583 @@
+/*
+ * Behaviour tests for zstr.h: the search, replace, split and UTF-8 kernels against byte-at-a-time
+ * references, on random input that crosses the 16- and 64-byte block edges; then the chunked
+ * builder and the intern pool.
+ * test_zstr_scalar.c runs them again with ZSTR_NO_SIMD, test_zstr_avx2.c with AVX2 enabled (which
+ * also brings in the table-driven UTF-8 validator). Build and run with `make test`.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "zstr.h"
+
+static uint32_t rng_state = 2463534242u;
+
+static uint32_t rng_next(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// Random bytes from pool; a small alphabet makes partial matches and near misses common.
+static void random_text(char *out, size_t len, const char *pool, size_t pool_len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        out[i] = pool[rng_next() % pool_len];
+    }
+}
+
+static ptrdiff_t ref_find(const char *hay, size_t len, const char *needle, size_t n)
+{
+    for (size_t i = 0; i + n <= len; i++)
+    {
+        if (0 == memcmp(hay + i, needle, n)) return (ptrdiff_t)i;
+    }
+    return -1;
+}
+
+static ptrdiff_t ref_rfind(const char *hay, size_t len, const char *needle, size_t n)
+{
+    for (size_t i = len + 1; i-- > 0; )
+    {
+        if (i + n <= len && 0 == memcmp(hay + i, needle, n)) return (ptrdiff_t)i;
+    }
+    return -1;
+}
+
+// Search.
+
+static void test_find_cases(void)
+{
+    zstr s = zstr_from("the quick brown fox jumps over the lazy dog");
+    assert(0 == zstr_find(&s, "the"));
+    assert(31 == zstr_rfind(&s, "the"));
+    assert(16 == zstr_find(&s, "fox"));
+    assert(-1 == zstr_find(&s, "cat"));
+    assert(0 == zstr_find(&s, ""));
+    assert((ptrdiff_t)zstr_len(&s) == zstr_rfind(&s, ""));
+    assert(zstr_contains(&s, "lazy") && !zstr_contains(&s, "Lazy"));
+    zstr_free(&s);
+
+    // Embedded NULs: the views search the whole length.
+    static const char bin[] = "ab\0cd\0ab\0cd";
+    zstr_view v = { bin, sizeof(bin) - 1 };
+    assert(3 == zstr_view_find(v, (zstr_view){ "cd\0ab", 5 }));
+    assert(9 == zstr_view_rfind(v, ZSV("cd")));
+    assert(3 == zstr_view_count(v, (zstr_view){ "\0", 1 }));
+    assert(0 == zstr_view_count(v, ZSV("")));
+    assert(-1 == zstr_view_find(ZSV("ab"), ZSV("abc")));
+    assert(-1 == zstr_view_rfind(ZSV(""), ZSV("a")));
+
+    // A match on each side of a 64-byte block edge, and one straddling it.
+    char big[200];
+    memset(big, 'a', sizeof(big));
+    for (size_t at = 56; at < 72; at++)
+    {
+        memset(big, 'a', sizeof(big));
+        memcpy(big + at, "xyzw", 4);
+        zstr_view h = { big, sizeof(big) };
+        assert((ptrdiff_t)at == zstr_view_find(h, ZSV("xyzw")));
+        assert((ptrdiff_t)at == zstr_view_rfind(h, ZSV("xyzw")));
+        assert((ptrdiff_t)at == zstr_view_find(h, ZSV("axyzw")) + 1);
+        assert(-1 == zstr_view_find(h, ZSV("xyzz")));
+    }
+}
+
+static void test_find_random(void)
+{
+    char hay[600];
+    char needle[12];
+    for (int round = 0; round < 20000; round++)
+    {
+        size_t len = rng_next() % sizeof(hay);
+        size_t n = 1 + rng_next() % (round % 4 ? 4 : sizeof(needle));
+        size_t pool = 2 + rng_next() % 3;
+        random_text(hay, len, "ab\0c", pool);
+        random_text(needle, n, "ab\0c", pool);
+        zstr_view h = { hay, len };
+        zstr_view nd = { needle, n };
+        assert(ref_find(hay, len, needle, n) == zstr_view_find(h, nd));
+        assert(ref_rfind(hay, len, needle, n) == zstr_view_rfind(h, nd));
+
+        size_t count = 0;
+        for (size_t at = 0; ; )
+        {
+            ptrdiff_t hit = ref_find(hay + at, len - at, needle, n);
+            if (hit < 0) break;
+            count++;
+            at += (size_t)hit + n;
+        }
+        assert(count == zstr_view_count(h, nd));
+    }
+}
+
+// Replace.
+
+// The expected result, built forwards into a fresh buffer.
+static zstr ref_replace(const char *src, size_t len, zstr_view target, zstr_view with)
+{
+    zstr out = zstr_init();
+    size_t at = 0;
+    ptrdiff_t hit;
+    while ((hit = ref_find(src + at, len - at, target.data, target.len)) >= 0)
+    {
+        zstr_cat_len(&out, src + at, (size_t)hit);
+        zstr_cat_len(&out, with.data, with.len);
+        at += (size_t)hit + target.len;
+    }
+    zstr_cat_len(&out, src + at, len - at);
+    return out;
+}
+
+static void test_replace_cases(void)
+{
+    zstr s = zstr_from("a-b-c");
+    assert(Z_OK == zstr_replace(&s, "-", "--"));
+    assert(0 == strcmp("a--b--c", zstr_cstr(&s)));
+    assert(Z_OK == zstr_replace(&s, "--", ""));
+    assert(0 == strcmp("abc", zstr_cstr(&s)) && 3 == zstr_len(&s));
+    assert(Z_OK == zstr_replace(&s, "b", NULL));
+    assert(0 == strcmp("ac", zstr_cstr(&s)));
+    assert(Z_OK == zstr_replace(&s, "zz", "y"));
+    assert(0 == strcmp("ac", zstr_cstr(&s)));
+    assert(Z_ERR == zstr_replace(&s, "", "y"));
+    assert(Z_ERR == zstr_replace_view(&s, ZSV(""), ZSV("y")));
+
+    // Short to long: the inline string grows past its small buffer.
+    assert(Z_OK == zstr_replace(&s, "a", "0123456789012345678901234567890123456789"));
+    assert(41 == zstr_len(&s) && zstr_is_long(&s) && 'c' == zstr_cstr(&s)[40]);
+    zstr_free(&s);
+
+    // Overlapping candidates are taken left to right.
+    s = zstr_from("aaaaa");
+    assert(Z_OK == zstr_replace(&s, "aa", "b"));
+    assert(0 == strcmp("bba", zstr_cstr(&s)));
+    zstr_free(&s);
+
+    // Over 64 matches spill the growing replacement's offset list to the heap.
+    s = zstr_init();
+    for (int i = 0; i < 1000; i++)
+    {
+        zstr_cat(&s, "x,");
+    }
+    assert(Z_OK == zstr_replace(&s, ",", ";;"));
+    assert(3000 == zstr_len(&s) && 1000 == zstr_view_count(zstr_as_view(&s), ZSV(";;")));
+    assert(Z_OK == zstr_replace(&s, "x;;", "x"));
+    assert(1000 == zstr_len(&s) && '\0' == zstr_cstr(&s)[1000]);
+    zstr_free(&s);
+}
+
+static void test_replace_random(void)
+{
+    char text[500];
+    char target[6];
+    char with[9];
+    for (int round = 0; round < 5000; round++)
+    {
+        size_t len = rng_next() % sizeof(text);
+        size_t tn = 1 + rng_next() % sizeof(target);
+        size_t wn = rng_next() % sizeof(with);
+        random_text(text, len, "abc", 2 + rng_next() % 2);
+        random_text(target, tn, "abc", 2);
+        random_text(with, wn, "xyz", 3);
+        zstr_view t = { target, tn };
+        zstr_view w = { with, wn };
+
+        zstr want = ref_replace(text, len, t, w);
+        zstr got = zstr_from_len(text, len);
+        assert(Z_OK == zstr_replace_view(&got, t, w));
+        assert(zstr_len(&want) == zstr_len(&got));
+        assert(0 == memcmp(zstr_cstr(&want), zstr_cstr(&got), zstr_len(&got)));
+        assert('\0' == zstr_cstr(&got)[zstr_len(&got)]);
+        zstr_free(&want);
+        zstr_free(&got);
+    }
+}
+
+// Split.
+
+static void test_split(void)
+{
+    zstr_split_iter it = zstr_split_init(ZSV("a,,b,"), ",");
+    zstr_view part;
+    const char *want[] = { "a", "", "b", "" };
+    for (size_t i = 0; i < 4; i++)
+    {
+        assert(zstr_split_next(&it, &part) && zstr_view_eq(part, want[i]));
+    }
+    assert(!zstr_split_next(&it, &part));
+
+    // A delimiter longer than what is left, and an empty one, give the rest as one part.
+    it = zstr_split_init(ZSV("ab::c:"), "::");
+    assert(zstr_split_next(&it, &part) && zstr_view_eq(part, "ab"));
+    assert(zstr_split_next(&it, &part) && zstr_view_eq(part, "c:"));
+    assert(!zstr_split_next(&it, &part));
+    it = zstr_split_init(ZSV("abc"), "");
+    assert(zstr_split_next(&it, &part) && zstr_view_eq(part, "abc"));
+    assert(!zstr_split_next(&it, &part));
+    it = zstr_split_init(ZSV(""), ",");
+    assert(zstr_split_next(&it, &part) && 0 == part.len);
+    assert(!zstr_split_next(&it, &part));
+
+    // Random input: the parts joined with the delimiter give the source back, and none holds it.
+    char text[400];
+    for (int round = 0; round < 3000; round++)
+    {
+        size_t len = rng_next() % sizeof(text);
+        random_text(text, len, "ab,", 3);
+        const char *delim = (round % 2) ? "," : "a,";
+        size_t dn = strlen(delim);
+        it = zstr_split_init((zstr_view){ text, len }, delim);
+        zstr joined = zstr_init();
+        size_t parts = 0;
+        while (zstr_split_next(&it, &part))
+        {
+            assert(-1 == ref_find(part.data, part.len, delim, dn));
+            if (parts++) zstr_cat(&joined, delim);
+            zstr_cat_len(&joined, part.data, part.len);
+        }
+        assert(parts == zstr_view_count((zstr_view){ text, len }, (zstr_view){ delim, dn }) + 1);
+        assert(len == zstr_len(&joined) && 0 == memcmp(text, zstr_cstr(&joined), len));
+        zstr_free(&joined);
+    }
+}
+
+// UTF-8.
+
+// Decodes every sequence in full and checks the code point's range.
+static bool ref_utf8_valid(const unsigned char *p, size_t len)
+{
+    static const uint32_t least[5] = { 0, 0, 0x80, 0x800, 0x10000 };
+    size_t i = 0;
+    while (i < len)
+    {
+        unsigned char c = p[i];
+        size_t n = (c < 0x80) ? 1 : (0xC0 == (c & 0xE0)) ? 2 : (0xE0 == (c & 0xF0)) ? 3 : (0xF0 == (c & 0xF8)) ? 4 : 0;
+        if (0 == n || len - i < n) return false;
+        uint32_t cp = (1 == n) ? c : (uint32_t)(c & (0x7F >> n));
+        for (size_t k = 1; k < n; k++)
+        {
+            if (0x80 != (p[i + k] & 0xC0)) return false;
+            cp = (cp << 6) | (p[i + k] & 0x3F);
+        }
+        if (cp < least[n] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return false;
+        i += n;
+    }
+    return true;
+}
+
+// Counts the way zstr_next_rune walks a NUL-terminated string.
+static size_t ref_runes(const char *cstr)
+{
+    size_t count = 0;
+    while (*cstr)
+    {
+        zstr_next_rune(&cstr);
+        count++;
+    }
+    return count;
+}
+
+static size_t put_rune(char *out, uint32_t cp)
+{
+    if (cp < 0x80)
+    {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800)
+    {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000)
+    {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+static void check_utf8(const char *p, size_t len, bool valid)
+{
+    zstr_view v = { p, len };
+    assert(valid == zstr_view_is_valid_utf8(v));
+    zstr s = zstr_from_len(p, len);
+    assert(valid == zstr_is_valid_utf8(&s));
+    assert(ref_runes(zstr_cstr(&s)) == zstr_count_runes(&s));
+    assert(zstr_count_runes(&s) == zstr_view_count_runes(v));
+    zstr_free(&s);
+}
+
+static void test_utf8_cases(void)
+{
+    static const struct { const char *text; bool valid; size_t runes; } cases[] = {
+        { "", true, 0 },
+        { "plain ascii", true, 11 },
+        { "caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80", true, 8 },
+        { "\xC0\x80", false, 1 },                // Overlong NUL.
+        { "\xC1\xBF", false, 1 },
+        { "\xE0\x80\x80", false, 1 },            // Overlong three-byte.
+        { "\xE0\xA0\x80", true, 1 },
+        { "\xED\x9F\xBF", true, 1 },
+        { "\xED\xA0\x80", false, 1 },            // Surrogate.
+        { "\xF0\x80\x80\x80", false, 1 },        // Overlong four-byte.
+        { "\xF4\x8F\xBF\xBF", true, 1 },         // U+10FFFF.
+        { "\xF4\x90\x80\x80", false, 1 },        // Past U+10FFFF.
+        { "\xF5\x80\x80\x80", false, 1 },     // Out of range, but shaped like a four-byte lead.
+        { "\xFF", false, 1 },
+        { "\x80", false, 1 },                    // Stray continuation.
+        { "a\xC3", false, 2 },                   // Truncated at the end.
+        { "\xE2\x82", false, 2 },
+        { "\xE2\x82x", false, 3 },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        size_t len = strlen(cases[i].text);
+        check_utf8(cases[i].text, len, cases[i].valid);
+        assert(cases[i].runes == zstr_view_count_runes((zstr_view){ cases[i].text, len }));
+    }
+
+    // A four-byte sequence at every offset across the 16- and 64-byte edges, whole and cut short.
+    char buf[160];
+    for (size_t at = 0; at + 4 <= sizeof(buf); at++)
+    {
+        memset(buf, 'a', sizeof(buf));
+        memcpy(buf + at, "\xF0\x9F\x98\x80", 4);
+        check_utf8(buf, sizeof(buf), true);
+        check_utf8(buf, at + 3, false);
+        check_utf8(buf, at + 4, true);
+        buf[at + 2] = 'a';
+        check_utf8(buf, sizeof(buf), false);
+    }
+}
+
+// Random code points, some of them corrupted: validity and rune counts match the references.
+static void test_utf8_random(void)
+{
+    char buf[700];
+    for (int round = 0; round < 20000; round++)
+    {
+        size_t runes = rng_next() % 160;
+        size_t len = 0;
+        for (size_t r = 0; r < runes && len + 4 <= sizeof(buf); r++)
+        {
+            uint32_t pick = rng_next();
+            uint32_t cp;
+            switch (pick % 4)
+            {
+            case 0: cp = 1 + pick % 0x7F; break;
+            case 1: cp = 0x80 + pick % 0x780; break;
+            case 2: cp = 0x800 + pick % 0xF800; break;
+            default: cp = 0x10000 + pick % 0x100000; break;
+            }
+            if (cp >= 0xD800 && cp <= 0xDFFF) cp -= 0x800;
+            // Long runs of ASCII let the clean-block fast paths kick in.
+            if (round % 3 == 0 && pick % 8) cp = 'a' + pick % 26;
+            len += put_rune(buf + len, cp);
+        }
+        if (round % 2 && len > 0)
+        {
+            int hits = 1 + (int)(rng_next() % 3);
+            for (int k = 0; k < hits; k++)
+            {
+                buf[rng_next() % len] = (char)(1 + rng_next() % 255);
+            }
+        }
+        check_utf8(buf, len, ref_utf8_valid((const unsigned char *)buf, len));
+    }
+}
+
+// Builder.
+
+static void check_builder(const zstr_builder *b, const zstr *want)
+{
+    assert(zstr_len(want) == zstr_builder_len(b));
+
+    zstr got = zstr_builder_to_str(b);
+    assert(zstr_eq(want, &got) && '\0' == zstr_cstr(&got)[zstr_len(&got)]);
+    zstr_free(&got);
+
+    // The chunk views cover the content in order, and input too small for them reports the need.
+    zstr_view views[64];
+    size_t n = zstr_builder_views(b, views, 64);
+    assert(n <= 64);
+    size_t at = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        assert(views[i].len > 0);
+        assert(0 == memcmp(zstr_cstr(want) + at, views[i].data, views[i].len));
+        at += views[i].len;
+    }
+    assert(at == zstr_len(want));
+    assert(n == zstr_builder_views(b, NULL, 0));
+
+    FILE *f = tmpfile();
+    assert(f && Z_OK == zstr_builder_write_file(b, f));
+    assert((long)zstr_len(want) == ftell(f));
+    rewind(f);
+    char *back = (char *)malloc(zstr_len(want) + 1);
+    assert(back && zstr_len(want) == fread(back, 1, zstr_len(want) + 1, f));
+    assert(0 == memcmp(back, zstr_cstr(want), zstr_len(want)));
+    free(back);
+    fclose(f);
+}
+
+// Random appends of every kind, mirrored into a plain zstr; earlier bytes never move.
+static void test_builder(void)
+{
+    zstr_builder b = zstr_builder_init();
+    zstr want = zstr_init();
+    check_builder(&b, &want);
+    assert(0 == zstr_builder_views(&b, NULL, 0));
+
+    char piece[9000];
+    random_text(piece, sizeof(piece), "abcdefgh", 8);
+    const char *first = NULL;
+    for (int round = 0; round < 3000; round++)
+    {
+        size_t n;
+        switch (rng_next() % 5)
+        {
+        case 0:
+            // Now and then a piece past the chunk size gets a chunk of its own.
+            n = (0 == rng_next() % 50) ? 5000 + rng_next() % 4000 : rng_next() % 300;
+            assert(Z_OK == zstr_builder_cat_len(&b, piece, n));
+            zstr_cat_len(&want, piece, n);
+            break;
+        case 1:
+            assert(Z_OK == zstr_builder_push_char(&b, 'z'));
+            zstr_push(&want, 'z');
+            break;
+        case 2:
+            assert(Z_OK == zstr_builder_fmt(&b, "[%d:%s]", round, "fmt"));
+            zstr_fmt(&want, "[%d:%s]", round, "fmt");
+            break;
+        case 3:
+        {
+            n = rng_next() % 600;
+            char *dst = zstr_builder_reserve(&b, n);
+            assert(dst);
+            memcpy(dst, piece + 7, n);
+            size_t used = n ? rng_next() % n : 0;
+            zstr_builder_commit(&b, used);
+            zstr_cat_len(&want, piece + 7, used);
+            break;
+        }
+        default:
+            assert(Z_OK == zstr_builder_cat_view(&b, ZSV("view")));
+            assert(Z_OK == zstr_builder_cat(&b, ""));
+            zstr_cat(&want, "view");
+            break;
+        }
+        if (!first && zstr_builder_len(&b) > 0)
+        {
+            zstr_view v;
+            zstr_builder_views(&b, &v, 1);
+            first = v.data;
+        }
+    }
+    zstr_view v;
+    zstr_builder_views(&b, &v, 1);
+    assert(first == v.data);
+    check_builder(&b, &want);
+
+    // Clearing keeps the first chunk for the next round.
+    zstr_chunk *head = b.head;
+    zstr_builder_clear(&b);
+    assert(0 == zstr_builder_len(&b) && head == b.head && head == b.tail);
+    zstr_clear(&want);
+    check_builder(&b, &want);
+    assert(Z_OK == zstr_builder_fmt(&b, "%0*d", 5000, 7));
+    zstr_fmt(&want, "%0*d", 5000, 7);
+    check_builder(&b, &want);
+
+    zstr_builder_free(&b);
+    assert(0 == zstr_builder_len(&b) && NULL == b.head);
+    zstr_free(&want);
+}
+
+// Interning.
+
+// Ids are dense in first-seen order, and each one's canonical view keeps its address.
+static void test_intern(void)
+{
+    zstr_intern_pool p = zstr_intern_init();
+    uint32_t id;
+    assert(!zstr_intern_lookup(&p, ZSV("a"), &id));
+    assert(NULL == zstr_intern_get(&p, 0).data);
+
+    zstr_view empty = zstr_intern(&p, ZSV(""));
+    assert(empty.data && 0 == empty.len && '\0' == empty.data[0]);
+    assert(zstr_interned_eq(empty, zstr_intern_cstr(&p, "")));
+    assert(Z_OK == zstr_intern_id(&p, (zstr_view){ "x\0y", 3 }, &id) && 1 == id);
+    assert(Z_OK == zstr_intern_id(&p, ZSV("x"), &id) && 2 == id);
+    assert(3 == zstr_intern_get(&p, 1).len && 3 == zstr_intern_count(&p));
+
+    enum { KEYS = 20000 };
+    const char **seen = (const char **)calloc(KEYS, sizeof(char *));
+    uint32_t *ids = (uint32_t *)calloc(KEYS, sizeof(uint32_t));
+    assert(seen && ids);
+    size_t expect = 3;
+    char key[32];
+    for (int round = 0; round < 4 * KEYS; round++)
+    {
+        int k = (int)(rng_next() % KEYS);
+        snprintf(key, sizeof(key), "tag-%d", k);
+        zstr_view v = zstr_intern_cstr(&p, key);
+        assert(v.data && zstr_view_eq(v, key) && '\0' == v.data[v.len]);
+        assert(Z_OK == zstr_intern_id(&p, v, &id));
+        if (!seen[k])
+        {
+            seen[k] = v.data;
+            ids[k] = id;
+            assert(id == expect++);
+        }
+        assert(seen[k] == v.data && ids[k] == id);
+        assert(zstr_interned_eq(v, zstr_intern_get(&p, id)));
+    }
+    assert(expect == zstr_intern_count(&p));
+    for (int k = 0; k < KEYS; k++)
+    {
+        snprintf(key, sizeof(key), "tag-%d", k);
+        bool present = zstr_intern_lookup(&p, zstr_view_from(key), &id);
+        assert(present == (NULL != seen[k]));
+        assert(!present || ids[k] == id);
+    }
+    assert(zstr_interned_eq(empty, zstr_intern_get(&p, 0)));
+
+    free(seen);
+    free(ids);
+    zstr_intern_free(&p);
+    assert(0 == zstr_intern_count(&p));
+    assert(!zstr_intern_lookup(&p, ZSV("x"), NULL));
+}
+
+int main(void)
+{
+    test_find_cases();
+    test_find_random();
+    test_replace_cases();
+    test_replace_random();
+    test_split();
+    test_utf8_cases();
+    test_utf8_random();
+    test_builder();
+    test_intern();
+    printf("zstr: ok\n");
+    return 0;
+}
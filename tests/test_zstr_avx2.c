@@ -0,0 +1,25 @@
+/*
+ * The zstr tests again with AVX2 (and so SSSE3) enabled for this file only, which selects the
+ * 256-bit block masks and the table-driven UTF-8 validator. Machines without AVX2 skip it.
+ */
+
+#if defined(__GNUC__) && !defined(__clang__) && (defined(__x86_64__) || defined(__i386__))
+#   pragma GCC target("avx2")
+#   define ZSTR_TEST_AVX2 1
+#endif
+
+#define main zstr_test_main
+#include "test_zstr.c"
+#undef main
+
+int main(void)
+{
+#if defined(ZSTR_TEST_AVX2)
+    if (!__builtin_cpu_supports("avx2"))
+    {
+        printf("zstr (avx2): skipped\n");
+        return 0;
+    }
+#endif
+    return zstr_test_main();
+}
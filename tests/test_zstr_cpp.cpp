@@ -0,0 +1,72 @@
+/*
+ * Behaviour tests for the zstr.h C++ wrappers: search, the builder and the intern pool.
+ * Build and run with `make test`.
+ */
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "zstr.h"
+
+static void test_search()
+{
+    z_str::string s("one,two,one");
+    assert(0 == s.find("one") && 8 == s.rfind("one"));
+    assert(-1 == s.find("three") && s.contains("two,"));
+    s.replace("one", "1");
+    assert(s == "1,two,1");
+
+    std::string joined;
+    for (auto part : s.split(","))
+    {
+        joined += std::string(part.data(), part.size()) + ";";
+    }
+    assert("1;two;1;" == joined);
+}
+
+static void test_builder()
+{
+    z_str::builder b;
+    std::string want;
+    for (int i = 0; i < 2000; i++)
+    {
+        b.append("item").fmt("-%d", i) += ',';
+        want += "item-" + std::to_string(i) + ",";
+    }
+    assert(want.size() == b.size());
+    z_str::string s = b.str();
+    assert(want.size() == s.size() && 0 == memcmp(want.data(), s.data(), s.size()));
+
+    // Moving hands the chunks over.
+    z_str::builder moved(std::move(b));
+    assert(0 == b.size() && want.size() == moved.size());
+    moved.clear();
+    moved += "again";
+    assert(moved.str() == "again");
+}
+
+static void test_intern()
+{
+    z_str::intern_pool pool;
+    z_str::view a = pool.intern(z_str::view("alpha", 5));
+    std::string copy = "alpha";
+    z_str::view b = pool.intern(z_str::view(copy.data(), copy.size()));
+    assert(a.data() == b.data() && copy.data() != b.data());
+
+    uint32_t id = 0;
+    assert(pool.id(z_str::view("beta", 4), &id) && 1 == id);
+    assert(pool.get(0).data() == a.data() && 4 == pool.get(1).size());
+    assert(nullptr == pool.get(7).data());
+    assert(2 == pool.size());
+}
+
+int main()
+{
+    test_search();
+    test_builder();
+    test_intern();
+    std::printf("zstr_cpp: ok\n");
+    return 0;
+}
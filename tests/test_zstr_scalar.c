@@ -0,0 +1,4 @@
+// The zstr tests again, on the scalar kernels and without compiler extensions.
+#define ZSTR_NO_SIMD
+#define Z_NO_EXTENSIONS
+#include "test_zstr.c"
@@ -0,0 +1,625 @@
+/*
+ * Behaviour tests for zthread.h.
+ * Build and run with `make test` (and `make test TEST_SAN=thread`).
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ZTHREAD_IMPLEMENTATION
+#include "zthread.h"
+
+#define EXEC_THREADS 4
+
+DEFINE_SPSC_QUEUE_TYPE(int64_t, I64)
+DEFINE_MPMC_QUEUE_TYPE(int64_t, I64)
+
+// Executor.
+
+static int64_t g_counter;
+
+static void count_task(void *arg)
+{
+    zatomic_fetch_add_i64(&g_counter, (int64_t)(intptr_t)arg, ZATOMIC_RELAXED);
+}
+
+typedef struct
+{
+    zexec *e;
+    int n;
+    int64_t result;
+} fib_job;
+
+// Spawns both halves and joins them, so workers wait on their own subtasks all the way down.
+static void fib_task(void *arg)
+{
+    fib_job *j = (fib_job *)arg;
+    if (j->n < 12)
+    {
+        int64_t a = 0, b = 1;
+        for (int i = 0; i < j->n; i++)
+        {
+            int64_t t = a + b;
+            a = b;
+            b = t;
+        }
+        j->result = a;
+        return;
+    }
+    fib_job l = { j->e, j->n - 1, 0 };
+    fib_job r = { j->e, j->n - 2, 0 };
+    ztask *t = zexec_spawn(j->e, fib_task, &l);
+    assert(t);
+    fib_task(&r);
+    zexec_join(t);
+    j->result = l.result + r.result;
+}
+
+typedef struct
+{
+    int index;
+    int worker;
+    int64_t sum;
+} run_item;
+
+static void run_task(void *arg)
+{
+    run_item *it = (run_item *)arg;
+    it->worker = zexec_worker_index();
+    for (int i = 0; i <= it->index; i++)
+    {
+        it->sum += i;
+    }
+}
+
+static void slow_task(void *arg)
+{
+    int *worker = (int *)arg;
+    *worker = zexec_worker_index();
+    zthread_sleep(2);
+}
+
+typedef struct
+{
+    zexec *e;
+    int workers[64];
+} steal_job;
+
+// Spawned from inside a task: the subtasks land on one deque and the other workers must steal them.
+static void steal_root(void *arg)
+{
+    steal_job *j = (steal_job *)arg;
+    ztask *tasks[64];
+    for (int i = 0; i < 64; i++)
+    {
+        tasks[i] = zexec_spawn(j->e, slow_task, &j->workers[i]);
+        assert(tasks[i]);
+    }
+    for (int i = 0; i < 64; i++)
+    {
+        zexec_join(tasks[i]);
+    }
+}
+
+static void test_exec(void)
+{
+    assert(-1 == zexec_worker_index());
+    zexec *e = zexec_create(EXEC_THREADS);
+    assert(e && EXEC_THREADS == zexec_threads(e));
+
+    // Destroy runs everything still queued.
+    g_counter = 0;
+    for (int i = 1; i <= 10000; i++)
+    {
+        assert(Z_OK == zexec_submit(e, count_task, (void *)(intptr_t)i));
+    }
+    zexec_destroy(e);
+    assert(10000LL * 10001 / 2 == g_counter);
+
+    e = zexec_create(EXEC_THREADS);
+    assert(e);
+    fib_job f = { e, 27, 0 };
+    ztask *t = zexec_spawn(e, fib_task, &f);
+    assert(t);
+    zexec_join(t);
+    assert(196418 == f.result);
+
+    // Fork-join: every item runs once, the caller takes part as item 0.
+    run_item items[200];
+    memset(items, 0, sizeof(items));
+    for (int i = 0; i < 200; i++)
+    {
+        items[i].index = i;
+    }
+    zexec_run(e, run_task, items, sizeof(run_item), 200);
+    for (int i = 0; i < 200; i++)
+    {
+        assert((int64_t)i * (i + 1) / 2 == items[i].sum);
+        assert(items[i].worker >= -1 && items[i].worker < EXEC_THREADS);
+    }
+    assert(-1 == items[0].worker);
+
+    // Size 0 hands the same argument to every call.
+    g_counter = 0;
+    zexec_run(e, count_task, (void *)(intptr_t)3, 0, 100);
+    assert(300 == g_counter);
+
+    steal_job s;
+    s.e = e;
+    t = zexec_spawn(e, steal_root, &s);
+    assert(t);
+    zexec_join(t);
+    // The joining thread may run tasks too (as worker -1).
+    int seen[EXEC_THREADS + 1] = {0};
+    int distinct = 0;
+    for (int i = 0; i < 64; i++)
+    {
+        assert(s.workers[i] >= -1 && s.workers[i] < EXEC_THREADS);
+        distinct += !seen[s.workers[i] + 1]++;
+    }
+    assert(distinct > 1);
+    zexec_destroy(e);
+
+    zexec *d = zexec_default();
+    assert(d && d == zexec_default());
+    assert((size_t)zthread_hardware_concurrency() == zexec_threads(d));
+}
+
+// Atomics and locks.
+
+#define LOCK_THREADS 4
+#define LOCK_ITERS   20000
+
+typedef struct
+{
+    zspinlock_t spin;
+    zlock_t lock;
+    zrwlock_t rw;
+    int64_t spin_count;   // Plain fields: only ever touched under their lock
+    int64_t lock_count;
+    int64_t a, b;         // Writers keep a + b == 0
+    int32_t ids;
+    int32_t add;
+    int64_t bits;
+    void *slot;
+} lock_state;
+
+static void lock_worker(void *arg)
+{
+    lock_state *st = (lock_state *)arg;
+    int32_t me = zatomic_fetch_add_i32(&st->ids, 1, ZATOMIC_RELAXED);
+    for (int i = 0; i < LOCK_ITERS; i++)
+    {
+        zspin_lock(&st->spin);
+        st->spin_count++;
+        zspin_unlock(&st->spin);
+
+        zlock_lock(&st->lock);
+        st->lock_count++;
+        zlock_unlock(&st->lock);
+
+        if (0 == i % 64)
+        {
+            zrwlock_write_lock(&st->rw);
+            st->a++;
+            st->b--;
+            zrwlock_write_unlock(&st->rw);
+        }
+        else
+        {
+            zrwlock_read_lock(&st->rw);
+            assert(0 == st->a + st->b);
+            zrwlock_read_unlock(&st->rw);
+        }
+    }
+    zatomic_fetch_or_i64(&st->bits, (int64_t)1 << me, ZATOMIC_RELAXED);
+
+    // CAS loop: every thread adds its share without losing updates.
+    for (int i = 0; i < LOCK_ITERS; i++)
+    {
+        int32_t seen = zatomic_load_i32(&st->add, ZATOMIC_RELAXED);
+        while (!zatomic_cas_i32(&st->add, &seen, seen + 2, ZATOMIC_ACQ_REL))
+        {
+        }
+    }
+}
+
+static int32_t g_once_runs;
+
+static void once_fn(void)
+{
+    zthread_sleep(5);
+    zatomic_fetch_add_i32(&g_once_runs, 1, ZATOMIC_RELAXED);
+}
+
+typedef struct
+{
+    zonce_t *once;
+    zevent_t *event;
+    int32_t *released;
+} once_job;
+
+static void once_worker(void *arg)
+{
+    once_job *j = (once_job *)arg;
+    zonce_call(j->once, once_fn);
+    // Nobody gets past the call before once_fn has returned.
+    assert(1 == zatomic_load_i32(&g_once_runs, ZATOMIC_ACQUIRE));
+    zevent_wait(j->event);
+    zatomic_fetch_add_i32(j->released, 1, ZATOMIC_RELEASE);
+}
+
+static void test_locks(void)
+{
+    lock_state st;
+    memset(&st, 0, sizeof(st));
+    zspin_init(&st.spin);
+    zlock_init(&st.lock);
+    zrwlock_init(&st.rw);
+
+    zthread_t threads[LOCK_THREADS];
+    for (int t = 0; t < LOCK_THREADS; t++)
+    {
+        assert(Z_OK == zthread_create(&threads[t], lock_worker, &st));
+    }
+    for (int t = 0; t < LOCK_THREADS; t++)
+    {
+        zthread_join(threads[t]);
+    }
+    assert((int64_t)LOCK_THREADS * LOCK_ITERS == st.spin_count);
+    assert((int64_t)LOCK_THREADS * LOCK_ITERS == st.lock_count);
+    assert(st.a > 0 && 0 == st.a + st.b);
+    assert(LOCK_THREADS == st.ids && 2 * LOCK_THREADS * LOCK_ITERS == st.add);
+    assert((1 << LOCK_THREADS) - 1 == st.bits);
+    zrwlock_destroy(&st.rw);
+
+    assert(zspin_trylock(&st.spin) && !zspin_trylock(&st.spin));
+    zspin_unlock(&st.spin);
+    assert(zlock_trylock(&st.lock) && !zlock_trylock(&st.lock));
+    zlock_unlock(&st.lock);
+
+    int x = 1, y = 2;
+    st.slot = &x;
+    assert(&x == zatomic_exchange_ptr(&st.slot, &y, ZATOMIC_ACQ_REL));
+    void *expect = &x;
+    assert(!zatomic_cas_ptr(&st.slot, &expect, NULL, ZATOMIC_SEQ_CST) && &y == expect);
+    assert(zatomic_cas_ptr(&st.slot, &expect, NULL, ZATOMIC_SEQ_CST));
+    assert(NULL == zatomic_load_ptr(&st.slot, ZATOMIC_ACQUIRE));
+    assert(3 == zatomic_fetch_and_i64(&(int64_t){3}, 1, ZATOMIC_RELAXED));
+
+    // Once flag and event: one run, and every waiter released by a single set.
+    zonce_t once = ZONCE_INIT;
+    zevent_t event;
+    zevent_init(&event, false);
+    assert(!zevent_is_set(&event));
+    int32_t released = 0;
+    once_job job = { &once, &event, &released };
+    for (int t = 0; t < LOCK_THREADS; t++)
+    {
+        assert(Z_OK == zthread_create(&threads[t], once_worker, &job));
+    }
+    zthread_sleep(20);
+    assert(0 == zatomic_load_i32(&released, ZATOMIC_ACQUIRE));
+    zevent_set(&event);
+    for (int t = 0; t < LOCK_THREADS; t++)
+    {
+        zthread_join(threads[t]);
+    }
+    assert(LOCK_THREADS == released && 1 == g_once_runs);
+    zonce_call(&once, once_fn);
+    assert(1 == g_once_runs);
+
+    assert(zevent_is_set(&event));
+    zevent_wait(&event);
+    zevent_reset(&event);
+    assert(!zevent_is_set(&event));
+
+    // A wait on a value that already changed returns straight away.
+    int32_t word = 1;
+    zthread_wait_on(&word, 0);
+    zthread_wake_all(&word);
+}
+
+// Queues.
+
+#define Q_ITEMS     50000
+#define Q_PRODUCERS 3
+#define Q_CONSUMERS 3
+
+static void spsc_producer(void *arg)
+{
+    zspsc_I64 *q = (zspsc_I64 *)arg;
+    int64_t batch[16];
+    int64_t next = 0;
+    while (next < Q_ITEMS)
+    {
+        // Alternate single waits with batches of up to 16.
+        if (0 == next % 3)
+        {
+            zspsc_push_wait_I64(q, next++);
+            continue;
+        }
+        size_t n = 0;
+        while (n < 16 && next + (int64_t)n < Q_ITEMS)
+        {
+            batch[n] = next + (int64_t)n;
+            n++;
+        }
+        size_t moved = zspsc_push_n_I64(q, batch, n);
+        if (0 == moved)
+        {
+            zthread_yield();
+        }
+        next += (int64_t)moved;
+    }
+}
+
+static void test_spsc(void)
+{
+    zspsc_I64 q;
+    assert(Z_OK == zspsc_init_I64(&q, 1000));
+    assert(1024 == zspsc_capacity_I64(&q));
+
+    // Single-threaded: full and empty edges, partial batches.
+    int64_t v = 0;
+    assert(!zspsc_pop_I64(&q, &v));
+    for (int64_t i = 0; i < 1024; i++)
+    {
+        assert(zspsc_push_I64(&q, i));
+    }
+    assert(!zspsc_push_I64(&q, -1) && 1024 == zspsc_size_I64(&q));
+    int64_t out[2048];
+    assert(1024 == zspsc_pop_n_I64(&q, out, 2048));
+    for (int64_t i = 0; i < 1024; i++)
+    {
+        assert(i == out[i]);
+    }
+    assert(1024 == zspsc_push_n_I64(&q, out, 2048));
+    assert(0 == zspsc_push_n_I64(&q, out, 1));
+    assert(1024 == zspsc_pop_n_I64(&q, out, 2048));
+    zspsc_free_I64(&q);
+
+    // Two threads through a small queue, so both sides park; order is kept.
+    assert(Z_OK == zspsc_init_I64(&q, 8));
+    zthread_t prod;
+    assert(Z_OK == zthread_create(&prod, spsc_producer, &q));
+    int64_t expect = 0;
+    while (expect < Q_ITEMS)
+    {
+        if (expect & 1)
+        {
+            zspsc_pop_wait_I64(&q, &v);
+            assert(expect++ == v);
+            continue;
+        }
+        size_t n = zspsc_pop_n_I64(&q, out, 5);
+        if (0 == n)
+        {
+            zthread_yield();
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            assert(expect++ == out[i]);
+        }
+    }
+    zthread_join(prod);
+    assert(0 == zspsc_size_I64(&q));
+    zspsc_free_I64(&q);
+}
+
+typedef struct
+{
+    zmpmc_I64 *q;
+    int id;
+    int64_t *seen;     // Q_PRODUCERS * Q_ITEMS per-value counters, written by the consumers
+    int64_t consumed;
+} mpmc_job;
+
+static void mpmc_producer(void *arg)
+{
+    mpmc_job *j = (mpmc_job *)arg;
+    int64_t base = (int64_t)j->id * Q_ITEMS;
+    int64_t batch[8];
+    for (int64_t i = 0; i < Q_ITEMS;)
+    {
+        if (i % 5)
+        {
+            zmpmc_push_wait_I64(j->q, base + i++);
+            continue;
+        }
+        size_t n = 0;
+        while (n < 8 && i + (int64_t)n < Q_ITEMS)
+        {
+            batch[n] = base + i + (int64_t)n;
+            n++;
+        }
+        size_t moved = zmpmc_push_n_I64(j->q, batch, n);
+        if (0 == moved)
+        {
+            zthread_yield();
+        }
+        i += (int64_t)moved;
+    }
+}
+
+static void mpmc_consumer(void *arg)
+{
+    mpmc_job *j = (mpmc_job *)arg;
+    int64_t last[Q_PRODUCERS];
+    for (int p = 0; p < Q_PRODUCERS; p++)
+    {
+        last[p] = -1;
+    }
+    int64_t share = (int64_t)Q_PRODUCERS * Q_ITEMS / Q_CONSUMERS;
+    int64_t buf[8];
+    while (j->consumed < share)
+    {
+        size_t n;
+        if (j->consumed & 1)
+        {
+            zmpmc_pop_wait_I64(j->q, &buf[0]);
+            n = 1;
+        }
+        else
+        {
+            size_t want = share - j->consumed < 8 ? (size_t)(share - j->consumed) : 8;
+            n = zmpmc_pop_n_I64(j->q, buf, want);
+            if (0 == n)
+            {
+                zthread_yield();
+            }
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            int p = (int)(buf[i] / Q_ITEMS);
+            int64_t seq = buf[i] % Q_ITEMS;
+            // One producer's items reach any one consumer in the order they were pushed.
+            assert(p >= 0 && p < Q_PRODUCERS && seq > last[p]);
+            last[p] = seq;
+            zatomic_fetch_add_i64(&j->seen[buf[i]], 1, ZATOMIC_RELAXED);
+        }
+        j->consumed += (int64_t)n;
+    }
+}
+
+static void test_mpmc(void)
+{
+    zmpmc_I64 q;
+    assert(Z_OK == zmpmc_init_I64(&q, 3));
+    assert(4 == zmpmc_capacity_I64(&q));
+    int64_t v;
+    assert(zmpmc_push_I64(&q, 7) && zmpmc_push_I64(&q, 8));
+    assert(2 == zmpmc_push_n_I64(&q, (int64_t[]){9, 10, 11}, 3));
+    assert(!zmpmc_push_I64(&q, 12) && 4 == zmpmc_size_I64(&q));
+    assert(zmpmc_pop_I64(&q, &v) && 7 == v);
+    int64_t out[8];
+    assert(3 == zmpmc_pop_n_I64(&q, out, 8) && 8 == out[0] && 10 == out[2]);
+    assert(!zmpmc_pop_I64(&q, &v));
+    zmpmc_free_I64(&q);
+
+    assert(Z_OK == zmpmc_init_I64(&q, 64));
+    int64_t *seen = (int64_t *)calloc((size_t)Q_PRODUCERS * Q_ITEMS, sizeof(int64_t));
+    assert(seen);
+    zthread_t threads[Q_PRODUCERS + Q_CONSUMERS];
+    mpmc_job jobs[Q_PRODUCERS + Q_CONSUMERS];
+    for (int t = 0; t < Q_PRODUCERS + Q_CONSUMERS; t++)
+    {
+        jobs[t].q = &q;
+        jobs[t].id = t < Q_PRODUCERS ? t : t - Q_PRODUCERS;
+        jobs[t].seen = seen;
+        jobs[t].consumed = 0;
+        assert(Z_OK == zthread_create(&threads[t], t < Q_PRODUCERS ? mpmc_producer : mpmc_consumer, &jobs[t]));
+    }
+    for (int t = 0; t < Q_PRODUCERS + Q_CONSUMERS; t++)
+    {
+        zthread_join(threads[t]);
+    }
+    // Every item arrived exactly once.
+    for (size_t i = 0; i < (size_t)Q_PRODUCERS * Q_ITEMS; i++)
+    {
+        assert(1 == seen[i]);
+    }
+    assert(0 == zmpmc_size_I64(&q));
+    free(seen);
+    zmpmc_free_I64(&q);
+}
+
+// Topology and placement.
+
+static void node_task(void *arg)
+{
+    int *out = (int *)arg;
+    out[0] = zexec_worker_index();
+    out[1] = zexec_worker_node();
+}
+
+static void test_topology(void)
+{
+    int count = zthread_topology(NULL, 0);
+    assert(count >= 1 && count <= zthread_hardware_concurrency());
+    zthread_cpu_info *cpus = (zthread_cpu_info *)calloc((size_t)count, sizeof(zthread_cpu_info));
+    assert(cpus && count == zthread_topology(cpus, count));
+    int cores = zthread_physical_cores();
+    int nodes = zthread_numa_nodes();
+    assert(cores >= 1 && cores <= count && nodes >= 1);
+    for (int i = 0; i < count; i++)
+    {
+        assert(cpus[i].cpu >= 0 && cpus[i].core >= 0 && cpus[i].package >= 0);
+        assert(cpus[i].node >= 0 && cpus[i].node < nodes);
+        for (int k = 0; k < i; k++)
+        {
+            assert(cpus[i].cpu != cpus[k].cpu);
+        }
+    }
+
+    // Pinning the caller to one CPU keeps it there.
+    int last = cpus[count - 1].cpu;
+    int rc = zthread_set_affinity(zthread_self(), &last, 1);
+    assert(Z_OK == rc || Z_ERR == rc);
+    if (Z_OK == rc)
+    {
+        int now = zthread_current_cpu();
+        assert(-1 == now || last == now);
+    }
+    int bad = -1;
+    assert(Z_EINVAL == zthread_set_affinity(zthread_self(), &bad, 1) || Z_ERR == rc);
+    int all[256];
+    int n = count < 256 ? count : 256;
+    for (int i = 0; i < n; i++)
+    {
+        all[i] = cpus[i].cpu;
+    }
+    assert(rc == zthread_set_affinity(zthread_self(), all, (size_t)n));
+
+    assert(Z_OK == zthread_set_name(zthread_self(), "zdk-test-thread-name"));
+#if defined(__linux__)
+    FILE *comm = fopen("/proc/thread-self/comm", "r");
+    if (comm)
+    {
+        char name[32] = {0};
+        assert(fgets(name, sizeof(name), comm));
+        fclose(comm);
+        assert(0 == strcmp(name, "zdk-test-thread\n"));
+    }
+#endif
+
+    // Node-local memory is page aligned and usable.
+    size_t size = 3 * 4096 + 17;
+    uint8_t *mem = (uint8_t *)zthread_numa_alloc(size, cpus[0].node);
+    assert(mem && 0 == (uintptr_t)mem % 4096);
+    memset(mem, 0x5A, size);
+    assert(0x5A == mem[size - 1]);
+    zthread_numa_free(mem, size);
+    mem = (uint8_t *)zthread_numa_alloc(size, -1);
+    assert(mem);
+    zthread_numa_free(mem, size);
+
+    // One pinned worker per physical core, each reporting its node.
+    zexec_options opt = { 0, ZEXEC_PLACE_CORES, "pinned" };
+    zexec *e = zexec_create_ex(&opt);
+    assert(e && (size_t)cores == zexec_threads(e));
+    int where[2] = { -2, -2 };
+    ztask *t = zexec_spawn(e, node_task, where);
+    assert(t);
+    zexec_join(t);
+    if (where[0] >= 0)
+    {
+        assert(where[0] < cores && where[1] >= -1 && where[1] < nodes);
+    }
+    zexec_destroy(e);
+    free(cpus);
+}
+
+int main(void)
+{
+    test_exec();
+    test_locks();
+    test_spsc();
+    test_mpmc();
+    test_topology();
+    printf("zthread: ok\n");
+    return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * Behaviour tests for the zthread.h C++ wrappers.
+ * Build and run with `make test`.
+ */
+
+#include <cassert>
+#include <cstdio>
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define ZTHREAD_IMPLEMENTATION
+#include "zthread.h"
+
+static void test_pool()
+{
+    z_thread::pool pool(4);
+    assert(4 == pool.size());
+    assert(pool.native_handle());
+
+    auto doubled = pool.submit([](int x) { return x * 2; }, 21);
+    auto text = pool.submit([](const std::string &a, const std::string &b) { return a + b; },
+                            std::string("work-"), std::string("stealing"));
+    assert(42 == doubled.get());
+    assert("work-stealing" == text.get());
+
+    // Exceptions travel through the future.
+    auto thrown = pool.submit([]() -> int { throw std::runtime_error("boom"); });
+    bool caught = false;
+    try
+    {
+        thrown.get();
+    }
+    catch (const std::runtime_error &)
+    {
+        caught = true;
+    }
+    assert(caught);
+
+    std::vector<std::future<long>> futures;
+    for (long i = 0; i < 1000; i++)
+    {
+        futures.push_back(pool.submit([](long v) { return v * v; }, i));
+    }
+    long sum = 0;
+    for (auto &f : futures)
+    {
+        sum += f.get();
+    }
+    assert(999L * 1000 * 1999 / 6 == sum);
+
+    // run() takes part itself, so it may nest inside a pool task.
+    std::vector<int> hits(256, 0);
+    auto nested = pool.submit([&]() {
+        pool.run(hits.size(), [&](size_t i) { hits[i]++; });
+        return 1;
+    });
+    assert(1 == nested.get());
+    for (int h : hits)
+    {
+        assert(1 == h);
+    }
+}
+
+static void test_post_on_destroy()
+{
+    std::atomic<int> done(0);
+    {
+        z_thread::pool pool(2);
+        for (int i = 0; i < 500; i++)
+        {
+            pool.post([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+        }
+    }
+    // The destructor ran every posted task before joining.
+    assert(500 == done.load());
+}
+
+int main()
+{
+    test_pool();
+    test_post_on_destroy();
+    std::printf("zthread_cpp: ok\n");
+    return 0;
+}
@@ -0,0 +1,573 @@
+/*
+ * Behaviour tests for ztree.h: red-black and B+ trees fuzzed against a presence-array reference,
+ * with their structure checked as they go. test_ztree_aug.c runs them again with ZTREE_AUGMENTED,
+ * which adds the order statistics and a user aggregate to the checks.
+ * Build and run with `make test`.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ZALLOC_IMPLEMENTATION
+#include "zalloc.h"
+
+// Unpooled nodes come from here, so a test can make the next allocations fail.
+static long g_fail_after = -1;
+
+static void *test_malloc(size_t size)
+{
+    if (0 == g_fail_after)
+    {
+        return NULL;
+    }
+    if (g_fail_after > 0)
+    {
+        g_fail_after--;
+    }
+    return malloc(size);
+}
+
+#define ZTREE_MALLOC(sz) test_malloc(sz)
+
+static int cmp_int(const int *a, const int *b)
+{
+    return (*a > *b) - (*a < *b);
+}
+
+// Wide enough that leaves hold the minimum of four entries, so splits and merges are constant.
+typedef struct
+{
+    int tag;
+    char pad[120];
+} wide_val;
+
+#define REGISTER_ZTREE_TYPES(X) X(int, int, rb, cmp_int)
+#define REGISTER_ZBTREE_TYPES(X) X(int, int, ii, cmp_int) X(int, wide_val, iw, cmp_int)
+#include "ztree.h"
+
+#define KEYS 3000
+
+static uint32_t rng_state = 88172645u;
+
+static uint32_t rng_next(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// Reference: ref[k] is the value for key k, or -1 when k is absent.
+static int ref[KEYS];
+static size_t ref_size;
+
+static void ref_reset(void)
+{
+    for (int k = 0; k < KEYS; k++)
+    {
+        ref[k] = -1;
+    }
+    ref_size = 0;
+}
+
+static int ref_lower(int k)
+{
+    for (; k < KEYS; k++)
+    {
+        if (ref[k] >= 0) return k;
+    }
+    return -1;
+}
+
+// The checker is written once per tree type.
+#define DEFINE_CHECKS(Name)                                                                     \
+    /* Every key below n lies in [lo, hi), leaves sit at one depth and no node is empty. */      \
+    static size_t check_node_##Name(zbtree_node_##Name *n, uint32_t height, long lo, long hi,   \
+                                    zbtree_leaf_##Name **chain)                                 \
+    {                                                                                           \
+        assert(n->count > 0);                                                                   \
+        if (1 == height)                                                                        \
+        {                                                                                       \
+            zbtree_leaf_##Name *l = (zbtree_leaf_##Name *)n;                                    \
+            assert(n->count <= (uint32_t)zbtree_leaf_cap_##Name);                               \
+            assert(l == *chain);                                                                \
+            *chain = l->next;                                                                   \
+            assert(!l->next || l->next->prev == l);                                             \
+            for (uint32_t i = 0; i < n->count; i++)                                             \
+            {                                                                                   \
+                assert(l->keys[i] >= lo && l->keys[i] < hi);                                    \
+                assert(0 == i || l->keys[i - 1] < l->keys[i]);                                  \
+            }                                                                                   \
+            return n->count;                                                                    \
+        }                                                                                       \
+        zbtree_inner_##Name *in = (zbtree_inner_##Name *)n;                                     \
+        assert(n->count <= (uint32_t)zbtree_inner_cap_##Name);                                  \
+        size_t total = 0;                                                                       \
+        for (uint32_t i = 0; i <= n->count; i++)                                                \
+        {                                                                                       \
+            long a = (0 == i) ? lo : in->keys[i - 1];                                           \
+            long b = (i == n->count) ? hi : in->keys[i];                                        \
+            assert(a <= b);                                                                     \
+            total += check_node_##Name(in->kids[i], height - 1, a, b, chain);                   \
+        }                                                                                       \
+        return total;                                                                           \
+    }                                                                                           \
+                                                                                                \
+    static void check_tree_##Name(zbtree_##Name *t)                                             \
+    {                                                                                           \
+        if (!t->root)                                                                           \
+        {                                                                                       \
+            assert(0 == t->size && 0 == t->height && !t->first && !t->last);                    \
+            return;                                                                             \
+        }                                                                                       \
+        zbtree_leaf_##Name *chain = t->first;                                                   \
+        assert(!t->first->prev && !t->last->next);                                              \
+        assert(t->size == check_node_##Name(t->root, t->height, -1, KEYS, &chain));             \
+        assert(NULL == chain);                                                                  \
+    }
+
+DEFINE_CHECKS(ii)
+DEFINE_CHECKS(iw)
+
+// Red-black trees.
+
+// Checks order, parent links, colours and (when augmented) the subtree sizes and sums.
+// Returns the black height.
+static int check_rb_node(ztree_node_rb *n, ztree_node_rb *parent, long lo, long hi, size_t *total)
+{
+    if (!n)
+    {
+        return 1;
+    }
+    assert(n->parent == parent);
+    assert(n->key > lo && n->key < hi);
+    if (ZTREE_RED == n->color)
+    {
+        assert(!n->left || ZTREE_BLACK == n->left->color);
+        assert(!n->right || ZTREE_BLACK == n->right->color);
+    }
+    int bl = check_rb_node(n->left, n, lo, n->key, total);
+    int br = check_rb_node(n->right, n, n->key, hi, total);
+    assert(bl == br);
+    (*total)++;
+#ifdef ZTREE_AUGMENTED
+    assert(n->count == 1 + ZTREE_AUG_COUNT__(n->left) + ZTREE_AUG_COUNT__(n->right));
+    assert(n->sum == n->value + (n->left ? n->left->sum : 0) + (n->right ? n->right->sum : 0));
+#endif
+    return bl + (ZTREE_BLACK == n->color);
+}
+
+static void compare_rb(ztree_rb *t)
+{
+    size_t total = 0;
+    assert(!t->root || (ZTREE_BLACK == t->root->color));
+    check_rb_node(t->root, NULL, -1, KEYS, &total);
+    assert(total == t->size && ref_size == t->size);
+
+    int k = ref_lower(0);
+    ztree_foreach(t, n)
+    {
+        assert(k == n->key && ref[k] == n->value);
+        k = ref_lower(k + 1);
+    }
+    assert(-1 == k);
+    ztree_node_rb *back = ztree_max(t);
+    for (int j = KEYS - 1; j >= 0; j--)
+    {
+        if (ref[j] < 0) continue;
+        assert(back && j == back->key);
+        back = ztree_prev(back);
+    }
+    assert(!back);
+
+    for (int probe = 0; probe < 20; probe++)
+    {
+        int lo = (int)(rng_next() % (KEYS + 2)) - 1;
+        ztree_node_rb *lb = ztree_lower_bound(t, lo);
+        int want = ref_lower(lo < 0 ? 0 : lo);
+        assert(want < 0 ? !lb : lb && want == lb->key);
+#ifdef ZTREE_AUGMENTED
+        int hi = lo + (int)(rng_next() % 300) - 20;
+        size_t below = 0, inside = 0;
+        for (int j = 0; j < KEYS; j++)
+        {
+            below += ref[j] >= 0 && j < lo;
+            inside += ref[j] >= 0 && j >= lo && j < hi;
+        }
+        assert(below == ztree_rank(t, lo));
+        assert(inside == ztree_count_range(t, lo, hi));
+        ztree_node_rb *sel = ztree_select(t, below);
+        assert(want < 0 ? !sel : sel == lb);
+        assert(!ztree_select(t, t->size));
+#endif
+    }
+}
+
+static void fuzz_rb(ztree_rb *t, int ops)
+{
+    ref_reset();
+    for (int op = 0; op < ops; op++)
+    {
+        int phase = op / (ops / 4);
+        int k = (int)(rng_next() % KEYS);
+        bool add = (0 == phase) ? rng_next() % 4 : (3 == phase) ? 0 == rng_next() % 4 : rng_next() % 2;
+        if (add)
+        {
+            int v = (int)(rng_next() % 1000);
+            assert(Z_OK == ztree_insert(t, k, v));
+            ref_size += ref[k] < 0;
+            ref[k] = v;
+        }
+        else
+        {
+            ztree_remove(t, k);
+            ref_size -= ref[k] >= 0;
+            ref[k] = -1;
+        }
+        ztree_node_rb *found = ztree_find(t, k);
+        assert(add ? found && ref[k] == found->value : !found);
+        if (0 == op % 500)
+        {
+            compare_rb(t);
+        }
+    }
+    compare_rb(t);
+}
+
+static void test_rb(void)
+{
+    ztree_rb t = ztree_init(rb);
+    fuzz_rb(&t, 60000);
+
+    // Editing values in place, then repairing the aggregates above each edit.
+    ztree_foreach(&t, n)
+    {
+        n->value = 1;
+        ref[n->key] = 1;
+#ifdef ZTREE_AUGMENTED
+        ztree_refresh(n);
+#endif
+    }
+    compare_rb(&t);
+#ifdef ZTREE_AUGMENTED
+    assert(!t.root || (long)t.size == t.root->sum);
+
+    // Every rank selects its own node.
+    for (size_t i = 0; i < t.size; i++)
+    {
+        ztree_node_rb *n = ztree_select(&t, i);
+        assert(n && i == ztree_rank(&t, n->key) && 1 == ztree_count_range(&t, n->key, n->key + 1));
+    }
+    assert(0 == ztree_count_range(&t, 10, 10) && 0 == ztree_count_range(&t, 10, 5));
+#endif
+    ztree_clear(&t);
+    assert(NULL == t.root && 0 == t.size);
+}
+
+// Pooled nodes, none of them through ZTREE_MALLOC; clear drops the slabs.
+static void test_rb_pooled(void)
+{
+    ztree_rb t = ztree_init_pool(rb, 16);
+    assert(t.pooled);
+    g_fail_after = 0;
+    for (int round = 0; round < 2; round++)
+    {
+        fuzz_rb(&t, 20000);
+        ztree_clear(&t);
+        assert(NULL == t.root && 0 == t.size);
+    }
+    g_fail_after = -1;
+}
+
+// An insert whose node cannot be allocated leaves the tree as it was.
+static void test_rb_out_of_memory(void)
+{
+    ztree_rb t = ztree_init(rb);
+    ref_reset();
+    for (int k = 0; k < 100; k++)
+    {
+        assert(Z_OK == ztree_insert(&t, k * 3, k));
+        ref[k * 3] = k;
+        ref_size++;
+    }
+    g_fail_after = 0;
+    assert(Z_ENOMEM == ztree_insert(&t, 1, 1));
+    assert(Z_OK == ztree_insert(&t, 3, 7));
+    g_fail_after = -1;
+    ref[3] = 7;
+    compare_rb(&t);
+    ztree_clear(&t);
+}
+
+// The whole tree against the reference, forwards and backwards, plus some bounds and ranges.
+static void compare_ii(zbtree_ii *t)
+{
+    check_tree_ii(t);
+    assert(ref_size == zbtree_size(t));
+
+    int k = ref_lower(0);
+    size_t seen = 0;
+    zbtree_foreach(t, it)
+    {
+        assert(k == *zbtree_iter_key(&it) && ref[k] == *zbtree_iter_value(&it));
+        k = ref_lower(k + 1);
+        seen++;
+    }
+    assert(-1 == k && seen == ref_size);
+
+    zbtree_iter_ii it = zbtree_last(t);
+    for (int j = KEYS - 1; j >= 0; j--)
+    {
+        if (ref[j] < 0) continue;
+        assert(zbtree_iter_valid(&it) && j == *zbtree_iter_key(&it));
+        zbtree_iter_prev(&it);
+    }
+    assert(!zbtree_iter_valid(&it));
+
+    for (int probe = 0; probe < 20; probe++)
+    {
+        int lo = (int)(rng_next() % (KEYS + 2)) - 1;
+        int hi = lo + (int)(rng_next() % 200);
+        zbtree_iter_ii b = zbtree_lower_bound(t, lo);
+        int want = ref_lower(lo < 0 ? 0 : lo);
+        assert(want < 0 ? !zbtree_iter_valid(&b) : want == *zbtree_iter_key(&b));
+        b = zbtree_upper_bound(t, lo);
+        want = ref_lower(lo + 1 < 0 ? 0 : lo + 1);
+        assert(want < 0 ? !zbtree_iter_valid(&b) : want == *zbtree_iter_key(&b));
+
+        size_t in_range = 0, want_range = 0;
+        zbtree_foreach_range(t, lo, hi, r)
+        {
+            int key = *zbtree_iter_key(&r);
+            assert(key >= lo && key < hi && ref[key] >= 0);
+            in_range++;
+        }
+        for (int j = lo < 0 ? 0 : lo; j < hi && j < KEYS; j++)
+        {
+            want_range += ref[j] >= 0;
+        }
+        assert(want_range == in_range);
+    }
+}
+
+// Random inserts, overwrites and removes, with phases that grow, churn and drain the tree.
+static void fuzz_ii(zbtree_ii *t, int ops)
+{
+    ref_reset();
+    for (int op = 0; op < ops; op++)
+    {
+        int phase = op / (ops / 4);
+        int k = (int)(rng_next() % KEYS);
+        bool add = (0 == phase) ? rng_next() % 4 : (3 == phase) ? 0 == rng_next() % 4 : rng_next() % 2;
+        if (add)
+        {
+            int v = (int)(rng_next() % 100000);
+            assert(Z_OK == zbtree_insert(t, k, v));
+            ref_size += ref[k] < 0;
+            ref[k] = v;
+        }
+        else
+        {
+            zbtree_remove(t, k);
+            ref_size -= ref[k] >= 0;
+            ref[k] = -1;
+        }
+        int *found = zbtree_find(t, k);
+        assert(add ? found && ref[k] == *found : !found);
+        assert(add == zbtree_contains(t, k));
+        if (0 == op % 500)
+        {
+            compare_ii(t);
+        }
+    }
+    compare_ii(t);
+}
+
+static void test_fuzz(void)
+{
+    zbtree_ii t = zbtree_init(ii);
+    fuzz_ii(&t, 60000);
+    zbtree_clear(&t);
+    check_tree_ii(&t);
+
+    // Ascending and descending runs hit the right-edge append and the left edge of every leaf.
+    ref_reset();
+    for (int k = 0; k < KEYS; k++)
+    {
+        assert(Z_OK == zbtree_insert(&t, k, k));
+        ref[k] = k;
+        ref_size++;
+    }
+    compare_ii(&t);
+    for (int k = KEYS - 1; k >= 0; k -= 2)
+    {
+        zbtree_remove(&t, k);
+        ref[k] = -1;
+        ref_size--;
+    }
+    compare_ii(&t);
+    zbtree_clear(&t);
+}
+
+// Four-entry leaves: the same fuzz, on the wide values, with the minimum fanout.
+static void test_narrow(void)
+{
+    assert(4 == zbtree_leaf_cap_iw);
+    zbtree_iw t = zbtree_init(iw);
+    ref_reset();
+    for (int op = 0; op < 40000; op++)
+    {
+        int k = (int)(rng_next() % 500);
+        if (rng_next() % 2)
+        {
+            wide_val v = { k * 3, { 0 } };
+            assert(Z_OK == zbtree_insert(&t, k, v));
+            ref_size += ref[k] < 0;
+            ref[k] = k * 3;
+        }
+        else
+        {
+            zbtree_remove(&t, k);
+            ref_size -= ref[k] >= 0;
+            ref[k] = -1;
+        }
+        if (0 == op % 200)
+        {
+            check_tree_iw(&t);
+            assert(ref_size == zbtree_size(&t));
+            for (int j = 0; j < 500; j++)
+            {
+                wide_val *v = zbtree_find(&t, j);
+                assert(ref[j] < 0 ? !v : v && ref[j] == v->tag);
+            }
+        }
+    }
+    zbtree_clear(&t);
+}
+
+static void test_bulk_load(void)
+{
+    static int keys[KEYS], vals[KEYS];
+    for (size_t n = 0; n < KEYS; n = n * 2 + 1)
+    {
+        ref_reset();
+        for (size_t i = 0; i < n; i++)
+        {
+            keys[i] = (int)i;
+            vals[i] = (int)(i * 7);
+            ref[i] = vals[i];
+        }
+        ref_size = n;
+        zbtree_ii t = zbtree_init(ii);
+        assert(Z_OK == zbtree_bulk_load(&t, keys, vals, n));
+        compare_ii(&t);
+
+        // A loaded tree takes ordinary updates afterwards.
+        for (int k = 0; k < KEYS; k += 7)
+        {
+            zbtree_remove(&t, k);
+            ref_size -= ref[k] >= 0;
+            ref[k] = -1;
+        }
+        compare_ii(&t);
+        if (zbtree_size(&t) > 0)
+        {
+            assert(Z_EINVAL == zbtree_bulk_load(&t, keys, vals, n));
+        }
+        zbtree_clear(&t);
+    }
+
+    int bad[] = { 1, 2, 2, 3 };
+    zbtree_ii t = zbtree_init(ii);
+    assert(Z_EINVAL == zbtree_bulk_load(&t, bad, bad, 4));
+    bad[2] = 0;
+    assert(Z_EINVAL == zbtree_bulk_load(&t, bad, bad, 4));
+    assert(0 == zbtree_size(&t) && !t.root);
+}
+
+// A failed insert or bulk load leaves the tree as it was.
+static void test_out_of_memory(void)
+{
+    zbtree_iw t = zbtree_init(iw);
+    ref_reset();
+    int failed = 0;
+    for (int k = 0; k < 2000; k++)
+    {
+        int key = (int)(rng_next() % KEYS);
+        g_fail_after = (k % 3) ? -1 : (long)(rng_next() % 3);
+        wide_val v = { key, { 0 } };
+        int rc = zbtree_insert(&t, key, v);
+        g_fail_after = -1;
+        if (Z_OK == rc)
+        {
+            ref_size += ref[key] < 0;
+            ref[key] = key;
+        }
+        else
+        {
+            assert(Z_ENOMEM == rc);
+            assert(!zbtree_contains(&t, key));
+            failed++;
+        }
+        if (0 == k % 100)
+        {
+            check_tree_iw(&t);
+            assert(ref_size == zbtree_size(&t));
+        }
+    }
+    assert(failed > 0);
+    check_tree_iw(&t);
+    zbtree_clear(&t);
+
+    static int keys[1000];
+    static wide_val vals[1000];
+    for (int i = 0; i < 1000; i++)
+    {
+        keys[i] = i;
+        vals[i].tag = i;
+    }
+    for (long fail = 0; fail < 40; fail += 3)
+    {
+        g_fail_after = fail;
+        assert(Z_ENOMEM == zbtree_bulk_load(&t, keys, vals, 1000));
+        g_fail_after = -1;
+        assert(!t.root && 0 == zbtree_size(&t));
+        check_tree_iw(&t);
+    }
+    assert(Z_OK == zbtree_bulk_load(&t, keys, vals, 1000));
+    check_tree_iw(&t);
+    zbtree_clear(&t);
+}
+
+// Pooled nodes: the same behaviour, none of it through ZTREE_MALLOC, and clear drops the slabs
+// (LeakSanitizer checks) while the tree stays usable.
+static void test_pooled(void)
+{
+    zbtree_ii t = zbtree_init_pool(ii, 8);
+    assert(t.pooled);
+    g_fail_after = 0;
+    for (int round = 0; round < 2; round++)
+    {
+        fuzz_ii(&t, 20000);
+        zbtree_clear(&t);
+        check_tree_ii(&t);
+    }
+    g_fail_after = -1;
+}
+
+int main(void)
+{
+    test_rb();
+    test_rb_pooled();
+    test_rb_out_of_memory();
+    test_fuzz();
+    test_narrow();
+    test_bulk_load();
+    test_out_of_memory();
+    test_pooled();
+    printf("ztree: ok\n");
+    return 0;
+}
@@ -0,0 +1,6 @@
+// The ztree tests again with order statistics and a user aggregate (the sum of the values).
+#define ZTREE_AUGMENTED
+#define ZTREE_AUGMENT_FIELDS long sum;
+#define ZTREE_AUGMENT_PULL(n) \
+    ((n)->sum = (n)->value + ((n)->left ? (n)->left->sum : 0) + ((n)->right ? (n)->right->sum : 0))
+#include "test_ztree.c"
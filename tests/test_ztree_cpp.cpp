@@ -0,0 +1,119 @@
+/*
+ * Behaviour tests for the ztree.h C++ wrappers.
+ * Build and run with `make test`.
+ */
+
+#include <cassert>
+#include <cstdio>
+#include <iterator>
+#include <map>
+#include <vector>
+
+static int cmp_int(const int *a, const int *b)
+{
+    return (*a > *b) - (*a < *b);
+}
+
+#define ZTREE_AUGMENTED
+#define REGISTER_ZTREE_TYPES(X) X(int, int, ii, cmp_int)
+#define REGISTER_ZBTREE_TYPES(X) X(int, double, id, cmp_int)
+#include "ztree.h"
+
+// z_tree::map order statistics against std::map.
+static void test_map_ranks()
+{
+    z_tree::map<int, int> t;
+    std::map<int, int> want;
+    for (int i = 0; i < 3000; i++)
+    {
+        int k = (i * 7919) % 4001;
+        t.insert(k, i);
+        want[k] = i;
+    }
+    for (int k = 0; k < 4001; k += 5)
+    {
+        t.erase(k);
+        want.erase(k);
+    }
+    assert(want.size() == t.size());
+
+    size_t rank = 0;
+    for (auto &e : want)
+    {
+        assert(rank == t.rank(e.first));
+        auto sel = t.select(rank);
+        assert(sel != t.end() && e.first == sel.key() && e.second == sel.value());
+        rank++;
+    }
+    assert(t.select(t.size()) == t.end());
+
+    auto lo = want.lower_bound(1000), hi = want.lower_bound(2500);
+    assert((size_t)std::distance(lo, hi) == t.count_range(1000, 2500));
+    assert(0 == t.count_range(2500, 1000));
+}
+
+// z_tree::btree against std::map.
+static void test_btree()
+{
+    z_tree::btree<int, double> t;
+    std::map<int, double> want;
+    unsigned seed = 7;
+    for (int op = 0; op < 20000; op++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        int k = (int)((seed >> 8) % 1000);
+        if (seed & 1)
+        {
+            t.insert(k, k * 0.5);
+            want[k] = k * 0.5;
+        }
+        else
+        {
+            t.erase(k);
+            want.erase(k);
+        }
+    }
+    assert(want.size() == t.size() && !t.empty());
+
+    auto w = want.begin();
+    for (auto e : t)
+    {
+        assert(w != want.end() && w->first == e.key() && w->second == e.value());
+        ++w;
+    }
+    assert(w == want.end());
+
+    auto lb = t.lower_bound(500);
+    assert(lb != t.end() && want.lower_bound(500)->first == lb.key());
+    auto ub = t.upper_bound(lb.key());
+    assert(ub != t.end() && want.upper_bound(lb.key())->first == ub.key());
+    assert(t.upper_bound(1000) == t.end());
+    assert(t.contains(lb.key()) && *t.find(lb.key()) == lb.value());
+
+    t.clear();
+    assert(t.empty() && t.begin() == t.end());
+
+    std::vector<int> keys;
+    std::vector<double> vals;
+    for (int i = 0; i < 5000; i++)
+    {
+        keys.push_back(i * 2);
+        vals.push_back(i);
+    }
+    assert(t.bulk_load(keys.data(), vals.data(), keys.size()));
+    assert(5000 == t.size() && 2500.0 == *t.find(5000) && !t.find(5001));
+    z_tree::btree<int, double> moved(std::move(t));
+    assert(t.empty() && 5000 == moved.size());
+
+    keys[10] = 0;
+    z_tree::btree<int, double> bad;
+    assert(!bad.bulk_load(keys.data(), vals.data(), keys.size()) && bad.empty());
+}
+
+int main()
+{
+    test_map_ranks();
+    test_btree();
+    std::printf("ztree_cpp: ok\n");
+    return 0;
+}
@@ -0,0 +1,363 @@
+/*
+ * Behaviour tests for zvec.h.
+ * Build and run with `make test`.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    int key;
+    int seq;
+} pair;
+
+typedef struct
+{
+    double price;
+    int seq;
+} priced;
+
+#define REGISTER_ZVEC_TYPES(X) X(int, Int) X(pair, Pair) X(priced, Priced)
+#define ZVEC_SMALL_CAP_SmallInt 8
+#define REGISTER_ZVEC_SMALL_TYPES(X) X(int, SmallInt)
+// zthread.h first, so the parallel algorithms are generated.
+#define ZTHREAD_IMPLEMENTATION
+#include "zthread.h"
+#include "zvec.h"
+
+#define PAIR_LESS(a, b)   ((a)->key < (b)->key)
+#define PAIR_KEY(p)       zvec_radix_key_i32((p)->key)
+#define PRICE_KEY(p)      zvec_radix_key_f64((p)->price)
+#define INT_LESS(a, b)    (*(a) < *(b))
+
+ZVEC_GENERATE_SORT_BY(pair, Pair, Key, PAIR_LESS)
+ZVEC_GENERATE_SORT_BY(int, Int, Value, INT_LESS)
+ZVEC_GENERATE_RADIX_SORT_BY(pair, Pair, Key, PAIR_KEY)
+ZVEC_GENERATE_RADIX_SORT_BY(priced, Priced, Price, PRICE_KEY)
+
+static uint32_t rng_state = 2463534242u;
+
+static uint32_t rng_next(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static int cmp_int(const int *a, const int *b)
+{
+    return (*a > *b) - (*a < *b);
+}
+
+static int cmp_int_qsort(const void *a, const void *b)
+{
+    return cmp_int((const int *)a, (const int *)b);
+}
+
+static int cmp_pair(const pair *a, const pair *b)
+{
+    return (a->key > b->key) - (a->key < b->key);
+}
+
+enum { PAT_RANDOM, PAT_SORTED, PAT_REVERSED, PAT_EQUAL, PAT_ORGAN, PAT_FEW, PAT_SAWTOOTH, PAT_COUNT };
+
+static int pattern_value(int pat, size_t i, size_t n)
+{
+    switch (pat)
+    {
+        case PAT_RANDOM:   return (int)rng_next();
+        case PAT_SORTED:   return (int)i;
+        case PAT_REVERSED: return (int)(n - i);
+        case PAT_EQUAL:    return 42;
+        case PAT_ORGAN:    return (int)(i < n / 2 ? i : n - i);
+        case PAT_FEW:      return (int)(rng_next() % 4) - 2;
+        default:           return (int)(i % 37);
+    }
+}
+
+// Every pattern and size, each sorter against qsort.
+static void test_sort_patterns(void)
+{
+    static const size_t sizes[] = { 0, 1, 2, 3, 15, 16, 17, 100, 1000, 100000 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        size_t n = sizes[s];
+        for (int pat = 0; pat < PAT_COUNT; pat++)
+        {
+            zvec_Int a = zvec_init(Int);
+            zvec_Int b = zvec_init(Int);
+            zvec_Pair p = zvec_init(Pair);
+            int *ref = (int *)malloc((n ? n : 1) * sizeof(int));
+            for (size_t i = 0; i < n; i++)
+            {
+                int x = pattern_value(pat, i, n);
+                ref[i] = x;
+                assert(Z_OK == zvec_push(&a, x));
+                assert(Z_OK == zvec_push(&b, x));
+                pair q = { x, (int)i };
+                assert(Z_OK == zvec_push(&p, q));
+            }
+            qsort(ref, n, sizeof(int), cmp_int_qsort);
+
+            zvec_sort(&a, cmp_int);
+            zvec_sort_Int_by_Value(&b);
+            assert(Z_OK == zvec_radix_sort_Pair_by_Key(&p));
+            for (size_t i = 0; i < n; i++)
+            {
+                assert(ref[i] == a.data[i]);
+                assert(ref[i] == b.data[i]);
+                assert(ref[i] == p.data[i].key);
+                // Radix sort is stable.
+                assert(0 == i || p.data[i - 1].key < p.data[i].key || p.data[i - 1].seq < p.data[i].seq);
+            }
+            free(ref);
+            zvec_free(&a);
+            zvec_free(&b);
+            zvec_free(&p);
+        }
+    }
+}
+
+static void test_search(void)
+{
+    zvec_Pair v = zvec_init(Pair);
+    for (int i = 0; i < 500; i++)
+    {
+        pair q = { (i / 3) * 2, i };
+        assert(Z_OK == zvec_push(&v, q));
+    }
+    zvec_sort_Pair_by_Key(&v);
+    for (int k = -1; k < 340; k++)
+    {
+        pair key = { k, 0 };
+        pair *lb = zvec_lower_bound_Pair_by_Key(&v, &key);
+        pair *lb2 = zvec_lower_bound(&v, &key, cmp_pair);
+        assert(lb == lb2);
+        size_t idx = lb ? (size_t)(lb - v.data) : v.length;
+        assert(idx == v.length || v.data[idx].key >= k);
+        assert(0 == idx || v.data[idx - 1].key < k);
+
+        pair *hit = zvec_bsearch_Pair_by_Key(&v, &key);
+        pair *hit2 = zvec_bsearch(&v, &key, cmp_pair);
+        bool present = k >= 0 && 0 == (k & 1) && k <= ((499 / 3) * 2);
+        assert((NULL != hit) == present && (NULL != hit2) == present);
+        assert(!hit || hit->key == k);
+        assert(!hit2 || hit2->key == k);
+    }
+    zvec_free(&v);
+
+    zvec_Int e = zvec_init(Int);
+    int k = 3;
+    assert(NULL == zvec_bsearch(&e, &k, cmp_int));
+    assert(NULL == zvec_lower_bound_Int_by_Value(&e, &k));
+    zvec_free(&e);
+}
+
+// Order-preserving keys: signed ints, and doubles with negatives, signed zeros and infinities.
+static void test_radix_keys(void)
+{
+    assert(zvec_radix_key_i32(-1) < zvec_radix_key_i32(0));
+    assert(zvec_radix_key_i32(INT32_MIN) < zvec_radix_key_i32(INT32_MAX));
+    assert(zvec_radix_key_i64(-5) < zvec_radix_key_i64(3));
+    assert(zvec_radix_key_f32(-2.0f) < zvec_radix_key_f32(-1.0f));
+    assert(zvec_radix_key_f32(-0.0f) < zvec_radix_key_f32(0.0f));
+    assert(zvec_radix_key_u64(7) == 7);
+
+    static const double vals[] = { 3.5, -0.0, 0.0, -1e300, 1e-300, -2.25, 1.0 / 0.0, -1.0 / 0.0, 2.0, -2.25 };
+    zvec_Priced v = zvec_init(Priced);
+    for (int i = 0; i < 1000; i++)
+    {
+        priced q = { vals[rng_next() % 10], i };
+        assert(Z_OK == zvec_push(&v, q));
+    }
+    assert(Z_OK == zvec_radix_sort_Priced_by_Price(&v));
+    for (size_t i = 1; i < v.length; i++)
+    {
+        uint64_t a = zvec_radix_key_f64(v.data[i - 1].price);
+        uint64_t b = zvec_radix_key_f64(v.data[i].price);
+        assert(a < b || (a == b && v.data[i - 1].seq < v.data[i].seq));
+        assert(v.data[i - 1].price <= v.data[i].price);
+    }
+    zvec_free(&v);
+}
+
+// Returned by value while inline: data still points into this frame until re-anchored.
+static zvec_SmallInt make_small(int n)
+{
+    zvec_SmallInt v = zvec_init(SmallInt);
+    for (int i = 0; i < n; i++)
+    {
+        assert(Z_OK == zvec_push(&v, i * 10));
+    }
+    return v;
+}
+
+static void test_small(void)
+{
+    zvec_SmallInt v = zvec_init(SmallInt);
+    assert(0 == v.length);
+    for (int i = 0; i < 8; i++)
+    {
+        assert(Z_OK == zvec_push(&v, i));
+        assert(zvec_data(&v) == v.inline_buf && 8 == v.capacity);
+    }
+
+    // The ninth element moves everything to the heap, in order.
+    assert(Z_OK == zvec_push(&v, 8));
+    assert(zvec_data(&v) != v.inline_buf && v.capacity > 8);
+    for (int i = 0; i < 9; i++)
+    {
+        assert(i == *zvec_at(&v, (size_t)i));
+    }
+
+    // Shrinking back under the inline capacity returns to the inline buffer.
+    zvec_pop(&v);
+    zvec_remove(&v, 0);
+    zvec_shrink_to_fit(&v);
+    assert(zvec_data(&v) == v.inline_buf && 7 == v.length);
+    for (int i = 0; i < 7; i++)
+    {
+        assert(i + 1 == v.data[i]);
+    }
+    zvec_free(&v);
+    assert(0 == v.length && zvec_data(&v) == v.inline_buf);
+    zvec_free(&v);
+
+    for (int n = 0; n <= 20; n += 4)
+    {
+        zvec_SmallInt r = make_small(n);
+        int expect = 0, count = 0;
+        zvec_foreach(&r, it)
+        {
+            assert(expect == *it);
+            expect += 10;
+            count++;
+        }
+        assert(n == count);
+        int key = 30;
+        int *hit = zvec_bsearch(&r, &key, cmp_int);
+        assert((NULL != hit) == (n > 3));
+        zvec_reverse(&r);
+        zvec_sort(&r, cmp_int);
+        assert(0 == n || 0 == *zvec_at(&r, 0));
+        zvec_free(&r);
+    }
+}
+
+static void add_one(int *x, void *ctx)
+{
+    (void)ctx;
+    (*x)++;
+}
+
+static void square(const int *src, int *dst, void *ctx)
+{
+    *dst = *src * *(const int *)ctx;
+}
+
+static void add_into(int *acc, const int *x, void *ctx)
+{
+    (void)ctx;
+    *acc += *x;
+}
+
+// Associative but not commutative: the chunk results must be combined in order.
+static void keep_first(int *acc, const int *x, void *ctx)
+{
+    (void)ctx;
+    if (-1 == *acc)
+    {
+        *acc = *x;
+    }
+}
+
+static void test_parallel(void)
+{
+    static const size_t threads[] = { 1, 2, 3, 8 };
+    static const size_t sizes[] = { 100, 16384, 200003 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        size_t n = sizes[s];
+        for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+        {
+            zvec_Int v = zvec_init(Int);
+            for (size_t i = 0; i < n; i++)
+            {
+                assert(Z_OK == zvec_push(&v, (int)(i % 1000)));
+            }
+
+            zvec_par_for_each_Int(&v, add_one, NULL, threads[t]);
+            long sum = 0;
+            for (size_t i = 0; i < n; i++)
+            {
+                assert((int)(i % 1000) + 1 == v.data[i]);
+                sum += v.data[i];
+            }
+
+            zvec_Int sq = zvec_init(Int);
+            int factor = 3;
+            assert(Z_OK == zvec_par_transform_Int(&sq, &v, square, &factor, threads[t]));
+            assert(n == sq.length);
+            for (size_t i = 0; i < n; i++)
+            {
+                assert(3 * v.data[i] == sq.data[i]);
+            }
+
+            int acc = 0;
+            zvec_par_reduce_Int(&v, &acc, add_into, NULL, threads[t]);
+            assert(sum == acc);
+            acc = -1;
+            zvec_par_reduce_Int(&v, &acc, keep_first, NULL, threads[t]);
+            assert(1 == acc);
+
+            for (size_t i = 0; i < n; i++)
+            {
+                v.data[i] = (int)rng_next();
+                sq.data[i] = v.data[i];
+            }
+            zvec_par_sort_Int(&v, cmp_int, threads[t]);
+            zvec_par_sort_Int_by_Value(&sq, threads[t]);
+            for (size_t i = 1; i < n; i++)
+            {
+                assert(v.data[i - 1] <= v.data[i]);
+                assert(v.data[i] == sq.data[i]);
+            }
+            zvec_free(&v);
+            zvec_free(&sq);
+        }
+    }
+
+    // Keys with duplicates through the sort-by path keep every element.
+    zvec_Pair p = zvec_init(Pair);
+    long seq_sum = 0;
+    for (int i = 0; i < 100000; i++)
+    {
+        pair q = { (int)(rng_next() % 100), i };
+        assert(Z_OK == zvec_push(&p, q));
+        seq_sum += i;
+    }
+    zvec_par_sort_Pair_by_Key(&p, 4);
+    for (size_t i = 0; i < p.length; i++)
+    {
+        assert(0 == i || p.data[i - 1].key <= p.data[i].key);
+        seq_sum -= p.data[i].seq;
+    }
+    assert(0 == seq_sum);
+    zvec_free(&p);
+}
+
+int main(void)
+{
+    test_sort_patterns();
+    test_search();
+    test_radix_keys();
+    test_small();
+    test_parallel();
+    printf("zvec: ok\n");
+    return 0;
+}
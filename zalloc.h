@@ -50,10 +50,26 @@
 #ifndef Z_MALLOC
     #include <stdlib.h>
     #define Z_MALLOC(sz)    malloc(sz)
+    #define Z_CALLOC(n,sz)  calloc(n, sz)
     #define Z_REALLOC(p,sz) realloc(p, sz)
     #define Z_FREE(p)       free(p)
 #endif
 
+/* * Runtime allocator handle, shared with the containers (same definition as in zcommon.h).
+ * zarena_allocator() / zpool_allocator() wrap an arena or pool so a container built with
+ * Z_ALLOCATOR_HANDLE can allocate from it; the handle only borrows the arena or pool.
+*/
+#ifndef Z_ALLOC_T_DEFINED
+#define Z_ALLOC_T_DEFINED
+typedef struct zalloc_t
+{
+    void *(*alloc)(void *ctx, size_t size);
+    void *(*realloc)(void *ctx, void *ptr, size_t old_size, size_t new_size);
+    void  (*free)(void *ctx, void *ptr, size_t size);
+    void *ctx;
+} zalloc_t;
+#endif
+
 
 /* * Z-ARENA (linear/region allocator)
  * Best for: temporary memory, per-frame data, fast bulk cleanups.
@@ -68,6 +84,16 @@
     #define ZARENA_DEFAULT_BLOCK_SIZE 4096
 #endif
 
+/* Blocks grow geometrically up to this size. */
+#ifndef ZARENA_MAX_BLOCK_SIZE
+    #define ZARENA_MAX_BLOCK_SIZE (1024 * 1024)
+#endif
+
+/* Virtual mode commits the reserved range in steps of this many bytes. */
+#ifndef ZARENA_COMMIT_SIZE
+    #define ZARENA_COMMIT_SIZE (64 * 1024)
+#endif
+
 typedef struct zarena_block zarena_block;
 
 typedef struct zarena 
@@ -75,8 +101,23 @@ typedef struct zarena
     zarena_block *head;
     zarena_block *first;
     size_t total_alloc;
+    zarena_block *large;      /* Allocations bigger than a block, newest first */
+    zarena_block *large_free; /* Large blocks released by reset/restore, reused first-fit */
+    uint8_t *vm_base;         /* Virtual mode: one reserved range, committed on demand */
+    size_t vm_reserved;
+    size_t vm_committed;
+    size_t vm_used;
 } zarena;
 
+/* Position to roll back to; restoring releases everything allocated after the save. */
+typedef struct zarena_mark 
+{
+    zarena_block *block;
+    size_t used;
+    zarena_block *large;
+    size_t total_alloc;
+} zarena_mark;
+
 ZALLOC_API void  zarena_init(zarena *a);
 ZALLOC_API void  zarena_free(zarena *a);
 ZALLOC_API void  zarena_reset(zarena *a);
@@ -85,6 +126,29 @@ ZALLOC_API void* zarena_alloc_align(zarena *a, size_t size, size_t align);
 ZALLOC_API void* zarena_alloc_zero(zarena *a, size_t size);
 ZALLOC_API void* zarena_realloc(zarena *a, void *old_ptr, size_t old_size, size_t new_size);
 
+/* * Reserves reserve_size bytes of address space and commits it on demand, so the arena is a
+ * single contiguous region that never moves. Returns 0 on success, -1 if unsupported or failed.
+ * Allocations past the reservation return NULL.
+*/
+ZALLOC_API int   zarena_init_virtual(zarena *a, size_t reserve_size);
+
+ZALLOC_API zarena_mark zarena_save(zarena *a);
+ZALLOC_API void        zarena_restore(zarena *a, zarena_mark m);
+
+/* Temporary scope: everything allocated inside the block is released on exit (do not break out of it). */
+#define ZARENA_SCOPE(a)                                                     \
+    for (zarena_mark z_scope_mark__ = zarena_save(a),                       \
+                     *z_scope_once__ = &z_scope_mark__;                     \
+         z_scope_once__;                                                    \
+         zarena_restore((a), z_scope_mark__), z_scope_once__ = NULL)
+
+/* Per-thread arena: created empty on first use, released by zarena_thread_free() (call it before the thread exits). */
+ZALLOC_API zarena* zarena_thread(void);
+ZALLOC_API void    zarena_thread_free(void);
+
+/* Frees are no-ops: the memory comes back with zarena_reset/zarena_free. */
+ZALLOC_API zalloc_t zarena_allocator(zarena *a);
+
 #define zarena_alloc_macro(ctx, sz)    zarena_alloc((zarena*)ctx, sz)
 #define zarena_calloc_macro(ctx, n, s) zarena_alloc_zero((zarena*)ctx, (n)*(s))
 #define zarena_free_macro(ctx, p)      /* no-op */
@@ -102,17 +166,34 @@ ZALLOC_API void* zarena_realloc(zarena *a, void *old_ptr, size_t old_size, size_
 
 /* * Z-POOL (fixed-block allocator)
  * Best for: stable maps, linked lists, graphs, millions of small objects.
- * AUTOMATICALLY ALIGNED to sizeof(void*) to prevent bus errors.
+ * AUTOMATICALLY ALIGNED like malloc (max_align_t), so any object type fits an item;
+ * zpool_init_aligned asks for more (SIMD vectors, cache lines).
 */
 #ifdef ZALLOC_ENABLE_POOL
 
+/* Alignment of max_align_t, what malloc guarantees. */
+#ifndef ZPOOL_MAX_ALIGN
+    #if defined(__cplusplus) && __cplusplus >= 201103L
+        #define ZPOOL_MAX_ALIGN alignof(max_align_t)
+    #elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(_MSC_VER)
+        #define ZPOOL_MAX_ALIGN _Alignof(max_align_t)
+    #else
+        #define ZPOOL_MAX_ALIGN (2 * sizeof(void*))
+    #endif
+#endif
+
 typedef struct zpool zpool;
 
 ZALLOC_API void  zpool_init(zpool *p, size_t item_size, size_t items_per_block);
+/* align must be a power of two; below ZPOOL_MAX_ALIGN it is raised to it. */
+ZALLOC_API void  zpool_init_aligned(zpool *p, size_t item_size, size_t items_per_block, size_t align);
 ZALLOC_API void  zpool_free(zpool *p);
 ZALLOC_API void* zpool_alloc(zpool *p);
 ZALLOC_API void  zpool_recycle(zpool *p, void *ptr);
 
+/* Serves requests up to item_size (list/tree nodes, stable map values); larger ones fail. */
+ZALLOC_API zalloc_t zpool_allocator(zpool *p);
+
 typedef struct zpool_node 
 {
     struct zpool_node *next;
@@ -121,6 +202,7 @@ typedef struct zpool_node
 struct zpool 
 {
     size_t item_size;      /* Aligned size */
+    size_t align;
     size_t count_per_block;
     zpool_node *head;      /* Free list head */
     void **blocks;         /* Array of allocated pages */
@@ -128,6 +210,48 @@ struct zpool
     size_t block_cap;
 };
 
+/* Empty zpool for struct literals (containers embedding one); keep it in step with the layout. */
+#define ZPOOL_INIT_ZERO__ { 0, 0, 0, NULL, NULL, 0, 0 }
+
+/* * Z-POOL-MT (thread-safe fixed-block allocator)
+ * One pool shared by many threads. Each thread allocates through its own zpool_cache and only
+ * touches the shared lock-free list once per ZPOOL_MT_BATCH items (tagged head, ABA-safe).
+ * Items are at least two pointers wide and aligned like malloc's. zpool_mt_free() needs every
+ * thread to be done with it.
+ * The tag shares a 64-bit word with the pointer, which must fit ZPOOL_MT_PTR_BITS (48 on
+ * 64-bit targets). Where malloc may return wider or tagged pointers (MTE, HWASan), define it
+ * to 64: the shared list is then guarded by a spinlock instead.
+*/
+#ifndef ZPOOL_MT_BATCH
+    #define ZPOOL_MT_BATCH 32
+#endif
+
+typedef struct zpool_mt 
+{
+    size_t item_size;
+    size_t count_per_block;
+    uint64_t free_batches; /* Tagged pointer to a stack of free batches */
+    uint64_t blocks;       /* Stack of allocated pages */
+    uint64_t lock;         /* Spinlock for free_batches when ZPOOL_MT_PTR_BITS is 64 */
+} zpool_mt;
+
+typedef struct zpool_cache 
+{
+    zpool_mt *pool;
+    zpool_node *head;      /* Thread-private free list */
+    size_t count;
+} zpool_cache;
+
+ZALLOC_API void  zpool_mt_init(zpool_mt *p, size_t item_size, size_t items_per_block);
+ZALLOC_API void  zpool_mt_free(zpool_mt *p);
+ZALLOC_API void* zpool_mt_alloc(zpool_mt *p);
+ZALLOC_API void  zpool_mt_recycle(zpool_mt *p, void *ptr);
+
+ZALLOC_API void  zpool_cache_init(zpool_cache *c, zpool_mt *p);
+ZALLOC_API void* zpool_cache_alloc(zpool_cache *c);
+ZALLOC_API void  zpool_cache_recycle(zpool_cache *c, void *ptr);
+ZALLOC_API void  zpool_cache_flush(zpool_cache *c);
+
 #endif /* ZALLOC_ENABLE_POOL */
 
 
@@ -161,6 +285,57 @@ ZALLOC_API void   zdebug_register_atexit(void);
 #define zdebug_calloc(n, sz)  zdebug_calloc_loc(n, sz, __FILE__, __LINE__)
 #define zdebug_realloc(p, sz) zdebug_realloc_loc(p, sz, __FILE__, __LINE__)
 
+/* * Z-PROF (sampling heap profiler)
+ * Cheap enough to leave on in production: one byte countdown per allocation, and only about one
+ * allocation per ZPROF_SAMPLE_RATE bytes (Poisson sampling) is attributed to its file:line in a
+ * per-thread table. Sampled sizes are scaled back up, so the live/peak figures estimate the
+ * whole heap. Define ZDEBUG_SAMPLING to route the zdebug_* calls above through the profiler.
+ * A thread's table is handed to the next new thread once it exits (POSIX and Windows), so
+ * thread churn does not grow the profiler past the peak thread count.
+*/
+#ifndef ZPROF_SAMPLE_RATE
+    #define ZPROF_SAMPLE_RATE (512 * 1024)
+#endif
+
+/* Distinct callsites tracked per thread; the rest are reported as "(other)". */
+#ifndef ZPROF_MAX_SITES
+    #define ZPROF_MAX_SITES 1024
+#endif
+
+typedef struct zprof_site_info 
+{
+    const char *file;
+    int line;
+    size_t live_bytes;  /* Estimated, like every figure below */
+    size_t live_count;
+    size_t peak_bytes;
+    size_t total_bytes;
+    size_t total_count;
+} zprof_site_info;
+
+typedef void (*zprof_visit_fn)(const zprof_site_info *site, void *user);
+
+ZALLOC_API void* zprof_malloc_loc(size_t size, const char *file, int line);
+ZALLOC_API void* zprof_calloc_loc(size_t count, size_t size, const char *file, int line);
+ZALLOC_API void* zprof_realloc_loc(void *ptr, size_t size, const char *file, int line);
+ZALLOC_API void  zprof_free(void *ptr);
+
+/* Mean bytes between samples; 0 stops sampling new allocations. */
+ZALLOC_API void   zprof_set_rate(size_t bytes);
+ZALLOC_API size_t zprof_live_bytes(void);
+ZALLOC_API size_t zprof_peak_bytes(void);
+
+/* Visits every site of every table, live heap included; a site hit from concurrent threads shows up once per thread. */
+ZALLOC_API void   zprof_foreach(zprof_visit_fn fn, void *user);
+/* Writes "file:line live_bytes" lines (collapsed-stack format for flamegraph.pl, speedscope...). Returns 0 on success. */
+ZALLOC_API int    zprof_write_collapsed(const char *path);
+/* Logs the live sites through ZDEBUG_LOG and returns how many there are. */
+ZALLOC_API size_t zprof_print(void);
+
+#define zprof_malloc(sz)     zprof_malloc_loc(sz, __FILE__, __LINE__)
+#define zprof_calloc(n, sz)  zprof_calloc_loc(n, sz, __FILE__, __LINE__)
+#define zprof_realloc(p, sz) zprof_realloc_loc(p, sz, __FILE__, __LINE__)
+
 #endif /* ZALLOC_ENABLE_DEBUG */
 
 #endif // ZALLOC_H
@@ -172,6 +347,61 @@ ZALLOC_API void   zdebug_register_atexit(void);
 #include <stdio.h>
 #include <assert.h>
 
+#ifndef ZALLOC_TLS
+    #if defined(__cplusplus)
+        #define ZALLOC_TLS thread_local
+    #elif defined(_MSC_VER)
+        #define ZALLOC_TLS __declspec(thread)
+    #elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+        #define ZALLOC_TLS _Thread_local
+    #else
+        #define ZALLOC_TLS __thread
+    #endif
+#endif
+
+/* Atomics shared by the pool and the profiler (load is acquire, store and add are relaxed). */
+#if defined(ZALLOC_ENABLE_POOL) || defined(ZALLOC_ENABLE_DEBUG)
+#ifndef ZALLOC_ATOMICS_GUARD
+#define ZALLOC_ATOMICS_GUARD
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+static inline uint64_t _zalloc_load64(uint64_t *p) 
+{
+    return (uint64_t)_InterlockedCompareExchange64((volatile __int64*)p, 0, 0);
+}
+static inline void _zalloc_store64(uint64_t *p, uint64_t v) 
+{
+    _InterlockedExchange64((volatile __int64*)p, (__int64)v);
+}
+static inline uint64_t _zalloc_add64(uint64_t *p, uint64_t v) 
+{
+    return (uint64_t)_InterlockedExchangeAdd64((volatile __int64*)p, (__int64)v) + v;
+}
+static inline int _zalloc_cas64(uint64_t *p, uint64_t expected, uint64_t desired) 
+{
+    return _InterlockedCompareExchange64((volatile __int64*)p, (__int64)desired, (__int64)expected) == (__int64)expected;
+}
+#else
+static inline uint64_t _zalloc_load64(uint64_t *p) 
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+static inline void _zalloc_store64(uint64_t *p, uint64_t v) 
+{
+    __atomic_store_n(p, v, __ATOMIC_RELAXED);
+}
+static inline uint64_t _zalloc_add64(uint64_t *p, uint64_t v) 
+{
+    return __atomic_add_fetch(p, v, __ATOMIC_RELAXED);
+}
+static inline int _zalloc_cas64(uint64_t *p, uint64_t expected, uint64_t desired) 
+{
+    return __atomic_compare_exchange_n(p, &expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+#endif
+#endif // ZALLOC_ATOMICS_GUARD
+#endif
+
 /* ZARENA. */
 #ifdef ZALLOC_ENABLE_ARENA
 #ifndef ZALLOC_ENABLE_ARENA_GUARD
@@ -191,6 +421,19 @@ static inline uintptr_t _zarena_align_ptr(uintptr_t ptr, size_t align)
     return (ptr + (align - 1)) & ~(align - 1);
 }
 
+#if defined(_WIN32)
+    #include <windows.h>
+    #define ZARENA_HAS_VIRTUAL
+#elif defined(__unix__) || defined(__APPLE__)
+    #include <sys/mman.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+        #define MAP_ANONYMOUS MAP_ANON
+    #endif
+    #define ZARENA_HAS_VIRTUAL
+#endif
+
 static zarena_block* _zarena_new_block(size_t cap) 
 {
     size_t total_sz = sizeof(zarena_block) + cap;
@@ -202,20 +445,131 @@ static zarena_block* _zarena_new_block(size_t cap)
     return b;
 }
 
+static void _zarena_free_chain(zarena_block *curr) 
+{
+    while (curr) 
+    {
+        zarena_block *next = curr->next;
+        Z_FREE(curr);
+        curr = next;
+    }
+}
+
+/* Moves the large blocks newer than 'keep' to the free list. */
+static void _zarena_release_large(zarena *a, zarena_block *keep) 
+{
+    while (a->large && a->large != keep) 
+    {
+        zarena_block *b = a->large;
+        a->large = b->next;
+        b->next = a->large_free;
+        a->large_free = b;
+    }
+}
+
+/* An allocation that would not fit the next block gets one of its own, off the main chain. */
+static void* _zarena_alloc_large(zarena *a, size_t size, size_t align) 
+{
+    size_t need = size + align;
+    zarena_block **link = &a->large_free;
+    zarena_block *b = NULL;
+
+    while (*link) 
+    {
+        if ((*link)->capacity >= need) 
+        {
+            b = *link;
+            *link = b->next;
+            break;
+        }
+        link = &(*link)->next;
+    }
+    if (!b && !(b = _zarena_new_block(need))) return NULL;
+
+    b->next  = a->large;
+    a->large = b;
+
+    uintptr_t base  = (uintptr_t)b->data;
+    uintptr_t start = _zarena_align_ptr(base, align);
+    b->used = size + (start - base);
+    a->total_alloc += size;
+    return (void*)start;
+}
+
+#ifdef ZARENA_HAS_VIRTUAL
+static int _zarena_vm_commit(zarena *a, size_t needed) 
+{
+    if (needed > a->vm_reserved) return -1;
+
+    size_t target = (needed + ZARENA_COMMIT_SIZE - 1) / ZARENA_COMMIT_SIZE * ZARENA_COMMIT_SIZE;
+    if (target > a->vm_reserved) target = a->vm_reserved;
+
+    uint8_t *start = a->vm_base + a->vm_committed;
+    size_t len = target - a->vm_committed;
+#if defined(_WIN32)
+    if (!VirtualAlloc(start, len, MEM_COMMIT, PAGE_READWRITE)) return -1;
+#else
+    if (0 != mprotect(start, len, PROT_READ | PROT_WRITE)) return -1;
+#endif
+    a->vm_committed = target;
+    return 0;
+}
+#endif
+
 ZALLOC_API void zarena_init(zarena *a) 
 {
     memset(a, 0, sizeof(zarena));
 }
 
+ZALLOC_API int zarena_init_virtual(zarena *a, size_t reserve_size) 
+{
+    memset(a, 0, sizeof(zarena));
+#ifdef ZARENA_HAS_VIRTUAL
+    if (0 == reserve_size) return -1;
+    size_t size = (reserve_size + ZARENA_COMMIT_SIZE - 1) / ZARENA_COMMIT_SIZE * ZARENA_COMMIT_SIZE;
+#if defined(_WIN32)
+    void *base = VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+    if (!base) return -1;
+#else
+    int flags = MAP_PRIVATE;
+#ifdef MAP_NORESERVE
+    flags |= MAP_NORESERVE;
+#endif
+#ifdef MAP_ANONYMOUS
+    void *base = mmap(NULL, size, PROT_NONE, flags | MAP_ANONYMOUS, -1, 0);
+#else
+    /* Strict ISO modes hide MAP_ANONYMOUS; a private /dev/zero mapping is equivalent. */
+    int fd = open("/dev/zero", O_RDWR);
+    if (fd < 0) return -1;
+    void *base = mmap(NULL, size, PROT_NONE, flags, fd, 0);
+    close(fd);
+#endif
+    if (MAP_FAILED == base) return -1;
+#endif
+    a->vm_base = (uint8_t*)base;
+    a->vm_reserved = size;
+    return 0;
+#else
+    (void)reserve_size;
+    return -1;
+#endif
+}
+
 ZALLOC_API void zarena_free(zarena *a) 
 {
-    zarena_block *curr = a->first;
-    while (curr) 
+#ifdef ZARENA_HAS_VIRTUAL
+    if (a->vm_base) 
     {
-        zarena_block *next = curr->next;
-        Z_FREE(curr);
-        curr = next;
+#if defined(_WIN32)
+        VirtualFree(a->vm_base, 0, MEM_RELEASE);
+#else
+        munmap(a->vm_base, a->vm_reserved);
+#endif
     }
+#endif
+    _zarena_free_chain(a->first);
+    _zarena_free_chain(a->large);
+    _zarena_free_chain(a->large_free);
     memset(a, 0, sizeof(zarena));
 }
 
@@ -226,6 +580,7 @@ ZALLOC_API void zarena_free_ptr(zarena **a) {
 }
 #endif
 
+/* Keeps every block (and the committed pages) so the next cycle allocates nothing. */
 ZALLOC_API void zarena_reset(zarena *a) 
 {
     zarena_block *curr = a->first;
@@ -236,12 +591,60 @@ ZALLOC_API void zarena_reset(zarena *a)
     }
     a->head = a->first;
     a->total_alloc = 0;
+    a->vm_used = 0;
+    _zarena_release_large(a, NULL);
+}
+
+ZALLOC_API zarena_mark zarena_save(zarena *a) 
+{
+    zarena_mark m;
+    m.block = a->head;
+    m.used  = a->vm_base ? a->vm_used : (a->head ? a->head->used : 0);
+    m.large = a->large;
+    m.total_alloc = a->total_alloc;
+    return m;
+}
+
+ZALLOC_API void zarena_restore(zarena *a, zarena_mark m) 
+{
+    if (a->vm_base) 
+    {
+        a->vm_used = m.used;
+    }
+    else if (m.block) 
+    {
+        /* Blocks after the mark are reset when the bump pointer reaches them again. */
+        a->head = m.block;
+        a->head->used = m.used;
+    }
+    else if (a->first) 
+    {
+        a->head = a->first;
+        a->head->used = 0;
+    }
+    _zarena_release_large(a, m.large);
+    a->total_alloc = m.total_alloc;
 }
 
 ZALLOC_API void* zarena_alloc_align(zarena *a, size_t size, size_t align) 
 {
     if (size == 0) return NULL;
 
+#ifdef ZARENA_HAS_VIRTUAL
+    if (a->vm_base) 
+    {
+        uintptr_t curr = (uintptr_t)a->vm_base + a->vm_used;
+        uintptr_t next = _zarena_align_ptr(curr, align);
+        size_t needed  = size + (next - curr);
+
+        if (needed > a->vm_reserved - a->vm_used) return NULL;
+        if (a->vm_used + needed > a->vm_committed && 0 != _zarena_vm_commit(a, a->vm_used + needed)) return NULL;
+        a->vm_used     += needed;
+        a->total_alloc += size;
+        return (void*)next;
+    }
+#endif
+
     if (a->head) 
     {
         uintptr_t base = (uintptr_t)a->head->data;
@@ -275,7 +678,11 @@ ZALLOC_API void* zarena_alloc_align(zarena *a, size_t size, size_t align)
     }
 
     size_t next_cap = (a->head ? a->head->capacity * 2 : ZARENA_DEFAULT_BLOCK_SIZE);
-    if (next_cap < size + align) next_cap = size + align;
+    if (next_cap > ZARENA_MAX_BLOCK_SIZE) next_cap = ZARENA_MAX_BLOCK_SIZE;
+    if (next_cap < ZARENA_DEFAULT_BLOCK_SIZE) next_cap = ZARENA_DEFAULT_BLOCK_SIZE;
+    
+    /* Oversized requests do not get to set the growth rate or strand the head's free space. */
+    if (size + align > next_cap) return _zarena_alloc_large(a, size, align);
 
     zarena_block *b = _zarena_new_block(next_cap);
     if (!b) return NULL;
@@ -312,6 +719,15 @@ ZALLOC_API void* zarena_alloc_zero(zarena *a, size_t size)
     return p;
 }
 
+/* Grows in place when old_ptr is the latest allocation of its block (or of the virtual range). */
+static int _zarena_extend_last(zarena_block *b, uintptr_t old_p, size_t old_size, size_t diff) 
+{
+    if (!b || old_p + old_size != (uintptr_t)b->data + b->used) return 0;
+    if (b->used + diff > b->capacity) return 0;
+    b->used += diff;
+    return 1;
+}
+
 ZALLOC_API void* zarena_realloc(zarena *a, void *old_ptr, size_t old_size, size_t new_size) 
 {
     if (!old_ptr) return zarena_alloc(a, new_size);
@@ -319,27 +735,65 @@ ZALLOC_API void* zarena_realloc(zarena *a, void *old_ptr, size_t old_size, size_
     
     if (new_size <= old_size) return old_ptr;
 
-    if (a->head) 
+    uintptr_t old_p = (uintptr_t)old_ptr;
+    size_t diff = new_size - old_size;
+
+#ifdef ZARENA_HAS_VIRTUAL
+    if (a->vm_base && old_p + old_size == (uintptr_t)a->vm_base + a->vm_used) 
     {
-        uintptr_t old_p = (uintptr_t)old_ptr;
-        uintptr_t data_end = (uintptr_t)a->head->data + a->head->used;
-   
-        if (old_p + old_size == data_end) 
-        {
-            size_t diff = new_size - old_size;
-            if (a->head->used + diff <= a->head->capacity) 
-            {
-                a->head->used  += diff;
-                a->total_alloc += diff;
-                return old_ptr;
-            }
-        }
+        if (diff > a->vm_reserved - a->vm_used) return NULL;
+        if (a->vm_used + diff > a->vm_committed && 0 != _zarena_vm_commit(a, a->vm_used + diff)) return NULL;
+        a->vm_used     += diff;
+        a->total_alloc += diff;
+        return old_ptr;
+    }
+#endif
+
+    if (_zarena_extend_last(a->head, old_p, old_size, diff) ||
+        _zarena_extend_last(a->large, old_p, old_size, diff)) 
+    {
+        a->total_alloc += diff;
+        return old_ptr;
     }
 
     void *new_ptr = zarena_alloc(a, new_size);
     if (new_ptr) memcpy(new_ptr, old_ptr, old_size);
     return new_ptr;
 }
+
+/* All-zero is a valid empty arena, so the TLS slot needs no explicit init. */
+static ZALLOC_TLS zarena g_zarena_thread;
+
+ZALLOC_API zarena* zarena_thread(void) 
+{
+    return &g_zarena_thread;
+}
+
+ZALLOC_API void zarena_thread_free(void) 
+{
+    zarena_free(&g_zarena_thread);
+}
+
+static void* _zarena_h_alloc(void *ctx, size_t size) 
+{
+    return zarena_alloc((zarena*)ctx, size);
+}
+
+static void* _zarena_h_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size) 
+{
+    return zarena_realloc((zarena*)ctx, ptr, old_size, new_size);
+}
+
+static void _zarena_h_free(void *ctx, void *ptr, size_t size) 
+{
+    (void)ctx; (void)ptr; (void)size;
+}
+
+ZALLOC_API zalloc_t zarena_allocator(zarena *a) 
+{
+    zalloc_t h = { _zarena_h_alloc, _zarena_h_realloc, _zarena_h_free, a };
+    return h;
+}
 #endif // ZALLOC_ENABLE_ARENA_GUARD
 #endif // ZALLOC_ENABLE_ARENA
 
@@ -350,13 +804,20 @@ ZALLOC_API void* zarena_realloc(zarena *a, void *old_ptr, size_t old_size, size_
 #define ZALLOC_ENABLE_POOL_GUARD
 
 ZALLOC_API void zpool_init(zpool *p, size_t item_size, size_t items_per_block) 
+{
+    zpool_init_aligned(p, item_size, items_per_block, ZPOOL_MAX_ALIGN);
+}
+
+ZALLOC_API void zpool_init_aligned(zpool *p, size_t item_size, size_t items_per_block, size_t align) 
 {
     memset(p, 0, sizeof(zpool));
     
-    size_t align = sizeof(void*);
+    assert((align & (align - 1)) == 0);
+    if (align < ZPOOL_MAX_ALIGN) align = ZPOOL_MAX_ALIGN;
     if (item_size < sizeof(zpool_node*)) item_size = sizeof(zpool_node*);
     
     p->item_size = (item_size + (align - 1)) & ~(align - 1);
+    p->align = align;
     p->count_per_block = (items_per_block < 1) ? 64 : items_per_block;
 }
 
@@ -372,9 +833,13 @@ ZALLOC_API void zpool_free(zpool *p)
 
 static void _zpool_grow(zpool *p) 
 {
-    size_t block_mem_size = p->item_size * p->count_per_block;
-    uint8_t *block = (uint8_t*)Z_MALLOC(block_mem_size);
-    if (!block) return;
+    /* malloc already gives ZPOOL_MAX_ALIGN; a larger alignment pads the block. blocks[] keeps
+     * what Z_MALLOC returned. */
+    size_t pad = (p->align > ZPOOL_MAX_ALIGN) ? p->align - 1 : 0;
+    size_t block_mem_size = p->item_size * p->count_per_block + pad;
+    uint8_t *raw = (uint8_t*)Z_MALLOC(block_mem_size);
+    if (!raw) return;
+    uint8_t *block = raw + ((p->align - ((uintptr_t)raw & (p->align - 1))) & (p->align - 1));
 
     if (p->block_count == p->block_cap) 
     {
@@ -382,13 +847,13 @@ static void _zpool_grow(zpool *p)
         void **new_list = (void**)Z_REALLOC(p->blocks, new_cap * sizeof(void*));
         if (!new_list) 
         { 
-            Z_FREE(block); 
+            Z_FREE(raw); 
             return; 
         }
         p->blocks = new_list;
         p->block_cap = new_cap;
     }
-    p->blocks[p->block_count++] = block;
+    p->blocks[p->block_count++] = raw;
 
     for (size_t i = 0; i < p->count_per_block - 1; i++) 
     {
@@ -420,6 +885,282 @@ ZALLOC_API void zpool_recycle(zpool *p, void *ptr)
     node->next = p->head;
     p->head = node;
 }
+
+static void* _zpool_h_alloc(void *ctx, size_t size) 
+{
+    zpool *p = (zpool*)ctx;
+    return (size <= p->item_size) ? zpool_alloc(p) : NULL;
+}
+
+static void* _zpool_h_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size) 
+{
+    (void)old_size;
+    if (!ptr) return _zpool_h_alloc(ctx, new_size);
+    return (new_size <= ((zpool*)ctx)->item_size) ? ptr : NULL;
+}
+
+static void _zpool_h_free(void *ctx, void *ptr, size_t size) 
+{
+    (void)size;
+    zpool_recycle((zpool*)ctx, ptr);
+}
+
+ZALLOC_API zalloc_t zpool_allocator(zpool *p) 
+{
+    zalloc_t h = { _zpool_h_alloc, _zpool_h_realloc, _zpool_h_free, p };
+    return h;
+}
+
+/* ZPOOL-MT. */
+
+/* * Tagged head: user-space pointers fit in 48 bits on 64-bit targets (32 on 32-bit ones),
+ * the bits above count pushes so a stale head can never be swapped back in (ABA).
+ * Pointer tagging puts bits up there, so it gets the spinlocked list (ZPOOL_MT_PTR_BITS 64).
+*/
+#ifndef ZPOOL_MT_PTR_BITS
+    #if defined(__has_feature)
+        #if __has_feature(hwaddress_sanitizer)
+            #define ZPOOL_MT_HWTAGS__
+        #endif
+    #endif
+    #if defined(__ARM_FEATURE_MEMORY_TAGGING) || defined(__SANITIZE_HWADDRESS__)
+        #define ZPOOL_MT_HWTAGS__
+    #endif
+    #if !(UINTPTR_MAX > 0xFFFFFFFFu)
+        #define ZPOOL_MT_PTR_BITS 32
+    #elif defined(ZPOOL_MT_HWTAGS__)
+        #define ZPOOL_MT_PTR_BITS 64
+    #else
+        #define ZPOOL_MT_PTR_BITS 48
+    #endif
+#endif
+#if ZPOOL_MT_PTR_BITS >= 64
+    #define ZPOOL_MT_PTR_MASK (~(uint64_t)0)
+#else
+    #define ZPOOL_MT_PTR_MASK ((((uint64_t)1) << ZPOOL_MT_PTR_BITS) - 1)
+#endif
+
+/* First node of every batch on the shared stack; the rest hang off node.next. */
+typedef struct zpool_batch 
+{
+    zpool_node node;
+    uint64_t next_batch;   /* Read racily by _zpool_mt_pop, hence atomic */
+} zpool_batch;
+
+/* Pages are chained through a header that keeps the items as aligned as malloc's. */
+#define ZPOOL_MT_BLOCK_HEADER (ZPOOL_MAX_ALIGN > 16 ? ZPOOL_MAX_ALIGN : 16)
+
+static inline zpool_batch* _zpool_mt_ptr(uint64_t v) 
+{
+    return (zpool_batch*)(uintptr_t)(v & ZPOOL_MT_PTR_MASK);
+}
+
+#if ZPOOL_MT_PTR_BITS >= 64
+/* No room for a tag: a spinlock keeps the list consistent instead. */
+static void _zpool_mt_lock(zpool_mt *p) 
+{
+    while (!_zalloc_cas64(&p->lock, 0, 1)) 
+    {
+        while (_zalloc_load64(&p->lock)) 
+        {
+        }
+    }
+}
+
+static void _zpool_mt_unlock(zpool_mt *p) 
+{
+    _zalloc_cas64(&p->lock, 1, 0);
+}
+
+static void _zpool_mt_push(zpool_mt *p, zpool_node *batch) 
+{
+    zpool_batch *b = (zpool_batch*)batch;
+    _zpool_mt_lock(p);
+    _zalloc_store64(&b->next_batch, p->free_batches);
+    p->free_batches = (uint64_t)(uintptr_t)b;
+    _zpool_mt_unlock(p);
+}
+
+static zpool_node* _zpool_mt_pop(zpool_mt *p) 
+{
+    _zpool_mt_lock(p);
+    zpool_batch *b = _zpool_mt_ptr(p->free_batches);
+    if (b) p->free_batches = _zalloc_load64(&b->next_batch);
+    _zpool_mt_unlock(p);
+    return b ? &b->node : NULL;
+}
+#else
+static void _zpool_mt_push(zpool_mt *p, zpool_node *batch) 
+{
+    zpool_batch *b = (zpool_batch*)batch;
+    for (;;) 
+    {
+        uint64_t old = _zalloc_load64(&p->free_batches);
+        _zalloc_store64(&b->next_batch, old & ZPOOL_MT_PTR_MASK);
+        uint64_t tag = (old >> ZPOOL_MT_PTR_BITS) + 1;
+        if (_zalloc_cas64(&p->free_batches, old, (uint64_t)(uintptr_t)b | (tag << ZPOOL_MT_PTR_BITS))) return;
+    }
+}
+
+static zpool_node* _zpool_mt_pop(zpool_mt *p) 
+{
+    for (;;) 
+    {
+        uint64_t old = _zalloc_load64(&p->free_batches);
+        zpool_batch *b = _zpool_mt_ptr(old);
+        if (!b) return NULL;
+        /* b may already be owned by another thread; pages are never unmapped, and the tag makes the CAS fail then. */
+        uint64_t next = _zalloc_load64(&b->next_batch) & ZPOOL_MT_PTR_MASK;
+        uint64_t tag = (old >> ZPOOL_MT_PTR_BITS) + 1;
+        if (_zalloc_cas64(&p->free_batches, old, next | (tag << ZPOOL_MT_PTR_BITS))) 
+        {
+            return &b->node;
+        }
+    }
+}
+#endif
+
+/* Allocates a page and returns its items as one chain (count_per_block long). */
+static zpool_node* _zpool_mt_grow(zpool_mt *p) 
+{
+    size_t size = ZPOOL_MT_BLOCK_HEADER + p->item_size * p->count_per_block;
+    uint8_t *block = (uint8_t*)Z_MALLOC(size);
+    if (!block) return NULL;
+    /* A page the tagged head cannot address would corrupt the list: fail the allocation. */
+    if ((uint64_t)((uintptr_t)block + size - 1) > ZPOOL_MT_PTR_MASK) 
+    {
+        assert(!"zpool_mt: pointer wider than ZPOOL_MT_PTR_BITS, define it to 64");
+        Z_FREE(block);
+        return NULL;
+    }
+
+    for (;;) 
+    {
+        uint64_t old = _zalloc_load64(&p->blocks);
+        *(uint64_t*)block = old;
+        if (_zalloc_cas64(&p->blocks, old, (uint64_t)(uintptr_t)block)) break;
+    }
+
+    uint8_t *items = block + ZPOOL_MT_BLOCK_HEADER;
+    for (size_t i = 0; i < p->count_per_block - 1; i++) 
+    {
+        zpool_node *node = (zpool_node*)(items + (i * p->item_size));
+        node->next = (zpool_node*)(items + ((i + 1) * p->item_size));
+    }
+    ((zpool_node*)(items + ((p->count_per_block - 1) * p->item_size)))->next = NULL;
+    return (zpool_node*)items;
+}
+
+/* Detaches up to n nodes from the front of *head; returns the detached chain. */
+static zpool_node* _zpool_mt_split(zpool_node **head, size_t n, size_t *taken) 
+{
+    zpool_node *first = *head;
+    zpool_node *last = first;
+    size_t k = 1;
+    while (k < n && last->next) 
+    {
+        last = last->next;
+        k++;
+    }
+    *head = last->next;
+    last->next = NULL;
+    *taken = k;
+    return first;
+}
+
+ZALLOC_API void zpool_mt_init(zpool_mt *p, size_t item_size, size_t items_per_block) 
+{
+    memset(p, 0, sizeof(zpool_mt));
+
+    size_t align = ZPOOL_MAX_ALIGN;
+    if (item_size < sizeof(zpool_batch)) item_size = sizeof(zpool_batch);
+
+    p->item_size = (item_size + (align - 1)) & ~(align - 1);
+    p->count_per_block = (items_per_block < 1) ? 64 : items_per_block;
+}
+
+ZALLOC_API void zpool_mt_free(zpool_mt *p) 
+{
+    uint8_t *block = (uint8_t*)(uintptr_t)p->blocks;
+    while (block) 
+    {
+        uint8_t *next = (uint8_t*)(uintptr_t)*(uint64_t*)block;
+        Z_FREE(block);
+        block = next;
+    }
+    memset(p, 0, sizeof(zpool_mt));
+}
+
+ZALLOC_API void* zpool_mt_alloc(zpool_mt *p) 
+{
+    zpool_node *chain = _zpool_mt_pop(p);
+    if (!chain) chain = _zpool_mt_grow(p);
+    if (!chain) return NULL;
+    if (chain->next) _zpool_mt_push(p, chain->next);
+    return (void*)chain;
+}
+
+ZALLOC_API void zpool_mt_recycle(zpool_mt *p, void *ptr) 
+{
+    if (!ptr) return;
+    zpool_node *node = (zpool_node*)ptr;
+    node->next = NULL;
+    _zpool_mt_push(p, node);
+}
+
+ZALLOC_API void zpool_cache_init(zpool_cache *c, zpool_mt *p) 
+{
+    c->pool = p;
+    c->head = NULL;
+    c->count = 0;
+}
+
+ZALLOC_API void* zpool_cache_alloc(zpool_cache *c) 
+{
+    if (!c->head) 
+    {
+        zpool_node *chain = _zpool_mt_pop(c->pool);
+        if (!chain) chain = _zpool_mt_grow(c->pool);
+        if (!chain) return NULL;
+        size_t n = 0;
+        for (zpool_node *it = chain; it; it = it->next) n++;
+        c->head = chain;
+        c->count = n;
+    }
+    zpool_node *node = c->head;
+    c->head = node->next;
+    c->count--;
+    return (void*)node;
+}
+
+ZALLOC_API void zpool_cache_recycle(zpool_cache *c, void *ptr) 
+{
+    if (!ptr) return;
+    zpool_node *node = (zpool_node*)ptr;
+    node->next = c->head;
+    c->head = node;
+    /* Keep one batch cached for the next allocs and hand the one behind it back. */
+    if (++c->count >= 2 * ZPOOL_MT_BATCH) 
+    {
+        zpool_node *last = c->head;
+        for (size_t i = 1; i < ZPOOL_MT_BATCH; i++) last = last->next;
+        size_t taken = 0;
+        zpool_node *batch = _zpool_mt_split(&last->next, ZPOOL_MT_BATCH, &taken);
+        _zpool_mt_push(c->pool, batch);
+        c->count -= taken;
+    }
+}
+
+ZALLOC_API void zpool_cache_flush(zpool_cache *c) 
+{
+    while (c->head) 
+    {
+        size_t taken = 0;
+        zpool_node *batch = _zpool_mt_split(&c->head, ZPOOL_MT_BATCH, &taken);
+        _zpool_mt_push(c->pool, batch);
+    }
+    c->count = 0;
+}
 #endif // ZALLOC_ENABLE_POOL_GUARD
 #endif // ZALLOC_ENABLE_POOL
 
@@ -429,6 +1170,445 @@ ZALLOC_API void zpool_recycle(zpool *p, void *ptr)
 #ifndef ZALLOC_ENABLE_DEBUG_GUARD
 #define ZALLOC_ENABLE_DEBUG_GUARD
 
+/* ZPROF. */
+
+/* Every block starts with a tag right before the user pointer (site is NULL when not sampled). */
+typedef struct zprof_tag 
+{
+    struct zprof_site *site;
+    size_t size;
+} zprof_tag;
+
+/* Sampled blocks also keep the estimate they added, so the freeing thread can take it back. */
+typedef struct zprof_sample 
+{
+    uint64_t weight;
+    uint64_t count;
+} zprof_sample;
+
+#define ZPROF_TAG_SPACE    16 /* Keeps the user pointer as aligned as malloc's */
+#define ZPROF_SAMPLE_SPACE 16
+
+typedef struct zprof_site 
+{
+    uint64_t file;         /* Published last, 0 marks a free slot */
+    int line;
+    uint64_t live_bytes;
+    uint64_t live_count;
+    uint64_t peak_bytes;
+    uint64_t total_bytes;
+    uint64_t total_count;
+} zprof_site;
+
+/* Owned by one thread at a time (it alone inserts), read by dumps; never freed since live blocks
+ * point into it. An exiting thread clears owned and the next thread without a table adopts it. */
+typedef struct zprof_table 
+{
+    struct zprof_table *next;
+    uint64_t owned;
+    zprof_site other;
+    zprof_site sites[ZPROF_MAX_SITES];
+} zprof_table;
+
+typedef struct zprof_thread 
+{
+    zprof_table *table;
+    uint64_t rng;
+    int64_t countdown;     /* Bytes left before the next sample */
+    int ready;
+} zprof_thread;
+
+static ZALLOC_TLS zprof_thread g_zprof_thread;
+static uint64_t g_zprof_tables = 0;
+static uint64_t g_zprof_rate = ZPROF_SAMPLE_RATE;
+static uint64_t g_zprof_live = 0;
+static uint64_t g_zprof_peak = 0;
+
+static uint64_t _zprof_rand(uint64_t *state) 
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/* ln(x) for x in (0, 1] without libm: exponent from the bits, then an atanh series on the mantissa. */
+static double _zprof_log(double x) 
+{
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    int e = (int)((bits >> 52) & 0x7FF) - 1023;
+    bits = (bits & 0x000FFFFFFFFFFFFFull) | 0x3FF0000000000000ull;
+    double m;
+    memcpy(&m, &bits, sizeof(m));
+    double t = (m - 1.0) / (m + 1.0), t2 = t * t;
+    return e * 0.69314718055994531 + 2.0 * t * (1.0 + t2 * (1.0 / 3 + t2 * (1.0 / 5 + t2 * (1.0 / 7 + t2 / 9))));
+}
+
+/* Exponentially distributed gap, so sample points form a Poisson process over allocated bytes. */
+static int64_t _zprof_gap(zprof_thread *t, uint64_t rate) 
+{
+    double u = (double)((_zprof_rand(&t->rng) >> 11) + 1) * (1.0 / 9007199254740992.0);
+    return (int64_t)(-_zprof_log(u) * (double)rate) + 1;
+}
+
+/* Estimated bytes this allocation stands for: rate per sample point it covers, usually 0. */
+static uint64_t _zprof_weight(size_t size) 
+{
+    zprof_thread *t = &g_zprof_thread;
+    uint64_t rate = _zalloc_load64(&g_zprof_rate);
+    if (0 == rate) return 0;
+    if (!t->ready) 
+    {
+        t->rng = (uint64_t)(uintptr_t)t ^ 0x2545F4914F6CDD1Dull;
+        t->countdown = _zprof_gap(t, rate);
+        t->ready = 1;
+    }
+
+    t->countdown -= (int64_t)size;
+    if (t->countdown > 0) return 0;
+
+    uint64_t points = 0;
+    while (t->countdown <= 0) 
+    {
+        points++;
+        t->countdown += _zprof_gap(t, rate);
+    }
+    return points * rate;
+}
+
+/* Thread exit hook: hands the table back. Later allocations from other exit handlers just
+ * adopt (or create) a table again and re-arm the hook. */
+static void _zprof_thread_exit(void *table) 
+{
+    zprof_table *tb = (zprof_table*)table;
+    if (tb && g_zprof_thread.table == tb) 
+    {
+        g_zprof_thread.table = NULL;
+        _zalloc_cas64(&tb->owned, 1, 0);
+    }
+}
+
+#if defined(_WIN32)
+#include <windows.h>
+static DWORD g_zprof_fls = FLS_OUT_OF_INDEXES;
+static uint64_t g_zprof_fls_state = 0; /* 0 unset, 1 being set, 2 ready */
+
+static void NTAPI _zprof_fls_exit(void *table) 
+{
+    _zprof_thread_exit(table);
+}
+
+static void _zprof_watch(zprof_table *tb) 
+{
+    if (2 != _zalloc_load64(&g_zprof_fls_state)) 
+    {
+        if (_zalloc_cas64(&g_zprof_fls_state, 0, 1)) 
+        {
+            g_zprof_fls = FlsAlloc(_zprof_fls_exit);
+            _zalloc_cas64(&g_zprof_fls_state, 1, 2);
+        }
+        while (2 != _zalloc_load64(&g_zprof_fls_state)) SwitchToThread();
+    }
+    if (FLS_OUT_OF_INDEXES != g_zprof_fls) FlsSetValue(g_zprof_fls, tb);
+}
+#elif defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+static pthread_key_t g_zprof_key;
+static int g_zprof_key_ok = 0;
+static pthread_once_t g_zprof_once = PTHREAD_ONCE_INIT;
+
+static void _zprof_make_key(void) 
+{
+    g_zprof_key_ok = (0 == pthread_key_create(&g_zprof_key, _zprof_thread_exit));
+}
+
+static void _zprof_watch(zprof_table *tb) 
+{
+    pthread_once(&g_zprof_once, _zprof_make_key);
+    if (g_zprof_key_ok) pthread_setspecific(g_zprof_key, tb);
+}
+#else
+/* No exit hook: every thread keeps its own table. */
+static void _zprof_watch(zprof_table *tb) 
+{
+    (void)tb;
+}
+#endif
+
+/* A table left by an exited thread, else a fresh one. */
+static zprof_table* _zprof_adopt(void) 
+{
+    zprof_table *tb = (zprof_table*)(uintptr_t)_zalloc_load64(&g_zprof_tables);
+    for (; tb; tb = tb->next) 
+    {
+        if (0 == _zalloc_load64(&tb->owned) && _zalloc_cas64(&tb->owned, 0, 1)) return tb;
+    }
+
+    tb = (zprof_table*)calloc(1, sizeof(zprof_table));
+    if (!tb) return NULL;
+    tb->owned = 1;
+    tb->other.file = (uint64_t)(uintptr_t)"(other)";
+    uint64_t head;
+    do 
+    {
+        head = _zalloc_load64(&g_zprof_tables);
+        tb->next = (zprof_table*)(uintptr_t)head;
+    } while (!_zalloc_cas64(&g_zprof_tables, head, (uint64_t)(uintptr_t)tb));
+    return tb;
+}
+
+static zprof_site* _zprof_site(const char *file, int line) 
+{
+    zprof_thread *t = &g_zprof_thread;
+    if (!t->table) 
+    {
+        t->table = _zprof_adopt();
+        if (!t->table) return NULL;
+        _zprof_watch(t->table);
+    }
+
+    uint64_t key = (uint64_t)(uintptr_t)file;
+    size_t h = (size_t)(((key >> 3) ^ ((uint64_t)(unsigned)line * 0x9E3779B97F4A7C15ull)) % ZPROF_MAX_SITES);
+    for (size_t probe = 0; probe < ZPROF_MAX_SITES; probe++) 
+    {
+        zprof_site *s = &t->table->sites[(h + probe) % ZPROF_MAX_SITES];
+        if (0 == s->file) 
+        {
+            s->line = line;
+            _zalloc_cas64(&s->file, 0, key);
+            return s;
+        }
+        if (key == s->file && line == s->line) return s;
+    }
+    return &t->table->other;
+}
+
+static void _zprof_raise(uint64_t *peak, uint64_t value) 
+{
+    uint64_t curr = _zalloc_load64(peak);
+    while (value > curr && !_zalloc_cas64(peak, curr, value)) curr = _zalloc_load64(peak);
+}
+
+static void _zprof_account(zprof_site *s, uint64_t weight, uint64_t count) 
+{
+    _zprof_raise(&s->peak_bytes, _zalloc_add64(&s->live_bytes, weight));
+    _zalloc_add64(&s->live_count, count);
+    _zalloc_add64(&s->total_bytes, weight);
+    _zalloc_add64(&s->total_count, count);
+    _zprof_raise(&g_zprof_peak, _zalloc_add64(&g_zprof_live, weight));
+}
+
+static void _zprof_release(zprof_site *s, uint64_t weight, uint64_t count) 
+{
+    _zalloc_add64(&s->live_bytes, (uint64_t)0 - weight);
+    _zalloc_add64(&s->live_count, (uint64_t)0 - count);
+    _zalloc_add64(&g_zprof_live, (uint64_t)0 - weight);
+}
+
+static size_t _zprof_front(const zprof_site *site) 
+{
+    return ZPROF_TAG_SPACE + (site ? ZPROF_SAMPLE_SPACE : 0);
+}
+
+/* Writes the tag (and sample) into a fresh block and returns the user pointer. */
+static void* _zprof_attach(uint8_t *base, size_t size, zprof_site *site, uint64_t weight) 
+{
+    uint8_t *user = base + _zprof_front(site);
+    zprof_tag *tag = ((zprof_tag*)user) - 1;
+    tag->site = site;
+    tag->size = size;
+    if (site) 
+    {
+        zprof_sample *smp = (zprof_sample*)base;
+        smp->weight = weight;
+        smp->count  = weight / size ? weight / size : 1;
+        _zprof_account(site, smp->weight, smp->count);
+    }
+    return user;
+}
+
+static uint8_t* _zprof_base(void *ptr) 
+{
+    zprof_tag *tag = ((zprof_tag*)ptr) - 1;
+    return (uint8_t*)ptr - _zprof_front(tag->site);
+}
+
+ZALLOC_API void* zprof_malloc_loc(size_t size, const char *file, int line) 
+{
+    if (size == 0 || size > SIZE_MAX - ZPROF_TAG_SPACE - ZPROF_SAMPLE_SPACE) return NULL;
+
+    uint64_t weight = _zprof_weight(size);
+    zprof_site *site = weight ? _zprof_site(file, line) : NULL;
+    uint8_t *base = (uint8_t*)malloc(_zprof_front(site) + size);
+    if (!base) return NULL;
+    return _zprof_attach(base, size, site, weight);
+}
+
+ZALLOC_API void* zprof_calloc_loc(size_t count, size_t size, const char *file, int line) 
+{
+    if (size && count > SIZE_MAX / size) return NULL;
+    void *ptr = zprof_malloc_loc(count * size, file, line);
+    if (ptr) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+ZALLOC_API void zprof_free(void *ptr) 
+{
+    if (!ptr) return;
+    zprof_tag *tag = ((zprof_tag*)ptr) - 1;
+    uint8_t *base = _zprof_base(ptr);
+    if (tag->site) 
+    {
+        zprof_sample *smp = (zprof_sample*)base;
+        _zprof_release(tag->site, smp->weight, smp->count);
+    }
+    free(base);
+}
+
+/* A resize is sampled like a fresh allocation of the new size. */
+ZALLOC_API void* zprof_realloc_loc(void *ptr, size_t size, const char *file, int line) 
+{
+    if (!ptr) return zprof_malloc_loc(size, file, line);
+    if (size == 0) 
+    { 
+        zprof_free(ptr); 
+        return NULL; 
+    }
+    if (size > SIZE_MAX - ZPROF_TAG_SPACE - ZPROF_SAMPLE_SPACE) return NULL;
+
+    zprof_tag *tag = ((zprof_tag*)ptr) - 1;
+    uint64_t weight = _zprof_weight(size);
+    zprof_site *site = weight ? _zprof_site(file, line) : NULL;
+
+    if (!tag->site && !site) 
+    {
+        uint8_t *base = (uint8_t*)realloc(_zprof_base(ptr), ZPROF_TAG_SPACE + size);
+        if (!base) return NULL;
+        return _zprof_attach(base, size, NULL, 0);
+    }
+
+    /* The header layout changes (or must be re-accounted): move to a fresh block. */
+    uint8_t *base = (uint8_t*)malloc(_zprof_front(site) + size);
+    if (!base) return NULL;
+    size_t keep = tag->size < size ? tag->size : size;
+    void *user = _zprof_attach(base, size, site, weight);
+    memcpy(user, ptr, keep);
+    zprof_free(ptr);
+    return user;
+}
+
+ZALLOC_API void zprof_set_rate(size_t bytes) 
+{
+    _zalloc_store64(&g_zprof_rate, (uint64_t)bytes);
+}
+
+ZALLOC_API size_t zprof_live_bytes(void) 
+{
+    return (size_t)_zalloc_load64(&g_zprof_live);
+}
+
+ZALLOC_API size_t zprof_peak_bytes(void) 
+{
+    return (size_t)_zalloc_load64(&g_zprof_peak);
+}
+
+static void _zprof_visit(zprof_site *s, zprof_visit_fn fn, void *user) 
+{
+    uint64_t file = _zalloc_load64(&s->file);
+    if (0 == file) return;
+
+    zprof_site_info info;
+    info.file = (const char*)(uintptr_t)file;
+    info.line = s->line;
+    info.total_count = (size_t)_zalloc_load64(&s->total_count);
+    if (0 == info.total_count) return;
+    info.live_bytes  = (size_t)_zalloc_load64(&s->live_bytes);
+    info.live_count  = (size_t)_zalloc_load64(&s->live_count);
+    info.peak_bytes  = (size_t)_zalloc_load64(&s->peak_bytes);
+    info.total_bytes = (size_t)_zalloc_load64(&s->total_bytes);
+    fn(&info, user);
+}
+
+ZALLOC_API void zprof_foreach(zprof_visit_fn fn, void *user) 
+{
+    zprof_table *tb = (zprof_table*)(uintptr_t)_zalloc_load64(&g_zprof_tables);
+    for (; tb; tb = tb->next) 
+    {
+        for (size_t i = 0; i < ZPROF_MAX_SITES; i++) _zprof_visit(&tb->sites[i], fn, user);
+        _zprof_visit(&tb->other, fn, user);
+    }
+}
+
+static void _zprof_collapsed_line(const zprof_site_info *site, void *user) 
+{
+    if (site->live_bytes) fprintf((FILE*)user, "%s:%d %zu\n", site->file, site->line, site->live_bytes);
+}
+
+ZALLOC_API int zprof_write_collapsed(const char *path) 
+{
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+    zprof_foreach(_zprof_collapsed_line, f);
+    return (0 == fclose(f)) ? 0 : -1;
+}
+
+static void _zprof_print_line(const zprof_site_info *site, void *user) 
+{
+    if (!site->live_bytes) return;
+    ZDEBUG_LOG("   %s:%d  %zu bytes in ~%zu blocks (peak %zu)\n",
+               site->file, site->line, site->live_bytes, site->live_count, site->peak_bytes);
+    (*(size_t*)user)++;
+}
+
+ZALLOC_API size_t zprof_print(void) 
+{
+    size_t sites = 0;
+    ZDEBUG_LOG("=> ZPROF live heap (estimated): %zu bytes, peak %zu bytes\n", zprof_live_bytes(), zprof_peak_bytes());
+    zprof_foreach(_zprof_print_line, &sites);
+    return sites;
+}
+
+#ifdef ZDEBUG_SAMPLING
+
+/* The zdebug_* entry points sample instead of tracking every block. */
+ZALLOC_API void* zdebug_malloc_loc(size_t size, const char *file, int line) 
+{
+    return zprof_malloc_loc(size, file, line);
+}
+
+ZALLOC_API void* zdebug_calloc_loc(size_t count, size_t size, const char *file, int line) 
+{
+    return zprof_calloc_loc(count, size, file, line);
+}
+
+ZALLOC_API void* zdebug_realloc_loc(void *ptr, size_t size, const char *file, int line) 
+{
+    return zprof_realloc_loc(ptr, size, file, line);
+}
+
+ZALLOC_API void zdebug_free(void *ptr) 
+{
+    zprof_free(ptr);
+}
+
+static void _zdebug_atexit_wrapper(void) 
+{
+    zprof_print();
+}
+
+ZALLOC_API void zdebug_register_atexit(void) 
+{
+    atexit(_zdebug_atexit_wrapper);
+}
+
+ZALLOC_API size_t zdebug_print_leaks(void) 
+{
+    return zprof_print();
+}
+
+#else
+
 #define ZDEBUG_MAGIC_ALIVE 0x11223344
 #define ZDEBUG_MAGIC_FREED 0xDEADDEAD
 #define ZDEBUG_CANARY_VAL  0xBB
@@ -615,6 +1795,8 @@ ZALLOC_API size_t zdebug_print_leaks(void)
     ZDEBUG_UNLOCK();
     return count;
 }
+
+#endif // ZDEBUG_SAMPLING
 #endif // ZALLOC_ENABLE_DEBUG_GUARD
 #endif // ZALLOC_ENABLE_DEBUG
 
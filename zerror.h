@@ -144,6 +144,58 @@
 
 
 #endif // Z_COMMON_BUNDLED
+
+// Runtime allocator handle. Not part of zcommon yet, so it stays outside the bundled block
+// above (regenerated from upstream); every ZDK header carries the same guarded copy.
+#ifndef Z_ALLOCATOR_HANDLE_DEFINED
+#define Z_ALLOCATOR_HANDLE_DEFINED
+
+/* * zalloc_t routes one container's memory through any allocator (arena, pool, ...).
+ * Containers only carry a handle when Z_ALLOCATOR_HANDLE is defined before the first
+ * ZDK include; otherwise they are laid out and compiled exactly as before.
+ * A NULL handle means the compile-time *_MALLOC macros. realloc and free also receive
+ * the old size, for allocators that do not track it.
+ */
+#ifndef Z_ALLOC_T_DEFINED
+#define Z_ALLOC_T_DEFINED
+typedef struct zalloc_t
+{
+    void *(*alloc)(void *ctx, size_t size);
+    void *(*realloc)(void *ctx, void *ptr, size_t old_size, size_t new_size);
+    void  (*free)(void *ctx, void *ptr, size_t size);
+    void *ctx;
+} zalloc_t;
+#endif
+
+#ifdef Z_ALLOCATOR_HANDLE
+#   define Z_ALLOCATOR_FIELD                   const zalloc_t *allocator;
+#   define Z_ALLOCATOR_INIT                    , NULL
+#   define Z_HMALLOC(h, sz, dflt)              ((h) ? (h)->alloc((h)->ctx, (sz)) : (dflt))
+#   define Z_HCALLOC(h, n, sz, dflt)           ((h) ? z_hcalloc__((h), (n), (sz)) : (dflt))
+#   define Z_HREALLOC(h, p, old_sz, sz, dflt)  ((h) ? (h)->realloc((h)->ctx, (p), (old_sz), (sz)) : (dflt))
+#   define Z_HFREE(h, p, sz, dflt)             ((h) ? ((p) ? (h)->free((h)->ctx, (p), (sz)) : (void)0) : (void)(dflt))
+    // Setter for a generated container; call it while the container owns no memory yet.
+#   define Z_GEN_SET_ALLOCATOR(Type, Fn)       static inline void Fn(Type *c, const zalloc_t *a) { c->allocator = a; }
+
+static inline void *z_hcalloc__(const zalloc_t *h, size_t n, size_t sz)
+{
+    if (0 != n && sz > SIZE_MAX / n) return NULL;
+    void *p = h->alloc(h->ctx, n * sz);
+    if (p) memset(p, 0, n * sz);
+    return p;
+}
+#else
+#   define Z_ALLOCATOR_FIELD
+#   define Z_ALLOCATOR_INIT
+#   define Z_HMALLOC(h, sz, dflt)              (dflt)
+#   define Z_HCALLOC(h, n, sz, dflt)           (dflt)
+#   define Z_HREALLOC(h, p, old_sz, sz, dflt)  (dflt)
+#   define Z_HFREE(h, p, sz, dflt)             (dflt)
+#   define Z_GEN_SET_ALLOCATOR(Type, Fn)
+#endif
+
+#endif // Z_ALLOCATOR_HANDLE_DEFINED
+
 /* ============================================================================ */
 
 /*
@@ -144,6 +144,58 @@
 
 
 #endif // Z_COMMON_BUNDLED
+
+// Runtime allocator handle. Not part of zcommon yet, so it stays outside the bundled block
+// above (regenerated from upstream); every ZDK header carries the same guarded copy.
+#ifndef Z_ALLOCATOR_HANDLE_DEFINED
+#define Z_ALLOCATOR_HANDLE_DEFINED
+
+/* * zalloc_t routes one container's memory through any allocator (arena, pool, ...).
+ * Containers only carry a handle when Z_ALLOCATOR_HANDLE is defined before the first
+ * ZDK include; otherwise they are laid out and compiled exactly as before.
+ * A NULL handle means the compile-time *_MALLOC macros. realloc and free also receive
+ * the old size, for allocators that do not track it.
+ */
+#ifndef Z_ALLOC_T_DEFINED
+#define Z_ALLOC_T_DEFINED
+typedef struct zalloc_t
+{
+    void *(*alloc)(void *ctx, size_t size);
+    void *(*realloc)(void *ctx, void *ptr, size_t old_size, size_t new_size);
+    void  (*free)(void *ctx, void *ptr, size_t size);
+    void *ctx;
+} zalloc_t;
+#endif
+
+#ifdef Z_ALLOCATOR_HANDLE
+#   define Z_ALLOCATOR_FIELD                   const zalloc_t *allocator;
+#   define Z_ALLOCATOR_INIT                    , NULL
+#   define Z_HMALLOC(h, sz, dflt)              ((h) ? (h)->alloc((h)->ctx, (sz)) : (dflt))
+#   define Z_HCALLOC(h, n, sz, dflt)           ((h) ? z_hcalloc__((h), (n), (sz)) : (dflt))
+#   define Z_HREALLOC(h, p, old_sz, sz, dflt)  ((h) ? (h)->realloc((h)->ctx, (p), (old_sz), (sz)) : (dflt))
+#   define Z_HFREE(h, p, sz, dflt)             ((h) ? ((p) ? (h)->free((h)->ctx, (p), (sz)) : (void)0) : (void)(dflt))
+    // Setter for a generated container; call it while the container owns no memory yet.
+#   define Z_GEN_SET_ALLOCATOR(Type, Fn)       static inline void Fn(Type *c, const zalloc_t *a) { c->allocator = a; }
+
+static inline void *z_hcalloc__(const zalloc_t *h, size_t n, size_t sz)
+{
+    if (0 != n && sz > SIZE_MAX / n) return NULL;
+    void *p = h->alloc(h->ctx, n * sz);
+    if (p) memset(p, 0, n * sz);
+    return p;
+}
+#else
+#   define Z_ALLOCATOR_FIELD
+#   define Z_ALLOCATOR_INIT
+#   define Z_HMALLOC(h, sz, dflt)              (dflt)
+#   define Z_HCALLOC(h, n, sz, dflt)           (dflt)
+#   define Z_HREALLOC(h, p, old_sz, sz, dflt)  (dflt)
+#   define Z_HFREE(h, p, sz, dflt)             (dflt)
+#   define Z_GEN_SET_ALLOCATOR(Type, Fn)
+#endif
+
+#endif // Z_ALLOCATOR_HANDLE_DEFINED
+
 /* ============================================================================ */
 
 
@@ -171,6 +223,13 @@
 #include "zstr.h"
 // [Bundled] "zcommon.h" is included inline in this same file
 
+// Optional dependency: zthread.h (parallel batches and directory walks on its executor).
+// Opt-in with ZFILE_USE_ZTHREAD, since it needs ZTHREAD_IMPLEMENTATION somewhere in the program.
+#if defined(ZFILE_USE_ZTHREAD)
+#   include "zthread.h"
+#   define ZFILE_HAS_ZTHREAD 1
+#endif
+
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -208,6 +267,8 @@ zstr zfile_tempname(const char *prefix, const char *ext);
 zstr zfile_read_all(const char *path);
 int zfile_write_all(const char *path, const void *data, size_t len);
 int zfile_append(const char *path, const void *data, size_t len);
+// In-kernel where possible: copy_file_range (or sendfile) on Linux, copyfile on macOS,
+// CopyFileW on Windows.
 int zfile_copy(const char *src, const char *dst);
 int zfile_remove(const char *path);
 int zfile_rename(const char *old_path, const char *new_path);
@@ -219,6 +280,49 @@ int64_t zfile_size(const char *path);
 // Prevents data corruption on crash.
 int zfile_save_atomic(const char *path, const void *data, size_t len);
 
+// Memory-mapped files.
+
+typedef enum 
+{
+    ZFILE_MAP_READ,         // Read-only view.
+    ZFILE_MAP_WRITE         // Shared read-write view: stores reach the file.
+} zfile_map_mode;
+
+typedef enum 
+{
+    ZFILE_ADVISE_NORMAL,
+    ZFILE_ADVISE_SEQUENTIAL, // Aggressive read-ahead, pages dropped behind the reader.
+    ZFILE_ADVISE_RANDOM,     // No read-ahead.
+    ZFILE_ADVISE_WILLNEED    // Start reading the range in now.
+} zfile_advice;
+
+/* * A whole file mapped into memory (mmap / CreateFileMapping). data is NULL for an empty
+ * file. The view stays valid until zfile_map_close, even if the file is renamed or removed;
+ * truncating it underneath a mapping faults on access to the lost pages.
+ */
+typedef struct 
+{
+    char  *data;
+    size_t len;
+    bool   writable;
+} zfile_map;
+
+// Returns 0 on success, or an error code (out is zeroed).
+int zfile_map_open(const char *path, zfile_map_mode mode, zfile_map *out);
+
+// Creates (or truncates) the file at len bytes of zeros and maps it read-write.
+int zfile_map_create(const char *path, size_t len, zfile_map *out);
+
+void zfile_map_close(zfile_map *m);
+
+zstr_view zfile_map_view(const zfile_map *m);
+
+// Access pattern hint for [offset, offset + len); len 0 means to the end. Also 0 or an error.
+int zfile_map_advise(zfile_map *m, size_t offset, size_t len, zfile_advice advice);
+
+// Writes dirty pages of a writable map back to the file.
+int zfile_map_sync(zfile_map *m);
+
 // Buffered reader.
 
 typedef struct 
@@ -230,10 +334,16 @@ typedef struct
     size_t pos;     
     bool   eof;
     bool   own_buf; 
+    bool   mapped;      // Lines come straight from map (see zfile_reader_open_map).
+    zfile_map map;
 } zfile_reader;
 
 zfile_reader zfile_reader_open(const char *path);
 zfile_reader zfile_reader_open_buf(const char *path, char *buf, size_t cap);
+
+// Maps the whole file instead of reading it: lines are views into the mapping, never
+// copied, and there is no line length limit. The views stay valid until close.
+zfile_reader zfile_reader_open_map(const char *path);
 void zfile_reader_close(zfile_reader *r);
 
 bool zfile_reader_next_line(zfile_reader *r, zstr_view *out_line);
@@ -248,6 +358,13 @@ bool zfile_reader_next_line(zfile_reader *r, zstr_view *out_line);
          zfile_reader_close(&_r_##line_var))                                            \
         for (zstr_view line_var; zfile_reader_next_line(&_r_##line_var, &line_var); )
 
+// Same over a mapping (zfile_reader_open_map); an empty file runs no iteration.
+#define ZFILE_FOR_EACH_LINE_MAPPED(path, line_var)                                      \
+    for (zfile_reader _r_##line_var = zfile_reader_open_map(path);                      \
+         _r_##line_var.mapped;                                                          \
+         zfile_reader_close(&_r_##line_var))                                            \
+        for (zstr_view line_var; zfile_reader_next_line(&_r_##line_var, &line_var); )
+
 // Directory iteration.
 
 typedef enum
@@ -270,6 +387,106 @@ zdir_iter* zdir_open(const char *path);
 bool zdir_next(zdir_iter *it, zdir_entry *out_entry);
 void zdir_close(zdir_iter *it);
 
+// Recursive directory walk.
+
+typedef struct 
+{
+    const char *path;   // root joined with every level down to the entry.
+    const char *name;
+    zdir_type   type;   // Symbolic links are ZDIR_UNKNOWN and never followed (*).
+    size_t      depth;  // 0 for the root's direct children.
+} zfile_walk_entry;
+
+// Called once per entry below root. For a directory, return false to skip its contents.
+typedef bool (*zfile_walk_fn)(const zfile_walk_entry *entry, void *user);
+
+/* * Visits every entry below root. Entry types come from the directory listing itself
+ * (d_type, or the find data on Windows); only entries the file system leaves untyped cost a
+ * stat. With ZFILE_HAS_ZTHREAD every directory is a task on zexec_default(), so fn runs
+ * concurrently on several threads and must be thread-safe; siblings come in no set order.
+ * Returns the number of entries visited, or -1 if root cannot be opened.
+ * (*) Strict ISO C builds on POSIX see no lstat: there links are followed, minus cycles.
+ */
+int64_t zfile_walk(const char *root, zfile_walk_fn fn, void *user);
+
+// Batched file I/O.
+
+typedef struct 
+{
+    const char *path;
+    const void *data;   // NULL: read the file into content. Otherwise write len bytes of it.
+    size_t      len;
+    zstr        content;
+    int         result; // 0, or the error code.
+} zfile_job;
+
+// Runs every job (in parallel with ZFILE_HAS_ZTHREAD). Returns how many failed.
+size_t zfile_run_jobs(zfile_job *jobs, size_t count);
+
+// The same in the background: jobs must stay put until zfile_batch_wait, which also frees the
+// handle and returns the failure count. Without ZFILE_HAS_ZTHREAD the jobs run right here.
+// NULL if out of memory (nothing ran).
+typedef struct zfile_batch zfile_batch;
+zfile_batch *zfile_batch_start(zfile_job *jobs, size_t count);
+size_t zfile_batch_wait(zfile_batch *b);
+
+// Delimited records (CSV, TSV).
+
+/* * Streaming record parser. Newlines, delimiters and quotes are located 64 bytes at a time
+ * as bitmasks (AVX2, SSE2 or NEON; define ZFILE_NO_SIMD for the scalar path), and the quoted
+ * spans are resolved from the quote bits alone, so blocks without quotes cost nothing extra.
+ * Fields are views into the input; only a quoted field with doubled quotes ("") is
+ * unescaped, into a per-row scratch buffer. A quote opens a quoted field only at the field's
+ * start (after the delimiter, a newline or the start of input; RFC 4180); elsewhere outside
+ * quotes it is plain text, so ab"c is a four byte field.
+ * A trailing \r is dropped from a row; a blank line is a row with one empty field.
+ */
+typedef struct 
+{
+    zstr_view *fields;  // Valid until the next zfile_csv_next.
+    size_t     count;
+} zfile_csv_row;
+
+typedef struct 
+{
+    const char *data;
+    size_t len;
+    size_t next;        // Next block to scan.
+    size_t base;        // Block that mask belongs to.
+    uint64_t mask;      // Its delimiters and newlines outside quotes, not yet consumed.
+    uint64_t quoted;    // All ones when the next block starts inside quotes.
+    bool at_start;      // The next block's first byte starts a field.
+    bool after_close;   // The last byte scanned was a closing quote ("" reopens).
+    size_t field_start;
+    bool done;
+    char delim;
+    char quote;         // 0: no quoting (plain TSV).
+    zstr_view *fields;
+    size_t field_cap;
+    char *scratch;
+    size_t scratch_cap;
+    zfile_map map;
+} zfile_csv;
+
+// Parses text, which must outlive the parser.
+void zfile_csv_init(zfile_csv *c, zstr_view text, char delim, char quote);
+
+// Maps the file and parses the mapping. Returns 0, or an error code.
+int zfile_csv_open(zfile_csv *c, const char *path, char delim, char quote);
+
+bool zfile_csv_next(zfile_csv *c, zfile_csv_row *row);
+void zfile_csv_close(zfile_csv *c);
+
+// Row callback for zfile_csv_parallel: chunk is the piece's index. Return false to stop it.
+typedef bool (*zfile_csv_fn)(const zfile_csv_row *row, size_t chunk, void *user);
+
+/* * Splits text into up to chunks pieces on record boundaries (quote state included) and
+ * parses them in parallel with ZFILE_HAS_ZTHREAD, one after another otherwise. Rows keep
+ * their order within a chunk; chunks run concurrently. Returns the number of rows.
+ */
+int64_t zfile_csv_parallel(zstr_view text, char delim, char quote, size_t chunks, 
+                           zfile_csv_fn fn, void *user);
+
 // Optional short names.
 #ifdef ZFILE_SHORT_NAMES
 #   define file_exists   zfile_exists
@@ -345,6 +562,49 @@ namespace z_file
             return s.c_str(); 
         }
     };
+    class mapping 
+    {
+        zfile_map m;
+     public:
+        explicit mapping(const char *p, zfile_map_mode mode = ZFILE_MAP_READ) 
+        { 
+            zfile_map_open(p, mode, &m); 
+        }
+
+        ~mapping() 
+        { 
+            zfile_map_close(&m); 
+        }
+
+        mapping(const mapping&) = delete;
+        mapping &operator=(const mapping&) = delete;
+
+        bool is_open() const 
+        { 
+            return m.data != NULL; 
+        }
+
+        char *data() const 
+        { 
+            return m.data; 
+        }
+
+        size_t size() const 
+        { 
+            return m.len; 
+        }
+
+        z_str::view view() const 
+        { 
+            return z_str::view(m.data, m.len); 
+        }
+
+        int advise(zfile_advice a, size_t offset = 0, size_t len = 0) 
+        { 
+            return zfile_map_advise(&m, offset, len, a); 
+        }
+    };
+
     class dir_iterable 
     {
         zstr_view root;
@@ -449,10 +709,40 @@ namespace z_file
 #else
 #   include <dirent.h>
 #   include <unistd.h>
+#   include <fcntl.h>
+#   include <sys/mman.h>
 #   define z_stat_struct stat
 #   define zfile__fopen fopen
 #endif
 
+#if defined(__linux__)
+#   include <sys/sendfile.h>
+#   if defined(__USE_MISC) || defined(_GNU_SOURCE)
+#       include <sys/syscall.h>
+#       define ZFILE__SYSCALL 1
+#   endif
+#elif defined(__APPLE__)
+#   include <copyfile.h>
+#endif
+
+// SIMD scanning for the record parser (define ZFILE_NO_SIMD to force the scalar path).
+#if !defined(Z_NO_EXTENSIONS) && !defined(ZFILE_NO_SIMD) && defined(__AVX2__)
+#   include <immintrin.h>
+#   define ZFILE_SIMD_AVX2 1
+#elif !defined(Z_NO_EXTENSIONS) && !defined(ZFILE_NO_SIMD) && \
+      (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#   include <emmintrin.h>
+#   define ZFILE_SIMD_SSE2 1
+#elif !defined(Z_NO_EXTENSIONS) && !defined(ZFILE_NO_SIMD) && \
+      (defined(__aarch64__) || defined(_M_ARM64))
+#   include <arm_neon.h>
+#   define ZFILE_SIMD_NEON 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#   include <intrin.h>
+#endif
+
 // Internal utilities.
 
 static uint32_t zfile__rng_state = 0;
@@ -780,12 +1070,22 @@ int zfile_mkdir_recursive(const char *path)
 
 // IO utils.
 
+static int zfile__read_into(const char *path, zstr *out);
+
 zstr zfile_read_all(const char *path)
+{
+    zstr s = zstr_init();
+    zfile__read_into(path, &s);
+    return s;
+}
+
+// zfile_read_all with the error code: 0, or errno from the open.
+static int zfile__read_into(const char *path, zstr *out)
 {
     FILE *f = zfile__fopen(path, "rb");
     if (!f) 
     {
-        return zstr_init();
+        return errno;
     }
 
     fseek(f, 0, SEEK_END);
@@ -820,7 +1120,8 @@ zstr zfile_read_all(const char *path)
         }
     }
     fclose(f);
-    return s;
+    *out = s;
+    return 0;
 }
 
 static int zfile__write_mode(const char *path, const void *data, size_t len, const char *mode)
@@ -845,8 +1146,121 @@ int zfile_append(const char *path, const void *data, size_t len)
     return zfile__write_mode(path, data, len, "ab");
 }
 
+#if defined(__linux__)
+// Kernel-side copy of what fstat reports, then a plain loop for anything past it.
+static int zfile__copy_fd(int in, int out)
+{
+    struct stat st;
+    if (0 != fstat(in, &st)) 
+    {
+        return errno;
+    }
+    off_t off = 0;
+#   if defined(ZFILE__SYSCALL) && defined(SYS_copy_file_range)
+    bool ranged = true;
+#   endif
+    while (off < st.st_size) 
+    {
+        size_t want = (size_t)(st.st_size - off);
+        ssize_t n;
+#       if defined(ZFILE__SYSCALL) && defined(SYS_copy_file_range)
+        if (ranged) 
+        {
+            loff_t from = (loff_t)off;
+            n = (ssize_t)syscall(SYS_copy_file_range, in, &from, out, NULL, want, 0u);
+            if (n < 0 && (ENOSYS == errno || EXDEV == errno || EINVAL == errno || 
+                          EOPNOTSUPP == errno || EPERM == errno)) 
+            {
+                ranged = false;     // Not for this pair of file systems: try sendfile.
+                continue;
+            }
+        }
+        else
+#       endif
+        {
+            off_t from = off;
+            n = sendfile(out, in, &from, want);
+        }
+        if (n < 0) 
+        {
+            if (EINTR == errno) 
+            {
+                continue;
+            }
+            if (0 == off && (EINVAL == errno || ENOSYS == errno)) 
+            {
+                break;              // Neither works here: all of it goes through the loop.
+            }
+            return errno;
+        }
+        if (0 == n) 
+        {
+            break;                  // Shrank meanwhile.
+        }
+        off += n;
+    }
+    // Files that report no size (/proc) or grew since the fstat.
+    if ((off_t)-1 == lseek(in, off, SEEK_SET)) 
+    {
+        return errno;
+    }
+    char buf[65536];
+    for (;;) 
+    {
+        ssize_t n = read(in, buf, sizeof(buf));
+        if (n < 0 && EINTR == errno) 
+        {
+            continue;
+        }
+        if (n <= 0) 
+        {
+            return n < 0 ? errno : 0;
+        }
+        for (ssize_t done = 0; done < n; ) 
+        {
+            ssize_t w = write(out, buf + done, (size_t)(n - done));
+            if (w < 0 && EINTR != errno) 
+            {
+                return errno;
+            }
+            done += (w > 0) ? w : 0;
+        }
+    }
+}
+#endif
+
 int zfile_copy(const char *src, const char *dst)
 {
+#   if defined(_WIN32)
+    wchar_t *wsrc = zfile__to_wstr(src);
+    wchar_t *wdst = zfile__to_wstr(dst);
+    int res = CopyFileW(wsrc, wdst, FALSE) ? 0 : -1;
+    Z_FREE(wsrc); Z_FREE(wdst);
+    return res;
+#   elif defined(__linux__)
+    int in = open(src, O_RDONLY);
+    if (in < 0) 
+    {
+        return errno;
+    }
+    int out = open(dst, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (out < 0) 
+    {
+        int err = errno;
+        close(in);
+        return err;
+    }
+    int err = zfile__copy_fd(in, out);
+    close(in);
+    if (0 != close(out) && 0 == err) 
+    {
+        err = errno;
+    }
+    return err;
+#   elif defined(__APPLE__)
+    // Clones on APFS, copies the data otherwise.
+    return 0 == copyfile(src, dst, NULL, COPYFILE_DATA | COPYFILE_CLONE) ? 0 : errno;
+#   else
     FILE *fs = zfile__fopen(src, "rb");
     if (!fs) 
     {
@@ -869,6 +1283,7 @@ int zfile_copy(const char *src, const char *dst)
     }
     fclose(fs); fclose(fd);
     return err;
+#   endif
 }
 
 int zfile_remove(const char *path)
@@ -919,6 +1334,222 @@ int zfile_save_atomic(const char *path, const void *data, size_t len)
     return res;
 }
 
+// Memory-mapped files.
+
+#ifdef _WIN32
+static int zfile__map_handle(HANDLE h, size_t len, bool writable, zfile_map *out)
+{
+    if (0 == len) 
+    {
+        CloseHandle(h);
+        out->writable = writable;
+        return 0;
+    }
+    HANDLE mapping = CreateFileMappingW(h, NULL, writable ? PAGE_READWRITE : PAGE_READONLY, 
+                                        (DWORD)((uint64_t)len >> 32), (DWORD)len, NULL);
+    CloseHandle(h);
+    if (!mapping) 
+    {
+        return -1;
+    }
+    // The view keeps the mapping (and the file) alive on its own.
+    void *p = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, len);
+    CloseHandle(mapping);
+    if (!p) 
+    {
+        return -1;
+    }
+    out->data = (char*)p;
+    out->len = len;
+    out->writable = writable;
+    return 0;
+}
+#else
+static int zfile__map_fd(int fd, size_t len, bool writable, zfile_map *out)
+{
+    if (0 == len) 
+    {
+        close(fd);
+        out->writable = writable;
+        return 0;
+    }
+    void *p = mmap(NULL, len, PROT_READ | (writable ? PROT_WRITE : 0), MAP_SHARED, fd, 0);
+    int err = errno;
+    close(fd);
+    if (MAP_FAILED == p) 
+    {
+        return err;
+    }
+    out->data = (char*)p;
+    out->len = len;
+    out->writable = writable;
+    return 0;
+}
+#endif
+
+int zfile_map_open(const char *path, zfile_map_mode mode, zfile_map *out)
+{
+    bool writable = (ZFILE_MAP_WRITE == mode);
+    memset(out, 0, sizeof(*out));
+#   ifdef _WIN32
+    wchar_t *wpath = zfile__to_wstr(path);
+    HANDLE h = CreateFileW(wpath, GENERIC_READ | (writable ? GENERIC_WRITE : 0), 
+                           FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, 
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    Z_FREE(wpath);
+    LARGE_INTEGER size;
+    if (INVALID_HANDLE_VALUE == h) 
+    {
+        return -1;
+    }
+    if (!GetFileSizeEx(h, &size) || (uint64_t)size.QuadPart > SIZE_MAX) 
+    {
+        CloseHandle(h);
+        return -1;
+    }
+    return zfile__map_handle(h, (size_t)size.QuadPart, writable, out);
+#   else
+    int fd = open(path, writable ? O_RDWR : O_RDONLY);
+    if (fd < 0) 
+    {
+        return errno;
+    }
+    struct stat st;
+    int err = (0 != fstat(fd, &st)) ? errno : ((uint64_t)st.st_size > SIZE_MAX) ? EFBIG : 0;
+    if (0 != err) 
+    {
+        close(fd);
+        return err;
+    }
+    return zfile__map_fd(fd, (size_t)st.st_size, writable, out);
+#   endif
+}
+
+int zfile_map_create(const char *path, size_t len, zfile_map *out)
+{
+    memset(out, 0, sizeof(*out));
+#   ifdef _WIN32
+    wchar_t *wpath = zfile__to_wstr(path);
+    HANDLE h = CreateFileW(wpath, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, 
+                           CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    Z_FREE(wpath);
+    if (INVALID_HANDLE_VALUE == h) 
+    {
+        return -1;
+    }
+    LARGE_INTEGER size;
+    size.QuadPart = (LONGLONG)len;
+    if (!SetFilePointerEx(h, size, NULL, FILE_BEGIN) || !SetEndOfFile(h)) 
+    {
+        CloseHandle(h);
+        return -1;
+    }
+    return zfile__map_handle(h, len, true, out);
+#   else
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) 
+    {
+        return errno;
+    }
+    // Sized by writing its last byte: ftruncate is hidden in strict ISO C modes.
+    if (len > 0 && ((off_t)-1 == lseek(fd, (off_t)(len - 1), SEEK_SET) || 1 != write(fd, "", 1))) 
+    {
+        int err = errno;
+        close(fd);
+        return err;
+    }
+    return zfile__map_fd(fd, len, true, out);
+#   endif
+}
+
+void zfile_map_close(zfile_map *m)
+{
+    if (m->data) 
+    {
+#       ifdef _WIN32
+        UnmapViewOfFile(m->data);
+#       else
+        munmap(m->data, m->len);
+#       endif
+    }
+    memset(m, 0, sizeof(*m));
+}
+
+zstr_view zfile_map_view(const zfile_map *m)
+{
+    return m->data ? (zstr_view){ m->data, m->len } : (zstr_view){ "", 0 };
+}
+
+int zfile_map_advise(zfile_map *m, size_t offset, size_t len, zfile_advice advice)
+{
+    if (!m->data || offset >= m->len) 
+    {
+        return 0;
+    }
+    if (0 == len || len > m->len - offset) 
+    {
+        len = m->len - offset;
+    }
+#   ifdef _WIN32
+    // Only prefetching has a Windows counterpart (8+, looked up so older systems still load).
+    if (ZFILE_ADVISE_WILLNEED != advice) 
+    {
+        return 0;
+    }
+    typedef struct { void *addr; SIZE_T size; } zfile__range;
+    typedef BOOL (WINAPI *zfile__prefetch_fn)(HANDLE, ULONG_PTR, zfile__range*, ULONG);
+    zfile__prefetch_fn fn = (zfile__prefetch_fn)(void*)GetProcAddress(GetModuleHandleW(L"kernel32.dll"), 
+                                                                     "PrefetchVirtualMemory");
+    zfile__range r = { m->data + offset, len };
+    return (!fn || fn(GetCurrentProcess(), 1, &r, 0)) ? 0 : -1;
+#   else
+#   if defined(MADV_SEQUENTIAL) || defined(POSIX_MADV_SEQUENTIAL)
+    // The advice calls want a page-aligned start.
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t lead = offset % page;
+    char *start = m->data + offset - lead;
+#   endif
+#   if defined(MADV_SEQUENTIAL)
+    int how = MADV_NORMAL;
+    switch (advice) 
+    {
+        case ZFILE_ADVISE_SEQUENTIAL: how = MADV_SEQUENTIAL; break;
+        case ZFILE_ADVISE_RANDOM:     how = MADV_RANDOM;     break;
+        case ZFILE_ADVISE_WILLNEED:   how = MADV_WILLNEED;   break;
+        default:                      break;
+    }
+    return 0 == madvise(start, len + lead, how) ? 0 : errno;
+#   elif defined(POSIX_MADV_SEQUENTIAL)
+    int how = POSIX_MADV_NORMAL;
+    switch (advice) 
+    {
+        case ZFILE_ADVISE_SEQUENTIAL: how = POSIX_MADV_SEQUENTIAL; break;
+        case ZFILE_ADVISE_RANDOM:     how = POSIX_MADV_RANDOM;     break;
+        case ZFILE_ADVISE_WILLNEED:   how = POSIX_MADV_WILLNEED;   break;
+        default:                      break;
+    }
+    return posix_madvise(start, len + lead, how);
+#   else
+    // Strict ISO C builds see neither; a hint may always be ignored.
+    (void)advice;
+    return 0;
+#   endif
+#   endif
+}
+
+int zfile_map_sync(zfile_map *m)
+{
+    if (!m->data || !m->writable) 
+    {
+        return 0;
+    }
+#   ifdef _WIN32
+    return FlushViewOfFile(m->data, m->len) ? 0 : -1;
+#   else
+    return 0 == msync(m->data, m->len, MS_SYNC) ? 0 : errno;
+#   endif
+}
+
 // Buffered reader.
 
 #define ZFILE_DEFAULT_CAP 4096
@@ -950,8 +1581,27 @@ zfile_reader zfile_reader_open(const char *path)
     return r;
 }
 
+zfile_reader zfile_reader_open_map(const char *path) 
+{
+    zfile_reader r;
+    memset(&r, 0, sizeof(r));
+    if (0 == zfile_map_open(path, ZFILE_MAP_READ, &r.map)) 
+    {
+        zfile_map_advise(&r.map, 0, 0, ZFILE_ADVISE_SEQUENTIAL);
+        r.mapped = true;
+        r.buffer = r.map.data;
+        r.len = r.map.len;
+        r.eof = true;
+    }
+    return r;
+}
+
 void zfile_reader_close(zfile_reader *r) 
 {
+    if (r->mapped) 
+    {
+        zfile_map_close(&r->map);
+    }
     if (r->handle) 
     {
         fclose(r->handle);
@@ -965,7 +1615,8 @@ void zfile_reader_close(zfile_reader *r)
 
 bool zfile_reader_next_line(zfile_reader *r, zstr_view *out_line) 
 {
-    if (!r->handle) 
+    // A mapped reader is the buffered one with the whole file loaded and eof already set.
+    if ((!r->handle && !r->mapped) || (r->mapped && r->pos >= r->len)) 
     {
         return false;
     }
@@ -1093,7 +1744,7 @@ bool zdir_next(zdir_iter *it, zdir_entry *out)
             continue;
         }
         strncpy(out->name, ent->d_name, sizeof(out->name)-1);
-#       if defined(_DIRENT_HAVE_D_TYPE) && defined(DT_DIR)
+#       if defined(DT_DIR)
         if (DT_DIR == ent->d_type) 
         {
             out->type = ZDIR_DIR;
@@ -1129,6 +1780,702 @@ void zdir_close(zdir_iter *it)
     Z_FREE(it);
 }
 
+// Recursive directory walk.
+
+// Strict ISO C builds hide lstat (and d_type), so stat follows links there: cycles are cut
+// by comparing each directory against the ones above it.
+#if !defined(_WIN32) && !defined(DT_DIR)
+#   define ZFILE__WALK_FOLLOWS 1
+#endif
+
+typedef struct zfile__walk_dir
+{
+    zfile_walk_fn fn;
+    void *user;
+    char *path;
+    size_t depth;
+    int64_t count;      // Entries at and below this directory, once done.
+    const struct zfile__walk_dir *parent;
+    uint64_t id[2];     // Device and inode (ZFILE__WALK_FOLLOWS only).
+} zfile__walk_dir;
+
+// Type of an entry the listing could not name: links stay ZDIR_UNKNOWN.
+static zdir_type zfile__stat_type(const char *path, uint64_t id[2])
+{
+#   if defined(_WIN32)
+    (void)path; (void)id;
+    return ZDIR_UNKNOWN;
+#   else
+    struct stat st;
+#       if defined(ZFILE__WALK_FOLLOWS)
+    if (0 != stat(path, &st)) 
+#       else
+    if (0 != lstat(path, &st)) 
+#       endif
+    {
+        return ZDIR_UNKNOWN;
+    }
+    id[0] = (uint64_t)st.st_dev;
+    id[1] = (uint64_t)st.st_ino;
+    return S_ISDIR(st.st_mode) ? ZDIR_DIR : S_ISREG(st.st_mode) ? ZDIR_FILE : ZDIR_UNKNOWN;
+#   endif
+}
+
+static void zfile__walk_task(void *arg)
+{
+    zfile__walk_dir *d = (zfile__walk_dir*)arg;
+    zdir_iter *it = zdir_open(d->path);
+    if (!it) 
+    {
+        d->count = -1;
+        return;
+    }
+    size_t base = strlen(d->path);
+    size_t cap = base + 64;
+    char *full = (char*)Z_MALLOC(cap);
+    zfile__walk_dir **kids = NULL;
+    size_t kid_count = 0, kid_cap = 0;
+#   ifdef ZFILE_HAS_ZTHREAD
+    ztask **tasks = NULL;
+#   endif
+    zdir_entry e;
+    while (full && zdir_next(it, &e)) 
+    {
+        size_t n = strlen(e.name);
+        if (base + n + 2 > cap) 
+        {
+            char *grown = (char*)Z_REALLOC(full, (cap = base + n + 64));
+            if (!grown) 
+            {
+                break;
+            }
+            full = grown;
+        }
+        memcpy(full, d->path, base);
+        size_t at = base;
+        if (at > 0 && '/' != full[at - 1] && '\\' != full[at - 1]) 
+        {
+            full[at++] = ZFILE_SEP;
+        }
+        memcpy(full + at, e.name, n + 1);
+
+        zfile_walk_entry entry = { full, full + at, e.type, d->depth };
+        uint64_t id[2] = { 0, 0 };
+        if (ZDIR_UNKNOWN == entry.type) 
+        {
+            entry.type = zfile__stat_type(full, id);
+        }
+        d->count++;
+        if (!d->fn(&entry, d->user) || ZDIR_DIR != entry.type) 
+        {
+            continue;
+        }
+#       if defined(ZFILE__WALK_FOLLOWS)
+        const zfile__walk_dir *up = d;
+        for (; up && !(up->id[0] == id[0] && up->id[1] == id[1]); up = up->parent) 
+        {
+        }
+        if (up) 
+        {
+            continue;
+        }
+#       endif
+        if (kid_count == kid_cap) 
+        {
+            size_t want = kid_cap ? kid_cap * 2 : 8;
+            zfile__walk_dir **grown = (zfile__walk_dir**)Z_REALLOC(kids, want * sizeof(*kids));
+            if (!grown) 
+            {
+                continue;
+            }
+            kids = grown;
+            kid_cap = want;
+        }
+        zfile__walk_dir *kid = (zfile__walk_dir*)Z_MALLOC(sizeof(zfile__walk_dir));
+        char *kid_path = (char*)Z_MALLOC(at + n + 1);
+        if (!kid || !kid_path) 
+        {
+            Z_FREE(kid);
+            Z_FREE(kid_path);
+            continue;
+        }
+        memcpy(kid_path, full, at + n + 1);
+        kid->fn = d->fn;
+        kid->user = d->user;
+        kid->path = kid_path;
+        kid->depth = d->depth + 1;
+        kid->count = 0;
+        kid->parent = d;
+        kid->id[0] = id[0];
+        kid->id[1] = id[1];
+        kids[kid_count++] = kid;
+    }
+    zdir_close(it);
+    Z_FREE(full);
+
+    // Subdirectories after the listing is closed, so a deep tree holds few descriptors.
+#   ifdef ZFILE_HAS_ZTHREAD
+    tasks = kid_count ? (ztask**)Z_MALLOC(kid_count * sizeof(ztask*)) : NULL;
+    for (size_t i = 0; i < kid_count; i++) 
+    {
+        tasks[i] = tasks ? zexec_spawn(zexec_default(), zfile__walk_task, kids[i]) : NULL;
+        if (!tasks || !tasks[i]) 
+        {
+            zfile__walk_task(kids[i]);
+        }
+    }
+#   endif
+    for (size_t i = 0; i < kid_count; i++) 
+    {
+#       ifdef ZFILE_HAS_ZTHREAD
+        if (tasks && tasks[i]) 
+        {
+            zexec_join(tasks[i]);
+        }
+#       else
+        zfile__walk_task(kids[i]);
+#       endif
+        d->count += (kids[i]->count > 0) ? kids[i]->count : 0;
+        Z_FREE(kids[i]->path);
+        Z_FREE(kids[i]);
+    }
+#   ifdef ZFILE_HAS_ZTHREAD
+    Z_FREE(tasks);
+#   endif
+    Z_FREE(kids);
+}
+
+int64_t zfile_walk(const char *root, zfile_walk_fn fn, void *user)
+{
+    zfile__walk_dir d = { fn, user, (char*)root, 0, 0, NULL, { 0, 0 } };
+#   if defined(ZFILE__WALK_FOLLOWS)
+    zfile__stat_type(root, d.id);
+#   endif
+    zfile__walk_task(&d);
+    return d.count;
+}
+
+// Batched file I/O.
+
+struct zfile_batch 
+{
+    zfile_job *jobs;
+    size_t count;
+#   ifdef ZFILE_HAS_ZTHREAD
+    ztask *task;
+#   endif
+};
+
+static void zfile__job_run(void *arg)
+{
+    zfile_job *j = (zfile_job*)arg;
+    if (j->data) 
+    {
+        j->result = zfile_write_all(j->path, j->data, j->len);
+    }
+    else 
+    {
+        zstr_free(&j->content);
+        j->result = zfile__read_into(j->path, &j->content);
+    }
+}
+
+static void zfile__batch_run(void *arg)
+{
+    zfile_batch *b = (zfile_batch*)arg;
+#   ifdef ZFILE_HAS_ZTHREAD
+    zexec_run(zexec_default(), zfile__job_run, b->jobs, sizeof(zfile_job), b->count);
+#   else
+    for (size_t i = 0; i < b->count; i++) 
+    {
+        zfile__job_run(&b->jobs[i]);
+    }
+#   endif
+}
+
+static size_t zfile__failures(const zfile_job *jobs, size_t count)
+{
+    size_t failed = 0;
+    for (size_t i = 0; i < count; i++) 
+    {
+        failed += (0 != jobs[i].result);
+    }
+    return failed;
+}
+
+size_t zfile_run_jobs(zfile_job *jobs, size_t count)
+{
+    zfile_batch b;
+    memset(&b, 0, sizeof(b));
+    b.jobs = jobs;
+    b.count = count;
+    zfile__batch_run(&b);
+    return zfile__failures(jobs, count);
+}
+
+zfile_batch *zfile_batch_start(zfile_job *jobs, size_t count)
+{
+    zfile_batch *b = (zfile_batch*)Z_MALLOC(sizeof(zfile_batch));
+    if (!b) 
+    {
+        return NULL;
+    }
+    b->jobs = jobs;
+    b->count = count;
+#   ifdef ZFILE_HAS_ZTHREAD
+    if (NULL == (b->task = zexec_spawn(zexec_default(), zfile__batch_run, b))) 
+    {
+        Z_FREE(b);
+        return NULL;
+    }
+#   else
+    zfile__batch_run(b);
+#   endif
+    return b;
+}
+
+size_t zfile_batch_wait(zfile_batch *b)
+{
+#   ifdef ZFILE_HAS_ZTHREAD
+    zexec_join(b->task);
+#   endif
+    size_t failed = zfile__failures(b->jobs, b->count);
+    Z_FREE(b);
+    return failed;
+}
+
+// Delimited records.
+
+// Bitmasks of '\n', the delimiter and the quote over 64 bytes at p.
+static inline void zfile__csv_masks(const char *p, char delim, char quote, 
+                                    uint64_t *nl, uint64_t *dl, uint64_t *qt)
+{
+#   if defined(ZFILE_SIMD_AVX2)
+    __m256i lo = _mm256_loadu_si256((const __m256i*)p);
+    __m256i hi = _mm256_loadu_si256((const __m256i*)(p + 32));
+    __m256i n = _mm256_set1_epi8('\n'), d = _mm256_set1_epi8(delim), q = _mm256_set1_epi8(quote);
+#       define ZFILE__MASK2(v) ((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, v)) | \
+                                ((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, v)) << 32))
+    *nl = ZFILE__MASK2(n);
+    *dl = ZFILE__MASK2(d);
+    *qt = quote ? ZFILE__MASK2(q) : 0;
+#       undef ZFILE__MASK2
+#   elif defined(ZFILE_SIMD_SSE2) || defined(ZFILE_SIMD_NEON)
+    uint64_t m[3] = { 0, 0, 0 };
+    for (int i = 0; i < 4; i++) 
+    {
+#       if defined(ZFILE_SIMD_SSE2)
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + 16 * i));
+        m[0] |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))) << (16 * i);
+        m[1] |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(delim))) << (16 * i);
+        m[2] |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(quote))) << (16 * i);
+#       else
+        static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+        uint8x16_t w = vld1q_u8(weights);
+        uint8x16_t v = vld1q_u8((const uint8_t*)p + 16 * i);
+        uint8x16_t e[3] = { vceqq_u8(v, vdupq_n_u8('\n')), vceqq_u8(v, vdupq_n_u8((uint8_t)delim)), 
+                            vceqq_u8(v, vdupq_n_u8((uint8_t)quote)) };
+        for (int k = 0; k < 3; k++) 
+        {
+            uint8x16_t bits = vandq_u8(e[k], w);
+            uint64_t word = (uint64_t)vaddv_u8(vget_low_u8(bits)) | ((uint64_t)vaddv_u8(vget_high_u8(bits)) << 8);
+            m[k] |= word << (16 * i);
+        }
+#       endif
+    }
+    *nl = m[0];
+    *dl = m[1];
+    *qt = quote ? m[2] : 0;
+#   else
+    uint64_t n = 0, d = 0, q = 0;
+    for (int i = 0; i < 64; i++) 
+    {
+        n |= (uint64_t)('\n' == p[i]) << i;
+        d |= (uint64_t)(delim == p[i]) << i;
+        q |= (uint64_t)(quote == p[i]) << i;
+    }
+    *nl = n;
+    *dl = d;
+    *qt = quote ? q : 0;
+#   endif
+}
+
+static inline uint32_t zfile__ctz64(uint64_t x)
+{
+#   if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long i;
+    _BitScanForward64(&i, x);
+    return (uint32_t)i;
+#   elif defined(__GNUC__) || defined(__clang__)
+    return (uint32_t)__builtin_ctzll(x);
+#   else
+    uint32_t n = 0;
+    while (0 == (x & 1u)) 
+    {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#   endif
+}
+
+// Quoted spans of one block: bit i set while inside quotes. Outside quotes only a quote at a
+// field's start (a bit of starts) or right after a closing quote (the "" escape) opens a span;
+// inside, every quote closes it. Walks the quote bits only, carrying the state across blocks.
+static inline uint64_t zfile__csv_spans(uint64_t qt, uint64_t breaks, uint64_t *quoted, 
+                                        bool *at_start, bool *after_close)
+{
+    uint64_t starts = (breaks << 1) | (uint64_t)*at_start;
+    *at_start = (breaks >> 63) != 0;
+    if (0 == qt) 
+    {
+        *after_close = false;
+        return *quoted;
+    }
+    uint64_t inside = 0;
+    bool in = (0 != *quoted);
+    uint32_t from = 0;
+    int64_t closed = *after_close ? -1 : -2;
+    while (qt) 
+    {
+        uint32_t i = zfile__ctz64(qt);
+        qt &= qt - 1;
+        if (in) 
+        {
+            inside |= (((uint64_t)1 << i) - 1) & ~(((uint64_t)1 << from) - 1);
+            in = false;
+            closed = i;
+        }
+        else if (((starts >> i) & 1) || closed + 1 == (int64_t)i) 
+        {
+            in = true;
+            from = i;
+        }
+    }
+    if (in) 
+    {
+        inside |= ~(((uint64_t)1 << from) - 1);
+    }
+    *quoted = in ? ~(uint64_t)0 : 0;
+    *after_close = (63 == closed);
+    return inside;
+}
+
+// Loads the 64 bytes at at (zero-padded at the end of the input) and returns their masks.
+static inline void zfile__csv_load(const zfile_csv *c, size_t at, uint64_t *nl, uint64_t *dl, uint64_t *qt)
+{
+    if (c->len - at >= 64) 
+    {
+        zfile__csv_masks(c->data + at, c->delim, c->quote, nl, dl, qt);
+        return;
+    }
+    char tail[64];
+    size_t n = c->len - at;
+    memset(tail, 0, sizeof(tail));
+    memcpy(tail, c->data + at, n);
+    zfile__csv_masks(tail, c->delim, c->quote, nl, dl, qt);
+    uint64_t valid = ((uint64_t)1 << n) - 1;
+    *nl &= valid;
+    *dl &= valid;
+    *qt &= valid;
+}
+
+void zfile_csv_init(zfile_csv *c, zstr_view text, char delim, char quote)
+{
+    memset(c, 0, sizeof(*c));
+    c->data = text.data;
+    c->len = text.len;
+    c->delim = delim;
+    c->quote = quote;
+    c->at_start = true;
+}
+
+int zfile_csv_open(zfile_csv *c, const char *path, char delim, char quote)
+{
+    zfile_map map;
+    int err = zfile_map_open(path, ZFILE_MAP_READ, &map);
+    zfile_csv_init(c, zfile_map_view(&map), delim, quote);
+    if (0 == err) 
+    {
+        zfile_map_advise(&map, 0, 0, ZFILE_ADVISE_SEQUENTIAL);
+        c->map = map;
+    }
+    return err;
+}
+
+void zfile_csv_close(zfile_csv *c)
+{
+    zfile_map_close(&c->map);
+    Z_FREE(c->fields);
+    Z_FREE(c->scratch);
+    memset(c, 0, sizeof(*c));
+}
+
+static bool zfile__csv_push(zfile_csv *c, size_t n, size_t from, size_t to)
+{
+    if (n == c->field_cap) 
+    {
+        size_t cap = c->field_cap ? c->field_cap * 2 : 16;
+        zstr_view *grown = (zstr_view*)Z_REALLOC(c->fields, cap * sizeof(zstr_view));
+        if (!grown) 
+        {
+            return false;
+        }
+        c->fields = grown;
+        c->field_cap = cap;
+    }
+    c->fields[n] = (zstr_view){ c->data + from, to - from };
+    return true;
+}
+
+// Strips the row's \r and the fields' quotes, unescaping "" where it occurs.
+static bool zfile__csv_finish(zfile_csv *c, size_t n, zfile_csv_row *row)
+{
+    zstr_view *last = &c->fields[n - 1];
+    if (last->len > 0 && '\r' == last->data[last->len - 1]) 
+    {
+        last->len--;
+    }
+    if (c->quote) 
+    {
+        // Unescaped text never outgrows the raw row, which thus sizes the scratch once.
+        size_t row_len = (size_t)(last->data + last->len - c->fields[0].data) + 1;
+        size_t used = 0;
+        for (size_t i = 0; i < n; i++) 
+        {
+            zstr_view *f = &c->fields[i];
+            if (0 == f->len || c->quote != f->data[0]) 
+            {
+                continue;
+            }
+            f->data++;
+            f->len--;
+            const char *q = (const char*)memchr(f->data, c->quote, f->len);
+            if (!q || q == f->data + f->len - 1) 
+            {
+                f->len -= (NULL != q);  // The usual case: just the closing quote.
+                continue;
+            }
+            if (c->scratch_cap < row_len) 
+            {
+                char *grown = (char*)Z_REALLOC(c->scratch, row_len);
+                if (!grown) 
+                {
+                    return false;
+                }
+                c->scratch = grown;
+                c->scratch_cap = row_len;
+            }
+            char *out = c->scratch + used;
+            size_t k = 0;
+            // "" is a quote; a lone one closes the quoted part and is dropped.
+            for (size_t j = 0; j < f->len; j++) 
+            {
+                if (c->quote != f->data[j]) 
+                {
+                    out[k++] = f->data[j];
+                }
+                else if (j + 1 < f->len && c->quote == f->data[j + 1]) 
+                {
+                    out[k++] = c->quote;
+                    j++;
+                }
+            }
+            *f = (zstr_view){ out, k };
+            used += k;
+        }
+    }
+    row->fields = c->fields;
+    row->count = n;
+    return true;
+}
+
+bool zfile_csv_next(zfile_csv *c, zfile_csv_row *row)
+{
+    size_t n = 0;
+    while (!c->done) 
+    {
+        if (0 == c->mask) 
+        {
+            if (c->next >= c->len) 
+            {
+                c->done = true;
+                // A last row without its newline.
+                if (c->field_start < c->len || n > 0) 
+                {
+                    return zfile__csv_push(c, n, c->field_start, c->len) && zfile__csv_finish(c, n + 1, row);
+                }
+                return false;
+            }
+            uint64_t nl, dl, qt;
+            zfile__csv_load(c, c->next, &nl, &dl, &qt);
+            uint64_t inside = zfile__csv_spans(qt, nl | dl, &c->quoted, &c->at_start, &c->after_close);
+            c->mask = (nl | dl) & ~inside;
+            c->base = c->next;
+            c->next += 64;
+            continue;
+        }
+        size_t pos = c->base + zfile__ctz64(c->mask);
+        c->mask &= c->mask - 1;
+        if (!zfile__csv_push(c, n++, c->field_start, pos)) 
+        {
+            c->done = true;
+            return false;
+        }
+        c->field_start = pos + 1;
+        if ('\n' == c->data[pos]) 
+        {
+            return zfile__csv_finish(c, n, row);
+        }
+    }
+    return false;
+}
+
+// Parallel chunks.
+
+typedef struct 
+{
+    zstr_view text;     // Phase one: the raw piece; phase two: the piece on record bounds.
+    bool ends_inside[2]; // Phase one: quote state at the raw end, entered outside / inside.
+    char delim;
+    char quote;
+    size_t index;
+    int64_t rows;
+    zfile_csv_fn fn;
+    void *user;
+} zfile__csv_chunk;
+
+// Whether a quote opens depends on the state it meets, so each raw piece is scanned for both
+// entry states. Pieces never start right after a quote, which leaves after_close clear there.
+static void zfile__csv_count(void *arg)
+{
+    zfile__csv_chunk *k = (zfile__csv_chunk*)arg;
+    zfile_csv scan;
+    zfile_csv_init(&scan, k->text, k->delim, k->quote);
+    bool first = (0 == k->index) || 
+                 k->delim == k->text.data[-1] || '\n' == k->text.data[-1];
+    uint64_t quoted[2] = { 0, ~(uint64_t)0 };
+    bool at_start[2] = { first, first }, after_close[2] = { false, false };
+    for (size_t at = 0; at < scan.len; at += 64) 
+    {
+        uint64_t nl, dl, qt;
+        zfile__csv_load(&scan, at, &nl, &dl, &qt);
+        for (int h = 0; h < 2; h++) 
+        {
+            zfile__csv_spans(qt, nl | dl, &quoted[h], &at_start[h], &after_close[h]);
+        }
+    }
+    k->ends_inside[0] = (0 != quoted[0]);
+    k->ends_inside[1] = (0 != quoted[1]);
+}
+
+static void zfile__csv_parse(void *arg)
+{
+    zfile__csv_chunk *k = (zfile__csv_chunk*)arg;
+    zfile_csv c;
+    zfile_csv_row row;
+    zfile_csv_init(&c, k->text, k->delim, k->quote);
+    while (zfile_csv_next(&c, &row)) 
+    {
+        k->rows++;
+        if (!k->fn(&row, k->index, k->user)) 
+        {
+            break;
+        }
+    }
+    zfile_csv_close(&c);
+}
+
+int64_t zfile_csv_parallel(zstr_view text, char delim, char quote, size_t chunks, 
+                           zfile_csv_fn fn, void *user)
+{
+    // Pieces under 64 KiB are not worth a task.
+    size_t most = text.len / 65536 + 1;
+    chunks = (0 == chunks) ? 1 : (chunks > most ? most : chunks);
+    zfile__csv_chunk *k = (zfile__csv_chunk*)Z_CALLOC(chunks, sizeof(zfile__csv_chunk));
+    if (!k) 
+    {
+        return -1;
+    }
+    size_t step = text.len / chunks, from = 0;
+    for (size_t i = 0; i < chunks; i++) 
+    {
+        size_t to = (i + 1 == chunks) ? text.len : (i + 1) * step;
+        to = (to < from) ? from : to;
+        while (quote && to < text.len && to > 0 && quote == text.data[to - 1]) 
+        {
+            to++;
+        }
+        k[i] = (zfile__csv_chunk){ { text.data + from, to - from }, { false, false }, delim, quote, i, 0, fn, user };
+        from = to;
+    }
+#   ifdef ZFILE_HAS_ZTHREAD
+    zexec_run(zexec_default(), zfile__csv_count, k, sizeof(*k), chunks);
+#   else
+    for (size_t i = 0; i < chunks; i++) 
+    {
+        zfile__csv_count(&k[i]);
+    }
+#   endif
+    // A piece starts after the first newline outside quotes past its raw start; chaining the
+    // pieces' end states gives the quote state there.
+    size_t prev = 0;
+    bool inside = false;
+    for (size_t i = 0; i < chunks; i++) 
+    {
+        size_t at = (size_t)(k[i].text.data - text.data);
+        bool next_inside = k[i].ends_inside[inside];
+        if (i > 0) 
+        {
+            bool start = delim == text.data[at - 1] || '\n' == text.data[at - 1], closed = false;
+            for (; at < text.len; at++) 
+            {
+                char ch = text.data[at];
+                bool reopen = closed;
+                closed = false;
+                if (0 != quote && quote == ch) 
+                {
+                    if (inside) 
+                    {
+                        inside = false;
+                        closed = true;
+                    }
+                    else if (start || reopen) 
+                    {
+                        inside = true;
+                    }
+                }
+                else if (!inside && '\n' == ch) 
+                {
+                    break;
+                }
+                start = (delim == ch || '\n' == ch);
+            }
+            at = (at < text.len) ? at + 1 : at;
+            at = (at < prev) ? prev : at;
+            k[i - 1].text.len = at - (size_t)(k[i - 1].text.data - text.data);
+        }
+        inside = next_inside;
+        k[i].text = (zstr_view){ text.data + at, text.len - at };
+        prev = at;
+    }
+#   ifdef ZFILE_HAS_ZTHREAD
+    zexec_run(zexec_default(), zfile__csv_parse, k, sizeof(*k), chunks);
+#   else
+    for (size_t i = 0; i < chunks; i++) 
+    {
+        zfile__csv_parse(&k[i]);
+    }
+#   endif
+    int64_t rows = 0;
+    for (size_t i = 0; i < chunks; i++) 
+    {
+        rows += k[i].rows;
+    }
+    Z_FREE(k);
+    return rows;
+}
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -144,6 +144,58 @@
 
 
 #endif // Z_COMMON_BUNDLED
+
+// Runtime allocator handle. Not part of zcommon yet, so it stays outside the bundled block
+// above (regenerated from upstream); every ZDK header carries the same guarded copy.
+#ifndef Z_ALLOCATOR_HANDLE_DEFINED
+#define Z_ALLOCATOR_HANDLE_DEFINED
+
+/* * zalloc_t routes one container's memory through any allocator (arena, pool, ...).
+ * Containers only carry a handle when Z_ALLOCATOR_HANDLE is defined before the first
+ * ZDK include; otherwise they are laid out and compiled exactly as before.
+ * A NULL handle means the compile-time *_MALLOC macros. realloc and free also receive
+ * the old size, for allocators that do not track it.
+ */
+#ifndef Z_ALLOC_T_DEFINED
+#define Z_ALLOC_T_DEFINED
+typedef struct zalloc_t
+{
+    void *(*alloc)(void *ctx, size_t size);
+    void *(*realloc)(void *ctx, void *ptr, size_t old_size, size_t new_size);
+    void  (*free)(void *ctx, void *ptr, size_t size);
+    void *ctx;
+} zalloc_t;
+#endif
+
+#ifdef Z_ALLOCATOR_HANDLE
+#   define Z_ALLOCATOR_FIELD                   const zalloc_t *allocator;
+#   define Z_ALLOCATOR_INIT                    , NULL
+#   define Z_HMALLOC(h, sz, dflt)              ((h) ? (h)->alloc((h)->ctx, (sz)) : (dflt))
+#   define Z_HCALLOC(h, n, sz, dflt)           ((h) ? z_hcalloc__((h), (n), (sz)) : (dflt))
+#   define Z_HREALLOC(h, p, old_sz, sz, dflt)  ((h) ? (h)->realloc((h)->ctx, (p), (old_sz), (sz)) : (dflt))
+#   define Z_HFREE(h, p, sz, dflt)             ((h) ? ((p) ? (h)->free((h)->ctx, (p), (sz)) : (void)0) : (void)(dflt))
+    // Setter for a generated container; call it while the container owns no memory yet.
+#   define Z_GEN_SET_ALLOCATOR(Type, Fn)       static inline void Fn(Type *c, const zalloc_t *a) { c->allocator = a; }
+
+static inline void *z_hcalloc__(const zalloc_t *h, size_t n, size_t sz)
+{
+    if (0 != n && sz > SIZE_MAX / n) return NULL;
+    void *p = h->alloc(h->ctx, n * sz);
+    if (p) memset(p, 0, n * sz);
+    return p;
+}
+#else
+#   define Z_ALLOCATOR_FIELD
+#   define Z_ALLOCATOR_INIT
+#   define Z_HMALLOC(h, sz, dflt)              (dflt)
+#   define Z_HCALLOC(h, n, sz, dflt)           (dflt)
+#   define Z_HREALLOC(h, p, old_sz, sz, dflt)  (dflt)
+#   define Z_HFREE(h, p, sz, dflt)             (dflt)
+#   define Z_GEN_SET_ALLOCATOR(Type, Fn)
+#endif
+
+#endif // Z_ALLOCATOR_HANDLE_DEFINED
+
 /* ============================================================================ */
 
 /*
@@ -162,6 +214,7 @@
  * • Automatic type registration via z_registry.h
  * • Allocation failure returns Z_ENOMEM (fast path)
  * • Support for complex C++ types (constructors/destructors called)
+ * • Intrusive lists (zero allocations) and unrolled lists (many elements per node)
  *
  * License: MIT
  * Author: Zuhaitz
@@ -566,12 +619,14 @@ extern "C" {
 
 /* * Allocation Strategy Injection.
  * Allows C++ to use new/delete (constructors/destructors) 
- * while C uses malloc/free.
+ * while C uses malloc/free (or the list's zalloc_t handle when it carries one).
  */
 #ifdef __cplusplus
     #define ZLIST_IMPL_ALLOC(T, Name)                                                   \
-        static inline zlist_node_##Name* zlist_create_node_##Name(T val)                \
+        static inline zlist_node_##Name* zlist_create_node_##Name(zlist_##Name *l,      \
+                                                                  T val)                \
         {                                                                               \
+            (void)l;                                                                    \
             try {                                                                       \
                 zlist_node_##Name* n = new zlist_node_##Name;                           \
                 n->prev = nullptr;                                                      \
@@ -581,16 +636,22 @@ extern "C" {
             } catch (...) { return nullptr; }                                           \
         }                                                                               \
                                                                                         \
-        static inline void zlist_free_node_##Name(zlist_node_##Name* n)                 \
+        static inline void zlist_free_node_##Name(zlist_##Name *l,                      \
+                                                  zlist_node_##Name* n)                 \
         {                                                                               \
+            (void)l;                                                                    \
             delete n; /* Invokes destructor */                                          \
         }
+    #define ZLIST_GEN_SET_ALLOCATOR__(Name)
 #else
     #define ZLIST_IMPL_ALLOC(T, Name)                                                   \
-        static inline zlist_node_##Name* zlist_create_node_##Name(T val)                \
+        static inline zlist_node_##Name* zlist_create_node_##Name(zlist_##Name *l,      \
+                                                                  T val)                \
         {                                                                               \
+            (void)l;                                                                    \
             zlist_node_##Name* n = (zlist_node_##Name*)                                 \
-                                   ZLIST_MALLOC(sizeof(zlist_node_##Name));             \
+                                   Z_HMALLOC(l->allocator, sizeof(zlist_node_##Name),   \
+                                             ZLIST_MALLOC(sizeof(zlist_node_##Name)));  \
             if (n) {                                                                    \
                 n->value = val;                                                         \
                 n->prev = NULL;                                                         \
@@ -599,10 +660,13 @@ extern "C" {
             return n;                                                                   \
         }                                                                               \
                                                                                         \
-        static inline void zlist_free_node_##Name(zlist_node_##Name* n)                 \
+        static inline void zlist_free_node_##Name(zlist_##Name *l,                      \
+                                                  zlist_node_##Name* n)                 \
         {                                                                               \
-            ZLIST_FREE(n);                                                              \
+            (void)l;                                                                    \
+            Z_HFREE(l->allocator, n, sizeof(*n), ZLIST_FREE(n));                        \
         }
+    #define ZLIST_GEN_SET_ALLOCATOR__(Name) Z_GEN_SET_ALLOCATOR(zlist_##Name, zlist_set_allocator_##Name)
 #endif
 
 
@@ -626,14 +690,16 @@ typedef struct
     zlist_node_##Name *head;                                                        \
     zlist_node_##Name *tail;                                                        \
     size_t length;                                                                  \
+    Z_ALLOCATOR_FIELD                                                               \
 } zlist_##Name;                                                                     \
                                                                                     \
 /* Inject Allocation Logic (C vs C++). */                                           \
 ZLIST_IMPL_ALLOC(T, Name)                                                           \
+ZLIST_GEN_SET_ALLOCATOR__(Name)                                                     \
                                                                                     \
 static inline zlist_##Name zlist_init_##Name(void)                                  \
 {                                                                                   \
-    zlist_##Name l = { NULL, NULL, 0 };                                             \
+    zlist_##Name l = { NULL, NULL, 0 Z_ALLOCATOR_INIT };                            \
     return l;                                                                       \
 }                                                                                   \
                                                                                     \
@@ -675,7 +741,7 @@ static inline zlist_node_##Name* zlist_detach_node_##Name(zlist_##Name *l,
                                                                                     \
 static inline int zlist_push_back_##Name(zlist_##Name *l, T val)                    \
 {                                                                                   \
-    zlist_node_##Name *n = zlist_create_node_##Name(val);                           \
+    zlist_node_##Name *n = zlist_create_node_##Name(l, val);                        \
     if (!n) return Z_ENOMEM;                                                        \
                                                                                     \
     n->prev = l->tail;                                                              \
@@ -688,7 +754,7 @@ static inline int zlist_push_back_##Name(zlist_##Name *l, T val)
                                                                                     \
 static inline int zlist_push_front_##Name(zlist_##Name *l, T val)                   \
 {                                                                                   \
-    zlist_node_##Name *n = zlist_create_node_##Name(val);                           \
+    zlist_node_##Name *n = zlist_create_node_##Name(l, val);                        \
     if (!n) return Z_ENOMEM;                                                        \
                                                                                     \
     n->next = l->head;                                                              \
@@ -703,7 +769,7 @@ static inline int zlist_insert_after_##Name(zlist_##Name *l,
     zlist_node_##Name *prev_node, T val)                                            \
 {                                                                                   \
     if (!prev_node) return zlist_push_front_##Name(l, val);                         \
-    zlist_node_##Name *n = zlist_create_node_##Name(val);                           \
+    zlist_node_##Name *n = zlist_create_node_##Name(l, val);                        \
     if (!n) return Z_ENOMEM;                                                        \
                                                                                     \
     n->prev = prev_node;                                                            \
@@ -722,7 +788,7 @@ static inline void zlist_pop_back_##Name(zlist_##Name *l)
     l->tail = old_tail->prev;                                                       \
     if (l->tail) l->tail->next = NULL;                                              \
     else l->head = NULL;                                                            \
-    zlist_free_node_##Name(old_tail);                                               \
+    zlist_free_node_##Name(l, old_tail);                                            \
     l->length--;                                                                    \
 }                                                                                   \
                                                                                     \
@@ -733,7 +799,7 @@ static inline void zlist_pop_front_##Name(zlist_##Name *l)
     l->head = old_head->next;                                                       \
     if (l->head) l->head->prev = NULL;                                              \
     else l->tail = NULL;                                                            \
-    zlist_free_node_##Name(old_head);                                               \
+    zlist_free_node_##Name(l, old_head);                                            \
     l->length--;                                                                    \
 }                                                                                   \
                                                                                     \
@@ -744,7 +810,7 @@ static inline void zlist_remove_node_##Name(zlist_##Name *l, zlist_node_##Name *
     else l->head = n->next;                                                         \
     if (n->next) n->next->prev = n->prev;                                           \
     else l->tail = n->prev;                                                         \
-    zlist_free_node_##Name(n);                                                      \
+    zlist_free_node_##Name(l, n);                                                   \
     l->length--;                                                                    \
 }                                                                                   \
                                                                                     \
@@ -754,7 +820,7 @@ static inline void zlist_clear_##Name(zlist_##Name *l)
     while (curr)                                                                    \
     {                                                                               \
         zlist_node_##Name *next = curr->next;                                       \
-        zlist_free_node_##Name(curr);                                               \
+        zlist_free_node_##Name(l, curr);                                            \
         curr = next;                                                                \
     }                                                                               \
     l->head = l->tail = NULL;                                                       \
@@ -848,6 +914,533 @@ ZLIST_GEN_SAFE_IMPL(T, Name)
 // Execute the generator for all registered types.
 Z_ALL_LISTS(ZLIST_GENERATE_IMPL)
 
+/*
+ * Intrusive lists.
+ * The links live inside the elements, so push and unlink never allocate, and an element
+ * removes itself in O(1) given its list. Embed a prev/next pair and name it at registration:
+ *
+ *   typedef struct job { int id; struct { struct job *prev, *next; } link; } job;
+ *   #define REGISTER_ZLIST_INTRUSIVE_TYPES(X) X(job, link, job)
+ *
+ * The list never owns its elements: pop and detach hand them back and clear only forgets them.
+ * An element can sit in as many lists as it has link members, one per registered Name.
+ */
+
+/*
+ * Unrolled lists.
+ * Each chunk holds up to ZLIST_UNROLLED_BYTES of elements (at least four), so walking the list
+ * touches one pointer per chunk instead of one per element, and pushes allocate once per chunk.
+ * Push and pop work at both ends in O(1); element pointers stay valid until that element is popped
+ * or the list is reversed, which swaps elements within their chunks.
+ *
+ *   #define REGISTER_ZLIST_UNROLLED_TYPES(X) X(int, ints)
+ */
+#ifndef ZLIST_UNROLLED_BYTES
+#   define ZLIST_UNROLLED_BYTES 256
+#endif
+
+#define ZLIST_UNROLLED_CAP__(sz) ((ZLIST_UNROLLED_BYTES / (sz)) < 4 ? 4 : (ZLIST_UNROLLED_BYTES / (sz)))
+
+/* * Chunk allocation, as for plain nodes.
+ * C++ builds every slot of a chunk up front and resets a slot when its element is popped.
+ */
+#ifdef __cplusplus
+    #define ZLIST_IMPL_CHUNK_ALLOC(T, Name)                                             \
+        static inline zlist_chunk_##Name* zlist_create_chunk_##Name(zlist_##Name *l)    \
+        {                                                                               \
+            (void)l;                                                                    \
+            try {                                                                       \
+                zlist_chunk_##Name* c = new zlist_chunk_##Name;                         \
+                c->prev = nullptr;                                                      \
+                c->next = nullptr;                                                      \
+                c->start = 0;                                                           \
+                c->count = 0;                                                           \
+                return c;                                                               \
+            } catch (...) { return nullptr; }                                           \
+        }                                                                               \
+                                                                                        \
+        static inline void zlist_free_chunk_##Name(zlist_##Name *l,                     \
+                                                   zlist_chunk_##Name* c)               \
+        {                                                                               \
+            (void)l;                                                                    \
+            delete c; /* Invokes destructors */                                         \
+        }
+    #define ZLIST_CHUNK_RELEASE_SLOT__(T, slot) ((slot) = T())
+#else
+    #define ZLIST_IMPL_CHUNK_ALLOC(T, Name)                                             \
+        static inline zlist_chunk_##Name* zlist_create_chunk_##Name(zlist_##Name *l)    \
+        {                                                                               \
+            (void)l;                                                                    \
+            zlist_chunk_##Name* c = (zlist_chunk_##Name*)                               \
+                                    Z_HMALLOC(l->allocator, sizeof(zlist_chunk_##Name), \
+                                              ZLIST_MALLOC(sizeof(zlist_chunk_##Name)));\
+            if (c) {                                                                    \
+                c->prev = NULL;                                                         \
+                c->next = NULL;                                                         \
+                c->start = 0;                                                           \
+                c->count = 0;                                                           \
+            }                                                                           \
+            return c;                                                                   \
+        }                                                                               \
+                                                                                        \
+        static inline void zlist_free_chunk_##Name(zlist_##Name *l,                     \
+                                                   zlist_chunk_##Name* c)               \
+        {                                                                               \
+            (void)l;                                                                    \
+            Z_HFREE(l->allocator, c, sizeof(*c), ZLIST_FREE(c));                        \
+        }
+    #define ZLIST_CHUNK_RELEASE_SLOT__(T, slot) ((void)0)
+#endif
+
+#define ZLIST_GENERATE_INTRUSIVE_IMPL(T, Link, Name)                                \
+/* List structure; the elements carry the links. */                                 \
+typedef struct                                                                      \
+{                                                                                   \
+    T *head;                                                                        \
+    T *tail;                                                                        \
+    size_t length;                                                                  \
+} zlist_##Name;                                                                     \
+                                                                                    \
+static inline zlist_##Name zlist_init_##Name(void)                                  \
+{                                                                                   \
+    zlist_##Name l = { NULL, NULL, 0 };                                             \
+    return l;                                                                       \
+}                                                                                   \
+                                                                                    \
+static inline bool zlist_is_empty_##Name(const zlist_##Name *l)                     \
+{                                                                                   \
+    return l->head == NULL;                                                         \
+}                                                                                   \
+                                                                                    \
+static inline void zlist_push_back_##Name(zlist_##Name *l, T *e)                    \
+{                                                                                   \
+    e->Link.next = NULL;                                                            \
+    e->Link.prev = l->tail;                                                         \
+    if (l->tail) l->tail->Link.next = e;                                            \
+    else l->head = e;                                                               \
+    l->tail = e;                                                                    \
+    l->length++;                                                                    \
+}                                                                                   \
+                                                                                    \
+static inline void zlist_push_front_##Name(zlist_##Name *l, T *e)                   \
+{                                                                                   \
+    e->Link.prev = NULL;                                                            \
+    e->Link.next = l->head;                                                         \
+    if (l->head) l->head->Link.prev = e;                                            \
+    else l->tail = e;                                                               \
+    l->head = e;                                                                    \
+    l->length++;                                                                    \
+}                                                                                   \
+                                                                                    \
+static inline void zlist_insert_after_##Name(zlist_##Name *l, T *pos, T *e)         \
+{                                                                                   \
+    if (!pos)                                                                       \
+    {                                                                               \
+        zlist_push_front_##Name(l, e);                                              \
+        return;                                                                     \
+    }                                                                               \
+    e->Link.prev = pos;                                                             \
+    e->Link.next = pos->Link.next;                                                  \
+    if (pos->Link.next) pos->Link.next->Link.prev = e;                              \
+    else l->tail = e;                                                               \
+    pos->Link.next = e;                                                             \
+    l->length++;                                                                    \
+}                                                                                   \
+                                                                                    \
+/* Unlinks e in O(1) and hands it back; e must be in l. */                          \
+static inline T *zlist_detach_node_##Name(zlist_##Name *l, T *e)                    \
+{                                                                                   \
+    if (!e) return NULL;                                                            \
+    if (e->Link.prev) e->Link.prev->Link.next = e->Link.next;                       \
+    else l->head = e->Link.next;                                                    \
+    if (e->Link.next) e->Link.next->Link.prev = e->Link.prev;                       \
+    else l->tail = e->Link.prev;                                                    \
+    e->Link.prev = e->Link.next = NULL;                                             \
+    l->length--;                                                                    \
+    return e;                                                                       \
+}                                                                                   \
+                                                                                    \
+static inline void zlist_remove_node_##Name(zlist_##Name *l, T *e)                  \
+{                                                                                   \
+    (void)zlist_detach_node_##Name(l, e);                                           \
+}                                                                                   \
+                                                                                    \
+static inline T *zlist_pop_back_##Name(zlist_##Name *l)                             \
+{                                                                                   \
+    return zlist_detach_node_##Name(l, l->tail);                                    \
+}                                                                                   \
+                                                                                    \
+static inline T *zlist_pop_front_##Name(zlist_##Name *l)                            \
+{                                                                                   \
+    return zlist_detach_node_##Name(l, l->head);                                    \
+}                                                                                   \
+                                                                                    \
+/* Forgets every element; the elements themselves are left untouched. */            \
+static inline void zlist_clear_##Name(zlist_##Name *l)                              \
+{                                                                                   \
+    l->head = l->tail = NULL;                                                       \
+    l->length = 0;                                                                  \
+}                                                                                   \
+                                                                                    \
+static inline void zlist_splice_##Name(zlist_##Name *dest, zlist_##Name *src)       \
+{                                                                                   \
+    if (dest == src || !src->head) return;                                          \
+    if (!dest->head)                                                                \
+    {                                                                               \
+        *dest = *src;                                                               \
+    }                                                                               \
+    else                                                                            \
+    {                                                                               \
+        dest->tail->Link.next = src->head;                                          \
+        src->head->Link.prev = dest->tail;                                          \
+        dest->tail = src->tail;                                                     \
+        dest->length += src->length;                                                \
+    }                                                                               \
+    src->head = src->tail = NULL;                                                   \
+    src->length = 0;                                                                \
+}                                                                                   \
+                                                                                    \
+static inline void zlist_reverse_##Name(zlist_##Name *l)                            \
+{                                                                                   \
+    T *curr = l->head;                                                              \
+    while (curr)                                                                    \
+    {                                                                               \
+        T *next = curr->Link.next;                                                  \
+        curr->Link.next = curr->Link.prev;                                          \
+        curr->Link.prev = next;                                                     \
+        curr = next;                                                                \
+    }                                                                               \
+    curr = l->head;                                                                 \
+    l->head = l->tail;                                                              \
+    l->tail = curr;                                                                 \
+}                                                                                   \
+                                                                                    \
+static inline T *zlist_at_##Name(zlist_##Name *l, size_t index)                     \
+{                                                                                   \
+    if (index >= l->length) return NULL;                                            \
+    T *curr = l->head;                                                              \
+    while (index-- > 0) curr = curr->Link.next;                                     \
+    return curr;                                                                    \
+}                                                                                   \
+                                                                                    \
+static inline T *zlist_head_##Name(zlist_##Name *l)                                 \
+{                                                                                   \
+    return l->head;                                                                 \
+}                                                                                   \
+                                                                                    \
+static inline T *zlist_tail_##Name(zlist_##Name *l)                                 \
+{                                                                                   \
+    return l->tail;                                                                 \
+}                                                                                   \
+                                                                                    \
+static inline T *zlist_next_##Name(T *e)                                            \
+{                                                                                   \
+    return e->Link.next;                                                            \
+}                                                                                   \
+                                                                                    \
+static inline T *zlist_prev_##Name(T *e)                                            \
+{                                                                                   \
+    return e->Link.prev;                                                            \
+}
+
+#define ZLIST_GENERATE_UNROLLED_IMPL(T, Name)                                       \
+enum { zlist_chunk_cap_##Name = ZLIST_UNROLLED_CAP__(sizeof(T)) };                  \
+                                                                                    \
+/* Chunk; live elements occupy items[start, start + count). */                      \
+typedef struct zlist_chunk_##Name                                                   \
+{                                                                                   \
+    struct zlist_chunk_##Name *prev;                                                \
+    struct zlist_chunk_##Name *next;                                                \
+    uint32_t start;                                                                 \
+    uint32_t count;                                                                 \
+    T items[zlist_chunk_cap_##Name];                                                \
+} zlist_chunk_##Name;                                                               \
+                                                                                    \
+/* List structure (container). */                                                   \
+typedef struct                                                                      \
+{                                                                                   \
+    zlist_chunk_##Name *head;                                                       \
+    zlist_chunk_##Name *tail;                                                       \
+    size_t length;                                                                  \
+    Z_ALLOCATOR_FIELD                                                               \
+} zlist_##Name;                                                                     \
+                                                                                    \
+/* Element cursor: a chunk and a slot inside it, chunk is NULL at the end. */       \
+typedef struct                                                                      \
+{                                                                                   \
+    zlist_chunk_##Name *chunk;                                                      \
+    uint32_t idx;                                                                   \
+} zlist_iter_##Name;                                                                \
+                                                                                    \
+/* Inject Allocation Logic (C vs C++). */                                           \
+ZLIST_IMPL_CHUNK_ALLOC(T, Name)                                                     \
+ZLIST_GEN_SET_ALLOCATOR__(Name)                                                     \
+                                                                                    \
+static inline zlist_##Name zlist_init_##Name(void)                                  \
+{                                                                                   \
+    zlist_##Name l = { NULL, NULL, 0 Z_ALLOCATOR_INIT };                            \
+    return l;                                                                       \
+}                                                                                   \
+                                                                                    \
+static inline bool zlist_is_empty_##Name(const zlist_##Name *l)                     \
+{                                                                                   \
+    return l->head == NULL;                                                         \
+}                                                                                   \
+                                                                                    \
+static inline void zlist_unlink_chunk_##Name(zlist_##Name *l, zlist_chunk_##Name *c) \
+{                                                                                   \
+    if (c->prev) c->prev->next = c->next;                                           \
+    else l->head = c->next;                                                         \
+    if (c->next) c->next->prev = c->prev;                                           \
+    else l->tail = c->prev;                                                         \
+    zlist_free_chunk_##Name(l, c);                                                  \
+}                                                                                   \
+                                                                                    \
+static inline int zlist_push_back_##Name(zlist_##Name *l, T val)                    \
+{                                                                                   \
+    zlist_chunk_##Name *c = l->tail;                                                \
+    if (!c || c->start + c->count == (uint32_t)zlist_chunk_cap_##Name)              \
+    {                                                                               \
+        c = zlist_create_chunk_##Name(l);                                           \
+        if (!c) return Z_ENOMEM;                                                    \
+        c->prev = l->tail;                                                          \
+        if (l->tail) l->tail->next = c;                                             \
+        else l->head = c;                                                           \
+        l->tail = c;                                                                \
+    }                                                                               \
+    c->items[c->start + c->count] = val;                                            \
+    c->count++;                                                                     \
+    l->length++;                                                                    \
+    return Z_OK;                                                                    \
+}                                                                                   \
+                                                                                    \
+static inline int zlist_push_front_##Name(zlist_##Name *l, T val)                   \
+{                                                                                   \
+    zlist_chunk_##Name *c = l->head;                                                \
+    if (!c || 0 == c->start)                                                        \
+    {                                                                               \
+        c = zlist_create_chunk_##Name(l);                                           \
+        if (!c) return Z_ENOMEM;                                                    \
+        c->start = zlist_chunk_cap_##Name;                                          \
+        c->next = l->head;                                                          \
+        if (l->head) l->head->prev = c;                                             \
+        else l->tail = c;                                                           \
+        l->head = c;                                                                \
+    }                                                                               \
+    c->start--;                                                                     \
+    c->items[c->start] = val;                                                       \
+    c->count++;                                                                     \
+    l->length++;                                                                    \
+    return Z_OK;                                                                    \
+}                                                                                   \
+                                                                                    \
+static inline void zlist_pop_back_##Name(zlist_##Name *l)                           \
+{                                                                                   \
+    zlist_chunk_##Name *c = l->tail;                                                \
+    if (!c) return;                                                                 \
+    c->count--;                                                                     \
+    ZLIST_CHUNK_RELEASE_SLOT__(T, c->items[c->start + c->count]);                   \
+    l->length--;                                                                    \
+    if (0 == c->count) zlist_unlink_chunk_##Name(l, c);                             \
+}                                                                                   \
+                                                                                    \
+static inline void zlist_pop_front_##Name(zlist_##Name *l)                          \
+{                                                                                   \
+    zlist_chunk_##Name *c = l->head;                                                \
+    if (!c) return;                                                                 \
+    ZLIST_CHUNK_RELEASE_SLOT__(T, c->items[c->start]);                              \
+    c->start++;                                                                     \
+    c->count--;                                                                     \
+    l->length--;                                                                    \
+    if (0 == c->count) zlist_unlink_chunk_##Name(l, c);                             \
+}                                                                                   \
+                                                                                    \
+static inline T *zlist_front_##Name(zlist_##Name *l)                                \
+{                                                                                   \
+    return l->head ? &l->head->items[l->head->start] : NULL;                        \
+}                                                                                   \
+                                                                                    \
+static inline T *zlist_back_##Name(zlist_##Name *l)                                 \
+{                                                                                   \
+    return l->tail ? &l->tail->items[l->tail->start + l->tail->count - 1] : NULL;   \
+}                                                                                   \
+                                                                                    \
+/* Walks chunks from the nearer end, so the cost is O(n / chunk capacity). */       \
+static inline T *zlist_at_##Name(zlist_##Name *l, size_t index)                     \
+{                                                                                   \
+    if (index >= l->length) return NULL;                                            \
+    if (index < l->length / 2)                                                      \
+    {                                                                               \
+        zlist_chunk_##Name *c = l->head;                                            \
+        while (index >= c->count)                                                   \
+        {                                                                           \
+            index -= c->count;                                                      \
+            c = c->next;                                                            \
+        }                                                                           \
+        return &c->items[c->start + index];                                         \
+    }                                                                               \
+    size_t back = l->length - 1 - index;                                            \
+    zlist_chunk_##Name *c = l->tail;                                                \
+    while (back >= c->count)                                                        \
+    {                                                                               \
+        back -= c->count;                                                           \
+        c = c->prev;                                                                \
+    }                                                                               \
+    return &c->items[c->start + c->count - 1 - back];                               \
+}                                                                                   \
+                                                                                    \
+static inline void zlist_clear_##Name(zlist_##Name *l)                              \
+{                                                                                   \
+    zlist_chunk_##Name *curr = l->head;                                             \
+    while (curr)                                                                    \
+    {                                                                               \
+        zlist_chunk_##Name *next = curr->next;                                      \
+        zlist_free_chunk_##Name(l, curr);                                           \
+        curr = next;                                                                \
+    }                                                                               \
+    l->head = l->tail = NULL;                                                       \
+    l->length = 0;                                                                  \
+}                                                                                   \
+                                                                                    \
+/* Links src's chunks after dest's in O(1); partly filled chunks stay as they are. */ \
+static inline void zlist_splice_##Name(zlist_##Name *dest, zlist_##Name *src)       \
+{                                                                                   \
+    if (dest == src || !src->head) return;                                          \
+    if (!dest->head)                                                                \
+    {                                                                               \
+        dest->head = src->head;                                                     \
+        dest->tail = src->tail;                                                     \
+        dest->length = src->length;                                                 \
+    }                                                                               \
+    else                                                                            \
+    {                                                                               \
+        dest->tail->next = src->head;                                               \
+        src->head->prev = dest->tail;                                               \
+        dest->tail = src->tail;                                                     \
+        dest->length += src->length;                                                \
+    }                                                                               \
+    src->head = src->tail = NULL;                                                   \
+    src->length = 0;                                                                \
+}                                                                                   \
+                                                                                    \
+static inline void zlist_reverse_##Name(zlist_##Name *l)                            \
+{                                                                                   \
+    zlist_chunk_##Name *curr = l->head;                                             \
+    while (curr)                                                                    \
+    {                                                                               \
+        uint32_t i = curr->start, j = curr->start + curr->count;                    \
+        while (j - i > 1)                                                           \
+        {                                                                           \
+            T tmp = curr->items[i];                                                 \
+            curr->items[i++] = curr->items[--j];                                    \
+            curr->items[j] = tmp;                                                   \
+        }                                                                           \
+        zlist_chunk_##Name *next = curr->next;                                      \
+        curr->next = curr->prev;                                                    \
+        curr->prev = next;                                                          \
+        curr = next;                                                                \
+    }                                                                               \
+    curr = l->head;                                                                 \
+    l->head = l->tail;                                                              \
+    l->tail = curr;                                                                 \
+}                                                                                   \
+                                                                                    \
+static inline zlist_iter_##Name zlist_iter_begin_##Name(zlist_##Name *l)            \
+{                                                                                   \
+    zlist_iter_##Name it = { l->head, l->head ? l->head->start : 0 };               \
+    return it;                                                                      \
+}                                                                                   \
+                                                                                    \
+static inline bool zlist_iter_valid_##Name(const zlist_iter_##Name *it)             \
+{                                                                                   \
+    return it->chunk != NULL;                                                       \
+}                                                                                   \
+                                                                                    \
+static inline T *zlist_iter_value_##Name(const zlist_iter_##Name *it)               \
+{                                                                                   \
+    return &it->chunk->items[it->idx];                                              \
+}                                                                                   \
+                                                                                    \
+static inline void zlist_iter_next_##Name(zlist_iter_##Name *it)                    \
+{                                                                                   \
+    if (++it->idx == it->chunk->start + it->chunk->count)                           \
+    {                                                                               \
+        it->chunk = it->chunk->next;                                                \
+        it->idx = it->chunk ? it->chunk->start : 0;                                 \
+    }                                                                               \
+}
+
+/* Intrusive and unrolled registries; X(T, Link, Name) and X(T, Name). */
+#ifndef REGISTER_ZLIST_INTRUSIVE_TYPES
+    #define REGISTER_ZLIST_INTRUSIVE_TYPES(X)
+#endif
+
+#ifndef REGISTER_ZLIST_UNROLLED_TYPES
+    #define REGISTER_ZLIST_UNROLLED_TYPES(X)
+#endif
+
+#ifndef Z_AUTOGEN_INTRUSIVE_LISTS
+    #define Z_AUTOGEN_INTRUSIVE_LISTS(X)
+#endif
+
+#ifndef Z_AUTOGEN_UNROLLED_LISTS
+    #define Z_AUTOGEN_UNROLLED_LISTS(X)
+#endif
+
+#define Z_ALL_INTRUSIVE_LISTS(X)    \
+    Z_AUTOGEN_INTRUSIVE_LISTS(X)    \
+    REGISTER_ZLIST_INTRUSIVE_TYPES(X)
+
+#define Z_ALL_UNROLLED_LISTS(X)     \
+    Z_AUTOGEN_UNROLLED_LISTS(X)     \
+    REGISTER_ZLIST_UNROLLED_TYPES(X)
+
+Z_ALL_INTRUSIVE_LISTS(ZLIST_GENERATE_INTRUSIVE_IMPL)
+Z_ALL_UNROLLED_LISTS(ZLIST_GENERATE_UNROLLED_IMPL)
+
+// Generic dispatch entries for the intrusive and unrolled variants (empty where a variant has no such call).
+#define LI_IS_EMPTY_ENTRY(T, L, Name)           zlist_##Name*: zlist_is_empty_##Name,
+#define LI_CONST_IS_EMPTY_ENTRY(T, L, Name) const zlist_##Name*: zlist_is_empty_##Name,
+#define LI_REVERSE_ENTRY(T, L, Name)            zlist_##Name*: zlist_reverse_##Name,
+#define LI_DETACH_ENTRY(T, L, Name)             zlist_##Name*: zlist_detach_node_##Name,
+#define LI_PUSH_B_ENTRY(T, L, Name)             zlist_##Name*: zlist_push_back_##Name,
+#define LI_PUSH_F_ENTRY(T, L, Name)             zlist_##Name*: zlist_push_front_##Name,
+#define LI_INS_A_ENTRY(T, L, Name)              zlist_##Name*: zlist_insert_after_##Name,
+#define LI_POP_B_ENTRY(T, L, Name)              zlist_##Name*: zlist_pop_back_##Name,
+#define LI_POP_F_ENTRY(T, L, Name)              zlist_##Name*: zlist_pop_front_##Name,
+#define LI_REM_N_ENTRY(T, L, Name)              zlist_##Name*: zlist_remove_node_##Name,
+#define LI_CLEAR_ENTRY(T, L, Name)              zlist_##Name*: zlist_clear_##Name,
+#define LI_SPLICE_ENTRY(T, L, Name)             zlist_##Name*: zlist_splice_##Name,
+#define LI_HEAD_ENTRY(T, L, Name)               zlist_##Name*: zlist_head_##Name,
+#define LI_TAIL_ENTRY(T, L, Name)               zlist_##Name*: zlist_tail_##Name,
+#define LI_AT_ENTRY(T, L, Name)                 zlist_##Name*: zlist_at_##Name,
+#define LI_FRONT_ENTRY(T, L, Name)
+#define LI_BACK_ENTRY(T, L, Name)
+
+#define LU_IS_EMPTY_ENTRY(T, Name)              zlist_##Name*: zlist_is_empty_##Name,
+#define LU_CONST_IS_EMPTY_ENTRY(T, Name)  const zlist_##Name*: zlist_is_empty_##Name,
+#define LU_REVERSE_ENTRY(T, Name)               zlist_##Name*: zlist_reverse_##Name,
+#define LU_DETACH_ENTRY(T, Name)
+#define LU_PUSH_B_ENTRY(T, Name)                zlist_##Name*: zlist_push_back_##Name,
+#define LU_PUSH_F_ENTRY(T, Name)                zlist_##Name*: zlist_push_front_##Name,
+#define LU_INS_A_ENTRY(T, Name)
+#define LU_POP_B_ENTRY(T, Name)                 zlist_##Name*: zlist_pop_back_##Name,
+#define LU_POP_F_ENTRY(T, Name)                 zlist_##Name*: zlist_pop_front_##Name,
+#define LU_REM_N_ENTRY(T, Name)
+#define LU_CLEAR_ENTRY(T, Name)                 zlist_##Name*: zlist_clear_##Name,
+#define LU_SPLICE_ENTRY(T, Name)                zlist_##Name*: zlist_splice_##Name,
+#define LU_HEAD_ENTRY(T, Name)
+#define LU_TAIL_ENTRY(T, Name)
+#define LU_AT_ENTRY(T, Name)                    zlist_##Name*: zlist_at_##Name,
+#define LU_FRONT_ENTRY(T, Name)                 zlist_##Name*: zlist_front_##Name,
+#define LU_BACK_ENTRY(T, Name)                  zlist_##Name*: zlist_back_##Name,
+#define LU_ITER_BEGIN_ENTRY(T, Name)            zlist_##Name*: zlist_iter_begin_##Name,
+#define LU_ITER_VALID_ENTRY(T, Name)            zlist_iter_##Name*: zlist_iter_valid_##Name,
+#define LU_ITER_VALUE_ENTRY(T, Name)            zlist_iter_##Name*: zlist_iter_value_##Name,
+#define LU_ITER_NEXT_ENTRY(T, Name)             zlist_iter_##Name*: zlist_iter_next_##Name,
+
+#define ZLIST_VARIANTS__(Op) Z_ALL_INTRUSIVE_LISTS(LI_##Op##_ENTRY) Z_ALL_UNROLLED_LISTS(LU_##Op##_ENTRY)
+
 // C API macros (using _Generic).
 #define zlist_init(Name)         zlist_init_##Name()
 
@@ -858,21 +1451,38 @@ Z_ALL_LISTS(ZLIST_GENERATE_IMPL)
 #define zlist_is_empty(l)  _Generic((l),    \
     Z_ALL_LISTS(L_IS_EMPTY_ENTRY)           \
     Z_ALL_LISTS(L_CONST_IS_EMPTY_ENTRY)     \
+    ZLIST_VARIANTS__(IS_EMPTY)              \
+    ZLIST_VARIANTS__(CONST_IS_EMPTY)        \
     default: false) (l)
 
-#define zlist_reverse(l)            _Generic((l),    Z_ALL_LISTS(L_REVERSE_ENTRY) default: (void)0) (l)
-#define zlist_detach_node(l, n)     _Generic((l),    Z_ALL_LISTS(L_DETACH_ENTRY)  default: (void*)0) (l, n)
-#define zlist_push_back(l, val)     _Generic((l),    Z_ALL_LISTS(L_PUSH_B_ENTRY)  default: 0)         (l, val)
-#define zlist_push_front(l, val)    _Generic((l),    Z_ALL_LISTS(L_PUSH_F_ENTRY)  default: 0)         (l, val)
-#define zlist_insert_after(l, n, v) _Generic((l),    Z_ALL_LISTS(L_INS_A_ENTRY)   default: 0)         (l, n, v)
-#define zlist_pop_back(l)           _Generic((l),    Z_ALL_LISTS(L_POP_B_ENTRY)   default: (void)0)   (l)
-#define zlist_pop_front(l)          _Generic((l),    Z_ALL_LISTS(L_POP_F_ENTRY)   default: (void)0)   (l)
-#define zlist_remove_node(l, n)     _Generic((l),    Z_ALL_LISTS(L_REM_N_ENTRY)   default: (void)0)   (l, n)
-#define zlist_clear(l)              _Generic((l),    Z_ALL_LISTS(L_CLEAR_ENTRY)   default: (void)0)   (l)
-#define zlist_splice(dst, src)      _Generic((dst),  Z_ALL_LISTS(L_SPLICE_ENTRY)  default: (void)0)   (dst, src)
-#define zlist_head(l)               _Generic((l),    Z_ALL_LISTS(L_HEAD_ENTRY)    default: (void*)0)  (l)
-#define zlist_tail(l)               _Generic((l),    Z_ALL_LISTS(L_TAIL_ENTRY)    default: (void*)0)  (l)
-#define zlist_at(l, idx)            _Generic((l),    Z_ALL_LISTS(L_AT_ENTRY)      default: (void*)0)  (l, idx)
+#define zlist_reverse(l)            _Generic((l),    Z_ALL_LISTS(L_REVERSE_ENTRY) ZLIST_VARIANTS__(REVERSE) default: (void)0)  (l)
+#define zlist_detach_node(l, n)     _Generic((l),    Z_ALL_LISTS(L_DETACH_ENTRY)  ZLIST_VARIANTS__(DETACH)  default: (void*)0) (l, n)
+#define zlist_push_back(l, val)     _Generic((l),    Z_ALL_LISTS(L_PUSH_B_ENTRY)  ZLIST_VARIANTS__(PUSH_B)  default: 0)        (l, val)
+#define zlist_push_front(l, val)    _Generic((l),    Z_ALL_LISTS(L_PUSH_F_ENTRY)  ZLIST_VARIANTS__(PUSH_F)  default: 0)        (l, val)
+#define zlist_insert_after(l, n, v) _Generic((l),    Z_ALL_LISTS(L_INS_A_ENTRY)   ZLIST_VARIANTS__(INS_A)   default: 0)        (l, n, v)
+#define zlist_pop_back(l)           _Generic((l),    Z_ALL_LISTS(L_POP_B_ENTRY)   ZLIST_VARIANTS__(POP_B)   default: (void)0)  (l)
+#define zlist_pop_front(l)          _Generic((l),    Z_ALL_LISTS(L_POP_F_ENTRY)   ZLIST_VARIANTS__(POP_F)   default: (void)0)  (l)
+#define zlist_remove_node(l, n)     _Generic((l),    Z_ALL_LISTS(L_REM_N_ENTRY)   ZLIST_VARIANTS__(REM_N)   default: (void)0)  (l, n)
+#define zlist_clear(l)              _Generic((l),    Z_ALL_LISTS(L_CLEAR_ENTRY)   ZLIST_VARIANTS__(CLEAR)   default: (void)0)  (l)
+#define zlist_splice(dst, src)      _Generic((dst),  Z_ALL_LISTS(L_SPLICE_ENTRY)  ZLIST_VARIANTS__(SPLICE)  default: (void)0)  (dst, src)
+#define zlist_head(l)               _Generic((l),    Z_ALL_LISTS(L_HEAD_ENTRY)    ZLIST_VARIANTS__(HEAD)    default: (void*)0) (l)
+#define zlist_tail(l)               _Generic((l),    Z_ALL_LISTS(L_TAIL_ENTRY)    ZLIST_VARIANTS__(TAIL)    default: (void*)0) (l)
+#define zlist_at(l, idx)            _Generic((l),    Z_ALL_LISTS(L_AT_ENTRY)      ZLIST_VARIANTS__(AT)      default: (void*)0) (l, idx)
+
+// Unrolled lists: element access and cursors.
+#define zlist_front(l)              _Generic((l),    ZLIST_VARIANTS__(FRONT)                                default: (void*)0) (l)
+#define zlist_back(l)               _Generic((l),    ZLIST_VARIANTS__(BACK)                                 default: (void*)0) (l)
+#define zlist_iter_begin(l)         _Generic((l),    Z_ALL_UNROLLED_LISTS(LU_ITER_BEGIN_ENTRY)              default: 0)        (l)
+#define zlist_iter_valid(it)        _Generic((it),   Z_ALL_UNROLLED_LISTS(LU_ITER_VALID_ENTRY)              default: 0)        (it)
+#define zlist_iter_value(it)        _Generic((it),   Z_ALL_UNROLLED_LISTS(LU_ITER_VALUE_ENTRY)              default: (void*)0) (it)
+#define zlist_iter_next(it)         _Generic((it),   Z_ALL_UNROLLED_LISTS(LU_ITER_NEXT_ENTRY)               default: (void)0)  (it)
+
+// Runtime allocator (Z_ALLOCATOR_HANDLE, C only): l must still be empty, and only splice lists sharing it.
+#if defined(Z_ALLOCATOR_HANDLE) && !defined(__cplusplus)
+#   define L_ALLOC_ENTRY(T, Name)   zlist_##Name*: zlist_set_allocator_##Name,
+#   define LU_ALLOC_ENTRY(T, Name)  zlist_##Name*: zlist_set_allocator_##Name,
+#   define zlist_set_allocator(l, a) _Generic((l),   Z_ALL_LISTS(L_ALLOC_ENTRY) Z_ALL_UNROLLED_LISTS(LU_ALLOC_ENTRY) default: (void)0) (l, a)
+#endif
 
 // Explicit declaration macros
 #define zlist_foreach_decl(Name, l, iter) \
@@ -910,6 +1520,17 @@ Z_ALL_LISTS(ZLIST_GENERATE_IMPL)
              (iter) != NULL;                                                                    \
              (iter) = (safe_iter), (safe_iter) = (iter) ? (iter)->prev : NULL)
 
+#   define zlist_foreach_intrusive(l, link, iter) \
+        for (__typeof__((l)->head) iter = (l)->head; (iter) != NULL; (iter) = (iter)->link.next)
+
+#   define zlist_foreach_intrusive_safe(l, link, iter, safe_iter)                                   \
+        for (__typeof__((l)->head) iter = (l)->head, safe_iter = (iter) ? (iter)->link.next : NULL; \
+             (iter) != NULL;                                                                        \
+             (iter) = (safe_iter), (safe_iter) = (iter) ? (iter)->link.next : NULL)
+
+#   define zlist_foreach_unrolled(l, it) \
+        for (__typeof__(zlist_iter_begin(l)) it = zlist_iter_begin(l); zlist_iter_valid(&(it)); zlist_iter_next(&(it)))
+
 #else
 #   define zlist_foreach(l, iter) \
         for ((iter) = (l)->head; (iter) != NULL; (iter) = (iter)->next)
@@ -927,6 +1548,17 @@ Z_ALL_LISTS(ZLIST_GENERATE_IMPL)
              (iter) != NULL;                                                    \
              (iter) = (safe_iter), (safe_iter) = (iter) ? (iter)->prev : NULL)
 
+#   define zlist_foreach_intrusive(l, link, iter) \
+        for ((iter) = (l)->head; (iter) != NULL; (iter) = (iter)->link.next)
+
+#   define zlist_foreach_intrusive_safe(l, link, iter, safe_iter)                       \
+        for ((iter) = (l)->head, (safe_iter) = (iter) ? (iter)->link.next : NULL;       \
+             (iter) != NULL;                                                            \
+             (iter) = (safe_iter), (safe_iter) = (iter) ? (iter)->link.next : NULL)
+
+#   define zlist_foreach_unrolled(l, it) \
+        for ((it) = zlist_iter_begin(l); zlist_iter_valid(&(it)); zlist_iter_next(&(it)))
+
 #endif
 
 // Safe API macros (conditioned on zerror.h).
@@ -984,6 +1616,11 @@ Z_ALL_LISTS(ZLIST_GENERATE_IMPL)
 #   define list_foreach_safe            zlist_foreach_safe
 #   define list_foreach_rev             zlist_foreach_rev
 #   define list_foreach_rev_safe        zlist_foreach_rev_safe
+#   define list_front                   zlist_front
+#   define list_back                    zlist_back
+#   define list_foreach_intrusive       zlist_foreach_intrusive
+#   define list_foreach_intrusive_safe  zlist_foreach_intrusive_safe
+#   define list_foreach_unrolled        zlist_foreach_unrolled
 
 #   if Z_HAS_ZERROR && !defined(__cplusplus)
 #       define list_push_back_safe   zlist_push_back_safe
@@ -144,6 +144,58 @@
 
 
 #endif // Z_COMMON_BUNDLED
+
+// Runtime allocator handle. Not part of zcommon yet, so it stays outside the bundled block
+// above (regenerated from upstream); every ZDK header carries the same guarded copy.
+#ifndef Z_ALLOCATOR_HANDLE_DEFINED
+#define Z_ALLOCATOR_HANDLE_DEFINED
+
+/* * zalloc_t routes one container's memory through any allocator (arena, pool, ...).
+ * Containers only carry a handle when Z_ALLOCATOR_HANDLE is defined before the first
+ * ZDK include; otherwise they are laid out and compiled exactly as before.
+ * A NULL handle means the compile-time *_MALLOC macros. realloc and free also receive
+ * the old size, for allocators that do not track it.
+ */
+#ifndef Z_ALLOC_T_DEFINED
+#define Z_ALLOC_T_DEFINED
+typedef struct zalloc_t
+{
+    void *(*alloc)(void *ctx, size_t size);
+    void *(*realloc)(void *ctx, void *ptr, size_t old_size, size_t new_size);
+    void  (*free)(void *ctx, void *ptr, size_t size);
+    void *ctx;
+} zalloc_t;
+#endif
+
+#ifdef Z_ALLOCATOR_HANDLE
+#   define Z_ALLOCATOR_FIELD                   const zalloc_t *allocator;
+#   define Z_ALLOCATOR_INIT                    , NULL
+#   define Z_HMALLOC(h, sz, dflt)              ((h) ? (h)->alloc((h)->ctx, (sz)) : (dflt))
+#   define Z_HCALLOC(h, n, sz, dflt)           ((h) ? z_hcalloc__((h), (n), (sz)) : (dflt))
+#   define Z_HREALLOC(h, p, old_sz, sz, dflt)  ((h) ? (h)->realloc((h)->ctx, (p), (old_sz), (sz)) : (dflt))
+#   define Z_HFREE(h, p, sz, dflt)             ((h) ? ((p) ? (h)->free((h)->ctx, (p), (sz)) : (void)0) : (void)(dflt))
+    // Setter for a generated container; call it while the container owns no memory yet.
+#   define Z_GEN_SET_ALLOCATOR(Type, Fn)       static inline void Fn(Type *c, const zalloc_t *a) { c->allocator = a; }
+
+static inline void *z_hcalloc__(const zalloc_t *h, size_t n, size_t sz)
+{
+    if (0 != n && sz > SIZE_MAX / n) return NULL;
+    void *p = h->alloc(h->ctx, n * sz);
+    if (p) memset(p, 0, n * sz);
+    return p;
+}
+#else
+#   define Z_ALLOCATOR_FIELD
+#   define Z_ALLOCATOR_INIT
+#   define Z_HMALLOC(h, sz, dflt)              (dflt)
+#   define Z_HCALLOC(h, n, sz, dflt)           (dflt)
+#   define Z_HREALLOC(h, p, old_sz, sz, dflt)  (dflt)
+#   define Z_HFREE(h, p, sz, dflt)             (dflt)
+#   define Z_GEN_SET_ALLOCATOR(Type, Fn)
+#endif
+
+#endif // Z_ALLOCATOR_HANDLE_DEFINED
+
 /* ============================================================================ */
 
 
@@ -157,12 +209,15 @@
  *
  * Features:
  * • Open addressing with Robin Hood hashing (high load factors)
- * • Two storage modes:
+ * • Three storage modes:
  * 1. Standard: Keys/Values stored inline (fastest, cache-friendly)
  * 2. Stable: Values stored via pointer (stable addresses, like std::map)
- * • C++ z_map::map<K,V> with RAII and STL-compatible iterators
+ * 3. Flat: Swiss-table layout, 1-byte control tags probed 16 at a time (SSE2/NEON)
+ * • Concurrent maps: standard maps sharded behind per-shard zthread rwlocks, with batched get/put
+ * • C++ z_map::map<K,V> (and z_map::flat_map<K,V>) with RAII and STL-compatible iterators
  * • C++ complex type support (constructors/destructors called)
  * • Allocation failure returns Z_ENOMEM (fast path)
+ * • Bundled word-at-a-time (wyhash-style) default hash when zhash.h is absent
  *
  * License: MIT
  * Author: Zuhaitz
@@ -186,6 +241,29 @@
 #   define Z_HAS_ZERROR 0
 #endif
 
+// SIMD group probing for flat maps (define ZMAP_NO_SIMD to force the scalar path).
+#if !defined(Z_NO_EXTENSIONS) && !defined(ZMAP_NO_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#   include <emmintrin.h>
+#   define ZMAP_SIMD_SSE2 1
+#elif !defined(Z_NO_EXTENSIONS) && !defined(ZMAP_NO_SIMD) && \
+      (defined(__aarch64__) || defined(_M_ARM64))
+#   include <arm_neon.h>
+#   define ZMAP_SIMD_NEON 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#   include <intrin.h>
+#endif
+
+// Scanner markers for flat and concurrent maps (not part of the bundled zcommon block yet).
+#ifndef DEFINE_FLAT_MAP_TYPE
+#   define DEFINE_FLAT_MAP_TYPE(Key, Val, Name)
+#endif
+#ifndef DEFINE_CONCURRENT_MAP_TYPE
+#   define DEFINE_CONCURRENT_MAP_TYPE(Key, Val, Name)
+#endif
+
 // Shared enum.
 typedef enum
 {
@@ -204,10 +282,6 @@ typedef enum
 
 namespace z_map
 {
-    // Forward declarations.
-    template <typename K, typename V> struct map;
-    template <typename K, typename V> class map_iterator;
-
     template <typename K, typename V>
     struct traits
     {
@@ -215,6 +289,16 @@ namespace z_map
     };
 
     template <typename K, typename V>
+    struct flat_traits
+    {
+        static_assert(0 == sizeof(K), "No flat zmap implementation registered for this key/value pair.");
+    };
+
+    // Forward declarations.
+    template <typename K, typename V, template <typename, typename> class Tr = traits> struct map;
+    template <typename K, typename V, template <typename, typename> class Tr = traits> class map_iterator;
+
+    template <typename K, typename V, template <typename, typename> class Tr>
     class map_iterator
     {
     public:
@@ -223,7 +307,7 @@ namespace z_map
         using KeyT = typename std::remove_const<K>::type;
         using ValT = typename std::remove_const<V>::type;
         
-        using MapTraits = traits<KeyT, ValT>;
+        using MapTraits = Tr<KeyT, ValT>;
         using CMap = typename MapTraits::map_type;
         using CBucket = typename MapTraits::bucket_type;
 
@@ -238,7 +322,7 @@ namespace z_map
         {
             if (map_ptr && index < map_ptr->capacity) 
             {
-                if (ZMAP_EMPTY == map_ptr->buckets[index].state)
+                if (!MapTraits::occupied(map_ptr, index))
                 {
                     advance();
                 }
@@ -247,12 +331,12 @@ namespace z_map
 
         reference operator*() const
         { 
-            return map_ptr->buckets[index];
+            return *MapTraits::slot(map_ptr, index);
         }
 
         pointer operator->() const
         {
-            return &map_ptr->buckets[index];
+            return MapTraits::slot(map_ptr, index);
         }
 
         bool operator==(const map_iterator &other) const
@@ -285,7 +369,7 @@ namespace z_map
     private:
         void advance() 
         {
-            while (index < map_ptr->capacity && ZMAP_EMPTY == map_ptr->buckets[index].state) 
+            while (index < map_ptr->capacity && !MapTraits::occupied(map_ptr, index)) 
             {
                 index++;
             }
@@ -295,20 +379,20 @@ namespace z_map
         size_t index;
     };
 
-    template <typename K, typename V>
+    template <typename K, typename V, template <typename, typename> class Tr>
     struct map
     {
-        using Traits = traits<K, V>;
+        using Traits = Tr<K, V>;
         using c_map = typename Traits::map_type;
-        using iterator = map_iterator<K, V>;
-        using const_iterator = map_iterator<const K, const V>;
+        using iterator = map_iterator<K, V, Tr>;
+        using const_iterator = map_iterator<const K, const V, Tr>;
 
         c_map inner;
 
         using HashFunc = uint32_t (*)(K, uint32_t);
         using CmpFunc = int (*)(K, K);
 
-        map(HashFunc h, CmpFunc c, uint32_t seed = 0xCAFEBABE, float load_factor = 0.85f) 
+        map(HashFunc h, CmpFunc c, uint32_t seed = 0xCAFEBABE, float load_factor = Traits::default_load) 
             : inner(Traits::init(h, c, load_factor)) 
         {
             Traits::set_seed(&inner, seed);
@@ -397,6 +481,14 @@ namespace z_map
             Traits::clear(&inner);
         }
 
+        void reserve(size_t n)
+        {
+            if (Z_OK != Traits::reserve(&inner, n))
+            {
+                throw std::bad_alloc();
+            }
+        }
+
         size_t size() const
         {
             return inner.count;
@@ -427,6 +519,10 @@ namespace z_map
             return const_iterator((c_map *)&inner, inner.capacity);
         }
     };
+
+    // Swiss-table backed map; same interface as z_map::map.
+    template <typename K, typename V>
+    using flat_map = map<K, V, flat_traits>;
 }
 extern "C" {
 #endif // __cplusplus
@@ -449,6 +545,16 @@ extern "C" {
 #   define ZMAP_FREE(p)         Z_FREE(p)
 #endif
 
+// Table and value storage goes through the map's zalloc_t handle when it carries one.
+#define ZMAP_HMALLOC__(m, sz)     Z_HMALLOC((m)->allocator, sz, ZMAP_MALLOC(sz))
+#define ZMAP_HCALLOC__(m, n, sz)  Z_HCALLOC((m)->allocator, n, sz, ZMAP_CALLOC(n, sz))
+#define ZMAP_HFREE__(m, p, sz)    Z_HFREE((m)->allocator, p, sz, ZMAP_FREE(p))
+#ifdef Z_ALLOCATOR_HANDLE
+#   define ZMAP_ALLOCATOR_INIT__  , .allocator = NULL
+#else
+#   define ZMAP_ALLOCATOR_INIT__
+#endif
+
 // Load factor configuration.
 #define ZMAP_DEFAULT_LOAD 0.85f
 
@@ -462,21 +568,134 @@ extern "C" {
 #   define ZMAP_HAS_ZHASH 0
 #endif
 
+// FNV-1a, byte at a time. Kept for users that depend on its exact values.
+static inline uint32_t zmap_fnv1a_hash(const void *key, size_t len, uint32_t seed) 
+{
+    uint32_t hash = 2166136261u ^ seed;
+    const uint8_t *data = (const uint8_t *)key;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= data[i];
+        hash *= 16777619;
+    }
+    return hash;
+}
+
+/*
+ * wyhash-style word-at-a-time hash.
+ * Consumes 8 bytes per load (48 per round on long keys, in three independent
+ * lanes) and folds with a 64x64->128 multiply. Loads go through memcpy, so
+ * keys need no alignment. The 32-bit result is the xor-fold of the 64-bit one.
+ */
+static inline void zmap_mum(uint64_t *a, uint64_t *b)
+{
+#if defined(__SIZEOF_INT128__) && !defined(Z_NO_EXTENSIONS)
+    __extension__ typedef unsigned __int128 zmap_u128;
+    zmap_u128 r = (zmap_u128)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64) && !defined(Z_NO_EXTENSIONS)
+    *a = _umul128(*a, *b, b);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline uint64_t zmap_wymix(uint64_t a, uint64_t b)
+{
+    zmap_mum(&a, &b);
+    return a ^ b;
+}
+
+static inline uint64_t zmap_read64(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t zmap_read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t zmap_wyhash(const void *key, size_t len, uint32_t seed)
+{
+    static const uint64_t s0 = 0x2d358dccaa6c78a5ull;
+    static const uint64_t s1 = 0x8bb84b93962eacc9ull;
+    static const uint64_t s2 = 0x4b33a62ed433d4a3ull;
+    static const uint64_t s3 = 0x4d5a2da51de1aa47ull;
+    const uint8_t *p = (const uint8_t *)key;
+    uint64_t h = zmap_wymix((uint64_t)seed ^ s0, s1);
+    uint64_t a, b;
+    if (len <= 16)
+    {
+        if (len >= 4)
+        {
+            size_t off = (len >> 3) << 2;
+            a = (zmap_read32(p) << 32) | zmap_read32(p + off);
+            b = (zmap_read32(p + len - 4) << 32) | zmap_read32(p + len - 4 - off);
+        }
+        else if (len > 0)
+        {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        }
+        else
+        {
+            a = 0;
+            b = 0;
+        }
+    }
+    else
+    {
+        size_t i = len;
+        if (i > 48)
+        {
+            uint64_t h1 = h, h2 = h;
+            do
+            {
+                h  = zmap_wymix(zmap_read64(p) ^ s1, zmap_read64(p + 8) ^ h);
+                h1 = zmap_wymix(zmap_read64(p + 16) ^ s2, zmap_read64(p + 24) ^ h1);
+                h2 = zmap_wymix(zmap_read64(p + 32) ^ s3, zmap_read64(p + 40) ^ h2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            h ^= h1 ^ h2;
+        }
+        while (i > 16)
+        {
+            h = zmap_wymix(zmap_read64(p) ^ s1, zmap_read64(p + 8) ^ h);
+            p += 16;
+            i -= 16;
+        }
+        a = zmap_read64(p + i - 16);
+        b = zmap_read64(p + i - 8);
+    }
+    a ^= s1;
+    b ^= h;
+    zmap_mum(&a, &b);
+    h = zmap_wymix(a ^ s0 ^ (uint64_t)len, b ^ s1);
+    return (uint32_t)(h ^ (h >> 32));
+}
+
 #ifndef ZMAP_HASH_FUNC
 #   if ZMAP_HAS_ZHASH
 #       define ZMAP_HASH_FUNC(key, len, seed) zhash_fast(key, len, seed)
 #   else
-        // FNV-1a inline fallback.
+        // Bundled default: wyhash-style (define ZMAP_HASH_FUNC to zmap_fnv1a_hash for the old values).
         static inline uint32_t zmap_default_hash(const void *key, size_t len, uint32_t seed) 
         {
-            uint32_t hash = 2166136261u ^ seed;
-            const uint8_t *data = (const uint8_t *)key;
-            for (size_t i = 0; i < len; i++)
-            {
-                hash ^= data[i];
-                hash *= 16777619;
-            }
-            return hash;
+            return zmap_wyhash(key, len, seed);
         }
         #define ZMAP_HASH_FUNC(key, len, seed) zmap_default_hash(key, len, seed)
     #endif
@@ -520,6 +739,166 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
     return (index + capacity) - home;
 }
 
+/*
+ * Flat map control bytes.
+ * Each slot has one tag: EMPTY, DELETED (tombstone) or FULL, where a FULL tag
+ * holds the low 7 bits of the hash (the high bit is clear). Tags are scanned a
+ * group of ZMAP_GROUP_WIDTH at a time, so a miss usually costs one group load.
+ */
+#define ZMAP_CTRL_EMPTY   ((uint8_t)0x80)
+#define ZMAP_CTRL_DELETED ((uint8_t)0xFE)
+#define ZMAP_GROUP_WIDTH  16
+#define ZMAP_FLAT_DEFAULT_LOAD 0.875f
+
+/*
+ * Cached hashes store the full 32-bit hash in each flat slot. Resize then never
+ * calls the hash function again and key comparison is skipped on hash mismatch;
+ * worth it for string or other expensive keys.
+ *
+ * The choice is per type: maps listed in REGISTER_FLAT_CACHED_MAPS(X) always
+ * cache, maps in REGISTER_FLAT_MAPS(X) follow ZMAP_FLAT_CACHE_HASH. That macro
+ * is global (0 or 1, default 0) and applies to every such type in the
+ * translation unit, so define it identically wherever zmap.h is included.
+ */
+#ifndef ZMAP_FLAT_CACHE_HASH
+#   define ZMAP_FLAT_CACHE_HASH 0
+#endif
+
+// Slot hash helpers, selected by the generator's Cache argument (0 or 1).
+#define ZMAP_FLAT_HASH_FIELD__(Cache)        ZMAP_FLAT_HASH_FIELD_##Cache##__
+#define ZMAP_FLAT_SLOT_HASH__(Cache)         ZMAP_FLAT_SLOT_HASH_##Cache##__
+#define ZMAP_FLAT_SET_HASH__(Cache)          ZMAP_FLAT_SET_HASH_##Cache##__
+#define ZMAP_FLAT_HASH_EQ__(Cache)           ZMAP_FLAT_HASH_EQ_##Cache##__
+
+#define ZMAP_FLAT_HASH_FIELD_1__             uint32_t stored_hash;
+#define ZMAP_FLAT_SLOT_HASH_1__(m, slot)     ((slot).stored_hash)
+#define ZMAP_FLAT_SET_HASH_1__(slot, h)      ((slot).stored_hash = (h))
+#define ZMAP_FLAT_HASH_EQ_1__(slot, h)       ((slot).stored_hash == (h))
+
+#define ZMAP_FLAT_HASH_FIELD_0__
+#define ZMAP_FLAT_SLOT_HASH_0__(m, slot)     ((m)->hash_func((slot).key, (m)->seed))
+#define ZMAP_FLAT_SET_HASH_0__(slot, h)      ((void)0)
+#define ZMAP_FLAT_HASH_EQ_0__(slot, h)       1
+
+static inline uint8_t zmap_ctrl_h2(uint32_t hash)
+{
+    return (uint8_t)(hash & 0x7F);
+}
+
+static inline size_t zmap_group_index(uint32_t hash, uint32_t group_bits)
+{
+    if (0 == group_bits)
+    {
+        return 0;
+    }
+    return zmap_fib_index(hash, group_bits);
+}
+
+static inline uint32_t zmap_ctz32(uint32_t x)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long idx;
+    _BitScanForward(&idx, x);
+    return (uint32_t)idx;
+#elif defined(__GNUC__) || defined(__clang__)
+    return (uint32_t)__builtin_ctz(x);
+#else
+    uint32_t n = 0;
+    while (0 == (x & 1u))
+    {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+#if defined(ZMAP_SIMD_NEON)
+    static inline uint32_t zmap_neon_movemask(uint8x16_t v)
+    {
+        static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128,
+                                             1, 2, 4, 8, 16, 32, 64, 128 };
+        uint8x16_t bits = vandq_u8(v, vld1q_u8(weights));
+        return (uint32_t)vaddv_u8(vget_low_u8(bits)) | ((uint32_t)vaddv_u8(vget_high_u8(bits)) << 8);
+    }
+#endif
+
+// Bitmask of the slots in the group whose tag equals h2.
+static inline uint32_t zmap_group_match(const uint8_t *group, uint8_t h2)
+{
+#if defined(ZMAP_SIMD_SSE2)
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)h2)));
+#elif defined(ZMAP_SIMD_NEON)
+    return zmap_neon_movemask(vceqq_u8(vld1q_u8(group), vdupq_n_u8(h2)));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < ZMAP_GROUP_WIDTH; i++)
+    {
+        if (h2 == group[i])
+        {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+// Bitmask of the EMPTY slots in the group.
+static inline uint32_t zmap_group_match_empty(const uint8_t *group)
+{
+    return zmap_group_match(group, ZMAP_CTRL_EMPTY);
+}
+
+// Bitmask of the EMPTY or DELETED slots in the group (tags with the high bit set).
+static inline uint32_t zmap_group_match_free(const uint8_t *group)
+{
+#if defined(ZMAP_SIMD_SSE2)
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+#elif defined(ZMAP_SIMD_NEON)
+    return zmap_neon_movemask(vcltq_s8(vreinterpretq_s8_u8(vld1q_u8(group)), vdupq_n_s8(0)));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < ZMAP_GROUP_WIDTH; i++)
+    {
+        if (group[i] & 0x80)
+        {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+/*
+ * First EMPTY or DELETED slot on the probe sequence of `hash`.
+ * Groups are visited with triangular probing, which covers every group of a
+ * power-of-two table. The table always keeps at least one EMPTY slot.
+ */
+static inline size_t zmap_flat_find_free(const uint8_t *ctrl, size_t capacity,
+                                         uint32_t group_bits, uint32_t hash)
+{
+    size_t group_mask = (capacity / ZMAP_GROUP_WIDTH) - 1;
+    size_t g = zmap_group_index(hash, group_bits);
+    size_t step = 0;
+    for (;;)
+    {
+        uint32_t mask = zmap_group_match_free(ctrl + g * ZMAP_GROUP_WIDTH);
+        if (mask)
+        {
+            return g * ZMAP_GROUP_WIDTH + zmap_ctz32(mask);
+        }
+        step++;
+        g = (g + step) & group_mask;
+    }
+}
+
+static inline size_t zmap_flat_growth(size_t capacity, float load_factor)
+{
+    size_t limit = (size_t)((float)capacity * load_factor);
+    return (limit >= capacity) ? capacity - 1 : limit;
+}
+
 // Safe API logic.
 #if Z_HAS_ZERROR
     static inline zerr zmap_err_impl(int code, const char* msg, const char* file, int line, const char* func) 
@@ -550,16 +929,146 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
             }                                                                                       \
             return ResPtr_##Name##_ok(ptr);                                                         \
         }
+
+    #define ZMAP_GEN_FLAT_SAFE_IMPL(KeyT, ValT, Name)                                               \
+        DEFINE_RESULT(ValT*, ResPtr_flat_##Name)                                                    \
+                                                                                                    \
+        static inline zres zmap_put_safe_flat_##Name(zmap_flat_##Name *m, KeyT k, ValT v,           \
+                                                    const char* f, int l, const char* fn)           \
+        {                                                                                           \
+            if (zmap_put_flat_##Name(m, k, v) != Z_OK)                                              \
+            {                                                                                       \
+                return zres_err(zmap_err_impl(Z_ENOMEM, "Map Put OOM", f, l, fn));                  \
+            }                                                                                       \
+            return zres_ok();                                                                       \
+        }                                                                                           \
+                                                                                                    \
+        static inline ResPtr_flat_##Name zmap_get_safe_flat_##Name(zmap_flat_##Name *m, KeyT k,     \
+                                                                  const char* f, int l,             \
+                                                                  const char* fn)                   \
+        {                                                                                           \
+            ValT* ptr = zmap_get_flat_##Name(m, k);                                                 \
+            if (!ptr)                                                                               \
+            {                                                                                       \
+                return ResPtr_flat_##Name##_err(zmap_err_impl(Z_ENOTFOUND, "Key not found",         \
+                                                              f, l, fn));                           \
+            }                                                                                       \
+            return ResPtr_flat_##Name##_ok(ptr);                                                    \
+        }
 #else
 #   define ZMAP_GEN_SAFE_IMPL(KeyT, ValT, Name)
+#   define ZMAP_GEN_FLAT_SAFE_IMPL(KeyT, ValT, Name)
+#endif
+
+
+/*
+ * Pooled stable-map values.
+ * When zalloc.h (with ZALLOC_ENABLE_POOL) is included before zmap.h, a stable map created with
+ * zmap_init_stable_pool_##Name draws its value slots from a zpool it owns. Free and clear then
+ * release whole slabs instead of one allocation per entry.
+ */
+#if defined(ZALLOC_H) && defined(ZALLOC_ENABLE_POOL)
+#   define ZMAP_HAS_ZPOOL 1
+#else
+#   define ZMAP_HAS_ZPOOL 0
+#endif
+
+#ifndef ZMAP_POOL_DEFAULT_BLOCK
+#   define ZMAP_POOL_DEFAULT_BLOCK 256
 #endif
 
+#if ZMAP_HAS_ZPOOL
+#   define ZMAP_STABLE_POOL_FIELDS__ zpool value_pool; bool pooled;
+#   define ZMAP_STABLE_POOLED__(m)   ((m)->pooled)
+#   define ZMAP_STABLE_POOL_INIT__   , .value_pool = ZPOOL_INIT_ZERO__, .pooled = false
+    // Drops every slab but keeps the pool geometry so the map stays usable.
+#   define ZMAP_STABLE_POOL_RESET__(m)                                          \
+        do                                                                      \
+        {                                                                       \
+            if ((m)->pooled)                                                    \
+            {                                                                   \
+                size_t item_size__ = (m)->value_pool.item_size;                 \
+                size_t per_block__ = (m)->value_pool.count_per_block;           \
+                zpool_free(&(m)->value_pool);                                   \
+                zpool_init(&(m)->value_pool, item_size__, per_block__);         \
+            }                                                                   \
+        } while (0)
+#   ifdef __cplusplus
+}   // extern "C"
+    template <typename T>
+    static inline T *zmap_stable_new__(zpool *pool, bool pooled, const T &val)
+    {
+        if (!pooled)
+        {
+            return new T(val);
+        }
+        void *raw = zpool_alloc(pool);
+        if (!raw)
+        {
+            throw std::bad_alloc();
+        }
+        try
+        {
+            return new (raw) T(val);
+        }
+        catch (...)
+        {
+            zpool_recycle(pool, raw);
+            throw;
+        }
+    }
+
+    template <typename T>
+    static inline void zmap_stable_delete__(zpool *pool, bool pooled, T *ptr)
+    {
+        if (!pooled)
+        {
+            delete ptr;
+            return;
+        }
+        ptr->~T();
+        zpool_recycle(pool, ptr);
+    }
+extern "C" {
+#       define ZMAP_STABLE_NEW__(m, T, v)     zmap_stable_new__<T>(&(m)->value_pool, (m)->pooled, (v))
+#       define ZMAP_STABLE_DELETE__(m, p)     zmap_stable_delete__(&(m)->value_pool, (m)->pooled, (p))
+#       define ZMAP_STABLE_NEEDS_WALK__(m, T) (!(m)->pooled || !std::is_trivially_destructible<T>::value)
+#   else
+#       define ZMAP_STABLE_ALLOC__(m, T)      ((m)->pooled ? zpool_alloc(&(m)->value_pool) : ZMAP_HMALLOC__(m, sizeof(T)))
+#       define ZMAP_STABLE_RELEASE__(m, p)                                      \
+            do                                                                  \
+            {                                                                   \
+                if ((m)->pooled)                                                \
+                {                                                               \
+                    zpool_recycle(&(m)->value_pool, (p));                       \
+                }                                                               \
+                else                                                            \
+                {                                                               \
+                    ZMAP_HFREE__(m, p, sizeof(*(p)));                           \
+                }                                                               \
+            } while (0)
+#   endif
+#else
+#   define ZMAP_STABLE_POOL_FIELDS__
+#   define ZMAP_STABLE_POOL_INIT__
+#   define ZMAP_STABLE_POOLED__(m)        0
+#   define ZMAP_STABLE_POOL_RESET__(m)    ((void)0)
+#   define ZMAP_STABLE_NEW__(m, T, v)     new T(v)
+#   define ZMAP_STABLE_DELETE__(m, p)     delete (p)
+#   define ZMAP_STABLE_NEEDS_WALK__(m, T) 1
+#   define ZMAP_STABLE_ALLOC__(m, T)      ZMAP_HMALLOC__(m, sizeof(T))
+#   define ZMAP_STABLE_RELEASE__(m, p)    ZMAP_HFREE__(m, p, sizeof(*(p)))
+#endif
 
 /* * Implementation injection (C vs C++).
  * C++ uses new/delete/move for proper RAII.
  * C uses calloc/free/struct-copy.
  */
 #ifdef __cplusplus
+#   define ZMAP_TRY__   try
+#   define ZMAP_CATCH__ catch (...)
+    // new[]/delete[] run constructors, so C++ maps never route through a zalloc_t.
+#   define ZMAP_GEN_SET_ALLOCATOR__(Type, Fn)
 #   define ZMAP_IMPL_OPS(KeyT, ValT, Name)                                                                          \
         static inline void zmap_free_##Name(zmap_##Name *m)                                                         \
         {                                                                                                           \
@@ -635,7 +1144,7 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
             }                                                                                                       \
         }                                                                                                           \
                                                                                                                     \
-        static inline int zmap_put_##Name(zmap_##Name *m, KeyT key, ValT val)                                       \
+        static inline int zmap_put_with_hash_##Name(zmap_##Name *m, KeyT key, ValT val, uint32_t hash)              \
         {                                                                                                           \
             try                                                                                                     \
             {                                                                                                       \
@@ -647,7 +1156,6 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
                         return Z_ENOMEM;                                                                            \
                     }                                                                                               \
                 }                                                                                                   \
-                uint32_t hash = m->hash_func(key, m->seed);                                                         \
                 size_t idx = zmap_fib_index(hash, m->bits);                                                         \
                 size_t dist = 0;                                                                                    \
                 zmap_bucket_##Name entry;                                                                           \
@@ -680,6 +1188,11 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
             {                                                                                                       \
                 return Z_ENOMEM;                                                                                    \
             }                                                                                                       \
+        }                                                                                                           \
+                                                                                                                    \
+        static inline int zmap_put_##Name(zmap_##Name *m, KeyT key, ValT val)                                       \
+        {                                                                                                           \
+            return zmap_put_with_hash_##Name(m, key, val, m->hash_func(key, m->seed));                              \
         }
 
 #   define ZMAP_IMPL_STABLE_OPS(KeyT, ValT, Name)                                                                   \
@@ -687,16 +1200,21 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
         {                                                                                                           \
             if (m->buckets)                                                                                         \
             {                                                                                                       \
-                for (size_t i = 0; i < m->capacity; i++)                                                            \
+                for (size_t i = 0; ZMAP_STABLE_NEEDS_WALK__(m, ValT) && i < m->capacity; i++)                       \
                 {                                                                                                   \
                     if (ZMAP_OCCUPIED == m->buckets[i].state)                                                       \
                     {                                                                                               \
-                        delete m->buckets[i].value;                                                                 \
+                        ZMAP_STABLE_DELETE__(m, m->buckets[i].value);                                               \
                     }                                                                                               \
                 }                                                                                                   \
                 delete[] m->buckets;                                                                                \
             }                                                                                                       \
-            *m = (zmap_stable_##Name){0};                                                                           \
+            ZMAP_STABLE_POOL_RESET__(m);                                                                            \
+            m->buckets = nullptr;                                                                                   \
+            m->capacity = 0;                                                                                        \
+            m->count = 0;                                                                                           \
+            m->threshold = 0;                                                                                       \
+            m->bits = 0;                                                                                            \
         }                                                                                                           \
                                                                                                                     \
         static inline void zmap_clear_stable_##Name(zmap_stable_##Name *m)                                          \
@@ -780,7 +1298,7 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
                     {                                                                                               \
                         if (!entry.value)                                                                           \
                         {                                                                                           \
-                            entry.value = new ValT(val);                                                            \
+                            entry.value = ZMAP_STABLE_NEW__(m, ValT, val);                                          \
                         }                                                                                           \
                         m->buckets[idx] = entry;                                                                    \
                         m->count++;                                                                                 \
@@ -796,7 +1314,7 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
                     {                                                                                               \
                         if (!entry.value)                                                                           \
                         {                                                                                           \
-                            entry.value = new ValT(val);                                                            \
+                            entry.value = ZMAP_STABLE_NEW__(m, ValT, val);                                          \
                         }                                                                                           \
                         std::swap(m->buckets[idx], entry);                                                          \
                         dist = existing_dist;                                                                       \
@@ -809,15 +1327,101 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
                 return Z_ENOMEM;                                                                                    \
             }                                                                                                       \
         }                                                                                                           \
-        static inline void zmap_remove_val_stable_##Name(ValT *ptr)                                                 \
+        static inline void zmap_remove_val_stable_##Name(zmap_stable_##Name *m, ValT *ptr)                          \
+        {                                                                                                           \
+            (void)m;                                                                                                \
+            ZMAP_STABLE_DELETE__(m, ptr);                                                                           \
+        }
+
+#   define ZMAP_IMPL_FLAT_OPS(KeyT, ValT, Name, Cache)                                                              \
+        static inline void zmap_free_flat_##Name(zmap_flat_##Name *m)                                               \
+        {                                                                                                           \
+            if (m->slots)                                                                                           \
+            {                                                                                                       \
+                delete[] m->slots;                                                                                  \
+            }                                                                                                       \
+            if (m->ctrl)                                                                                            \
+            {                                                                                                       \
+                delete[] m->ctrl;                                                                                   \
+            }                                                                                                       \
+            m->slots = nullptr;                                                                                     \
+            m->ctrl = nullptr;                                                                                      \
+            m->capacity = 0;                                                                                        \
+            m->count = 0;                                                                                           \
+            m->growth_left = 0;                                                                                     \
+            m->bits = 0;                                                                                            \
+        }                                                                                                           \
+                                                                                                                    \
+        static inline void zmap_clear_flat_##Name(zmap_flat_##Name *m)                                              \
+        {                                                                                                           \
+            zmap_free_flat_##Name(m);                                                                               \
+        }                                                                                                           \
+                                                                                                                    \
+        static inline int zmap_resize_flat_##Name(zmap_flat_##Name *m, size_t new_cap)                              \
         {                                                                                                           \
-            delete ptr;                                                                                             \
+            if (new_cap < ZMAP_GROUP_WIDTH)                                                                         \
+            {                                                                                                       \
+                new_cap = ZMAP_GROUP_WIDTH;                                                                         \
+            }                                                                                                       \
+            if (new_cap > PTRDIFF_MAX / sizeof(zmap_bucket_flat_##Name))                                            \
+            {                                                                                                       \
+                return Z_ENOMEM;                                                                                    \
+            }                                                                                                       \
+            uint8_t *new_ctrl = new (std::nothrow) uint8_t[new_cap];                                                \
+            if (!new_ctrl)                                                                                          \
+            {                                                                                                       \
+                return Z_ENOMEM;                                                                                    \
+            }                                                                                                       \
+            try                                                                                                     \
+            {                                                                                                       \
+                zmap_bucket_flat_##Name *new_slots = new zmap_bucket_flat_##Name[new_cap]();                        \
+                memset(new_ctrl, ZMAP_CTRL_EMPTY, new_cap);                                                         \
+                uint32_t new_bits = 0;                                                                              \
+                size_t temp = new_cap / ZMAP_GROUP_WIDTH;                                                           \
+                while (temp >>= 1)                                                                                  \
+                {                                                                                                   \
+                    new_bits++;                                                                                     \
+                }                                                                                                   \
+                for (size_t i = 0; i < m->capacity; i++)                                                            \
+                {                                                                                                   \
+                    if (0 == (m->ctrl[i] & 0x80))                                                                   \
+                    {                                                                                               \
+                        uint32_t hash = ZMAP_FLAT_SLOT_HASH__(Cache)(m, m->slots[i]);                               \
+                        size_t idx = zmap_flat_find_free(new_ctrl, new_cap, new_bits, hash);                        \
+                        new_ctrl[idx] = zmap_ctrl_h2(hash);                                                         \
+                        new_slots[idx] = std::move(m->slots[i]);                                                    \
+                    }                                                                                               \
+                }                                                                                                   \
+                if (m->slots)                                                                                       \
+                {                                                                                                   \
+                    delete[] m->slots;                                                                              \
+                }                                                                                                   \
+                if (m->ctrl)                                                                                        \
+                {                                                                                                   \
+                    delete[] m->ctrl;                                                                               \
+                }                                                                                                   \
+                m->slots = new_slots;                                                                               \
+                m->ctrl = new_ctrl;                                                                                 \
+                m->capacity = new_cap;                                                                              \
+                m->bits = new_bits;                                                                                 \
+                m->growth_left = zmap_flat_growth(new_cap, m->load_factor) - m->count;                              \
+                return Z_OK;                                                                                        \
+            }                                                                                                       \
+            catch (...)                                                                                             \
+            {                                                                                                       \
+                delete[] new_ctrl;                                                                                  \
+                return Z_ENOMEM;                                                                                    \
+            }                                                                                                       \
         }
 #else
+#   define ZMAP_TRY__   if (1)
+#   define ZMAP_CATCH__ else
+#   define ZMAP_GEN_SET_ALLOCATOR__(Type, Fn) Z_GEN_SET_ALLOCATOR(Type, Fn)
 #   define ZMAP_IMPL_OPS(KeyT, ValT, Name)                                                                              \
         static inline void zmap_free_##Name(zmap_##Name *m)                                                             \
         {                                                                                                               \
-            ZMAP_FREE(m->buckets); *m = (zmap_##Name){0};                                                               \
+            ZMAP_HFREE__(m, m->buckets, m->capacity * sizeof(zmap_bucket_##Name));                                      \
+            *m = (zmap_##Name){0};                                                                                      \
         }                                                                                                               \
                                                                                                                         \
         static inline void zmap_clear_##Name(zmap_##Name *m)                                                            \
@@ -831,7 +1435,8 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
                                                                                                                         \
         static inline int zmap_resize_##Name(zmap_##Name *m, size_t new_cap)                                            \
         {                                                                                                               \
-            zmap_bucket_##Name *new_buckets = (zmap_bucket_##Name*)ZMAP_CALLOC(new_cap, sizeof(zmap_bucket_##Name));    \
+            zmap_bucket_##Name *new_buckets = (zmap_bucket_##Name*)                                                     \
+                ZMAP_HCALLOC__(m, new_cap, sizeof(zmap_bucket_##Name));                                                 \
             if (!new_buckets)                                                                                           \
             {                                                                                                           \
                 return Z_ENOMEM;                                                                                        \
@@ -870,7 +1475,7 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
                     }                                                                                                   \
                 }                                                                                                       \
             }                                                                                                           \
-            ZMAP_FREE(m->buckets);                                                                                      \
+            ZMAP_HFREE__(m, m->buckets, m->capacity * sizeof(zmap_bucket_##Name));                                      \
             m->buckets = new_buckets;                                                                                   \
             m->capacity = new_cap;                                                                                      \
             m->bits = new_bits;                                                                                         \
@@ -878,7 +1483,7 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
             return Z_OK;                                                                                                \
         }                                                                                                               \
                                                                                                                         \
-        static inline int zmap_put_##Name(zmap_##Name *m, KeyT key, ValT val)                                           \
+        static inline int zmap_put_with_hash_##Name(zmap_##Name *m, KeyT key, ValT val, uint32_t hash)                  \
         {                                                                                                               \
             if (m->count >= m->threshold)                                                                               \
             {                                                                                                           \
@@ -888,7 +1493,6 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
                     return Z_ENOMEM;                                                                                    \
                 }                                                                                                       \
             }                                                                                                           \
-            uint32_t hash = m->hash_func(key, m->seed);                                                                 \
             size_t idx = zmap_fib_index(hash, m->bits);                                                                 \
             size_t dist = 0;                                                                                            \
             zmap_bucket_##Name entry = (zmap_bucket_##Name){                                                            \
@@ -917,6 +1521,11 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
                 idx = (idx + 1) & (m->capacity - 1);                                                                    \
                 dist++;                                                                                                 \
             }                                                                                                           \
+        }                                                                                                               \
+                                                                                                                        \
+        static inline int zmap_put_##Name(zmap_##Name *m, KeyT key, ValT val)                                           \
+        {                                                                                                               \
+            return zmap_put_with_hash_##Name(m, key, val, m->hash_func(key, m->seed));                                  \
         }
 
 #   define ZMAP_IMPL_STABLE_OPS(KeyT, ValT, Name)                                                               \
@@ -924,16 +1533,21 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
         {                                                                                                       \
             if (m->buckets)                                                                                     \
             {                                                                                                   \
-                for (size_t i = 0; i < m->capacity; i++)                                                        \
+                for (size_t i = 0; !ZMAP_STABLE_POOLED__(m) && i < m->capacity; i++)                            \
                 {                                                                                               \
                     if (ZMAP_OCCUPIED == m->buckets[i].state)                                                   \
                     {                                                                                           \
-                        ZMAP_FREE(m->buckets[i].value);                                                         \
+                        ZMAP_HFREE__(m, m->buckets[i].value, sizeof(ValT));                                     \
                     }                                                                                           \
                 }                                                                                               \
-                ZMAP_FREE(m->buckets);                                                                          \
+                ZMAP_HFREE__(m, m->buckets, m->capacity * sizeof(zmap_bucket_stable_##Name));                   \
             }                                                                                                   \
-            *m = (zmap_stable_##Name){0};                                                                       \
+            ZMAP_STABLE_POOL_RESET__(m);                                                                        \
+            m->buckets = NULL;                                                                                  \
+            m->capacity = 0;                                                                                    \
+            m->count = 0;                                                                                       \
+            m->threshold = 0;                                                                                   \
+            m->bits = 0;                                                                                        \
         }                                                                                                       \
                                                                                                                 \
         static inline void zmap_clear_stable_##Name(zmap_stable_##Name *m)                                      \
@@ -944,7 +1558,7 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
         static inline int zmap_resize_stable_##Name(zmap_stable_##Name *m, size_t new_cap)                      \
         {                                                                                                       \
             zmap_bucket_stable_##Name *new_buckets = (zmap_bucket_stable_##Name*)                               \
-                                                     ZMAP_CALLOC(new_cap, sizeof(zmap_bucket_stable_##Name));   \
+                ZMAP_HCALLOC__(m, new_cap, sizeof(zmap_bucket_stable_##Name));                                  \
             if (!new_buckets)                                                                                   \
             {                                                                                                   \
                 return Z_ENOMEM;                                                                                \
@@ -983,7 +1597,7 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
                     }                                                                                           \
                 }                                                                                               \
             }                                                                                                   \
-            ZMAP_FREE(m->buckets);                                                                              \
+            ZMAP_HFREE__(m, m->buckets, m->capacity * sizeof(zmap_bucket_stable_##Name));                       \
             m->buckets = new_buckets;                                                                           \
             m->capacity = new_cap;                                                                              \
             m->bits = new_bits;                                                                                 \
@@ -1012,7 +1626,7 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
                 {                                                                                               \
                     if (!entry.value)                                                                           \
                     {                                                                                           \
-                        entry.value = (ValT*)ZMAP_MALLOC(sizeof(ValT));                                         \
+                        entry.value = (ValT*)ZMAP_STABLE_ALLOC__(m, ValT);                                      \
                         if (!entry.value)                                                                       \
                         {                                                                                       \
                             return Z_ENOMEM;                                                                    \
@@ -1033,7 +1647,7 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
                 {                                                                                               \
                     if (!entry.value)                                                                           \
                     {                                                                                           \
-                        entry.value = (ValT*)ZMAP_MALLOC(sizeof(ValT));                                         \
+                        entry.value = (ValT*)ZMAP_STABLE_ALLOC__(m, ValT);                                      \
                         if (!entry.value)                                                                       \
                         {                                                                                       \
                             return Z_ENOMEM;                                                                    \
@@ -1049,22 +1663,132 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
                 dist++;                                                                                         \
             }                                                                                                   \
         }                                                                                                       \
-        static inline void zmap_remove_val_stable_##Name(ValT *ptr)                                             \
+        static inline void zmap_remove_val_stable_##Name(zmap_stable_##Name *m, ValT *ptr)                      \
         {                                                                                                       \
-            ZMAP_FREE(ptr);                                                                                     \
+            (void)m;                                                                                            \
+            ZMAP_STABLE_RELEASE__(m, ptr);                                                                      \
         }
-#endif
 
-/*
- * ZMAP_GENERATE_IMPL
- * Standard In-Place Map Generator.
- */
-#define ZMAP_GENERATE_IMPL(KeyT, ValT, Name)                                                                                \
-    typedef struct                                                                                                          \
-    {                                                                                                                       \
-        KeyT key;                                                                                                           \
-        ValT value;                                                                                                         \
-        uint32_t stored_hash;                                                                                               \
+#   define ZMAP_IMPL_FLAT_OPS(KeyT, ValT, Name, Cache)                                                          \
+        static inline void zmap_free_flat_##Name(zmap_flat_##Name *m)                                           \
+        {                                                                                                       \
+            ZMAP_HFREE__(m, m->slots, m->capacity * sizeof(zmap_bucket_flat_##Name));                           \
+            ZMAP_HFREE__(m, m->ctrl, m->capacity);                                                              \
+            m->slots = NULL;                                                                                    \
+            m->ctrl = NULL;                                                                                     \
+            m->capacity = 0;                                                                                    \
+            m->count = 0;                                                                                       \
+            m->growth_left = 0;                                                                                 \
+            m->bits = 0;                                                                                        \
+        }                                                                                                       \
+                                                                                                                \
+        static inline void zmap_clear_flat_##Name(zmap_flat_##Name *m)                                          \
+        {                                                                                                       \
+            if (m->capacity > 0)                                                                                \
+            {                                                                                                   \
+                memset(m->ctrl, ZMAP_CTRL_EMPTY, m->capacity);                                                  \
+                m->growth_left = zmap_flat_growth(m->capacity, m->load_factor);                                 \
+            }                                                                                                   \
+            m->count = 0;                                                                                       \
+        }                                                                                                       \
+                                                                                                                \
+        static inline int zmap_resize_flat_##Name(zmap_flat_##Name *m, size_t new_cap)                          \
+        {                                                                                                       \
+            if (new_cap < ZMAP_GROUP_WIDTH)                                                                     \
+            {                                                                                                   \
+                new_cap = ZMAP_GROUP_WIDTH;                                                                     \
+            }                                                                                                   \
+            uint8_t *new_ctrl = (uint8_t*)ZMAP_HMALLOC__(m, new_cap);                                           \
+            zmap_bucket_flat_##Name *new_slots = (zmap_bucket_flat_##Name*)                                     \
+                ZMAP_HMALLOC__(m, new_cap * sizeof(zmap_bucket_flat_##Name));                                   \
+            if (!new_ctrl || !new_slots)                                                                        \
+            {                                                                                                   \
+                ZMAP_HFREE__(m, new_ctrl, new_cap);                                                             \
+                ZMAP_HFREE__(m, new_slots, new_cap * sizeof(zmap_bucket_flat_##Name));                          \
+                return Z_ENOMEM;                                                                                \
+            }                                                                                                   \
+            memset(new_ctrl, ZMAP_CTRL_EMPTY, new_cap);                                                         \
+            uint32_t new_bits = 0;                                                                              \
+            size_t temp = new_cap / ZMAP_GROUP_WIDTH;                                                           \
+            while (temp >>= 1)                                                                                  \
+            {                                                                                                   \
+                new_bits++;                                                                                     \
+            }                                                                                                   \
+            for (size_t i = 0; i < m->capacity; i++)                                                            \
+            {                                                                                                   \
+                if (0 == (m->ctrl[i] & 0x80))                                                                   \
+                {                                                                                               \
+                    uint32_t hash = ZMAP_FLAT_SLOT_HASH__(Cache)(m, m->slots[i]);                               \
+                    size_t idx = zmap_flat_find_free(new_ctrl, new_cap, new_bits, hash);                        \
+                    new_ctrl[idx] = zmap_ctrl_h2(hash);                                                         \
+                    new_slots[idx] = m->slots[i];                                                               \
+                }                                                                                               \
+            }                                                                                                   \
+            ZMAP_HFREE__(m, m->slots, m->capacity * sizeof(zmap_bucket_flat_##Name));                           \
+            ZMAP_HFREE__(m, m->ctrl, m->capacity);                                                              \
+            m->slots = new_slots;                                                                               \
+            m->ctrl = new_ctrl;                                                                                 \
+            m->capacity = new_cap;                                                                              \
+            m->bits = new_bits;                                                                                 \
+            m->growth_left = zmap_flat_growth(new_cap, m->load_factor) - m->count;                              \
+            return Z_OK;                                                                                        \
+        }
+#endif
+
+// Bulk build tuning: below ZMAP_BUILD_MIN_PARALLEL entries threads cost more than they save.
+#ifndef ZMAP_BUILD_MIN_PARALLEL
+#   define ZMAP_BUILD_MIN_PARALLEL 4096
+#endif
+#define ZMAP_BUILD_MAX_THREADS 64
+
+// Stable LSD radix sort of items by the key_bits bits above key_shift (11-bit digits).
+static inline void zmap_build_radix_sort(uint64_t *items, uint64_t *tmp, size_t n,
+                                         uint32_t key_shift, uint32_t key_bits)
+{
+    size_t counts[1u << 11];
+    uint64_t *src = items;
+    uint64_t *dst = tmp;
+    for (uint32_t done = 0; done < key_bits; done += 11)
+    {
+        uint32_t shift = key_shift + done;
+        uint32_t width = (key_bits - done < 11) ? key_bits - done : 11;
+        uint64_t mask = ((uint64_t)1 << width) - 1;
+        memset(counts, 0, sizeof(size_t) << width);
+        for (size_t i = 0; i < n; i++)
+        {
+            counts[(src[i] >> shift) & mask]++;
+        }
+        size_t off = 0;
+        for (size_t d = 0; d <= mask; d++)
+        {
+            size_t c = counts[d];
+            counts[d] = off;
+            off += c;
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            dst[counts[(src[i] >> shift) & mask]++] = src[i];
+        }
+        uint64_t *swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != items)
+    {
+        memcpy(items, src, n * sizeof(uint64_t));
+    }
+}
+
+/*
+ * ZMAP_GENERATE_IMPL
+ * Standard In-Place Map Generator.
+ */
+#define ZMAP_GENERATE_IMPL(KeyT, ValT, Name)                                                                                \
+    typedef struct                                                                                                          \
+    {                                                                                                                       \
+        KeyT key;                                                                                                           \
+        ValT value;                                                                                                         \
+        uint32_t stored_hash;                                                                                               \
         zmap_state state;                                                                                                   \
     } zmap_bucket_##Name;                                                                                                   \
                                                                                                                             \
@@ -1079,6 +1803,7 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
         uint32_t seed;                                                                                                      \
         uint32_t (*hash_func)(KeyT, uint32_t);                                                                              \
         int      (*cmp_func)(KeyT, KeyT);                                                                                   \
+        Z_ALLOCATOR_FIELD                                                                                                   \
     } zmap_##Name;                                                                                                          \
                                                                                                                             \
     typedef struct                                                                                                          \
@@ -1092,7 +1817,7 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
         return (zmap_##Name){                                                                                               \
             .buckets = NULL, .capacity = 0, .count = 0, .threshold = 0,                                                     \
             .bits = 0, .load_factor = (load <= 0.1f || load > 0.95f) ? ZMAP_DEFAULT_LOAD : load,                            \
-            .seed = 0xCAFEBABE, .hash_func = h, .cmp_func = c                                                               \
+            .seed = 0xCAFEBABE, .hash_func = h, .cmp_func = c ZMAP_ALLOCATOR_INIT__                                         \
         };                                                                                                                  \
     }                                                                                                                       \
                                                                                                                             \
@@ -1106,15 +1831,53 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
         m->seed = s;                                                                                                        \
     }                                                                                                                       \
                                                                                                                             \
+    ZMAP_GEN_SET_ALLOCATOR__(zmap_##Name, zmap_set_allocator_##Name)                                                        \
+                                                                                                                            \
     ZMAP_IMPL_OPS(KeyT, ValT, Name)                                                                                         \
                                                                                                                             \
-    static inline ValT* zmap_get_##Name(zmap_##Name *m, KeyT key)                                                           \
+    /* Grows the table once so that n entries fit without further resizes. */                                               \
+    static inline int zmap_reserve_##Name(zmap_##Name *m, size_t n)                                                         \
+    {                                                                                                                       \
+        if (0 == n || (m->capacity > 0 && n <= m->threshold))                                                               \
+        {                                                                                                                   \
+            return Z_OK;                                                                                                    \
+        }                                                                                                                   \
+        if (n > SIZE_MAX / 4)                                                                                               \
+        {                                                                                                                   \
+            return Z_ENOMEM;                                                                                                \
+        }                                                                                                                   \
+        size_t cap = zmap_next_pow2(n);                                                                                     \
+        while ((size_t)(cap * m->load_factor) < n)                                                                          \
+        {                                                                                                                   \
+            cap <<= 1;                                                                                                      \
+        }                                                                                                                   \
+        return zmap_resize_##Name(m, cap);                                                                                  \
+    }                                                                                                                       \
+                                                                                                                            \
+    /* Bulk insert of n key/value pairs: one resize up front, then no growth checks that fire.                              \
+     * Later duplicates overwrite earlier ones. */                                                                          \
+    static inline int zmap_build_##Name(zmap_##Name *m, const KeyT *keys, const ValT *vals, size_t n)                       \
+    {                                                                                                                       \
+        if (Z_OK != zmap_reserve_##Name(m, m->count + n))                                                                   \
+        {                                                                                                                   \
+            return Z_ENOMEM;                                                                                                \
+        }                                                                                                                   \
+        for (size_t i = 0; i < n; i++)                                                                                      \
+        {                                                                                                                   \
+            if (Z_OK != zmap_put_with_hash_##Name(m, keys[i], vals[i], m->hash_func(keys[i], m->seed)))                     \
+            {                                                                                                               \
+                return Z_ENOMEM;                                                                                            \
+            }                                                                                                               \
+        }                                                                                                                   \
+        return Z_OK;                                                                                                        \
+    }                                                                                                                       \
+                                                                                                                            \
+    static inline ValT* zmap_get_with_hash_##Name(zmap_##Name *m, KeyT key, uint32_t hash)                                  \
     {                                                                                                                       \
         if (0 == m->count)                                                                                                  \
         {                                                                                                                   \
             return NULL;                                                                                                    \
         }                                                                                                                   \
-        uint32_t hash = m->hash_func(key, m->seed);                                                                         \
         size_t idx = zmap_fib_index(hash, m->bits);                                                                         \
         size_t dist = 0;                                                                                                    \
         for (;;)                                                                                                            \
@@ -1137,13 +1900,21 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
         }                                                                                                                   \
     }                                                                                                                       \
                                                                                                                             \
-    static inline void zmap_remove_##Name(zmap_##Name *m, KeyT key)                                                         \
+    static inline ValT* zmap_get_##Name(zmap_##Name *m, KeyT key)                                                           \
+    {                                                                                                                       \
+        if (0 == m->count)                                                                                                  \
+        {                                                                                                                   \
+            return NULL;                                                                                                    \
+        }                                                                                                                   \
+        return zmap_get_with_hash_##Name(m, key, m->hash_func(key, m->seed));                                               \
+    }                                                                                                                       \
+                                                                                                                            \
+    static inline void zmap_remove_with_hash_##Name(zmap_##Name *m, KeyT key, uint32_t hash)                                \
     {                                                                                                                       \
         if (0 == m->count)                                                                                                  \
         {                                                                                                                   \
             return;                                                                                                         \
         }                                                                                                                   \
-        uint32_t hash = m->hash_func(key, m->seed);                                                                         \
         size_t idx = zmap_fib_index(hash, m->bits);                                                                         \
         size_t dist = 0;                                                                                                    \
         for (;;)                                                                                                            \
@@ -1183,6 +1954,15 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
         }                                                                                                                   \
     }                                                                                                                       \
                                                                                                                             \
+    static inline void zmap_remove_##Name(zmap_##Name *m, KeyT key)                                                         \
+    {                                                                                                                       \
+        if (0 == m->count)                                                                                                  \
+        {                                                                                                                   \
+            return;                                                                                                         \
+        }                                                                                                                   \
+        zmap_remove_with_hash_##Name(m, key, m->hash_func(key, m->seed));                                                   \
+    }                                                                                                                       \
+                                                                                                                            \
     static inline zmap_iter_##Name zmap_iter_init_##Name(zmap_##Name *m)                                                    \
     {                                                                                                                       \
         return (zmap_iter_##Name){ .map = m, .index = 0 };                                                                  \
@@ -1212,8 +1992,239 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
         return m->count;                                                                                                    \
     }                                                                                                                       \
                                                                                                                             \
+    ZMAP_GEN_PARALLEL_BUILD(KeyT, ValT, Name)                                                                               \
     ZMAP_GEN_SAFE_IMPL(KeyT, ValT, Name)
 
+/*
+ * ZMAP_GENERATE_PARALLEL_BUILD_IMPL
+ * zmap_build_parallel_##Name: bulk build into an empty map on up to ZMAP_BUILD_MAX_THREADS threads.
+ * 1. Each thread hashes a chunk of the input and counts entries per table range.
+ * 2. Each thread scatters its chunk into per-range slices (ranges split the table by home bucket).
+ * 3. Each thread radix-sorts its slice by home bucket and lays it out in its own bucket range.
+ *    Sorted placement is already a valid Robin Hood layout; entries that would probe past the
+ *    range end are left for the calling thread, which inserts them with the regular put.
+ * Duplicate keys: some value among the duplicates is kept (last one wins within a range).
+ */
+#define ZMAP_GENERATE_PARALLEL_BUILD_IMPL(KeyT, ValT, Name)                                                                 \
+    typedef struct                                                                                                          \
+    {                                                                                                                       \
+        zmap_##Name *m;                                                                                                     \
+        const KeyT *keys;                                                                                                   \
+        const ValT *vals;                                                                                                   \
+        uint32_t *hashes;                                                                                                   \
+        uint64_t *order;                                                                                                    \
+        uint64_t *scratch;                                                                                                  \
+        size_t *counts;                                                                                                     \
+        size_t *ranges;                                                                                                     \
+        size_t n;                                                                                                           \
+        size_t threads;                                                                                                     \
+        size_t tid;                                                                                                         \
+        uint32_t tbits;                                                                                                     \
+        int phase;                                                                                                          \
+        int status;                                                                                                         \
+        size_t inserted;                                                                                                    \
+        size_t spill_count;                                                                                                 \
+    } zmap_build_task_##Name;                                                                                               \
+                                                                                                                            \
+    static inline void zmap_build_place_##Name(zmap_build_task_##Name *t, uint64_t *items, size_t count)                    \
+    {                                                                                                                       \
+        zmap_##Name *m = t->m;                                                                                              \
+        uint32_t shift = m->bits - t->tbits;                                                                                \
+        size_t slot_hi = (t->tid + 1) << shift;                                                                             \
+        size_t cursor = t->tid << shift;                                                                                    \
+        size_t run_home = SIZE_MAX;                                                                                         \
+        size_t run_start = cursor;                                                                                          \
+        for (size_t j = 0; j < count; j++)                                                                                  \
+        {                                                                                                                   \
+            size_t i = (size_t)(items[j] & 0xFFFFFFFFu);                                                                    \
+            size_t home = (size_t)((uint32_t)(items[j] >> 32) >> (32 - m->bits));                                           \
+            uint32_t hash = t->hashes[i];                                                                                   \
+            size_t pos = (home > cursor) ? home : cursor;                                                                   \
+            bool dup = false;                                                                                               \
+            if (home != run_home)                                                                                           \
+            {                                                                                                               \
+                run_home = home;                                                                                            \
+                run_start = pos;                                                                                            \
+            }                                                                                                               \
+            for (size_t k = run_start; k < pos; k++)                                                                        \
+            {                                                                                                               \
+                if (m->buckets[k].stored_hash == hash && 0 == m->cmp_func(m->buckets[k].key, t->keys[i]))                   \
+                {                                                                                                           \
+                    m->buckets[k].value = t->vals[i];                                                                       \
+                    dup = true;                                                                                             \
+                    break;                                                                                                  \
+                }                                                                                                           \
+            }                                                                                                               \
+            if (dup)                                                                                                        \
+            {                                                                                                               \
+                continue;                                                                                                   \
+            }                                                                                                               \
+            if (pos >= slot_hi)                                                                                             \
+            {                                                                                                               \
+                items[t->spill_count++] = items[j];                                                                         \
+                continue;                                                                                                   \
+            }                                                                                                               \
+            m->buckets[pos].key = t->keys[i];                                                                               \
+            m->buckets[pos].value = t->vals[i];                                                                             \
+            m->buckets[pos].stored_hash = hash;                                                                             \
+            m->buckets[pos].state = ZMAP_OCCUPIED;                                                                          \
+            cursor = pos + 1;                                                                                               \
+            t->inserted++;                                                                                                  \
+        }                                                                                                                   \
+    }                                                                                                                       \
+                                                                                                                            \
+    static inline void zmap_build_worker_##Name(void *arg)                                                                  \
+    {                                                                                                                       \
+        zmap_build_task_##Name *t = (zmap_build_task_##Name *)arg;                                                          \
+        size_t chunk = (t->n + t->threads - 1) / t->threads;                                                                \
+        size_t lo = (t->tid * chunk < t->n) ? t->tid * chunk : t->n;                                                        \
+        size_t hi = (lo + chunk < t->n) ? lo + chunk : t->n;                                                                \
+        size_t *row = t->counts + t->tid * t->threads;                                                                      \
+        uint32_t range_shift = 32 - t->tbits;                                                                               \
+        if (0 == t->phase)                                                                                                  \
+        {                                                                                                                   \
+            for (size_t i = lo; i < hi; i++)                                                                                \
+            {                                                                                                               \
+                uint32_t hash = t->m->hash_func(t->keys[i], t->m->seed);                                                    \
+                t->hashes[i] = hash;                                                                                        \
+                row[(uint32_t)(hash * ZMAP_FIB_CONST) >> range_shift]++;                                                    \
+            }                                                                                                               \
+        }                                                                                                                   \
+        else if (1 == t->phase)                                                                                             \
+        {                                                                                                                   \
+            for (size_t i = lo; i < hi; i++)                                                                                \
+            {                                                                                                               \
+                uint32_t mixed = (uint32_t)(t->hashes[i] * ZMAP_FIB_CONST);                                                 \
+                t->order[row[mixed >> range_shift]++] = ((uint64_t)mixed << 32) | (uint64_t)i;                              \
+            }                                                                                                               \
+        }                                                                                                                   \
+        else                                                                                                                \
+        {                                                                                                                   \
+            uint64_t *items = t->order + t->ranges[t->tid];                                                                 \
+            size_t count = t->ranges[t->tid + 1] - t->ranges[t->tid];                                                       \
+            uint32_t bits = t->m->bits;                                                                                     \
+            zmap_build_radix_sort(items, t->scratch + t->ranges[t->tid], count, 64 - bits, bits - t->tbits);                \
+            ZMAP_TRY__                                                                                                      \
+            {                                                                                                               \
+                zmap_build_place_##Name(t, items, count);                                                                   \
+            }                                                                                                               \
+            ZMAP_CATCH__                                                                                                    \
+            {                                                                                                               \
+                t->status = Z_ENOMEM;                                                                                       \
+            }                                                                                                               \
+        }                                                                                                                   \
+    }                                                                                                                       \
+                                                                                                                            \
+    static inline int zmap_build_parallel_##Name(zmap_##Name *m, const KeyT *keys, const ValT *vals,                        \
+                                                 size_t n, size_t threads)                                                  \
+    {                                                                                                                       \
+        size_t tcount = 1;                                                                                                  \
+        uint32_t tbits = 0;                                                                                                 \
+        while (tcount * 2 <= threads && tcount < ZMAP_BUILD_MAX_THREADS)                                                    \
+        {                                                                                                                   \
+            tcount *= 2;                                                                                                    \
+            tbits++;                                                                                                        \
+        }                                                                                                                   \
+        if (tcount < 2 || 0 != m->count || n < ZMAP_BUILD_MIN_PARALLEL || n > UINT32_MAX ||                                 \
+            n > SIZE_MAX / (2 * sizeof(uint64_t)))                                                                          \
+        {                                                                                                                   \
+            return zmap_build_##Name(m, keys, vals, n);                                                                     \
+        }                                                                                                                   \
+        if (Z_OK != zmap_reserve_##Name(m, n))                                                                              \
+        {                                                                                                                   \
+            return Z_ENOMEM;                                                                                                \
+        }                                                                                                                   \
+        uint32_t *hashes = (uint32_t *)ZMAP_HMALLOC__(m, n * sizeof(uint32_t));                                             \
+        uint64_t *order = (uint64_t *)ZMAP_HMALLOC__(m, 2 * n * sizeof(uint64_t));                                          \
+        size_t *counts = (size_t *)ZMAP_HCALLOC__(m, tcount * tcount + tcount + 1, sizeof(size_t));                         \
+        if (!hashes || !order || !counts)                                                                                   \
+        {                                                                                                                   \
+            ZMAP_HFREE__(m, hashes, n * sizeof(uint32_t));                                                                  \
+            ZMAP_HFREE__(m, order, 2 * n * sizeof(uint64_t));                                                               \
+            ZMAP_HFREE__(m, counts, (tcount * tcount + tcount + 1) * sizeof(size_t));                                       \
+            return zmap_build_##Name(m, keys, vals, n);                                                                     \
+        }                                                                                                                   \
+        zmap_build_task_##Name tasks[ZMAP_BUILD_MAX_THREADS];                                                               \
+        zthread_t handles[ZMAP_BUILD_MAX_THREADS];                                                                          \
+        bool started[ZMAP_BUILD_MAX_THREADS];                                                                               \
+        for (size_t t = 0; t < tcount; t++)                                                                                 \
+        {                                                                                                                   \
+            tasks[t].m = m;                                                                                                 \
+            tasks[t].keys = keys;                                                                                           \
+            tasks[t].vals = vals;                                                                                           \
+            tasks[t].hashes = hashes;                                                                                       \
+            tasks[t].order = order;                                                                                         \
+            tasks[t].scratch = order + n;                                                                                   \
+            tasks[t].counts = counts;                                                                                       \
+            tasks[t].ranges = counts + tcount * tcount;                                                                     \
+            tasks[t].n = n;                                                                                                 \
+            tasks[t].threads = tcount;                                                                                      \
+            tasks[t].tid = t;                                                                                               \
+            tasks[t].tbits = tbits;                                                                                         \
+            tasks[t].status = Z_OK;                                                                                         \
+            tasks[t].inserted = 0;                                                                                          \
+            tasks[t].spill_count = 0;                                                                                       \
+        }                                                                                                                   \
+        for (int phase = 0; phase < 3; phase++)                                                                             \
+        {                                                                                                                   \
+            if (1 == phase)                                                                                                 \
+            {                                                                                                               \
+                /* Turn per-chunk counts into write offsets, range-major so each range is contiguous. */                    \
+                size_t *ranges = counts + tcount * tcount;                                                                  \
+                size_t off = 0;                                                                                             \
+                for (size_t r = 0; r < tcount; r++)                                                                         \
+                {                                                                                                           \
+                    ranges[r] = off;                                                                                        \
+                    for (size_t t = 0; t < tcount; t++)                                                                     \
+                    {                                                                                                       \
+                        size_t c = counts[t * tcount + r];                                                                  \
+                        counts[t * tcount + r] = off;                                                                       \
+                        off += c;                                                                                           \
+                    }                                                                                                       \
+                }                                                                                                           \
+                ranges[tcount] = off;                                                                                       \
+            }                                                                                                               \
+            for (size_t t = 0; t < tcount; t++)                                                                             \
+            {                                                                                                               \
+                tasks[t].phase = phase;                                                                                     \
+                started[t] = (Z_OK == zthread_create(&handles[t], zmap_build_worker_##Name, &tasks[t]));                    \
+                if (!started[t])                                                                                            \
+                {                                                                                                           \
+                    zmap_build_worker_##Name(&tasks[t]);                                                                    \
+                }                                                                                                           \
+            }                                                                                                               \
+            for (size_t t = 0; t < tcount; t++)                                                                             \
+            {                                                                                                               \
+                if (started[t])                                                                                             \
+                {                                                                                                           \
+                    zthread_join(handles[t]);                                                                               \
+                }                                                                                                           \
+            }                                                                                                               \
+        }                                                                                                                   \
+        int res = Z_OK;                                                                                                     \
+        for (size_t t = 0; t < tcount; t++)                                                                                 \
+        {                                                                                                                   \
+            m->count += tasks[t].inserted;                                                                                  \
+            if (Z_OK != tasks[t].status)                                                                                    \
+            {                                                                                                               \
+                res = tasks[t].status;                                                                                      \
+            }                                                                                                               \
+        }                                                                                                                   \
+        for (size_t t = 0; t < tcount && Z_OK == res; t++)                                                                  \
+        {                                                                                                                   \
+            uint64_t *spills = order + tasks[t].ranges[t];                                                                  \
+            for (size_t s = 0; s < tasks[t].spill_count && Z_OK == res; s++)                                                \
+            {                                                                                                               \
+                size_t i = (size_t)(spills[s] & 0xFFFFFFFFu);                                                               \
+                res = zmap_put_with_hash_##Name(m, keys[i], vals[i], hashes[i]);                                            \
+            }                                                                                                               \
+        }                                                                                                                   \
+        ZMAP_HFREE__(m, hashes, n * sizeof(uint32_t));                                                                      \
+        ZMAP_HFREE__(m, order, 2 * n * sizeof(uint64_t));                                                                   \
+        ZMAP_HFREE__(m, counts, (tcount * tcount + tcount + 1) * sizeof(size_t));                                           \
+        return res;                                                                                                         \
+    }
+
 /*
  * ZMAP_GENERATE_STABLE_IMPL
  * Stable Map Generator. Values are heap-allocated pointers.
@@ -1237,6 +2248,8 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
         uint32_t seed;                                                                                                      \
         uint32_t (*hash_func)(KeyT, uint32_t);                                                                              \
         int (*cmp_func)(KeyT, KeyT);                                                                                        \
+        ZMAP_STABLE_POOL_FIELDS__                                                                                           \
+        Z_ALLOCATOR_FIELD                                                                                                   \
     } zmap_stable_##Name;                                                                                                   \
                                                                                                                             \
     typedef struct                                                                                                          \
@@ -1251,7 +2264,7 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
         return (zmap_stable_##Name){                                                                                        \
             .buckets = NULL, .capacity = 0, .count = 0, .threshold = 0,                                                     \
             .bits = 0, .load_factor = (load <= 0.1f || load > 0.95f) ? ZMAP_DEFAULT_LOAD : load,                            \
-            .seed = 0xCAFEBABE, .hash_func = h, .cmp_func = c                                                               \
+            .seed = 0xCAFEBABE, .hash_func = h, .cmp_func = c ZMAP_STABLE_POOL_INIT__ ZMAP_ALLOCATOR_INIT__                 \
         };                                                                                                                  \
     }                                                                                                                       \
                                                                                                                             \
@@ -1265,8 +2278,30 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
         m->seed = s;                                                                                                        \
     }                                                                                                                       \
                                                                                                                             \
+    ZMAP_GEN_SET_ALLOCATOR__(zmap_stable_##Name, zmap_set_allocator_stable_##Name)                                          \
+                                                                                                                            \
+    ZMAP_GEN_STABLE_POOL_INIT(KeyT, ValT, Name)                                                                             \
+                                                                                                                            \
     ZMAP_IMPL_STABLE_OPS(KeyT, ValT, Name)                                                                                  \
                                                                                                                             \
+    static inline int zmap_reserve_stable_##Name(zmap_stable_##Name *m, size_t n)                                           \
+    {                                                                                                                       \
+        if (0 == n || (m->capacity > 0 && n <= m->threshold))                                                               \
+        {                                                                                                                   \
+            return Z_OK;                                                                                                    \
+        }                                                                                                                   \
+        if (n > SIZE_MAX / 4)                                                                                               \
+        {                                                                                                                   \
+            return Z_ENOMEM;                                                                                                \
+        }                                                                                                                   \
+        size_t cap = zmap_next_pow2(n);                                                                                     \
+        while ((size_t)(cap * m->load_factor) < n)                                                                          \
+        {                                                                                                                   \
+            cap <<= 1;                                                                                                      \
+        }                                                                                                                   \
+        return zmap_resize_stable_##Name(m, cap);                                                                           \
+    }                                                                                                                       \
+                                                                                                                            \
     static inline ValT* zmap_get_stable_##Name(zmap_stable_##Name *m, KeyT key)                                             \
     {                                                                                                                       \
         if (0 == m->count)                                                                                                  \
@@ -1318,7 +2353,7 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
             }                                                                                                               \
             if (m->buckets[idx].stored_hash == hash && 0 == m->cmp_func(m->buckets[idx].key, key))                          \
             {                                                                                                               \
-                zmap_remove_val_stable_##Name(m->buckets[idx].value);                                                       \
+                zmap_remove_val_stable_##Name(m, m->buckets[idx].value);                                                    \
                 m->count--;                                                                                                 \
                 for (;;)                                                                                                    \
                 {                                                                                                           \
@@ -1378,6 +2413,563 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
         return false;                                                                                                       \
     }
 
+/*
+ * ZMAP_GENERATE_FLAT_IMPL / ZMAP_GENERATE_FLAT_CACHED_IMPL
+ * Flat (Swiss-table) Map Generator.
+ * Control tags live in their own byte array, separate from the key/value slots,
+ * and are probed a group at a time. A lookup only touches a slot when its 7-bit
+ * tag matches, so misses rarely leave the control array. Deletion leaves a
+ * tombstone unless the group still has an EMPTY tag; tombstones are dropped by
+ * an in-place rehash when they exhaust the growth budget.
+ */
+#define ZMAP_GENERATE_FLAT_IMPL(KeyT, ValT, Name)        ZMAP_GENERATE_FLAT_IMPL_EX__(KeyT, ValT, Name, ZMAP_FLAT_CACHE_HASH)
+#define ZMAP_GENERATE_FLAT_CACHED_IMPL(KeyT, ValT, Name) ZMAP_GENERATE_FLAT_IMPL_EX__(KeyT, ValT, Name, 1)
+
+#define ZMAP_GENERATE_FLAT_IMPL_EX__(KeyT, ValT, Name, Cache)                                                               \
+    typedef struct                                                                                                          \
+    {                                                                                                                       \
+        KeyT key;                                                                                                           \
+        ValT value;                                                                                                         \
+        ZMAP_FLAT_HASH_FIELD__(Cache)                                                                                       \
+    } zmap_bucket_flat_##Name;                                                                                              \
+                                                                                                                            \
+    typedef struct                                                                                                          \
+    {                                                                                                                       \
+        uint8_t *ctrl;                                                                                                      \
+        zmap_bucket_flat_##Name *slots;                                                                                     \
+        size_t capacity;                                                                                                    \
+        size_t count;                                                                                                       \
+        size_t growth_left;                                                                                                 \
+        uint32_t bits;                                                                                                      \
+        float load_factor;                                                                                                  \
+        uint32_t seed;                                                                                                      \
+        uint32_t (*hash_func)(KeyT, uint32_t);                                                                              \
+        int (*cmp_func)(KeyT, KeyT);                                                                                        \
+        Z_ALLOCATOR_FIELD                                                                                                   \
+    } zmap_flat_##Name;                                                                                                     \
+                                                                                                                            \
+    typedef struct                                                                                                          \
+    {                                                                                                                       \
+        zmap_flat_##Name *map;                                                                                              \
+        size_t index;                                                                                                       \
+    } zmap_iter_flat_##Name;                                                                                                \
+                                                                                                                            \
+    static inline zmap_flat_##Name zmap_init_ext_flat_##Name(uint32_t (*h)(KeyT, uint32_t),                                 \
+                                                             int (*c)(KeyT, KeyT), float load)                              \
+    {                                                                                                                       \
+        zmap_flat_##Name m;                                                                                                 \
+        memset(&m, 0, sizeof(m));                                                                                           \
+        m.load_factor = (load <= 0.1f || load > 0.95f) ? ZMAP_FLAT_DEFAULT_LOAD : load;                                     \
+        m.seed = 0xCAFEBABE;                                                                                                \
+        m.hash_func = h;                                                                                                    \
+        m.cmp_func = c;                                                                                                     \
+        return m;                                                                                                           \
+    }                                                                                                                       \
+                                                                                                                            \
+    static inline zmap_flat_##Name zmap_init_flat_##Name(uint32_t (*h)(KeyT, uint32_t), int (*c)(KeyT, KeyT))               \
+    {                                                                                                                       \
+        return zmap_init_ext_flat_##Name(h, c, ZMAP_FLAT_DEFAULT_LOAD);                                                     \
+    }                                                                                                                       \
+                                                                                                                            \
+    static inline void zmap_set_seed_flat_##Name(zmap_flat_##Name *m, uint32_t s)                                           \
+    {                                                                                                                       \
+        m->seed = s;                                                                                                        \
+    }                                                                                                                       \
+                                                                                                                            \
+    ZMAP_GEN_SET_ALLOCATOR__(zmap_flat_##Name, zmap_set_allocator_flat_##Name)                                              \
+                                                                                                                            \
+    ZMAP_IMPL_FLAT_OPS(KeyT, ValT, Name, Cache)                                                                             \
+                                                                                                                            \
+    /* Tombstones count against growth_left, so a reserve may rehash at the same capacity. */                               \
+    static inline int zmap_reserve_flat_##Name(zmap_flat_##Name *m, size_t n)                                               \
+    {                                                                                                                       \
+        if (n <= m->count + m->growth_left)                                                                                 \
+        {                                                                                                                   \
+            return Z_OK;                                                                                                    \
+        }                                                                                                                   \
+        if (n > SIZE_MAX / 4)                                                                                               \
+        {                                                                                                                   \
+            return Z_ENOMEM;                                                                                                \
+        }                                                                                                                   \
+        size_t cap = zmap_next_pow2(n);                                                                                     \
+        if (cap < ZMAP_GROUP_WIDTH)                                                                                         \
+        {                                                                                                                   \
+            cap = ZMAP_GROUP_WIDTH;                                                                                         \
+        }                                                                                                                   \
+        while (zmap_flat_growth(cap, m->load_factor) < n)                                                                   \
+        {                                                                                                                   \
+            cap <<= 1;                                                                                                      \
+        }                                                                                                                   \
+        if (cap < m->capacity)                                                                                              \
+        {                                                                                                                   \
+            cap = m->capacity;                                                                                              \
+        }                                                                                                                   \
+        return zmap_resize_flat_##Name(m, cap);                                                                             \
+    }                                                                                                                       \
+                                                                                                                            \
+    /* Slot index holding `key`, or m->capacity when absent. */                                                             \
+    static inline size_t zmap_find_flat_##Name(zmap_flat_##Name *m, KeyT key, uint32_t hash)                                \
+    {                                                                                                                       \
+        size_t group_mask = (m->capacity / ZMAP_GROUP_WIDTH) - 1;                                                           \
+        size_t g = zmap_group_index(hash, m->bits);                                                                         \
+        size_t step = 0;                                                                                                    \
+        uint8_t h2 = zmap_ctrl_h2(hash);                                                                                    \
+        for (;;)                                                                                                            \
+        {                                                                                                                   \
+            const uint8_t *group = m->ctrl + g * ZMAP_GROUP_WIDTH;                                                          \
+            uint32_t mask = zmap_group_match(group, h2);                                                                    \
+            while (mask)                                                                                                    \
+            {                                                                                                               \
+                size_t i = g * ZMAP_GROUP_WIDTH + zmap_ctz32(mask);                                                         \
+                if (ZMAP_FLAT_HASH_EQ__(Cache)(m->slots[i], hash) && 0 == m->cmp_func(m->slots[i].key, key))                \
+                {                                                                                                           \
+                    return i;                                                                                               \
+                }                                                                                                           \
+                mask &= mask - 1;                                                                                           \
+            }                                                                                                               \
+            if (zmap_group_match_empty(group))                                                                              \
+            {                                                                                                               \
+                return m->capacity;                                                                                         \
+            }                                                                                                               \
+            step++;                                                                                                         \
+            if (step > group_mask)                                                                                          \
+            {                                                                                                               \
+                return m->capacity;                                                                                         \
+            }                                                                                                               \
+            g = (g + step) & group_mask;                                                                                    \
+        }                                                                                                                   \
+    }                                                                                                                       \
+                                                                                                                            \
+    static inline ValT* zmap_get_flat_##Name(zmap_flat_##Name *m, KeyT key)                                                 \
+    {                                                                                                                       \
+        if (0 == m->count)                                                                                                  \
+        {                                                                                                                   \
+            return NULL;                                                                                                    \
+        }                                                                                                                   \
+        size_t i = zmap_find_flat_##Name(m, key, m->hash_func(key, m->seed));                                               \
+        return (i == m->capacity) ? NULL : &m->slots[i].value;                                                              \
+    }                                                                                                                       \
+                                                                                                                            \
+    static inline int zmap_put_flat_##Name(zmap_flat_##Name *m, KeyT key, ValT val)                                         \
+    {                                                                                                                       \
+        uint32_t hash = m->hash_func(key, m->seed);                                                                         \
+        if (m->count > 0)                                                                                                   \
+        {                                                                                                                   \
+            size_t i = zmap_find_flat_##Name(m, key, hash);                                                                 \
+            if (i != m->capacity)                                                                                           \
+            {                                                                                                               \
+                m->slots[i].value = val;                                                                                    \
+                return Z_OK;                                                                                                \
+            }                                                                                                               \
+        }                                                                                                                   \
+        if (0 == m->growth_left)                                                                                            \
+        {                                                                                                                   \
+            size_t new_cap = m->capacity;                                                                                   \
+            if (0 == new_cap || m->count * 2 >= zmap_flat_growth(new_cap, m->load_factor))                                  \
+            {                                                                                                               \
+                new_cap = zmap_next_pow2(Z_GROWTH_FACTOR(m->capacity));                                                     \
+            }                                                                                                               \
+            if (Z_OK != zmap_resize_flat_##Name(m, new_cap))                                                                \
+            {                                                                                                               \
+                return Z_ENOMEM;                                                                                            \
+            }                                                                                                               \
+        }                                                                                                                   \
+        size_t idx = zmap_flat_find_free(m->ctrl, m->capacity, m->bits, hash);                                              \
+        if (ZMAP_CTRL_EMPTY == m->ctrl[idx])                                                                                \
+        {                                                                                                                   \
+            m->growth_left--;                                                                                               \
+        }                                                                                                                   \
+        m->ctrl[idx] = zmap_ctrl_h2(hash);                                                                                  \
+        m->slots[idx].key = key;                                                                                            \
+        m->slots[idx].value = val;                                                                                          \
+        ZMAP_FLAT_SET_HASH__(Cache)(m->slots[idx], hash);                                                                   \
+        m->count++;                                                                                                         \
+        return Z_OK;                                                                                                        \
+    }                                                                                                                       \
+                                                                                                                            \
+    static inline void zmap_remove_flat_##Name(zmap_flat_##Name *m, KeyT key)                                               \
+    {                                                                                                                       \
+        if (0 == m->count)                                                                                                  \
+        {                                                                                                                   \
+            return;                                                                                                         \
+        }                                                                                                                   \
+        size_t i = zmap_find_flat_##Name(m, key, m->hash_func(key, m->seed));                                               \
+        if (i == m->capacity)                                                                                               \
+        {                                                                                                                   \
+            return;                                                                                                         \
+        }                                                                                                                   \
+        /* A group that still has an EMPTY tag never diverted a probe, so no tombstone is needed. */                        \
+        if (zmap_group_match_empty(m->ctrl + (i & ~(size_t)(ZMAP_GROUP_WIDTH - 1))))                                        \
+        {                                                                                                                   \
+            m->ctrl[i] = ZMAP_CTRL_EMPTY;                                                                                   \
+            m->growth_left++;                                                                                               \
+        }                                                                                                                   \
+        else                                                                                                                \
+        {                                                                                                                   \
+            m->ctrl[i] = ZMAP_CTRL_DELETED;                                                                                 \
+        }                                                                                                                   \
+        m->count--;                                                                                                         \
+    }                                                                                                                       \
+                                                                                                                            \
+    static inline size_t zmap_size_flat_##Name(zmap_flat_##Name *m)                                                         \
+    {                                                                                                                       \
+        return m->count;                                                                                                    \
+    }                                                                                                                       \
+                                                                                                                            \
+    static inline zmap_iter_flat_##Name zmap_iter_init_flat_##Name(zmap_flat_##Name *m)                                     \
+    {                                                                                                                       \
+        zmap_iter_flat_##Name it;                                                                                           \
+        it.map = m;                                                                                                         \
+        it.index = 0;                                                                                                       \
+        return it;                                                                                                          \
+    }                                                                                                                       \
+                                                                                                                            \
+    static inline bool zmap_iter_next_flat_##Name(zmap_iter_flat_##Name *it, KeyT *out_k, ValT *out_v)                      \
+    {                                                                                                                       \
+        if (!it->map || !it->map->ctrl)                                                                                     \
+        {                                                                                                                   \
+            return false;                                                                                                   \
+        }                                                                                                                   \
+        while (it->index < it->map->capacity)                                                                               \
+        {                                                                                                                   \
+            size_t i = it->index++;                                                                                         \
+            if (0 == (it->map->ctrl[i] & 0x80))                                                                             \
+            {                                                                                                               \
+                if (out_k)                                                                                                  \
+                {                                                                                                           \
+                    *out_k = it->map->slots[i].key;                                                                         \
+                }                                                                                                           \
+                if (out_v)                                                                                                  \
+                {                                                                                                           \
+                    *out_v = it->map->slots[i].value;                                                                       \
+                }                                                                                                           \
+                return true;                                                                                                \
+            }                                                                                                               \
+        }                                                                                                                   \
+        return false;                                                                                                       \
+    }                                                                                                                       \
+                                                                                                                            \
+    ZMAP_GEN_FLAT_SAFE_IMPL(KeyT, ValT, Name)
+
+/*
+ * Concurrent (sharded) map helpers.
+ * Each shard is a standard map behind its own zrwlock_t, padded to a cache line so that
+ * neighbouring locks never share one.
+ */
+#ifndef ZMAP_CACHE_LINE
+#   define ZMAP_CACHE_LINE 64
+#endif
+
+#define ZMAP_CONCURRENT_DEFAULT_SHARDS 64
+#define ZMAP_CONCURRENT_MAX_SHARDS     (1u << 16)
+#define ZMAP_CONCURRENT_BATCH          64
+
+#define ZMAP_CONCURRENT_PAD__(sz) ((((sz) + ZMAP_CACHE_LINE - 1) / ZMAP_CACHE_LINE) * ZMAP_CACHE_LINE)
+
+// Shard selection uses the low bits; the per-shard index uses the high bits of the product.
+static inline size_t zmap_shard_index(uint32_t hash, size_t shard_count)
+{
+    return (size_t)hash & (shard_count - 1);
+}
+
+// Batch entries are packed as (shard << 8) | position, so sorting groups them by shard.
+static inline void zmap_concurrent_sort_batch(uint32_t *order, size_t n)
+{
+    for (size_t i = 1; i < n; i++)
+    {
+        uint32_t v = order[i];
+        size_t j = i;
+        while (j > 0 && order[j - 1] > v)
+        {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = v;
+    }
+}
+
+// Shard tables follow the concurrent map's handle (C only, like the other map kinds).
+#if defined(Z_ALLOCATOR_HANDLE) && !defined(__cplusplus)
+#   define ZMAP_CONCURRENT_ALLOCATOR_RESET__(m)          ((m)->allocator = NULL)
+#   define ZMAP_CONCURRENT_SHARD_ALLOCATOR__(Name, s, a) zmap_set_allocator_##Name##_shard(s, a)
+    // Re-homes the (still empty) shard array on a; on Z_ENOMEM m is left freed.
+#   define ZMAP_GEN_CONCURRENT_SET_ALLOCATOR__(KeyT, ValT, Name)                                                        \
+        static inline int zmap_set_allocator_concurrent_##Name(zmap_concurrent_##Name *m, const zalloc_t *a)            \
+        {                                                                                                               \
+            size_t shards = m->shard_count;                                                                             \
+            uint32_t seed = m->seed;                                                                                    \
+            uint32_t (*h)(KeyT, uint32_t) = m->hash_func;                                                               \
+            int (*c)(KeyT, KeyT) = m->cmp_func;                                                                         \
+            zmap_free_concurrent_##Name(m);                                                                             \
+            m->allocator = a;                                                                                           \
+            int res = zmap_setup_concurrent__##Name(m, shards, h, c);                                                   \
+            if (Z_OK == res)                                                                                            \
+            {                                                                                                           \
+                zmap_set_seed_concurrent_##Name(m, seed);                                                               \
+            }                                                                                                           \
+            return res;                                                                                                 \
+        }
+#elif defined(Z_ALLOCATOR_HANDLE)
+#   define ZMAP_CONCURRENT_ALLOCATOR_RESET__(m)          ((m)->allocator = NULL)
+#   define ZMAP_CONCURRENT_SHARD_ALLOCATOR__(Name, s, a) ((void)0)
+#   define ZMAP_GEN_CONCURRENT_SET_ALLOCATOR__(KeyT, ValT, Name)
+#else
+#   define ZMAP_CONCURRENT_ALLOCATOR_RESET__(m)          ((void)0)
+#   define ZMAP_CONCURRENT_SHARD_ALLOCATOR__(Name, s, a) ((void)0)
+#   define ZMAP_GEN_CONCURRENT_SET_ALLOCATOR__(KeyT, ValT, Name)
+#endif
+
+/*
+ * ZMAP_GENERATE_CONCURRENT_IMPL
+ * Sharded map for shared use across threads. Requires zthread.h (link ZTHREAD_IMPLEMENTATION).
+ * Lookups copy the value out under the shard's read lock; no pointers into a shard escape.
+ */
+#define ZMAP_GENERATE_CONCURRENT_IMPL(KeyT, ValT, Name)                                                                     \
+    ZMAP_GENERATE_IMPL(KeyT, ValT, Name##_shard)                                                                            \
+                                                                                                                            \
+    typedef struct                                                                                                          \
+    {                                                                                                                       \
+        zrwlock_t lock;                                                                                                     \
+        zmap_##Name##_shard map;                                                                                            \
+    } zmap_shard_body_##Name;                                                                                               \
+                                                                                                                            \
+    typedef union                                                                                                           \
+    {                                                                                                                       \
+        zmap_shard_body_##Name s;                                                                                           \
+        char pad[ZMAP_CONCURRENT_PAD__(sizeof(zmap_shard_body_##Name))];                                                    \
+    } zmap_shard_##Name;                                                                                                    \
+                                                                                                                            \
+    typedef struct                                                                                                          \
+    {                                                                                                                       \
+        zmap_shard_##Name *shards;                                                                                          \
+        void *shard_mem;                                                                                                    \
+        size_t shard_count;                                                                                                 \
+        uint32_t seed;                                                                                                      \
+        uint32_t (*hash_func)(KeyT, uint32_t);                                                                              \
+        int      (*cmp_func)(KeyT, KeyT);                                                                                   \
+        Z_ALLOCATOR_FIELD                                                                                                   \
+    } zmap_concurrent_##Name;                                                                                               \
+                                                                                                                            \
+    /* Builds the shard array through m->allocator, which the caller has already set. */                                    \
+    static inline int zmap_setup_concurrent__##Name(zmap_concurrent_##Name *m, size_t shards,                               \
+                                                    uint32_t (*h)(KeyT, uint32_t), int (*c)(KeyT, KeyT))                    \
+    {                                                                                                                       \
+        if (0 == shards)                                                                                                    \
+        {                                                                                                                   \
+            shards = ZMAP_CONCURRENT_DEFAULT_SHARDS;                                                                        \
+        }                                                                                                                   \
+        if (shards > ZMAP_CONCURRENT_MAX_SHARDS)                                                                            \
+        {                                                                                                                   \
+            shards = ZMAP_CONCURRENT_MAX_SHARDS;                                                                            \
+        }                                                                                                                   \
+        shards = zmap_next_pow2(shards);                                                                                    \
+        void *mem = ZMAP_HMALLOC__(m, shards * sizeof(zmap_shard_##Name) + ZMAP_CACHE_LINE);                                \
+        if (!mem)                                                                                                           \
+        {                                                                                                                   \
+            return Z_ENOMEM;                                                                                                \
+        }                                                                                                                   \
+        uintptr_t aligned = ((uintptr_t)mem + ZMAP_CACHE_LINE - 1) & ~(uintptr_t)(ZMAP_CACHE_LINE - 1);                     \
+        m->shards = (zmap_shard_##Name *)aligned;                                                                           \
+        m->shard_mem = mem;                                                                                                 \
+        m->shard_count = shards;                                                                                            \
+        m->seed = 0xCAFEBABE;                                                                                               \
+        m->hash_func = h;                                                                                                   \
+        m->cmp_func = c;                                                                                                    \
+        for (size_t i = 0; i < shards; i++)                                                                                 \
+        {                                                                                                                   \
+            zrwlock_init(&m->shards[i].s.lock);                                                                             \
+            m->shards[i].s.map = zmap_init_##Name##_shard(h, c);                                                            \
+            ZMAP_CONCURRENT_SHARD_ALLOCATOR__(Name, &m->shards[i].s.map, m->allocator);                                     \
+            zmap_set_seed_##Name##_shard(&m->shards[i].s.map, m->seed);                                                     \
+        }                                                                                                                   \
+        return Z_OK;                                                                                                        \
+    }                                                                                                                       \
+                                                                                                                            \
+    static inline int zmap_init_concurrent_##Name(zmap_concurrent_##Name *m, size_t shards,                                 \
+                                                  uint32_t (*h)(KeyT, uint32_t), int (*c)(KeyT, KeyT))                      \
+    {                                                                                                                       \
+        ZMAP_CONCURRENT_ALLOCATOR_RESET__(m);                                                                               \
+        return zmap_setup_concurrent__##Name(m, shards, h, c);                                                              \
+    }                                                                                                                       \
+                                                                                                                            \
+    /* Not thread-safe: call before the map is shared (existing entries keep their old hashes). */                          \
+    static inline void zmap_set_seed_concurrent_##Name(zmap_concurrent_##Name *m, uint32_t s)                               \
+    {                                                                                                                       \
+        m->seed = s;                                                                                                        \
+        for (size_t i = 0; i < m->shard_count; i++)                                                                         \
+        {                                                                                                                   \
+            zmap_set_seed_##Name##_shard(&m->shards[i].s.map, s);                                                           \
+        }                                                                                                                   \
+    }                                                                                                                       \
+                                                                                                                            \
+    /* Not thread-safe: all other users must be done with the map. */                                                       \
+    static inline void zmap_free_concurrent_##Name(zmap_concurrent_##Name *m)                                               \
+    {                                                                                                                       \
+        for (size_t i = 0; i < m->shard_count; i++)                                                                         \
+        {                                                                                                                   \
+            zmap_free_##Name##_shard(&m->shards[i].s.map);                                                                  \
+            zrwlock_destroy(&m->shards[i].s.lock);                                                                          \
+        }                                                                                                                   \
+        ZMAP_HFREE__(m, m->shard_mem, m->shard_count * sizeof(zmap_shard_##Name) + ZMAP_CACHE_LINE);                        \
+        m->shards = NULL;                                                                                                   \
+        m->shard_mem = NULL;                                                                                                \
+        m->shard_count = 0;                                                                                                 \
+    }                                                                                                                       \
+                                                                                                                            \
+    ZMAP_GEN_CONCURRENT_SET_ALLOCATOR__(KeyT, ValT, Name)                                                                   \
+                                                                                                                            \
+    static inline void zmap_clear_concurrent_##Name(zmap_concurrent_##Name *m)                                              \
+    {                                                                                                                       \
+        for (size_t i = 0; i < m->shard_count; i++)                                                                         \
+        {                                                                                                                   \
+            zrwlock_write_lock(&m->shards[i].s.lock);                                                                       \
+            zmap_clear_##Name##_shard(&m->shards[i].s.map);                                                                 \
+            zrwlock_write_unlock(&m->shards[i].s.lock);                                                                     \
+        }                                                                                                                   \
+    }                                                                                                                       \
+                                                                                                                            \
+    static inline int zmap_put_concurrent_##Name(zmap_concurrent_##Name *m, KeyT key, ValT val)                             \
+    {                                                                                                                       \
+        uint32_t hash = m->hash_func(key, m->seed);                                                                         \
+        zmap_shard_body_##Name *s = &m->shards[zmap_shard_index(hash, m->shard_count)].s;                                   \
+        zrwlock_write_lock(&s->lock);                                                                                       \
+        int res = zmap_put_with_hash_##Name##_shard(&s->map, key, val, hash);                                               \
+        zrwlock_write_unlock(&s->lock);                                                                                     \
+        return res;                                                                                                         \
+    }                                                                                                                       \
+                                                                                                                            \
+    static inline bool zmap_get_concurrent_##Name(zmap_concurrent_##Name *m, KeyT key, ValT *out)                           \
+    {                                                                                                                       \
+        uint32_t hash = m->hash_func(key, m->seed);                                                                         \
+        zmap_shard_body_##Name *s = &m->shards[zmap_shard_index(hash, m->shard_count)].s;                                   \
+        bool found = false;                                                                                                 \
+        zrwlock_read_lock(&s->lock);                                                                                        \
+        if (s->map.count > 0)                                                                                               \
+        {                                                                                                                   \
+            ValT *v = zmap_get_with_hash_##Name##_shard(&s->map, key, hash);                                                \
+            if (v)                                                                                                          \
+            {                                                                                                               \
+                if (out)                                                                                                    \
+                {                                                                                                           \
+                    *out = *v;                                                                                              \
+                }                                                                                                           \
+                found = true;                                                                                               \
+            }                                                                                                               \
+        }                                                                                                                   \
+        zrwlock_read_unlock(&s->lock);                                                                                      \
+        return found;                                                                                                       \
+    }                                                                                                                       \
+                                                                                                                            \
+    static inline void zmap_remove_concurrent_##Name(zmap_concurrent_##Name *m, KeyT key)                                   \
+    {                                                                                                                       \
+        uint32_t hash = m->hash_func(key, m->seed);                                                                         \
+        zmap_shard_body_##Name *s = &m->shards[zmap_shard_index(hash, m->shard_count)].s;                                   \
+        zrwlock_write_lock(&s->lock);                                                                                       \
+        if (s->map.count > 0)                                                                                               \
+        {                                                                                                                   \
+            zmap_remove_with_hash_##Name##_shard(&s->map, key, hash);                                                       \
+        }                                                                                                                   \
+        zrwlock_write_unlock(&s->lock);                                                                                     \
+    }                                                                                                                       \
+                                                                                                                            \
+    /* Sum of all shards; each shard is read under its lock, the total is not a global snapshot. */                         \
+    static inline size_t zmap_size_concurrent_##Name(zmap_concurrent_##Name *m)                                             \
+    {                                                                                                                       \
+        size_t total = 0;                                                                                                   \
+        for (size_t i = 0; i < m->shard_count; i++)                                                                         \
+        {                                                                                                                   \
+            zrwlock_read_lock(&m->shards[i].s.lock);                                                                        \
+            total += m->shards[i].s.map.count;                                                                              \
+            zrwlock_read_unlock(&m->shards[i].s.lock);                                                                      \
+        }                                                                                                                   \
+        return total;                                                                                                       \
+    }                                                                                                                       \
+                                                                                                                            \
+    /* Looks up n keys, taking each shard's read lock once per batch of ZMAP_CONCURRENT_BATCH.                              \
+     * found (optional) receives a flag per key; out[i] is left untouched for missing keys.                                 \
+     * Returns the number of keys found. */                                                                                 \
+    static inline size_t zmap_get_many_concurrent_##Name(zmap_concurrent_##Name *m, const KeyT *keys,                       \
+                                                         ValT *out, bool *found, size_t n)                                  \
+    {                                                                                                                       \
+        uint32_t hashes[ZMAP_CONCURRENT_BATCH];                                                                             \
+        uint32_t order[ZMAP_CONCURRENT_BATCH];                                                                              \
+        size_t hits = 0;                                                                                                    \
+        for (size_t base = 0; base < n; base += ZMAP_CONCURRENT_BATCH)                                                      \
+        {                                                                                                                   \
+            size_t batch = (n - base < ZMAP_CONCURRENT_BATCH) ? n - base : ZMAP_CONCURRENT_BATCH;                           \
+            for (size_t i = 0; i < batch; i++)                                                                              \
+            {                                                                                                               \
+                hashes[i] = m->hash_func(keys[base + i], m->seed);                                                          \
+                order[i] = (uint32_t)(zmap_shard_index(hashes[i], m->shard_count) << 8) | (uint32_t)i;                      \
+            }                                                                                                               \
+            zmap_concurrent_sort_batch(order, batch);                                                                       \
+            size_t i = 0;                                                                                                   \
+            while (i < batch)                                                                                               \
+            {                                                                                                               \
+                uint32_t shard = order[i] >> 8;                                                                             \
+                zmap_shard_body_##Name *s = &m->shards[shard].s;                                                            \
+                zrwlock_read_lock(&s->lock);                                                                                \
+                for (; i < batch && (order[i] >> 8) == shard; i++)                                                          \
+                {                                                                                                           \
+                    size_t k = base + (order[i] & 0xFF);                                                                    \
+                    ValT *v = (s->map.count > 0)                                                                            \
+                            ? zmap_get_with_hash_##Name##_shard(&s->map, keys[k], hashes[order[i] & 0xFF])                  \
+                            : NULL;                                                                                         \
+                    if (v)                                                                                                  \
+                    {                                                                                                       \
+                        out[k] = *v;                                                                                        \
+                        hits++;                                                                                             \
+                    }                                                                                                       \
+                    if (found)                                                                                              \
+                    {                                                                                                       \
+                        found[k] = (NULL != v);                                                                             \
+                    }                                                                                                       \
+                }                                                                                                           \
+                zrwlock_read_unlock(&s->lock);                                                                              \
+            }                                                                                                               \
+        }                                                                                                                   \
+        return hits;                                                                                                        \
+    }                                                                                                                       \
+                                                                                                                            \
+    /* Inserts n pairs, taking each shard's write lock once per batch of ZMAP_CONCURRENT_BATCH.                             \
+     * Later duplicates win within a shard. Stops at the first error (Z_ENOMEM); pairs in other                             \
+     * batches may already be inserted. */                                                                                  \
+    static inline int zmap_put_many_concurrent_##Name(zmap_concurrent_##Name *m, const KeyT *keys,                          \
+                                                      const ValT *vals, size_t n)                                           \
+    {                                                                                                                       \
+        uint32_t hashes[ZMAP_CONCURRENT_BATCH];                                                                             \
+        uint32_t order[ZMAP_CONCURRENT_BATCH];                                                                              \
+        for (size_t base = 0; base < n; base += ZMAP_CONCURRENT_BATCH)                                                      \
+        {                                                                                                                   \
+            size_t batch = (n - base < ZMAP_CONCURRENT_BATCH) ? n - base : ZMAP_CONCURRENT_BATCH;                           \
+            for (size_t i = 0; i < batch; i++)                                                                              \
+            {                                                                                                               \
+                hashes[i] = m->hash_func(keys[base + i], m->seed);                                                          \
+                order[i] = (uint32_t)(zmap_shard_index(hashes[i], m->shard_count) << 8) | (uint32_t)i;                      \
+            }                                                                                                               \
+            zmap_concurrent_sort_batch(order, batch);                                                                       \
+            size_t i = 0;                                                                                                   \
+            while (i < batch)                                                                                               \
+            {                                                                                                               \
+                uint32_t shard = order[i] >> 8;                                                                             \
+                zmap_shard_body_##Name *s = &m->shards[shard].s;                                                            \
+                int res = Z_OK;                                                                                             \
+                zrwlock_write_lock(&s->lock);                                                                               \
+                for (; i < batch && (order[i] >> 8) == shard && Z_OK == res; i++)                                           \
+                {                                                                                                           \
+                    size_t k = base + (order[i] & 0xFF);                                                                    \
+                    res = zmap_put_with_hash_##Name##_shard(&s->map, keys[k], vals[k], hashes[order[i] & 0xFF]);            \
+                }                                                                                                           \
+                zrwlock_write_unlock(&s->lock);                                                                             \
+                if (Z_OK != res)                                                                                            \
+                {                                                                                                           \
+                    return res;                                                                                             \
+                }                                                                                                           \
+            }                                                                                                               \
+        }                                                                                                                   \
+        return Z_OK;                                                                                                        \
+    }
+
 // Dispatch entries.
 #define M_PUT_ENTRY(K, V, N)     zmap_##N*: zmap_put_##N,
 #define M_GET_ENTRY(K, V, N)     zmap_##N*: zmap_get_##N,
@@ -1385,19 +2977,32 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
 #define M_FREE_ENTRY(K, V, N)    zmap_##N*: zmap_free_##N,
 #define M_SIZE_ENTRY(K, V, N)    zmap_##N*: zmap_size_##N,
 #define M_CLEAR_ENTRY(K, V, N)   zmap_##N*: zmap_clear_##N,
-#define M_SEED_ENTRY(K, V, N)    zmap_##N*: zmap_set_seed_##Name,
-#define M_ITER_INIT(K, V, N)     zmap_##N*: zmap_iter_init_##Name,
-#define M_ITER_NEXT(K, V, N)     zmap_iter_##N*: zmap_iter_next_##Name,
+#define M_SEED_ENTRY(K, V, N)    zmap_##N*: zmap_set_seed_##N,
+#define M_RESERVE_ENTRY(K, V, N) zmap_##N*: zmap_reserve_##N,
+#define M_ITER_INIT(K, V, N)     zmap_##N*: zmap_iter_init_##N,
+#define M_ITER_NEXT(K, V, N)     zmap_iter_##N*: zmap_iter_next_##N,
 
 #define S_PUT_ENTRY(K, V, N)     zmap_stable_##N*: zmap_put_stable_##N,
 #define S_GET_ENTRY(K, V, N)     zmap_stable_##N*: zmap_get_stable_##N,
-#define S_REM_ENTRY(K, V, N)     zmap_stable_##N*: zmap_remove_stable_##Name,
-#define S_FREE_ENTRY(K, V, N)    zmap_stable_##N*: zmap_free_stable_##Name,
-#define S_SIZE_ENTRY(K, V, N)    zmap_stable_##N*: zmap_size_stable_##Name,
-#define S_CLEAR_ENTRY(K, V, N)   zmap_stable_##N*: zmap_clear_stable_##Name,
-#define S_SEED_ENTRY(K, V, N)    zmap_stable_##N*: zmap_set_seed_stable_##Name,
-#define S_ITER_INIT(K, V, N)     zmap_stable_##N*: zmap_iter_init_stable_##Name,
-#define S_ITER_NEXT(K, V, N)     zmap_iter_stable_##N*: zmap_iter_next_stable_##Name,
+#define S_REM_ENTRY(K, V, N)     zmap_stable_##N*: zmap_remove_stable_##N,
+#define S_FREE_ENTRY(K, V, N)    zmap_stable_##N*: zmap_free_stable_##N,
+#define S_SIZE_ENTRY(K, V, N)    zmap_stable_##N*: zmap_size_stable_##N,
+#define S_CLEAR_ENTRY(K, V, N)   zmap_stable_##N*: zmap_clear_stable_##N,
+#define S_SEED_ENTRY(K, V, N)    zmap_stable_##N*: zmap_set_seed_stable_##N,
+#define S_RESERVE_ENTRY(K, V, N) zmap_stable_##N*: zmap_reserve_stable_##N,
+#define S_ITER_INIT(K, V, N)     zmap_stable_##N*: zmap_iter_init_stable_##N,
+#define S_ITER_NEXT(K, V, N)     zmap_iter_stable_##N*: zmap_iter_next_stable_##N,
+
+#define F_PUT_ENTRY(K, V, N)     zmap_flat_##N*: zmap_put_flat_##N,
+#define F_GET_ENTRY(K, V, N)     zmap_flat_##N*: zmap_get_flat_##N,
+#define F_REM_ENTRY(K, V, N)     zmap_flat_##N*: zmap_remove_flat_##N,
+#define F_FREE_ENTRY(K, V, N)    zmap_flat_##N*: zmap_free_flat_##N,
+#define F_SIZE_ENTRY(K, V, N)    zmap_flat_##N*: zmap_size_flat_##N,
+#define F_CLEAR_ENTRY(K, V, N)   zmap_flat_##N*: zmap_clear_flat_##N,
+#define F_SEED_ENTRY(K, V, N)    zmap_flat_##N*: zmap_set_seed_flat_##N,
+#define F_RESERVE_ENTRY(K, V, N) zmap_flat_##N*: zmap_reserve_flat_##N,
+#define F_ITER_INIT(K, V, N)     zmap_flat_##N*: zmap_iter_init_flat_##N,
+#define F_ITER_NEXT(K, V, N)     zmap_iter_flat_##N*: zmap_iter_next_flat_##N,
 
 #if Z_HAS_ZERROR
     static inline zres zmap_err_dummy(void* v, ...)
@@ -1408,6 +3013,8 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
 
 #   define M_PUT_SAFE_ENTRY(K, V, N) zmap_##N*: zmap_put_safe_##N,
 #   define M_GET_SAFE_ENTRY(K, V, N) zmap_##N*: zmap_get_safe_##N,
+#   define F_PUT_SAFE_ENTRY(K, V, N) zmap_flat_##N*: zmap_put_safe_flat_##N,
+#   define F_GET_SAFE_ENTRY(K, V, N) zmap_flat_##N*: zmap_get_safe_flat_##N,
 #endif
 
 // Registry Hooks.
@@ -1429,38 +3036,114 @@ static inline size_t zmap_dist(size_t index, size_t capacity, uint32_t hash, uin
 #ifndef Z_AUTOGEN_STABLE_MAPS
 #   define Z_AUTOGEN_STABLE_MAPS(X)
 #endif
+#ifndef REGISTER_FLAT_MAPS
+#   define REGISTER_FLAT_MAPS(X)
+#endif
+#ifndef Z_AUTOGEN_FLAT_MAPS
+#   define Z_AUTOGEN_FLAT_MAPS(X)
+#endif
+#ifndef REGISTER_FLAT_CACHED_MAPS
+#   define REGISTER_FLAT_CACHED_MAPS(X)
+#endif
+
+// Concurrent maps lock through zthread.h; it is only pulled in when some are registered.
+#if (defined(REGISTER_CONCURRENT_MAPS) || defined(Z_AUTOGEN_CONCURRENT_MAPS)) && !defined(ZTHREAD_H)
+#   include "zthread.h"
+#endif
+#ifndef REGISTER_CONCURRENT_MAPS
+#   define REGISTER_CONCURRENT_MAPS(X)
+#endif
+#ifndef Z_AUTOGEN_CONCURRENT_MAPS
+#   define Z_AUTOGEN_CONCURRENT_MAPS(X)
+#endif
 
 #define Z_ALL_MAPS(X)        Z_AUTOGEN_MAPS(X)        REGISTER_ZMAP_TYPES(X)
 #define Z_ALL_STABLE_MAPS(X) Z_AUTOGEN_STABLE_MAPS(X) REGISTER_STABLE_MAPS(X)
+// Cached flat maps share the flat API and dispatch; only their generator differs.
+#define Z_ALL_FLAT_PLAIN_MAPS(X) Z_AUTOGEN_FLAT_MAPS(X) REGISTER_FLAT_MAPS(X)
+#define Z_ALL_FLAT_MAPS(X)   Z_ALL_FLAT_PLAIN_MAPS(X) REGISTER_FLAT_CACHED_MAPS(X)
+#define Z_ALL_CONCURRENT_MAPS(X) Z_AUTOGEN_CONCURRENT_MAPS(X) REGISTER_CONCURRENT_MAPS(X)
+
+// Pooled stable maps are only generated when zalloc.h's zpool is available.
+#if ZMAP_HAS_ZPOOL
+#   define ZMAP_GEN_STABLE_POOL_INIT(KeyT, ValT, Name)                                                                  \
+        static inline zmap_stable_##Name zmap_init_stable_pool_##Name(uint32_t (*h)(KeyT, uint32_t),                    \
+                                                                      int (*c)(KeyT, KeyT), size_t items_per_block)     \
+        {                                                                                                               \
+            zmap_stable_##Name m = zmap_init_stable_##Name(h, c);                                                       \
+            zpool_init(&m.value_pool, sizeof(ValT), items_per_block ? items_per_block : ZMAP_POOL_DEFAULT_BLOCK);        \
+            m.pooled = true;                                                                                            \
+            return m;                                                                                                   \
+        }
+#else
+#   define ZMAP_GEN_STABLE_POOL_INIT(KeyT, ValT, Name)
+#endif
+
+// Parallel bulk build is only generated when zthread.h has been included.
+#ifdef ZTHREAD_H
+#   define ZMAP_GEN_PARALLEL_BUILD(KeyT, ValT, Name) ZMAP_GENERATE_PARALLEL_BUILD_IMPL(KeyT, ValT, Name)
+#else
+#   define ZMAP_GEN_PARALLEL_BUILD(KeyT, ValT, Name)
+#endif
 
 Z_ALL_MAPS(ZMAP_GENERATE_IMPL)
 Z_ALL_STABLE_MAPS(ZMAP_GENERATE_STABLE_IMPL)
+Z_ALL_FLAT_PLAIN_MAPS(ZMAP_GENERATE_FLAT_IMPL)
+REGISTER_FLAT_CACHED_MAPS(ZMAP_GENERATE_FLAT_CACHED_IMPL)
+Z_ALL_CONCURRENT_MAPS(ZMAP_GENERATE_CONCURRENT_IMPL)
 
 // API Macros.
 #define zmap_init(Name, h, c)        zmap_init_##Name(h, c)
 #define zmap_init_stable(Name, h, c) zmap_init_stable_##Name(h, c)
+#define zmap_init_stable_pool(Name, h, c, n) zmap_init_stable_pool_##Name(h, c, n)
+#define zmap_init_flat(Name, h, c)   zmap_init_flat_##Name(h, c)
 
 #if defined(Z_HAS_CLEANUP) && Z_HAS_CLEANUP
 #   define zmap_autofree(Name)          Z_CLEANUP(zmap_free_##Name) zmap_##Name
 #   define zmap_autofree_stable(Name)   Z_CLEANUP(zmap_free_stable_##Name) zmap_stable_##Name
+#   define zmap_autofree_flat(Name)     Z_CLEANUP(zmap_free_flat_##Name) zmap_flat_##Name
 #endif
 
-#define zmap_put(m, k, v)   _Generic((m), Z_ALL_MAPS(M_PUT_ENTRY)  Z_ALL_STABLE_MAPS(S_PUT_ENTRY)  default: 0)(m, k, v)
-#define zmap_get(m, k)      _Generic((m), Z_ALL_MAPS(M_GET_ENTRY)  Z_ALL_STABLE_MAPS(S_GET_ENTRY)  default: (void*)0)(m, k)
-#define zmap_remove(m, k)   _Generic((m), Z_ALL_MAPS(M_REM_ENTRY)  Z_ALL_STABLE_MAPS(S_REM_ENTRY)  default: (void)0)(m, k)
-#define zmap_free(m)        _Generic((m), Z_ALL_MAPS(M_FREE_ENTRY) Z_ALL_STABLE_MAPS(S_FREE_ENTRY) default: (void)0)(m)
-#define zmap_size(m)        _Generic((m), Z_ALL_MAPS(M_SIZE_ENTRY) Z_ALL_STABLE_MAPS(S_SIZE_ENTRY) default: 0)(m)
-#define zmap_clear(m)       _Generic((m), Z_ALL_MAPS(M_CLEAR_ENTRY)Z_ALL_STABLE_MAPS(S_CLEAR_ENTRY)default: (void)0)(m)
-#define zmap_set_seed(m, s) _Generic((m), Z_ALL_MAPS(M_SEED_ENTRY) Z_ALL_STABLE_MAPS(S_SEED_ENTRY) default: (void)0)(m, s)
+#define zmap_put(m, k, v)   _Generic((m), Z_ALL_MAPS(M_PUT_ENTRY)  Z_ALL_STABLE_MAPS(S_PUT_ENTRY)  \
+                                          Z_ALL_FLAT_MAPS(F_PUT_ENTRY)  default: 0)(m, k, v)
+#define zmap_get(m, k)      _Generic((m), Z_ALL_MAPS(M_GET_ENTRY)  Z_ALL_STABLE_MAPS(S_GET_ENTRY)  \
+                                          Z_ALL_FLAT_MAPS(F_GET_ENTRY)  default: (void*)0)(m, k)
+#define zmap_remove(m, k)   _Generic((m), Z_ALL_MAPS(M_REM_ENTRY)  Z_ALL_STABLE_MAPS(S_REM_ENTRY)  \
+                                          Z_ALL_FLAT_MAPS(F_REM_ENTRY)  default: (void)0)(m, k)
+#define zmap_free(m)        _Generic((m), Z_ALL_MAPS(M_FREE_ENTRY) Z_ALL_STABLE_MAPS(S_FREE_ENTRY) \
+                                          Z_ALL_FLAT_MAPS(F_FREE_ENTRY) default: (void)0)(m)
+#define zmap_size(m)        _Generic((m), Z_ALL_MAPS(M_SIZE_ENTRY) Z_ALL_STABLE_MAPS(S_SIZE_ENTRY) \
+                                          Z_ALL_FLAT_MAPS(F_SIZE_ENTRY) default: 0)(m)
+#define zmap_clear(m)       _Generic((m), Z_ALL_MAPS(M_CLEAR_ENTRY)Z_ALL_STABLE_MAPS(S_CLEAR_ENTRY)\
+                                          Z_ALL_FLAT_MAPS(F_CLEAR_ENTRY)default: (void)0)(m)
+#define zmap_set_seed(m, s) _Generic((m), Z_ALL_MAPS(M_SEED_ENTRY) Z_ALL_STABLE_MAPS(S_SEED_ENTRY) \
+                                          Z_ALL_FLAT_MAPS(F_SEED_ENTRY) default: (void)0)(m, s)
+#define zmap_reserve(m, n)  _Generic((m), Z_ALL_MAPS(M_RESERVE_ENTRY) Z_ALL_STABLE_MAPS(S_RESERVE_ENTRY) \
+                                          Z_ALL_FLAT_MAPS(F_RESERVE_ENTRY) default: 0)(m, n)
+
+// Runtime allocator (Z_ALLOCATOR_HANDLE, C only): m must not own memory yet (concurrent maps: must be empty).
+#if defined(Z_ALLOCATOR_HANDLE) && !defined(__cplusplus)
+#   define M_ALLOC_ENTRY(K, V, N) zmap_##N*: zmap_set_allocator_##N,
+#   define S_ALLOC_ENTRY(K, V, N) zmap_stable_##N*: zmap_set_allocator_stable_##N,
+#   define F_ALLOC_ENTRY(K, V, N) zmap_flat_##N*: zmap_set_allocator_flat_##N,
+#   define C_ALLOC_ENTRY(K, V, N) zmap_concurrent_##N*: zmap_set_allocator_concurrent_##N,
+#   define zmap_set_allocator(m, a) _Generic((m), Z_ALL_MAPS(M_ALLOC_ENTRY) Z_ALL_STABLE_MAPS(S_ALLOC_ENTRY) \
+                                                  Z_ALL_FLAT_MAPS(F_ALLOC_ENTRY)                             \
+                                                  Z_ALL_CONCURRENT_MAPS(C_ALLOC_ENTRY) default: (void)0)(m, a)
+#endif
 
 #if Z_HAS_ZERROR
-#   define zmap_put_safe(m, k, v) _Generic((m), Z_ALL_MAPS(M_PUT_SAFE_ENTRY) default: zmap_err_dummy)(m, k, v, __FILE__, __LINE__, __func__)
-#   define zmap_get_safe(m, k)    _Generic((m), Z_ALL_MAPS(M_GET_SAFE_ENTRY) default: zmap_err_dummy)(m, k, __FILE__, __LINE__, __func__)
+#   define zmap_put_safe(m, k, v) _Generic((m), Z_ALL_MAPS(M_PUT_SAFE_ENTRY) Z_ALL_FLAT_MAPS(F_PUT_SAFE_ENTRY) \
+                                              default: zmap_err_dummy)(m, k, v, __FILE__, __LINE__, __func__)
+#   define zmap_get_safe(m, k)    _Generic((m), Z_ALL_MAPS(M_GET_SAFE_ENTRY) Z_ALL_FLAT_MAPS(F_GET_SAFE_ENTRY) \
+                                              default: zmap_err_dummy)(m, k, __FILE__, __LINE__, __func__)
 #endif
 
 // Iterators.
-#define zmap_iter_init(Name, m) _Generic((m), Z_ALL_MAPS(M_ITER_INIT) Z_ALL_STABLE_MAPS(S_ITER_INIT) default: 0)(m)
-#define zmap_iter_next(it, k, v) _Generic((it), Z_ALL_MAPS(M_ITER_NEXT) Z_ALL_STABLE_MAPS(S_ITER_NEXT) default: false)(it, k, v)
+#define zmap_iter_init(Name, m) _Generic((m), Z_ALL_MAPS(M_ITER_INIT) Z_ALL_STABLE_MAPS(S_ITER_INIT) \
+                                              Z_ALL_FLAT_MAPS(F_ITER_INIT) default: 0)(m)
+#define zmap_iter_next(it, k, v) _Generic((it), Z_ALL_MAPS(M_ITER_NEXT) Z_ALL_STABLE_MAPS(S_ITER_NEXT) \
+                                                Z_ALL_FLAT_MAPS(F_ITER_NEXT) default: false)(it, k, v)
 
 /* * zmap_foreach(Name, m, k_ptr, v_ptr)
  * Iterates over the map. k_ptr and v_ptr are assigned pointers to key and value.
@@ -1472,14 +3155,29 @@ Z_ALL_STABLE_MAPS(ZMAP_GENERATE_STABLE_IMPL)
            ((k_ptr) = &(m)->buckets[_i_##Name].key) && \
            ((v_ptr) = (void*)&(m)->buckets[_i_##Name].value))
 
+/* * zmap_foreach_flat(Name, m, k_ptr, v_ptr)
+ * Same as zmap_foreach, for flat maps (walks the control tags).
+ */
+#define zmap_foreach_flat(Name, m, k_ptr, v_ptr) \
+    for (size_t _i_##Name = 0; _i_##Name < (m)->capacity; ++_i_##Name) \
+        if (0 == ((m)->ctrl[_i_##Name] & 0x80) && \
+           ((k_ptr) = &(m)->slots[_i_##Name].key) && \
+           ((v_ptr) = &(m)->slots[_i_##Name].value))
+
 // Optional short names.
 #ifdef ZMAP_SHORT_NAMES
 #   define map(Name)           zmap_##Name
 #   define map_stable(Name)    zmap_stable_##Name
+#   define map_flat(Name)      zmap_flat_##Name
+#   define map_concurrent(Name) zmap_concurrent_##Name
 #   define map_init            zmap_init
 #   define map_init_stable     zmap_init_stable 
+#   define map_init_stable_pool zmap_init_stable_pool
+#   define map_init_flat       zmap_init_flat
 #   define map_autofree        zmap_autofree
 #   define map_autofree_stable zmap_autofree_stable
+#   define map_autofree_flat   zmap_autofree_flat
+#   define map_foreach_flat    zmap_foreach_flat
 #   define map_put             zmap_put
 #   define map_get             zmap_get
 #   define map_remove          zmap_remove
@@ -1487,6 +3185,7 @@ Z_ALL_STABLE_MAPS(ZMAP_GENERATE_STABLE_IMPL)
 #   define map_size            zmap_size
 #   define map_clear           zmap_clear
 #   define map_set_seed        zmap_set_seed
+#   define map_reserve         zmap_reserve
     
 #   define map_iter_init       zmap_iter_init
 #   define map_iter_next       zmap_iter_next
@@ -1514,9 +3213,48 @@ namespace z_map
             static constexpr auto clear = ::zmap_clear_##Name;              \
             static constexpr auto free = ::zmap_free_##Name;                \
             static constexpr auto set_seed = ::zmap_set_seed_##Name;        \
+            static constexpr auto reserve = ::zmap_reserve_##Name;          \
+            static constexpr float default_load = ZMAP_DEFAULT_LOAD;        \
+                                                                            \
+            static inline bool occupied(const map_type *m, size_t i)        \
+            {                                                               \
+                return ZMAP_OCCUPIED == m->buckets[i].state;                \
+            }                                                               \
+                                                                            \
+            static inline bucket_type *slot(map_type *m, size_t i)          \
+            {                                                               \
+                return &m->buckets[i];                                      \
+            }                                                               \
+        };
+
+    #define ZMAP_CPP_FLAT_TRAITS(Key, Val, Name)                            \
+        template<> struct flat_traits<Key, Val>                             \
+        {                                                                   \
+            using map_type = ::zmap_flat_##Name;                            \
+            using bucket_type = ::zmap_bucket_flat_##Name;                  \
+            static constexpr auto init = ::zmap_init_ext_flat_##Name;       \
+            static constexpr auto put = ::zmap_put_flat_##Name;             \
+            static constexpr auto get = ::zmap_get_flat_##Name;             \
+            static constexpr auto remove = ::zmap_remove_flat_##Name;       \
+            static constexpr auto clear = ::zmap_clear_flat_##Name;         \
+            static constexpr auto free = ::zmap_free_flat_##Name;           \
+            static constexpr auto set_seed = ::zmap_set_seed_flat_##Name;   \
+            static constexpr auto reserve = ::zmap_reserve_flat_##Name;     \
+            static constexpr float default_load = ZMAP_FLAT_DEFAULT_LOAD;   \
+                                                                            \
+            static inline bool occupied(const map_type *m, size_t i)        \
+            {                                                               \
+                return 0 == (m->ctrl[i] & 0x80);                            \
+            }                                                               \
+                                                                            \
+            static inline bucket_type *slot(map_type *m, size_t i)          \
+            {                                                               \
+                return &m->slots[i];                                        \
+            }                                                               \
         };
 
     Z_ALL_MAPS(ZMAP_CPP_TRAITS)
+    Z_ALL_FLAT_MAPS(ZMAP_CPP_FLAT_TRAITS)
 }
 #endif // __cplusplus
 
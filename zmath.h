@@ -7,7 +7,8 @@
  * • Zero standard library dependencies (No <math.h> needed).
  * • Scalar math (clamp, lerp, smoothstep).
  * • Fast approximate trigonometry (polynomial).
- * • Vector math (vec2, vec3).
+ * • Vector math (vec2, vec3, vec4) and 4x4 matrices.
+ * • SIMD batch kernels (SSE2/AVX2/NEON) over arrays and SoA vector streams.
  *
  * License: MIT
  * Author: Zuhaitz
@@ -18,9 +19,31 @@
 #ifndef ZMATH_H
 #define ZMATH_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
+// SIMD selection.
+//
+// x86 always gets the 4-wide SSE2 path (baseline on x86-64); AVX2 widens the
+// batch and stream kernels to 8 lanes. AArch64 uses NEON. Define ZMATH_NO_SIMD
+// to force the scalar fallback. The intrinsic headers are pulled in here,
+// ahead of the short names and outside extern "C".
+
+#if defined(ZMATH_IMPLEMENTATION) && !defined(Z_NO_EXTENSIONS) && !defined(ZMATH_NO_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#   include <emmintrin.h>
+#   define ZMATH_SIMD_SSE2 1
+#   if defined(__AVX2__)
+#       include <immintrin.h>
+#       define ZMATH_SIMD_AVX2 1
+#   endif
+#elif defined(ZMATH_IMPLEMENTATION) && !defined(Z_NO_EXTENSIONS) && !defined(ZMATH_NO_SIMD) && \
+    (defined(__aarch64__) || defined(_M_ARM64))
+#   include <arm_neon.h>
+#   define ZMATH_SIMD_NEON 1
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -40,8 +63,27 @@ extern "C" {
 
 // Types.
 
+// 16-byte alignment for the SIMD-friendly types.
+#if defined(__cplusplus)
+#   define ZMATH_ALIGN(n) alignas(n)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#   define ZMATH_ALIGN(n) _Alignas(n)
+#elif defined(_MSC_VER)
+#   define ZMATH_ALIGN(n) __declspec(align(n))
+#else
+#   define ZMATH_ALIGN(n) __attribute__((aligned(n)))
+#endif
+
 typedef struct { float x, y; } zvec2;
 typedef struct { float x, y, z; } zvec3;
+typedef struct { ZMATH_ALIGN(16) float x; float y, z, w; } zvec4;
+
+// Column-major 4x4 matrix: element (row r, column c) is m[c * 4 + r].
+typedef struct { ZMATH_ALIGN(16) float m[16]; } zmat4;
+
+// Structure-of-arrays vector streams: one array per component, count elements each.
+typedef struct { float *x, *y, *z; size_t count; } zvec3_stream;
+typedef struct { float *x, *y, *z, *w; size_t count; } zvec4_stream;
 
 // API declarations.
 
@@ -116,6 +158,44 @@ ZMATHDEF zvec3 zmath_v3_cross(zvec3 a, zvec3 b);
 ZMATHDEF float zmath_v3_len(zvec3 v);
 ZMATHDEF zvec3 zmath_v3_norm(zvec3 v);
 
+ZMATHDEF zvec4 zmath_v4_add(zvec4 a, zvec4 b);
+ZMATHDEF zvec4 zmath_v4_sub(zvec4 a, zvec4 b);
+ZMATHDEF zvec4 zmath_v4_scale(zvec4 v, float s);
+ZMATHDEF float zmath_v4_dot(zvec4 a, zvec4 b);
+
+// Matrices.
+ZMATHDEF zmat4 zmath_m4_identity(void);
+ZMATHDEF zmat4 zmath_m4_mul(const zmat4 *a, const zmat4 *b);
+ZMATHDEF zmat4 zmath_m4_transpose(const zmat4 *m);
+ZMATHDEF zmat4 zmath_m4_translate(zvec3 t);
+ZMATHDEF zmat4 zmath_m4_scale(zvec3 s);
+ZMATHDEF zmat4 zmath_m4_rotate(zvec3 axis, float angle);
+ZMATHDEF zvec4 zmath_m4_mul_v4(const zmat4 *m, zvec4 v);
+ZMATHDEF zvec3 zmath_m4_transform_point(const zmat4 *m, zvec3 p);
+ZMATHDEF void  zmath_m4_transform_v4_many(const zmat4 *m, zvec4 *out, const zvec4 *in, size_t n);
+
+// Batch math over arrays (out may alias in).
+ZMATHDEF void  zmath_sin_n(float *out, const float *in, size_t n);
+ZMATHDEF void  zmath_cos_n(float *out, const float *in, size_t n);
+ZMATHDEF void  zmath_exp_n(float *out, const float *in, size_t n);
+
+// SoA streams: each call covers a->count elements, outputs may alias inputs.
+ZMATHDEF void  zmath_v3_stream_add(zvec3_stream *out, const zvec3_stream *a, const zvec3_stream *b);
+ZMATHDEF void  zmath_v3_stream_sub(zvec3_stream *out, const zvec3_stream *a, const zvec3_stream *b);
+ZMATHDEF void  zmath_v3_stream_scale(zvec3_stream *out, const zvec3_stream *a, float s);
+ZMATHDEF void  zmath_v3_stream_madd(zvec3_stream *out, const zvec3_stream *a, const zvec3_stream *b, float s);
+ZMATHDEF void  zmath_v3_stream_dot(float *out, const zvec3_stream *a, const zvec3_stream *b);
+ZMATHDEF void  zmath_v3_stream_cross(zvec3_stream *out, const zvec3_stream *a, const zvec3_stream *b);
+ZMATHDEF void  zmath_v3_stream_len(float *out, const zvec3_stream *a);
+ZMATHDEF void  zmath_v3_stream_norm(zvec3_stream *out, const zvec3_stream *a);
+ZMATHDEF void  zmath_v3_stream_transform(zvec3_stream *out, const zmat4 *m, const zvec3_stream *a);
+
+ZMATHDEF void  zmath_v4_stream_add(zvec4_stream *out, const zvec4_stream *a, const zvec4_stream *b);
+ZMATHDEF void  zmath_v4_stream_scale(zvec4_stream *out, const zvec4_stream *a, float s);
+ZMATHDEF void  zmath_v4_stream_madd(zvec4_stream *out, const zvec4_stream *a, const zvec4_stream *b, float s);
+ZMATHDEF void  zmath_v4_stream_dot(float *out, const zvec4_stream *a, const zvec4_stream *b);
+ZMATHDEF void  zmath_v4_stream_transform(zvec4_stream *out, const zmat4 *m, const zvec4_stream *a);
+
 // Optional short names.
 #ifdef ZMATH_SHORT_NAMES
     // Constants.
@@ -129,6 +209,8 @@ ZMATHDEF zvec3 zmath_v3_norm(zvec3 v);
     // Types.
     typedef zvec2       vec2;
     typedef zvec3       vec3;
+    typedef zvec4       vec4;
+    typedef zmat4       mat4;
 
     // Logic, we undefine standard macros if they exist.
 #   ifdef isnan
@@ -231,6 +313,15 @@ ZMATHDEF zvec3 zmath_v3_norm(zvec3 v);
 #   define v3_cross    zmath_v3_cross
 #   define v3_len      zmath_v3_len
 #   define v3_norm     zmath_v3_norm
+
+#   define v4_add      zmath_v4_add
+#   define v4_sub      zmath_v4_sub
+#   define v4_scale    zmath_v4_scale
+#   define v4_dot      zmath_v4_dot
+
+#   define m4_identity zmath_m4_identity
+#   define m4_mul      zmath_m4_mul
+#   define m4_mul_v4   zmath_m4_mul_v4
 #endif
 
 #ifdef __cplusplus
@@ -496,7 +587,7 @@ ZMATHDEF float zmath_exp(float x)
     float f = 1.0f + r + (r2 * 0.5f) + (r * r2 * 0.16666666f);
     int int_part = (int)n;
     uint32_t bits = zmath__float_as_uint(f);
-    bits += (int_part << 23);
+    bits += (uint32_t)int_part << 23;
     return zmath__uint_as_float(bits);
 }
 
@@ -689,4 +780,720 @@ ZMATHDEF zvec3 zmath_v3_norm(zvec3 v)
     return (len > ZMATH_EPSILON) ? zmath_v3_scale(v, 1.0f/len) : v;
 }
 
+ZMATHDEF zvec4 zmath_v4_add(zvec4 a, zvec4 b) 
+{ 
+    zvec4 r = {a.x+b.x, a.y+b.y, a.z+b.z, a.w+b.w}; 
+    return r; 
+}
+
+ZMATHDEF zvec4 zmath_v4_sub(zvec4 a, zvec4 b) 
+{ 
+    zvec4 r = {a.x-b.x, a.y-b.y, a.z-b.z, a.w-b.w}; 
+    return r; 
+}
+
+ZMATHDEF zvec4 zmath_v4_scale(zvec4 v, float s) 
+{ 
+    zvec4 r = {v.x*s, v.y*s, v.z*s, v.w*s}; 
+    return r; 
+}
+
+ZMATHDEF float zmath_v4_dot(zvec4 a, zvec4 b) 
+{ 
+    return a.x*b.x + a.y*b.y + a.z*b.z + a.w*b.w; 
+}
+
+// 4-wide lanes (matrices and vec4).
+
+#if defined(ZMATH_SIMD_SSE2)
+
+typedef __m128 zmath__f4;
+static inline zmath__f4 zmath__f4_load(const float *p)           { return _mm_loadu_ps(p); }
+static inline void      zmath__f4_store(float *p, zmath__f4 v)   { _mm_storeu_ps(p, v); }
+static inline zmath__f4 zmath__f4_set1(float s)                  { return _mm_set1_ps(s); }
+static inline zmath__f4 zmath__f4_mul(zmath__f4 a, zmath__f4 b)  { return _mm_mul_ps(a, b); }
+static inline zmath__f4 zmath__f4_madd(zmath__f4 a, zmath__f4 b, zmath__f4 c)
+{
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+#   define ZMATH__HAS_F4 1
+
+#elif defined(ZMATH_SIMD_NEON)
+
+typedef float32x4_t zmath__f4;
+static inline zmath__f4 zmath__f4_load(const float *p)           { return vld1q_f32(p); }
+static inline void      zmath__f4_store(float *p, zmath__f4 v)   { vst1q_f32(p, v); }
+static inline zmath__f4 zmath__f4_set1(float s)                  { return vdupq_n_f32(s); }
+static inline zmath__f4 zmath__f4_mul(zmath__f4 a, zmath__f4 b)  { return vmulq_f32(a, b); }
+static inline zmath__f4 zmath__f4_madd(zmath__f4 a, zmath__f4 b, zmath__f4 c)
+{
+    return vmlaq_f32(c, a, b);
+}
+#   define ZMATH__HAS_F4 1
+
+#endif
+
+// Wide lanes (batch and stream kernels).
+//
+// Masks are carried as float vectors with all bits set in the true lanes.
+
+#if defined(ZMATH_SIMD_AVX2)
+
+typedef __m256 zmath__vf;
+#   define ZMATH__W 8
+static inline zmath__vf zmath__vf_load(const float *p)            { return _mm256_loadu_ps(p); }
+static inline void      zmath__vf_store(float *p, zmath__vf v)    { _mm256_storeu_ps(p, v); }
+static inline zmath__vf zmath__vf_set1(float s)                   { return _mm256_set1_ps(s); }
+static inline zmath__vf zmath__vf_add(zmath__vf a, zmath__vf b)   { return _mm256_add_ps(a, b); }
+static inline zmath__vf zmath__vf_sub(zmath__vf a, zmath__vf b)   { return _mm256_sub_ps(a, b); }
+static inline zmath__vf zmath__vf_mul(zmath__vf a, zmath__vf b)   { return _mm256_mul_ps(a, b); }
+static inline zmath__vf zmath__vf_div(zmath__vf a, zmath__vf b)   { return _mm256_div_ps(a, b); }
+static inline zmath__vf zmath__vf_sqrt(zmath__vf a)               { return _mm256_sqrt_ps(a); }
+static inline zmath__vf zmath__vf_and(zmath__vf a, zmath__vf b)   { return _mm256_and_ps(a, b); }
+static inline zmath__vf zmath__vf_or(zmath__vf a, zmath__vf b)    { return _mm256_or_ps(a, b); }
+static inline zmath__vf zmath__vf_abs(zmath__vf a)                { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+static inline zmath__vf zmath__vf_gt(zmath__vf a, zmath__vf b)    { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+static inline zmath__vf zmath__vf_round(zmath__vf a)
+{
+    return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+}
+static inline zmath__vf zmath__vf_select(zmath__vf m, zmath__vf a, zmath__vf b)
+{
+    return _mm256_blendv_ps(b, a, m);
+}
+// f * 2^n for integral n, by adding n straight into the exponent field.
+static inline zmath__vf zmath__vf_ldexp(zmath__vf f, zmath__vf n)
+{
+    __m256i e = _mm256_slli_epi32(_mm256_cvtps_epi32(n), 23);
+    return _mm256_castsi256_ps(_mm256_add_epi32(_mm256_castps_si256(f), e));
+}
+
+#elif defined(ZMATH_SIMD_SSE2)
+
+typedef __m128 zmath__vf;
+#   define ZMATH__W 4
+static inline zmath__vf zmath__vf_load(const float *p)            { return _mm_loadu_ps(p); }
+static inline void      zmath__vf_store(float *p, zmath__vf v)    { _mm_storeu_ps(p, v); }
+static inline zmath__vf zmath__vf_set1(float s)                   { return _mm_set1_ps(s); }
+static inline zmath__vf zmath__vf_add(zmath__vf a, zmath__vf b)   { return _mm_add_ps(a, b); }
+static inline zmath__vf zmath__vf_sub(zmath__vf a, zmath__vf b)   { return _mm_sub_ps(a, b); }
+static inline zmath__vf zmath__vf_mul(zmath__vf a, zmath__vf b)   { return _mm_mul_ps(a, b); }
+static inline zmath__vf zmath__vf_div(zmath__vf a, zmath__vf b)   { return _mm_div_ps(a, b); }
+static inline zmath__vf zmath__vf_sqrt(zmath__vf a)               { return _mm_sqrt_ps(a); }
+static inline zmath__vf zmath__vf_and(zmath__vf a, zmath__vf b)   { return _mm_and_ps(a, b); }
+static inline zmath__vf zmath__vf_or(zmath__vf a, zmath__vf b)    { return _mm_or_ps(a, b); }
+static inline zmath__vf zmath__vf_abs(zmath__vf a)                { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+static inline zmath__vf zmath__vf_gt(zmath__vf a, zmath__vf b)    { return _mm_cmpgt_ps(a, b); }
+static inline zmath__vf zmath__vf_round(zmath__vf a)
+{
+    // SSE2 has no packed round; the int conversion rounds to nearest under
+    // the default MXCSR mode.
+    return _mm_cvtepi32_ps(_mm_cvtps_epi32(a));
+}
+static inline zmath__vf zmath__vf_select(zmath__vf m, zmath__vf a, zmath__vf b)
+{
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+static inline zmath__vf zmath__vf_ldexp(zmath__vf f, zmath__vf n)
+{
+    __m128i e = _mm_slli_epi32(_mm_cvtps_epi32(n), 23);
+    return _mm_castsi128_ps(_mm_add_epi32(_mm_castps_si128(f), e));
+}
+
+#elif defined(ZMATH_SIMD_NEON)
+
+typedef float32x4_t zmath__vf;
+#   define ZMATH__W 4
+static inline zmath__vf zmath__vf_load(const float *p)            { return vld1q_f32(p); }
+static inline void      zmath__vf_store(float *p, zmath__vf v)    { vst1q_f32(p, v); }
+static inline zmath__vf zmath__vf_set1(float s)                   { return vdupq_n_f32(s); }
+static inline zmath__vf zmath__vf_add(zmath__vf a, zmath__vf b)   { return vaddq_f32(a, b); }
+static inline zmath__vf zmath__vf_sub(zmath__vf a, zmath__vf b)   { return vsubq_f32(a, b); }
+static inline zmath__vf zmath__vf_mul(zmath__vf a, zmath__vf b)   { return vmulq_f32(a, b); }
+static inline zmath__vf zmath__vf_div(zmath__vf a, zmath__vf b)   { return vdivq_f32(a, b); }
+static inline zmath__vf zmath__vf_sqrt(zmath__vf a)               { return vsqrtq_f32(a); }
+static inline zmath__vf zmath__vf_abs(zmath__vf a)                { return vabsq_f32(a); }
+static inline zmath__vf zmath__vf_round(zmath__vf a)              { return vrndnq_f32(a); }
+static inline zmath__vf zmath__vf_and(zmath__vf a, zmath__vf b)
+{
+    return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+}
+static inline zmath__vf zmath__vf_or(zmath__vf a, zmath__vf b)
+{
+    return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+}
+static inline zmath__vf zmath__vf_gt(zmath__vf a, zmath__vf b)
+{
+    return vreinterpretq_f32_u32(vcgtq_f32(a, b));
+}
+static inline zmath__vf zmath__vf_select(zmath__vf m, zmath__vf a, zmath__vf b)
+{
+    return vbslq_f32(vreinterpretq_u32_f32(m), a, b);
+}
+static inline zmath__vf zmath__vf_ldexp(zmath__vf f, zmath__vf n)
+{
+    int32x4_t e = vshlq_n_s32(vcvtq_s32_f32(n), 23);
+    return vreinterpretq_f32_s32(vaddq_s32(vreinterpretq_s32_f32(f), e));
+}
+
+#endif
+
+#ifdef ZMATH__W
+
+static inline zmath__vf zmath__vf_madd(zmath__vf a, zmath__vf b, zmath__vf c)
+{
+    return zmath__vf_add(zmath__vf_mul(a, b), c);
+}
+
+// Same reduction, fold and polynomial as zmath_sin, lane by lane.
+static inline zmath__vf zmath__vf_sin(zmath__vf x)
+{
+    zmath__vf q = zmath__vf_round(zmath__vf_mul(x, zmath__vf_set1(1.0f / ZMATH_TAU)));
+    x = zmath__vf_sub(x, zmath__vf_mul(q, zmath__vf_set1(ZMATH_TAU)));
+
+    // |x| > pi/2 folds to copysign(pi, x) - x.
+    zmath__vf sign = zmath__vf_and(x, zmath__vf_set1(-0.0f));
+    zmath__vf fold = zmath__vf_sub(zmath__vf_or(sign, zmath__vf_set1(ZMATH_PI)), x);
+    x = zmath__vf_select(zmath__vf_gt(zmath__vf_abs(x), zmath__vf_set1(ZMATH_HALF_PI)), fold, x);
+
+    zmath__vf x2 = zmath__vf_mul(x, x);
+    zmath__vf p = zmath__vf_madd(x2, zmath__vf_set1(ZMATH_SIN_C3), zmath__vf_set1(ZMATH_SIN_C2));
+    p = zmath__vf_madd(x2, p, zmath__vf_set1(ZMATH_SIN_C1));
+    p = zmath__vf_madd(x2, p, zmath__vf_set1(ZMATH_SIN_C0));
+    p = zmath__vf_madd(x2, p, zmath__vf_set1(1.0f));
+    return zmath__vf_mul(x, p);
+}
+
+// Same split as zmath_exp: 2^n from the exponent bits, cubic for the rest.
+static inline zmath__vf zmath__vf_exp(zmath__vf x)
+{
+    zmath__vf px = zmath__vf_mul(x, zmath__vf_set1(1.44269504088f));
+    zmath__vf n = zmath__vf_round(px);
+    zmath__vf r = zmath__vf_mul(zmath__vf_sub(px, n), zmath__vf_set1(0.69314718056f));
+    zmath__vf r2 = zmath__vf_mul(r, r);
+    zmath__vf f = zmath__vf_add(zmath__vf_set1(1.0f), r);
+    f = zmath__vf_madd(r2, zmath__vf_set1(0.5f), f);
+    f = zmath__vf_madd(zmath__vf_mul(r, r2), zmath__vf_set1(0.16666666f), f);
+    return zmath__vf_ldexp(f, n);
+}
+
+// Runs KERNEL over n floats; the ragged tail goes through a zero-padded
+// block so every element sees the same vector code.
+#define ZMATH__BATCH(out, in, n, KERNEL)                                       \
+    do                                                                         \
+    {                                                                          \
+        size_t i_ = 0;                                                         \
+        for (; i_ + ZMATH__W <= (n); i_ += ZMATH__W)                           \
+        {                                                                      \
+            zmath__vf_store((out) + i_, KERNEL(zmath__vf_load((in) + i_)));    \
+        }                                                                      \
+        if (i_ < (n))                                                          \
+        {                                                                      \
+            float buf_[ZMATH__W] = {0};                                        \
+            memcpy(buf_, (in) + i_, ((n) - i_) * sizeof(float));               \
+            zmath__vf_store(buf_, KERNEL(zmath__vf_load(buf_)));               \
+            memcpy((out) + i_, buf_, ((n) - i_) * sizeof(float));              \
+        }                                                                      \
+    } while (0)
+
+static inline zmath__vf zmath__vf_cos(zmath__vf x)
+{
+    return zmath__vf_sin(zmath__vf_add(x, zmath__vf_set1(ZMATH_HALF_PI)));
+}
+
+#endif // ZMATH__W
+
+// Matrices.
+
+ZMATHDEF zmat4 zmath_m4_identity(void)
+{
+    zmat4 r;
+    memset(&r, 0, sizeof(r));
+    r.m[0] = r.m[5] = r.m[10] = r.m[15] = 1.0f;
+    return r;
+}
+
+ZMATHDEF zmat4 zmath_m4_mul(const zmat4 *a, const zmat4 *b)
+{
+    zmat4 r;
+#ifdef ZMATH__HAS_F4
+    zmath__f4 c0 = zmath__f4_load(a->m);
+    zmath__f4 c1 = zmath__f4_load(a->m + 4);
+    zmath__f4 c2 = zmath__f4_load(a->m + 8);
+    zmath__f4 c3 = zmath__f4_load(a->m + 12);
+    for (int j = 0; j < 4; j++)
+    {
+        const float *bj = b->m + j * 4;
+        zmath__f4 v = zmath__f4_mul(c0, zmath__f4_set1(bj[0]));
+        v = zmath__f4_madd(c1, zmath__f4_set1(bj[1]), v);
+        v = zmath__f4_madd(c2, zmath__f4_set1(bj[2]), v);
+        v = zmath__f4_madd(c3, zmath__f4_set1(bj[3]), v);
+        zmath__f4_store(r.m + j * 4, v);
+    }
+#else
+    for (int j = 0; j < 4; j++)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            r.m[j * 4 + i] = a->m[i] * b->m[j * 4] + a->m[4 + i] * b->m[j * 4 + 1] +
+                             a->m[8 + i] * b->m[j * 4 + 2] + a->m[12 + i] * b->m[j * 4 + 3];
+        }
+    }
+#endif
+    return r;
+}
+
+ZMATHDEF zmat4 zmath_m4_transpose(const zmat4 *m)
+{
+    zmat4 r;
+    for (int c = 0; c < 4; c++)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            r.m[c * 4 + i] = m->m[i * 4 + c];
+        }
+    }
+    return r;
+}
+
+ZMATHDEF zmat4 zmath_m4_translate(zvec3 t)
+{
+    zmat4 r = zmath_m4_identity();
+    r.m[12] = t.x;
+    r.m[13] = t.y;
+    r.m[14] = t.z;
+    return r;
+}
+
+ZMATHDEF zmat4 zmath_m4_scale(zvec3 s)
+{
+    zmat4 r = zmath_m4_identity();
+    r.m[0] = s.x;
+    r.m[5] = s.y;
+    r.m[10] = s.z;
+    return r;
+}
+
+ZMATHDEF zmat4 zmath_m4_rotate(zvec3 axis, float angle)
+{
+    zvec3 a = zmath_v3_norm(axis);
+    float s = zmath_sin(angle);
+    float c = zmath_cos(angle);
+    float t = 1.0f - c;
+    zmat4 r = zmath_m4_identity();
+    r.m[0]  = t*a.x*a.x + c;      r.m[4] = t*a.x*a.y - s*a.z;  r.m[8]  = t*a.x*a.z + s*a.y;
+    r.m[1]  = t*a.x*a.y + s*a.z;  r.m[5] = t*a.y*a.y + c;      r.m[9]  = t*a.y*a.z - s*a.x;
+    r.m[2]  = t*a.x*a.z - s*a.y;  r.m[6] = t*a.y*a.z + s*a.x;  r.m[10] = t*a.z*a.z + c;
+    return r;
+}
+
+ZMATHDEF zvec4 zmath_m4_mul_v4(const zmat4 *m, zvec4 v)
+{
+    zvec4 r;
+#ifdef ZMATH__HAS_F4
+    zmath__f4 acc = zmath__f4_mul(zmath__f4_load(m->m), zmath__f4_set1(v.x));
+    acc = zmath__f4_madd(zmath__f4_load(m->m + 4), zmath__f4_set1(v.y), acc);
+    acc = zmath__f4_madd(zmath__f4_load(m->m + 8), zmath__f4_set1(v.z), acc);
+    acc = zmath__f4_madd(zmath__f4_load(m->m + 12), zmath__f4_set1(v.w), acc);
+    zmath__f4_store(&r.x, acc);
+#else
+    r.x = m->m[0]*v.x + m->m[4]*v.y + m->m[8]*v.z  + m->m[12]*v.w;
+    r.y = m->m[1]*v.x + m->m[5]*v.y + m->m[9]*v.z  + m->m[13]*v.w;
+    r.z = m->m[2]*v.x + m->m[6]*v.y + m->m[10]*v.z + m->m[14]*v.w;
+    r.w = m->m[3]*v.x + m->m[7]*v.y + m->m[11]*v.z + m->m[15]*v.w;
+#endif
+    return r;
+}
+
+// Affine: w is taken as 1 and no perspective divide is applied.
+ZMATHDEF zvec3 zmath_m4_transform_point(const zmat4 *m, zvec3 p)
+{
+    zvec3 r = {
+        m->m[0]*p.x + m->m[4]*p.y + m->m[8]*p.z  + m->m[12],
+        m->m[1]*p.x + m->m[5]*p.y + m->m[9]*p.z  + m->m[13],
+        m->m[2]*p.x + m->m[6]*p.y + m->m[10]*p.z + m->m[14]
+    };
+    return r;
+}
+
+ZMATHDEF void zmath_m4_transform_v4_many(const zmat4 *m, zvec4 *out, const zvec4 *in, size_t n)
+{
+#ifdef ZMATH__HAS_F4
+    // Columns stay in registers for the whole run.
+    zmath__f4 c0 = zmath__f4_load(m->m);
+    zmath__f4 c1 = zmath__f4_load(m->m + 4);
+    zmath__f4 c2 = zmath__f4_load(m->m + 8);
+    zmath__f4 c3 = zmath__f4_load(m->m + 12);
+    for (size_t i = 0; i < n; i++)
+    {
+        zvec4 v = in[i];
+        zmath__f4 acc = zmath__f4_mul(c0, zmath__f4_set1(v.x));
+        acc = zmath__f4_madd(c1, zmath__f4_set1(v.y), acc);
+        acc = zmath__f4_madd(c2, zmath__f4_set1(v.z), acc);
+        acc = zmath__f4_madd(c3, zmath__f4_set1(v.w), acc);
+        zmath__f4_store(&out[i].x, acc);
+    }
+#else
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = zmath_m4_mul_v4(m, in[i]);
+    }
+#endif
+}
+
+// Batch math.
+
+ZMATHDEF void zmath_sin_n(float *out, const float *in, size_t n)
+{
+#ifdef ZMATH__W
+    ZMATH__BATCH(out, in, n, zmath__vf_sin);
+#else
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = zmath_sin(in[i]);
+    }
+#endif
+}
+
+ZMATHDEF void zmath_cos_n(float *out, const float *in, size_t n)
+{
+#ifdef ZMATH__W
+    ZMATH__BATCH(out, in, n, zmath__vf_cos);
+#else
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = zmath_cos(in[i]);
+    }
+#endif
+}
+
+ZMATHDEF void zmath_exp_n(float *out, const float *in, size_t n)
+{
+#ifdef ZMATH__W
+    ZMATH__BATCH(out, in, n, zmath__vf_exp);
+#else
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = zmath_exp(in[i]);
+    }
+#endif
+}
+
+// SoA streams.
+//
+// The vector loop covers whole blocks of ZMATH__W elements; the remainder
+// (and the whole stream without SIMD) goes through the scalar API.
+
+#ifdef ZMATH__W
+#   define ZMATH__LD(s, c) zmath__vf_load((s)->c + i)
+#   define ZMATH__ST(s, c, v) zmath__vf_store((s)->c + i, (v))
+#endif
+
+static inline zvec3 zmath__v3_at(const zvec3_stream *s, size_t i)
+{
+    zvec3 r = {s->x[i], s->y[i], s->z[i]};
+    return r;
+}
+
+static inline void zmath__v3_put(zvec3_stream *s, size_t i, zvec3 v)
+{
+    s->x[i] = v.x;
+    s->y[i] = v.y;
+    s->z[i] = v.z;
+}
+
+static inline zvec4 zmath__v4_at(const zvec4_stream *s, size_t i)
+{
+    zvec4 r = {s->x[i], s->y[i], s->z[i], s->w[i]};
+    return r;
+}
+
+static inline void zmath__v4_put(zvec4_stream *s, size_t i, zvec4 v)
+{
+    s->x[i] = v.x;
+    s->y[i] = v.y;
+    s->z[i] = v.z;
+    s->w[i] = v.w;
+}
+
+ZMATHDEF void zmath_v3_stream_add(zvec3_stream *out, const zvec3_stream *a, const zvec3_stream *b)
+{
+    size_t i = 0;
+#ifdef ZMATH__W
+    for (; i + ZMATH__W <= a->count; i += ZMATH__W)
+    {
+        ZMATH__ST(out, x, zmath__vf_add(ZMATH__LD(a, x), ZMATH__LD(b, x)));
+        ZMATH__ST(out, y, zmath__vf_add(ZMATH__LD(a, y), ZMATH__LD(b, y)));
+        ZMATH__ST(out, z, zmath__vf_add(ZMATH__LD(a, z), ZMATH__LD(b, z)));
+    }
+#endif
+    for (; i < a->count; i++)
+    {
+        zmath__v3_put(out, i, zmath_v3_add(zmath__v3_at(a, i), zmath__v3_at(b, i)));
+    }
+}
+
+ZMATHDEF void zmath_v3_stream_sub(zvec3_stream *out, const zvec3_stream *a, const zvec3_stream *b)
+{
+    size_t i = 0;
+#ifdef ZMATH__W
+    for (; i + ZMATH__W <= a->count; i += ZMATH__W)
+    {
+        ZMATH__ST(out, x, zmath__vf_sub(ZMATH__LD(a, x), ZMATH__LD(b, x)));
+        ZMATH__ST(out, y, zmath__vf_sub(ZMATH__LD(a, y), ZMATH__LD(b, y)));
+        ZMATH__ST(out, z, zmath__vf_sub(ZMATH__LD(a, z), ZMATH__LD(b, z)));
+    }
+#endif
+    for (; i < a->count; i++)
+    {
+        zmath__v3_put(out, i, zmath_v3_sub(zmath__v3_at(a, i), zmath__v3_at(b, i)));
+    }
+}
+
+ZMATHDEF void zmath_v3_stream_scale(zvec3_stream *out, const zvec3_stream *a, float s)
+{
+    size_t i = 0;
+#ifdef ZMATH__W
+    zmath__vf vs = zmath__vf_set1(s);
+    for (; i + ZMATH__W <= a->count; i += ZMATH__W)
+    {
+        ZMATH__ST(out, x, zmath__vf_mul(ZMATH__LD(a, x), vs));
+        ZMATH__ST(out, y, zmath__vf_mul(ZMATH__LD(a, y), vs));
+        ZMATH__ST(out, z, zmath__vf_mul(ZMATH__LD(a, z), vs));
+    }
+#endif
+    for (; i < a->count; i++)
+    {
+        zmath__v3_put(out, i, zmath_v3_scale(zmath__v3_at(a, i), s));
+    }
+}
+
+// out = a + b * s (e.g. pos += vel * dt).
+ZMATHDEF void zmath_v3_stream_madd(zvec3_stream *out, const zvec3_stream *a, const zvec3_stream *b, float s)
+{
+    size_t i = 0;
+#ifdef ZMATH__W
+    zmath__vf vs = zmath__vf_set1(s);
+    for (; i + ZMATH__W <= a->count; i += ZMATH__W)
+    {
+        ZMATH__ST(out, x, zmath__vf_madd(ZMATH__LD(b, x), vs, ZMATH__LD(a, x)));
+        ZMATH__ST(out, y, zmath__vf_madd(ZMATH__LD(b, y), vs, ZMATH__LD(a, y)));
+        ZMATH__ST(out, z, zmath__vf_madd(ZMATH__LD(b, z), vs, ZMATH__LD(a, z)));
+    }
+#endif
+    for (; i < a->count; i++)
+    {
+        zmath__v3_put(out, i, zmath_v3_add(zmath__v3_at(a, i), zmath_v3_scale(zmath__v3_at(b, i), s)));
+    }
+}
+
+ZMATHDEF void zmath_v3_stream_dot(float *out, const zvec3_stream *a, const zvec3_stream *b)
+{
+    size_t i = 0;
+#ifdef ZMATH__W
+    for (; i + ZMATH__W <= a->count; i += ZMATH__W)
+    {
+        zmath__vf d = zmath__vf_mul(ZMATH__LD(a, x), ZMATH__LD(b, x));
+        d = zmath__vf_madd(ZMATH__LD(a, y), ZMATH__LD(b, y), d);
+        d = zmath__vf_madd(ZMATH__LD(a, z), ZMATH__LD(b, z), d);
+        zmath__vf_store(out + i, d);
+    }
+#endif
+    for (; i < a->count; i++)
+    {
+        out[i] = zmath_v3_dot(zmath__v3_at(a, i), zmath__v3_at(b, i));
+    }
+}
+
+ZMATHDEF void zmath_v3_stream_cross(zvec3_stream *out, const zvec3_stream *a, const zvec3_stream *b)
+{
+    size_t i = 0;
+#ifdef ZMATH__W
+    for (; i + ZMATH__W <= a->count; i += ZMATH__W)
+    {
+        zmath__vf ax = ZMATH__LD(a, x), ay = ZMATH__LD(a, y), az = ZMATH__LD(a, z);
+        zmath__vf bx = ZMATH__LD(b, x), by = ZMATH__LD(b, y), bz = ZMATH__LD(b, z);
+        ZMATH__ST(out, x, zmath__vf_sub(zmath__vf_mul(ay, bz), zmath__vf_mul(az, by)));
+        ZMATH__ST(out, y, zmath__vf_sub(zmath__vf_mul(az, bx), zmath__vf_mul(ax, bz)));
+        ZMATH__ST(out, z, zmath__vf_sub(zmath__vf_mul(ax, by), zmath__vf_mul(ay, bx)));
+    }
+#endif
+    for (; i < a->count; i++)
+    {
+        zmath__v3_put(out, i, zmath_v3_cross(zmath__v3_at(a, i), zmath__v3_at(b, i)));
+    }
+}
+
+ZMATHDEF void zmath_v3_stream_len(float *out, const zvec3_stream *a)
+{
+    size_t i = 0;
+#ifdef ZMATH__W
+    for (; i + ZMATH__W <= a->count; i += ZMATH__W)
+    {
+        zmath__vf x = ZMATH__LD(a, x), y = ZMATH__LD(a, y), z = ZMATH__LD(a, z);
+        zmath__vf d = zmath__vf_madd(z, z, zmath__vf_madd(y, y, zmath__vf_mul(x, x)));
+        zmath__vf_store(out + i, zmath__vf_sqrt(d));
+    }
+#endif
+    for (; i < a->count; i++)
+    {
+        out[i] = zmath_v3_len(zmath__v3_at(a, i));
+    }
+}
+
+// Vectors no longer than ZMATH_EPSILON pass through unchanged, as in zmath_v3_norm.
+ZMATHDEF void zmath_v3_stream_norm(zvec3_stream *out, const zvec3_stream *a)
+{
+    size_t i = 0;
+#ifdef ZMATH__W
+    zmath__vf one = zmath__vf_set1(1.0f);
+    zmath__vf eps = zmath__vf_set1(ZMATH_EPSILON);
+    for (; i + ZMATH__W <= a->count; i += ZMATH__W)
+    {
+        zmath__vf x = ZMATH__LD(a, x), y = ZMATH__LD(a, y), z = ZMATH__LD(a, z);
+        zmath__vf len = zmath__vf_sqrt(zmath__vf_madd(z, z, zmath__vf_madd(y, y, zmath__vf_mul(x, x))));
+        zmath__vf keep = zmath__vf_gt(len, eps);
+        zmath__vf inv = zmath__vf_select(keep, zmath__vf_div(one, len), one);
+        ZMATH__ST(out, x, zmath__vf_mul(x, inv));
+        ZMATH__ST(out, y, zmath__vf_mul(y, inv));
+        ZMATH__ST(out, z, zmath__vf_mul(z, inv));
+    }
+#endif
+    for (; i < a->count; i++)
+    {
+        zmath__v3_put(out, i, zmath_v3_norm(zmath__v3_at(a, i)));
+    }
+}
+
+// Transforms points (w = 1) by m, as zmath_m4_transform_point.
+ZMATHDEF void zmath_v3_stream_transform(zvec3_stream *out, const zmat4 *m, const zvec3_stream *a)
+{
+    size_t i = 0;
+#ifdef ZMATH__W
+    zmath__vf mv[16];
+    for (int k = 0; k < 16; k++)
+    {
+        mv[k] = zmath__vf_set1(m->m[k]);
+    }
+    for (; i + ZMATH__W <= a->count; i += ZMATH__W)
+    {
+        zmath__vf x = ZMATH__LD(a, x), y = ZMATH__LD(a, y), z = ZMATH__LD(a, z);
+        for (int r = 0; r < 3; r++)
+        {
+            zmath__vf v = zmath__vf_madd(mv[r], x, mv[12 + r]);
+            v = zmath__vf_madd(mv[4 + r], y, v);
+            v = zmath__vf_madd(mv[8 + r], z, v);
+            zmath__vf_store((r == 0 ? out->x : r == 1 ? out->y : out->z) + i, v);
+        }
+    }
+#endif
+    for (; i < a->count; i++)
+    {
+        zmath__v3_put(out, i, zmath_m4_transform_point(m, zmath__v3_at(a, i)));
+    }
+}
+
+ZMATHDEF void zmath_v4_stream_add(zvec4_stream *out, const zvec4_stream *a, const zvec4_stream *b)
+{
+    size_t i = 0;
+#ifdef ZMATH__W
+    for (; i + ZMATH__W <= a->count; i += ZMATH__W)
+    {
+        ZMATH__ST(out, x, zmath__vf_add(ZMATH__LD(a, x), ZMATH__LD(b, x)));
+        ZMATH__ST(out, y, zmath__vf_add(ZMATH__LD(a, y), ZMATH__LD(b, y)));
+        ZMATH__ST(out, z, zmath__vf_add(ZMATH__LD(a, z), ZMATH__LD(b, z)));
+        ZMATH__ST(out, w, zmath__vf_add(ZMATH__LD(a, w), ZMATH__LD(b, w)));
+    }
+#endif
+    for (; i < a->count; i++)
+    {
+        zmath__v4_put(out, i, zmath_v4_add(zmath__v4_at(a, i), zmath__v4_at(b, i)));
+    }
+}
+
+ZMATHDEF void zmath_v4_stream_scale(zvec4_stream *out, const zvec4_stream *a, float s)
+{
+    size_t i = 0;
+#ifdef ZMATH__W
+    zmath__vf vs = zmath__vf_set1(s);
+    for (; i + ZMATH__W <= a->count; i += ZMATH__W)
+    {
+        ZMATH__ST(out, x, zmath__vf_mul(ZMATH__LD(a, x), vs));
+        ZMATH__ST(out, y, zmath__vf_mul(ZMATH__LD(a, y), vs));
+        ZMATH__ST(out, z, zmath__vf_mul(ZMATH__LD(a, z), vs));
+        ZMATH__ST(out, w, zmath__vf_mul(ZMATH__LD(a, w), vs));
+    }
+#endif
+    for (; i < a->count; i++)
+    {
+        zmath__v4_put(out, i, zmath_v4_scale(zmath__v4_at(a, i), s));
+    }
+}
+
+ZMATHDEF void zmath_v4_stream_madd(zvec4_stream *out, const zvec4_stream *a, const zvec4_stream *b, float s)
+{
+    size_t i = 0;
+#ifdef ZMATH__W
+    zmath__vf vs = zmath__vf_set1(s);
+    for (; i + ZMATH__W <= a->count; i += ZMATH__W)
+    {
+        ZMATH__ST(out, x, zmath__vf_madd(ZMATH__LD(b, x), vs, ZMATH__LD(a, x)));
+        ZMATH__ST(out, y, zmath__vf_madd(ZMATH__LD(b, y), vs, ZMATH__LD(a, y)));
+        ZMATH__ST(out, z, zmath__vf_madd(ZMATH__LD(b, z), vs, ZMATH__LD(a, z)));
+        ZMATH__ST(out, w, zmath__vf_madd(ZMATH__LD(b, w), vs, ZMATH__LD(a, w)));
+    }
+#endif
+    for (; i < a->count; i++)
+    {
+        zmath__v4_put(out, i, zmath_v4_add(zmath__v4_at(a, i), zmath_v4_scale(zmath__v4_at(b, i), s)));
+    }
+}
+
+ZMATHDEF void zmath_v4_stream_dot(float *out, const zvec4_stream *a, const zvec4_stream *b)
+{
+    size_t i = 0;
+#ifdef ZMATH__W
+    for (; i + ZMATH__W <= a->count; i += ZMATH__W)
+    {
+        zmath__vf d = zmath__vf_mul(ZMATH__LD(a, x), ZMATH__LD(b, x));
+        d = zmath__vf_madd(ZMATH__LD(a, y), ZMATH__LD(b, y), d);
+        d = zmath__vf_madd(ZMATH__LD(a, z), ZMATH__LD(b, z), d);
+        d = zmath__vf_madd(ZMATH__LD(a, w), ZMATH__LD(b, w), d);
+        zmath__vf_store(out + i, d);
+    }
+#endif
+    for (; i < a->count; i++)
+    {
+        out[i] = zmath_v4_dot(zmath__v4_at(a, i), zmath__v4_at(b, i));
+    }
+}
+
+ZMATHDEF void zmath_v4_stream_transform(zvec4_stream *out, const zmat4 *m, const zvec4_stream *a)
+{
+    size_t i = 0;
+#ifdef ZMATH__W
+    zmath__vf mv[16];
+    for (int k = 0; k < 16; k++)
+    {
+        mv[k] = zmath__vf_set1(m->m[k]);
+    }
+    for (; i + ZMATH__W <= a->count; i += ZMATH__W)
+    {
+        zmath__vf x = ZMATH__LD(a, x), y = ZMATH__LD(a, y), z = ZMATH__LD(a, z), w = ZMATH__LD(a, w);
+        for (int r = 0; r < 4; r++)
+        {
+            zmath__vf v = zmath__vf_mul(mv[r], x);
+            v = zmath__vf_madd(mv[4 + r], y, v);
+            v = zmath__vf_madd(mv[8 + r], z, v);
+            v = zmath__vf_madd(mv[12 + r], w, v);
+            zmath__vf_store((r == 0 ? out->x : r == 1 ? out->y : r == 2 ? out->z : out->w) + i, v);
+        }
+    }
+#endif
+    for (; i < a->count; i++)
+    {
+        zmath__v4_put(out, i, zmath_m4_mul_v4(m, zmath__v4_at(a, i)));
+    }
+}
+
 #endif // ZMATH_IMPLEMENTATION
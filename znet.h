@@ -32,6 +32,13 @@
 #   define ZNET_HAS_ZSTR 1
 #endif
 
+// Optional dependency: ztime.h (clock for event loop timers).
+// Opt-in with ZNET_USE_ZTIME, since it needs ZTIME_IMPLEMENTATION somewhere in the program.
+#if defined(ZNET_USE_ZTIME)
+#   include "ztime.h"
+#   define ZNET_HAS_ZTIME 1
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -75,7 +82,8 @@ typedef enum
 {
     ZNET_POLL_READ  = 1 << 0,
     ZNET_POLL_WRITE = 1 << 1,
-    ZNET_POLL_ERR   = 1 << 2
+    ZNET_POLL_ERR   = 1 << 2,
+    ZNET_POLL_EDGE  = 1 << 3    // Event loop only: edge-triggered registration.
 } znet_poll_flags;
 
 #define ZNET_INVALID_SOCKET (znet_socket){ ~(uintptr_t)0, false }
@@ -153,11 +161,230 @@ int znet_set_nonblocking(znet_socket s, bool enable);
 // Enable IPv4 mapping on IPv6 sockets.
 int znet_set_dual_stack(znet_socket s, bool enable);
 
+// Event loop.
+
+/* * Readiness loop for many sockets: epoll on Linux, kqueue on BSD/macOS, WSAPoll on Windows
+ * and poll() elsewhere. Callbacks receive the ready ZNET_POLL_* bits (a hangup reports ERR,
+ * plus READ when reading). With ZNET_POLL_EDGE a callback fires once per readiness change
+ * and must drain the socket until it would block; without it, readiness is level-triggered.
+ * Timers run on the loop thread with millisecond resolution (ztime.h clock with ZNET_USE_ZTIME).
+ * A loop is single-threaded: drive it and register with it from one thread.
+*/
+typedef struct znet_loop  znet_loop;
+typedef struct znet_watch znet_watch;
+typedef struct znet_timer znet_timer;
+
+typedef void (*znet_io_fn)(znet_loop *loop, znet_watch *w, int events, void *user);
+typedef void (*znet_timer_fn)(znet_loop *loop, znet_timer *t, void *user);
+
+// Returns NULL on failure.
+znet_loop *znet_loop_create(void);
+
+// Frees every watch and timer; the sockets themselves stay open. Close znet_io handles first.
+void znet_loop_destroy(znet_loop *loop);
+
+// Watches a socket (ZNET_POLL_READ | ZNET_POLL_WRITE, optionally ZNET_POLL_EDGE). NULL on failure.
+znet_watch *znet_loop_add(znet_loop *loop, znet_socket s, int events, znet_io_fn fn, void *user);
+
+// Changes the watched events. Z_OK or Z_ERR.
+int znet_loop_modify(znet_loop *loop, znet_watch *w, int events);
+
+// Stops watching; safe from any callback, including w's own. Close the socket afterwards.
+void znet_loop_remove(znet_loop *loop, znet_watch *w);
+
+znet_socket znet_watch_socket(const znet_watch *w);
+
+// Fires after delay_ms, then every repeat_ms when non-zero. A one-shot handle dies once it fired.
+znet_timer *znet_loop_timer(znet_loop *loop, uint64_t delay_ms, uint64_t repeat_ms, 
+                            znet_timer_fn fn, void *user);
+
+void znet_loop_cancel(znet_loop *loop, znet_timer *t);
+
+// One iteration: waits up to timeout_ms (-1: until an event or timer), then runs due timers and
+// ready callbacks. Returns the number of callbacks run, or -1 on error.
+int znet_loop_poll(znet_loop *loop, int timeout_ms);
+
+// Iterates until znet_loop_stop, or until no watch, timer or znet_io is left. Z_OK or Z_ERR.
+int znet_loop_run(znet_loop *loop);
+
+void znet_loop_stop(znet_loop *loop);
+
+// Loop clock in milliseconds, refreshed once per iteration.
+uint64_t znet_loop_now(const znet_loop *loop);
+
+// True when the loop runs znet_io operations on io_uring (see ZNET_USE_URING).
+bool znet_loop_uses_uring(const znet_loop *loop);
+
+// Completion-style socket I/O.
+
+/* * A znet_io owns a (nonblocking) socket on a loop and runs accept/recv/send for it,
+ * with callbacks on completion. By default this rides on the loop's readiness backend.
+ * With ZNET_USE_URING on Linux 6.0+ it uses io_uring instead: multishot accept and recv
+ * (into a provided-buffer ring shared by the loop), zero-copy sends from ZNET_ZC_THRESHOLD
+ * bytes up, and one io_uring_enter per loop iteration for everything queued meanwhile.
+ * Older kernels, or a failed setup, silently keep the readiness path.
+*/
+typedef struct znet_io znet_io;
+
+// client is invalid on failure. Accepted sockets are blocking; hand them to znet_io_open.
+typedef void (*znet_accept_fn)(znet_io *io, znet_socket client, void *user);
+// len > 0: data (valid during the call only); 0: peer closed; < 0: error. Recv stops after <= 0.
+typedef void (*znet_recv_fn)(znet_io *io, const void *data, z_ssize_t len, void *user);
+// sent is the whole length, or -1 on error. The data may be reused from here on.
+typedef void (*znet_send_fn)(znet_io *io, z_ssize_t sent, void *user);
+
+// Takes ownership of s. NULL on failure (s stays open).
+znet_io *znet_io_open(znet_loop *loop, znet_socket s);
+
+// Stops every operation (their callbacks are dropped) and closes the socket. Safe in callbacks.
+void znet_io_close(znet_io *io);
+
+// Accepts connections until closed.
+int znet_io_accept(znet_io *io, znet_accept_fn fn, void *user);
+
+// Delivers data as it arrives until the peer closes, an error, or znet_io_close.
+int znet_io_recv(znet_io *io, znet_recv_fn fn, void *user);
+
+// Queues a send; sends complete in order. data must stay valid until fn runs. fn may be NULL.
+int znet_io_send(znet_io *io, const void *data, size_t len, znet_send_fn fn, void *user);
+
+znet_socket znet_io_socket(const znet_io *io);
+znet_loop *znet_io_loop(const znet_io *io);
+
+// Batched datagrams (UDP).
+
+typedef struct 
+{
+    void     *data;
+    size_t    len;    // Receive: capacity in, bytes received out. Send: bytes to send.
+    znet_addr addr;   // Receive: sender. Send: destination, or ZNET_UNSPEC on a connected socket.
+} znet_msg;
+
+// Receives up to count datagrams with recvmmsg on Linux (one recvfrom elsewhere); waits only
+// for the first one. Returns the number received, or -1 on error.
+int znet_recv_batch(znet_socket s, znet_msg *msgs, int count);
+
+// Sends up to count datagrams with sendmmsg on Linux. Returns the number sent, or -1 on error.
+int znet_send_batch(znet_socket s, const znet_msg *msgs, int count);
+
 // HTTP
 
 #ifdef ZNET_HAS_ZSTR
 // Performs a simple blocking HTTP GET request.
 zstr znet_http_get(const char *domain, const char *path, int timeout_ms);
+
+// Headers kept per message; further ones are skipped (framing headers are still honoured).
+#ifndef ZNET_HTTP_MAX_HEADERS
+#   define ZNET_HTTP_MAX_HEADERS 32
+#endif
+
+typedef struct 
+{
+    zstr_view name;
+    zstr_view value;
+} znet_http_header;
+
+typedef struct 
+{
+    int status;
+    int version;                // 10 or 11.
+    zstr_view reason;
+    znet_http_header headers[ZNET_HTTP_MAX_HEADERS];
+    size_t header_count;
+    int64_t content_length;     // -1 if absent.
+    bool chunked;
+    bool keep_alive;
+    zstr_view body;             // Collected body; empty when streamed through on_body.
+} znet_http_response;
+
+/* * Parses a response head in place: every view points into buf, nothing is copied.
+ * Returns the head length (through the blank line), 0 if buf holds no complete head yet,
+ * or -1 if it is malformed.
+*/
+z_ssize_t znet_http_parse_response(const char *buf, size_t len, znet_http_response *out);
+
+// Value of the first header called name (case-insensitive), or an empty view.
+zstr_view znet_http_header_get(const znet_http_header *headers, size_t count, const char *name);
+
+// Receives the body as it arrives; return non-zero to abort (the call then fails).
+typedef int (*znet_http_body_fn)(const znet_http_response *res, const char *data, size_t len, void *user);
+
+typedef struct 
+{
+    const char *method;         // "GET" when NULL.
+    const char *path;           // "/" when NULL.
+    const char *headers;        // Extra header lines, each ending in "\r\n"; may be NULL.
+    const void *body;
+    size_t body_len;
+    znet_http_body_fn on_body;  // NULL collects the body into the response.
+    void *user;
+} znet_http_request;
+
+/* * Persistent HTTP/1.1 client: keeps up to ZNET_HTTP_POOL_MAX idle keep-alive connections
+ * and the resolved address per host:port, decodes chunked bodies and retries once on a
+ * fresh connection when a reused one turns out to be closed. One thread at a time.
+ * Views in results stay valid until the next call on the same client.
+*/
+typedef struct znet_http_client znet_http_client;
+
+// timeout_ms <= 0: no socket timeout. NULL on failure.
+znet_http_client *znet_http_client_create(int timeout_ms);
+void znet_http_client_destroy(znet_http_client *c);
+
+// Blocking request. Z_OK with *out filled, Z_ERR on failure.
+int znet_http_send(znet_http_client *c, const char *host, uint16_t port, 
+                   const znet_http_request *req, znet_http_response *out);
+
+// Pipelined: writes all count requests on one connection, then reads the responses in order.
+// Z_OK once all arrived; on failure, outs past the last complete response have status 0.
+int znet_http_pipeline(znet_http_client *c, const char *host, uint16_t port, 
+                       const znet_http_request *reqs, znet_http_response *outs, size_t count);
+
+/* * HTTP/1.1 server on a znet_loop. Requests are parsed incrementally in a per-connection
+ * buffer and handed to the handler as views into it, without copies; request bodies need a
+ * Content-Length of at most ZNET_HTTP_MAX_BODY. Connections stay open for the next request
+ * unless either side asks to close, and idle ones are dropped after ZNET_HTTP_IDLE_MS.
+ * A response head and body leave in one writev; file bodies use sendfile where available.
+*/
+typedef struct znet_http_server znet_http_server;
+typedef struct znet_http_conn   znet_http_conn;
+
+typedef struct 
+{
+    zstr_view method;
+    zstr_view target;           // As sent: path and query.
+    zstr_view path;
+    zstr_view query;            // After the '?'; empty if none.
+    int version;                // 10 or 11.
+    znet_http_header headers[ZNET_HTTP_MAX_HEADERS];
+    size_t header_count;
+    int64_t content_length;     // -1 if absent.
+    bool keep_alive;
+    zstr_view body;
+} znet_http_incoming;
+
+// Runs per request, in order on each connection. Answer with one znet_http_respond* call, from
+// the handler or later on the loop thread; the views in req stay valid until that call.
+typedef void (*znet_http_handler)(znet_http_conn *conn, const znet_http_incoming *req, void *user);
+
+// Serves the listening socket, which the server takes over. NULL on failure (it stays open).
+znet_http_server *znet_http_server_create(znet_loop *loop, znet_socket listener, 
+                                          znet_http_handler fn, void *user);
+
+// Closes the listener and every connection, answered or not. Not from inside a handler.
+void znet_http_server_destroy(znet_http_server *srv);
+
+// headers: extra lines, each ending in "\r\n"; may be NULL. body is only read during the call.
+// Z_OK, or Z_ERR if the client is gone (conn is released either way).
+int znet_http_respond(znet_http_conn *conn, int status, const char *headers, 
+                      const void *body, size_t len);
+
+// Like znet_http_respond with len bytes of the file fd from offset as the body. fd may be
+// closed once this returns.
+int znet_http_respond_file(znet_http_conn *conn, int status, const char *headers, 
+                           int fd, int64_t offset, uint64_t len);
+
+znet_addr znet_http_conn_peer(const znet_http_conn *conn);
 #endif
 
 #ifdef __cplusplus
@@ -182,24 +409,65 @@ zstr znet_http_get(const char *domain, const char *path, int timeout_ms);
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#ifndef ZNET_MALLOC
+#   define ZNET_MALLOC(sz)      malloc(sz)
+#   define ZNET_REALLOC(p, sz)  realloc(p, sz)
+#   define ZNET_FREE(p)         free(p)
+#endif
+
+// Events collected per epoll_wait/kevent call.
+#ifndef ZNET_LOOP_EVENTS
+#   define ZNET_LOOP_EVENTS 256
+#endif
+
+// znet_io receive buffer size (scratch buffer, and each io_uring provided buffer).
+#ifndef ZNET_IO_BUFFER
+#   define ZNET_IO_BUFFER 16384
+#endif
+
+// io_uring submission queue depth and provided buffers per loop (powers of two).
+#ifndef ZNET_URING_ENTRIES
+#   define ZNET_URING_ENTRIES 256
+#endif
+#ifndef ZNET_URING_BUFFERS
+#   define ZNET_URING_BUFFERS 256
+#endif
+
+// Sends from this size up go out with IORING_OP_SEND_ZC; below it, copying is cheaper.
+#ifndef ZNET_ZC_THRESHOLD
+#   define ZNET_ZC_THRESHOLD 16384
+#endif
+
+// Datagrams per recvmmsg/sendmmsg call.
+#ifndef ZNET_BATCH_MAX
+#   define ZNET_BATCH_MAX 64
+#endif
 
 #if defined(_WIN32)
 #   pragma comment(lib, "ws2_32.lib")
 #   include <winsock2.h>
 #   include <ws2tcpip.h>
+#   include <io.h>
     
     typedef int socklen_t;
 #   define ZNET__CLOSE_FN      closesocket
 #   define ZNET__ERRNO         WSAGetLastError()
 #   define ZNET__WOULDBLOCK    WSAEWOULDBLOCK
+#   define ZNET__INTERRUPTED   WSAEINTR
 #   define ZNET__SOCKET        SOCKET
 #   define ZNET__INVALID       INVALID_SOCKET
 #   define ZNET__ERROR         SOCKET_ERROR
 #else
 #   include <sys/socket.h>
 #   include <sys/select.h>
+#   include <poll.h>
 #   include <netinet/in.h>
+#   include <netinet/tcp.h>
+#   include <sys/uio.h>
 #   include <arpa/inet.h>
 #   include <netdb.h>
 #   include <unistd.h>
@@ -209,11 +477,44 @@ zstr znet_http_get(const char *domain, const char *path, int timeout_ms);
 #   define ZNET__CLOSE_FN      close
 #   define ZNET__ERRNO         errno
 #   define ZNET__WOULDBLOCK    EWOULDBLOCK
+#   define ZNET__INTERRUPTED   EINTR
 #   define ZNET__SOCKET        int
 #   define ZNET__INVALID       -1
 #   define ZNET__ERROR         -1
 #endif
 
+#if defined(MSG_NOSIGNAL)
+#   define ZNET__NOSIGNAL MSG_NOSIGNAL
+#else
+#   define ZNET__NOSIGNAL 0
+#endif
+
+#if defined(__linux__)
+#   include <sys/epoll.h>
+#   include <sys/sendfile.h>
+#   define ZNET__SENDFILE 1
+#   include <sys/syscall.h>
+#   define ZNET__EPOLL 1
+#   if defined(ZNET_USE_URING)
+#       include <linux/io_uring.h>
+#       include <sys/mman.h>
+        // IORING_CQE_F_NOTIF arrived with SEND_ZC and multishot recv (6.0); older headers skip it.
+#       ifdef IORING_CQE_F_NOTIF
+#           define ZNET__URING 1
+#       endif
+#   endif
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || \
+      defined(__NetBSD__) || defined(__DragonFly__)
+#   include <sys/event.h>
+#   define ZNET__KQUEUE 1
+#elif defined(_WIN32)
+    typedef WSAPOLLFD ZNET__POLLFD;
+#   define ZNET__POLL(p, n, ms) WSAPoll((p), (ULONG)(n), (ms))
+#else
+    typedef struct pollfd ZNET__POLLFD;
+#   define ZNET__POLL(p, n, ms) poll((p), (nfds_t)(n), (ms))
+#endif
+
 // Internal macros for result codes.
 #ifndef Z_OK
 #define Z_OK 0
@@ -465,6 +766,7 @@ int znet_poll(znet_socket s, znet_poll_flags wait_for, int timeout_ms)
     {
         return -1;
     }
+#   ifdef _WIN32
     fd_set read_fds, write_fds, err_fds;
     FD_ZERO(&read_fds); FD_ZERO(&write_fds); FD_ZERO(&err_fds);
 
@@ -512,6 +814,36 @@ int znet_poll(znet_socket s, znet_poll_flags wait_for, int timeout_ms)
     }
     
     return ret_flags;
+#   else
+    // poll() has no FD_SETSIZE ceiling on the descriptor value.
+    struct pollfd p;
+    p.fd = (int)s.handle;
+    p.events = (short)(((wait_for & ZNET_POLL_READ) ? POLLIN : 0) | 
+                       ((wait_for & ZNET_POLL_WRITE) ? POLLOUT : 0));
+    p.revents = 0;
+    int res = poll(&p, 1, timeout_ms < 0 ? -1 : timeout_ms);
+    if (res <= 0) 
+    {
+        return res; // 0 = Timeout, -1 = Error
+    }
+
+    // Like select(), a failed or hung-up socket reads (and writes) as ready.
+    int broken = p.revents & (POLLERR | POLLHUP | POLLNVAL);
+    int ret_flags = 0;
+    if ((wait_for & ZNET_POLL_READ) && ((p.revents & POLLIN) || broken)) 
+    {
+        ret_flags |= ZNET_POLL_READ;
+    }
+    if ((wait_for & ZNET_POLL_WRITE) && ((p.revents & POLLOUT) || broken)) 
+    {
+        ret_flags |= ZNET_POLL_WRITE;
+    }
+    if ((wait_for & ZNET_POLL_ERR) && broken) 
+    {
+        ret_flags |= ZNET_POLL_ERR;
+    }
+    return ret_flags;
+#   endif
 }
 
 // Configuration logic.
@@ -552,51 +884,2943 @@ int znet_set_dual_stack(znet_socket s, bool enable)
     return setsockopt((ZNET__SOCKET)s.handle, IPPROTO_IPV6, IPV6_V6ONLY, (const char*)&opt, sizeof(opt));
 }
 
-// HTTP extensions.
+// Event loop logic.
 
-#ifdef ZNET_HAS_ZSTR
-zstr znet_http_get(const char *domain, const char *path, int timeout_ms) 
+struct znet_watch 
 {
-    zstr resp = zstr_init();
-    znet_addr addr;
-    if (Z_OK != znet_resolve(domain, 80, &addr)) 
+    znet_socket sock;
+    int events;
+    znet_io_fn fn;
+    void *user;
+    size_t slot;                // Poll-set index (poll backends).
+    bool dead;                  // Removed; freed once the current iteration is over.
+    znet_watch *next_dead;
+    znet_watch *prev;           // Live watches, on every backend, so destroy can free them.
+    znet_watch *next;
+};
+
+#define ZNET__TIMER_RUNNING ((size_t)-1)
+
+struct znet_timer 
+{
+    uint64_t due;
+    uint64_t repeat;
+    uint64_t seq;               // Orders equal deadlines first-come first-served.
+    znet_timer_fn fn;
+    void *user;
+    size_t heap;                // Index in the heap, or ZNET__TIMER_RUNNING inside its callback.
+    bool cancelled;
+};
+
+struct znet_loop 
+{
+#   if defined(ZNET__EPOLL)
+    int epfd;
+#   elif defined(ZNET__KQUEUE)
+    int kq;
+#   else
+    ZNET__POLLFD *pfds;
+    znet_watch **owners;
+    size_t npfds;
+    size_t cap_pfds;
+#   endif
+    size_t watches;
+    znet_watch *live;
+    znet_watch *dead;
+    znet_timer **heap;          // Min-heap on (due, seq).
+    size_t timers;
+    size_t cap_timers;
+    uint64_t seq;
+    uint64_t now;
+    bool stop;
+    size_t ios;                 // Open znet_io handles.
+    znet_io *dead_ios;
+    struct znet__send *done;    // Sends finished outside a callback, reported next iteration in order.
+    struct znet__send *done_tail;
+    char *scratch;              // Readiness-path receive buffer.
+#   if defined(ZNET__URING)
+    struct znet__uring *ring;
+#   endif
+};
+
+// znet_io hooks around each iteration's wait (defined with znet_io below).
+static void znet__io_begin(znet_loop *l, int *wait);
+static int znet__io_end(znet_loop *l);
+static void znet__io_shutdown(znet_loop *l);
+#if defined(ZNET__URING)
+static void znet__uring_start(znet_loop *l);
+#endif
+
+static uint64_t znet__clock_ms(void) 
+{
+#   if defined(ZNET_HAS_ZTIME)
+    return ztime_now_ms();
+#   elif defined(_WIN32)
+    return (uint64_t)GetTickCount64();
+#   else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+#   endif
+}
+
+// Timer heap.
+
+static bool znet__timer_before(const znet_timer *a, const znet_timer *b) 
+{
+    return a->due < b->due || (a->due == b->due && a->seq < b->seq);
+}
+
+static void znet__heap_place(znet_loop *l, size_t i, znet_timer *t) 
+{
+    l->heap[i] = t;
+    t->heap = i;
+}
+
+static void znet__heap_up(znet_loop *l, size_t i) 
+{
+    znet_timer *t = l->heap[i];
+    while (i > 0 && znet__timer_before(t, l->heap[(i - 1) / 2])) 
     {
-        return resp;
+        znet__heap_place(l, i, l->heap[(i - 1) / 2]);
+        i = (i - 1) / 2;
     }
-    
-    znet_socket s = znet_socket_create(addr.family, ZNET_TCP);
-    if (timeout_ms > 0) 
+    znet__heap_place(l, i, t);
+}
+
+static void znet__heap_down(znet_loop *l, size_t i) 
+{
+    znet_timer *t = l->heap[i];
+    for (;;) 
     {
-        znet_set_timeout(s, timeout_ms);
+        size_t c = 2 * i + 1;
+        if (c >= l->timers) 
+        {
+            break;
+        }
+        if (c + 1 < l->timers && znet__timer_before(l->heap[c + 1], l->heap[c])) 
+        {
+            c++;
+        }
+        if (!znet__timer_before(l->heap[c], t)) 
+        {
+            break;
+        }
+        znet__heap_place(l, i, l->heap[c]);
+        i = c;
     }
-    
-    if (Z_OK != znet_connect(s, addr)) 
+    znet__heap_place(l, i, t);
+}
+
+static int znet__heap_push(znet_loop *l, znet_timer *t) 
+{
+    if (l->timers == l->cap_timers) 
     {
-        znet_close(&s); 
-        return resp; 
+        size_t cap = l->cap_timers ? l->cap_timers * 2 : 16;
+        znet_timer **grown = (znet_timer**)ZNET_REALLOC(l->heap, cap * sizeof(*grown));
+        if (!grown) 
+        {
+            return Z_ERR;
+        }
+        l->heap = grown;
+        l->cap_timers = cap;
     }
-    
-    zstr req = zstr_init();
-    zstr_fmt(&req, 
-        "GET %s HTTP/1.0\r\n"
-        "Host: %s\r\n"
-        "User-Agent: znet/1.1\r\n"
-        "Connection: close\r\n\r\n", 
-        path, domain
-    );
-    
-    znet_send(s, zstr_cstr(&req), zstr_len(&req));
-    zstr_free(&req);
-    
-    char buf[4096]; 
-    z_ssize_t n;
-    while ((n = znet_recv(s, buf, sizeof(buf))) > 0) 
+    znet__heap_place(l, l->timers++, t);
+    znet__heap_up(l, l->timers - 1);
+    return Z_OK;
+}
+
+static void znet__heap_remove(znet_loop *l, size_t i) 
+{
+    znet_timer *last = l->heap[--l->timers];
+    if (i == l->timers) 
     {
-        zstr_cat_len(&resp, buf, n);
+        return;
     }
-    
-    znet_close(&s);
-    return resp;
+    znet__heap_place(l, i, last);
+    znet__heap_down(l, i);
+    znet__heap_up(l, last->heap);
+}
+
+// Backend registration.
+
+#if defined(ZNET__EPOLL)
+static int znet__backend_init(znet_loop *l) 
+{
+    l->epfd = epoll_create1(EPOLL_CLOEXEC);
+    return l->epfd >= 0 ? Z_OK : Z_ERR;
+}
+
+static void znet__backend_free(znet_loop *l) 
+{
+    close(l->epfd);
+}
+
+static int znet__backend_set(znet_loop *l, znet_watch *w, int events, bool add) 
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = ((events & ZNET_POLL_READ) ? EPOLLIN : 0u) | ((events & ZNET_POLL_WRITE) ? EPOLLOUT : 0u) | 
+                ((events & ZNET_POLL_EDGE) ? (uint32_t)EPOLLET : 0u);
+    ev.data.ptr = w;
+    int op = add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+    return 0 == epoll_ctl(l->epfd, op, (int)w->sock.handle, &ev) ? Z_OK : Z_ERR;
+}
+
+static void znet__backend_del(znet_loop *l, znet_watch *w) 
+{
+    struct epoll_event ev;
+    epoll_ctl(l->epfd, EPOLL_CTL_DEL, (int)w->sock.handle, &ev);
+}
+#elif defined(ZNET__KQUEUE)
+static int znet__backend_init(znet_loop *l) 
+{
+    l->kq = kqueue();
+    return l->kq >= 0 ? Z_OK : Z_ERR;
+}
+
+static void znet__backend_free(znet_loop *l) 
+{
+    close(l->kq);
+}
+
+// Both filters stay registered; unwatched ones are disabled.
+static int znet__backend_set(znet_loop *l, znet_watch *w, int events, bool add) 
+{
+    struct kevent ch[2];
+    unsigned short clear = (events & ZNET_POLL_EDGE) ? EV_CLEAR : 0;
+    (void)add;
+    EV_SET(&ch[0], (uintptr_t)w->sock.handle, EVFILT_READ, 
+           EV_ADD | clear | ((events & ZNET_POLL_READ) ? EV_ENABLE : EV_DISABLE), 0, 0, w);
+    EV_SET(&ch[1], (uintptr_t)w->sock.handle, EVFILT_WRITE, 
+           EV_ADD | clear | ((events & ZNET_POLL_WRITE) ? EV_ENABLE : EV_DISABLE), 0, 0, w);
+    return 0 == kevent(l->kq, ch, 2, NULL, 0, NULL) ? Z_OK : Z_ERR;
+}
+
+static void znet__backend_del(znet_loop *l, znet_watch *w) 
+{
+    struct kevent ch[2];
+    EV_SET(&ch[0], (uintptr_t)w->sock.handle, EVFILT_READ, EV_DELETE, 0, 0, NULL);
+    EV_SET(&ch[1], (uintptr_t)w->sock.handle, EVFILT_WRITE, EV_DELETE, 0, 0, NULL);
+    kevent(l->kq, ch, 2, NULL, 0, NULL);
+}
+#else
+// Poll set: dense arrays, swap-removed so the wait only walks live entries.
+static int znet__backend_init(znet_loop *l) 
+{
+    (void)l;
+    return Z_OK;
+}
+
+static void znet__backend_free(znet_loop *l) 
+{
+    ZNET_FREE(l->pfds);
+    ZNET_FREE(l->owners);
+}
+
+static int znet__backend_set(znet_loop *l, znet_watch *w, int events, bool add) 
+{
+    if (add) 
+    {
+        if (l->npfds == l->cap_pfds) 
+        {
+            size_t cap = l->cap_pfds ? l->cap_pfds * 2 : 64;
+            ZNET__POLLFD *pfds = (ZNET__POLLFD*)ZNET_REALLOC(l->pfds, cap * sizeof(*pfds));
+            if (!pfds) 
+            {
+                return Z_ERR;
+            }
+            l->pfds = pfds;
+            znet_watch **owners = (znet_watch**)ZNET_REALLOC(l->owners, cap * sizeof(*owners));
+            if (!owners) 
+            {
+                return Z_ERR;
+            }
+            l->owners = owners;
+            l->cap_pfds = cap;
+        }
+        w->slot = l->npfds++;
+        l->pfds[w->slot].fd = (ZNET__SOCKET)w->sock.handle;
+        l->owners[w->slot] = w;
+    }
+    l->pfds[w->slot].events = (short)(((events & ZNET_POLL_READ) ? POLLIN : 0) | 
+                                      ((events & ZNET_POLL_WRITE) ? POLLOUT : 0));
+    l->pfds[w->slot].revents = 0;
+    return Z_OK;
+}
+
+static void znet__backend_del(znet_loop *l, znet_watch *w) 
+{
+    size_t last = --l->npfds;
+    if (w->slot != last) 
+    {
+        l->pfds[w->slot] = l->pfds[last];
+        l->owners[w->slot] = l->owners[last];
+        l->owners[w->slot]->slot = w->slot;
+    }
+}
+#endif
+
+// Loop API.
+
+znet_loop *znet_loop_create(void) 
+{
+    znet_loop *l = (znet_loop*)ZNET_MALLOC(sizeof(znet_loop));
+    if (!l) 
+    {
+        return NULL;
+    }
+    memset(l, 0, sizeof(*l));
+    if (Z_OK != znet__backend_init(l)) 
+    {
+        ZNET_FREE(l);
+        return NULL;
+    }
+#   if defined(ZNET__URING)
+    znet__uring_start(l);
+#   endif
+    l->now = znet__clock_ms();
+    return l;
+}
+
+static void znet__reap(znet_loop *l) 
+{
+    while (l->dead) 
+    {
+        znet_watch *w = l->dead;
+        l->dead = w->next_dead;
+        ZNET_FREE(w);
+    }
+}
+
+void znet_loop_destroy(znet_loop *loop) 
+{
+    if (!loop) 
+    {
+        return;
+    }
+    znet__io_shutdown(loop);
+    znet__reap(loop);
+    while (loop->live) 
+    {
+        znet_watch *w = loop->live;
+        loop->live = w->next;
+        ZNET_FREE(w);
+    }
+    for (size_t i = 0; i < loop->timers; i++) 
+    {
+        ZNET_FREE(loop->heap[i]);
+    }
+    ZNET_FREE(loop->heap);
+    znet__backend_free(loop);
+    ZNET_FREE(loop);
+}
+
+znet_watch *znet_loop_add(znet_loop *loop, znet_socket s, int events, znet_io_fn fn, void *user) 
+{
+    if (!s.valid || !fn) 
+    {
+        return NULL;
+    }
+    znet_watch *w = (znet_watch*)ZNET_MALLOC(sizeof(znet_watch));
+    if (!w) 
+    {
+        return NULL;
+    }
+    memset(w, 0, sizeof(*w));
+    w->sock = s;
+    w->events = events;
+    w->fn = fn;
+    w->user = user;
+    if (Z_OK != znet__backend_set(loop, w, events, true)) 
+    {
+        ZNET_FREE(w);
+        return NULL;
+    }
+    w->next = loop->live;
+    if (loop->live) 
+    {
+        loop->live->prev = w;
+    }
+    loop->live = w;
+    loop->watches++;
+    return w;
+}
+
+int znet_loop_modify(znet_loop *loop, znet_watch *w, int events) 
+{
+    if (!w || w->dead) 
+    {
+        return Z_ERR;
+    }
+    if (Z_OK != znet__backend_set(loop, w, events, false)) 
+    {
+        return Z_ERR;
+    }
+    w->events = events;
+    return Z_OK;
+}
+
+void znet_loop_remove(znet_loop *loop, znet_watch *w) 
+{
+    if (!w || w->dead) 
+    {
+        return;
+    }
+    znet__backend_del(loop, w);
+    if (w->prev) 
+    {
+        w->prev->next = w->next;
+    }
+    else 
+    {
+        loop->live = w->next;
+    }
+    if (w->next) 
+    {
+        w->next->prev = w->prev;
+    }
+    w->dead = true;
+    w->next_dead = loop->dead;
+    loop->dead = w;
+    loop->watches--;
+}
+
+znet_socket znet_watch_socket(const znet_watch *w) 
+{
+    return w->sock;
+}
+
+znet_timer *znet_loop_timer(znet_loop *loop, uint64_t delay_ms, uint64_t repeat_ms, 
+                            znet_timer_fn fn, void *user) 
+{
+    znet_timer *t = (znet_timer*)ZNET_MALLOC(sizeof(znet_timer));
+    if (!t) 
+    {
+        return NULL;
+    }
+    t->due = loop->now + delay_ms;
+    t->repeat = repeat_ms;
+    t->seq = loop->seq++;
+    t->fn = fn;
+    t->user = user;
+    t->cancelled = false;
+    if (Z_OK != znet__heap_push(loop, t)) 
+    {
+        ZNET_FREE(t);
+        return NULL;
+    }
+    return t;
+}
+
+void znet_loop_cancel(znet_loop *loop, znet_timer *t) 
+{
+    if (!t) 
+    {
+        return;
+    }
+    if (ZNET__TIMER_RUNNING == t->heap) 
+    {
+        t->cancelled = true;    // Freed when its callback returns.
+        return;
+    }
+    znet__heap_remove(loop, t->heap);
+    ZNET_FREE(t);
+}
+
+static int znet__run_timers(znet_loop *l) 
+{
+    // Timers armed by these callbacks wait for the next iteration, even with a zero delay.
+    uint64_t horizon = l->seq;
+    int ran = 0;
+    while (l->timers > 0 && l->heap[0]->due <= l->now && l->heap[0]->seq < horizon) 
+    {
+        znet_timer *t = l->heap[0];
+        znet__heap_remove(l, 0);
+        t->heap = ZNET__TIMER_RUNNING;
+        t->fn(l, t, t->user);
+        ran++;
+        if (t->repeat && !t->cancelled) 
+        {
+            // Missed periods are skipped rather than replayed back to back.
+            t->due = (t->due + t->repeat > l->now) ? t->due + t->repeat : l->now + t->repeat;
+            t->seq = l->seq++;
+            if (Z_OK == znet__heap_push(l, t)) 
+            {
+                continue;
+            }
+        }
+        ZNET_FREE(t);
+    }
+    return ran;
+}
+
+static int znet__wait_ms(const znet_loop *l, int timeout_ms) 
+{
+    if (0 == l->timers) 
+    {
+        return timeout_ms;
+    }
+    uint64_t due = l->heap[0]->due;
+    uint64_t left = due > l->now ? due - l->now : 0;
+    if (timeout_ms >= 0 && (uint64_t)timeout_ms < left) 
+    {
+        return timeout_ms;
+    }
+    return left > 0x7fffffff ? 0x7fffffff : (int)left;
+}
+
+static int znet__ready(const znet_watch *w, int read, int write, int broken) 
+{
+    int ev = (read ? ZNET_POLL_READ : 0) | (write ? ZNET_POLL_WRITE : 0);
+    if (broken) 
+    {
+        ev |= ZNET_POLL_ERR | (w->events & ZNET_POLL_READ);
+    }
+    return ev;
+}
+
+int znet_loop_poll(znet_loop *loop, int timeout_ms) 
+{
+    int wait = znet__wait_ms(loop, timeout_ms);
+    int ran = 0;
+    znet__io_begin(loop, &wait);
+#   if defined(ZNET__EPOLL)
+    struct epoll_event evs[ZNET_LOOP_EVENTS];
+    int n = epoll_wait(loop->epfd, evs, ZNET_LOOP_EVENTS, wait);
+    if (n < 0 && EINTR != errno) 
+    {
+        return -1;
+    }
+    loop->now = znet__clock_ms();
+    for (int i = 0; i < n; i++) 
+    {
+        znet_watch *w = (znet_watch*)evs[i].data.ptr;
+        if (!w || w->dead)      // NULL: the io_uring completion queue.
+        {
+            continue;
+        }
+        uint32_t e = evs[i].events;
+        w->fn(loop, w, znet__ready(w, e & EPOLLIN, e & EPOLLOUT, e & (EPOLLERR | EPOLLHUP)), w->user);
+        ran++;
+    }
+#   elif defined(ZNET__KQUEUE)
+    struct kevent evs[ZNET_LOOP_EVENTS];
+    struct timespec ts = { wait / 1000, (long)(wait % 1000) * 1000000L };
+    int n = kevent(loop->kq, NULL, 0, evs, ZNET_LOOP_EVENTS, wait < 0 ? NULL : &ts);
+    if (n < 0 && EINTR != errno) 
+    {
+        return -1;
+    }
+    loop->now = znet__clock_ms();
+    for (int i = 0; i < n; i++) 
+    {
+        znet_watch *w = (znet_watch*)evs[i].udata;
+        if (!w || w->dead) 
+        {
+            continue;
+        }
+        int broken = (evs[i].flags & EV_ERROR) || ((evs[i].flags & EV_EOF) && 0 != evs[i].fflags);
+        w->fn(loop, w, znet__ready(w, EVFILT_READ == evs[i].filter, EVFILT_WRITE == evs[i].filter, broken), 
+              w->user);
+        ran++;
+    }
+#   else
+    int n;
+    if (0 == loop->npfds) 
+    {
+#       ifdef _WIN32
+        Sleep(wait < 0 ? INFINITE : (DWORD)wait);
+#       else
+        poll(NULL, 0, wait);
+#       endif
+        n = 0;
+    }
+    else 
+    {
+        n = ZNET__POLL(loop->pfds, loop->npfds, wait);
+    }
+#   ifdef _WIN32
+    if (n < 0) 
+#   else
+    if (n < 0 && EINTR != errno) 
+#   endif
+    {
+        return -1;
+    }
+    loop->now = znet__clock_ms();
+    // Snapshot the count: watches added by callbacks wait for the next iteration.
+    size_t count = n > 0 ? loop->npfds : 0;
+    for (size_t i = 0; i < count && i < loop->npfds; i++) 
+    {
+        short re = loop->pfds[i].revents;
+        znet_watch *w = loop->owners[i];
+        if (0 == re) 
+        {
+            continue;
+        }
+        loop->pfds[i].revents = 0;
+        w->fn(loop, w, znet__ready(w, re & POLLIN, re & POLLOUT, re & (POLLERR | POLLHUP | POLLNVAL)), 
+              w->user);
+        ran++;
+    }
+#   endif
+    ran += znet__run_timers(loop);
+    ran += znet__io_end(loop);
+    znet__reap(loop);
+    return ran;
+}
+
+int znet_loop_run(znet_loop *loop) 
+{
+    loop->stop = false;
+    while (!loop->stop && (loop->watches > 0 || loop->timers > 0 || loop->ios > 0)) 
+    {
+        if (znet_loop_poll(loop, -1) < 0) 
+        {
+            return Z_ERR;
+        }
+    }
+    return Z_OK;
+}
+
+void znet_loop_stop(znet_loop *loop) 
+{
+    loop->stop = true;
+}
+
+uint64_t znet_loop_now(const znet_loop *loop) 
+{
+    return loop->now;
+}
+
+// Completion I/O logic.
+
+typedef struct znet__send 
+{
+    znet_io *io;
+    const char *data;
+    size_t len;
+    size_t off;
+    znet_send_fn fn;
+    void *user;
+    struct znet__send *next;
+} znet__send;
+
+struct znet_io 
+{
+    znet_loop *loop;
+    znet_socket sock;
+    znet_watch *watch;          // Readiness path only.
+    int events;                 // Interest currently set on watch.
+    znet_accept_fn on_accept;
+    void *accept_user;
+    znet_recv_fn on_recv;
+    void *recv_user;
+    znet__send *sends;          // Queue; the head is the one in progress.
+    znet__send *sends_tail;
+    int inflight;               // io_uring requests not completed yet.
+    int deferred;               // Its sends on loop->done, not reported yet.
+    bool accepting;             // An io_uring accept/recv/send is armed.
+    bool receiving;
+    bool sending;
+    bool closed;
+    z_ssize_t zc_result;        // SEND_ZC result held until its notification.
+    znet_io *next_dead;
+};
+
+static void znet__send_finish(znet_io *io, z_ssize_t result) 
+{
+    znet__send *q = io->sends;
+    io->sends = q->next;
+    if (!io->sends) 
+    {
+        io->sends_tail = NULL;
+    }
+    if (q->fn) 
+    {
+        q->fn(io, result, q->user);
+    }
+    ZNET_FREE(q);
+}
+
+#if defined(ZNET__URING)
+// Request tags live in the low bits of user_data (znet_io is at least 8-byte aligned).
+#define ZNET__OP_ACCEPT 1u
+#define ZNET__OP_RECV   2u
+#define ZNET__OP_SEND   3u
+#define ZNET__OP_CANCEL 4u
+
+typedef struct znet__uring 
+{
+    int fd;
+    unsigned *sq_head, *sq_tail, *sq_mask;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    unsigned sq_entries;
+    unsigned sq_local;          // Tail including SQEs not yet published.
+    unsigned pending;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_map, *cq_map;
+    size_t sq_size, cq_size, sqes_size;
+    struct io_uring_buf_ring *br;   // Provided buffers, group 0.
+    size_t br_size;
+    char *pool;
+    unsigned short br_tail;
+} znet__uring;
+
+static void znet__uring_free(znet__uring *r) 
+{
+    if (r->pool) 
+    {
+        munmap(r->pool, (size_t)ZNET_URING_BUFFERS * ZNET_IO_BUFFER);
+    }
+    if (r->br) 
+    {
+        munmap(r->br, r->br_size);
+    }
+    if (r->sqes) 
+    {
+        munmap(r->sqes, r->sqes_size);
+    }
+    if (r->cq_map && r->cq_map != r->sq_map) 
+    {
+        munmap(r->cq_map, r->cq_size);
+    }
+    if (r->sq_map) 
+    {
+        munmap(r->sq_map, r->sq_size);
+    }
+    if (r->fd >= 0) 
+    {
+        close(r->fd);
+    }
+    ZNET_FREE(r);
+}
+
+static void znet__uring_give(znet__uring *r, unsigned short bid) 
+{
+    struct io_uring_buf *b = &r->br->bufs[r->br_tail & (ZNET_URING_BUFFERS - 1)];
+    b->addr = (uint64_t)(uintptr_t)(r->pool + (size_t)bid * ZNET_IO_BUFFER);
+    b->len = ZNET_IO_BUFFER;
+    b->bid = bid;
+    r->br_tail++;
+    __atomic_store_n(&r->br->tail, r->br_tail, __ATOMIC_RELEASE);
+}
+
+// NULL unless the kernel has everything znet_io relies on; the loop then stays on readiness.
+static znet__uring *znet__uring_create(void) 
+{
+    znet__uring *r = (znet__uring*)ZNET_MALLOC(sizeof(znet__uring));
+    if (!r) 
+    {
+        return NULL;
+    }
+    memset(r, 0, sizeof(*r));
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_CQSIZE;
+    p.cq_entries = 4 * ZNET_URING_ENTRIES;      // Multishot requests post many completions.
+    r->fd = (int)syscall(SYS_io_uring_setup, ZNET_URING_ENTRIES, &p);
+    if (r->fd < 0) 
+    {
+        ZNET_FREE(r);
+        return NULL;
+    }
+    r->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) 
+    {
+        r->sq_size = r->cq_size = (r->sq_size > r->cq_size) ? r->sq_size : r->cq_size;
+    }
+    r->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sq_map = mmap(NULL, r->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED, r->fd, IORING_OFF_SQ_RING);
+    if (MAP_FAILED == r->sq_map) 
+    {
+        r->sq_map = NULL;
+        znet__uring_free(r);
+        return NULL;
+    }
+    r->cq_map = (p.features & IORING_FEAT_SINGLE_MMAP) ? r->sq_map 
+              : mmap(NULL, r->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED, r->fd, IORING_OFF_CQ_RING);
+    void *sqes = mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED, r->fd, IORING_OFF_SQES);
+    if (MAP_FAILED == r->cq_map || MAP_FAILED == sqes) 
+    {
+        r->cq_map = (MAP_FAILED == r->cq_map) ? NULL : r->cq_map;
+        r->sqes = (MAP_FAILED == sqes) ? NULL : (struct io_uring_sqe*)sqes;
+        znet__uring_free(r);
+        return NULL;
+    }
+    r->sqes = (struct io_uring_sqe*)sqes;
+    char *sq = (char*)r->sq_map, *cq = (char*)r->cq_map;
+    r->sq_head = (unsigned*)(sq + p.sq_off.head);
+    r->sq_tail = (unsigned*)(sq + p.sq_off.tail);
+    r->sq_mask = (unsigned*)(sq + p.sq_off.ring_mask);
+    r->sq_entries = p.sq_entries;
+    r->sq_local = *r->sq_tail;
+    unsigned *array = (unsigned*)(sq + p.sq_off.array);
+    for (unsigned i = 0; i < p.sq_entries; i++) 
+    {
+        array[i] = i;
+    }
+    r->cq_head = (unsigned*)(cq + p.cq_off.head);
+    r->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+    r->cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+
+    // SEND_ZC support implies multishot recv (both 6.0).
+    size_t probe_size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = (struct io_uring_probe*)ZNET_MALLOC(probe_size);
+    bool zc = false;
+    if (probe) 
+    {
+        memset(probe, 0, probe_size);
+        if (0 == syscall(SYS_io_uring_register, r->fd, IORING_REGISTER_PROBE, probe, 256)) 
+        {
+            zc = probe->last_op >= IORING_OP_SEND_ZC && 
+                 (probe->ops[IORING_OP_SEND_ZC].flags & IO_URING_OP_SUPPORTED);
+        }
+        ZNET_FREE(probe);
+    }
+    r->br_size = ZNET_URING_BUFFERS * sizeof(struct io_uring_buf);
+    void *br = mmap(NULL, r->br_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    void *pool = mmap(NULL, (size_t)ZNET_URING_BUFFERS * ZNET_IO_BUFFER, PROT_READ | PROT_WRITE, 
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    r->br = (MAP_FAILED == br) ? NULL : (struct io_uring_buf_ring*)br;
+    r->pool = (MAP_FAILED == pool) ? NULL : (char*)pool;
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)r->br;
+    reg.ring_entries = ZNET_URING_BUFFERS;
+    reg.bgid = 0;
+    if (!zc || !r->br || !r->pool || 
+        0 != syscall(SYS_io_uring_register, r->fd, IORING_REGISTER_PBUF_RING, &reg, 1)) 
+    {
+        znet__uring_free(r);
+        return NULL;
+    }
+    for (unsigned i = 0; i < ZNET_URING_BUFFERS; i++) 
+    {
+        znet__uring_give(r, (unsigned short)i);
+    }
+    return r;
+}
+
+// The completion queue wakes epoll_wait; a NULL watch marks it.
+static void znet__uring_start(znet_loop *l) 
+{
+    l->ring = znet__uring_create();
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    if (l->ring && 0 != epoll_ctl(l->epfd, EPOLL_CTL_ADD, l->ring->fd, &ev)) 
+    {
+        znet__uring_free(l->ring);
+        l->ring = NULL;
+    }
+}
+
+// One io_uring_enter for every SQE queued since the last call.
+static void znet__uring_submit(znet__uring *r) 
+{
+    if (0 == r->pending) 
+    {
+        return;
+    }
+    __atomic_store_n(r->sq_tail, r->sq_local, __ATOMIC_RELEASE);
+    long n = syscall(SYS_io_uring_enter, r->fd, r->pending, 0, 0, NULL, 0);
+    if (n > 0) 
+    {
+        r->pending -= (unsigned)n;
+    }
+}
+
+static struct io_uring_sqe *znet__uring_sqe(znet__uring *r) 
+{
+    if (r->sq_local - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE) >= r->sq_entries) 
+    {
+        znet__uring_submit(r);
+        if (r->sq_local - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE) >= r->sq_entries) 
+        {
+            return NULL;
+        }
+    }
+    struct io_uring_sqe *sqe = &r->sqes[r->sq_local & *r->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    r->sq_local++;
+    r->pending++;
+    return sqe;
+}
+
+static int znet__uring_arm(znet_io *io, unsigned op) 
+{
+    znet__uring *r = io->loop->ring;
+    struct io_uring_sqe *sqe = znet__uring_sqe(r);
+    if (!sqe) 
+    {
+        return Z_ERR;
+    }
+    sqe->fd = (int)io->sock.handle;
+    sqe->user_data = (uint64_t)(uintptr_t)io | op;
+    if (ZNET__OP_ACCEPT == op) 
+    {
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        io->accepting = true;
+    }
+    else if (ZNET__OP_RECV == op) 
+    {
+        sqe->opcode = IORING_OP_RECV;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = 0;
+        io->receiving = true;
+    }
+    else if (ZNET__OP_SEND == op) 
+    {
+        znet__send *q = io->sends;
+        sqe->opcode = (q->len - q->off >= ZNET_ZC_THRESHOLD) ? IORING_OP_SEND_ZC : IORING_OP_SEND;
+        sqe->addr = (uint64_t)(uintptr_t)(q->data + q->off);
+        sqe->len = (unsigned)(q->len - q->off);
+        sqe->msg_flags = ZNET__NOSIGNAL;
+        io->sending = true;
+    }
+    else 
+    {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+    }
+    io->inflight++;
+    return Z_OK;
+}
+
+static void znet__uring_send_done(znet_io *io, z_ssize_t res) 
+{
+    io->sending = false;
+    znet__send *q = io->sends;
+    if (io->closed) 
+    {
+        return;
+    }
+    if (res > 0) 
+    {
+        q->off += (size_t)res;
+    }
+    if (res > 0 && q->off < q->len) 
+    {
+        znet__uring_arm(io, ZNET__OP_SEND);        // Short write: send the rest.
+        return;
+    }
+    znet__send_finish(io, res < 0 ? -1 : (z_ssize_t)q->len);
+    if (!io->closed && io->sends && !io->sending) 
+    {
+        znet__uring_arm(io, ZNET__OP_SEND);
+    }
+}
+
+static void znet__uring_complete(znet_loop *l, uint64_t data, int32_t res, uint32_t flags) 
+{
+    znet__uring *r = l->ring;
+    znet_io *io = (znet_io*)(uintptr_t)(data & ~(uint64_t)7);
+    unsigned op = (unsigned)(data & 7);
+    bool more = 0 != (flags & IORING_CQE_F_MORE);
+    if (ZNET__OP_SEND != op && !more) 
+    {
+        io->inflight--;
+    }
+    switch (op) 
+    {
+        case ZNET__OP_ACCEPT:
+            io->accepting = more;
+            if (io->closed || !io->on_accept) 
+            {
+                if (res >= 0) 
+                {
+                    close(res);
+                }
+                break;
+            }
+            if (res >= 0) 
+            {
+                io->on_accept(io, (znet_socket){ (uintptr_t)res, true }, io->accept_user);
+            }
+            else if (-ECANCELED != res) 
+            {
+                errno = -res;
+                io->on_accept(io, ZNET_INVALID_SOCKET, io->accept_user);
+            }
+            if (!io->closed && io->on_accept && !io->accepting) 
+            {
+                znet__uring_arm(io, ZNET__OP_ACCEPT);
+            }
+            break;
+
+        case ZNET__OP_RECV:
+            io->receiving = more;
+            if (res > 0 && (flags & IORING_CQE_F_BUFFER)) 
+            {
+                unsigned short bid = (unsigned short)(flags >> IORING_CQE_BUFFER_SHIFT);
+                if (!io->closed && io->on_recv) 
+                {
+                    io->on_recv(io, r->pool + (size_t)bid * ZNET_IO_BUFFER, res, io->recv_user);
+                }
+                znet__uring_give(r, bid);
+            }
+            else if (-ENOBUFS != res && -ECANCELED != res && !io->closed && io->on_recv) 
+            {
+                // End of stream or error: recv stops.
+                znet_recv_fn fn = io->on_recv;
+                io->on_recv = NULL;
+                errno = (res < 0) ? -res : 0;
+                fn(io, NULL, res < 0 ? -1 : 0, io->recv_user);
+            }
+            // Out of buffers ends a multishot recv; the ring was just refilled, so re-arm.
+            if (!io->closed && io->on_recv && !io->receiving) 
+            {
+                znet__uring_arm(io, ZNET__OP_RECV);
+            }
+            break;
+
+        case ZNET__OP_SEND:
+            if (flags & IORING_CQE_F_NOTIF) 
+            {
+                // The kernel is done with the zero-copy pages.
+                io->inflight--;
+                znet__uring_send_done(io, io->zc_result);
+            }
+            else if (more) 
+            {
+                io->zc_result = res;
+            }
+            else 
+            {
+                io->inflight--;
+                znet__uring_send_done(io, res);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+static int znet__uring_reap(znet_loop *l) 
+{
+    znet__uring *r = l->ring;
+    int ran = 0;
+    unsigned head = *r->cq_head;
+    while (head != __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE)) 
+    {
+        struct io_uring_cqe *cqe = &r->cqes[head & *r->cq_mask];
+        uint64_t data = cqe->user_data;
+        int32_t res = cqe->res;
+        uint32_t flags = cqe->flags;
+        __atomic_store_n(r->cq_head, ++head, __ATOMIC_RELEASE);
+        znet__uring_complete(l, data, res, flags);
+        ran++;
+    }
+    return ran;
+}
+#endif
+
+// Readiness path.
+
+static void znet__io_interest(znet_io *io) 
+{
+    int events = ((io->on_accept || io->on_recv) ? ZNET_POLL_READ : 0) | (io->sends ? ZNET_POLL_WRITE : 0);
+    if (events != io->events && Z_OK == znet_loop_modify(io->loop, io->watch, events)) 
+    {
+        io->events = events;
+    }
+}
+
+// Writes queued data until the socket would block.
+static void znet__io_flush(znet_io *io, bool report_now) 
+{
+    while (io->sends && !io->closed) 
+    {
+        znet__send *q = io->sends;
+        z_ssize_t n = send((ZNET__SOCKET)io->sock.handle, q->data + q->off, (int)(q->len - q->off), 
+                           ZNET__NOSIGNAL);
+        if (n < 0 && ZNET__WOULDBLOCK == ZNET__ERRNO) 
+        {
+            return;
+        }
+        if (n > 0) 
+        {
+            q->off += (size_t)n;
+            if (q->off < q->len) 
+            {
+                continue;
+            }
+        }
+        if (report_now && 0 == io->deferred) 
+        {
+            znet__send_finish(io, n < 0 ? -1 : (z_ssize_t)q->len);
+            continue;
+        }
+        // Called from znet_io_send, or behind sends that were: report from the loop, in order.
+        io->sends = q->next;
+        if (!io->sends) 
+        {
+            io->sends_tail = NULL;
+        }
+        q->off = (n < 0) ? (size_t)-1 : q->len;
+        q->next = NULL;
+        if (io->loop->done_tail) 
+        {
+            io->loop->done_tail->next = q;
+        }
+        else 
+        {
+            io->loop->done = q;
+        }
+        io->loop->done_tail = q;
+        io->deferred++;
+    }
+}
+
+static void znet__io_ready(znet_loop *loop, znet_watch *w, int events, void *user) 
+{
+    znet_io *io = (znet_io*)user;
+    (void)w;
+    if ((events & (ZNET_POLL_READ | ZNET_POLL_ERR)) && io->on_accept) 
+    {
+        for (int i = 0; i < 64 && !io->closed && io->on_accept; i++) 
+        {
+            znet_socket c = znet_accept(io->sock, NULL);
+            if (!c.valid && ZNET__WOULDBLOCK == ZNET__ERRNO) 
+            {
+                break;
+            }
+            io->on_accept(io, c, io->accept_user);
+        }
+    }
+    if ((events & (ZNET_POLL_READ | ZNET_POLL_ERR)) && io->on_recv && !io->closed) 
+    {
+        if (!loop->scratch && !(loop->scratch = (char*)ZNET_MALLOC(ZNET_IO_BUFFER))) 
+        {
+            return;
+        }
+        for (int i = 0; i < 16 && !io->closed && io->on_recv; i++) 
+        {
+            z_ssize_t n = znet_recv(io->sock, loop->scratch, ZNET_IO_BUFFER);
+            if (n < 0 && ZNET__WOULDBLOCK == ZNET__ERRNO) 
+            {
+                break;
+            }
+            if (n > 0) 
+            {
+                io->on_recv(io, loop->scratch, n, io->recv_user);
+                continue;
+            }
+            znet_recv_fn fn = io->on_recv;
+            io->on_recv = NULL;
+            fn(io, NULL, n < 0 ? -1 : 0, io->recv_user);
+        }
+    }
+    if ((events & (ZNET_POLL_WRITE | ZNET_POLL_ERR)) && !io->closed) 
+    {
+        znet__io_flush(io, true);
+    }
+    if (!io->closed) 
+    {
+        znet__io_interest(io);
+    }
+}
+
+// Loop hooks.
+
+static void znet__io_begin(znet_loop *l, int *wait) 
+{
+#   if defined(ZNET__URING)
+    if (l->ring) 
+    {
+        znet__uring_submit(l->ring);
+        if (*l->ring->cq_head != __atomic_load_n(l->ring->cq_tail, __ATOMIC_ACQUIRE)) 
+        {
+            *wait = 0;
+        }
+    }
+#   endif
+    if (l->done) 
+    {
+        *wait = 0;
+    }
+}
+
+static int znet__io_end(znet_loop *l) 
+{
+    int ran = 0;
+#   if defined(ZNET__URING)
+    if (l->ring) 
+    {
+        ran += znet__uring_reap(l);
+    }
+#   endif
+    while (l->done) 
+    {
+        znet__send *q = l->done;
+        l->done = q->next;
+        if (!l->done) 
+        {
+            l->done_tail = NULL;
+        }
+        q->io->deferred--;
+        if (q->fn) 
+        {
+            q->fn(q->io, (size_t)-1 == q->off ? -1 : (z_ssize_t)q->len, q->user);
+            ran++;
+        }
+        ZNET_FREE(q);
+    }
+    // Closed handles go once the kernel no longer holds requests on them.
+    znet_io **link = &l->dead_ios;
+    while (*link) 
+    {
+        znet_io *io = *link;
+        if (io->inflight > 0) 
+        {
+            link = &io->next_dead;
+            continue;
+        }
+        *link = io->next_dead;
+        while (io->sends) 
+        {
+            znet__send *q = io->sends;
+            io->sends = q->next;
+            ZNET_FREE(q);
+        }
+        ZNET_FREE(io);
+    }
+    return ran;
+}
+
+static void znet__io_shutdown(znet_loop *l) 
+{
+#   if defined(ZNET__URING)
+    if (l->ring) 
+    {
+        znet__uring_free(l->ring);      // Closing the ring cancels what is in flight.
+        l->ring = NULL;
+    }
+#   endif
+    while (l->done) 
+    {
+        znet__send *q = l->done;
+        l->done = q->next;
+        ZNET_FREE(q);
+    }
+    l->done_tail = NULL;
+    for (znet_io *io = l->dead_ios; io; io = io->next_dead) 
+    {
+        io->inflight = 0;
+    }
+    znet__io_end(l);
+    ZNET_FREE(l->scratch);
+}
+
+// znet_io API.
+
+znet_io *znet_io_open(znet_loop *loop, znet_socket s) 
+{
+    if (!s.valid) 
+    {
+        return NULL;
+    }
+    znet_io *io = (znet_io*)ZNET_MALLOC(sizeof(znet_io));
+    if (!io) 
+    {
+        return NULL;
+    }
+    memset(io, 0, sizeof(*io));
+    io->loop = loop;
+    io->sock = s;
+    znet_set_nonblocking(s, true);
+#   if defined(ZNET__URING)
+    if (!loop->ring) 
+#   endif
+    {
+        io->watch = znet_loop_add(loop, s, 0, znet__io_ready, io);
+        if (!io->watch) 
+        {
+            ZNET_FREE(io);
+            return NULL;
+        }
+    }
+    loop->ios++;
+    return io;
+}
+
+void znet_io_close(znet_io *io) 
+{
+    if (!io || io->closed) 
+    {
+        return;
+    }
+    znet_loop *l = io->loop;
+    io->closed = true;
+    io->on_accept = NULL;
+    io->on_recv = NULL;
+    if (io->watch) 
+    {
+        znet_loop_remove(l, io->watch);
+    }
+#   if defined(ZNET__URING)
+    if (l->ring && io->inflight > 0 && Z_OK == znet__uring_arm(io, ZNET__OP_CANCEL)) 
+    {
+        znet__uring_submit(l->ring);    // Matches by fd, so it must go out before the close.
+    }
+#   endif
+    // Drop completions already queued for this handle.
+    znet__send **link = &l->done;
+    l->done_tail = NULL;
+    while (*link) 
+    {
+        if ((*link)->io == io) 
+        {
+            znet__send *q = *link;
+            *link = q->next;
+            ZNET_FREE(q);
+        }
+        else 
+        {
+            l->done_tail = *link;
+            link = &(*link)->next;
+        }
+    }
+    io->deferred = 0;
+    znet_close(&io->sock);
+    io->next_dead = l->dead_ios;
+    l->dead_ios = io;
+    l->ios--;
+}
+
+int znet_io_accept(znet_io *io, znet_accept_fn fn, void *user) 
+{
+    if (io->closed || !fn) 
+    {
+        return Z_ERR;
+    }
+    io->on_accept = fn;
+    io->accept_user = user;
+#   if defined(ZNET__URING)
+    if (io->loop->ring) 
+    {
+        return io->accepting ? Z_OK : znet__uring_arm(io, ZNET__OP_ACCEPT);
+    }
+#   endif
+    znet__io_interest(io);
+    return Z_OK;
+}
+
+int znet_io_recv(znet_io *io, znet_recv_fn fn, void *user) 
+{
+    if (io->closed || !fn) 
+    {
+        return Z_ERR;
+    }
+    io->on_recv = fn;
+    io->recv_user = user;
+#   if defined(ZNET__URING)
+    if (io->loop->ring) 
+    {
+        return io->receiving ? Z_OK : znet__uring_arm(io, ZNET__OP_RECV);
+    }
+#   endif
+    znet__io_interest(io);
+    return Z_OK;
+}
+
+int znet_io_send(znet_io *io, const void *data, size_t len, znet_send_fn fn, void *user) 
+{
+    if (io->closed) 
+    {
+        return Z_ERR;
+    }
+    znet__send *q = (znet__send*)ZNET_MALLOC(sizeof(znet__send));
+    if (!q) 
+    {
+        return Z_ERR;
+    }
+    q->io = io;
+    q->data = (const char*)data;
+    q->len = len;
+    q->off = 0;
+    q->fn = fn;
+    q->user = user;
+    q->next = NULL;
+    bool idle = (NULL == io->sends);
+    if (io->sends_tail) 
+    {
+        io->sends_tail->next = q;
+    }
+    else 
+    {
+        io->sends = q;
+    }
+    io->sends_tail = q;
+#   if defined(ZNET__URING)
+    if (io->loop->ring) 
+    {
+        return (idle && !io->sending) ? znet__uring_arm(io, ZNET__OP_SEND) : Z_OK;
+    }
+#   endif
+    // Nothing ahead of it: try right away and only wait for writability on a short write.
+    if (idle) 
+    {
+        znet__io_flush(io, false);
+    }
+    znet__io_interest(io);
+    return Z_OK;
+}
+
+znet_socket znet_io_socket(const znet_io *io) 
+{
+    return io->sock;
+}
+
+znet_loop *znet_io_loop(const znet_io *io) 
+{
+    return io->loop;
+}
+
+bool znet_loop_uses_uring(const znet_loop *loop) 
+{
+#   if defined(ZNET__URING)
+    return NULL != loop->ring;
+#   else
+    (void)loop;
+    return false;
+#   endif
+}
+
+// Batched datagram logic.
+
+int znet_recv_batch(znet_socket s, znet_msg *msgs, int count) 
+{
+#   if defined(SYS_recvmmsg)
+    // struct mmsghdr is _GNU_SOURCE-only; the kernel layout is stable.
+    struct { struct msghdr hdr; unsigned int len; } mm[ZNET_BATCH_MAX];
+    struct iovec iov[ZNET_BATCH_MAX];
+    struct sockaddr_storage from[ZNET_BATCH_MAX];
+    int n = count < ZNET_BATCH_MAX ? count : ZNET_BATCH_MAX;
+    memset(mm, 0, sizeof(mm[0]) * (size_t)(n > 0 ? n : 1));
+    for (int i = 0; i < n; i++) 
+    {
+        iov[i].iov_base = msgs[i].data;
+        iov[i].iov_len = msgs[i].len;
+        mm[i].hdr.msg_iov = &iov[i];
+        mm[i].hdr.msg_iovlen = 1;
+        mm[i].hdr.msg_name = &from[i];
+        mm[i].hdr.msg_namelen = sizeof(from[i]);
+    }
+    // MSG_WAITFORONE (0x10000): block for the first datagram only.
+    long got = syscall(SYS_recvmmsg, (int)s.handle, mm, (unsigned)n, 0x10000, NULL);
+    for (long i = 0; i < got; i++) 
+    {
+        msgs[i].len = mm[i].len;
+        msgs[i].addr = znet__from_sys(&from[i]);
+    }
+    return (int)got;
+#   else
+    if (count < 1) 
+    {
+        return 0;
+    }
+    z_ssize_t r = znet_recvfrom(s, msgs[0].data, msgs[0].len, &msgs[0].addr);
+    if (r < 0) 
+    {
+        return -1;
+    }
+    msgs[0].len = (size_t)r;
+    return 1;
+#   endif
+}
+
+int znet_send_batch(znet_socket s, const znet_msg *msgs, int count) 
+{
+#   if defined(SYS_sendmmsg)
+    struct { struct msghdr hdr; unsigned int len; } mm[ZNET_BATCH_MAX];
+    struct iovec iov[ZNET_BATCH_MAX];
+    struct sockaddr_storage to[ZNET_BATCH_MAX];
+    int sent = 0;
+    while (sent < count) 
+    {
+        int n = (count - sent) < ZNET_BATCH_MAX ? (count - sent) : ZNET_BATCH_MAX;
+        memset(mm, 0, sizeof(mm[0]) * (size_t)n);
+        for (int i = 0; i < n; i++) 
+        {
+            const znet_msg *m = &msgs[sent + i];
+            iov[i].iov_base = m->data;
+            iov[i].iov_len = m->len;
+            mm[i].hdr.msg_iov = &iov[i];
+            mm[i].hdr.msg_iovlen = 1;
+            if (ZNET_UNSPEC != m->addr.family) 
+            {
+                socklen_t len;
+                znet__to_sys(m->addr, &to[i], &len);
+                mm[i].hdr.msg_name = &to[i];
+                mm[i].hdr.msg_namelen = len;
+            }
+        }
+        long r = syscall(SYS_sendmmsg, (int)s.handle, mm, (unsigned)n, 0);
+        if (r <= 0) 
+        {
+            return sent > 0 ? sent : -1;
+        }
+        sent += (int)r;
+        if (r < n) 
+        {
+            break;
+        }
+    }
+    return sent;
+#   else
+    int sent = 0;
+    for (; sent < count; sent++) 
+    {
+        const znet_msg *m = &msgs[sent];
+        z_ssize_t r = (ZNET_UNSPEC == m->addr.family) ? znet_send(s, m->data, m->len) 
+                                                      : znet_sendto(s, m->data, m->len, m->addr);
+        if (r < 0) 
+        {
+            return sent > 0 ? sent : -1;
+        }
+    }
+    return sent;
+#   endif
+}
+
+// HTTP extensions.
+
+#ifdef ZNET_HAS_ZSTR
+zstr znet_http_get(const char *domain, const char *path, int timeout_ms) 
+{
+    zstr resp = zstr_init();
+    znet_addr addr;
+    if (Z_OK != znet_resolve(domain, 80, &addr)) 
+    {
+        return resp;
+    }
+    
+    znet_socket s = znet_socket_create(addr.family, ZNET_TCP);
+    if (timeout_ms > 0) 
+    {
+        znet_set_timeout(s, timeout_ms);
+    }
+    
+    if (Z_OK != znet_connect(s, addr)) 
+    {
+        znet_close(&s); 
+        return resp; 
+    }
+    
+    zstr req = zstr_init();
+    zstr_fmt(&req, 
+        "GET %s HTTP/1.0\r\n"
+        "Host: %s\r\n"
+        "User-Agent: znet/1.1\r\n"
+        "Connection: close\r\n\r\n", 
+        path, domain
+    );
+    
+    znet_send(s, zstr_cstr(&req), zstr_len(&req));
+    zstr_free(&req);
+    
+    char buf[4096]; 
+    z_ssize_t n;
+    while ((n = znet_recv(s, buf, sizeof(buf))) > 0) 
+    {
+        zstr_cat_len(&resp, buf, n);
+    }
+    
+    znet_close(&s);
+    return resp;
+}
+
+// HTTP/1.1 client logic.
+
+#ifndef ZNET_HTTP_BUFFER
+#   define ZNET_HTTP_BUFFER 16384      // Per connection; also the largest response head.
+#endif
+#ifndef ZNET_HTTP_POOL_MAX
+#   define ZNET_HTTP_POOL_MAX 8        // Idle connections kept per host.
+#endif
+
+typedef struct znet__http_conn 
+{
+    znet_socket sock;
+    size_t start;               // Unread bytes are buf[start, end).
+    size_t end;
+    struct znet__http_conn *next;
+    char buf[ZNET_HTTP_BUFFER];
+} znet__http_conn;
+
+typedef struct 
+{
+    char *host;
+    uint16_t port;
+    znet_addr addr;
+    bool resolved;
+    znet__http_conn *idle;
+    size_t idle_count;
+} znet__http_host;
+
+struct znet_http_client 
+{
+    int timeout_ms;
+    znet__http_host *hosts;
+    size_t host_count;
+    size_t host_cap;
+    zstr *heads;                // Per response slot: its copied head, and its collected body.
+    zstr *bodies;
+    size_t slots;
+};
+
+static bool znet__ieq(zstr_view v, const char *s) 
+{
+    size_t n = strlen(s);
+    if (v.len != n) 
+    {
+        return false;
+    }
+    for (size_t i = 0; i < n; i++) 
+    {
+        char a = v.data[i], b = s[i];
+        a = (a >= 'A' && a <= 'Z') ? (char)(a + 32) : a;
+        b = (b >= 'A' && b <= 'Z') ? (char)(b + 32) : b;
+        if (a != b) 
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Case-insensitive search for token in a comma-separated header value.
+static bool znet__has_token(zstr_view v, const char *token) 
+{
+    size_t i = 0;
+    while (i < v.len) 
+    {
+        size_t j = i;
+        while (j < v.len && ',' != v.data[j]) 
+        {
+            j++;
+        }
+        if (znet__ieq(zstr_view_trim(zstr_sub(v, i, j - i)), token)) 
+        {
+            return true;
+        }
+        i = j + 1;
+    }
+    return false;
+}
+
+static const char *znet__find_crlf(const char *p, const char *end) 
+{
+    for (; p + 1 < end; p++) 
+    {
+        if ('\r' == p[0] && '\n' == p[1]) 
+        {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+zstr_view znet_http_header_get(const znet_http_header *headers, size_t count, const char *name) 
+{
+    for (size_t i = 0; i < count; i++) 
+    {
+        if (znet__ieq(headers[i].name, name)) 
+        {
+            return headers[i].value;
+        }
+    }
+    return (zstr_view){ "", 0 };
+}
+
+// Header lines from p up to the blank line, plus the framing they carry; *encoded tells whether
+// any Transfer-Encoding came. *close comes in as the version's default. Repeated Content-Length
+// values must agree (RFC 9112 6.3). Returns the head length from buf, 0 if incomplete, -1 if
+// malformed.
+static z_ssize_t znet__http_fields(const char *buf, const char *p, const char *end, znet_http_header *headers, 
+                                   size_t *count, int64_t *content_length, bool *chunked, bool *encoded, 
+                                   bool *close) 
+{
+    *encoded = false;
+    for (;;) 
+    {
+        const char *eol = znet__find_crlf(p, end);
+        if (!eol) 
+        {
+            return 0;
+        }
+        if (eol == p) 
+        {
+            return (z_ssize_t)(eol + 2 - buf);
+        }
+        const char *colon = (const char*)memchr(p, ':', (size_t)(eol - p));
+        if (!colon || colon == p) 
+        {
+            return -1;
+        }
+        zstr_view name = { p, (size_t)(colon - p) };
+        zstr_view value = zstr_view_trim((zstr_view){ colon + 1, (size_t)(eol - colon - 1) });
+        if (znet__ieq(name, "content-length")) 
+        {
+            // A list ("5, 5") or a repeated field is fine as long as every value is the same.
+            for (size_t i = 0; i <= value.len; ) 
+            {
+                size_t j = i;
+                while (j < value.len && ',' != value.data[j]) 
+                {
+                    j++;
+                }
+                zstr_view item = zstr_view_trim(zstr_sub(value, i, j - i));
+                int64_t n = 0;
+                if (0 == item.len) 
+                {
+                    return -1;
+                }
+                for (size_t k = 0; k < item.len; k++) 
+                {
+                    if (item.data[k] < '0' || item.data[k] > '9' || n > (INT64_MAX - 9) / 10) 
+                    {
+                        return -1;
+                    }
+                    n = n * 10 + (item.data[k] - '0');
+                }
+                if (*content_length >= 0 && *content_length != n) 
+                {
+                    return -1;
+                }
+                *content_length = n;
+                i = j + 1;
+            }
+        }
+        else if (znet__ieq(name, "transfer-encoding")) 
+        {
+            *chunked = znet__has_token(value, "chunked");
+            *encoded = true;
+        }
+        else if (znet__ieq(name, "connection")) 
+        {
+            *close = znet__has_token(value, "close") || (*close && !znet__has_token(value, "keep-alive"));
+        }
+        if (*count < ZNET_HTTP_MAX_HEADERS) 
+        {
+            headers[*count].name = name;
+            headers[*count].value = value;
+            (*count)++;
+        }
+        p = eol + 2;
+    }
+}
+
+z_ssize_t znet_http_parse_response(const char *buf, size_t len, znet_http_response *out) 
+{
+    const char *p = buf, *end = buf + len;
+    const char *eol = znet__find_crlf(p, end);
+    if (!eol) 
+    {
+        return 0;
+    }
+    memset(out, 0, sizeof(*out));
+    out->content_length = -1;
+    // "HTTP/1.x SSS reason"
+    if (eol - p < 12 || 0 != memcmp(p, "HTTP/1.", 7) || ' ' != p[8] || 
+        p[9] < '0' || p[9] > '9' || p[10] < '0' || p[10] > '9' || p[11] < '0' || p[11] > '9') 
+    {
+        return -1;
+    }
+    out->version = ('1' == p[7]) ? 11 : 10;
+    out->status = (p[9] - '0') * 100 + (p[10] - '0') * 10 + (p[11] - '0');
+    out->reason = zstr_view_trim((zstr_view){ p + 12, (size_t)(eol - (p + 12)) });
+    bool close = (10 == out->version), encoded;
+    z_ssize_t n = znet__http_fields(buf, eol + 2, end, out->headers, &out->header_count, 
+                                    &out->content_length, &out->chunked, &encoded, &close);
+    out->keep_alive = !close;
+    return n;
+}
+
+// Reads more into the connection buffer. Returns bytes read, 0 at EOF, -1 on error or if full.
+static z_ssize_t znet__http_fill(znet__http_conn *c) 
+{
+    if (c->start > 0) 
+    {
+        memmove(c->buf, c->buf + c->start, c->end - c->start);
+        c->end -= c->start;
+        c->start = 0;
+    }
+    if (c->end == sizeof(c->buf)) 
+    {
+        return -1;
+    }
+    // With a socket timeout set, signals (and io_uring task work) fail the call instead of
+    // restarting it.
+    z_ssize_t n;
+    do 
+    {
+        n = znet_recv(c->sock, c->buf + c->end, sizeof(c->buf) - c->end);
+    } while (n < 0 && ZNET__INTERRUPTED == ZNET__ERRNO);
+    if (n > 0) 
+    {
+        c->end += (size_t)n;
+    }
+    return n < 0 ? -1 : n;
+}
+
+// One CRLF-terminated line from the buffer (consumed); NULL on EOF, error or an overlong line.
+static const char *znet__http_line(znet__http_conn *c, size_t *len) 
+{
+    for (;;) 
+    {
+        const char *eol = znet__find_crlf(c->buf + c->start, c->buf + c->end);
+        if (eol) 
+        {
+            const char *line = c->buf + c->start;
+            *len = (size_t)(eol - line);
+            c->start = (size_t)(eol + 2 - c->buf);
+            return line;
+        }
+        if (znet__http_fill(c) <= 0) 
+        {
+            return NULL;
+        }
+    }
+}
+
+typedef struct 
+{
+    const znet_http_request *req;
+    znet_http_response *res;
+    zstr *body;
+} znet__http_sink;
+
+static int znet__http_emit(znet__http_sink *k, const char *data, size_t len) 
+{
+    if (k->req->on_body) 
+    {
+        return k->req->on_body(k->res, data, len, k->req->user);
+    }
+    return Z_OK == zstr_cat_len(k->body, data, len) ? 0 : 1;
+}
+
+// Streams up to n body bytes (n < 0: until EOF). 0 on success.
+static int znet__http_stream(znet__http_conn *c, znet__http_sink *k, int64_t n) 
+{
+    while (n != 0) 
+    {
+        if (c->start == c->end) 
+        {
+            c->start = c->end = 0;
+            z_ssize_t got = znet__http_fill(c);
+            if (got <= 0) 
+            {
+                return (n < 0 && 0 == got) ? 0 : -1;
+            }
+        }
+        size_t avail = c->end - c->start;
+        size_t take = (n < 0 || (uint64_t)n > avail) ? avail : (size_t)n;
+        if (0 != znet__http_emit(k, c->buf + c->start, take)) 
+        {
+            return -1;
+        }
+        c->start += take;
+        n = (n < 0) ? n : n - (int64_t)take;
+    }
+    return 0;
+}
+
+static int znet__http_chunked(znet__http_conn *c, znet__http_sink *k) 
+{
+    for (;;) 
+    {
+        size_t len;
+        const char *line = znet__http_line(c, &len);
+        if (!line) 
+        {
+            return -1;
+        }
+        int64_t size = 0;
+        size_t i = 0;
+        for (; i < len; i++) 
+        {
+            char h = line[i];
+            int d = (h >= '0' && h <= '9') ? h - '0' : (h >= 'a' && h <= 'f') ? h - 'a' + 10 
+                  : (h >= 'A' && h <= 'F') ? h - 'A' + 10 : -1;
+            if (d < 0 || size > (INT64_MAX >> 4)) 
+            {
+                break;
+            }
+            size = size * 16 + d;
+        }
+        if (0 == i || (i < len && ';' != line[i] && ' ' != line[i] && '\t' != line[i])) 
+        {
+            return -1;
+        }
+        if (0 == size) 
+        {
+            // Trailers up to the blank line.
+            while (NULL != (line = znet__http_line(c, &len)) && len > 0) 
+            {
+            }
+            return line ? 0 : -1;
+        }
+        if (0 != znet__http_stream(c, k, size) || !znet__http_line(c, &len) || 0 != len) 
+        {
+            return -1;
+        }
+    }
+}
+
+// Reads one response. Returns 0 on success, -1 on failure, -2 if the connection gave nothing.
+static int znet__http_read(znet__http_conn *c, const znet_http_request *req, znet_http_response *res, 
+                           zstr *head, zstr *body) 
+{
+    bool got_any = (c->start != c->end);
+    for (;;) 
+    {
+        z_ssize_t n = znet_http_parse_response(c->buf + c->start, c->end - c->start, res);
+        if (n < 0) 
+        {
+            return -1;
+        }
+        if (0 == n) 
+        {
+            z_ssize_t got = znet__http_fill(c);
+            if (got <= 0) 
+            {
+                return got_any ? -1 : -2;
+            }
+            got_any = true;
+            continue;
+        }
+        // Interim 1xx responses (other than 101) precede the real one.
+        if (res->status >= 100 && res->status < 200 && 101 != res->status) 
+        {
+            c->start += (size_t)n;
+            continue;
+        }
+        // Keep the head for the caller: one copy, re-parsed so the views point at it.
+        zstr_clear(head);
+        if (Z_OK != zstr_cat_len(head, c->buf + c->start, (size_t)n)) 
+        {
+            return -1;
+        }
+        c->start += (size_t)n;
+        znet_http_parse_response(zstr_cstr(head), zstr_len(head), res);
+        break;
+    }
+    zstr_clear(body);
+    znet__http_sink k = { req, res, body };
+    const char *method = req->method ? req->method : "GET";
+    int rc;
+    if (0 == strcmp(method, "HEAD") || 204 == res->status || 304 == res->status) 
+    {
+        rc = 0;
+    }
+    else if (res->chunked) 
+    {
+        rc = znet__http_chunked(c, &k);
+    }
+    else if (res->content_length >= 0) 
+    {
+        rc = znet__http_stream(c, &k, res->content_length);
+    }
+    else 
+    {
+        res->keep_alive = false;    // Delimited by the close.
+        rc = znet__http_stream(c, &k, -1);
+    }
+    res->body = req->on_body ? (zstr_view){ "", 0 } : zstr_as_view(body);
+    return rc;
+}
+
+znet_http_client *znet_http_client_create(int timeout_ms) 
+{
+    znet_http_client *c = (znet_http_client*)ZNET_MALLOC(sizeof(znet_http_client));
+    if (c) 
+    {
+        memset(c, 0, sizeof(*c));
+        c->timeout_ms = timeout_ms;
+    }
+    return c;
+}
+
+static void znet__http_drop(znet__http_conn *conn) 
+{
+    znet_close(&conn->sock);
+    ZNET_FREE(conn);
+}
+
+void znet_http_client_destroy(znet_http_client *c) 
+{
+    if (!c) 
+    {
+        return;
+    }
+    for (size_t i = 0; i < c->host_count; i++) 
+    {
+        while (c->hosts[i].idle) 
+        {
+            znet__http_conn *conn = c->hosts[i].idle;
+            c->hosts[i].idle = conn->next;
+            znet__http_drop(conn);
+        }
+        ZNET_FREE(c->hosts[i].host);
+    }
+    for (size_t i = 0; i < c->slots; i++) 
+    {
+        zstr_free(&c->heads[i]);
+        zstr_free(&c->bodies[i]);
+    }
+    ZNET_FREE(c->heads);
+    ZNET_FREE(c->bodies);
+    ZNET_FREE(c->hosts);
+    ZNET_FREE(c);
+}
+
+static znet__http_host *znet__http_host_of(znet_http_client *c, const char *host, uint16_t port) 
+{
+    for (size_t i = 0; i < c->host_count; i++) 
+    {
+        if (c->hosts[i].port == port && 0 == strcmp(c->hosts[i].host, host)) 
+        {
+            return &c->hosts[i];
+        }
+    }
+    if (c->host_count == c->host_cap) 
+    {
+        size_t cap = c->host_cap ? c->host_cap * 2 : 4;
+        znet__http_host *grown = (znet__http_host*)ZNET_REALLOC(c->hosts, cap * sizeof(*grown));
+        if (!grown) 
+        {
+            return NULL;
+        }
+        c->hosts = grown;
+        c->host_cap = cap;
+    }
+    size_t n = strlen(host);
+    znet__http_host *h = &c->hosts[c->host_count];
+    memset(h, 0, sizeof(*h));
+    if (!(h->host = (char*)ZNET_MALLOC(n + 1))) 
+    {
+        return NULL;
+    }
+    memcpy(h->host, host, n + 1);
+    h->port = port;
+    c->host_count++;
+    return h;
+}
+
+// An idle connection if there is one (*reused set), else a new one. DNS is cached per host.
+static znet__http_conn *znet__http_acquire(znet_http_client *c, znet__http_host *h, bool *reused) 
+{
+    if (h->idle) 
+    {
+        znet__http_conn *conn = h->idle;
+        h->idle = conn->next;
+        h->idle_count--;
+        *reused = true;
+        return conn;
+    }
+    *reused = false;
+    znet__http_conn *conn = (znet__http_conn*)ZNET_MALLOC(sizeof(znet__http_conn));
+    if (!conn) 
+    {
+        return NULL;
+    }
+    conn->start = conn->end = 0;
+    conn->next = NULL;
+    for (int attempt = 0; attempt < 2; attempt++) 
+    {
+        // A cached address that stopped answering gets one fresh lookup.
+        if (!h->resolved || attempt > 0) 
+        {
+            if (Z_OK != znet_resolve(h->host, h->port, &h->addr)) 
+            {
+                break;
+            }
+            h->resolved = true;
+        }
+        conn->sock = znet_socket_create(h->addr.family, ZNET_TCP);
+        if (!conn->sock.valid) 
+        {
+            break;
+        }
+        if (c->timeout_ms > 0) 
+        {
+            znet_set_timeout(conn->sock, c->timeout_ms);
+        }
+        int one = 1;
+        setsockopt((ZNET__SOCKET)conn->sock.handle, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+#       if defined(SO_NOSIGPIPE)
+        setsockopt((ZNET__SOCKET)conn->sock.handle, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#       endif
+        if (Z_OK == znet_connect(conn->sock, h->addr)) 
+        {
+            return conn;
+        }
+        znet_close(&conn->sock);
+    }
+    ZNET_FREE(conn);
+    return NULL;
+}
+
+static void znet__http_release(znet__http_host *h, znet__http_conn *conn) 
+{
+    if (h->idle_count >= ZNET_HTTP_POOL_MAX || conn->start != conn->end) 
+    {
+        znet__http_drop(conn);
+        return;
+    }
+    conn->start = conn->end = 0;
+    conn->next = h->idle;
+    h->idle = conn;
+    h->idle_count++;
+}
+
+static int znet__http_format(zstr *out, const znet__http_host *h, const znet_http_request *r) 
+{
+    const char *method = r->method ? r->method : "GET";
+    int rc = (80 == h->port) 
+           ? zstr_fmt(out, "%s %s HTTP/1.1\r\nHost: %s\r\n", method, r->path ? r->path : "/", h->host)
+           : zstr_fmt(out, "%s %s HTTP/1.1\r\nHost: %s:%u\r\n", method, r->path ? r->path : "/", h->host, 
+                      (unsigned)h->port);
+    if (Z_OK == rc && (r->body_len > 0 || 0 == strcmp(method, "POST") || 0 == strcmp(method, "PUT"))) 
+    {
+        rc = zstr_fmt(out, "Content-Length: %zu\r\n", r->body_len);
+    }
+    if (Z_OK == rc && r->headers) 
+    {
+        rc = zstr_cat(out, r->headers);
+    }
+    if (Z_OK == rc) 
+    {
+        rc = zstr_cat_len(out, "\r\n", 2);
+    }
+    if (Z_OK == rc && r->body_len > 0) 
+    {
+        rc = zstr_cat_len(out, (const char*)r->body, r->body_len);
+    }
+    return rc;
+}
+
+static bool znet__http_send_all(znet_socket s, const char *data, size_t len) 
+{
+    while (len > 0) 
+    {
+        // A pooled connection may be closed under us: fail the send instead of raising SIGPIPE.
+        z_ssize_t n = send((ZNET__SOCKET)s.handle, data, (int)len, ZNET__NOSIGNAL);
+        if (n < 0 && ZNET__INTERRUPTED == ZNET__ERRNO) 
+        {
+            continue;
+        }
+        if (n <= 0) 
+        {
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+int znet_http_pipeline(znet_http_client *c, const char *host, uint16_t port, 
+                       const znet_http_request *reqs, znet_http_response *outs, size_t count) 
+{
+    // Slots are grown up front: head views must not move once handed out.
+    if (count > c->slots) 
+    {
+        zstr *heads = (zstr*)ZNET_REALLOC(c->heads, count * sizeof(zstr));
+        if (heads) 
+        {
+            c->heads = heads;
+        }
+        zstr *bodies = heads ? (zstr*)ZNET_REALLOC(c->bodies, count * sizeof(zstr)) : NULL;
+        if (!bodies) 
+        {
+            return Z_ERR;
+        }
+        c->bodies = bodies;
+        for (size_t i = c->slots; i < count; i++) 
+        {
+            c->heads[i] = zstr_init();
+            c->bodies[i] = zstr_init();
+        }
+        c->slots = count;
+    }
+    for (size_t i = 0; i < count; i++) 
+    {
+        outs[i].status = 0;
+    }
+    znet__http_host *h = znet__http_host_of(c, host, port);
+    if (!h) 
+    {
+        return Z_ERR;
+    }
+    zstr wire = zstr_init();
+    for (size_t i = 0; i < count; i++) 
+    {
+        if (Z_OK != znet__http_format(&wire, h, &reqs[i])) 
+        {
+            zstr_free(&wire);
+            return Z_ERR;
+        }
+    }
+    size_t done = 0;
+    int rc = Z_ERR;
+    for (int attempt = 0; attempt < 2 && done < count; attempt++) 
+    {
+        bool reused;
+        znet__http_conn *conn = znet__http_acquire(c, h, &reused);
+        if (!conn) 
+        {
+            break;
+        }
+        // A pooled connection the server already closed shows up as a failed send or
+        // an empty read; only then, and only before any response, is it safe to resend.
+        int got = znet__http_send_all(conn->sock, zstr_cstr(&wire), zstr_len(&wire)) ? 0 : -2;
+        bool keep = true;
+        for (size_t i = done; i < count && 0 == got; i++) 
+        {
+            got = znet__http_read(conn, &reqs[i], &outs[i], &c->heads[i], &c->bodies[i]);
+            if (0 == got) 
+            {
+                done++;
+                keep = keep && outs[i].keep_alive;
+                if (!outs[i].keep_alive && i + 1 < count) 
+                {
+                    got = -1;   // The server will not answer the rest on this connection.
+                }
+            }
+            else 
+            {
+                outs[i].status = 0;
+            }
+        }
+        if (0 == got && keep) 
+        {
+            znet__http_release(h, conn);
+        }
+        else 
+        {
+            znet__http_drop(conn);
+        }
+        if (0 == got) 
+        {
+            rc = Z_OK;
+            break;
+        }
+        if (-2 != got || !reused || done > 0) 
+        {
+            break;
+        }
+    }
+    zstr_free(&wire);
+    return rc;
+}
+
+int znet_http_send(znet_http_client *c, const char *host, uint16_t port, 
+                   const znet_http_request *req, znet_http_response *out) 
+{
+    return znet_http_pipeline(c, host, port, req, out, 1);
+}
+
+// HTTP/1.1 server logic.
+
+#ifndef ZNET_HTTP_MAX_BODY
+#   define ZNET_HTTP_MAX_BODY (1 << 20)   // Largest request body accepted (413 beyond).
+#endif
+#ifndef ZNET_HTTP_IDLE_MS
+#   define ZNET_HTTP_IDLE_MS 30000        // Connections quiet for this long are closed.
+#endif
+
+struct znet_http_conn 
+{
+    znet_http_server *srv;
+    znet_socket sock;
+    znet_watch *watch;
+    znet_addr peer;
+    char *buf;                  // Received bytes [0, len); the current request starts at 0.
+    size_t cap;
+    size_t len;
+    size_t scan;                // The search for the end of the head resumes here.
+    size_t head_len;            // Non-zero once the current head is complete.
+    znet_http_incoming req;
+    bool pending;               // The handler owes a response.
+    bool dispatching;
+    bool closing;               // Close once the output is out.
+    bool dead;                  // Socket gone; freed when the pending response arrives.
+    char *out;                  // Unsent response bytes [out_off, out_len).
+    size_t out_cap;
+    size_t out_len;
+    size_t out_off;
+    int file_fd;                // File body still to send after out, or -1.
+    int64_t file_off;
+    uint64_t file_left;
+    uint64_t last_active;
+    znet_http_conn *prev;
+    znet_http_conn *next;
+};
+
+struct znet_http_server 
+{
+    znet_loop *loop;
+    znet_socket listener;
+    znet_watch *watch;
+    znet_timer *sweep;
+    znet_http_handler fn;
+    void *user;
+    znet_http_conn *conns;
+};
+
+static void znet__srv_process(znet_http_conn *c);
+
+static void znet__file_close(int fd) 
+{
+#   if defined(_WIN32)
+    _close(fd);
+#   else
+    close(fd);
+#   endif
+}
+
+static void znet__conn_free(znet_http_conn *c) 
+{
+    if (c->prev) 
+    {
+        c->prev->next = c->next;
+    }
+    else 
+    {
+        c->srv->conns = c->next;
+    }
+    if (c->next) 
+    {
+        c->next->prev = c->prev;
+    }
+    if (c->file_fd >= 0) 
+    {
+        znet__file_close(c->file_fd);
+    }
+    ZNET_FREE(c->buf);
+    ZNET_FREE(c->out);
+    ZNET_FREE(c);
+}
+
+// Drops the socket; the struct lives on while the handler still holds it.
+static void znet__conn_kill(znet_http_conn *c) 
+{
+    if (!c->dead) 
+    {
+        znet_loop_remove(c->srv->loop, c->watch);
+        znet_close(&c->sock);
+        c->dead = true;
+    }
+    if (!c->pending) 
+    {
+        znet__conn_free(c);
+    }
+}
+
+static bool znet__conn_busy(const znet_http_conn *c) 
+{
+    return c->out_off < c->out_len || c->file_left > 0;
+}
+
+static void znet__conn_interest(znet_http_conn *c) 
+{
+    int events = znet__conn_busy(c) ? ZNET_POLL_WRITE : (c->pending || c->closing) ? 0 : ZNET_POLL_READ;
+    znet_loop_modify(c->srv->loop, c->watch, events);
+}
+
+// Gathers two pieces into one send. Returns bytes sent or -1.
+static z_ssize_t znet__sendv(znet_socket s, const char *a, size_t alen, const char *b, size_t blen) 
+{
+#   if defined(_WIN32)
+    WSABUF v[2] = { { (ULONG)alen, (CHAR*)a }, { (ULONG)blen, (CHAR*)b } };
+    DWORD sent = 0;
+    if (0 != WSASend((SOCKET)s.handle, v, blen ? 2 : 1, &sent, 0, NULL, NULL)) 
+    {
+        return -1;
+    }
+    return (z_ssize_t)sent;
+#   else
+    struct iovec v[2] = { { (void*)a, alen }, { (void*)b, blen } };
+    struct msghdr m;
+    memset(&m, 0, sizeof(m));
+    m.msg_iov = v;
+    m.msg_iovlen = blen ? 2 : 1;
+    return sendmsg((int)s.handle, &m, ZNET__NOSIGNAL);
+#   endif
+}
+
+static int znet__out_reserve(znet_http_conn *c, size_t len) 
+{
+    if (c->out_off == c->out_len) 
+    {
+        c->out_off = c->out_len = 0;
+    }
+    if (c->out_len + len > c->out_cap) 
+    {
+        size_t cap = c->out_cap ? c->out_cap : 1024;
+        while (cap < c->out_len + len) 
+        {
+            cap *= 2;
+        }
+        char *grown = (char*)ZNET_REALLOC(c->out, cap);
+        if (!grown) 
+        {
+            return Z_ERR;
+        }
+        c->out = grown;
+        c->out_cap = cap;
+    }
+    return Z_OK;
+}
+
+static int znet__out_append(znet_http_conn *c, const char *data, size_t len) 
+{
+    if (Z_OK != znet__out_reserve(c, len)) 
+    {
+        return Z_ERR;
+    }
+    if (len > 0) 
+    {
+        memcpy(c->out + c->out_len, data, len);
+    }
+    c->out_len += len;
+    return Z_OK;
+}
+
+// Next piece of the file body: sendfile straight to the socket, or a read into out.
+// Returns 1 on progress, 0 if the socket would block, -1 on error.
+static int znet__conn_file(znet_http_conn *c) 
+{
+    size_t chunk = c->file_left > (1u << 20) ? (1u << 20) : (size_t)c->file_left;
+#   if defined(ZNET__SENDFILE)
+    off_t off = (off_t)c->file_off;
+    ssize_t n = sendfile((int)c->sock.handle, c->file_fd, &off, chunk);
+    if (n < 0) 
+    {
+        return (EAGAIN == errno || EWOULDBLOCK == errno) ? 0 : -1;
+    }
+#   else
+    chunk = chunk > ZNET_IO_BUFFER ? ZNET_IO_BUFFER : chunk;
+    if (Z_OK != znet__out_reserve(c, chunk)) 
+    {
+        return -1;
+    }
+#       if defined(_WIN32)
+    _lseeki64(c->file_fd, c->file_off, SEEK_SET);
+    int n = _read(c->file_fd, c->out, (unsigned)chunk);
+#       else
+    ssize_t n = pread(c->file_fd, c->out, chunk, (off_t)c->file_off);
+#       endif
+    if (n > 0) 
+    {
+        c->out_off = 0;
+        c->out_len = (size_t)n;
+    }
+#   endif
+    if (n <= 0) 
+    {
+        return -1;      // The file ended before len: the promised length cannot be kept.
+    }
+    c->file_off += n;
+    c->file_left -= (uint64_t)n;
+    return 1;
+}
+
+// Writes pending output until done or the socket would block. Z_ERR if the client is gone.
+static int znet__conn_flush(znet_http_conn *c) 
+{
+    while (znet__conn_busy(c)) 
+    {
+        if (c->out_off < c->out_len) 
+        {
+            z_ssize_t n = znet__sendv(c->sock, c->out + c->out_off, c->out_len - c->out_off, NULL, 0);
+            if (n < 0) 
+            {
+                return (ZNET__WOULDBLOCK == ZNET__ERRNO) ? Z_OK : Z_ERR;
+            }
+            c->out_off += (size_t)n;
+            c->last_active = znet_loop_now(c->srv->loop);
+            continue;
+        }
+        int r = znet__conn_file(c);
+        if (r <= 0) 
+        {
+            return r ? Z_ERR : Z_OK;
+        }
+        c->last_active = znet_loop_now(c->srv->loop);
+    }
+    if (c->file_fd >= 0) 
+    {
+        znet__file_close(c->file_fd);
+        c->file_fd = -1;
+    }
+    return Z_OK;
+}
+
+static const char *znet__http_reason(int status) 
+{
+    switch (status) 
+    {
+        case 100: return "Continue";
+        case 200: return "OK";
+        case 201: return "Created";
+        case 202: return "Accepted";
+        case 204: return "No Content";
+        case 206: return "Partial Content";
+        case 301: return "Moved Permanently";
+        case 302: return "Found";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 408: return "Request Timeout";
+        case 411: return "Length Required";
+        case 413: return "Content Too Large";
+        case 429: return "Too Many Requests";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        default:  return status < 400 ? "OK" : status < 500 ? "Bad Request" : "Internal Server Error";
+    }
+}
+
+// Queues the head, then sends head and body together; only what does not go out is copied.
+static int znet__conn_respond(znet_http_conn *c, int status, const char *headers, 
+                              const char *body, uint64_t len, bool has_file) 
+{
+    bool head_only = (c->req.method.len == 4 && 0 == memcmp(c->req.method.data, "HEAD", 4));
+    bool no_body = (204 == status || 304 == status || (status >= 100 && status < 200));
+    bool close = !c->req.keep_alive || c->closing;
+    char line[160];
+    int n = snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\n", status, znet__http_reason(status));
+    int rc = znet__out_append(c, line, (size_t)n);
+    if (Z_OK == rc && !no_body) 
+    {
+        n = snprintf(line, sizeof(line), "Content-Length: %llu\r\n", (unsigned long long)len);
+        rc = znet__out_append(c, line, (size_t)n);
+    }
+    if (Z_OK == rc && (close || 10 == c->req.version)) 
+    {
+        const char *conn = close ? "Connection: close\r\n" : "Connection: keep-alive\r\n";
+        rc = znet__out_append(c, conn, strlen(conn));
+    }
+    if (Z_OK == rc && headers) 
+    {
+        rc = znet__out_append(c, headers, strlen(headers));
+    }
+    if (Z_OK == rc) 
+    {
+        rc = znet__out_append(c, "\r\n", 2);
+    }
+    if (Z_OK != rc) 
+    {
+        return Z_ERR;
+    }
+    c->closing = close;
+    if (head_only || no_body) 
+    {
+        len = 0;
+    }
+    if (has_file) 
+    {
+        c->file_left = len;
+        return Z_OK;
+    }
+    if (c->out_off == 0 && len > 0) 
+    {
+        z_ssize_t sent = znet__sendv(c->sock, c->out, c->out_len, body, (size_t)len);
+        if (sent < 0 && ZNET__WOULDBLOCK != ZNET__ERRNO) 
+        {
+            return Z_ERR;
+        }
+        size_t done = sent < 0 ? 0 : (size_t)sent;
+        if (done >= c->out_len) 
+        {
+            done -= c->out_len;
+            c->out_off = c->out_len;
+            return znet__out_append(c, body + done, (size_t)len - done);
+        }
+        c->out_off = done;
+    }
+    return znet__out_append(c, body, (size_t)len);
+}
+
+// Common tail of the respond calls: consume the request, then flush and read on.
+static int znet__conn_answered(znet_http_conn *c, int rc) 
+{
+    size_t used = c->head_len + (size_t)(c->req.content_length > 0 ? c->req.content_length : 0);
+    memmove(c->buf, c->buf + used, c->len - used);
+    c->len -= used;
+    c->scan = 0;
+    c->head_len = 0;
+    c->pending = false;
+    if (Z_OK == rc) 
+    {
+        rc = znet__conn_flush(c);
+    }
+    if (Z_OK != rc) 
+    {
+        // Nothing more can go out: drop the rest and close.
+        c->closing = true;
+        c->out_off = c->out_len;
+        c->file_left = 0;
+    }
+    // Inside the handler, the dispatch loop takes it from here (and may free c).
+    if (!c->dispatching) 
+    {
+        znet__srv_process(c);
+    }
+    return rc;
+}
+
+int znet_http_respond(znet_http_conn *conn, int status, const char *headers, 
+                      const void *body, size_t len) 
+{
+    if (conn->dead) 
+    {
+        conn->pending = false;
+        znet__conn_free(conn);
+        return Z_ERR;
+    }
+    int rc = znet__conn_respond(conn, status, headers, (const char*)body, len, false);
+    return znet__conn_answered(conn, rc);
+}
+
+int znet_http_respond_file(znet_http_conn *conn, int status, const char *headers, 
+                           int fd, int64_t offset, uint64_t len) 
+{
+    if (conn->dead) 
+    {
+        conn->pending = false;
+        znet__conn_free(conn);
+        return Z_ERR;
+    }
+#   if defined(_WIN32)
+    conn->file_fd = _dup(fd);
+#   else
+    conn->file_fd = dup(fd);
+#   endif
+    conn->file_off = offset;
+    int rc = (conn->file_fd < 0) ? Z_ERR : znet__conn_respond(conn, status, headers, NULL, len, true);
+    return znet__conn_answered(conn, rc);
+}
+
+znet_addr znet_http_conn_peer(const znet_http_conn *conn) 
+{
+    return conn->peer;
+}
+
+// Request head: "METHOD target HTTP/1.x" and the header lines. Same returns as the parser above.
+static z_ssize_t znet__http_parse_request(const char *buf, size_t len, znet_http_incoming *out, bool *chunked) 
+{
+    const char *p = buf, *end = buf + len;
+    const char *eol = znet__find_crlf(p, end);
+    if (!eol) 
+    {
+        return 0;
+    }
+    memset(out, 0, sizeof(*out));
+    out->content_length = -1;
+    const char *sp1 = (const char*)memchr(p, ' ', (size_t)(eol - p));
+    const char *sp2 = sp1 ? (const char*)memchr(sp1 + 1, ' ', (size_t)(eol - sp1 - 1)) : NULL;
+    if (!sp1 || !sp2 || sp1 == p || sp2 == sp1 + 1 || eol - sp2 != 9 || 0 != memcmp(sp2 + 1, "HTTP/1.", 7)) 
+    {
+        return -1;
+    }
+    out->method = (zstr_view){ p, (size_t)(sp1 - p) };
+    out->target = (zstr_view){ sp1 + 1, (size_t)(sp2 - sp1 - 1) };
+    const char *q = (const char*)memchr(out->target.data, '?', out->target.len);
+    out->path = q ? (zstr_view){ out->target.data, (size_t)(q - out->target.data) } : out->target;
+    out->query = q ? (zstr_view){ q + 1, (size_t)(sp2 - q - 1) } : (zstr_view){ "", 0 };
+    out->version = ('1' == sp2[8]) ? 11 : 10;
+    bool close = (10 == out->version), encoded;
+    *chunked = false;
+    z_ssize_t n = znet__http_fields(buf, eol + 2, end, out->headers, &out->header_count, 
+                                    &out->content_length, chunked, &encoded, &close);
+    out->keep_alive = !close;
+    // A request framed both ways, or by a coding other than chunked, is a smuggling risk: 400.
+    if (n > 0 && encoded && (out->content_length >= 0 || !*chunked)) 
+    {
+        return -1;
+    }
+    return n;
+}
+
+// Error reply for a request that cannot be served; the connection closes after it.
+static void znet__conn_reject(znet_http_conn *c, int status) 
+{
+    memset(&c->req, 0, sizeof(c->req));
+    c->closing = true;
+    c->pending = true;
+    c->head_len = 0;
+    c->len = 0;
+    znet_http_respond(c, status, NULL, NULL, 0);
+}
+
+// Hands complete buffered requests to the handler, one at a time.
+static void znet__srv_process(znet_http_conn *c) 
+{
+    c->dispatching = true;
+    while (!c->pending && !c->closing && !znet__conn_busy(c)) 
+    {
+        if (0 == c->head_len) 
+        {
+            // Resume the search a few bytes back, in case "\r\n\r\n" straddled two reads. A bare
+            // LF would never end the head, so it is rejected as soon as it shows up.
+            size_t from = c->scan > 3 ? c->scan - 3 : 0;
+            const char *p = c->buf + from, *end = c->buf + c->len;
+            bool bare = false;
+            for (; p < end; p++) 
+            {
+                if ('\n' == p[0] && (p == c->buf || '\r' != p[-1])) 
+                {
+                    bare = true;
+                    break;
+                }
+                if (p + 3 < end && '\r' == p[0] && '\n' == p[1] && '\r' == p[2] && '\n' == p[3]) 
+                {
+                    break;
+                }
+            }
+            if (bare) 
+            {
+                znet__conn_reject(c, 400);
+                break;
+            }
+            if (p + 3 >= end) 
+            {
+                c->scan = c->len;
+                if (c->len >= ZNET_HTTP_BUFFER) 
+                {
+                    znet__conn_reject(c, 431);
+                }
+                break;
+            }
+            c->head_len = (size_t)(p + 4 - c->buf);
+        }
+        // Parsed again on every attempt: the views must point into the buffer as it is now.
+        bool chunked;
+        z_ssize_t n = znet__http_parse_request(c->buf, c->head_len, &c->req, &chunked);
+        int status = (n <= 0) ? 400 : chunked ? 501 : (c->req.content_length > ZNET_HTTP_MAX_BODY) ? 413 : 0;
+        if (status) 
+        {
+            znet__conn_reject(c, status);
+            break;
+        }
+        size_t body = (size_t)(c->req.content_length > 0 ? c->req.content_length : 0);
+        if (c->len < c->head_len + body) 
+        {
+            if (c->cap < c->head_len + body) 
+            {
+                char *grown = (char*)ZNET_REALLOC(c->buf, c->head_len + body);
+                if (!grown) 
+                {
+                    c->closing = true;
+                    break;
+                }
+                c->buf = grown;
+                c->cap = c->head_len + body;
+            }
+            zstr_view expect = znet_http_header_get(c->req.headers, c->req.header_count, "expect");
+            if (c->len == c->head_len && znet__ieq(expect, "100-continue")) 
+            {
+                static const char cont[] = "HTTP/1.1 100 Continue\r\n\r\n";
+                znet__sendv(c->sock, cont, sizeof(cont) - 1, NULL, 0);
+            }
+            break;
+        }
+        c->req.body = (zstr_view){ c->buf + c->head_len, body };
+        c->pending = true;
+        c->srv->fn(c, &c->req, c->srv->user);
+    }
+    c->dispatching = false;
+    if (!c->pending && c->closing && !znet__conn_busy(c)) 
+    {
+        znet__conn_kill(c);
+        return;
+    }
+    if (!c->dead) 
+    {
+        znet__conn_interest(c);
+    }
+}
+
+static void znet__conn_ready(znet_loop *loop, znet_watch *w, int events, void *user) 
+{
+    znet_http_conn *c = (znet_http_conn*)user;
+    (void)w;
+    if (znet__conn_busy(c) && (events & (ZNET_POLL_WRITE | ZNET_POLL_ERR))) 
+    {
+        if (Z_OK != znet__conn_flush(c)) 
+        {
+            znet__conn_kill(c);
+        }
+        else if (!znet__conn_busy(c)) 
+        {
+            znet__srv_process(c);   // Closes, or moves on to buffered requests.
+        }
+        return;
+    }
+    if (!(events & (ZNET_POLL_READ | ZNET_POLL_ERR))) 
+    {
+        return;
+    }
+    if (c->pending || c->closing) 
+    {
+        // Not reading now: only a hangup lands here.
+        znet__conn_kill(c);
+        return;
+    }
+    if (c->len == c->cap) 
+    {
+        znet__srv_process(c);
+        return;
+    }
+    z_ssize_t n = znet_recv(c->sock, c->buf + c->len, c->cap - c->len);
+    if (n < 0 && ZNET__WOULDBLOCK == ZNET__ERRNO) 
+    {
+        return;
+    }
+    if (n <= 0) 
+    {
+        znet__conn_kill(c);
+        return;
+    }
+    c->len += (size_t)n;
+    c->last_active = znet_loop_now(loop);
+    znet__srv_process(c);
+}
+
+static void znet__srv_accept(znet_loop *loop, znet_watch *w, int events, void *user) 
+{
+    znet_http_server *srv = (znet_http_server*)user;
+    (void)w; (void)events;
+    for (int i = 0; i < 64; i++) 
+    {
+        znet_addr peer;
+        znet_socket s = znet_accept(srv->listener, &peer);
+        if (!s.valid) 
+        {
+            return;
+        }
+        znet_http_conn *c = (znet_http_conn*)ZNET_MALLOC(sizeof(znet_http_conn));
+        if (c) 
+        {
+            memset(c, 0, sizeof(*c));
+            c->buf = (char*)ZNET_MALLOC(ZNET_HTTP_BUFFER);
+        }
+        if (!c || !c->buf || Z_OK != znet_set_nonblocking(s, true)) 
+        {
+            if (c) 
+            {
+                ZNET_FREE(c->buf);
+            }
+            ZNET_FREE(c);
+            znet_close(&s);
+            continue;
+        }
+        int one = 1;
+        setsockopt((ZNET__SOCKET)s.handle, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+#       if defined(SO_NOSIGPIPE)
+        setsockopt((ZNET__SOCKET)s.handle, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#       endif
+        c->srv = srv;
+        c->sock = s;
+        c->peer = peer;
+        c->cap = ZNET_HTTP_BUFFER;
+        c->file_fd = -1;
+        c->last_active = znet_loop_now(loop);
+        c->watch = znet_loop_add(loop, s, ZNET_POLL_READ, znet__conn_ready, c);
+        if (!c->watch) 
+        {
+            ZNET_FREE(c->buf);
+            ZNET_FREE(c);
+            znet_close(&s);
+            continue;
+        }
+        c->next = srv->conns;
+        if (srv->conns) 
+        {
+            srv->conns->prev = c;
+        }
+        srv->conns = c;
+    }
+}
+
+static void znet__srv_sweep(znet_loop *loop, znet_timer *t, void *user) 
+{
+    znet_http_server *srv = (znet_http_server*)user;
+    uint64_t now = znet_loop_now(loop);
+    (void)t;
+    for (znet_http_conn *c = srv->conns, *next; c; c = next) 
+    {
+        next = c->next;
+        if (!c->pending && now - c->last_active >= ZNET_HTTP_IDLE_MS) 
+        {
+            znet__conn_kill(c);
+        }
+    }
+}
+
+znet_http_server *znet_http_server_create(znet_loop *loop, znet_socket listener, 
+                                          znet_http_handler fn, void *user) 
+{
+    znet_http_server *srv = (znet_http_server*)ZNET_MALLOC(sizeof(znet_http_server));
+    if (!srv) 
+    {
+        return NULL;
+    }
+    memset(srv, 0, sizeof(*srv));
+    srv->loop = loop;
+    srv->listener = listener;
+    srv->fn = fn;
+    srv->user = user;
+    uint64_t period = ZNET_HTTP_IDLE_MS / 4 ? ZNET_HTTP_IDLE_MS / 4 : 1;
+    if (Z_OK != znet_set_nonblocking(listener, true) || 
+        !(srv->watch = znet_loop_add(loop, listener, ZNET_POLL_READ, znet__srv_accept, srv)) || 
+        !(srv->sweep = znet_loop_timer(loop, period, period, znet__srv_sweep, srv))) 
+    {
+        if (srv->watch) 
+        {
+            znet_loop_remove(loop, srv->watch);
+        }
+        ZNET_FREE(srv);
+        return NULL;
+    }
+    return srv;
+}
+
+void znet_http_server_destroy(znet_http_server *srv) 
+{
+    if (!srv) 
+    {
+        return;
+    }
+    while (srv->conns) 
+    {
+        znet_http_conn *c = srv->conns;
+        c->pending = false;
+        znet__conn_kill(c);
+    }
+    znet_loop_cancel(srv->loop, srv->sweep);
+    znet_loop_remove(srv->loop, srv->watch);
+    znet_close(&srv->listener);
+    ZNET_FREE(srv);
 }
 #endif
 
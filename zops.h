@@ -10,6 +10,12 @@
 #ifndef Z_ALL_LISTS
     #define Z_ALL_LISTS(action)
 #endif
+#ifndef Z_ALL_UNROLLED_LISTS
+    #define Z_ALL_UNROLLED_LISTS(action)
+#endif
+#ifndef Z_ALL_INTRUSIVE_LISTS
+    #define Z_ALL_INTRUSIVE_LISTS(action)
+#endif
 #ifndef Z_ALL_MAPS
     #define Z_ALL_MAPS(action)
 #endif
@@ -52,10 +58,22 @@ static inline int    zops_ret_err(void *p, ...) { (void)p; return -1; } // Gener
     static inline bool   zops_empty_vec_const_##Name(const vec_##Name *v)   { return v->length == 0; }      \
     static inline void   zops_del_vec_##Name(vec_##Name *v)                 { vec_free_##Name(v); }         \
     static inline void   zops_clear_vec_##Name(vec_##Name *v)               { vec_clear_##Name(v); }        \
-    static inline T* zops_begin_vec_##Name(vec_##Name *v)                   { return v->data; }             \
-    static inline const T* zops_begin_vec_const_##Name(const vec_##Name *v) { return v->data; }             \
-    static inline T* zops_end_vec_##Name(vec_##Name *v)                     { return v->data + v->length; } \
-    static inline const T* zops_end_vec_const_##Name(const vec_##Name *v)   { return v->data + v->length; }
+    static inline T* zops_begin_vec_##Name(vec_##Name *v)                                                   \
+    {                                                                                                       \
+        return zvec_data_##Name(v);                                                                         \
+    }                                                                                                       \
+    static inline const T* zops_begin_vec_const_##Name(const vec_##Name *v)                                 \
+    {                                                                                                       \
+        return zvec_cdata_##Name##__(v);                                                                    \
+    }                                                                                                       \
+    static inline T* zops_end_vec_##Name(vec_##Name *v)                                                     \
+    {                                                                                                       \
+        return zvec_data_##Name(v) + v->length;                                                             \
+    }                                                                                                       \
+    static inline const T* zops_end_vec_const_##Name(const vec_##Name *v)                                   \
+    {                                                                                                       \
+        return zvec_cdata_##Name##__(v) + v->length;                                                        \
+    }
 
 // List trampolines.
 #define _Z_TRAMP_LIST(T, Name)                                                                      \
@@ -78,6 +96,25 @@ static inline int    zops_ret_err(void *p, ...) { (void)p; return -1; } // Gener
         zlist_node_##Name *n = list_at_##Name((list_##Name*)l, i); return n ? &n->value : NULL;     \
     }
 
+// Unrolled and intrusive list trampolines (const access only; the rest dispatch directly).
+#define _Z_TRAMP_ULIST(T, Name)                                                                     \
+    static inline const T* zops_front_ulist_const_##Name(const zlist_##Name *l) {                   \
+        return zlist_front_##Name((zlist_##Name*)l);                                                \
+    }                                                                                               \
+    static inline const T* zops_back_ulist_const_##Name(const zlist_##Name *l) {                    \
+        return zlist_back_##Name((zlist_##Name*)l);                                                 \
+    }                                                                                               \
+    static inline const T* zops_at_ulist_const_##Name(const zlist_##Name *l, size_t i) {            \
+        return zlist_at_##Name((zlist_##Name*)l, i);                                                \
+    }
+
+#define _Z_TRAMP_ILIST(T, Link, Name)                                                               \
+    static inline const T* zops_front_ilist_const_##Name(const zlist_##Name *l) { return l->head; } \
+    static inline const T* zops_back_ilist_const_##Name(const zlist_##Name *l)  { return l->tail; } \
+    static inline const T* zops_at_ilist_const_##Name(const zlist_##Name *l, size_t i) {            \
+        return zlist_at_##Name((zlist_##Name*)l, i);                                                \
+    }
+
 // Map trampolines.
 #define _Z_TRAMP_MAP(K, V, Name)                                                                            \
     static inline size_t zops_len_map_##Name(map_##Name *m)             { return map_size_##Name(m); }      \
@@ -94,6 +131,8 @@ static inline int    zops_ret_err(void *p, ...) { (void)p; return -1; } // Gener
 /* -> Generator Execution */
 Z_ALL_VECS(_Z_TRAMP_VEC)
 Z_ALL_LISTS(_Z_TRAMP_LIST)
+Z_ALL_UNROLLED_LISTS(_Z_TRAMP_ULIST)
+Z_ALL_INTRUSIVE_LISTS(_Z_TRAMP_ILIST)
 Z_ALL_MAPS(_Z_TRAMP_MAP)
 
 
@@ -124,6 +163,18 @@ Z_ALL_MAPS(_Z_TRAMP_MAP)
 #define _Z_LIST_BACK(T, N)  list_##N*: zops_back_list_##N, const list_##N*: zops_back_list_const_##N,
 #define _Z_LIST_AT(T, N)    list_##N*: zops_at_list_##N, const list_##N*: zops_at_list_const_##N,
 
+#define _Z_ULIST_PUSH(T, N)  zlist_##N*: zlist_push_back_##N,
+#define _Z_ULIST_POP(T, N)   zlist_##N*: zlist_pop_back_##N,
+#define _Z_ULIST_FRONT(T, N) zlist_##N*: zlist_front_##N, const zlist_##N*: zops_front_ulist_const_##N,
+#define _Z_ULIST_BACK(T, N)  zlist_##N*: zlist_back_##N,  const zlist_##N*: zops_back_ulist_const_##N,
+#define _Z_ULIST_AT(T, N)    zlist_##N*: zlist_at_##N,    const zlist_##N*: zops_at_ulist_const_##N,
+
+#define _Z_ILIST_PUSH(T, L, N)  zlist_##N*: zlist_push_back_##N,
+#define _Z_ILIST_POP(T, L, N)   zlist_##N*: zlist_pop_back_##N,
+#define _Z_ILIST_FRONT(T, L, N) zlist_##N*: zlist_head_##N, const zlist_##N*: zops_front_ilist_const_##N,
+#define _Z_ILIST_BACK(T, L, N)  zlist_##N*: zlist_tail_##N, const zlist_##N*: zops_back_ilist_const_##N,
+#define _Z_ILIST_AT(T, L, N)    zlist_##N*: zlist_at_##N,   const zlist_##N*: zops_at_ilist_const_##N,
+
 // Map support.
 #define _Z_HASH_LEN(K, V, N)   map_##N*: zops_len_map_##N, const map_##N*: zops_len_map_const_##N,
 #define _Z_HASH_EMPTY(K, V, N) map_##N*: zops_empty_map_##N, const map_##N*: zops_empty_map_const_##N,
@@ -193,6 +244,8 @@ Z_ALL_MAPS(_Z_TRAMP_MAP)
     const zstr*: zops_at_zstr_const,    \
     Z_ALL_VECS(_Z_MAP_AT)               \
     Z_ALL_LISTS(_Z_LIST_AT)             \
+    Z_ALL_UNROLLED_LISTS(_Z_ULIST_AT)   \
+    Z_ALL_INTRUSIVE_LISTS(_Z_ILIST_AT)  \
     Z_ALL_MAPS(_Z_HASH_AT)              \
     default:    zops_ret_null           \
 )(x, i)
@@ -202,6 +255,8 @@ Z_ALL_MAPS(_Z_TRAMP_MAP)
     const zstr*: zops_back_zstr_const,\
     Z_ALL_VECS(_Z_MAP_BACK)             \
     Z_ALL_LISTS(_Z_LIST_BACK)           \
+    Z_ALL_UNROLLED_LISTS(_Z_ULIST_BACK) \
+    Z_ALL_INTRUSIVE_LISTS(_Z_ILIST_BACK)\
     default:    zops_ret_null           \
 )(x)
 
@@ -210,6 +265,8 @@ Z_ALL_MAPS(_Z_TRAMP_MAP)
     const zstr*: zops_front_zstr_const, \
     Z_ALL_VECS(_Z_MAP_FRONT)            \
     Z_ALL_LISTS(_Z_LIST_FRONT)          \
+    Z_ALL_UNROLLED_LISTS(_Z_ULIST_FRONT)\
+    Z_ALL_INTRUSIVE_LISTS(_Z_ILIST_FRONT)\
     default:    zops_ret_null           \
 )(x)
 
@@ -219,6 +276,8 @@ Z_ALL_MAPS(_Z_TRAMP_MAP)
     zstr*:      zops_push_zstr,         \
     Z_ALL_VECS(_Z_MAP_PUSH)             \
     Z_ALL_LISTS(_Z_LIST_PUSH)           \
+    Z_ALL_UNROLLED_LISTS(_Z_ULIST_PUSH) \
+    Z_ALL_INTRUSIVE_LISTS(_Z_ILIST_PUSH)\
     default:    zops_ret_err            \
 )(x, val)
 
@@ -226,6 +285,8 @@ Z_ALL_MAPS(_Z_TRAMP_MAP)
     zstr*:      zops_pop_zstr,  \
     Z_ALL_VECS(_Z_MAP_POP)      \
     Z_ALL_LISTS(_Z_LIST_POP)    \
+    Z_ALL_UNROLLED_LISTS(_Z_ULIST_POP)\
+    Z_ALL_INTRUSIVE_LISTS(_Z_ILIST_POP)\
     default:    zops_noop       \
 )(x)
 
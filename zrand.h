@@ -12,6 +12,8 @@
  * • Thread-safe global API (Thread Local Storage).
  * • Deterministic instances (for procedural generation).
  * • Utilities: UUID v4, Fisher-Yates shuffle, Gaussian distribution.
+ * • Bulk fills over interleaved PCG lanes and a ziggurat normal sampler.
+ * • Jump-ahead and stream splitting for reproducible per-worker streams.
  * • Zero-dependency (optional integration with zmath.h).
  * • C++ `z_rand` wrapper with STL integration.
  *
@@ -92,6 +94,18 @@ bool    zrand_chance(double probability);
 /// Returns a `double` following a normal distribution.
 double  zrand_gaussian(double mean, double stddev);
 
+/// Returns a `double` following a normal distribution (ziggurat; faster than `zrand_gaussian`).
+double  zrand_normal(double mean, double stddev);
+
+/// Fills `out` with `n` random 32-bit unsigned integers.
+void    zrand_fill_u32(uint32_t *out, size_t n);
+
+/// Fills `out` with `n` floats in the range `[0.0, 1.0)`.
+void    zrand_fill_f32(float *out, size_t n);
+
+/// Fills `out` with `n` normally distributed doubles (ziggurat).
+void    zrand_fill_gaussian(double *out, size_t n, double mean, double stddev);
+
 /// Fills a buffer with random bytes.
 void    zrand_bytes(void *buf, size_t len);
 
@@ -141,9 +155,43 @@ int32_t  zrand_rng_range(zrand_rng *rng, int32_t min, int32_t max);
 /// Helper to generate a double from a specific instance.
 double   zrand_rng_f64(zrand_rng *rng);
 
-/// Helper to generate a gaussian double from a specific instance.
+/// Helper to generate a gaussian double from a specific instance (polar method).
 double   zrand_rng_gaussian(zrand_rng *rng, double mean, double stddev);
 
+/// Generates a gaussian double with the ziggurat method. Draws a different sequence than `zrand_rng_gaussian`, which is left unchanged for existing replays.
+double   zrand_rng_normal(zrand_rng *rng, double mean, double stddev);
+
+/// @endgroup
+/// @group Bulk Generation
+/// Each fill yields exactly what the matching single-value calls would, in order, and leaves `rng` in the same state, so seeded streams stay reproducible whichever form is used. Runs of values are produced by several interleaved PCG lanes (jumped copies of the same stream), which breaks the serial multiply chain.
+
+/// Fills `out` with `n` values; same as `n` calls of `zrand_rng_u32`.
+void     zrand_rng_fill_u32(zrand_rng *rng, uint32_t *out, size_t n);
+
+/// Fills `out` with `n` values; same as `n` calls of `zrand_rng_u64`.
+void     zrand_rng_fill_u64(zrand_rng *rng, uint64_t *out, size_t n);
+
+/// Fills `out` with `n` floats in `[0.0, 1.0)` (24-bit, as `zrand_f32`).
+void     zrand_rng_fill_f32(zrand_rng *rng, float *out, size_t n);
+
+/// Fills `out` with `n` doubles in `[0.0, 1.0)`; same as `n` calls of `zrand_rng_f64`.
+void     zrand_rng_fill_f64(zrand_rng *rng, double *out, size_t n);
+
+/// Fills `out` with `n` normally distributed doubles; same as `n` calls of `zrand_rng_normal`.
+void     zrand_rng_fill_gaussian(zrand_rng *rng, double *out, size_t n, double mean, double stddev);
+
+/// Fills a buffer with random bytes.
+void     zrand_rng_fill_bytes(zrand_rng *rng, void *buf, size_t len);
+
+/// @endgroup
+/// @group Streams
+
+/// Moves `rng` `delta` steps along its sequence in O(log delta). Pass `(uint64_t)-k` to step back `k`.
+void     zrand_rng_advance(zrand_rng *rng, uint64_t delta);
+
+/// Derives an independent, reproducible stream number `stream` from `parent`, which is left untouched. Give each worker its own index.
+void     zrand_rng_split(zrand_rng *child, const zrand_rng *parent, uint64_t stream);
+
 /// @endgroup
 
 // Optional short names.
@@ -158,6 +206,10 @@ double   zrand_rng_gaussian(zrand_rng *rng, double mean, double stddev);
 #   define rand_range_f    zrand_range_f
 #   define rand_chance     zrand_chance
 #   define rand_gaussian   zrand_gaussian
+#   define rand_normal     zrand_normal
+#   define rand_fill_u32   zrand_fill_u32
+#   define rand_fill_f32   zrand_fill_f32
+#   define rand_fill_gaussian zrand_fill_gaussian
 #   define rand_bytes      zrand_bytes
 #   define rand_str        zrand_str
 #   define rand_uuid       zrand_uuid
@@ -192,6 +244,8 @@ namespace z_rand
     /// @row `z_rand::chance(prob)` | Returns true based on probability.
     /// @row `z_rand::range(min, max)` | Returns value in range (overloaded for `int` and `float`).
     /// @row `z_rand::gaussian(mean, std)`| Returns normally distributed value.
+    /// @row `z_rand::normal(mean, std)` | Returns normally distributed value (ziggurat).
+    /// @row `z_rand::fill(ptr, n)` | Bulk fill (overloaded for `uint32_t` and `float`).
     /// @row `z_rand::uuid()` | Returns a standard `std::string` containing a UUID v4.
     /// @row `z_rand::string(len)` | Returns a standard `std::string` of random alphanumeric characters.
     /// @row `z_rand::shuffle(vector)` | Shuffles a `std::vector` (or `z_vec::vector`) in-place.
@@ -249,6 +303,21 @@ namespace z_rand
         return ::zrand_gaussian(mean, stddev);
     }
 
+    inline double normal(double mean, double stddev)
+    {
+        return ::zrand_normal(mean, stddev);
+    }
+
+    inline void fill(uint32_t *out, size_t n)
+    {
+        ::zrand_fill_u32(out, n);
+    }
+
+    inline void fill(float *out, size_t n)
+    {
+        ::zrand_fill_f32(out, n);
+    }
+
     inline std::string uuid() 
     {
         char buf[37];
@@ -352,6 +421,49 @@ namespace z_rand
         {
             return ::zrand_rng_gaussian(&rng, m, s);
         }
+
+        double normal(double m, double s)
+        {
+            return ::zrand_rng_normal(&rng, m, s);
+        }
+
+        void fill(uint32_t *out, size_t n)
+        {
+            ::zrand_rng_fill_u32(&rng, out, n);
+        }
+
+        void fill(uint64_t *out, size_t n)
+        {
+            ::zrand_rng_fill_u64(&rng, out, n);
+        }
+
+        void fill(float *out, size_t n)
+        {
+            ::zrand_rng_fill_f32(&rng, out, n);
+        }
+
+        void fill(double *out, size_t n)
+        {
+            ::zrand_rng_fill_f64(&rng, out, n);
+        }
+
+        void fill_gaussian(double *out, size_t n, double m, double s)
+        {
+            ::zrand_rng_fill_gaussian(&rng, out, n, m, s);
+        }
+
+        void advance(uint64_t delta)
+        {
+            ::zrand_rng_advance(&rng, delta);
+        }
+
+        // Independent child stream, e.g. one per worker thread.
+        generator split(uint64_t stream) const
+        {
+            generator g(0);
+            ::zrand_rng_split(&g.rng, &rng, stream);
+            return g;
+        }
     };
 }
 #endif // __cplusplus
@@ -366,6 +478,11 @@ namespace z_rand
 #include <string.h>
 #include <time.h>
 
+#if !defined(Z_NO_EXTENSIONS) && !defined(ZRAND_NO_SIMD) && defined(__AVX2__)
+#   include <immintrin.h>
+#   define ZRAND_SIMD_AVX2 1
+#endif
+
 #ifndef ZMATH_IMPLEMENTATION
 #   define ZMATH_IMPLEMENTATION
 #   define ZMATH_NO_LIBC 
@@ -392,11 +509,31 @@ namespace z_rand
         rand_s(&s2);
         return ((uint64_t)s1 << 32) | s2;
     }
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
+    static uint64_t zrand__os_seed(void) 
+    {
+        uint64_t seed;
+        arc4random_buf(&seed, sizeof(seed));
+        return seed;
+    }
 #else
 #   include <stdio.h>
+#   if defined(__linux__) && defined(__has_include)
+#       if __has_include(<sys/random.h>)
+#           include <sys/random.h>
+#           define ZRAND_HAS_GETRANDOM
+#       endif
+#   endif
     static uint64_t zrand__os_seed(void) 
     {
         uint64_t seed = 0;
+#   ifdef ZRAND_HAS_GETRANDOM
+        // One syscall, no file descriptor; /dev/urandom stays as the fallback.
+        if ((ssize_t)sizeof(seed) == getrandom(&seed, sizeof(seed), 0))
+        {
+            return seed;
+        }
+#   endif
         FILE *f = fopen("/dev/urandom", "rb");
         if (f) 
         {
@@ -413,15 +550,44 @@ namespace z_rand
 
 // PCG implementation details.
 
-static uint32_t zrand__pcg32(zrand_rng *rng) 
+#define ZRAND_PCG_MULT 6364136223846793005ULL
+
+// XSH-RR output permutation of a pre-step state.
+static inline uint32_t zrand__pcg_out(uint64_t oldstate) 
 {
-    uint64_t oldstate = rng->state;
-    rng->state = oldstate * 6364136223846793005ULL + (rng->inc | 1);
     uint32_t xorshifted = (uint32_t)(((oldstate >> 18u) ^ oldstate) >> 27u);
     uint32_t rot = (uint32_t)(oldstate >> 59u);
     return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
 }
 
+static uint32_t zrand__pcg32(zrand_rng *rng) 
+{
+    uint64_t oldstate = rng->state;
+    rng->state = oldstate * ZRAND_PCG_MULT + (rng->inc | 1);
+    return zrand__pcg_out(oldstate);
+}
+
+// Folds `delta` LCG steps into one affine map: state' = mult * state + plus
+// (Brown, "Random Number Generation with Arbitrary Strides").
+static void zrand__lcg_jump(uint64_t delta, uint64_t inc, uint64_t *mult, uint64_t *plus) 
+{
+    uint64_t cur_mult = ZRAND_PCG_MULT, cur_plus = inc;
+    uint64_t acc_mult = 1, acc_plus = 0;
+    while (delta > 0) 
+    {
+        if (delta & 1) 
+        {
+            acc_mult *= cur_mult;
+            acc_plus = acc_plus * cur_mult + cur_plus;
+        }
+        cur_plus = (cur_mult + 1) * cur_plus;
+        cur_mult *= cur_mult;
+        delta >>= 1;
+    }
+    *mult = acc_mult;
+    *plus = acc_plus;
+}
+
 void zrand_rng_init(zrand_rng *rng, uint64_t seed, uint64_t seq) 
 {
     rng->state = 0U;
@@ -473,8 +639,7 @@ uint32_t zrand_u32(void)
 
 uint64_t zrand_u64(void) 
 { 
-    zrand_rng *r = zrand__get(); 
-    return ((uint64_t)zrand__pcg32(r) << 32) | zrand__pcg32(r); 
+    return zrand_rng_u64(zrand__get()); 
 }
 
 float zrand_f32(void) 
@@ -538,26 +703,31 @@ double zrand_gaussian(double mean, double stddev)
     return zrand__box_muller(zrand__get(), mean, stddev); 
 }
 
+double zrand_normal(double mean, double stddev) 
+{ 
+    return zrand_rng_normal(zrand__get(), mean, stddev); 
+}
+
+void zrand_fill_u32(uint32_t *out, size_t n) 
+{
+    zrand_rng_fill_u32(zrand__get(), out, n);
+}
+
+void zrand_fill_f32(float *out, size_t n) 
+{
+    zrand_rng_fill_f32(zrand__get(), out, n);
+}
+
+void zrand_fill_gaussian(double *out, size_t n, double mean, double stddev) 
+{
+    zrand_rng_fill_gaussian(zrand__get(), out, n, mean, stddev);
+}
+
 // Utilities implementation.
 
 void zrand_bytes(void *buf, size_t len) 
 {
-    uint8_t *p = (uint8_t*)buf;
-    while (len >= 4) 
-    { 
-        *(uint32_t*)p = zrand_u32(); 
-        p += 4; 
-        len -= 4; 
-    }
-    if (len > 0) 
-    { 
-        uint32_t rem = zrand_u32(); 
-        uint8_t *r = (uint8_t*)&rem; 
-        while (len--) 
-        {
-            *p++ = *r++; 
-        }
-    }
+    zrand_rng_fill_bytes(zrand__get(), buf, len);
 }
 
 static const char ZRAND_ALPHANUM[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
@@ -640,7 +810,9 @@ uint32_t zrand_rng_u32(zrand_rng *rng)
 
 uint64_t zrand_rng_u64(zrand_rng *rng) 
 { 
-    return ((uint64_t)zrand__pcg32(rng) << 32) | zrand__pcg32(rng); 
+    // High half first, sequenced explicitly.
+    uint64_t hi = zrand__pcg32(rng);
+    return (hi << 32) | zrand__pcg32(rng); 
 }
 
 double zrand_rng_f64(zrand_rng *rng) 
@@ -668,5 +840,441 @@ int32_t zrand_rng_range(zrand_rng *rng, int32_t min, int32_t max)
     return min + (int32_t)(x / bucket);
 }
 
+// Bulk generation.
+
+// Enough independent lanes to hide the multiply latency of each state chain.
+#ifdef ZRAND_SIMD_AVX2
+#   define ZRAND_LANES 16
+#else
+#   define ZRAND_LANES 8
+#endif
+
+// Scratch block for fills that post-process raw draws.
+#define ZRAND_BLOCK 256
+
+#ifdef ZRAND_SIMD_AVX2
+// x * m mod 2^64 per 64-bit lane, from three 32x32->64 products.
+static inline __m256i zrand__mul64_x4(__m256i x, __m256i m, __m256i m_hi) 
+{
+    __m256i lo = _mm256_mul_epu32(x, m);
+    __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), m),
+                                     _mm256_mul_epu32(x, m_hi));
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+// zrand__pcg_out on four states; results sit in the low half of each lane.
+static inline __m256i zrand__pcg_out_x4(__m256i s) 
+{
+    __m256i x = _mm256_srli_epi64(_mm256_xor_si256(_mm256_srli_epi64(s, 18), s), 27);
+    __m256i rot = _mm256_srli_epi64(s, 59);
+    __m256i nrot = _mm256_and_si256(_mm256_sub_epi32(_mm256_setzero_si256(), rot), _mm256_set1_epi32(31));
+    return _mm256_or_si256(_mm256_srlv_epi32(x, rot), _mm256_sllv_epi32(x, nrot));
+}
+#endif
+
+void zrand_rng_fill_u32(zrand_rng *rng, uint32_t *out, size_t n) 
+{
+    size_t i = 0;
+    if (n >= 2 * ZRAND_LANES) 
+    {
+        // Lane k holds the state k steps ahead; every lane then strides by
+        // ZRAND_LANES, so out[] is exactly the serial sequence.
+        size_t body = n - n % ZRAND_LANES;
+        uint64_t inc = rng->inc | 1;
+        uint64_t s[ZRAND_LANES];
+        uint64_t mult, plus;
+        s[0] = rng->state;
+        for (int k = 1; k < ZRAND_LANES; k++)
+        {
+            s[k] = s[k - 1] * ZRAND_PCG_MULT + inc;
+        }
+        zrand__lcg_jump(ZRAND_LANES, inc, &mult, &plus);
+#   ifdef ZRAND_SIMD_AVX2
+        __m256i vs[ZRAND_LANES / 4];
+        for (int k = 0; k < ZRAND_LANES / 4; k++)
+        {
+            vs[k] = _mm256_loadu_si256((const __m256i*)(s + 4 * k));
+        }
+        __m256i vm = _mm256_set1_epi64x((long long)mult);
+        __m256i vm_hi = _mm256_set1_epi64x((long long)(mult >> 32));
+        __m256i vp = _mm256_set1_epi64x((long long)plus);
+        __m256i even = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+        for (; i < body; i += ZRAND_LANES) 
+        {
+            for (int k = 0; k < ZRAND_LANES / 4; k += 2) 
+            {
+                __m256i r0 = _mm256_permutevar8x32_epi32(zrand__pcg_out_x4(vs[k]), even);
+                __m256i r1 = _mm256_permutevar8x32_epi32(zrand__pcg_out_x4(vs[k + 1]), even);
+                _mm256_storeu_si256((__m256i*)(out + i + 4 * k), _mm256_permute2x128_si256(r0, r1, 0x20));
+                vs[k] = _mm256_add_epi64(zrand__mul64_x4(vs[k], vm, vm_hi), vp);
+                vs[k + 1] = _mm256_add_epi64(zrand__mul64_x4(vs[k + 1], vm, vm_hi), vp);
+            }
+        }
+        _mm256_storeu_si256((__m256i*)s, vs[0]);
+#   else
+        for (; i < body; i += ZRAND_LANES) 
+        {
+            for (int k = 0; k < ZRAND_LANES; k++) 
+            {
+                out[i + k] = zrand__pcg_out(s[k]);
+                s[k] = s[k] * mult + plus;
+            }
+        }
+#   endif
+        rng->state = s[0];
+    }
+    for (; i < n; i++)
+    {
+        out[i] = zrand__pcg32(rng);
+    }
+}
+
+void zrand_rng_fill_u64(zrand_rng *rng, uint64_t *out, size_t n) 
+{
+    uint32_t tmp[2 * ZRAND_BLOCK];
+    while (n > 0) 
+    {
+        size_t c = (n < ZRAND_BLOCK) ? n : ZRAND_BLOCK;
+        zrand_rng_fill_u32(rng, tmp, 2 * c);
+        for (size_t i = 0; i < c; i++)
+        {
+            out[i] = ((uint64_t)tmp[2 * i] << 32) | tmp[2 * i + 1];
+        }
+        out += c;
+        n -= c;
+    }
+}
+
+void zrand_rng_fill_f32(zrand_rng *rng, float *out, size_t n) 
+{
+    uint32_t tmp[ZRAND_BLOCK];
+    while (n > 0) 
+    {
+        size_t c = (n < ZRAND_BLOCK) ? n : ZRAND_BLOCK;
+        zrand_rng_fill_u32(rng, tmp, c);
+        for (size_t i = 0; i < c; i++)
+        {
+            out[i] = (tmp[i] >> 8) * (1.0f / 16777216.0f);
+        }
+        out += c;
+        n -= c;
+    }
+}
+
+void zrand_rng_fill_f64(zrand_rng *rng, double *out, size_t n) 
+{
+    uint64_t tmp[ZRAND_BLOCK];
+    while (n > 0) 
+    {
+        size_t c = (n < ZRAND_BLOCK) ? n : ZRAND_BLOCK;
+        zrand_rng_fill_u64(rng, tmp, c);
+        for (size_t i = 0; i < c; i++)
+        {
+            out[i] = (int64_t)(tmp[i] >> 11) * (1.0 / 9007199254740992.0);
+        }
+        out += c;
+        n -= c;
+    }
+}
+
+void zrand_rng_fill_bytes(zrand_rng *rng, void *buf, size_t len) 
+{
+    uint8_t *p = (uint8_t*)buf;
+    uint32_t tmp[ZRAND_BLOCK];
+    while (len > 0) 
+    {
+        size_t words = (len + 3) / 4;
+        size_t c = (words < ZRAND_BLOCK) ? words : ZRAND_BLOCK;
+        size_t bytes = (c * 4 < len) ? c * 4 : len;
+        zrand_rng_fill_u32(rng, tmp, c);
+        memcpy(p, tmp, bytes);
+        p += bytes;
+        len -= bytes;
+    }
+}
+
+// Streams.
+
+void zrand_rng_advance(zrand_rng *rng, uint64_t delta) 
+{
+    uint64_t mult, plus;
+    zrand__lcg_jump(delta, rng->inc | 1, &mult, &plus);
+    rng->state = rng->state * mult + plus;
+}
+
+static inline uint64_t zrand__splitmix64(uint64_t x) 
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+void zrand_rng_split(zrand_rng *child, const zrand_rng *parent, uint64_t stream) 
+{
+    // Hash both the sequence and the seed so neighbouring stream indices do
+    // not land on related increments.
+    uint64_t seq = zrand__splitmix64(parent->inc ^ zrand__splitmix64(stream));
+    uint64_t seed = zrand__splitmix64(parent->state ^ seq);
+    zrand_rng_init(child, seed, seq);
+}
+
+// Ziggurat normal sampler.
+//
+// Marsaglia & Tsang with 128 layers in Doornik's ZIGNOR layout: X[0] is the
+// base strip's pseudo-width, X[1] = R, X[128] = 0, and F[i] = exp(-X[i]^2 / 2).
+// One 64-bit draw picks the layer (low 7 bits) and the signed abscissa (top
+// 53 bits); about 99% of samples return after a single compare.
+
+#define ZRAND_ZIG_R 3.442619855899
+
+static const double ZRAND_ZIG_X[129] =
+{
+    3.7130862467425501, 3.4426198558990002, 3.2230849845811416, 3.0832288582168683,
+    2.9786962526477803, 2.8943440070215289, 2.8231253505489105, 2.7611693723871769,
+    2.7061135731218195, 2.6564064112613597, 2.6109722484318474, 2.5690336259249378,
+    2.5300096723888275, 2.4934545220953721, 2.4590181774118305, 2.4264206455337498,
+    2.3954342780110625, 2.3658713701176386, 2.3375752413392368, 2.310413683698763,
+    2.2842740596774718, 2.2590595738691985, 2.2346863955909795, 2.2110814088787034,
+    2.1881804320760492, 2.1659267937489219, 2.1442701823603953, 2.1231657086739766,
+    2.1025731351892385, 2.0824562379920168, 2.0627822745083084, 2.0435215366550676,
+    2.0246469733773855, 2.0061338699634721, 1.9879595741276199, 1.9701032608543265,
+    1.9525457295535567, 1.9352692282966228, 1.9182573008645099, 1.9014946531051511,
+    1.884967035707759, 1.8686611409944887, 1.8525645117280911, 1.836665460258446,
+    1.8209529965961255, 1.8054167642192285, 1.7900469825998586, 1.7748343955860695,
+    1.7597702248995934, 1.7448461281138004, 1.7300541605637305, 1.7153867407136676,
+    1.7008366185699169, 1.6863968467791681, 1.6720607540976009, 1.6578219209540241,
+    1.6436741568628686, 1.6296114794706347, 1.615628095043161, 1.6017183802213781,
+    1.5878768648905761, 1.5740982160230008, 1.5603772223661689, 1.5467087798599104,
+    1.5330878776740433, 1.5195095847659401, 1.5059690368632033, 1.492461423781354,
+    1.4789819769899242, 1.4655259573427108, 1.4520886428892246, 1.4386653166845635,
+    1.4252512545140601, 1.4118417124470577, 1.3984319141310053, 1.3850170377326518,
+    1.3715922024273426, 1.3581524543301435, 1.344692751753547, 1.3312079496656273,
+    1.3176927832094141, 1.3041418501286168, 1.2905495919261964, 1.2769102735601556,
+    1.2632179614546211, 1.2494664995730682, 1.2356494832633627, 1.2217602305399964,
+    1.2077917504159497, 1.1937367078331287, 1.1795873846639882, 1.1653356361647524,
+    1.1509728421488674, 1.1364898520131608, 1.1218769225825422, 1.107123647534036,
+    1.0922188769072774, 1.0771506248928957, 1.0619059636948243, 1.0464709007640454,
+    1.0308302360681956, 1.0149673952513305, 0.99886423349298359, 0.98250080351542901,
+    0.9658550794011499, 0.94890262551130644, 0.93161619661515083, 0.91396525102303228,
+    0.89591535258093769, 0.87742742911292337, 0.85845684319381321, 0.83895221429757738,
+    0.81885390670035729, 0.79809206064405691, 0.77658398789475991, 0.75423066445405562,
+    0.73091191064248884, 0.70647961133543646, 0.68074791866915463, 0.65347863873997525,
+    0.6243585973360507, 0.59296294247144832, 0.55869217840818519, 0.52065603876206057,
+    0.47743783729668982, 0.42654798635542351, 0.36287143109703196, 0.27232086481396467,
+    0.0
+};
+
+static const double ZRAND_ZIG_F[129] =
+{
+    0.0010143525641203791, 0.0026696290838809228, 0.0055489952207713449, 0.0086244844128598851,
+    0.011839478657884862, 0.015167298010546568, 0.018592102737011288, 0.022103304615927098,
+    0.025693291935934271, 0.02935631744000685, 0.033087886146225751, 0.036884388786656203,
+    0.040742868074444175, 0.044660862200491425, 0.048636295859867805, 0.052667401903051012,
+    0.056752663481049848, 0.060890770348040406, 0.065080585213068073, 0.069321117393577908,
+    0.073611501884113403, 0.077950982513973394, 0.082338898242235656, 0.086774671894780178,
+    0.091257800826830257, 0.095787849121731439, 0.10036444102865587, 0.10498725540942132,
+    0.10965602101484027, 0.11437051244886601, 0.11913054670765083, 0.12393598020286782,
+    0.12878670619594321, 0.13368265258343937, 0.1386237799845946, 0.14361008009062776,
+    0.14864157424234226, 0.15371831220818166, 0.1588403711394793, 0.16400785468342038,
+    0.169220892237365, 0.1744796383307895, 0.17978427212329545, 0.18513499700899219,
+    0.19053204031913715, 0.19597565311627774, 0.20146611007431367, 0.20700370943992652,
+    0.2125887730717303, 0.2182216465543054, 0.22390269938500842, 0.22963232523211613,
+    0.23541094226347908, 0.24123899354543982, 0.24711694751232141, 0.25304529850732577,
+    0.25902456739620483, 0.26505530225558921, 0.27113807913838461, 0.27727350291918812,
+    0.28346220822323298, 0.28970486044295984, 0.29600215684693298, 0.30235482778648354,
+    0.30876363800618112, 0.31522938806501088, 0.32175291587598492, 0.3283350983728503,
+    0.33497685331358917, 0.34167914123155041, 0.34844296754632659, 0.35526938484791709,
+    0.36215949536931757, 0.36911445366447221, 0.37613546951056259, 0.3832238110559012,
+    0.39038080823731458, 0.39760785649387331, 0.40490642080722294, 0.412278040102661,
+    0.41972433204957438, 0.42724699830499607, 0.43484783024999091, 0.44252871527546844,
+    0.45029164368203922, 0.45813871626787206, 0.46607215268945612, 0.47409430069301695,
+    0.48220764632948521, 0.49041482528384411, 0.4987186354709795, 0.50712205107556896,
+    0.51562823824400184, 0.52424057267298407, 0.53296265938383613, 0.5417983550254255,
+    0.55075179311460454, 0.55982741270408687, 0.56902999106795094, 0.57836468111976314,
+    0.58783705443470657, 0.59745315094451668, 0.60721953662512029, 0.61714337081888093,
+    0.62723248524992725, 0.6374954773350423, 0.64794182111022247, 0.65858200005008805,
+    0.66942766734889037, 0.68049184099733406, 0.69178914343667508, 0.70333609901615812,
+    0.7151515074104986, 0.72725691834418482, 0.73967724367264731, 0.75244155917461142,
+    0.7655841738977045, 0.7791460859296877, 0.79317701177130506, 0.80773829468296054,
+    0.82290721138140899, 0.83878360529598961, 0.85550060786945059, 0.87324304891006954,
+    0.8922816507840261, 0.9130436479717402, 0.93628268168505957, 0.96359969312708615,
+    1.0
+};
+
+// Double precision exp/log for the wedge and tail tests (zmath is single
+// precision). zrand__exp is only called on [-R^2 / 2, 0]; zrand__log on (0, 1].
+static double zrand__exp(double x) 
+{
+    double k = (double)(int64_t)(x * 1.4426950408889634 - 0.5);
+    double r = (x - k * 6.93147180369123816490e-01) - k * 1.90821492927058770002e-10;
+    double p = 1.0 / 479001600.0;
+    p = p * r + 1.0 / 39916800.0;
+    p = p * r + 1.0 / 3628800.0;
+    p = p * r + 1.0 / 362880.0;
+    p = p * r + 1.0 / 40320.0;
+    p = p * r + 1.0 / 5040.0;
+    p = p * r + 1.0 / 720.0;
+    p = p * r + 1.0 / 120.0;
+    p = p * r + 1.0 / 24.0;
+    p = p * r + 1.0 / 6.0;
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+    uint64_t bits = (uint64_t)((int64_t)k + 1023) << 52;
+    double scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+static double zrand__log(double x) 
+{
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    int e = (int)((bits >> 52) & 0x7FF) - 1023;
+    bits = (bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL;
+    double m;
+    memcpy(&m, &bits, sizeof(m));
+    if (m > 1.4142135623730951) 
+    {
+        m *= 0.5;
+        e++;
+    }
+    // log(m) = 2 atanh(s), |s| <= 0.172.
+    double s = (m - 1.0) / (m + 1.0);
+    double s2 = s * s;
+    double p = 1.0 / 17.0;
+    p = p * s2 + 1.0 / 15.0;
+    p = p * s2 + 1.0 / 13.0;
+    p = p * s2 + 1.0 / 11.0;
+    p = p * s2 + 1.0 / 9.0;
+    p = p * s2 + 1.0 / 7.0;
+    p = p * s2 + 1.0 / 5.0;
+    p = p * s2 + 1.0 / 3.0;
+    p = p * s2 + 1.0;
+    return e * 0.6931471805599453 + 2.0 * s * p;
+}
+
+// Draw source for the sampler: straight from the generator, or from a block
+// filled ahead of time. Unread block entries are handed back on completion.
+typedef struct 
+{
+    zrand_rng *rng;
+    uint64_t *buf;
+    size_t pos;
+    size_t len;
+    size_t want;
+} zrand__src;
+
+static void zrand__src_refill(zrand__src *s) 
+{
+    s->len = (s->want < ZRAND_BLOCK) ? s->want : ZRAND_BLOCK;
+    zrand_rng_fill_u64(s->rng, s->buf, s->len);
+    s->pos = 0;
+}
+
+static inline uint64_t zrand__src_u64(zrand__src *s) 
+{
+    if (NULL == s->buf) 
+    {
+        return zrand_rng_u64(s->rng);
+    }
+    if (s->pos == s->len) 
+    {
+        zrand__src_refill(s);
+    }
+    return s->buf[s->pos++];
+}
+
+static inline double zrand__src_f64(zrand__src *s) 
+{
+    return (int64_t)(zrand__src_u64(s) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Layer and signed abscissa from one draw. The top 53 bits fit int64_t,
+// which keeps the conversion a plain signed one.
+static inline double zrand__zig_x(uint64_t b, int *layer) 
+{
+    *layer = (int)(b & 127);
+    return ((int64_t)(b >> 11) * (2.0 / 9007199254740992.0) - 1.0) * ZRAND_ZIG_X[*layer];
+}
+
+// Finishes a sample whose first draw fell outside its layer's rectangle.
+static double zrand__zig_slow(zrand__src *s, int i, double x) 
+{
+    for (;;) 
+    {
+        if (0 == i) 
+        {
+            // Tail beyond R (Marsaglia 1964).
+            double xt, yt;
+            do 
+            {
+                xt = -zrand__log(1.0 - zrand__src_f64(s)) / ZRAND_ZIG_R;
+                yt = -zrand__log(1.0 - zrand__src_f64(s));
+            } while (yt + yt < xt * xt);
+            return (x < 0) ? -(ZRAND_ZIG_R + xt) : (ZRAND_ZIG_R + xt);
+        }
+        double y = ZRAND_ZIG_F[i] + zrand__src_f64(s) * (ZRAND_ZIG_F[i + 1] - ZRAND_ZIG_F[i]);
+        if (y < zrand__exp(-0.5 * x * x)) 
+        {
+            return x;
+        }
+        x = zrand__zig_x(zrand__src_u64(s), &i);
+        if ((x < 0 ? -x : x) < ZRAND_ZIG_X[i + 1]) 
+        {
+            return x;
+        }
+    }
+}
+
+double zrand_rng_normal(zrand_rng *rng, double mean, double stddev) 
+{
+    zrand__src s = {rng, NULL, 0, 0, 0};
+    int i;
+    double x = zrand__zig_x(zrand__src_u64(&s), &i);
+    if ((x < 0 ? -x : x) >= ZRAND_ZIG_X[i + 1]) 
+    {
+        x = zrand__zig_slow(&s, i, x);
+    }
+    return mean + stddev * x;
+}
+
+void zrand_rng_fill_gaussian(zrand_rng *rng, double *out, size_t n, double mean, double stddev) 
+{
+    uint64_t buf[ZRAND_BLOCK];
+    zrand__src s = {rng, buf, 0, 0, 0};
+    size_t k = 0;
+    while (k < n) 
+    {
+        // Roughly 1.02 draws per sample; size refills to what is left.
+        s.want = (n - k) + ((n - k) >> 5) + 2;
+        if (s.pos == s.len) 
+        {
+            zrand__src_refill(&s);
+        }
+        // Rectangle hits stay in locals; only rejections touch the source.
+        size_t pos = s.pos, len = s.len;
+        while (pos < len && k < n) 
+        {
+            int i;
+            double x = zrand__zig_x(buf[pos++], &i);
+            if ((x < 0 ? -x : x) >= ZRAND_ZIG_X[i + 1]) 
+            {
+                s.pos = pos;
+                x = zrand__zig_slow(&s, i, x);
+                pos = s.pos;
+                len = s.len;
+            }
+            out[k++] = mean + stddev * x;
+        }
+        s.pos = pos;
+    }
+    if (s.pos < s.len) 
+    {
+        zrand_rng_advance(rng, (uint64_t)0 - 2 * (uint64_t)(s.len - s.pos));
+    }
+}
+
 #endif //ZRAND_IMPLEMENTATION_GUARD
 #endif // ZRAND_IMPLEMENTATION
@@ -144,6 +144,58 @@
 
 
 #endif // Z_COMMON_BUNDLED
+
+// Runtime allocator handle. Not part of zcommon yet, so it stays outside the bundled block
+// above (regenerated from upstream); every ZDK header carries the same guarded copy.
+#ifndef Z_ALLOCATOR_HANDLE_DEFINED
+#define Z_ALLOCATOR_HANDLE_DEFINED
+
+/* * zalloc_t routes one container's memory through any allocator (arena, pool, ...).
+ * Containers only carry a handle when Z_ALLOCATOR_HANDLE is defined before the first
+ * ZDK include; otherwise they are laid out and compiled exactly as before.
+ * A NULL handle means the compile-time *_MALLOC macros. realloc and free also receive
+ * the old size, for allocators that do not track it.
+ */
+#ifndef Z_ALLOC_T_DEFINED
+#define Z_ALLOC_T_DEFINED
+typedef struct zalloc_t
+{
+    void *(*alloc)(void *ctx, size_t size);
+    void *(*realloc)(void *ctx, void *ptr, size_t old_size, size_t new_size);
+    void  (*free)(void *ctx, void *ptr, size_t size);
+    void *ctx;
+} zalloc_t;
+#endif
+
+#ifdef Z_ALLOCATOR_HANDLE
+#   define Z_ALLOCATOR_FIELD                   const zalloc_t *allocator;
+#   define Z_ALLOCATOR_INIT                    , NULL
+#   define Z_HMALLOC(h, sz, dflt)              ((h) ? (h)->alloc((h)->ctx, (sz)) : (dflt))
+#   define Z_HCALLOC(h, n, sz, dflt)           ((h) ? z_hcalloc__((h), (n), (sz)) : (dflt))
+#   define Z_HREALLOC(h, p, old_sz, sz, dflt)  ((h) ? (h)->realloc((h)->ctx, (p), (old_sz), (sz)) : (dflt))
+#   define Z_HFREE(h, p, sz, dflt)             ((h) ? ((p) ? (h)->free((h)->ctx, (p), (sz)) : (void)0) : (void)(dflt))
+    // Setter for a generated container; call it while the container owns no memory yet.
+#   define Z_GEN_SET_ALLOCATOR(Type, Fn)       static inline void Fn(Type *c, const zalloc_t *a) { c->allocator = a; }
+
+static inline void *z_hcalloc__(const zalloc_t *h, size_t n, size_t sz)
+{
+    if (0 != n && sz > SIZE_MAX / n) return NULL;
+    void *p = h->alloc(h->ctx, n * sz);
+    if (p) memset(p, 0, n * sz);
+    return p;
+}
+#else
+#   define Z_ALLOCATOR_FIELD
+#   define Z_ALLOCATOR_INIT
+#   define Z_HMALLOC(h, sz, dflt)              (dflt)
+#   define Z_HCALLOC(h, n, sz, dflt)           (dflt)
+#   define Z_HREALLOC(h, p, old_sz, sz, dflt)  (dflt)
+#   define Z_HFREE(h, p, sz, dflt)             (dflt)
+#   define Z_GEN_SET_ALLOCATOR(Type, Fn)
+#endif
+
+#endif // Z_ALLOCATOR_HANDLE_DEFINED
+
 /* ============================================================================ */
 
 
@@ -182,18 +234,62 @@ extern "C" {
     #define Z_STR_FREE(p)           Z_FREE(p)
 #endif
 
+// Heap buffers go through the string's zalloc_t handle when it carries one.
+#define ZSTR_HMALLOC__(s, sz)          (char *)Z_HMALLOC((s)->allocator, sz, Z_STR_MALLOC(sz))
+#define ZSTR_HREALLOC__(s, p, old, sz) (char *)Z_HREALLOC((s)->allocator, p, old, sz, Z_STR_REALLOC(p, sz))
+#define ZSTR_HFREE__(s, p, sz)         Z_HFREE((s)->allocator, p, sz, Z_STR_FREE(p))
+
 #if defined(__GNUC__) || defined(__clang__)
     #define ZSTR_PRINTF_ATTR(fmt_idx, var_idx) __attribute__((format(printf, fmt_idx, var_idx)))
 #else
     #define ZSTR_PRINTF_ATTR(fmt_idx, var_idx)
 #endif
 
+// SIMD scanning for search, split and UTF-8 (define ZSTR_NO_SIMD to force the scalar path).
+#if !defined(Z_NO_EXTENSIONS) && !defined(ZSTR_NO_SIMD) && defined(__AVX2__)
+#   include <immintrin.h>
+#   define ZSTR_SIMD_AVX2 1
+#elif !defined(Z_NO_EXTENSIONS) && !defined(ZSTR_NO_SIMD) && \
+      (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#   include <emmintrin.h>
+#   if defined(__SSSE3__)
+#       include <tmmintrin.h>
+#   endif
+#   define ZSTR_SIMD_SSE2 1
+#elif !defined(Z_NO_EXTENSIONS) && !defined(ZSTR_NO_SIMD) && \
+      (defined(__aarch64__) || defined(_M_ARM64))
+#   include <arm_neon.h>
+#   define ZSTR_SIMD_NEON 1
+#endif
+
+#if defined(ZSTR_SIMD_AVX2) || defined(ZSTR_SIMD_SSE2) || defined(ZSTR_SIMD_NEON)
+#   define ZSTR__SIMD 1
+#endif
+
+// UTF-8 validation needs a byte shuffle: SSSE3 (implied by AVX2) or NEON.
+#if defined(ZSTR_SIMD_AVX2) || defined(ZSTR_SIMD_NEON) || (defined(ZSTR_SIMD_SSE2) && defined(__SSSE3__))
+#   define ZSTR__UTF8_LOOKUP 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#   include <intrin.h>
+#endif
+
 // SSO Capacity -> 23 bytes available.
 // Max string length = 23 chars (if using the last byte for length/flag trick) 
 // OR 22 chars + null terminator. We stick to 23 bytes total storage.
 #define ZSTR_SSO_CAP 23
 #define ZSTR_UTF8_INVALID 0xFFFD
 
+// Builder chunks start at ZSTR_BUILDER_CHUNK bytes and double up to ZSTR_BUILDER_CHUNK_MAX.
+#ifndef ZSTR_BUILDER_CHUNK
+#define ZSTR_BUILDER_CHUNK 4096
+#endif
+
+#ifndef ZSTR_BUILDER_CHUNK_MAX
+#define ZSTR_BUILDER_CHUNK_MAX (1024 * 1024)
+#endif
+
 #ifndef ZSTR_FMT
 #define ZSTR_FMT "%.*s"
 #define ZSTR_ARG(s) (int)zstr_len(&(s)), zstr_cstr(&(s))
@@ -227,6 +323,7 @@ typedef struct {
         zstr_long l;
         zstr_short s;
     };
+    Z_ALLOCATOR_FIELD
 } zstr;
 
 // A read-only slice of a string (borrowed reference).
@@ -244,6 +341,503 @@ typedef struct {
     bool finished;
 } zstr_split_iter;
 
+// One link of a builder's chain; the bytes follow the header in the same block.
+typedef struct zstr_chunk
+{
+    struct zstr_chunk *next;
+    size_t len;
+    size_t cap;
+} zstr_chunk;
+
+// Append-only text spread over chained chunks: appends never move earlier bytes.
+typedef struct {
+    zstr_chunk *head;
+    zstr_chunk *tail;
+    size_t len;
+    size_t next_cap;
+    Z_ALLOCATOR_FIELD
+} zstr_builder;
+
+// Interned strings: each distinct content is stored once and gets a dense id.
+typedef struct {
+    const char *data;
+    size_t len;
+    uint32_t hash;
+} zstr_intern_entry;
+
+typedef struct {
+    zstr_builder arena;         // Owns the bytes (and the allocator); chunks never move.
+    zstr_intern_entry *entries; // Indexed by id.
+    uint32_t *slots;            // Open addressing: id + 1, 0 when empty.
+    size_t count;
+    size_t entry_cap;
+    size_t slot_cap;
+} zstr_intern_pool;
+
+
+/* Vectorized Kernels */
+
+// Length-aware scanners behind search, split, replace and the UTF-8 helpers.
+// They never read past data + len, so embedded NULs and unterminated views are fine.
+
+static inline uint32_t zstr__ctz64(uint64_t x)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long i;
+    _BitScanForward64(&i, x);
+    return (uint32_t)i;
+#elif defined(__GNUC__) || defined(__clang__)
+    return (uint32_t)__builtin_ctzll(x);
+#else
+    uint32_t n = 0;
+    while (0 == (x & 1u))
+    {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+// Index of the highest set bit.
+static inline uint32_t zstr__top64(uint64_t x)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long i;
+    _BitScanReverse64(&i, x);
+    return (uint32_t)i;
+#elif defined(__GNUC__) || defined(__clang__)
+    return 63u - (uint32_t)__builtin_clzll(x);
+#else
+    uint32_t n = 63;
+    while (0 == (x >> n))
+    {
+        n--;
+    }
+    return n;
+#endif
+}
+
+static inline uint32_t zstr__popcount64(uint64_t x)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    return (uint32_t)__popcnt64(x);
+#elif defined(__GNUC__) || defined(__clang__)
+    return (uint32_t)__builtin_popcountll(x);
+#else
+    uint32_t n = 0;
+    while (x)
+    {
+        x &= x - 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+#if defined(ZSTR_SIMD_NEON)
+    static inline uint64_t zstr__neon_mask16(uint8x16_t v)
+    {
+        static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128,
+                                             1, 2, 4, 8, 16, 32, 64, 128 };
+        uint8x16_t bits = vandq_u8(v, vld1q_u8(weights));
+        return (uint64_t)vaddv_u8(vget_low_u8(bits)) | ((uint64_t)vaddv_u8(vget_high_u8(bits)) << 8);
+    }
+#endif
+
+#if defined(ZSTR__SIMD)
+// Bitmask of the bytes equal to c over the 64 bytes at p.
+static inline uint64_t zstr__eq64(const char *p, char c)
+{
+#   if defined(ZSTR_SIMD_AVX2)
+    __m256i v = _mm256_set1_epi8(c);
+    uint64_t lo = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), v));
+    uint64_t hi = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + 32)), v));
+    return lo | (hi << 32);
+#   else
+    uint64_t m = 0;
+    for (int i = 0; i < 4; i++)
+    {
+#       if defined(ZSTR_SIMD_SSE2)
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + 16 * i));
+        m |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c))) << (16 * i);
+#       else
+        uint8x16_t v = vld1q_u8((const uint8_t*)p + 16 * i);
+        m |= zstr__neon_mask16(vceqq_u8(v, vdupq_n_u8((uint8_t)c))) << (16 * i);
+#       endif
+    }
+    return m;
+#   endif
+}
+
+// Bitmask of the non-ASCII bytes over the 64 bytes at p.
+static inline uint64_t zstr__high64(const char *p)
+{
+#   if defined(ZSTR_SIMD_AVX2)
+    uint64_t lo = (uint32_t)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*)p));
+    uint64_t hi = (uint32_t)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*)(p + 32)));
+    return lo | (hi << 32);
+#   else
+    uint64_t m = 0;
+    for (int i = 0; i < 4; i++)
+    {
+#       if defined(ZSTR_SIMD_SSE2)
+        m |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(p + 16 * i))) << (16 * i);
+#       else
+        int8x16_t v = vld1q_s8((const int8_t*)p + 16 * i);
+        m |= zstr__neon_mask16(vcltq_s8(v, vdupq_n_s8(0))) << (16 * i);
+#       endif
+    }
+    return m;
+#   endif
+}
+
+// Bitmask of the UTF-8 continuation bytes (10xxxxxx) over the 64 bytes at p.
+static inline uint64_t zstr__cont64(const char *p)
+{
+#   if defined(ZSTR_SIMD_AVX2)
+    __m256i edge = _mm256_set1_epi8(-64);
+    uint64_t lo = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(edge, _mm256_loadu_si256((const __m256i*)p)));
+    uint64_t hi = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(edge, _mm256_loadu_si256((const __m256i*)(p + 32))));
+    return lo | (hi << 32);
+#   else
+    uint64_t m = 0;
+    for (int i = 0; i < 4; i++)
+    {
+#       if defined(ZSTR_SIMD_SSE2)
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + 16 * i));
+        m |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-64), v)) << (16 * i);
+#       else
+        int8x16_t v = vld1q_s8((const int8_t*)p + 16 * i);
+        m |= zstr__neon_mask16(vcltq_s8(v, vdupq_n_s8(-64))) << (16 * i);
+#       endif
+    }
+    return m;
+#   endif
+}
+#endif
+
+// First occurrence of needle in hay: candidates are the positions where both the first
+// and the last needle byte line up, 64 at a time, and only those reach memcmp.
+static inline ptrdiff_t zstr__find(const char *hay, size_t len, const char *needle, size_t n)
+{
+    if (0 == n) return 0;
+    if (n > len) return -1;
+    if (1 == n)
+    {
+        const char *hit = (const char *)memchr(hay, needle[0], len);
+        return hit ? (ptrdiff_t)(hit - hay) : -1;
+    }
+
+    size_t starts = len - n + 1;
+    size_t i = 0;
+#if defined(ZSTR__SIMD)
+    for (; i + 64 <= starts; i += 64)
+    {
+        uint64_t m = zstr__eq64(hay + i, needle[0]) & zstr__eq64(hay + i + n - 1, needle[n - 1]);
+        while (m)
+        {
+            size_t at = i + zstr__ctz64(m);
+            if (0 == memcmp(hay + at + 1, needle + 1, n - 2)) return (ptrdiff_t)at;
+            m &= m - 1;
+        }
+    }
+#endif
+    while (i < starts)
+    {
+        const char *hit = (const char *)memchr(hay + i, needle[0], starts - i);
+        if (!hit) return -1;
+        i = (size_t)(hit - hay);
+        if (needle[n - 1] == hay[i + n - 1] && 0 == memcmp(hay + i + 1, needle + 1, n - 2)) return (ptrdiff_t)i;
+        i++;
+    }
+    return -1;
+}
+
+// Last occurrence of needle in hay, scanning the same filter from the end.
+static inline ptrdiff_t zstr__rfind(const char *hay, size_t len, const char *needle, size_t n)
+{
+    if (n > len) return -1;
+    if (0 == n) return (ptrdiff_t)len;
+
+    size_t end = len - n + 1;
+#if defined(ZSTR__SIMD)
+    for (; end >= 64; end -= 64)
+    {
+        size_t i = end - 64;
+        uint64_t m = zstr__eq64(hay + i, needle[0]) & zstr__eq64(hay + i + n - 1, needle[n - 1]);
+        while (m)
+        {
+            uint32_t bit = zstr__top64(m);
+            if (0 == memcmp(hay + i + bit, needle, n)) return (ptrdiff_t)(i + bit);
+            m &= ~((uint64_t)1 << bit);
+        }
+    }
+#endif
+    while (end-- > 0)
+    {
+        if (needle[0] == hay[end] && 0 == memcmp(hay + end, needle, n)) return (ptrdiff_t)end;
+    }
+    return -1;
+}
+
+// Strict scalar check from a sequence boundary: rejects overlongs, surrogates and
+// anything above U+10FFFF, plus truncated sequences at the end.
+static inline bool zstr__utf8_valid_scalar(const unsigned char *p, size_t len)
+{
+    size_t i = 0;
+    while (i < len)
+    {
+#if defined(ZSTR__SIMD)
+        if (i + 64 <= len && 0 == zstr__high64((const char *)p + i))
+        {
+            i += 64;
+            continue;
+        }
+#endif
+        unsigned char c = p[i];
+        if (c < 0x80)
+        {
+            i++;
+            continue;
+        }
+
+        size_t n;
+        unsigned char lo = 0x80, hi = 0xBF;
+        if (c >= 0xC2 && c <= 0xDF)
+        {
+            n = 2;
+        }
+        else if (c >= 0xE0 && c <= 0xEF)
+        {
+            n = 3;
+            if (0xE0 == c) lo = 0xA0;        // Overlong.
+            else if (0xED == c) hi = 0x9F;   // Surrogate.
+        }
+        else if (c >= 0xF0 && c <= 0xF4)
+        {
+            n = 4;
+            if (0xF0 == c) lo = 0x90;        // Overlong.
+            else if (0xF4 == c) hi = 0x8F;   // > U+10FFFF.
+        }
+        else
+        {
+            return false;
+        }
+
+        if (len - i < n) return false;
+        if (p[i + 1] < lo || p[i + 1] > hi) return false;
+        for (size_t k = 2; k < n; k++)
+        {
+            if (0x80 != (p[i + k] & 0xC0)) return false;
+        }
+        i += n;
+    }
+    return true;
+}
+
+#if defined(ZSTR__UTF8_LOOKUP)
+/*
+ * Table-driven validation (Keiser & Lemire): every error shows up as a bit that
+ * survives ANDing three 16-entry lookups keyed by the high and low nibble of the
+ * previous byte and the high nibble of the current one. The remaining case, a
+ * third or fourth byte that is not a continuation, is caught by comparing the
+ * bytes two and three back against 0xE0 and 0xF0.
+ */
+#define ZSTR__U8_TOO_SHORT  0x01
+#define ZSTR__U8_TOO_LONG   0x02
+#define ZSTR__U8_OVERLONG_3 0x04
+#define ZSTR__U8_TOO_LARGE  0x08
+#define ZSTR__U8_SURROGATE  0x10
+#define ZSTR__U8_OVERLONG_2 0x20
+#define ZSTR__U8_TOO_LARGE_1000 0x40
+#define ZSTR__U8_OVERLONG_4 0x40
+#define ZSTR__U8_TWO_CONTS  0x80
+#define ZSTR__U8_CARRY      (ZSTR__U8_TOO_SHORT | ZSTR__U8_TOO_LONG | ZSTR__U8_TWO_CONTS)
+
+static const uint8_t zstr__u8_prev_high[16] = {
+    ZSTR__U8_TOO_LONG, ZSTR__U8_TOO_LONG, ZSTR__U8_TOO_LONG, ZSTR__U8_TOO_LONG,
+    ZSTR__U8_TOO_LONG, ZSTR__U8_TOO_LONG, ZSTR__U8_TOO_LONG, ZSTR__U8_TOO_LONG,
+    ZSTR__U8_TWO_CONTS, ZSTR__U8_TWO_CONTS, ZSTR__U8_TWO_CONTS, ZSTR__U8_TWO_CONTS,
+    ZSTR__U8_TOO_SHORT | ZSTR__U8_OVERLONG_2,
+    ZSTR__U8_TOO_SHORT,
+    ZSTR__U8_TOO_SHORT | ZSTR__U8_OVERLONG_3 | ZSTR__U8_SURROGATE,
+    ZSTR__U8_TOO_SHORT | ZSTR__U8_TOO_LARGE | ZSTR__U8_TOO_LARGE_1000 | ZSTR__U8_OVERLONG_4
+};
+
+static const uint8_t zstr__u8_prev_low[16] = {
+    ZSTR__U8_CARRY | ZSTR__U8_OVERLONG_3 | ZSTR__U8_OVERLONG_2 | ZSTR__U8_OVERLONG_4,
+    ZSTR__U8_CARRY | ZSTR__U8_OVERLONG_2,
+    ZSTR__U8_CARRY,
+    ZSTR__U8_CARRY,
+    ZSTR__U8_CARRY | ZSTR__U8_TOO_LARGE,
+    ZSTR__U8_CARRY | ZSTR__U8_TOO_LARGE | ZSTR__U8_TOO_LARGE_1000,
+    ZSTR__U8_CARRY | ZSTR__U8_TOO_LARGE | ZSTR__U8_TOO_LARGE_1000,
+    ZSTR__U8_CARRY | ZSTR__U8_TOO_LARGE | ZSTR__U8_TOO_LARGE_1000,
+    ZSTR__U8_CARRY | ZSTR__U8_TOO_LARGE | ZSTR__U8_TOO_LARGE_1000,
+    ZSTR__U8_CARRY | ZSTR__U8_TOO_LARGE | ZSTR__U8_TOO_LARGE_1000,
+    ZSTR__U8_CARRY | ZSTR__U8_TOO_LARGE | ZSTR__U8_TOO_LARGE_1000,
+    ZSTR__U8_CARRY | ZSTR__U8_TOO_LARGE | ZSTR__U8_TOO_LARGE_1000,
+    ZSTR__U8_CARRY | ZSTR__U8_TOO_LARGE | ZSTR__U8_TOO_LARGE_1000,
+    ZSTR__U8_CARRY | ZSTR__U8_TOO_LARGE | ZSTR__U8_TOO_LARGE_1000 | ZSTR__U8_SURROGATE,
+    ZSTR__U8_CARRY | ZSTR__U8_TOO_LARGE | ZSTR__U8_TOO_LARGE_1000,
+    ZSTR__U8_CARRY | ZSTR__U8_TOO_LARGE | ZSTR__U8_TOO_LARGE_1000
+};
+
+static const uint8_t zstr__u8_cur_high[16] = {
+    ZSTR__U8_TOO_SHORT, ZSTR__U8_TOO_SHORT, ZSTR__U8_TOO_SHORT, ZSTR__U8_TOO_SHORT,
+    ZSTR__U8_TOO_SHORT, ZSTR__U8_TOO_SHORT, ZSTR__U8_TOO_SHORT, ZSTR__U8_TOO_SHORT,
+    ZSTR__U8_TOO_LONG | ZSTR__U8_OVERLONG_2 | ZSTR__U8_TWO_CONTS | ZSTR__U8_OVERLONG_3 |
+        ZSTR__U8_TOO_LARGE_1000 | ZSTR__U8_OVERLONG_4,
+    ZSTR__U8_TOO_LONG | ZSTR__U8_OVERLONG_2 | ZSTR__U8_TWO_CONTS | ZSTR__U8_OVERLONG_3 | ZSTR__U8_TOO_LARGE,
+    ZSTR__U8_TOO_LONG | ZSTR__U8_OVERLONG_2 | ZSTR__U8_TWO_CONTS | ZSTR__U8_SURROGATE | ZSTR__U8_TOO_LARGE,
+    ZSTR__U8_TOO_LONG | ZSTR__U8_OVERLONG_2 | ZSTR__U8_TWO_CONTS | ZSTR__U8_SURROGATE | ZSTR__U8_TOO_LARGE,
+    ZSTR__U8_TOO_SHORT, ZSTR__U8_TOO_SHORT, ZSTR__U8_TOO_SHORT, ZSTR__U8_TOO_SHORT
+};
+
+// Largest byte values the last three positions may hold without leaving a sequence open.
+static const uint8_t zstr__u8_tail_max[16] = {
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0xEF, 0xDF, 0xBF
+};
+
+#   if defined(ZSTR_SIMD_NEON)
+    typedef uint8x16_t zstr__v16;
+
+    static inline zstr__v16 zstr__v16_load(const char *p) { return vld1q_u8((const uint8_t *)p); }
+    static inline zstr__v16 zstr__v16_zero(void)          { return vdupq_n_u8(0); }
+    static inline zstr__v16 zstr__v16_or(zstr__v16 a, zstr__v16 b) { return vorrq_u8(a, b); }
+    static inline bool zstr__v16_any(zstr__v16 v)         { return 0 != vmaxvq_u8(v); }
+
+    static inline zstr__v16 zstr__v16_open(zstr__v16 prev)
+    {
+        return vqsubq_u8(prev, vld1q_u8(zstr__u8_tail_max));
+    }
+
+    static inline zstr__v16 zstr__utf8_check16(zstr__v16 in, zstr__v16 prev)
+    {
+        uint8x16_t prev1 = vextq_u8(prev, in, 15);
+        uint8x16_t sc = vandq_u8(vandq_u8(vqtbl1q_u8(vld1q_u8(zstr__u8_prev_high), vshrq_n_u8(prev1, 4)),
+                                          vqtbl1q_u8(vld1q_u8(zstr__u8_prev_low), vandq_u8(prev1, vdupq_n_u8(0x0F)))),
+                                 vqtbl1q_u8(vld1q_u8(zstr__u8_cur_high), vshrq_n_u8(in, 4)));
+        uint8x16_t third  = vqsubq_u8(vextq_u8(prev, in, 14), vdupq_n_u8(0xE0 - 0x80));
+        uint8x16_t fourth = vqsubq_u8(vextq_u8(prev, in, 13), vdupq_n_u8(0xF0 - 0x80));
+        uint8x16_t must23 = vandq_u8(vorrq_u8(third, fourth), vdupq_n_u8(0x80));
+        return veorq_u8(must23, sc);
+    }
+#   else
+    typedef __m128i zstr__v16;
+
+    static inline zstr__v16 zstr__v16_load(const char *p) { return _mm_loadu_si128((const __m128i *)p); }
+    static inline zstr__v16 zstr__v16_zero(void)          { return _mm_setzero_si128(); }
+    static inline zstr__v16 zstr__v16_or(zstr__v16 a, zstr__v16 b) { return _mm_or_si128(a, b); }
+    static inline bool zstr__v16_any(zstr__v16 v)
+    {
+        return 0xFFFF != _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()));
+    }
+
+    static inline zstr__v16 zstr__v16_open(zstr__v16 prev)
+    {
+        return _mm_subs_epu8(prev, _mm_loadu_si128((const __m128i *)zstr__u8_tail_max));
+    }
+
+    static inline zstr__v16 zstr__utf8_check16(zstr__v16 in, zstr__v16 prev)
+    {
+        __m128i nib = _mm_set1_epi8(0x0F);
+        __m128i prev1 = _mm_alignr_epi8(in, prev, 15);
+        __m128i sc = _mm_and_si128(
+            _mm_and_si128(
+                _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)zstr__u8_prev_high),
+                                 _mm_and_si128(_mm_srli_epi16(prev1, 4), nib)),
+                _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)zstr__u8_prev_low),
+                                 _mm_and_si128(prev1, nib))),
+            _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)zstr__u8_cur_high),
+                             _mm_and_si128(_mm_srli_epi16(in, 4), nib)));
+        __m128i third  = _mm_subs_epu8(_mm_alignr_epi8(in, prev, 14), _mm_set1_epi8((char)(0xE0 - 0x80)));
+        __m128i fourth = _mm_subs_epu8(_mm_alignr_epi8(in, prev, 13), _mm_set1_epi8((char)(0xF0 - 0x80)));
+        __m128i must23 = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8((char)0x80));
+        return _mm_xor_si128(must23, sc);
+    }
+#   endif
+#endif
+
+// Strict UTF-8 validation of len bytes at p.
+static inline bool zstr__utf8_valid(const char *p, size_t len)
+{
+#if defined(ZSTR__UTF8_LOOKUP)
+    zstr__v16 prev = zstr__v16_zero();
+    zstr__v16 err = zstr__v16_zero();
+    char pad[64];
+
+    // The zero-padded last block turns a truncated sequence into a TOO_SHORT error.
+    for (size_t i = 0; i < len; i += 64)
+    {
+        const char *block = p + i;
+        if (len - i < 64)
+        {
+            memset(pad, 0, sizeof(pad));
+            memcpy(pad, p + i, len - i);
+            block = pad;
+        }
+
+        if (0 == zstr__high64(block))
+        {
+            err = zstr__v16_or(err, zstr__v16_open(prev));
+            prev = zstr__v16_load(block + 48);
+        }
+        else
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                zstr__v16 in = zstr__v16_load(block + 16 * k);
+                err = zstr__v16_or(err, zstr__utf8_check16(in, prev));
+                prev = in;
+            }
+            if (zstr__v16_any(err)) return false;
+        }
+    }
+    err = zstr__v16_or(err, zstr__v16_open(prev));
+    return !zstr__v16_any(err);
+#else
+    return zstr__utf8_valid_scalar((const unsigned char *)p, len);
+#endif
+}
+
+// Rune count with the zstr_next_rune rules: a malformed byte counts as one rune.
+static inline size_t zstr__count_runes(const char *p, size_t len)
+{
+    // Valid text has exactly one rune per byte that is not a continuation byte.
+    if (zstr__utf8_valid(p, len))
+    {
+        size_t cont = 0;
+        size_t i = 0;
+#if defined(ZSTR__SIMD)
+        for (; i + 64 <= len; i += 64)
+        {
+            cont += zstr__popcount64(zstr__cont64(p + i));
+        }
+#endif
+        for (; i < len; i++)
+        {
+            cont += (0x80 == ((unsigned char)p[i] & 0xC0));
+        }
+        return len - cont;
+    }
+
+    const unsigned char *u = (const unsigned char *)p;
+    size_t count = 0;
+    size_t i = 0;
+    while (i < len)
+    {
+        unsigned char c = u[i];
+        size_t n = (c < 0x80) ? 1 : ((c & 0xE0) == 0xC0) ? 2 : ((c & 0xF0) == 0xE0) ? 3 : ((c & 0xF8) == 0xF0) ? 4 : 1;
+        size_t k = 1;
+        while (k < n && i + k < len && 0x80 == (u[i + k] & 0xC0)) k++;
+        i += (k == n) ? n : 1;
+        count++;
+    }
+    return count;
+}
+
 
 /* Internal Helpers and Accessors */
 
@@ -288,11 +882,26 @@ static inline zstr zstr_init(void)
     return s;
 }
 
+// Empties the struct but keeps its allocator handle.
+static inline void zstr_reset__(zstr *s)
+{
+#ifdef Z_ALLOCATOR_HANDLE
+    const zalloc_t *a = s->allocator;
+    *s = zstr_init();
+    s->allocator = a;
+#else
+    *s = zstr_init();
+#endif
+}
+
+// Routes s's heap buffer through a (Z_ALLOCATOR_HANDLE only); s must not be on the heap yet.
+Z_GEN_SET_ALLOCATOR(zstr, zstr_set_allocator)
+
 // Frees the string if it is on the heap, and resets it to empty.
 static inline void zstr_free(zstr *s)
 {
-    if (s->is_long) Z_STR_FREE(s->l.ptr);
-    *s = zstr_init();
+    if (s->is_long) ZSTR_HFREE__(s, s->l.ptr, s->l.cap + 1);
+    zstr_reset__(s);
 }
 
 // Clears the content (sets length to 0) but keeps the allocated capacity.
@@ -323,11 +932,11 @@ static inline int zstr_reserve(zstr *s, size_t new_cap)
     char *new_ptr;
     if (s->is_long)
     {
-        new_ptr = Z_STR_REALLOC(s->l.ptr, new_cap + 1);
+        new_ptr = ZSTR_HREALLOC__(s, s->l.ptr, s->l.cap + 1, new_cap + 1);
     }
     else 
     {
-        new_ptr = Z_STR_MALLOC(new_cap + 1);
+        new_ptr = ZSTR_HMALLOC__(s, new_cap + 1);
         if (new_ptr)
         {
             memcpy(new_ptr, s->s.buf, s->s.len);
@@ -374,7 +983,7 @@ static inline void zstr_shrink_to_fit(zstr *s)
         temp[s->l.len] = '\0';
 
         uint8_t old_len = (uint8_t)s->l.len;
-        Z_STR_FREE(s->l.ptr);
+        ZSTR_HFREE__(s, s->l.ptr, s->l.cap + 1);
 
         s->is_long = 0;
         memcpy(s->s.buf, temp, old_len + 1);
@@ -384,7 +993,7 @@ static inline void zstr_shrink_to_fit(zstr *s)
 
     if (s->l.len < s->l.cap)
     {
-        char *new_ptr = Z_STR_REALLOC(s->l.ptr, s->l.len + 1);
+        char *new_ptr = ZSTR_HREALLOC__(s, s->l.ptr, s->l.cap + 1, s->l.len + 1);
         if (new_ptr)
         {
             s->l.ptr = new_ptr;
@@ -460,22 +1069,29 @@ static inline char* zstr_take(zstr *s)
 {
     char *ptr;
 
+#ifdef Z_ALLOCATOR_HANDLE
+    if (s->is_long && !s->allocator)
+#else
     if (s->is_long)
+#endif
     {
         ptr = s->l.ptr;
     }
     else
     {
-        ptr = Z_STR_MALLOC(s->s.len + 1);
+        // Short strings (and handle-backed ones) are copied out to a plain malloc'd buffer.
+        size_t len = zstr_len(s);
+        ptr = Z_STR_MALLOC(len + 1);
         if (ptr)
         {
-            memcpy(ptr, s->s.buf, s->s.len);
-            ptr[s->s.len] = '\0';
+            memcpy(ptr, zstr_cstr(s), len);
+            ptr[len] = '\0';
         }
+        zstr_free(s);
     }
     
     // Reset the source struct so it doesn't double-free.
-    *s = zstr_init();
+    zstr_reset__(s);
     return ptr;
 }
 
@@ -702,61 +1318,104 @@ static inline void zstr_trim(zstr *s)
     else s->s.len = (uint8_t)final_len;
 }
 
-// Replaces all occurrences of "target" with "replacement". 
-// This may reallocate the string if the size grows.
-static inline int zstr_replace(zstr *s, const char *target, const char *replacement)
+// Replaces all non-overlapping occurrences of "target" with "replacement".
+// Shrinking replacements compact in place; growing ones record the match offsets in
+// one scan, reserve the final size once and fill from the back; the offset list
+// spills to s's allocator past 64 matches. Neither view may point into s itself.
+static inline int zstr_replace_view(zstr *s, zstr_view target, zstr_view replacement)
 {
-    if (!target || !*target) return Z_ERR;
-    
-    char *src = zstr_data(s);
-    char *p = strstr(src, target);
-    
-    if (!p) return Z_OK;
+    if (0 == target.len) return Z_ERR;
 
-    size_t target_len = strlen(target);
-    size_t repl_len = strlen(replacement);
-    size_t count = 0;
+    char *src = zstr_data(s);
+    size_t len = zstr_len(s);
+    ptrdiff_t at = zstr__find(src, len, target.data, target.len);
+    if (at < 0) return Z_OK;
 
-    char *scan = src;
-    while ((scan = strstr(scan, target)) != NULL) 
+    size_t new_len;
+    if (replacement.len <= target.len)
     {
-        count++;
-        scan += target_len;
+        size_t rd = 0, wr = 0;
+        while (at >= 0)
+        {
+            size_t hit = rd + (size_t)at;
+            memmove(src + wr, src + rd, hit - rd);
+            wr += hit - rd;
+            memcpy(src + wr, replacement.data, replacement.len);
+            wr += replacement.len;
+            rd = hit + target.len;
+            at = zstr__find(src + rd, len - rd, target.data, target.len);
+        }
+        memmove(src + wr, src + rd, len - rd);
+        new_len = wr + (len - rd);
     }
+    else
+    {
+        size_t local[64];
+        size_t *hits = local;
+        size_t cap = sizeof(local) / sizeof(local[0]);
+        size_t count = 0;
+        size_t rd = 0;
+        while (at >= 0)
+        {
+            if (count == cap)
+            {
+                size_t *grown = (size_t *)(void *)ZSTR_HMALLOC__(s, cap * 2 * sizeof(size_t));
+                if (!grown)
+                {
+                    if (hits != local) ZSTR_HFREE__(s, (char *)hits, cap * sizeof(size_t));
+                    return Z_ERR;
+                }
+                memcpy(grown, hits, count * sizeof(size_t));
+                if (hits != local) ZSTR_HFREE__(s, (char *)hits, cap * sizeof(size_t));
+                hits = grown;
+                cap *= 2;
+            }
+            hits[count++] = rd + (size_t)at;
+            rd += (size_t)at + target.len;
+            at = zstr__find(src + rd, len - rd, target.data, target.len);
+        }
 
-    size_t old_len = zstr_len(s);
-    size_t new_len = old_len + (count * (repl_len - target_len));
-
-    zstr res = zstr_init();
-    if (zstr_reserve(&res, new_len) != Z_OK) return Z_ERR; 
+        size_t grow = replacement.len - target.len;
+        if (grow > (SIZE_MAX - len) / count || zstr_reserve(s, len + count * grow) != Z_OK)
+        {
+            if (hits != local) ZSTR_HFREE__(s, (char *)hits, cap * sizeof(size_t));
+            return Z_ERR;
+        }
+        new_len = len + count * grow;
 
-    char *dest = zstr_data(&res);
-    char *curr_src = src;
-    char *curr_dest = dest;
-    
-    while ((p = strstr(curr_src, target)) != NULL)
-    {
-        size_t segment_len = p - curr_src;
-        memcpy(curr_dest, curr_src, segment_len);
-        curr_dest += segment_len;
-        
-        memcpy(curr_dest, replacement, repl_len);
-        curr_dest += repl_len;
-        
-        curr_src = p + target_len;
+        // Back to front, so every segment moves right into bytes already consumed.
+        src = zstr_data(s);
+        size_t wr = new_len;
+        rd = len;
+        for (size_t k = count; k-- > 0; )
+        {
+            size_t tail = rd - (hits[k] + target.len);
+            wr -= tail;
+            memmove(src + wr, src + hits[k] + target.len, tail);
+            wr -= replacement.len;
+            memcpy(src + wr, replacement.data, replacement.len);
+            rd = hits[k];
+        }
+        if (hits != local) ZSTR_HFREE__(s, (char *)hits, cap * sizeof(size_t));
     }
 
-    strcpy(curr_dest, curr_src);
-    
-    if (res.is_long) res.l.len = new_len;
-    else res.s.len = (uint8_t)new_len;
-
-    zstr_free(s);
-    *s = res;
+    src[new_len] = '\0';
+    if (s->is_long) s->l.len = new_len;
+    else s->s.len = (uint8_t)new_len;
 
     return Z_OK;
 }
 
+// Replaces all occurrences of "target" with "replacement". 
+// This may reallocate the string if the size grows.
+static inline int zstr_replace(zstr *s, const char *target, const char *replacement)
+{
+    if (!target || !*target) return Z_ERR;
+    zstr_view t = { target, strlen(target) };
+    zstr_view r = { replacement ? replacement : "", replacement ? strlen(replacement) : 0 };
+    return zstr_replace_view(s, t, r);
+}
+
 
 /* Comparison */
 
@@ -798,10 +1457,13 @@ static inline int zstr_cmp(const zstr *a, const zstr *b)
 // Returns the index of the first occurrence of needle, or -1 if not found.
 static inline ptrdiff_t zstr_find(const zstr *s, const char *needle)
 {
-    const char *data = zstr_cstr(s);
-    const char *found = strstr(data, needle);
-    if (!found) return -1;
-    return (ptrdiff_t)(found - data);
+    return zstr__find(zstr_cstr(s), zstr_len(s), needle, strlen(needle));
+}
+
+// Returns the index of the last occurrence of needle, or -1 if not found.
+static inline ptrdiff_t zstr_rfind(const zstr *s, const char *needle)
+{
+    return zstr__rfind(zstr_cstr(s), zstr_len(s), needle, strlen(needle));
 }
 
 // Returns true if the string contains the substring.
@@ -870,64 +1532,14 @@ static inline uint32_t zstr_next_rune(const char **p)
 // Counts the number of actual UTF-8 Runes, not bytes.
 static inline size_t zstr_count_runes(const zstr *s)
 {
-    const char *ptr = zstr_cstr(s);
-    size_t count = 0;
-    while (*ptr)
-    {
-        zstr_next_rune(&ptr);
-        count++;   
-    }
-    return count;
+    return zstr__count_runes(zstr_cstr(s), zstr_len(s));
 }
 
 // Validates that the string is strictly valid UTF-8.
 // Rejects Overlong encodings, Surrogates, and out-of-bounds values.
 static inline bool zstr_is_valid_utf8(const zstr *s)
 {
-    const unsigned char *p = (const unsigned char *)zstr_cstr(s);
-    while (*p)
-    {
-        if (*p < 0x80) 
-        {
-            p++; 
-        } 
-        else if ((*p & 0xE0) == 0xC0) // 2-byte.
-        {
-            if (*p < 0xC2) return false; // Overlong.
-            p++;
-            if ((*p & 0xC0) != 0x80) return false; 
-            p++;
-        } 
-        else if ((*p & 0xF0) == 0xE0) // 3-byte.
-        {
-            unsigned char b1 = *p++;
-            unsigned char b2 = *p++;
-            if ((*p & 0xC0) != 0x80) return false; 
-            
-            if (b1 == 0xE0 && b2 < 0xA0) return false; // Overlong.
-            if (b1 == 0xED && b2 >= 0xA0) return false; // Surrogate.
-            if ((b2 & 0xC0) != 0x80) return false;
-            p++;
-        } 
-        else if ((*p & 0xF8) == 0xF0) // 4-byte.
-        {
-            unsigned char b1 = *p++;
-            if (b1 > 0xF4) return false; // > U+10FFFF.
-            
-            unsigned char b2 = *p++;
-            if (b1 == 0xF0 && b2 < 0x90) return false; // Overlong.
-            if (b1 == 0xF4 && b2 >= 0x90) return false; // > U+10FFFF.
-            if ((b2 & 0xC0) != 0x80) return false;
-
-            if ((*p++ & 0xC0) != 0x80) return false; 
-            if ((*p++ & 0xC0) != 0x80) return false; 
-        } 
-        else 
-        {
-            return false;
-        }
-    }
-    return true;
+    return zstr__utf8_valid(zstr_cstr(s), zstr_len(s));
 }
 
 
@@ -976,6 +1588,51 @@ static inline bool zstr_view_eq_view(zstr_view a, zstr_view b)
     return memcmp(a.data, b.data, a.len) == 0;
 }
 
+// Returns the index of the first occurrence of needle in v, or -1 if not found.
+static inline ptrdiff_t zstr_view_find(zstr_view v, zstr_view needle)
+{
+    return zstr__find(v.data, v.len, needle.data, needle.len);
+}
+
+// Returns the index of the last occurrence of needle in v, or -1 if not found.
+static inline ptrdiff_t zstr_view_rfind(zstr_view v, zstr_view needle)
+{
+    return zstr__rfind(v.data, v.len, needle.data, needle.len);
+}
+
+// Returns true if v contains needle.
+static inline bool zstr_view_contains(zstr_view v, zstr_view needle)
+{
+    return zstr__find(v.data, v.len, needle.data, needle.len) != -1;
+}
+
+// Counts the non-overlapping occurrences of needle in v (0 for an empty needle).
+static inline size_t zstr_view_count(zstr_view v, zstr_view needle)
+{
+    if (0 == needle.len) return 0;
+    size_t count = 0;
+    size_t pos = 0;
+    ptrdiff_t at;
+    while ((at = zstr__find(v.data + pos, v.len - pos, needle.data, needle.len)) >= 0)
+    {
+        count++;
+        pos += (size_t)at + needle.len;
+    }
+    return count;
+}
+
+// Counts the UTF-8 runes in v, not bytes.
+static inline size_t zstr_view_count_runes(zstr_view v)
+{
+    return zstr__count_runes(v.data, v.len);
+}
+
+// Validates that v is strictly valid UTF-8.
+static inline bool zstr_view_is_valid_utf8(zstr_view v)
+{
+    return zstr__utf8_valid(v.data, v.len);
+}
+
 // Checks if view starts with prefix.
 static inline bool zstr_view_starts_with(zstr_view v, const char *prefix) 
 {
@@ -1080,33 +1737,434 @@ static inline bool zstr_split_next(zstr_split_iter *it, zstr_view *out_part)
     const char *start = it->source.data + it->current_pos;
     size_t remaining = it->source.len - it->current_pos;
     
-    size_t found_at = remaining;
-    
-    for (size_t i = 0; i <= remaining - it->delim.len; i++) 
-    {
-        if (memcmp(start + i, it->delim.data, it->delim.len) == 0) 
-        {
-            found_at = i;
-            break;
-        }
-    }
+    // An empty delimiter never matches, so the whole source comes back as one part.
+    ptrdiff_t found_at = it->delim.len ? zstr__find(start, remaining, it->delim.data, it->delim.len) : -1;
 
-    if (found_at == remaining) 
+    if (found_at < 0) 
     {
         *out_part = (zstr_view){ .data = start, .len = remaining };
         it->finished = true;
     }
     else 
     {
-        *out_part = (zstr_view){ .data = start, .len = found_at };
-        it->current_pos += found_at + it->delim.len;
+        *out_part = (zstr_view){ .data = start, .len = (size_t)found_at };
+        it->current_pos += (size_t)found_at + it->delim.len;
     }
     
     return true;
 }
 
+
+/* Builder (Chained Chunks) */
+
+// Creates an empty builder; the first append allocates a chunk.
+static inline zstr_builder zstr_builder_init(void)
+{
+    zstr_builder b;
+    memset(&b, 0, sizeof(zstr_builder));
+    return b;
+}
+
+// Routes b's chunks through a (Z_ALLOCATOR_HANDLE only); b must be empty.
+Z_GEN_SET_ALLOCATOR(zstr_builder, zstr_builder_set_allocator)
+
+static inline char *zstr_chunk_data__(zstr_chunk *c)
+{
+    return (char *)(c + 1);
+}
+
+// Links a new tail chunk with room for at least `need` bytes.
+static inline zstr_chunk *zstr_builder_grow__(zstr_builder *b, size_t need)
+{
+    size_t base = b->next_cap ? b->next_cap : ZSTR_BUILDER_CHUNK;
+    size_t cap = base < need ? need : base;
+    if (cap > SIZE_MAX - sizeof(zstr_chunk)) return NULL;
+
+    zstr_chunk *c = (zstr_chunk *)ZSTR_HMALLOC__(b, sizeof(zstr_chunk) + cap);
+    if (!c) return NULL;
+
+    c->next = NULL;
+    c->len = 0;
+    c->cap = cap;
+    if (b->tail) b->tail->next = c;
+    else b->head = c;
+    b->tail = c;
+
+    b->next_cap = (base >= ZSTR_BUILDER_CHUNK_MAX / 2) ? ZSTR_BUILDER_CHUNK_MAX : base * 2;
+    return c;
+}
+
+// Frees every chunk and resets the builder (the allocator handle is kept).
+static inline void zstr_builder_free(zstr_builder *b)
+{
+    zstr_chunk *c = b->head;
+    while (c)
+    {
+        zstr_chunk *next = c->next;
+        ZSTR_HFREE__(b, (char *)c, sizeof(zstr_chunk) + c->cap);
+        c = next;
+    }
+    b->head = b->tail = NULL;
+    b->len = 0;
+    b->next_cap = 0;
+}
+
+// Empties the builder but keeps its first chunk for reuse.
+static inline void zstr_builder_clear(zstr_builder *b)
+{
+    if (!b->head) return;
+
+    zstr_chunk *c = b->head->next;
+    while (c)
+    {
+        zstr_chunk *next = c->next;
+        ZSTR_HFREE__(b, (char *)c, sizeof(zstr_chunk) + c->cap);
+        c = next;
+    }
+    b->head->next = NULL;
+    b->head->len = 0;
+    b->tail = b->head;
+    b->len = 0;
+}
+
+// Total number of bytes appended.
+static inline size_t zstr_builder_len(const zstr_builder *b)
+{
+    return b->len;
+}
+
+// Appends len bytes. Fills the tail chunk first, so earlier bytes never move.
+static inline int zstr_builder_cat_len(zstr_builder *b, const char *src, size_t len)
+{
+    zstr_chunk *c = b->tail;
+    if (c && c->len < c->cap && len)
+    {
+        size_t n = (len < c->cap - c->len) ? len : c->cap - c->len;
+        memcpy(zstr_chunk_data__(c) + c->len, src, n);
+        c->len += n;
+        b->len += n;
+        src += n;
+        len -= n;
+    }
+
+    if (0 == len) return Z_OK;
+
+    c = zstr_builder_grow__(b, len);
+    if (!c) return Z_ERR;
+    memcpy(zstr_chunk_data__(c), src, len);
+    c->len = len;
+    b->len += len;
+    return Z_OK;
+}
+
+// Appends a C-string.
+static inline int zstr_builder_cat(zstr_builder *b, const char *cstr)
+{
+    return zstr_builder_cat_len(b, cstr, strlen(cstr));
+}
+
+// Appends the bytes of a view.
+static inline int zstr_builder_cat_view(zstr_builder *b, zstr_view v)
+{
+    return zstr_builder_cat_len(b, v.data, v.len);
+}
+
+// Appends a single character.
+static inline int zstr_builder_push_char(zstr_builder *b, char ch)
+{
+    zstr_chunk *c = b->tail;
+    if (c && c->len < c->cap)
+    {
+        zstr_chunk_data__(c)[c->len++] = ch;
+        b->len++;
+        return Z_OK;
+    }
+    return zstr_builder_cat_len(b, &ch, 1);
+}
+
+// Returns n contiguous writable bytes at the end, or NULL on allocation failure.
+// Nothing is appended until zstr_builder_commit() says how many were used.
+static inline char *zstr_builder_reserve(zstr_builder *b, size_t n)
+{
+    zstr_chunk *c = b->tail;
+    if (!c || c->cap - c->len < n)
+    {
+        c = zstr_builder_grow__(b, n);
+        if (!c) return NULL;
+    }
+    return zstr_chunk_data__(c) + c->len;
+}
+
+// Keeps the first n bytes written through zstr_builder_reserve().
+static inline void zstr_builder_commit(zstr_builder *b, size_t n)
+{
+    b->tail->len += n;
+    b->len += n;
+}
+
+// Appends formatted text, straight into the tail chunk when it fits.
+ZSTR_PRINTF_ATTR(2, 3)
+static inline int zstr_builder_fmt(zstr_builder *b, const char *fmt, ...)
+{
+    zstr_chunk *c = b->tail;
+    size_t room = c ? c->cap - c->len : 0;
+
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(room ? zstr_chunk_data__(c) + c->len : NULL, room, fmt, args);
+    va_end(args);
+
+    if (len < 0) return Z_ERR;
+    if ((size_t)len >= room)
+    {
+        // vsnprintf wants room for its NUL, which the chunk then simply does not count.
+        char *dst = zstr_builder_reserve(b, (size_t)len + 1);
+        if (!dst) return Z_ERR;
+        va_start(args, fmt);
+        vsnprintf(dst, (size_t)len + 1, fmt, args);
+        va_end(args);
+    }
+    zstr_builder_commit(b, (size_t)len);
+    return Z_OK;
+}
+
+// Fills `out` with up to `max` views of the non-empty chunks, in order, for writev-style
+// output without materializing. Returns the number of views needed for the whole content.
+static inline size_t zstr_builder_views(const zstr_builder *b, zstr_view *out, size_t max)
+{
+    size_t n = 0;
+    for (zstr_chunk *c = b->head; c; c = c->next)
+    {
+        if (0 == c->len) continue;
+        if (n < max) out[n] = (zstr_view){ .data = zstr_chunk_data__(c), .len = c->len };
+        n++;
+    }
+    return n;
+}
+
+// Writes the content to f chunk by chunk.
+static inline int zstr_builder_write_file(const zstr_builder *b, FILE *f)
+{
+    for (zstr_chunk *c = b->head; c; c = c->next)
+    {
+        if (c->len && fwrite(zstr_chunk_data__(c), 1, c->len, f) != c->len) return Z_ERR;
+    }
+    return Z_OK;
+}
+
+// Materializes the content into one zstr sized exactly once (empty on allocation failure).
+static inline zstr zstr_builder_to_str(const zstr_builder *b)
+{
+    zstr s = zstr_init();
+#ifdef Z_ALLOCATOR_HANDLE
+    s.allocator = b->allocator;
+#endif
+    if (zstr_reserve(&s, b->len) != Z_OK) return s;
+
+    char *dst = zstr_data(&s);
+    for (zstr_chunk *c = b->head; c; c = c->next)
+    {
+        memcpy(dst, zstr_chunk_data__(c), c->len);
+        dst += c->len;
+    }
+    *dst = '\0';
+
+    if (s.is_long) s.l.len = b->len;
+    else s.s.len = (uint8_t)b->len;
+    return s;
+}
+
+
+/* Interning */
+
+// Seedless 32-bit content hash for the intern table (stable within one process).
+static inline uint32_t zstr__hash(const char *p, size_t len)
+{
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ ((uint64_t)len * 0xC2B2AE3D27D4EB4Full);
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        uint64_t w;
+        memcpy(&w, p + i, 8);
+        h = (h ^ w) * 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 31;
+    }
+
+    uint64_t w = 0;
+    if (i < len) memcpy(&w, p + i, len - i);
+    h = (h ^ w) * 0x94D049BB133111EBull;
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 32;
+    return (uint32_t)h;
+}
+
+// Creates an empty pool; the first intern allocates.
+static inline zstr_intern_pool zstr_intern_init(void)
+{
+    zstr_intern_pool p;
+    memset(&p, 0, sizeof(zstr_intern_pool));
+    return p;
+}
+
+#ifdef Z_ALLOCATOR_HANDLE
+// Routes all of p's memory through a; p must be empty.
+static inline void zstr_intern_set_allocator(zstr_intern_pool *p, const zalloc_t *a)
+{
+    p->arena.allocator = a;
+}
+#endif
+
+// Frees the table and every interned string; views handed out become invalid.
+static inline void zstr_intern_free(zstr_intern_pool *p)
+{
+    zstr_builder *a = &p->arena;
+    Z_HFREE(a->allocator, p->entries, p->entry_cap * sizeof(zstr_intern_entry), Z_FREE(p->entries));
+    Z_HFREE(a->allocator, p->slots, p->slot_cap * sizeof(uint32_t), Z_FREE(p->slots));
+    zstr_builder_free(a);
+    p->entries = NULL;
+    p->slots = NULL;
+    p->count = p->entry_cap = p->slot_cap = 0;
+}
+
+// Number of distinct strings in the pool; ids run from 0 to count - 1.
+static inline size_t zstr_intern_count(const zstr_intern_pool *p)
+{
+    return p->count;
+}
+
+// Returns the id of the content in slot order, or -1 with *slot set to the free slot.
+static inline ptrdiff_t zstr_intern_find__(const zstr_intern_pool *p, const char *s, size_t len,
+                                           uint32_t h, size_t *slot)
+{
+    if (0 == p->slot_cap)
+    {
+        *slot = 0;
+        return -1;
+    }
+
+    size_t mask = p->slot_cap - 1;
+    size_t i = h & mask;
+    while (p->slots[i])
+    {
+        const zstr_intern_entry *e = &p->entries[p->slots[i] - 1];
+        if (e->hash == h && e->len == len && (0 == len || 0 == memcmp(e->data, s, len)))
+        {
+            return (ptrdiff_t)(p->slots[i] - 1);
+        }
+        i = (i + 1) & mask;
+    }
+    *slot = i;
+    return -1;
+}
+
+// Rebuilds the slot array at `cap` (a power of two) from the stored hashes.
+static inline int zstr_intern_rehash__(zstr_intern_pool *p, size_t cap)
+{
+    uint32_t *slots = (uint32_t *)Z_HCALLOC(p->arena.allocator, cap, sizeof(uint32_t), Z_CALLOC(cap, sizeof(uint32_t)));
+    if (!slots) return Z_ERR;
+
+    for (size_t id = 0; id < p->count; id++)
+    {
+        size_t i = p->entries[id].hash & (cap - 1);
+        while (slots[i]) i = (i + 1) & (cap - 1);
+        slots[i] = (uint32_t)(id + 1);
+    }
+
+    Z_HFREE(p->arena.allocator, p->slots, p->slot_cap * sizeof(uint32_t), Z_FREE(p->slots));
+    p->slots = slots;
+    p->slot_cap = cap;
+    return Z_OK;
+}
+
+// Looks s up without inserting. Returns true and sets *id if it is interned.
+static inline bool zstr_intern_lookup(const zstr_intern_pool *p, zstr_view s, uint32_t *id)
+{
+    size_t slot;
+    ptrdiff_t found = zstr_intern_find__(p, s.data, s.len, zstr__hash(s.data, s.len), &slot);
+    if (found < 0) return false;
+    if (id) *id = (uint32_t)found;
+    return true;
+}
+
+// Interns s and stores its dense id. The bytes are copied once, NUL-terminated,
+// into the pool's arena; later calls with equal content return the same id.
+static inline int zstr_intern_id(zstr_intern_pool *p, zstr_view s, uint32_t *id)
+{
+    uint32_t h = zstr__hash(s.data, s.len);
+    size_t slot;
+    ptrdiff_t found = zstr_intern_find__(p, s.data, s.len, h, &slot);
+    if (found >= 0)
+    {
+        *id = (uint32_t)found;
+        return Z_OK;
+    }
+
+    if (p->count >= UINT32_MAX - 1) return Z_ERR;
+
+    // Keep the table at most 3/4 full.
+    if ((p->count + 1) * 4 > p->slot_cap * 3)
+    {
+        if (zstr_intern_rehash__(p, p->slot_cap ? p->slot_cap * 2 : 64) != Z_OK) return Z_ERR;
+        zstr_intern_find__(p, s.data, s.len, h, &slot);
+    }
+
+    zstr_builder *a = &p->arena;
+    if (p->count == p->entry_cap)
+    {
+        size_t cap = p->entry_cap ? p->entry_cap * 2 : 64;
+        zstr_intern_entry *grown = (zstr_intern_entry *)Z_HREALLOC(a->allocator, p->entries,
+                                        p->entry_cap * sizeof(zstr_intern_entry), cap * sizeof(zstr_intern_entry),
+                                        Z_REALLOC(p->entries, cap * sizeof(zstr_intern_entry)));
+        if (!grown) return Z_ERR;
+        p->entries = grown;
+        p->entry_cap = cap;
+    }
+
+    char *dst = zstr_builder_reserve(a, s.len + 1);
+    if (!dst) return Z_ERR;
+    if (s.len) memcpy(dst, s.data, s.len);
+    dst[s.len] = '\0';
+    zstr_builder_commit(a, s.len + 1);
+
+    p->entries[p->count] = (zstr_intern_entry){ .data = dst, .len = s.len, .hash = h };
+    p->slots[slot] = (uint32_t)(p->count + 1);
+    *id = (uint32_t)p->count++;
+    return Z_OK;
+}
+
+// Returns the view stored for id, or an empty view with NULL data if id is unknown.
+static inline zstr_view zstr_intern_get(const zstr_intern_pool *p, uint32_t id)
+{
+    if (id >= p->count) return (zstr_view){ NULL, 0 };
+    return (zstr_view){ .data = p->entries[id].data, .len = p->entries[id].len };
+}
+
+// Interns s and returns the pool's canonical view of it (NULL data on allocation failure).
+// Canonical views of equal content share the same data pointer.
+static inline zstr_view zstr_intern(zstr_intern_pool *p, zstr_view s)
+{
+    uint32_t id;
+    if (zstr_intern_id(p, s, &id) != Z_OK) return (zstr_view){ NULL, 0 };
+    return zstr_intern_get(p, id);
+}
+
+// Interns a C-string.
+static inline zstr_view zstr_intern_cstr(zstr_intern_pool *p, const char *cstr)
+{
+    return zstr_intern(p, zstr_view_from(cstr));
+}
+
+// O(1) equality for two canonical views from the same pool.
+static inline bool zstr_interned_eq(zstr_view a, zstr_view b)
+{
+    return a.data == b.data;
+}
+
 #if defined(Z_HAS_CLEANUP) && Z_HAS_CLEANUP
     #define zstr_autofree  Z_CLEANUP(zstr_free) zstr
+    #define zstr_builder_autofree  Z_CLEANUP(zstr_builder_free) zstr_builder
+    #define zstr_intern_autofree   Z_CLEANUP(zstr_intern_free) zstr_intern_pool
 #endif
 
 #ifdef __cplusplus
@@ -1253,6 +2311,7 @@ namespace z_str
     {
         ::zstr inner;
         friend class view;
+        friend class builder;
 
         friend bool operator==(const string& lhs, const string& rhs);
         friend bool operator!=(const string& lhs, const string& rhs);
@@ -1371,6 +2430,7 @@ namespace z_str
 
         // Search
         std::ptrdiff_t find(const char *needle) const { return ::zstr_find(&inner, needle); }
+        std::ptrdiff_t rfind(const char *needle) const { return ::zstr_rfind(&inner, needle); }
         bool contains(const char *needle) const       { return ::zstr_contains(&inner, needle); }
         bool starts_with(const char *prefix) const    { return ::zstr_starts_with(&inner, prefix); }
         bool ends_with(const char *suffix) const      { return ::zstr_ends_with(&inner, suffix); }
@@ -1432,6 +2492,76 @@ namespace z_str
     // View constructor implementation.
     inline view::view(const string &s) : inner(::zstr_as_view(&s.inner)) {}
 
+    // Chunked builder: appends never copy earlier content; str() copies once.
+    class builder
+    {
+        ::zstr_builder inner;
+
+     public:
+        builder() : inner(::zstr_builder_init()) {}
+        ~builder() { ::zstr_builder_free(&inner); }
+
+        builder(const builder &) = delete;
+        builder& operator=(const builder &) = delete;
+
+        builder(builder &&other) noexcept : inner(other.inner) { other.inner = ::zstr_builder_init(); }
+
+        builder& append(const char *s)            { ::zstr_builder_cat(&inner, s); return *this; }
+        builder& append(const char *s, size_t n)  { ::zstr_builder_cat_len(&inner, s, n); return *this; }
+        builder& append(view v)                   { ::zstr_builder_cat_len(&inner, v.data(), v.size()); return *this; }
+        builder& operator+=(const char *s)        { return append(s); }
+        builder& operator+=(char c)               { ::zstr_builder_push_char(&inner, c); return *this; }
+        builder& operator+=(view v)               { return append(v); }
+
+        template<typename... Args>
+        builder& fmt(const char *format, Args... args)
+        {
+            ::zstr_builder_fmt(&inner, format, args...);
+            return *this;
+        }
+
+        size_t size() const { return ::zstr_builder_len(&inner); }
+        void clear()        { ::zstr_builder_clear(&inner); }
+
+        string str() const
+        {
+            string s;
+            s.inner = ::zstr_builder_to_str(&inner);
+            return s;
+        }
+
+        ::zstr_builder *c_ptr() { return &inner; }
+    };
+
+    // Interning pool: equal contents map to one id and one canonical view.
+    class intern_pool
+    {
+        ::zstr_intern_pool inner;
+
+     public:
+        intern_pool() : inner(::zstr_intern_init()) {}
+        ~intern_pool() { ::zstr_intern_free(&inner); }
+
+        intern_pool(const intern_pool &) = delete;
+        intern_pool& operator=(const intern_pool &) = delete;
+
+        view intern(view s)
+        {
+            ::zstr_view v = ::zstr_intern(&inner, ::zstr_view{ s.data(), s.size() });
+            return view(v.data, v.len);
+        }
+
+        bool id(view s, uint32_t *out) { return ::zstr_intern_id(&inner, ::zstr_view{ s.data(), s.size() }, out) == Z_OK; }
+
+        view get(uint32_t id) const
+        {
+            ::zstr_view v = ::zstr_intern_get(&inner, id);
+            return view(v.data, v.len);
+        }
+
+        size_t size() const { return ::zstr_intern_count(&inner); }
+    };
+
     // The global operators...
     inline std::ostream& operator<<(std::ostream &os, const string &s)
     {
@@ -144,6 +144,58 @@
 
 
 #endif // Z_COMMON_BUNDLED
+
+// Runtime allocator handle. Not part of zcommon yet, so it stays outside the bundled block
+// above (regenerated from upstream); every ZDK header carries the same guarded copy.
+#ifndef Z_ALLOCATOR_HANDLE_DEFINED
+#define Z_ALLOCATOR_HANDLE_DEFINED
+
+/* * zalloc_t routes one container's memory through any allocator (arena, pool, ...).
+ * Containers only carry a handle when Z_ALLOCATOR_HANDLE is defined before the first
+ * ZDK include; otherwise they are laid out and compiled exactly as before.
+ * A NULL handle means the compile-time *_MALLOC macros. realloc and free also receive
+ * the old size, for allocators that do not track it.
+ */
+#ifndef Z_ALLOC_T_DEFINED
+#define Z_ALLOC_T_DEFINED
+typedef struct zalloc_t
+{
+    void *(*alloc)(void *ctx, size_t size);
+    void *(*realloc)(void *ctx, void *ptr, size_t old_size, size_t new_size);
+    void  (*free)(void *ctx, void *ptr, size_t size);
+    void *ctx;
+} zalloc_t;
+#endif
+
+#ifdef Z_ALLOCATOR_HANDLE
+#   define Z_ALLOCATOR_FIELD                   const zalloc_t *allocator;
+#   define Z_ALLOCATOR_INIT                    , NULL
+#   define Z_HMALLOC(h, sz, dflt)              ((h) ? (h)->alloc((h)->ctx, (sz)) : (dflt))
+#   define Z_HCALLOC(h, n, sz, dflt)           ((h) ? z_hcalloc__((h), (n), (sz)) : (dflt))
+#   define Z_HREALLOC(h, p, old_sz, sz, dflt)  ((h) ? (h)->realloc((h)->ctx, (p), (old_sz), (sz)) : (dflt))
+#   define Z_HFREE(h, p, sz, dflt)             ((h) ? ((p) ? (h)->free((h)->ctx, (p), (sz)) : (void)0) : (void)(dflt))
+    // Setter for a generated container; call it while the container owns no memory yet.
+#   define Z_GEN_SET_ALLOCATOR(Type, Fn)       static inline void Fn(Type *c, const zalloc_t *a) { c->allocator = a; }
+
+static inline void *z_hcalloc__(const zalloc_t *h, size_t n, size_t sz)
+{
+    if (0 != n && sz > SIZE_MAX / n) return NULL;
+    void *p = h->alloc(h->ctx, n * sz);
+    if (p) memset(p, 0, n * sz);
+    return p;
+}
+#else
+#   define Z_ALLOCATOR_FIELD
+#   define Z_ALLOCATOR_INIT
+#   define Z_HMALLOC(h, sz, dflt)              (dflt)
+#   define Z_HCALLOC(h, n, sz, dflt)           (dflt)
+#   define Z_HREALLOC(h, p, old_sz, sz, dflt)  (dflt)
+#   define Z_HFREE(h, p, sz, dflt)             (dflt)
+#   define Z_GEN_SET_ALLOCATOR(Type, Fn)
+#endif
+
+#endif // Z_ALLOCATOR_HANDLE_DEFINED
+
 /* ============================================================================ */
 
 
@@ -158,9 +210,13 @@
  * Features:
  * • Native Win32 and POSIX (pthread) backends.
  * • Type-safe thread creation macros (zthread_create).
- * • Unified Mutex and Condition Variable primitives.
+ * • Unified Mutex, Reader/Writer Lock and Condition Variable primitives.
+ * • Atomics, spinlock, adaptive futex mutex, once flag and event primitives.
+ * • Bounded lock-free SPSC/MPMC ring queues (DEFINE_SPSC_QUEUE_TYPE, DEFINE_MPMC_QUEUE_TYPE).
+ * • Work-stealing executor (zexec) with joinable tasks and fork-join.
+ * • CPU topology, affinity, thread naming and NUMA-aware worker placement.
  * • Optional short names via ZTHREAD_SHORT_NAMES.
- * • Full C++ RAII wrappers (z_thread::thread, z_thread::mutex).
+ * • Full C++ RAII wrappers (z_thread::thread, z_thread::mutex, z_thread::pool).
  * • Zero dependencies (only standard system headers).
  *
  * License: MIT
@@ -179,6 +235,7 @@
     typedef HANDLE zthread_t;
     typedef CRITICAL_SECTION zmutex_t;
     typedef CONDITION_VARIABLE zcond_t;
+    typedef SRWLOCK zrwlock_t;
     // Internal Windows thread signature.
 #   define ZTHREAD_Func unsigned __stdcall
 #else
@@ -188,6 +245,25 @@
     typedef pthread_t zthread_t;
     typedef pthread_mutex_t zmutex_t;
     typedef pthread_cond_t zcond_t;
+    // pthread_rwlock_t is hidden in strict ISO modes; fall back to mutex + condvars there.
+    // Ask what <pthread.h> actually exposed: _POSIX_C_SOURCE may have been (re)defined
+    // after the feature headers already ran (zerror.h does this).
+#   if defined(PTHREAD_RWLOCK_INITIALIZER) || defined(__USE_XOPEN2K) || defined(__USE_UNIX98) || \
+       defined(__APPLE__)
+#       define ZTHREAD_NATIVE_RWLOCK 1
+        typedef pthread_rwlock_t zrwlock_t;
+#   else
+#       define ZTHREAD_NATIVE_RWLOCK 0
+        typedef struct
+        {
+            pthread_mutex_t lock;
+            pthread_cond_t readers_ok;
+            pthread_cond_t writer_ok;
+            int readers;
+            int writers_waiting;
+            int writer;
+        } zrwlock_t;
+#   endif
     // Internal POSIX thread signature.
 #   define ZTHREAD_Func void*
 #endif
@@ -258,11 +334,689 @@ void zcond_signal(zcond_t *c);
 void zcond_broadcast(zcond_t *c);
 void zcond_destroy(zcond_t *c);
 
+// Reader/writer locks: any number of readers, or a single writer.
+void zrwlock_init(zrwlock_t *l);
+void zrwlock_read_lock(zrwlock_t *l);
+void zrwlock_read_unlock(zrwlock_t *l);
+void zrwlock_write_lock(zrwlock_t *l);
+void zrwlock_write_unlock(zrwlock_t *l);
+void zrwlock_destroy(zrwlock_t *l);
+
+// Number of logical processors (at least 1).
+int zthread_hardware_concurrency(void);
+
+/* * Processor topology and placement.
+ * CPUs are numbered as the OS numbers them (the indices zthread_set_affinity takes). Only the
+ * CPUs the process may run on count (its affinity mask, which cgroup cpusets narrow). Where the
+ * platform does not report a detail, every CPU counts as its own core on package and node 0.
+*/
+typedef struct zthread_cpu_info
+{
+    int cpu;        // Logical processor index.
+    int core;       // Physical core, unique across packages; SMT siblings share it.
+    int package;    // Socket.
+    int node;       // NUMA node.
+} zthread_cpu_info;
+
+// Fills up to max entries, returns the number of usable online processors (NULL, 0 to size).
+int zthread_topology(zthread_cpu_info *out, int max);
+int zthread_physical_cores(void);
+int zthread_numa_nodes(void);
+// CPU the caller is running on right now, or -1 if unknown.
+int zthread_current_cpu(void);
+
+// The calling thread. On Windows a pseudo-handle: fine for affinity and naming, not for join.
+zthread_t zthread_self(void);
+// Restricts t to the listed CPUs. Z_OK, Z_EINVAL for a bad CPU, Z_ERR where unsupported
+// (macOS; another thread than the caller on Linux unless built with _GNU_SOURCE).
+int zthread_set_affinity(zthread_t t, const int *cpus, size_t count);
+// Name shown by debuggers and profilers; Linux truncates it to 15 bytes.
+int zthread_set_name(zthread_t t, const char *name);
+
+// Page-granular memory preferring NUMA node `node` (< 0: no preference). NULL on failure.
+void *zthread_numa_alloc(size_t size, int node);
+void zthread_numa_free(void *p, size_t size);
+
+/* * Atomics on plain integers and pointers.
+ * GCC/Clang use the __atomic builtins (what C11 <stdatomic.h> lowers to, but usable on
+ * ordinary types from C and C++ alike); MSVC uses Interlocked*, where every order is a full
+ * barrier. cas() follows C11: on failure *expected receives the current value.
+*/
+#if defined(__GNUC__) || defined(__clang__)
+#   define ZATOMIC_RELAXED __ATOMIC_RELAXED
+#   define ZATOMIC_ACQUIRE __ATOMIC_ACQUIRE
+#   define ZATOMIC_RELEASE __ATOMIC_RELEASE
+#   define ZATOMIC_ACQ_REL __ATOMIC_ACQ_REL
+#   define ZATOMIC_SEQ_CST __ATOMIC_SEQ_CST
+
+#   define ZATOMIC__GEN(T, S)                                                                       \
+    static inline T zatomic_load_##S(T *p, int o) { return __atomic_load_n(p, o); }                 \
+    static inline void zatomic_store_##S(T *p, T v, int o) { __atomic_store_n(p, v, o); }           \
+    static inline T zatomic_exchange_##S(T *p, T v, int o) { return __atomic_exchange_n(p, v, o); } \
+    static inline bool zatomic_cas_##S(T *p, T *expected, T desired, int o)                         \
+    {                                                                                               \
+        int fail = (ZATOMIC_ACQ_REL == o) ? ZATOMIC_ACQUIRE                                         \
+                 : (ZATOMIC_RELEASE == o) ? ZATOMIC_RELAXED : o;                                    \
+        return __atomic_compare_exchange_n(p, expected, desired, 0, o, fail);                       \
+    }
+#   define ZATOMIC__GEN_ARITH(T, S)                                                                 \
+    static inline T zatomic_fetch_add_##S(T *p, T v, int o) { return __atomic_fetch_add(p, v, o); } \
+    static inline T zatomic_fetch_or_##S(T *p, T v, int o) { return __atomic_fetch_or(p, v, o); }   \
+    static inline T zatomic_fetch_and_##S(T *p, T v, int o) { return __atomic_fetch_and(p, v, o); }
+
+    static inline void zatomic_fence(int o) 
+    { 
+        __atomic_thread_fence(o); 
+    }
+#elif defined(_MSC_VER)
+#   include <intrin.h>
+#   define ZATOMIC_RELAXED 0
+#   define ZATOMIC_ACQUIRE 2
+#   define ZATOMIC_RELEASE 3
+#   define ZATOMIC_ACQ_REL 4
+#   define ZATOMIC_SEQ_CST 5
+
+#   define ZATOMIC__GEN_MSVC(T, S, IT, Sfx)                                                        \
+    static inline T zatomic_load_##S(T *p, int o)                                                  \
+    { (void)o; return (T)_InterlockedOr##Sfx((volatile IT*)p, 0); }                                \
+    static inline void zatomic_store_##S(T *p, T v, int o)                                         \
+    { (void)o; _InterlockedExchange##Sfx((volatile IT*)p, (IT)v); }                                \
+    static inline T zatomic_exchange_##S(T *p, T v, int o)                                         \
+    { (void)o; return (T)_InterlockedExchange##Sfx((volatile IT*)p, (IT)v); }                      \
+    static inline bool zatomic_cas_##S(T *p, T *expected, T desired, int o)                        \
+    {                                                                                              \
+        (void)o;                                                                                   \
+        T seen = (T)_InterlockedCompareExchange##Sfx((volatile IT*)p, (IT)desired, (IT)*expected); \
+        if (seen == *expected) return true;                                                        \
+        *expected = seen;                                                                          \
+        return false;                                                                              \
+    }                                                                                              \
+    static inline T zatomic_fetch_add_##S(T *p, T v, int o)                                        \
+    { (void)o; return (T)_InterlockedExchangeAdd##Sfx((volatile IT*)p, (IT)v); }                   \
+    static inline T zatomic_fetch_or_##S(T *p, T v, int o)                                         \
+    { (void)o; return (T)_InterlockedOr##Sfx((volatile IT*)p, (IT)v); }                            \
+    static inline T zatomic_fetch_and_##S(T *p, T v, int o)                                        \
+    { (void)o; return (T)_InterlockedAnd##Sfx((volatile IT*)p, (IT)v); }
+
+    static inline void zatomic_fence(int o) 
+    { 
+        (void)o; 
+        MemoryBarrier(); 
+    }
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+    ZATOMIC__GEN(int32_t, i32)
+    ZATOMIC__GEN_ARITH(int32_t, i32)
+    ZATOMIC__GEN(int64_t, i64)
+    ZATOMIC__GEN_ARITH(int64_t, i64)
+    ZATOMIC__GEN(void*, ptr)
+#elif defined(_MSC_VER)
+    ZATOMIC__GEN_MSVC(int32_t, i32, long, )
+    ZATOMIC__GEN_MSVC(int64_t, i64, __int64, 64)
+
+    static inline void *zatomic_load_ptr(void **p, int o) 
+    { 
+        (void)o; 
+        return InterlockedCompareExchangePointer((PVOID volatile*)p, NULL, NULL); 
+    }
+    static inline void zatomic_store_ptr(void **p, void *v, int o) 
+    { 
+        (void)o; 
+        InterlockedExchangePointer((PVOID volatile*)p, v); 
+    }
+    static inline void *zatomic_exchange_ptr(void **p, void *v, int o) 
+    { 
+        (void)o; 
+        return InterlockedExchangePointer((PVOID volatile*)p, v); 
+    }
+    static inline bool zatomic_cas_ptr(void **p, void **expected, void *desired, int o) 
+    {
+        (void)o;
+        void *seen = InterlockedCompareExchangePointer((PVOID volatile*)p, desired, *expected);
+        if (seen == *expected) return true;
+        *expected = seen;
+        return false;
+    }
+#endif
+
+// CPU hint for spin-wait loops.
+static inline void zthread_pause(void) 
+{
+#if defined(_WIN32)
+    YieldProcessor();
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+    __builtin_ia32_pause();
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__aarch64__) || defined(__arm__))
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// Gives up the rest of the time slice.
+void zthread_yield(void);
+
+/* * Futex-style parking: zthread_wait_on() sleeps while *addr == expected (it may return
+ * spuriously, so re-check in a loop); the wakes release threads sleeping on addr.
+ * futex(2) on Linux, WaitOnAddress on Windows 8+, a hashed mutex/condvar table elsewhere.
+*/
+void zthread_wait_on(int32_t *addr, int32_t expected);
+void zthread_wake_one(int32_t *addr);
+void zthread_wake_all(int32_t *addr);
+
+// Spinlock (test-and-test-and-set) for very short critical sections.
+typedef struct { int32_t locked; } zspinlock_t;
+#define ZSPINLOCK_INIT { 0 }
+
+static inline void zspin_init(zspinlock_t *l) 
+{ 
+    l->locked = 0; 
+}
+
+static inline bool zspin_trylock(zspinlock_t *l) 
+{
+    return 0 == zatomic_load_i32(&l->locked, ZATOMIC_RELAXED) &&
+           0 == zatomic_exchange_i32(&l->locked, 1, ZATOMIC_ACQUIRE);
+}
+
+static inline void zspin_lock(zspinlock_t *l) 
+{
+    for (unsigned spins = 0; !zspin_trylock(l); spins++) 
+    {
+        if (spins < 64) 
+        {
+            zthread_pause();
+        }
+        else 
+        {
+            zthread_yield();
+        }
+    }
+}
+
+static inline void zspin_unlock(zspinlock_t *l) 
+{ 
+    zatomic_store_i32(&l->locked, 0, ZATOMIC_RELEASE); 
+}
+
+/* * Adaptive mutex: spins ZLOCK_SPIN rounds, then parks through zthread_wait_on.
+ * One int wide, statically initialisable and uncontended lock/unlock are a single atomic.
+*/
+#ifndef ZLOCK_SPIN
+    #define ZLOCK_SPIN 100
+#endif
+
+typedef struct { int32_t state; } zlock_t; // 0 free, 1 locked, 2 locked with waiters.
+#define ZLOCK_INIT { 0 }
+
+void zlock__lock_slow(zlock_t *l);
+
+static inline void zlock_init(zlock_t *l) 
+{ 
+    l->state = 0; 
+}
+
+static inline bool zlock_trylock(zlock_t *l) 
+{
+    int32_t expected = 0;
+    return zatomic_cas_i32(&l->state, &expected, 1, ZATOMIC_ACQUIRE);
+}
+
+static inline void zlock_lock(zlock_t *l) 
+{
+    if (!zlock_trylock(l)) 
+    {
+        zlock__lock_slow(l);
+    }
+}
+
+static inline void zlock_unlock(zlock_t *l) 
+{
+    if (2 == zatomic_exchange_i32(&l->state, 0, ZATOMIC_RELEASE)) 
+    {
+        zthread_wake_one(&l->state);
+    }
+}
+
+// Run-once flag: fn runs exactly once, later callers wait until it has returned.
+typedef struct { int32_t state; } zonce_t; // 0 new, 1 running, 2 done.
+#define ZONCE_INIT { 0 }
+
+void zonce__call_slow(zonce_t *o, void (*fn)(void));
+
+static inline void zonce_call(zonce_t *o, void (*fn)(void)) 
+{
+    if (2 != zatomic_load_i32(&o->state, ZATOMIC_ACQUIRE)) 
+    {
+        zonce__call_slow(o, fn);
+    }
+}
+
+// Manual-reset event: zevent_wait blocks until set; set/reset only make a syscall when needed.
+typedef struct { int32_t state; } zevent_t; // 0 clear, 1 set, 2 clear with waiters.
+
+static inline void zevent_init(zevent_t *e, bool set) 
+{ 
+    e->state = set ? 1 : 0; 
+}
+
+static inline bool zevent_is_set(zevent_t *e) 
+{ 
+    return 1 == zatomic_load_i32(&e->state, ZATOMIC_ACQUIRE); 
+}
+
+static inline void zevent_set(zevent_t *e) 
+{
+    if (2 == zatomic_exchange_i32(&e->state, 1, ZATOMIC_RELEASE)) 
+    {
+        zthread_wake_all(&e->state);
+    }
+}
+
+static inline void zevent_reset(zevent_t *e) 
+{
+    int32_t expected = 1;
+    zatomic_cas_i32(&e->state, &expected, 0, ZATOMIC_RELAXED);
+}
+
+void zevent_wait(zevent_t *e);
+
+/* * Bounded ring-buffer queues, generated per element type (plain C types: elements are
+ * copied with =).
+ * • DEFINE_SPSC_QUEUE_TYPE(T, Name): one producer, one consumer; each side caches the
+ *   other's index, so a push or pop rarely touches the other side's cache line.
+ * • DEFINE_MPMC_QUEUE_TYPE(T, Name): any number of producers and consumers (per-cell
+ *   sequence numbers, one CAS per operation or per batch).
+ * Capacity is rounded up to a power of two. push/pop never block. push_n/pop_n move up to
+ * n elements at once and return how many moved. push_wait/pop_wait spin briefly, then park
+ * (zthread_wait_on) until the queue stops being full/empty; the other side only wakes
+ * them when someone is actually parked.
+ * Usage: DEFINE_MPMC_QUEUE_TYPE(int, Int) ... zmpmc_Int q; zmpmc_init_Int(&q, 1024);
+*/
+#ifndef ZTHREAD_CACHE_LINE
+    #define ZTHREAD_CACHE_LINE 64
+#endif
+
+#ifndef ZQUEUE_SPIN
+    #define ZQUEUE_SPIN 64
+#endif
+
+// Parking shared by every queue type: waiters count parked threads, seq is what they sleep on.
+typedef struct 
+{
+    int32_t waiters;
+    int32_t seq;
+} zqueue__park;
+
+static inline void zqueue__notify(zqueue__park *p) 
+{
+    if (zatomic_load_i32(&p->waiters, ZATOMIC_SEQ_CST) > 0) 
+    {
+        zatomic_fetch_add_i32(&p->seq, 1, ZATOMIC_SEQ_CST);
+        zthread_wake_all(&p->seq);
+    }
+}
+
+static inline int32_t zqueue__prepare(zqueue__park *p) 
+{
+    int32_t seq = zatomic_load_i32(&p->seq, ZATOMIC_SEQ_CST);
+    zatomic_fetch_add_i32(&p->waiters, 1, ZATOMIC_SEQ_CST);
+    return seq;
+}
+
+static inline void zqueue__sleep(zqueue__park *p, int32_t seq) 
+{
+    zthread_wait_on(&p->seq, seq);
+    zatomic_fetch_add_i32(&p->waiters, -1, ZATOMIC_SEQ_CST);
+}
+
+static inline void zqueue__cancel(zqueue__park *p) 
+{
+    zatomic_fetch_add_i32(&p->waiters, -1, ZATOMIC_SEQ_CST);
+}
+
+static inline size_t zqueue__round_pow2(size_t capacity) 
+{
+    size_t cap = 2;
+    while (cap < capacity) 
+    {
+        cap <<= 1;
+    }
+    return cap;
+}
+
+// Generates <Prefix>_<Op>_wait_<Name>: retries TRY(q, arg), parking on q->PARK between attempts.
+#define ZQUEUE__GEN_WAIT(Prefix, Name, Op, ArgT, TRY, PARK)                                         \
+    static inline void Prefix##_##Op##_wait_##Name(Prefix##_##Name *q, ArgT arg)                    \
+    {                                                                                               \
+        for (int spin = 0; spin < ZQUEUE_SPIN; spin++)                                              \
+        {                                                                                           \
+            if (TRY(q, arg))                                                                        \
+            {                                                                                       \
+                return;                                                                             \
+            }                                                                                       \
+            zthread_pause();                                                                        \
+        }                                                                                           \
+        for (;;)                                                                                    \
+        {                                                                                           \
+            int32_t seq = zqueue__prepare(&q->PARK);                                                \
+            if (TRY(q, arg))                                                                        \
+            {                                                                                       \
+                zqueue__cancel(&q->PARK);                                                           \
+                return;                                                                             \
+            }                                                                                       \
+            zqueue__sleep(&q->PARK, seq);                                                           \
+            if (TRY(q, arg))                                                                        \
+            {                                                                                       \
+                return;                                                                             \
+            }                                                                                       \
+        }                                                                                           \
+    }
+
+#define DEFINE_SPSC_QUEUE_TYPE(T, Name)                                                             \
+    typedef struct                                                                                  \
+    {                                                                                               \
+        int64_t head;            /* Consumer side. */                                               \
+        int64_t tail_cache;                                                                         \
+        char pad0[ZTHREAD_CACHE_LINE - 2 * sizeof(int64_t)];                                        \
+        int64_t tail;            /* Producer side. */                                               \
+        int64_t head_cache;                                                                         \
+        char pad1[ZTHREAD_CACHE_LINE - 2 * sizeof(int64_t)];                                        \
+        T *buf;                                                                                     \
+        int64_t mask;                                                                               \
+        zqueue__park not_empty;  /* Consumers parked in pop_wait. */                                \
+        zqueue__park not_full;   /* Producers parked in push_wait. */                               \
+    } zspsc_##Name;                                                                                 \
+                                                                                                    \
+    static inline int zspsc_init_##Name(zspsc_##Name *q, size_t capacity)                           \
+    {                                                                                               \
+        size_t cap = zqueue__round_pow2(capacity);                                                  \
+        memset(q, 0, sizeof(*q));                                                                   \
+        q->buf = (T*)ZTHREAD_MALLOC(cap * sizeof(T));                                               \
+        if (!q->buf)                                                                                \
+        {                                                                                           \
+            return Z_ENOMEM;                                                                        \
+        }                                                                                           \
+        q->mask = (int64_t)cap - 1;                                                                 \
+        return Z_OK;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    static inline void zspsc_free_##Name(zspsc_##Name *q)                                           \
+    {                                                                                               \
+        ZTHREAD_FREE(q->buf);                                                                       \
+        q->buf = NULL;                                                                              \
+    }                                                                                               \
+                                                                                                    \
+    static inline size_t zspsc_capacity_##Name(const zspsc_##Name *q)                               \
+    {                                                                                               \
+        return (size_t)q->mask + 1;                                                                 \
+    }                                                                                               \
+                                                                                                    \
+    static inline size_t zspsc_size_##Name(zspsc_##Name *q)                                         \
+    {                                                                                               \
+        int64_t n = zatomic_load_i64(&q->tail, ZATOMIC_ACQUIRE) -                                   \
+                    zatomic_load_i64(&q->head, ZATOMIC_ACQUIRE);                                    \
+        return n > 0 ? (size_t)n : 0;                                                               \
+    }                                                                                               \
+                                                                                                    \
+    /* Space for up to n more elements, refreshing the cached head only when needed. */             \
+    static inline size_t zspsc_free_slots__##Name(zspsc_##Name *q, int64_t tail, size_t n)          \
+    {                                                                                               \
+        int64_t room = q->mask + 1 - (tail - q->head_cache);                                        \
+        if ((size_t)room < n)                                                                       \
+        {                                                                                           \
+            q->head_cache = zatomic_load_i64(&q->head, ZATOMIC_SEQ_CST);                            \
+            room = q->mask + 1 - (tail - q->head_cache);                                            \
+        }                                                                                           \
+        return (size_t)room < n ? (size_t)room : n;                                                 \
+    }                                                                                               \
+                                                                                                    \
+    static inline size_t zspsc_ready__##Name(zspsc_##Name *q, int64_t head, size_t n)               \
+    {                                                                                               \
+        int64_t ready = q->tail_cache - head;                                                       \
+        if ((size_t)ready < n)                                                                      \
+        {                                                                                           \
+            q->tail_cache = zatomic_load_i64(&q->tail, ZATOMIC_SEQ_CST);                            \
+            ready = q->tail_cache - head;                                                           \
+        }                                                                                           \
+        return (size_t)ready < n ? (size_t)ready : n;                                               \
+    }                                                                                               \
+                                                                                                    \
+    static inline size_t zspsc_push_n_##Name(zspsc_##Name *q, const T *src, size_t n)               \
+    {                                                                                               \
+        int64_t tail = q->tail;                                                                     \
+        size_t k = zspsc_free_slots__##Name(q, tail, n);                                            \
+        for (size_t i = 0; i < k; i++)                                                              \
+        {                                                                                           \
+            q->buf[(tail + (int64_t)i) & q->mask] = src[i];                                         \
+        }                                                                                           \
+        if (k)                                                                                      \
+        {                                                                                           \
+            zatomic_store_i64(&q->tail, tail + (int64_t)k, ZATOMIC_SEQ_CST);                        \
+            zqueue__notify(&q->not_empty);                                                          \
+        }                                                                                           \
+        return k;                                                                                   \
+    }                                                                                               \
+                                                                                                    \
+    static inline size_t zspsc_pop_n_##Name(zspsc_##Name *q, T *dst, size_t n)                      \
+    {                                                                                               \
+        int64_t head = q->head;                                                                     \
+        size_t k = zspsc_ready__##Name(q, head, n);                                                 \
+        for (size_t i = 0; i < k; i++)                                                              \
+        {                                                                                           \
+            dst[i] = q->buf[(head + (int64_t)i) & q->mask];                                         \
+        }                                                                                           \
+        if (k)                                                                                      \
+        {                                                                                           \
+            zatomic_store_i64(&q->head, head + (int64_t)k, ZATOMIC_SEQ_CST);                        \
+            zqueue__notify(&q->not_full);                                                           \
+        }                                                                                           \
+        return k;                                                                                   \
+    }                                                                                               \
+                                                                                                    \
+    static inline bool zspsc_push_##Name(zspsc_##Name *q, T value)                                  \
+    {                                                                                               \
+        return 1 == zspsc_push_n_##Name(q, &value, 1);                                              \
+    }                                                                                               \
+                                                                                                    \
+    static inline bool zspsc_pop_##Name(zspsc_##Name *q, T *out)                                    \
+    {                                                                                               \
+        return 1 == zspsc_pop_n_##Name(q, out, 1);                                                  \
+    }                                                                                               \
+                                                                                                    \
+    ZQUEUE__GEN_WAIT(zspsc, Name, push, T, zspsc_push_##Name, not_full)                             \
+    ZQUEUE__GEN_WAIT(zspsc, Name, pop, T*, zspsc_pop_##Name, not_empty)
+
+#define DEFINE_MPMC_QUEUE_TYPE(T, Name)                                                             \
+    typedef struct                                                                                  \
+    {                                                                                               \
+        int64_t seq;                                                                                \
+        T value;                                                                                    \
+    } zmpmc_cell_##Name;                                                                            \
+                                                                                                    \
+    typedef struct                                                                                  \
+    {                                                                                               \
+        int64_t enqueue_pos;                                                                        \
+        char pad0[ZTHREAD_CACHE_LINE - sizeof(int64_t)];                                            \
+        int64_t dequeue_pos;                                                                        \
+        char pad1[ZTHREAD_CACHE_LINE - sizeof(int64_t)];                                            \
+        zmpmc_cell_##Name *cells;                                                                   \
+        int64_t mask;                                                                               \
+        zqueue__park not_empty;                                                                     \
+        zqueue__park not_full;                                                                      \
+    } zmpmc_##Name;                                                                                 \
+                                                                                                    \
+    static inline int zmpmc_init_##Name(zmpmc_##Name *q, size_t capacity)                           \
+    {                                                                                               \
+        size_t cap = zqueue__round_pow2(capacity);                                                  \
+        memset(q, 0, sizeof(*q));                                                                   \
+        q->cells = (zmpmc_cell_##Name*)ZTHREAD_MALLOC(cap * sizeof(zmpmc_cell_##Name));             \
+        if (!q->cells)                                                                              \
+        {                                                                                           \
+            return Z_ENOMEM;                                                                        \
+        }                                                                                           \
+        for (size_t i = 0; i < cap; i++)                                                            \
+        {                                                                                           \
+            q->cells[i].seq = (int64_t)i;                                                           \
+        }                                                                                           \
+        q->mask = (int64_t)cap - 1;                                                                 \
+        return Z_OK;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    static inline void zmpmc_free_##Name(zmpmc_##Name *q)                                           \
+    {                                                                                               \
+        ZTHREAD_FREE(q->cells);                                                                     \
+        q->cells = NULL;                                                                            \
+    }                                                                                               \
+                                                                                                    \
+    static inline size_t zmpmc_capacity_##Name(const zmpmc_##Name *q)                               \
+    {                                                                                               \
+        return (size_t)q->mask + 1;                                                                 \
+    }                                                                                               \
+                                                                                                    \
+    static inline size_t zmpmc_size_##Name(zmpmc_##Name *q)                                         \
+    {                                                                                               \
+        int64_t n = zatomic_load_i64(&q->enqueue_pos, ZATOMIC_ACQUIRE) -                            \
+                    zatomic_load_i64(&q->dequeue_pos, ZATOMIC_ACQUIRE);                             \
+        return n > 0 ? (size_t)n : 0;                                                               \
+    }                                                                                               \
+                                                                                                    \
+    /* Claims up to n cells in a row whose seq is pos + i + lag, then CASes *pos_ptr past them. */  \
+    static inline size_t zmpmc_claim__##Name(zmpmc_##Name *q, int64_t *pos_ptr, int64_t lag,        \
+                                             size_t n, int64_t *start)                              \
+    {                                                                                               \
+        int64_t pos = zatomic_load_i64(pos_ptr, ZATOMIC_RELAXED);                                   \
+        for (;;)                                                                                    \
+        {                                                                                           \
+            size_t k = 0;                                                                           \
+            int64_t dif = 0;                                                                        \
+            while (k < n)                                                                           \
+            {                                                                                       \
+                int64_t at = pos + (int64_t)k;                                                      \
+                dif = zatomic_load_i64(&q->cells[at & q->mask].seq, ZATOMIC_SEQ_CST) - (at + lag);  \
+                if (0 != dif)                                                                       \
+                {                                                                                   \
+                    break;                                                                          \
+                }                                                                                   \
+                k++;                                                                                \
+            }                                                                                       \
+            if (0 == k && dif < 0)                                                                  \
+            {                                                                                       \
+                return 0; /* Full (push) or empty (pop). */                                         \
+            }                                                                                       \
+            if (0 == k)                                                                             \
+            {                                                                                       \
+                pos = zatomic_load_i64(pos_ptr, ZATOMIC_RELAXED);                                   \
+                continue;                                                                           \
+            }                                                                                       \
+            if (zatomic_cas_i64(pos_ptr, &pos, pos + (int64_t)k, ZATOMIC_RELAXED))                  \
+            {                                                                                       \
+                *start = pos;                                                                       \
+                return k;                                                                           \
+            }                                                                                       \
+        }                                                                                           \
+    }                                                                                               \
+                                                                                                    \
+    static inline size_t zmpmc_push_n_##Name(zmpmc_##Name *q, const T *src, size_t n)               \
+    {                                                                                               \
+        int64_t pos;                                                                                \
+        size_t k = n ? zmpmc_claim__##Name(q, &q->enqueue_pos, 0, n, &pos) : 0;                     \
+        for (size_t i = 0; i < k; i++)                                                              \
+        {                                                                                           \
+            zmpmc_cell_##Name *cell = &q->cells[(pos + (int64_t)i) & q->mask];                      \
+            cell->value = src[i];                                                                   \
+            zatomic_store_i64(&cell->seq, pos + (int64_t)i + 1, ZATOMIC_SEQ_CST);                   \
+        }                                                                                           \
+        if (k)                                                                                      \
+        {                                                                                           \
+            zqueue__notify(&q->not_empty);                                                          \
+        }                                                                                           \
+        return k;                                                                                   \
+    }                                                                                               \
+                                                                                                    \
+    static inline size_t zmpmc_pop_n_##Name(zmpmc_##Name *q, T *dst, size_t n)                      \
+    {                                                                                               \
+        int64_t pos;                                                                                \
+        size_t k = n ? zmpmc_claim__##Name(q, &q->dequeue_pos, 1, n, &pos) : 0;                     \
+        for (size_t i = 0; i < k; i++)                                                              \
+        {                                                                                           \
+            zmpmc_cell_##Name *cell = &q->cells[(pos + (int64_t)i) & q->mask];                      \
+            dst[i] = cell->value;                                                                   \
+            zatomic_store_i64(&cell->seq, pos + (int64_t)i + q->mask + 1, ZATOMIC_SEQ_CST);         \
+        }                                                                                           \
+        if (k)                                                                                      \
+        {                                                                                           \
+            zqueue__notify(&q->not_full);                                                           \
+        }                                                                                           \
+        return k;                                                                                   \
+    }                                                                                               \
+                                                                                                    \
+    static inline bool zmpmc_push_##Name(zmpmc_##Name *q, T value)                                  \
+    {                                                                                               \
+        return 1 == zmpmc_push_n_##Name(q, &value, 1);                                              \
+    }                                                                                               \
+                                                                                                    \
+    static inline bool zmpmc_pop_##Name(zmpmc_##Name *q, T *out)                                    \
+    {                                                                                               \
+        return 1 == zmpmc_pop_n_##Name(q, out, 1);                                                  \
+    }                                                                                               \
+                                                                                                    \
+    ZQUEUE__GEN_WAIT(zmpmc, Name, push, T, zmpmc_push_##Name, not_full)                             \
+    ZQUEUE__GEN_WAIT(zmpmc, Name, pop, T*, zmpmc_pop_##Name, not_empty)
+
+/* * Work-stealing executor.
+ * Every worker owns a Chase-Lev deque: tasks submitted from inside a task go to the local
+ * deque (LIFO for the owner, stolen FIFO by idle workers); tasks from other threads go
+ * through a shared injection queue. Idle workers park on a zcond_t.
+ * Waiting (zexec_join, zexec_run) runs other queued tasks meanwhile, so tasks may wait on
+ * the subtasks they spawn without exhausting the workers.
+ * Usage: zexec *e = zexec_create(0); ztask *t = zexec_spawn(e, fn, arg); zexec_join(t);
+*/
+typedef void (*zexec_fn)(void *arg);
+typedef struct zexec zexec;
+typedef struct ztask ztask;
+
+// Worker placement for zexec_create_ex.
+#define ZEXEC_PLACE_NONE   0    // The OS schedules the workers.
+#define ZEXEC_PLACE_CORES  1    // One worker pinned per physical core, its deque on the core's node.
+
+typedef struct zexec_options
+{
+    int threads;        // <= 0: one per logical processor (per physical core with ZEXEC_PLACE_CORES).
+    int placement;
+    const char *name;   // Workers are named "<name>-<index>"; "zexec" when NULL.
+} zexec_options;
+
+// threads <= 0 starts one worker per logical processor. Returns NULL on failure.
+zexec *zexec_create(int threads);
+// Past the physical core count, ZEXEC_PLACE_CORES wraps onto SMT siblings; workers that cannot be
+// pinned run unpinned. NULL on failure.
+zexec *zexec_create_ex(const zexec_options *opt);
+// Finishes every queued task, then joins the workers. Not callable from one of its own tasks.
+void zexec_destroy(zexec *e);
+size_t zexec_threads(const zexec *e);
+
+// Fire and forget. Returns Z_OK or Z_ENOMEM.
+int zexec_submit(zexec *e, zexec_fn fn, void *arg);
+// Task with a completion handle; every spawned task must be joined exactly once. NULL on failure.
+ztask *zexec_spawn(zexec *e, zexec_fn fn, void *arg);
+void zexec_join(ztask *t);
+// Fork-join: fn(tasks + i * size) for i < count, the caller runs task 0. size 0 shares one task.
+void zexec_run(zexec *e, zexec_fn fn, void *tasks, size_t size, size_t count);
+
+// Process-wide executor (one worker per logical processor), created on first use and never destroyed.
+zexec *zexec_default(void);
+
+// The calling worker's index in its executor and its NUMA node (-1 outside a worker; the node
+// is also -1 for workers not placed by ZEXEC_PLACE_CORES).
+int zexec_worker_index(void);
+int zexec_worker_node(void);
+
 // Short names (optional).
 #ifdef ZTHREAD_SHORT_NAMES
     typedef zthread_t   thread_t;
     typedef zmutex_t    mutex_t;
     typedef zcond_t     cond_t;
+    typedef zrwlock_t   rwlock_t;
 
 #   define thread_create   zthread_create
 #   define thread_join     zthread_join
@@ -282,6 +1036,13 @@ void zcond_destroy(zcond_t *c);
 #   define cond_signal     zcond_signal
 #   define cond_broadcast  zcond_broadcast
 #   define cond_destroy    zcond_destroy
+
+#   define rwlock_init         zrwlock_init
+#   define rwlock_read_lock    zrwlock_read_lock
+#   define rwlock_read_unlock  zrwlock_read_unlock
+#   define rwlock_write_lock   zrwlock_write_lock
+#   define rwlock_write_unlock zrwlock_write_unlock
+#   define rwlock_destroy      zrwlock_destroy
 #endif
 
 #ifdef __cplusplus
@@ -294,6 +1055,11 @@ void zcond_destroy(zcond_t *c);
 #include <utility>
 #include <exception>
 #include <functional>
+#include <future>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
 
 namespace z_thread 
 {
@@ -396,6 +1162,148 @@ namespace z_thread
         }
     };
 
+    class rwlock 
+    {
+        ::zrwlock_t inner;
+
+     public:
+        rwlock() 
+        { 
+            ::zrwlock_init(&inner); 
+        }
+
+        ~rwlock() 
+        { 
+            ::zrwlock_destroy(&inner); 
+        }
+
+        // Non-copyable.
+        rwlock(const rwlock&) = delete;
+        rwlock &operator=(const rwlock&) = delete;
+
+        void lock() 
+        { 
+            ::zrwlock_write_lock(&inner); 
+        }
+
+        void unlock() 
+        { 
+            ::zrwlock_write_unlock(&inner); 
+        }
+
+        void lock_shared() 
+        { 
+            ::zrwlock_read_lock(&inner); 
+        }
+
+        void unlock_shared() 
+        { 
+            ::zrwlock_read_unlock(&inner); 
+        }
+
+        ::zrwlock_t *native_handle() 
+        { 
+            return &inner; 
+        }
+    };
+
+    // BasicLockable, so std::lock_guard / std::unique_lock work with these two.
+    class spinlock 
+    {
+        ::zspinlock_t inner;
+
+     public:
+        spinlock() 
+        { 
+            ::zspin_init(&inner); 
+        }
+
+        // Non-copyable.
+        spinlock(const spinlock&) = delete;
+        spinlock &operator=(const spinlock&) = delete;
+
+        void lock() 
+        { 
+            ::zspin_lock(&inner); 
+        }
+
+        bool try_lock() 
+        { 
+            return ::zspin_trylock(&inner); 
+        }
+
+        void unlock() 
+        { 
+            ::zspin_unlock(&inner); 
+        }
+    };
+
+    // Adaptive spin-then-park mutex (zlock_t).
+    class fast_mutex 
+    {
+        ::zlock_t inner;
+
+     public:
+        fast_mutex() 
+        { 
+            ::zlock_init(&inner); 
+        }
+
+        // Non-copyable.
+        fast_mutex(const fast_mutex&) = delete;
+        fast_mutex &operator=(const fast_mutex&) = delete;
+
+        void lock() 
+        { 
+            ::zlock_lock(&inner); 
+        }
+
+        bool try_lock() 
+        { 
+            return ::zlock_trylock(&inner); 
+        }
+
+        void unlock() 
+        { 
+            ::zlock_unlock(&inner); 
+        }
+    };
+
+    class event 
+    {
+        ::zevent_t inner;
+
+     public:
+        explicit event(bool set = false) 
+        { 
+            ::zevent_init(&inner, set); 
+        }
+
+        // Non-copyable.
+        event(const event&) = delete;
+        event &operator=(const event&) = delete;
+
+        void set() 
+        { 
+            ::zevent_set(&inner); 
+        }
+
+        void reset() 
+        { 
+            ::zevent_reset(&inner); 
+        }
+
+        void wait() 
+        { 
+            ::zevent_wait(&inner); 
+        }
+
+        bool is_set() 
+        { 
+            return ::zevent_is_set(&inner); 
+        }
+    };
+
     class thread 
     {
         ::zthread_t inner;
@@ -512,29 +1420,166 @@ namespace z_thread
         { 
             return inner; 
         }
+
+        bool set_name(const char *name) 
+        { 
+            return joinable && Z_OK == ::zthread_set_name(inner, name); 
+        }
+
+        bool set_affinity(const int *cpus, size_t count) 
+        { 
+            return joinable && Z_OK == ::zthread_set_affinity(inner, cpus, count); 
+        }
         
         static void sleep(int ms) 
         { 
             ::zthread_sleep(ms); 
         }
     };
-}
 
-#endif // __cplusplus
+    // Work-stealing pool over zexec. submit() returns a std::future; blocking on one from inside
+    // a pool task holds that worker, so nested fork-join should go through run() instead.
+    class pool 
+    {
+        ::zexec *inner;
 
-#endif // ZTHREAD_H
+        struct task_base 
+        { 
+            virtual void run() = 0; 
+            virtual ~task_base() {} 
+        };
 
-#ifdef ZTHREAD_IMPLEMENTATION
-#ifndef ZTHREAD_IMPLEMENTATION_GUARD
-#define ZTHREAD_IMPLEMENTATION_GUARD
+        template <typename Func>
+        struct task_type : task_base 
+        {
+            Func f;
+            task_type(Func &&func) : f(std::forward<Func>(func)) {}
+            void run() override { f(); }
+        };
 
-struct zthread__wrap 
-{ 
-    zthread_proxy_fn f; 
-    void *arg; 
-};
+        static void proxy_thunk(void *arg) 
+        {
+            task_base *p = static_cast<task_base*>(arg);
+            p->run();
+            delete p;
+        }
 
-#ifdef _WIN32
+        template <typename Func>
+        void post_task(Func &&f) 
+        {
+            task_base *p = new task_type<Func>(std::forward<Func>(f));
+            if (Z_OK != ::zexec_submit(inner, proxy_thunk, p)) 
+            {
+                delete p;
+                throw std::bad_alloc();
+            }
+        }
+
+        template <typename Func>
+        static void run_thunk(void *arg) 
+        {
+            (*static_cast<Func*>(arg))();
+        }
+
+    public:
+        // threads <= 0: one worker per logical processor.
+        explicit pool(int threads = 0) : inner(::zexec_create(threads)) 
+        {
+            if (!inner) 
+            {
+                throw std::bad_alloc();
+            }
+        }
+
+        // Placement and worker naming, see zexec_options.
+        explicit pool(const ::zexec_options &opt) : inner(::zexec_create_ex(&opt)) 
+        {
+            if (!inner) 
+            {
+                throw std::bad_alloc();
+            }
+        }
+
+        // Runs what is still queued, then joins the workers.
+        ~pool() 
+        { 
+            ::zexec_destroy(inner); 
+        }
+
+        // Non-copyable.
+        pool(const pool&) = delete;
+        pool &operator=(const pool&) = delete;
+
+        // Usage: auto f = pool.submit([](int x) { return x * 2; }, 21); f.get();
+        template <typename Function, typename... Args>
+        auto submit(Function &&f, Args&&... args) -> std::future<decltype(f(args...))> 
+        {
+            typedef decltype(f(args...)) result_type;
+            auto task = std::make_shared<std::packaged_task<result_type()>>(
+                std::bind(std::forward<Function>(f), std::forward<Args>(args)...));
+            std::future<result_type> fut = task->get_future();
+            post_task([task]() { (*task)(); });
+            return fut;
+        }
+
+        // Fire and forget.
+        template <typename Function>
+        void post(Function &&f) 
+        {
+            post_task(std::function<void()>(std::forward<Function>(f)));
+        }
+
+        // Calls f(i) for i in [0, count) across the pool and returns when all are done;
+        // the caller takes part, so it is safe to use from inside a pool task.
+        template <typename Function>
+        void run(size_t count, Function &&f) 
+        {
+            typedef typename std::remove_reference<Function>::type fn_type;
+            struct item 
+            {
+                fn_type *fn;
+                size_t index;
+                void operator()() { (*fn)(index); }
+            };
+            std::vector<item> items(count);
+            for (size_t i = 0; i < count; i++) 
+            {
+                items[i].fn = &f;
+                items[i].index = i;
+            }
+            if (count) 
+            {
+                ::zexec_run(inner, run_thunk<item>, items.data(), sizeof(item), count);
+            }
+        }
+
+        size_t size() const 
+        { 
+            return ::zexec_threads(inner); 
+        }
+
+        ::zexec *native_handle() 
+        { 
+            return inner; 
+        }
+    };
+}
+
+#endif // __cplusplus
+
+#endif // ZTHREAD_H
+
+#ifdef ZTHREAD_IMPLEMENTATION
+#ifndef ZTHREAD_IMPLEMENTATION_GUARD
+#define ZTHREAD_IMPLEMENTATION_GUARD
+
+struct zthread__wrap 
+{ 
+    zthread_proxy_fn f; 
+    void *arg; 
+};
+
+#ifdef _WIN32
 static unsigned __stdcall zthread__proxy_entry(void *p) 
 {
     struct zthread__wrap *w = (struct zthread__wrap*)p;
@@ -621,6 +1666,36 @@ void zcond_destroy(zcond_t *c)
     (void)c; 
 } 
 
+void zrwlock_init(zrwlock_t *l) 
+{ 
+    InitializeSRWLock(l); 
+}
+
+void zrwlock_read_lock(zrwlock_t *l) 
+{ 
+    AcquireSRWLockShared(l); 
+}
+
+void zrwlock_read_unlock(zrwlock_t *l) 
+{ 
+    ReleaseSRWLockShared(l); 
+}
+
+void zrwlock_write_lock(zrwlock_t *l) 
+{ 
+    AcquireSRWLockExclusive(l); 
+}
+
+void zrwlock_write_unlock(zrwlock_t *l) 
+{ 
+    ReleaseSRWLockExclusive(l); 
+}
+
+void zrwlock_destroy(zrwlock_t *l) 
+{ 
+    (void)l; 
+}
+
 #else
 // POSIX implementation.
 
@@ -711,8 +1786,1385 @@ void zcond_destroy(zcond_t *c)
 { 
     pthread_cond_destroy(c); 
 }
+
+#if ZTHREAD_NATIVE_RWLOCK
+void zrwlock_init(zrwlock_t *l) 
+{ 
+    pthread_rwlock_init(l, NULL); 
+}
+
+void zrwlock_read_lock(zrwlock_t *l) 
+{ 
+    pthread_rwlock_rdlock(l); 
+}
+
+void zrwlock_read_unlock(zrwlock_t *l) 
+{ 
+    pthread_rwlock_unlock(l); 
+}
+
+void zrwlock_write_lock(zrwlock_t *l) 
+{ 
+    pthread_rwlock_wrlock(l); 
+}
+
+void zrwlock_write_unlock(zrwlock_t *l) 
+{ 
+    pthread_rwlock_unlock(l); 
+}
+
+void zrwlock_destroy(zrwlock_t *l) 
+{ 
+    pthread_rwlock_destroy(l); 
+}
+#else
+// Writer-preferring fallback: new readers wait while a writer is queued.
+void zrwlock_init(zrwlock_t *l) 
+{ 
+    pthread_mutex_init(&l->lock, NULL);
+    pthread_cond_init(&l->readers_ok, NULL);
+    pthread_cond_init(&l->writer_ok, NULL);
+    l->readers = 0;
+    l->writers_waiting = 0;
+    l->writer = 0;
+}
+
+void zrwlock_read_lock(zrwlock_t *l) 
+{ 
+    pthread_mutex_lock(&l->lock);
+    while (l->writer || l->writers_waiting > 0)
+    {
+        pthread_cond_wait(&l->readers_ok, &l->lock);
+    }
+    l->readers++;
+    pthread_mutex_unlock(&l->lock);
+}
+
+void zrwlock_read_unlock(zrwlock_t *l) 
+{ 
+    pthread_mutex_lock(&l->lock);
+    if (0 == --l->readers && l->writers_waiting > 0)
+    {
+        pthread_cond_signal(&l->writer_ok);
+    }
+    pthread_mutex_unlock(&l->lock);
+}
+
+void zrwlock_write_lock(zrwlock_t *l) 
+{ 
+    pthread_mutex_lock(&l->lock);
+    l->writers_waiting++;
+    while (l->writer || l->readers > 0)
+    {
+        pthread_cond_wait(&l->writer_ok, &l->lock);
+    }
+    l->writers_waiting--;
+    l->writer = 1;
+    pthread_mutex_unlock(&l->lock);
+}
+
+void zrwlock_write_unlock(zrwlock_t *l) 
+{ 
+    pthread_mutex_lock(&l->lock);
+    l->writer = 0;
+    if (l->writers_waiting > 0)
+    {
+        pthread_cond_signal(&l->writer_ok);
+    }
+    else
+    {
+        pthread_cond_broadcast(&l->readers_ok);
+    }
+    pthread_mutex_unlock(&l->lock);
+}
+
+void zrwlock_destroy(zrwlock_t *l) 
+{ 
+    pthread_cond_destroy(&l->writer_ok);
+    pthread_cond_destroy(&l->readers_ok);
+    pthread_mutex_destroy(&l->lock);
+}
+#endif
+#endif
+
+#ifdef _WIN32
+int zthread_hardware_concurrency(void) 
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+#else
+int zthread_hardware_concurrency(void) 
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+#endif
+
+// Parking.
+
+#if defined(__linux__) && (defined(__USE_MISC) || defined(_GNU_SOURCE) || defined(_DEFAULT_SOURCE))
+#   include <sys/syscall.h>
+#   include <linux/futex.h>
+#   define ZTHREAD__FUTEX 1
+#   define ZTHREAD__SYSCALL 1
+#elif defined(_WIN32) && defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+#   define ZTHREAD__WAIT_ON_ADDRESS 1
+#   ifdef _MSC_VER
+#       pragma comment(lib, "Synchronization.lib")
+#   endif
+#endif
+
+#if defined(ZTHREAD__FUTEX)
+void zthread_wait_on(int32_t *addr, int32_t expected) 
+{
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+void zthread_wake_one(int32_t *addr) 
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+void zthread_wake_all(int32_t *addr) 
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT32_MAX, NULL, NULL, 0);
+}
+#elif defined(ZTHREAD__WAIT_ON_ADDRESS)
+void zthread_wait_on(int32_t *addr, int32_t expected) 
+{
+    WaitOnAddress((volatile VOID*)addr, &expected, sizeof(expected), INFINITE);
+}
+
+void zthread_wake_one(int32_t *addr) 
+{
+    WakeByAddressSingle((PVOID)addr);
+}
+
+void zthread_wake_all(int32_t *addr) 
+{
+    WakeByAddressAll((PVOID)addr);
+}
+#else
+// Parking lot: the address picks a bucket; wakes broadcast because buckets are shared.
+#define ZTHREAD__PARK_BUCKETS 64
+
+#ifdef _WIN32
+typedef struct { SRWLOCK lock; CONDITION_VARIABLE cond; } zthread__bucket;
+#   define ZTHREAD__BUCKET_INIT { SRWLOCK_INIT, CONDITION_VARIABLE_INIT }
+#   define ZTHREAD__BUCKET_LOCK(b)   AcquireSRWLockExclusive(&(b)->lock)
+#   define ZTHREAD__BUCKET_UNLOCK(b) ReleaseSRWLockExclusive(&(b)->lock)
+#   define ZTHREAD__BUCKET_WAIT(b)   SleepConditionVariableSRW(&(b)->cond, &(b)->lock, INFINITE, 0)
+#   define ZTHREAD__BUCKET_WAKE(b)   WakeAllConditionVariable(&(b)->cond)
+#else
+typedef struct { pthread_mutex_t lock; pthread_cond_t cond; } zthread__bucket;
+#   define ZTHREAD__BUCKET_INIT { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER }
+#   define ZTHREAD__BUCKET_LOCK(b)   pthread_mutex_lock(&(b)->lock)
+#   define ZTHREAD__BUCKET_UNLOCK(b) pthread_mutex_unlock(&(b)->lock)
+#   define ZTHREAD__BUCKET_WAIT(b)   pthread_cond_wait(&(b)->cond, &(b)->lock)
+#   define ZTHREAD__BUCKET_WAKE(b)   pthread_cond_broadcast(&(b)->cond)
+#endif
+
+#define ZTHREAD__B ZTHREAD__BUCKET_INIT
+#define ZTHREAD__B8 ZTHREAD__B, ZTHREAD__B, ZTHREAD__B, ZTHREAD__B, ZTHREAD__B, ZTHREAD__B, ZTHREAD__B, ZTHREAD__B
+static zthread__bucket zthread__buckets[ZTHREAD__PARK_BUCKETS] = 
+{
+    ZTHREAD__B8, ZTHREAD__B8, ZTHREAD__B8, ZTHREAD__B8, ZTHREAD__B8, ZTHREAD__B8, ZTHREAD__B8, ZTHREAD__B8
+};
+#undef ZTHREAD__B8
+#undef ZTHREAD__B
+
+static zthread__bucket *zthread__bucket_of(int32_t *addr) 
+{
+    uintptr_t h = (uintptr_t)addr;
+    h ^= h >> 17;
+    h *= (uintptr_t)0x9E3779B97F4A7C15ull;
+    return &zthread__buckets[(h >> 7) % ZTHREAD__PARK_BUCKETS];
+}
+
+void zthread_wait_on(int32_t *addr, int32_t expected) 
+{
+    zthread__bucket *b = zthread__bucket_of(addr);
+    ZTHREAD__BUCKET_LOCK(b);
+    // Wakers lock the bucket after changing *addr, so this check cannot miss them.
+    if (zatomic_load_i32(addr, ZATOMIC_SEQ_CST) == expected) 
+    {
+        ZTHREAD__BUCKET_WAIT(b);
+    }
+    ZTHREAD__BUCKET_UNLOCK(b);
+}
+
+void zthread_wake_one(int32_t *addr) 
+{
+    zthread_wake_all(addr);
+}
+
+void zthread_wake_all(int32_t *addr) 
+{
+    zthread__bucket *b = zthread__bucket_of(addr);
+    ZTHREAD__BUCKET_LOCK(b);
+    ZTHREAD__BUCKET_WAKE(b);
+    ZTHREAD__BUCKET_UNLOCK(b);
+}
+#endif
+
+#ifdef _WIN32
+void zthread_yield(void) 
+{
+    SwitchToThread();
+}
+#else
+#include <sched.h>
+void zthread_yield(void) 
+{
+    sched_yield();
+}
 #endif
 
+// Topology and placement.
+
+#include <stdio.h>
+#ifdef _WIN32
+static int zthread__probe(zthread_cpu_info **out) 
+{
+    DWORD bytes = 0;
+    GetLogicalProcessorInformation(NULL, &bytes);
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION *info;
+    info = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION*)ZTHREAD_MALLOC(bytes);
+    zthread_cpu_info *cpus = (zthread_cpu_info*)ZTHREAD_MALLOC(64 * sizeof(zthread_cpu_info));
+    if (!info || !cpus || !GetLogicalProcessorInformation(info, &bytes)) 
+    {
+        ZTHREAD_FREE(info);
+        ZTHREAD_FREE(cpus);
+        return -1;
+    }
+    for (int i = 0; i < 64; i++) 
+    {
+        cpus[i].cpu = -1;
+        cpus[i].core = i;
+        cpus[i].package = 0;
+        cpus[i].node = 0;
+    }
+    int cores = 0, packages = 0;
+    for (DWORD k = 0; k < bytes / sizeof(*info); k++) 
+    {
+        int id = (RelationProcessorCore == info[k].Relationship) ? cores++
+               : (RelationProcessorPackage == info[k].Relationship) ? packages++
+               : (RelationNumaNode == info[k].Relationship) ? (int)info[k].NumaNode.NodeNumber : -1;
+        for (int i = 0; i < 64; i++) 
+        {
+            if (!(info[k].ProcessorMask & ((ULONG_PTR)1 << i))) 
+            {
+                continue;
+            }
+            switch (info[k].Relationship) 
+            {
+                case RelationProcessorCore:    cpus[i].cpu = i; cpus[i].core = id; break;
+                case RelationProcessorPackage: cpus[i].package = id; break;
+                case RelationNumaNode:         cpus[i].node = id; break;
+                default: break;
+            }
+        }
+    }
+    ZTHREAD_FREE(info);
+    DWORD_PTR allowed = ~(DWORD_PTR)0, system;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &allowed, &system) || 0 == allowed) 
+    {
+        allowed = ~(DWORD_PTR)0;
+    }
+    int n = 0;
+    for (int i = 0; i < 64; i++) 
+    {
+        if (cpus[i].cpu >= 0 && (i >= (int)(8 * sizeof(allowed)) || (allowed & ((DWORD_PTR)1 << i)))) 
+        {
+            cpus[n++] = cpus[i];
+        }
+    }
+    *out = cpus;
+    return n;
+}
+
+int zthread_current_cpu(void) 
+{
+    return (int)GetCurrentProcessorNumber();
+}
+
+zthread_t zthread_self(void) 
+{
+    return GetCurrentThread();
+}
+
+int zthread_set_affinity(zthread_t t, const int *cpus, size_t count) 
+{
+    DWORD_PTR mask = 0;
+    for (size_t i = 0; i < count; i++) 
+    {
+        if (cpus[i] < 0 || cpus[i] >= (int)(8 * sizeof(mask))) 
+        {
+            return Z_EINVAL;
+        }
+        mask |= (DWORD_PTR)1 << cpus[i];
+    }
+    if (0 == mask) 
+    {
+        return Z_EINVAL;
+    }
+    return 0 != SetThreadAffinityMask(t, mask) ? Z_OK : Z_ERR;
+}
+
+// SetThreadDescription is Windows 10 1607+, so it is looked up rather than linked.
+typedef HRESULT (WINAPI *zthread__describe_fn)(HANDLE, PCWSTR);
+
+int zthread_set_name(zthread_t t, const char *name) 
+{
+    FARPROC proc = GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "SetThreadDescription");
+    WCHAR wide[256];
+    if (!proc) 
+    {
+        return Z_ERR;
+    }
+    if (0 == MultiByteToWideChar(CP_UTF8, 0, name, -1, wide, 256)) 
+    {
+        return Z_EINVAL;
+    }
+    zthread__describe_fn describe;
+    memcpy(&describe, &proc, sizeof(describe));
+    return SUCCEEDED(describe(t, wide)) ? Z_OK : Z_ERR;
+}
+
+void *zthread_numa_alloc(size_t size, int node) 
+{
+    if (node < 0) 
+    {
+        return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+    return VirtualAllocExNuma(GetCurrentProcess(), NULL, size, MEM_RESERVE | MEM_COMMIT,
+                              PAGE_READWRITE, (DWORD)node);
+}
+
+void zthread_numa_free(void *p, size_t size) 
+{
+    (void)size;
+    if (p) 
+    {
+        VirtualFree(p, 0, MEM_RELEASE);
+    }
+}
+#else
+#if defined(__linux__)
+#   include <dirent.h>
+
+static int zthread__read_int(const char *path, int fallback) 
+{
+    FILE *f = fopen(path, "r");
+    int v = fallback;
+    if (f) 
+    {
+        if (1 != fscanf(f, "%d", &v)) 
+        {
+            v = fallback;
+        }
+        fclose(f);
+    }
+    return v;
+}
+
+// sysfs lists a cpuN/nodeM link for the node a CPU belongs to.
+static int zthread__node_of(int cpu) 
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR *d = opendir(path);
+    int node = 0;
+    if (!d) 
+    {
+        return 0;
+    }
+    struct dirent *ent;
+    while (NULL != (ent = readdir(d))) 
+    {
+        if (0 == strncmp(ent->d_name, "node", 4) && ent->d_name[4] >= '0' && ent->d_name[4] <= '9') 
+        {
+            node = atoi(ent->d_name + 4);
+            break;
+        }
+    }
+    closedir(d);
+    return node;
+}
+#endif
+
+// Whether the process may run on cpu; true when the mask cannot be read.
+static bool zthread__allowed(const unsigned long *mask, size_t words, int cpu) 
+{
+    size_t bits = 8 * sizeof(unsigned long);
+    if (0 == words) 
+    {
+        return true;
+    }
+    return (size_t)cpu < words * bits && 0 != (mask[(size_t)cpu / bits] & (1ul << ((size_t)cpu % bits)));
+}
+
+static int zthread__probe(zthread_cpu_info **out) 
+{
+    // The affinity mask already reflects a cgroup cpuset. words stays 0 if it cannot be read.
+    unsigned long mask[1024 / (8 * sizeof(unsigned long))];
+    size_t words = 0;
+#   if defined(__linux__) && defined(CPU_SET)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (0 == sched_getaffinity(0, sizeof(set), &set) && CPU_COUNT(&set) > 0) 
+    {
+        memset(mask, 0, sizeof(mask));
+        for (int cpu = 0; cpu < CPU_SETSIZE && cpu < (int)(8 * sizeof(mask)); cpu++) 
+        {
+            mask[cpu / (8 * sizeof(unsigned long))] |= 
+                (unsigned long)(0 != CPU_ISSET(cpu, &set)) << (cpu % (8 * sizeof(unsigned long)));
+        }
+        words = sizeof(mask) / sizeof(mask[0]);
+    }
+#   elif defined(ZTHREAD__SYSCALL) && defined(SYS_sched_getaffinity)
+    // The raw syscall returns how many bytes of the mask it wrote.
+    memset(mask, 0, sizeof(mask));
+    long got = syscall(SYS_sched_getaffinity, 0, sizeof(mask), mask);
+    words = got > 0 ? (size_t)got / sizeof(unsigned long) : 0;
+#   endif
+    long conf = sysconf(_SC_NPROCESSORS_CONF);
+    int total = conf > 0 ? (int)conf : zthread_hardware_concurrency();
+    zthread_cpu_info *cpus = (zthread_cpu_info*)ZTHREAD_MALLOC((size_t)total * sizeof(zthread_cpu_info));
+    if (!cpus) 
+    {
+        return -1;
+    }
+    int n = 0;
+    for (int cpu = 0; cpu < total; cpu++) 
+    {
+        zthread_cpu_info *c = &cpus[n];
+        c->cpu = cpu;
+        c->core = cpu;
+        c->package = 0;
+        c->node = 0;
+        if (!zthread__allowed(mask, words, cpu)) 
+        {
+            continue;
+        }
+#       if defined(__linux__)
+        char path[96];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/online", cpu);
+        if (0 == zthread__read_int(path, 1)) 
+        {
+            continue;
+        }
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+        c->core = zthread__read_int(path, cpu);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+        c->package = zthread__read_int(path, 0);
+        c->package = c->package < 0 ? 0 : c->package;
+        c->node = zthread__node_of(cpu);
+#       endif
+        n++;
+    }
+    *out = cpus;
+    return n;
+}
+
+int zthread_current_cpu(void) 
+{
+#   if defined(ZTHREAD__SYSCALL) && defined(SYS_getcpu)
+    unsigned cpu = 0;
+    return 0 == syscall(SYS_getcpu, &cpu, NULL, NULL) ? (int)cpu : -1;
+#   else
+    return -1;
+#   endif
+}
+
+zthread_t zthread_self(void) 
+{
+    return pthread_self();
+}
+
+int zthread_set_affinity(zthread_t t, const int *cpus, size_t count) 
+{
+    if (0 == count) 
+    {
+        return Z_EINVAL;
+    }
+#   if defined(__linux__) && defined(CPU_SET)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (size_t i = 0; i < count; i++) 
+    {
+        if (cpus[i] < 0 || cpus[i] >= CPU_SETSIZE) 
+        {
+            return Z_EINVAL;
+        }
+        CPU_SET(cpus[i], &set);
+    }
+    return 0 == pthread_setaffinity_np(t, sizeof(set), &set) ? Z_OK : Z_ERR;
+#   elif defined(ZTHREAD__SYSCALL)
+    // Without _GNU_SOURCE only the raw syscall is visible, and it takes a kernel tid.
+    unsigned long mask[1024 / (8 * sizeof(unsigned long))];
+    memset(mask, 0, sizeof(mask));
+    for (size_t i = 0; i < count; i++) 
+    {
+        if (cpus[i] < 0 || cpus[i] >= (int)(8 * sizeof(mask))) 
+        {
+            return Z_EINVAL;
+        }
+        mask[cpus[i] / (8 * sizeof(unsigned long))] |= 1ul << (cpus[i] % (8 * sizeof(unsigned long)));
+    }
+    if (!pthread_equal(t, pthread_self())) 
+    {
+        return Z_ERR;
+    }
+    return 0 == syscall(SYS_sched_setaffinity, 0, sizeof(mask), mask) ? Z_OK : Z_ERR;
+#   else
+    (void)t;
+    (void)cpus;
+    return Z_ERR;
+#   endif
+}
+
+int zthread_set_name(zthread_t t, const char *name) 
+{
+    char buf[16];
+    size_t len = strlen(name);
+    len = len < sizeof(buf) - 1 ? len : sizeof(buf) - 1;
+    memcpy(buf, name, len);
+    buf[len] = '\0';
+#   if defined(__linux__) && defined(CPU_SET)
+    return 0 == pthread_setname_np(t, buf) ? Z_OK : Z_ERR;
+#   elif defined(__linux__) && defined(ZTHREAD__SYSCALL)
+    // PR_SET_NAME (15) only names the caller.
+    if (!pthread_equal(t, pthread_self())) 
+    {
+        return Z_ERR;
+    }
+    return 0 == syscall(SYS_prctl, 15, buf, 0, 0, 0) ? Z_OK : Z_ERR;
+#   elif defined(__APPLE__)
+    if (!pthread_equal(t, pthread_self())) 
+    {
+        return Z_ERR;
+    }
+    return 0 == pthread_setname_np(name) ? Z_OK : Z_ERR;
+#   else
+    (void)t;
+    return Z_ERR;
+#   endif
+}
+
+#if defined(ZTHREAD__SYSCALL) && defined(SYS_mbind)
+#   include <sys/mman.h>
+
+void *zthread_numa_alloc(size_t size, int node) 
+{
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == p) 
+    {
+        return NULL;
+    }
+    unsigned long mask[1024 / (8 * sizeof(unsigned long))];
+    if (node >= 0 && node < (int)(8 * sizeof(mask))) 
+    {
+        // MPOL_PREFERRED (1): pages come from node while it has any, no libnuma needed.
+        // A kernel without NUMA rejects the call, which leaves plain first-touch placement.
+        memset(mask, 0, sizeof(mask));
+        mask[node / (8 * sizeof(unsigned long))] = 1ul << (node % (8 * sizeof(unsigned long)));
+        syscall(SYS_mbind, p, size, 1, mask, (unsigned long)(8 * sizeof(mask)), 0);
+    }
+    return p;
+}
+
+void zthread_numa_free(void *p, size_t size) 
+{
+    if (p) 
+    {
+        munmap(p, size);
+    }
+}
+#else
+// No placement control: rely on first touch, which a pinned caller gets node-local anyway.
+void *zthread_numa_alloc(size_t size, int node) 
+{
+    (void)node;
+    return ZTHREAD_MALLOC(size);
+}
+
+void zthread_numa_free(void *p, size_t size) 
+{
+    (void)size;
+    ZTHREAD_FREE(p);
+}
+#endif
+#endif
+
+int zthread_topology(zthread_cpu_info *out, int max) 
+{
+    zthread_cpu_info *cpus = NULL;
+    int n = zthread__probe(&cpus);
+    int *ids = (n > 0) ? (int*)ZTHREAD_MALLOC((size_t)n * sizeof(int)) : NULL;
+    if (!ids) 
+    {
+        // Nothing readable: one core per logical processor.
+        ZTHREAD_FREE(cpus);
+        n = zthread_hardware_concurrency();
+        for (int i = 0; i < n && i < max; i++) 
+        {
+            out[i].cpu = i;
+            out[i].core = i;
+            out[i].package = 0;
+            out[i].node = 0;
+        }
+        return n;
+    }
+    // Core ids repeat across packages; renumber (package, core) pairs densely.
+    int next = 0;
+    for (int i = 0; i < n; i++) 
+    {
+        int j = 0;
+        while (j < i && (cpus[j].package != cpus[i].package || cpus[j].core != cpus[i].core)) 
+        {
+            j++;
+        }
+        ids[i] = (j < i) ? ids[j] : next++;
+    }
+    for (int i = 0; i < n && i < max; i++) 
+    {
+        out[i] = cpus[i];
+        out[i].core = ids[i];
+    }
+    ZTHREAD_FREE(ids);
+    ZTHREAD_FREE(cpus);
+    return n;
+}
+
+int zthread_physical_cores(void) 
+{
+    int n = zthread_topology(NULL, 0), cores = 0;
+    zthread_cpu_info *cpus = (zthread_cpu_info*)ZTHREAD_MALLOC((size_t)n * sizeof(zthread_cpu_info));
+    if (!cpus) 
+    {
+        return n;
+    }
+    n = zthread_topology(cpus, n);
+    for (int i = 0; i < n; i++) 
+    {
+        cores = cpus[i].core >= cores ? cpus[i].core + 1 : cores;
+    }
+    ZTHREAD_FREE(cpus);
+    return cores > 0 ? cores : 1;
+}
+
+int zthread_numa_nodes(void) 
+{
+    int n = zthread_topology(NULL, 0), nodes = 1;
+    zthread_cpu_info *cpus = (zthread_cpu_info*)ZTHREAD_MALLOC((size_t)n * sizeof(zthread_cpu_info));
+    if (!cpus) 
+    {
+        return 1;
+    }
+    n = zthread_topology(cpus, n);
+    for (int i = 0; i < n; i++) 
+    {
+        nodes = cpus[i].node >= nodes ? cpus[i].node + 1 : nodes;
+    }
+    ZTHREAD_FREE(cpus);
+    return nodes;
+}
+
+void zlock__lock_slow(zlock_t *l) 
+{
+    for (int i = 0; i < ZLOCK_SPIN; i++) 
+    {
+        if (0 == zatomic_load_i32(&l->state, ZATOMIC_RELAXED) && zlock_trylock(l)) 
+        {
+            return;
+        }
+        zthread_pause();
+    }
+    // Taking it as 2 keeps the unlock-side wake for whoever is still parked.
+    while (0 != zatomic_exchange_i32(&l->state, 2, ZATOMIC_ACQUIRE)) 
+    {
+        zthread_wait_on(&l->state, 2);
+    }
+}
+
+void zonce__call_slow(zonce_t *o, void (*fn)(void)) 
+{
+    int32_t expected = 0;
+    if (zatomic_cas_i32(&o->state, &expected, 1, ZATOMIC_ACQUIRE)) 
+    {
+        fn();
+        zatomic_store_i32(&o->state, 2, ZATOMIC_RELEASE);
+        zthread_wake_all(&o->state);
+        return;
+    }
+    while (2 != zatomic_load_i32(&o->state, ZATOMIC_ACQUIRE)) 
+    {
+        zthread_wait_on(&o->state, 1);
+    }
+}
+
+void zevent_wait(zevent_t *e) 
+{
+    for (;;) 
+    {
+        int32_t state = zatomic_load_i32(&e->state, ZATOMIC_ACQUIRE);
+        if (1 == state) 
+        {
+            return;
+        }
+        if (0 == state && !zatomic_cas_i32(&e->state, &state, 2, ZATOMIC_ACQUIRE)) 
+        {
+            continue;
+        }
+        zthread_wait_on(&e->state, 2);
+    }
+}
+
+// Executor.
+
+#ifndef ZTHREAD_TLS
+#   if defined(__cplusplus)
+#       define ZTHREAD_TLS thread_local
+#   elif defined(_MSC_VER)
+#       define ZTHREAD_TLS __declspec(thread)
+#   elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#       define ZTHREAD_TLS _Thread_local
+#   else
+#       define ZTHREAD_TLS __thread
+#   endif
+#endif
+
+// Sequentially consistent unless the name says otherwise; the deque and the parking protocol rely on it.
+#define zthread__load(p)            zatomic_load_i64((p), ZATOMIC_SEQ_CST)
+#define zthread__store(p, v)        zatomic_store_i64((p), (v), ZATOMIC_SEQ_CST)
+#define zthread__store_rel(p, v)    zatomic_store_i64((p), (v), ZATOMIC_RELEASE)
+#define zthread__cas(p, e, d)       zthread__cas_i64((p), (e), (d))
+#define zthread__load_ptr(p)        zatomic_load_ptr((p), ZATOMIC_ACQUIRE)
+#define zthread__store_ptr(p, v)    zatomic_store_ptr((p), (v), ZATOMIC_RELEASE)
+#define zthread__cas_ptr(p, e, d)   zthread__cas_vp((p), (e), (d))
+
+static int64_t zthread__add(int64_t *p, int64_t v) 
+{ 
+    return zatomic_fetch_add_i64(p, v, ZATOMIC_SEQ_CST) + v; 
+}
+
+static int zthread__cas_i64(int64_t *p, int64_t expected, int64_t desired) 
+{ 
+    return zatomic_cas_i64(p, &expected, desired, ZATOMIC_SEQ_CST); 
+}
+
+static int zthread__cas_vp(void **p, void *expected, void *desired) 
+{ 
+    return zatomic_cas_ptr(p, &expected, desired, ZATOMIC_ACQ_REL); 
+}
+
+#define ZEXEC__RING_INITIAL 256
+
+struct ztask 
+{
+    zexec_fn fn;
+    void *arg;
+    zexec *exec;
+    ztask *next;            // Injection queue link.
+    int64_t *latch;         // Decremented once fn returns (NULL for fire and forget).
+    int64_t pending;        // Latch of a spawned task.
+    int detached;           // Freed by the worker after running.
+};
+
+// Deque storage; grown rings stay alive (chained by prev) because thieves may still read them.
+typedef struct zexec__ring 
+{
+    int64_t mask;
+    struct zexec__ring *prev;
+    void **slots;
+    int node;               // >= 0: from zthread_numa_alloc.
+} zexec__ring;
+
+typedef struct zexec__worker 
+{
+    int64_t top;                                    // Stolen from (thieves CAS it).
+    char pad0[ZTHREAD_CACHE_LINE - sizeof(int64_t)];
+    int64_t bottom;                                 // Pushed/popped by the owner only.
+    char pad1[ZTHREAD_CACHE_LINE - sizeof(int64_t)];
+    void *ring;
+    zexec *exec;
+    zthread_t thread;
+    uint64_t rng;
+    int started;
+    int index;
+    int cpu;                // Pinned CPU, or -1.
+    int node;               // NUMA node of cpu, or -1.
+} zexec__worker;
+
+struct zexec 
+{
+    zexec__worker *workers;
+    size_t count;
+    zmutex_t lock;          // Guards the injection queue and parking.
+    zcond_t wake;
+    ztask *inject_head;
+    ztask *inject_tail;
+    int64_t injected;       // Injection queue length, read without the lock.
+    int64_t seq;            // Bumped on every event a parked thread may care about.
+    int64_t sleepers;
+    int64_t joiners;
+    int64_t stop;
+    char name[16];
+};
+
+static ZTHREAD_TLS zexec__worker *zexec__self = NULL;
+static void *zexec__global = NULL;
+
+static zexec__ring *zexec__ring_new(int64_t cap, zexec__ring *prev, int node) 
+{
+    size_t bytes = sizeof(zexec__ring) + (size_t)cap * sizeof(void*);
+    zexec__ring *r = (zexec__ring*)(node >= 0 ? zthread_numa_alloc(bytes, node) : ZTHREAD_MALLOC(bytes));
+    if (!r) 
+    {
+        return NULL;
+    }
+    r->mask = cap - 1;
+    r->prev = prev;
+    r->slots = (void**)(r + 1);
+    r->node = node;
+    return r;
+}
+
+static void zexec__ring_free(zexec__ring *r) 
+{
+    if (r->node >= 0) 
+    {
+        zthread_numa_free(r, sizeof(zexec__ring) + (size_t)(r->mask + 1) * sizeof(void*));
+    }
+    else 
+    {
+        ZTHREAD_FREE(r);
+    }
+}
+
+static int zexec__deque_push(zexec__worker *w, ztask *t) 
+{
+    int64_t b = zthread__load(&w->bottom);
+    int64_t top = zthread__load(&w->top);
+    zexec__ring *r = (zexec__ring*)w->ring;
+
+    if (b - top > r->mask) 
+    {
+        zexec__ring *grown = zexec__ring_new((r->mask + 1) * 2, r, w->node);
+        if (!grown) 
+        {
+            return Z_ENOMEM;
+        }
+        for (int64_t i = top; i < b; i++) 
+        {
+            grown->slots[i & grown->mask] = zthread__load_ptr(&r->slots[i & r->mask]);
+        }
+        zthread__store_ptr(&w->ring, grown);
+        r = grown;
+    }
+    zthread__store_ptr(&r->slots[b & r->mask], t);
+    zthread__store_rel(&w->bottom, b + 1);
+    return Z_OK;
+}
+
+static ztask *zexec__deque_take(zexec__worker *w) 
+{
+    int64_t b = zthread__load(&w->bottom) - 1;
+    zexec__ring *r = (zexec__ring*)w->ring;
+    zthread__store(&w->bottom, b);
+    int64_t top = zthread__load(&w->top);
+
+    if (top > b) 
+    {
+        zthread__store(&w->bottom, b + 1);
+        return NULL;
+    }
+    ztask *t = (ztask*)zthread__load_ptr(&r->slots[b & r->mask]);
+    if (top == b) 
+    {
+        // Last item: race the thieves for it.
+        if (!zthread__cas(&w->top, top, top + 1)) 
+        {
+            t = NULL;
+        }
+        zthread__store(&w->bottom, b + 1);
+    }
+    return t;
+}
+
+static ztask *zexec__deque_steal(zexec__worker *v) 
+{
+    for (;;) 
+    {
+        int64_t top = zthread__load(&v->top);
+        int64_t b = zthread__load(&v->bottom);
+        if (top >= b) 
+        {
+            return NULL;
+        }
+        zexec__ring *r = (zexec__ring*)zthread__load_ptr(&v->ring);
+        ztask *t = (ztask*)zthread__load_ptr(&r->slots[top & r->mask]);
+        if (zthread__cas(&v->top, top, top + 1)) 
+        {
+            return t;
+        }
+        // Lost to the owner or another thief; someone made progress, look again.
+    }
+}
+
+static ztask *zexec__find(zexec *e, zexec__worker *self) 
+{
+    ztask *t;
+    if (self && NULL != (t = zexec__deque_take(self))) 
+    {
+        return t;
+    }
+
+    if (zthread__load(&e->injected) > 0) 
+    {
+        zmutex_lock(&e->lock);
+        t = e->inject_head;
+        if (t) 
+        {
+            e->inject_head = t->next;
+            if (!e->inject_head) 
+            {
+                e->inject_tail = NULL;
+            }
+            zthread__add(&e->injected, -1);
+        }
+        zmutex_unlock(&e->lock);
+        if (t) 
+        {
+            return t;
+        }
+    }
+
+    // Random victim order, so thieves spread out.
+    size_t start = 0;
+    if (self) 
+    {
+        self->rng ^= self->rng << 13;
+        self->rng ^= self->rng >> 7;
+        self->rng ^= self->rng << 17;
+        start = (size_t)(self->rng % e->count);
+    }
+    for (size_t i = 0; i < e->count; i++) 
+    {
+        zexec__worker *v = &e->workers[(start + i) % e->count];
+        if (v != self && NULL != (t = zexec__deque_steal(v))) 
+        {
+            return t;
+        }
+    }
+    return NULL;
+}
+
+// Parked threads wake on a seq change; joiners also need completions, so those wake everyone.
+static void zexec__notify(zexec *e, int all) 
+{
+    zthread__add(&e->seq, 1);
+    if (zthread__load(&e->sleepers) > 0) 
+    {
+        zmutex_lock(&e->lock);
+        if (all) 
+        {
+            zcond_broadcast(&e->wake);
+        }
+        else 
+        {
+            zcond_signal(&e->wake);
+        }
+        zmutex_unlock(&e->lock);
+    }
+}
+
+static void zexec__execute(zexec *e, ztask *t) 
+{
+    t->fn(t->arg);
+    // Read everything first: a joiner may free t (or the latch) the moment it reaches zero.
+    int64_t *latch = t->latch;
+    if (t->detached) 
+    {
+        ZTHREAD_FREE(t);
+    }
+    if (latch && 0 == zthread__add(latch, -1) && zthread__load(&e->joiners) > 0) 
+    {
+        zexec__notify(e, 1);
+    }
+}
+
+static void zexec__park(zexec *e, int64_t seen, int64_t *latch) 
+{
+    zmutex_lock(&e->lock);
+    zthread__add(&e->sleepers, 1);
+    while (zthread__load(&e->seq) == seen && !zthread__load(&e->stop) && (!latch || zthread__load(latch) > 0)) 
+    {
+        zcond_wait(&e->wake, &e->lock);
+    }
+    zthread__add(&e->sleepers, -1);
+    zmutex_unlock(&e->lock);
+}
+
+static void zexec__schedule(zexec *e, ztask *t) 
+{
+    zexec__worker *self = zexec__self;
+    if (!self || self->exec != e || Z_OK != zexec__deque_push(self, t)) 
+    {
+        t->next = NULL;
+        zmutex_lock(&e->lock);
+        if (e->inject_tail) 
+        {
+            e->inject_tail->next = t;
+        }
+        else 
+        {
+            e->inject_head = t;
+        }
+        e->inject_tail = t;
+        zthread__add(&e->injected, 1);
+        zmutex_unlock(&e->lock);
+    }
+    zexec__notify(e, zthread__load(&e->joiners) > 0);
+}
+
+static void zexec__wait(zexec *e, int64_t *latch) 
+{
+    zexec__worker *self = (zexec__self && zexec__self->exec == e) ? zexec__self : NULL;
+    zthread__add(&e->joiners, 1);
+    while (zthread__load(latch) > 0) 
+    {
+        ztask *t = zexec__find(e, self);
+        if (t) 
+        {
+            zexec__execute(e, t);
+            continue;
+        }
+        int64_t seen = zthread__load(&e->seq);
+        if (NULL != (t = zexec__find(e, self))) 
+        {
+            zexec__execute(e, t);
+            continue;
+        }
+        zexec__park(e, seen, latch);
+    }
+    zthread__add(&e->joiners, -1);
+}
+
+static void zexec__worker_main(void *arg) 
+{
+    zexec__worker *w = (zexec__worker*)arg;
+    zexec *e = w->exec;
+    char name[32];
+    snprintf(name, sizeof(name), "%s-%d", e->name, w->index);
+    zthread_set_name(zthread_self(), name);
+    // A pin the OS refuses (a CPU taken away since the probe, no support) leaves it unpinned.
+    if (w->cpu >= 0 && Z_OK != zthread_set_affinity(zthread_self(), &w->cpu, 1)) 
+    {
+        w->cpu = -1;
+    }
+    zexec__self = w;
+    for (;;) 
+    {
+        ztask *t = zexec__find(e, w);
+        if (t) 
+        {
+            zexec__execute(e, t);
+            continue;
+        }
+        // Snapshot, look once more, then sleep until something happens after the snapshot.
+        int64_t seen = zthread__load(&e->seq);
+        if (NULL != (t = zexec__find(e, w))) 
+        {
+            zexec__execute(e, t);
+            continue;
+        }
+        if (zthread__load(&e->stop)) 
+        {
+            break;
+        }
+        zexec__park(e, seen, NULL);
+    }
+    zexec__self = NULL;
+}
+
+// CPUs for ZEXEC_PLACE_CORES: the first sibling of every core, then the second, and so on.
+// Z_ERR when no CPU is known, so the workers run unpinned.
+static int zexec__place(int *cpus, int *nodes, int count) 
+{
+    int n = zthread_topology(NULL, 0);
+    if (n <= 0) 
+    {
+        return Z_ERR;
+    }
+    zthread_cpu_info *info = (zthread_cpu_info*)ZTHREAD_MALLOC((size_t)n * sizeof(zthread_cpu_info));
+    int *rank = (int*)ZTHREAD_MALLOC((size_t)n * sizeof(int));
+    if (!info || !rank) 
+    {
+        ZTHREAD_FREE(info);
+        ZTHREAD_FREE(rank);
+        return Z_ENOMEM;
+    }
+    // The CPU set can change between the two calls: never read past what info holds.
+    int got = zthread_topology(info, n);
+    n = got < n ? got : n;
+    if (n <= 0) 
+    {
+        ZTHREAD_FREE(rank);
+        ZTHREAD_FREE(info);
+        return Z_ERR;
+    }
+    int ranks = 0;
+    for (int i = 0; i < n; i++) 
+    {
+        rank[i] = 0;
+        for (int j = 0; j < i; j++) 
+        {
+            rank[i] += (info[j].core == info[i].core);
+        }
+        ranks = rank[i] >= ranks ? rank[i] + 1 : ranks;
+    }
+    int k = 0;
+    while (k < count) 
+    {
+        for (int r = 0; r < ranks && k < count; r++) 
+        {
+            for (int i = 0; i < n && k < count; i++) 
+            {
+                if (rank[i] == r) 
+                {
+                    cpus[k] = info[i].cpu;
+                    nodes[k] = info[i].node;
+                    k++;
+                }
+            }
+        }
+    }
+    ZTHREAD_FREE(rank);
+    ZTHREAD_FREE(info);
+    return Z_OK;
+}
+
+zexec *zexec_create(int threads) 
+{
+    zexec_options opt = { threads, ZEXEC_PLACE_NONE, NULL };
+    return zexec_create_ex(&opt);
+}
+
+zexec *zexec_create_ex(const zexec_options *opt) 
+{
+    int place = (ZEXEC_PLACE_CORES == opt->placement);
+    int want = opt->threads > 0 ? opt->threads
+             : (place ? zthread_physical_cores() : zthread_hardware_concurrency());
+    size_t count = (size_t)want;
+    zexec *e = (zexec*)ZTHREAD_CALLOC(1, sizeof(zexec));
+    if (!e) 
+    {
+        return NULL;
+    }
+    e->workers = (zexec__worker*)ZTHREAD_CALLOC(count, sizeof(zexec__worker));
+    int *cpus = (int*)ZTHREAD_MALLOC(2 * count * sizeof(int));
+    int placed = (e->workers && cpus && place) ? zexec__place(cpus, cpus + count, want) : Z_OK;
+    place = place && Z_OK == placed;
+    if (!e->workers || !cpus || Z_ENOMEM == placed) 
+    {
+        ZTHREAD_FREE(cpus);
+        ZTHREAD_FREE(e->workers);
+        ZTHREAD_FREE(e);
+        return NULL;
+    }
+    e->count = count;
+    zmutex_init(&e->lock);
+    zcond_init(&e->wake);
+    size_t len = strlen(opt->name ? opt->name : "zexec");
+    len = len < sizeof(e->name) - 1 ? len : sizeof(e->name) - 1;
+    memcpy(e->name, opt->name ? opt->name : "zexec", len);
+
+    for (size_t i = 0; i < count; i++) 
+    {
+        zexec__worker *w = &e->workers[i];
+        w->exec = e;
+        w->rng = 0x9E3779B97F4A7C15ull * (i + 1);
+        w->index = (int)i;
+        w->cpu = place ? cpus[i] : -1;
+        w->node = place ? cpus[count + i] : -1;
+        w->ring = zexec__ring_new(ZEXEC__RING_INITIAL, NULL, w->node);
+        if (!w->ring) 
+        {
+            ZTHREAD_FREE(cpus);
+            zexec_destroy(e);
+            return NULL;
+        }
+    }
+    ZTHREAD_FREE(cpus);
+    // Rings first: a started worker steals from all of them.
+    for (size_t i = 0; i < count; i++) 
+    {
+        zexec__worker *w = &e->workers[i];
+        w->started = (Z_OK == zthread_create(&w->thread, zexec__worker_main, w));
+        if (!w->started) 
+        {
+            zexec_destroy(e);
+            return NULL;
+        }
+    }
+    return e;
+}
+
+void zexec_destroy(zexec *e) 
+{
+    if (!e) 
+    {
+        return;
+    }
+    zthread__store(&e->stop, 1);
+    zthread__add(&e->seq, 1);
+    zmutex_lock(&e->lock);
+    zcond_broadcast(&e->wake);
+    zmutex_unlock(&e->lock);
+
+    for (size_t i = 0; i < e->count; i++) 
+    {
+        if (e->workers[i].started) 
+        {
+            zthread_join(e->workers[i].thread);
+        }
+    }
+    // Only reachable if no worker ever started.
+    ztask *t;
+    while (NULL != (t = zexec__find(e, NULL))) 
+    {
+        zexec__execute(e, t);
+    }
+    for (size_t i = 0; i < e->count; i++) 
+    {
+        zexec__ring *r = (zexec__ring*)e->workers[i].ring;
+        while (r) 
+        {
+            zexec__ring *prev = r->prev;
+            zexec__ring_free(r);
+            r = prev;
+        }
+    }
+    zcond_destroy(&e->wake);
+    zmutex_destroy(&e->lock);
+    ZTHREAD_FREE(e->workers);
+    ZTHREAD_FREE(e);
+}
+
+size_t zexec_threads(const zexec *e) 
+{
+    return e ? e->count : 0;
+}
+
+static ztask *zexec__task_new(zexec *e, zexec_fn fn, void *arg, int64_t *latch, int detached) 
+{
+    ztask *t = (ztask*)ZTHREAD_MALLOC(sizeof(ztask));
+    if (!t) 
+    {
+        return NULL;
+    }
+    t->fn = fn;
+    t->arg = arg;
+    t->exec = e;
+    t->next = NULL;
+    t->pending = 1;
+    t->latch = latch ? latch : (detached ? NULL : &t->pending);
+    t->detached = detached;
+    return t;
+}
+
+int zexec_submit(zexec *e, zexec_fn fn, void *arg) 
+{
+    ztask *t = zexec__task_new(e, fn, arg, NULL, 1);
+    if (!t) 
+    {
+        return Z_ENOMEM;
+    }
+    zexec__schedule(e, t);
+    return Z_OK;
+}
+
+ztask *zexec_spawn(zexec *e, zexec_fn fn, void *arg) 
+{
+    ztask *t = zexec__task_new(e, fn, arg, NULL, 0);
+    if (t) 
+    {
+        zexec__schedule(e, t);
+    }
+    return t;
+}
+
+void zexec_join(ztask *t) 
+{
+    if (!t) 
+    {
+        return;
+    }
+    zexec__wait(t->exec, &t->pending);
+    ZTHREAD_FREE(t);
+}
+
+void zexec_run(zexec *e, zexec_fn fn, void *tasks, size_t size, size_t count) 
+{
+    if (0 == count) 
+    {
+        return;
+    }
+    int64_t latch = (int64_t)count - 1;
+    for (size_t i = 1; i < count; i++) 
+    {
+        void *task = (char*)tasks + i * size;
+        ztask *t = e ? zexec__task_new(e, fn, task, &latch, 1) : NULL;
+        if (t) 
+        {
+            zexec__schedule(e, t);
+        }
+        else 
+        {
+            fn(task);
+            zthread__add(&latch, -1);
+        }
+    }
+    fn(tasks);
+    if (e) 
+    {
+        zexec__wait(e, &latch);
+    }
+}
+
+zexec *zexec_default(void) 
+{
+    zexec *e = (zexec*)zthread__load_ptr(&zexec__global);
+    if (e) 
+    {
+        return e;
+    }
+    zexec *fresh = zexec_create(0);
+    if (!fresh) 
+    {
+        return NULL;
+    }
+    if (!zthread__cas_ptr(&zexec__global, NULL, fresh)) 
+    {
+        zexec_destroy(fresh);
+    }
+    return (zexec*)zthread__load_ptr(&zexec__global);
+}
+
+int zexec_worker_index(void) 
+{
+    return zexec__self ? zexec__self->index : -1;
+}
+
+int zexec_worker_node(void) 
+{
+    return zexec__self ? zexec__self->node : -1;
+}
+
 #endif // ZTHREAD_IMPLEMENTATION_GUARD
 
 #endif // ZTHREAD_IMPLEMENTATION
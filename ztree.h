@@ -144,6 +144,58 @@
 
 
 #endif // Z_COMMON_BUNDLED
+
+// Runtime allocator handle. Not part of zcommon yet, so it stays outside the bundled block
+// above (regenerated from upstream); every ZDK header carries the same guarded copy.
+#ifndef Z_ALLOCATOR_HANDLE_DEFINED
+#define Z_ALLOCATOR_HANDLE_DEFINED
+
+/* * zalloc_t routes one container's memory through any allocator (arena, pool, ...).
+ * Containers only carry a handle when Z_ALLOCATOR_HANDLE is defined before the first
+ * ZDK include; otherwise they are laid out and compiled exactly as before.
+ * A NULL handle means the compile-time *_MALLOC macros. realloc and free also receive
+ * the old size, for allocators that do not track it.
+ */
+#ifndef Z_ALLOC_T_DEFINED
+#define Z_ALLOC_T_DEFINED
+typedef struct zalloc_t
+{
+    void *(*alloc)(void *ctx, size_t size);
+    void *(*realloc)(void *ctx, void *ptr, size_t old_size, size_t new_size);
+    void  (*free)(void *ctx, void *ptr, size_t size);
+    void *ctx;
+} zalloc_t;
+#endif
+
+#ifdef Z_ALLOCATOR_HANDLE
+#   define Z_ALLOCATOR_FIELD                   const zalloc_t *allocator;
+#   define Z_ALLOCATOR_INIT                    , NULL
+#   define Z_HMALLOC(h, sz, dflt)              ((h) ? (h)->alloc((h)->ctx, (sz)) : (dflt))
+#   define Z_HCALLOC(h, n, sz, dflt)           ((h) ? z_hcalloc__((h), (n), (sz)) : (dflt))
+#   define Z_HREALLOC(h, p, old_sz, sz, dflt)  ((h) ? (h)->realloc((h)->ctx, (p), (old_sz), (sz)) : (dflt))
+#   define Z_HFREE(h, p, sz, dflt)             ((h) ? ((p) ? (h)->free((h)->ctx, (p), (sz)) : (void)0) : (void)(dflt))
+    // Setter for a generated container; call it while the container owns no memory yet.
+#   define Z_GEN_SET_ALLOCATOR(Type, Fn)       static inline void Fn(Type *c, const zalloc_t *a) { c->allocator = a; }
+
+static inline void *z_hcalloc__(const zalloc_t *h, size_t n, size_t sz)
+{
+    if (0 != n && sz > SIZE_MAX / n) return NULL;
+    void *p = h->alloc(h->ctx, n * sz);
+    if (p) memset(p, 0, n * sz);
+    return p;
+}
+#else
+#   define Z_ALLOCATOR_FIELD
+#   define Z_ALLOCATOR_INIT
+#   define Z_HMALLOC(h, sz, dflt)              (dflt)
+#   define Z_HCALLOC(h, n, sz, dflt)           (dflt)
+#   define Z_HREALLOC(h, p, old_sz, sz, dflt)  (dflt)
+#   define Z_HFREE(h, p, sz, dflt)             (dflt)
+#   define Z_GEN_SET_ALLOCATOR(Type, Fn)
+#endif
+
+#endif // Z_ALLOCATOR_HANDLE_DEFINED
+
 /* ============================================================================ */
 
 
@@ -158,6 +210,8 @@
  * • O(log n) insert, find, and remove.
  * • Keys are always sorted.
  * • Supports lower_bound (range queries).
+ * • Optional order statistics (rank, select, count_range) and pooled nodes.
+ * • zbtree: cache-friendly B+ tree maps with bulk load and range scans.
  * • C++ z_tree::map<K, V> with RAII, iterators, and operator[].
  *
  * License: MIT
@@ -176,6 +230,7 @@
 #include <iterator>
 #include <utility>
 #include <type_traits>
+#include <new>
 
 namespace z_tree {
     template <typename K, typename V> class map;
@@ -366,6 +421,22 @@ template <typename K, typename V>
             return iterator(Traits::min(&inner), &inner);
         }
 
+        // Order statistics; these need ZTREE_AUGMENTED.
+        size_t rank(const K &k)
+        {
+            return Traits::rank(&inner, k);
+        }
+
+        iterator select(size_t i)
+        {
+            return iterator(Traits::select(&inner, i), &inner);
+        }
+
+        size_t count_range(const K &lo, const K &hi)
+        {
+            return Traits::count_range(&inner, lo, hi);
+        }
+
         iterator end()
         {
             return iterator(nullptr, &inner);
@@ -386,6 +457,166 @@ template <typename K, typename V>
             Traits::clear(&inner);
         }
     };
+
+    template <typename K, typename V>
+    struct btree_traits
+    {
+        static_assert(0 == sizeof(K), "No zbtree implementation registered for this Key/Value pair.");
+    };
+
+    // Wide-node B+ tree; keys and values are moved with memcpy.
+    template <typename K, typename V>
+    class btree
+    {
+        using Traits = btree_traits<K, V>;
+        using CTree = typename Traits::tree_type;
+        using CIter = typename Traits::iter_type;
+
+        static_assert(std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value,
+                      "z_tree::btree needs trivially copyable keys and values.");
+     public:
+        CTree inner;
+
+        class iterator
+        {
+            CIter it;
+
+         public:
+            struct EntryProxy
+            {
+                CIter it;
+                const K &key() const
+                {
+                    return *Traits::iter_key(&it);
+                }
+
+                V &value() const
+                {
+                    return *Traits::iter_value(&it);
+                }
+            };
+
+            explicit iterator(CIter i) : it(i) {}
+
+            const K &key() const
+            {
+                return *Traits::iter_key(&it);
+            }
+
+            V &value() const
+            {
+                return *Traits::iter_value(&it);
+            }
+
+            EntryProxy operator*() const
+            {
+                return EntryProxy{it};
+            }
+
+            iterator &operator++()
+            {
+                Traits::iter_next(&it);
+                return *this;
+            }
+
+            bool operator==(const iterator &other) const
+            {
+                return it.leaf == other.it.leaf && (!it.leaf || it.idx == other.it.idx);
+            }
+
+            bool operator!=(const iterator &other) const
+            {
+                return !(*this == other);
+            }
+        };
+
+        btree()
+        {
+            inner = Traits::init();
+        }
+
+        ~btree()
+        {
+            Traits::clear(&inner);
+        }
+
+        btree(const btree&) = delete;
+        btree &operator=(const btree&) = delete;
+
+        btree(btree &&other) noexcept : inner(other.inner)
+        {
+            other.inner = Traits::init();
+        }
+
+        void insert(K k, V v)
+        {
+            if (0 != Traits::insert(&inner, k, v))
+            {
+                throw std::bad_alloc();
+            }
+        }
+
+        // Fills an empty tree from strictly ascending keys; false on bad input.
+        bool bulk_load(const K *keys, const V *vals, size_t n)
+        {
+            int rc = Traits::bulk_load(&inner, const_cast<K*>(keys), const_cast<V*>(vals), n);
+            if (Z_ENOMEM == rc)
+            {
+                throw std::bad_alloc();
+            }
+            return 0 == rc;
+        }
+
+        void erase(K k)
+        {
+            Traits::remove(&inner, k);
+        }
+
+        V *find(K k)
+        {
+            return Traits::find(&inner, k);
+        }
+
+        bool contains(K k)
+        {
+            return Traits::contains(&inner, k);
+        }
+
+        iterator lower_bound(const K &k)
+        {
+            return iterator(Traits::lower_bound(&inner, k));
+        }
+
+        iterator upper_bound(const K &k)
+        {
+            return iterator(Traits::upper_bound(&inner, k));
+        }
+
+        iterator begin()
+        {
+            return iterator(Traits::first(&inner));
+        }
+
+        iterator end()
+        {
+            return iterator(CIter{nullptr, 0});
+        }
+
+        size_t size() const
+        {
+            return inner.size;
+        }
+
+        bool empty() const
+        {
+            return 0 == inner.size;
+        }
+
+        void clear()
+        {
+            Traits::clear(&inner);
+        }
+    };
 }
 extern "C" {
 #endif
@@ -413,19 +644,231 @@ typedef enum
     ZTREE_BLACK 
 } ztree_color;
 
+/*
+ * Pooled nodes.
+ * When zalloc.h (with ZALLOC_ENABLE_POOL) is included before ztree.h, a tree created with
+ * ztree_init_pool_##Name draws its nodes from a zpool it owns instead of one allocation per
+ * entry, and clear releases whole slabs instead of walking the tree.
+ */
+#if defined(ZALLOC_H) && defined(ZALLOC_ENABLE_POOL)
+#   define ZTREE_HAS_ZPOOL 1
+#else
+#   define ZTREE_HAS_ZPOOL 0
+#endif
+
+#ifndef ZTREE_POOL_DEFAULT_BLOCK
+#   define ZTREE_POOL_DEFAULT_BLOCK 64
+#endif
+
+#if ZTREE_HAS_ZPOOL
+#   define ZTREE_POOL_FIELDS__ zpool pool; bool pooled;
+#   define ZTREE_POOL_INIT__   , ZPOOL_INIT_ZERO__, false
+    // Drops every slab but keeps the pool geometry so the tree stays usable.
+#   define ZTREE_POOL_RESET__(t)                                                \
+        do                                                                      \
+        {                                                                       \
+            if ((t)->pooled)                                                    \
+            {                                                                   \
+                size_t item_size__ = (t)->pool.item_size;                       \
+                size_t per_block__ = (t)->pool.count_per_block;                 \
+                zpool_free(&(t)->pool);                                         \
+                zpool_init(&(t)->pool, item_size__, per_block__);               \
+            }                                                                   \
+        } while (0)
+#   define ZTREE_GEN_POOL_INIT__(Name)                                                  \
+        /* Pooled tree; per_block nodes per slab (0 picks ZTREE_POOL_DEFAULT_BLOCK). */ \
+        static inline ztree_##Name ztree_init_pool_##Name(size_t per_block)             \
+        {                                                                               \
+            ztree_##Name t = ztree_init_##Name();                                       \
+            zpool_init(&t.pool, sizeof(ztree_node_##Name),                              \
+                       per_block ? per_block : ZTREE_POOL_DEFAULT_BLOCK);               \
+            t.pooled = true;                                                            \
+            return t;                                                                   \
+        }
+#else
+#   define ZTREE_POOL_FIELDS__
+#   define ZTREE_POOL_INIT__
+#   define ZTREE_POOL_RESET__(t)          ((void)0)
+#   define ZTREE_GEN_POOL_INIT__(Name)
+#endif
+
+// Nodes come from the tree's pool, or its zalloc_t handle when it carries one (C only).
 #ifdef __cplusplus
-#   define ZTREE_NEW_NODE(Type, n)  Type *n = new Type()
-#   define ZTREE_FREE_NODE(n)       delete n
+#   if ZTREE_HAS_ZPOOL
+}   // extern "C"
+    template <typename T>
+    static inline T *ztree_node_new__(zpool *pool, bool pooled)
+    {
+        if (!pooled)
+        {
+            return new T();
+        }
+        void *raw = zpool_alloc(pool);
+        if (!raw)
+        {
+            throw std::bad_alloc();
+        }
+        try
+        {
+            return new (raw) T();
+        }
+        catch (...)
+        {
+            zpool_recycle(pool, raw);
+            throw;
+        }
+    }
+
+    template <typename T>
+    static inline void ztree_node_delete__(zpool *pool, bool pooled, T *n)
+    {
+        if (!pooled)
+        {
+            delete n;
+            return;
+        }
+        n->~T();
+        zpool_recycle(pool, n);
+    }
+extern "C" {
+#       define ZTREE_NEW_NODE(t, Type, n)  Type *n = ztree_node_new__<Type>(&(t)->pool, (t)->pooled)
+#       define ZTREE_FREE_NODE(t, n)       ztree_node_delete__(&(t)->pool, (t)->pooled, (n))
+#       define ZTREE_NEEDS_WALK__(t, Type) (!(t)->pooled || !std::is_trivially_destructible<Type>::value)
+#   else
+#       define ZTREE_NEW_NODE(t, Type, n)  Type *n = ((void)(t), new Type())
+#       define ZTREE_FREE_NODE(t, n)       delete n
+#       define ZTREE_NEEDS_WALK__(t, Type) 1
+#   endif
+#   define ZTREE_GEN_SET_ALLOCATOR__(Name)
 #else
-    
-#   define ZTREE_NEW_NODE(Type, n)                      \
-        Type *n = (Type*)ZTREE_MALLOC(sizeof(Type));    \
-        if (n)                                          \
-        {                                               \
-            n->parent = n->left = n->right = NULL;      \
+#   if ZTREE_HAS_ZPOOL
+#       define ZTREE_NODE_ALLOC__(t, Type) \
+            ((t)->pooled ? zpool_alloc(&(t)->pool) : Z_HMALLOC((t)->allocator, sizeof(Type), ZTREE_MALLOC(sizeof(Type))))
+#       define ZTREE_FREE_NODE(t, n)                                            \
+            do                                                                  \
+            {                                                                   \
+                if ((t)->pooled)                                                \
+                {                                                               \
+                    zpool_recycle(&(t)->pool, (n));                             \
+                }                                                               \
+                else                                                            \
+                {                                                               \
+                    Z_HFREE((t)->allocator, n, sizeof(*(n)), ZTREE_FREE(n));    \
+                }                                                               \
+            } while (0)
+#       define ZTREE_NEEDS_WALK__(t, Type) (!(t)->pooled)
+#   else
+#       define ZTREE_NODE_ALLOC__(t, Type) Z_HMALLOC((t)->allocator, sizeof(Type), ZTREE_MALLOC(sizeof(Type)))
+#       define ZTREE_FREE_NODE(t, n)       Z_HFREE((t)->allocator, n, sizeof(*(n)), ZTREE_FREE(n))
+#       define ZTREE_NEEDS_WALK__(t, Type) 1
+#   endif
+
+#   define ZTREE_NEW_NODE(t, Type, n)                                       \
+        Type *n = (Type*)ZTREE_NODE_ALLOC__(t, Type);                       \
+        if (n)                                                              \
+        {                                                                   \
+            n->parent = n->left = n->right = NULL;                          \
         }
 
-#   define ZTREE_FREE_NODE(n)       ZTREE_FREE(n)
+#   define ZTREE_GEN_SET_ALLOCATOR__(Name) Z_GEN_SET_ALLOCATOR(ztree_##Name, ztree_set_allocator_##Name)
+#endif
+
+/*
+ * Order statistics (opt-in).
+ * Define ZTREE_AUGMENTED before including ztree.h and every node also keeps the size of its
+ * subtree, refreshed through the rotations and the insert/delete fix-ups. That adds O(log n)
+ * ztree_rank, ztree_select and ztree_count_range for every registered tree.
+ *
+ * User aggregates ride on the same refresh: ZTREE_AUGMENT_FIELDS adds members to every node
+ * and ZTREE_AUGMENT_PULL(n) recomputes them from n and its children (either may be NULL).
+ * After editing a value in place, call ztree_refresh on its node to repair the path above it.
+ */
+#ifdef ZTREE_AUGMENTED
+#   ifndef ZTREE_AUGMENT_FIELDS
+#       define ZTREE_AUGMENT_FIELDS
+#   endif
+#   ifndef ZTREE_AUGMENT_PULL
+#       define ZTREE_AUGMENT_PULL(n) ((void)0)
+#   endif
+#   define ZTREE_AUG_FIELDS__     size_t count; ZTREE_AUGMENT_FIELDS
+#   define ZTREE_AUG_COUNT__(n)   ((n) ? (n)->count : 0)
+#   define ZTREE_PULL__(Name, n)  ztree__pull_##Name(n)
+#   define ZTREE_PULL_UP__(Name, n) ztree_refresh_##Name(n)
+#   define ZTREE_GEN_AUG_PULL__(Name)                                                                       \
+        static inline void ztree__pull_##Name(ztree_node_##Name *n)                                         \
+        {                                                                                                   \
+            n->count = 1 + ZTREE_AUG_COUNT__(n->left) + ZTREE_AUG_COUNT__(n->right);                        \
+            ZTREE_AUGMENT_PULL(n);                                                                          \
+        }                                                                                                   \
+                                                                                                            \
+        /* Recomputes n and every ancestor; call it after changing n's value in place. */                   \
+        static inline void ztree_refresh_##Name(ztree_node_##Name *n)                                       \
+        {                                                                                                   \
+            for (; n; n = n->parent)                                                                        \
+            {                                                                                               \
+                ztree__pull_##Name(n);                                                                      \
+            }                                                                                               \
+        }
+#   define ZTREE_GEN_AUG_QUERY__(Key, Name, Cmp)                                                            \
+        /* Number of keys strictly less than k. */                                                          \
+        static inline size_t ztree_rank_##Name(ztree_##Name *t, Key k)                                      \
+        {                                                                                                   \
+            size_t r = 0;                                                                                   \
+            ztree_node_##Name *x = t->root;                                                                 \
+            while (x)                                                                                       \
+            {                                                                                               \
+                if (Cmp(&k, &x->key) <= 0)                                                                  \
+                {                                                                                           \
+                    x = x->left;                                                                            \
+                }                                                                                           \
+                else                                                                                        \
+                {                                                                                           \
+                    r += 1 + ZTREE_AUG_COUNT__(x->left);                                                    \
+                    x = x->right;                                                                           \
+                }                                                                                           \
+            }                                                                                               \
+            return r;                                                                                       \
+        }                                                                                                   \
+                                                                                                            \
+        /* The i-th smallest node (0-based), or NULL when i >= size. */                                     \
+        static inline ztree_node_##Name *ztree_select_##Name(ztree_##Name *t, size_t i)                     \
+        {                                                                                                   \
+            ztree_node_##Name *x = t->root;                                                                 \
+            while (x)                                                                                       \
+            {                                                                                               \
+                size_t l = ZTREE_AUG_COUNT__(x->left);                                                      \
+                if (i == l)                                                                                 \
+                {                                                                                           \
+                    return x;                                                                               \
+                }                                                                                           \
+                if (i < l)                                                                                  \
+                {                                                                                           \
+                    x = x->left;                                                                            \
+                }                                                                                           \
+                else                                                                                        \
+                {                                                                                           \
+                    i -= l + 1;                                                                             \
+                    x = x->right;                                                                           \
+                }                                                                                           \
+            }                                                                                               \
+            return NULL;                                                                                    \
+        }                                                                                                   \
+                                                                                                            \
+        /* Number of keys in [lo, hi). */                                                                   \
+        static inline size_t ztree_count_range_##Name(ztree_##Name *t, Key lo, Key hi)                      \
+        {                                                                                                   \
+            if (Cmp(&lo, &hi) >= 0)                                                                         \
+            {                                                                                               \
+                return 0;                                                                                   \
+            }                                                                                               \
+            return ztree_rank_##Name(t, hi) - ztree_rank_##Name(t, lo);                                     \
+        }
+#else
+#   define ZTREE_AUG_FIELDS__
+#   define ZTREE_PULL__(Name, n)    ((void)0)
+#   define ZTREE_PULL_UP__(Name, n) ((void)0)
+#   define ZTREE_GEN_AUG_PULL__(Name)
+#   define ZTREE_GEN_AUG_QUERY__(Key, Name, Cmp)
 #endif
 
 #define ZTREE_GENERATE_IMPL(Key, Val, Name, Cmp)                                                                \
@@ -436,47 +879,62 @@ typedef enum
         Val value;                                                                                              \
         ztree_color color;                                                                                      \
         struct ztree_node_##Name *parent, *left, *right;                                                        \
+        ZTREE_AUG_FIELDS__                                                                                      \
     } ztree_node_##Name;                                                                                        \
                                                                                                                 \
+    ZTREE_GEN_AUG_PULL__(Name)                                                                                  \
+                                                                                                                \
     typedef struct                                                                                              \
     {                                                                                                           \
         ztree_node_##Name *root;                                                                                \
         size_t size;                                                                                            \
+        Z_ALLOCATOR_FIELD                                                                                       \
+        ZTREE_POOL_FIELDS__                                                                                     \
     } ztree_##Name;                                                                                             \
                                                                                                                 \
     static inline ztree_##Name ztree_init_##Name(void)                                                          \
     {                                                                                                           \
-        ztree_##Name t = {NULL, 0};                                                                             \
+        ztree_##Name t = {NULL, 0 Z_ALLOCATOR_INIT ZTREE_POOL_INIT__};                                          \
         return t;                                                                                               \
     }                                                                                                           \
                                                                                                                 \
-    static inline ztree_node_##Name *ztree__new_##Name(Key k, Val v)                                            \
+    ZTREE_GEN_POOL_INIT__(Name)                                                                                 \
+                                                                                                                \
+    ZTREE_GEN_SET_ALLOCATOR__(Name)                                                                             \
+                                                                                                                \
+    static inline ztree_node_##Name *ztree__new_##Name(ztree_##Name *t, Key k, Val v)                           \
     {                                                                                                           \
-        ZTREE_NEW_NODE(ztree_node_##Name, n);                                                                   \
+        (void)t;                                                                                                \
+        ZTREE_NEW_NODE(t, ztree_node_##Name, n);                                                                \
         if(n)                                                                                                   \
         {                                                                                                       \
             n->key = k;                                                                                         \
             n->value = v;                                                                                       \
             n->color = ZTREE_RED;                                                                               \
             n->parent = n->left = n->right = NULL;                                                              \
+            ZTREE_PULL__(Name, n);                                                                              \
         }                                                                                                       \
         return n;                                                                                               \
     }                                                                                                           \
                                                                                                                 \
-    static inline void ztree__free_rec_##Name(ztree_node_##Name *n)                                             \
+    static inline void ztree__free_rec_##Name(ztree_##Name *t, ztree_node_##Name *n)                            \
     {                                                                                                           \
         if (!n)                                                                                                 \
         {                                                                                                       \
             return;                                                                                             \
         }                                                                                                       \
-        ztree__free_rec_##Name(n->left);                                                                        \
-        ztree__free_rec_##Name(n->right);                                                                       \
-        ZTREE_FREE_NODE(n);                                                                                     \
+        ztree__free_rec_##Name(t, n->left);                                                                     \
+        ztree__free_rec_##Name(t, n->right);                                                                    \
+        ZTREE_FREE_NODE(t, n);                                                                                  \
     }                                                                                                           \
                                                                                                                 \
     static inline void ztree_clear_##Name(ztree_##Name *t)                                                      \
     {                                                                                                           \
-        ztree__free_rec_##Name(t->root);                                                                        \
+        if (ZTREE_NEEDS_WALK__(t, ztree_node_##Name))                                                           \
+        {                                                                                                       \
+            ztree__free_rec_##Name(t, t->root);                                                                 \
+        }                                                                                                       \
+        ZTREE_POOL_RESET__(t);                                                                                  \
         t->root = NULL;                                                                                         \
         t->size = 0;                                                                                            \
     }                                                                                                           \
@@ -505,6 +963,8 @@ typedef enum
         }                                                                                                       \
         y->left = x;                                                                                            \
         x->parent = y;                                                                                          \
+        ZTREE_PULL__(Name, x);                                                                                  \
+        ZTREE_PULL__(Name, y);                                                                                  \
     }                                                                                                           \
                                                                                                                 \
     static inline void ztree__rot_r_##Name(ztree_##Name *t, ztree_node_##Name *y)                               \
@@ -531,6 +991,8 @@ typedef enum
         }                                                                                                       \
         x->right = y;                                                                                           \
         y->parent = x;                                                                                          \
+        ZTREE_PULL__(Name, y);                                                                                  \
+        ZTREE_PULL__(Name, x);                                                                                  \
     }                                                                                                           \
                                                                                                                 \
     static inline void ztree__fix_ins_##Name(ztree_##Name *t, ztree_node_##Name *z)                             \
@@ -756,11 +1218,12 @@ typedef enum
             y->left->parent = y;                                                                                \
             y->color = z->color;                                                                                \
         }                                                                                                       \
+        ZTREE_PULL_UP__(Name, x_parent);                                                                        \
         if (ZTREE_BLACK == y_orig_color)                                                                        \
         {                                                                                                       \
             ztree__fix_del_##Name(t, x, x_parent);                                                              \
         }                                                                                                       \
-        ZTREE_FREE_NODE(z);                                                                                     \
+        ZTREE_FREE_NODE(t, z);                                                                                  \
         t->size--;                                                                                              \
     }                                                                                                           \
                                                                                                                 \
@@ -774,11 +1237,12 @@ typedef enum
             if (0 == cmp)                                                                                       \
             {                                                                                                   \
                 x->value = v;                                                                                   \
+                ZTREE_PULL_UP__(Name, x);                                                                       \
                 return Z_OK;                                                                                    \
             }                                                                                                   \
             x = (cmp < 0) ? x->left : x->right;                                                                 \
         }                                                                                                       \
-        ztree_node_##Name *z = ztree__new_##Name(k, v);                                                         \
+        ztree_node_##Name *z = ztree__new_##Name(t, k, v);                                                      \
         if (!z)                                                                                                 \
         {                                                                                                       \
             return Z_ENOMEM;                                                                                    \
@@ -796,6 +1260,7 @@ typedef enum
         {                                                                                                       \
             y->right = z;                                                                                       \
         }                                                                                                       \
+        ZTREE_PULL_UP__(Name, y);                                                                               \
         ztree__fix_ins_##Name(t, z);                                                                            \
         t->size++;                                                                                              \
         return Z_OK;                                                                                            \
@@ -889,7 +1354,9 @@ typedef enum
             p = p->parent;                                                                                      \
         }                                                                                                       \
         return p;                                                                                               \
-    }
+    }                                                                                                           \
+                                                                                                                \
+    ZTREE_GEN_AUG_QUERY__(Key, Name, Cmp)
 
 #ifndef REGISTER_ZTREE_TYPES
 #   if defined(__has_include) && __has_include("z_registry.h")
@@ -920,6 +1387,7 @@ Z_ALL_TREES(ZTREE_GENERATE_IMPL)
 #define T_PREV_ENTRY(K, V, Name, Cmp)     ztree_node_##Name*: ztree_prev_##Name,
 
 #define ztree_init(Name)             ztree_init_##Name()
+#define ztree_init_pool(Name, per_block) ztree_init_pool_##Name(per_block)
 
 #if defined(__GNUC__) || defined(__clang__)
 #   define ztree_autofree(Name)     __attribute__((cleanup(ztree_clear_##Name))) ztree_##Name
@@ -935,6 +1403,25 @@ Z_ALL_TREES(ZTREE_GENERATE_IMPL)
 #define ztree_next(n)           _Generic((n), Z_ALL_TREES(T_NEXT_ENTRY)   default: NULL)    (n)
 #define ztree_prev(n)           _Generic((n), Z_ALL_TREES(T_PREV_ENTRY)   default: NULL)    (n)
 
+// Order statistics, generated only under ZTREE_AUGMENTED.
+#ifdef ZTREE_AUGMENTED
+#   define T_RANK_ENTRY(K, V, Name, Cmp)    ztree_##Name*: ztree_rank_##Name,
+#   define T_SELECT_ENTRY(K, V, Name, Cmp)  ztree_##Name*: ztree_select_##Name,
+#   define T_COUNT_ENTRY(K, V, Name, Cmp)   ztree_##Name*: ztree_count_range_##Name,
+#   define T_REFRESH_ENTRY(K, V, Name, Cmp) ztree_node_##Name*: ztree_refresh_##Name,
+
+#   define ztree_rank(t, k)             _Generic((t), Z_ALL_TREES(T_RANK_ENTRY)    default: 0)       (t, k)
+#   define ztree_select(t, i)           _Generic((t), Z_ALL_TREES(T_SELECT_ENTRY)  default: NULL)    (t, i)
+#   define ztree_count_range(t, lo, hi) _Generic((t), Z_ALL_TREES(T_COUNT_ENTRY)   default: 0)       (t, lo, hi)
+#   define ztree_refresh(n)             _Generic((n), Z_ALL_TREES(T_REFRESH_ENTRY) default: (void)0) (n)
+#endif
+
+// Runtime allocator (Z_ALLOCATOR_HANDLE, C only): t must still be empty.
+#if defined(Z_ALLOCATOR_HANDLE) && !defined(__cplusplus)
+#   define T_ALLOC_ENTRY(K, V, Name, Cmp) ztree_##Name*: ztree_set_allocator_##Name,
+#   define ztree_set_allocator(t, a) _Generic((t), Z_ALL_TREES(T_ALLOC_ENTRY) default: (void)0) (t, a)
+#endif
+
 // Iteration macros.
 #if defined(__GNUC__) || defined(__clang__)
 
@@ -962,6 +1449,892 @@ Z_ALL_TREES(ZTREE_GENERATE_IMPL)
         for ((iter) = ztree_max(t); (iter) != NULL; (iter) = ztree_prev(iter))
 #endif
 
+/*
+ * B-tree ordered maps (B+ layout).
+ * Keys and values live in wide leaves that are linked both ways, so range scans walk
+ * contiguous arrays instead of chasing one node per key; inner nodes hold only
+ * separator keys and child pointers. Node capacity is derived from ZBTREE_NODE_BYTES
+ * (eight cache lines by default) and the key/value sizes. Keys and values are moved
+ * with memcpy, so they must be trivially copyable.
+ *
+ * When zalloc.h (with ZALLOC_ENABLE_POOL) is included before ztree.h, a tree created
+ * with zbtree_init_pool_##Name draws its nodes from two zpools it owns, and clear
+ * releases whole slabs instead of walking the tree.
+ */
+#ifndef DEFINE_BTREE_TYPE
+#   define DEFINE_BTREE_TYPE(Key, Val, Name)
+#endif
+
+#ifndef ZBTREE_NODE_BYTES
+#   define ZBTREE_NODE_BYTES 512
+#endif
+
+// Inner nodes keep at least two separators, so 48 levels cover any address space.
+#define ZBTREE_MAX_DEPTH 48
+
+#define ZBTREE_CAP__(per) ((ZBTREE_NODE_BYTES / (per)) < 4 ? 4 : (ZBTREE_NODE_BYTES / (per)))
+
+#if ZTREE_HAS_ZPOOL
+#   define ZBTREE_POOL_FIELDS__ zpool leaf_pool; zpool inner_pool; bool pooled;
+#   define ZBTREE_POOLED__(t)   ((t)->pooled)
+#   define ZBTREE_ALLOC__(t, pool, T)                                                   \
+        ((t)->pooled ? zpool_alloc(&(t)->pool)                                          \
+                     : Z_HMALLOC((t)->allocator, sizeof(T), ZTREE_MALLOC(sizeof(T))))
+#   define ZBTREE_RELEASE__(t, pool, p)                                                 \
+        do                                                                              \
+        {                                                                               \
+            if ((t)->pooled)                                                            \
+            {                                                                           \
+                zpool_recycle(&(t)->pool, (p));                                         \
+            }                                                                           \
+            else                                                                        \
+            {                                                                           \
+                Z_HFREE((t)->allocator, p, sizeof(*(p)), ZTREE_FREE(p));                \
+            }                                                                           \
+        } while (0)
+    // Drops every slab but keeps the pool geometry so the tree stays usable.
+#   define ZBTREE_POOL_RESET__(t)                                                       \
+        do                                                                              \
+        {                                                                               \
+            size_t leaf_sz__ = (t)->leaf_pool.item_size;                                \
+            size_t inner_sz__ = (t)->inner_pool.item_size;                              \
+            size_t per_block__ = (t)->leaf_pool.count_per_block;                        \
+            zpool_free(&(t)->leaf_pool);                                                \
+            zpool_free(&(t)->inner_pool);                                               \
+            zpool_init(&(t)->leaf_pool, leaf_sz__, per_block__);                        \
+            zpool_init(&(t)->inner_pool, inner_sz__, per_block__);                      \
+        } while (0)
+#   define ZBTREE_GEN_POOL_INIT__(Name)                                                 \
+        /* Pooled tree; per_block nodes per slab (0 picks ZTREE_POOL_DEFAULT_BLOCK). */ \
+        static inline zbtree_##Name zbtree_init_pool_##Name(size_t per_block)            \
+        {                                                                               \
+            zbtree_##Name t = zbtree_init_##Name();                                     \
+            size_t n = per_block ? per_block : ZTREE_POOL_DEFAULT_BLOCK;                \
+            zpool_init(&t.leaf_pool, sizeof(zbtree_leaf_##Name), n);                    \
+            zpool_init(&t.inner_pool, sizeof(zbtree_inner_##Name), n);                  \
+            t.pooled = true;                                                            \
+            return t;                                                                   \
+        }
+#else
+#   define ZBTREE_POOL_FIELDS__
+#   define ZBTREE_POOLED__(t)             0
+#   define ZBTREE_ALLOC__(t, pool, T)     Z_HMALLOC((t)->allocator, sizeof(T), ZTREE_MALLOC(sizeof(T)))
+#   define ZBTREE_RELEASE__(t, pool, p)   Z_HFREE((t)->allocator, p, sizeof(*(p)), ZTREE_FREE(p))
+#   define ZBTREE_POOL_RESET__(t)         ((void)0)
+#   define ZBTREE_GEN_POOL_INIT__(Name)
+#endif
+
+#ifdef __cplusplus
+#   define ZBTREE_GEN_SET_ALLOCATOR__(Name)
+#else
+#   define ZBTREE_GEN_SET_ALLOCATOR__(Name) Z_GEN_SET_ALLOCATOR(zbtree_##Name, zbtree_set_allocator_##Name)
+#endif
+
+#define ZBTREE_GENERATE_IMPL(Key, Val, Name, Cmp)                                                               \
+                                                                                                                \
+    enum                                                                                                        \
+    {                                                                                                           \
+        zbtree_leaf_cap_##Name  = ZBTREE_CAP__(sizeof(Key) + sizeof(Val)),                                      \
+        zbtree_inner_cap_##Name = ZBTREE_CAP__(sizeof(Key) + sizeof(void *)),                                   \
+        zbtree_leaf_min_##Name  = zbtree_leaf_cap_##Name / 2,                                                   \
+        zbtree_inner_min_##Name = zbtree_inner_cap_##Name / 2                                                   \
+    };                                                                                                          \
+                                                                                                                \
+    typedef struct                                                                                              \
+    {                                                                                                           \
+        uint32_t count;                                                                                         \
+    } zbtree_node_##Name;                                                                                       \
+                                                                                                                \
+    typedef struct zbtree_leaf_##Name                                                                           \
+    {                                                                                                           \
+        zbtree_node_##Name hdr;                                                                                 \
+        struct zbtree_leaf_##Name *prev, *next;                                                                 \
+        Key keys[zbtree_leaf_cap_##Name];                                                                       \
+        Val vals[zbtree_leaf_cap_##Name];                                                                       \
+    } zbtree_leaf_##Name;                                                                                       \
+                                                                                                                \
+    typedef struct                                                                                              \
+    {                                                                                                           \
+        zbtree_node_##Name hdr;                                                                                 \
+        Key keys[zbtree_inner_cap_##Name];                                                                      \
+        zbtree_node_##Name *kids[zbtree_inner_cap_##Name + 1];                                                  \
+    } zbtree_inner_##Name;                                                                                      \
+                                                                                                                \
+    typedef struct                                                                                              \
+    {                                                                                                           \
+        zbtree_node_##Name *root;                                                                               \
+        zbtree_leaf_##Name *first, *last;                                                                       \
+        size_t size;                                                                                            \
+        uint32_t height;                                                                                        \
+        ZBTREE_POOL_FIELDS__                                                                                    \
+        Z_ALLOCATOR_FIELD                                                                                       \
+    } zbtree_##Name;                                                                                            \
+                                                                                                                \
+    typedef struct                                                                                              \
+    {                                                                                                           \
+        zbtree_leaf_##Name *leaf;                                                                               \
+        uint32_t idx;                                                                                           \
+    } zbtree_iter_##Name;                                                                                       \
+                                                                                                                \
+    static inline zbtree_##Name zbtree_init_##Name(void)                                                        \
+    {                                                                                                           \
+        zbtree_##Name t;                                                                                        \
+        memset(&t, 0, sizeof(t));                                                                               \
+        return t;                                                                                               \
+    }                                                                                                           \
+                                                                                                                \
+    ZBTREE_GEN_POOL_INIT__(Name)                                                                                \
+                                                                                                                \
+    ZBTREE_GEN_SET_ALLOCATOR__(Name)                                                                            \
+                                                                                                                \
+    static inline size_t zbtree_size_##Name(const zbtree_##Name *t)                                             \
+    {                                                                                                           \
+        return t->size;                                                                                         \
+    }                                                                                                           \
+                                                                                                                \
+    /* First index whose key is >= k (upper == 0) or > k (upper == 1); branch-free. */                          \
+    static inline uint32_t zbtree__search_##Name(Key *keys, uint32_t n, Key *k, int upper)                      \
+    {                                                                                                           \
+        if (0 == n)                                                                                             \
+        {                                                                                                       \
+            return 0;                                                                                           \
+        }                                                                                                       \
+        Key *base = keys;                                                                                       \
+        while (n > 1)                                                                                           \
+        {                                                                                                       \
+            uint32_t half = n / 2;                                                                              \
+            base = (Cmp(&base[half], k) < upper) ? base + half : base;                                          \
+            n -= half;                                                                                          \
+        }                                                                                                       \
+        return (uint32_t)(base - keys) + (Cmp(base, k) < upper);                                                \
+    }                                                                                                           \
+                                                                                                                \
+    static inline zbtree_leaf_##Name *zbtree__new_leaf_##Name(zbtree_##Name *t)                                 \
+    {                                                                                                           \
+        (void)t;                                                                                                \
+        zbtree_leaf_##Name *l = (zbtree_leaf_##Name *)ZBTREE_ALLOC__(t, leaf_pool, zbtree_leaf_##Name);         \
+        if (l)                                                                                                  \
+        {                                                                                                       \
+            l->hdr.count = 0;                                                                                   \
+            l->prev = l->next = NULL;                                                                           \
+        }                                                                                                       \
+        return l;                                                                                               \
+    }                                                                                                           \
+                                                                                                                \
+    static inline zbtree_inner_##Name *zbtree__new_inner_##Name(zbtree_##Name *t)                               \
+    {                                                                                                           \
+        (void)t;                                                                                                \
+        zbtree_inner_##Name *n = (zbtree_inner_##Name *)ZBTREE_ALLOC__(t, inner_pool, zbtree_inner_##Name);     \
+        if (n)                                                                                                  \
+        {                                                                                                       \
+            n->hdr.count = 0;                                                                                   \
+        }                                                                                                       \
+        return n;                                                                                               \
+    }                                                                                                           \
+                                                                                                                \
+    static inline void zbtree__free_rec_##Name(zbtree_##Name *t, zbtree_node_##Name *n, uint32_t height)        \
+    {                                                                                                           \
+        if (height <= 1)                                                                                        \
+        {                                                                                                       \
+            zbtree_leaf_##Name *l = (zbtree_leaf_##Name *)n;                                                    \
+            ZBTREE_RELEASE__(t, leaf_pool, l);                                                                  \
+            return;                                                                                             \
+        }                                                                                                       \
+        zbtree_inner_##Name *in = (zbtree_inner_##Name *)n;                                                     \
+        for (uint32_t i = 0; i <= in->hdr.count; i++)                                                           \
+        {                                                                                                       \
+            zbtree__free_rec_##Name(t, in->kids[i], height - 1);                                                \
+        }                                                                                                       \
+        ZBTREE_RELEASE__(t, inner_pool, in);                                                                    \
+    }                                                                                                           \
+                                                                                                                \
+    static inline void zbtree_clear_##Name(zbtree_##Name *t)                                                    \
+    {                                                                                                           \
+        if (ZBTREE_POOLED__(t))                                                                                 \
+        {                                                                                                       \
+            ZBTREE_POOL_RESET__(t);                                                                             \
+        }                                                                                                       \
+        else if (t->root)                                                                                       \
+        {                                                                                                       \
+            zbtree__free_rec_##Name(t, t->root, t->height);                                                     \
+        }                                                                                                       \
+        t->root = NULL;                                                                                         \
+        t->first = t->last = NULL;                                                                              \
+        t->size = 0;                                                                                            \
+        t->height = 0;                                                                                          \
+    }                                                                                                           \
+                                                                                                                \
+    static inline zbtree_leaf_##Name *zbtree__leaf_for_##Name(zbtree_##Name *t, Key *k)                         \
+    {                                                                                                           \
+        zbtree_node_##Name *n = t->root;                                                                        \
+        for (uint32_t h = t->height; h > 1; h--)                                                                \
+        {                                                                                                       \
+            zbtree_inner_##Name *in = (zbtree_inner_##Name *)n;                                                 \
+            n = in->kids[zbtree__search_##Name(in->keys, in->hdr.count, k, 1)];                                 \
+        }                                                                                                       \
+        return (zbtree_leaf_##Name *)n;                                                                         \
+    }                                                                                                           \
+                                                                                                                \
+    static inline Val *zbtree_find_##Name(zbtree_##Name *t, Key k)                                              \
+    {                                                                                                           \
+        if (!t->root)                                                                                           \
+        {                                                                                                       \
+            return NULL;                                                                                        \
+        }                                                                                                       \
+        zbtree_leaf_##Name *l = zbtree__leaf_for_##Name(t, &k);                                                 \
+        uint32_t i = zbtree__search_##Name(l->keys, l->hdr.count, &k, 0);                                       \
+        if (i < l->hdr.count && 0 == Cmp(&l->keys[i], &k))                                                      \
+        {                                                                                                       \
+            return &l->vals[i];                                                                                 \
+        }                                                                                                       \
+        return NULL;                                                                                            \
+    }                                                                                                           \
+                                                                                                                \
+    static inline bool zbtree_contains_##Name(zbtree_##Name *t, Key k)                                          \
+    {                                                                                                           \
+        return NULL != zbtree_find_##Name(t, k);                                                                \
+    }                                                                                                           \
+                                                                                                                \
+    /* Inserts or overwrites. Every node a split needs is allocated up front, so Z_ENOMEM */                    \
+    /* leaves the tree untouched. */                                                                            \
+    static inline int zbtree_insert_##Name(zbtree_##Name *t, Key k, Val v)                                      \
+    {                                                                                                           \
+        if (!t->root)                                                                                           \
+        {                                                                                                       \
+            zbtree_leaf_##Name *l = zbtree__new_leaf_##Name(t);                                                 \
+            if (!l)                                                                                             \
+            {                                                                                                   \
+                return Z_ENOMEM;                                                                                \
+            }                                                                                                   \
+            l->keys[0] = k;                                                                                     \
+            l->vals[0] = v;                                                                                     \
+            l->hdr.count = 1;                                                                                   \
+            t->root = &l->hdr;                                                                                  \
+            t->first = t->last = l;                                                                             \
+            t->height = 1;                                                                                      \
+            t->size = 1;                                                                                        \
+            return Z_OK;                                                                                        \
+        }                                                                                                       \
+                                                                                                                \
+        zbtree_inner_##Name *path[ZBTREE_MAX_DEPTH];                                                            \
+        uint32_t slot[ZBTREE_MAX_DEPTH];                                                                        \
+        uint32_t depth = 0;                                                                                     \
+        zbtree_node_##Name *n = t->root;                                                                        \
+        for (uint32_t h = t->height; h > 1; h--)                                                                \
+        {                                                                                                       \
+            zbtree_inner_##Name *in = (zbtree_inner_##Name *)n;                                                 \
+            uint32_t i = zbtree__search_##Name(in->keys, in->hdr.count, &k, 1);                                 \
+            path[depth] = in;                                                                                   \
+            slot[depth] = i;                                                                                    \
+            depth++;                                                                                            \
+            n = in->kids[i];                                                                                    \
+        }                                                                                                       \
+                                                                                                                \
+        zbtree_leaf_##Name *leaf = (zbtree_leaf_##Name *)n;                                                     \
+        uint32_t pos = zbtree__search_##Name(leaf->keys, leaf->hdr.count, &k, 0);                               \
+        if (pos < leaf->hdr.count && 0 == Cmp(&leaf->keys[pos], &k))                                            \
+        {                                                                                                       \
+            leaf->vals[pos] = v;                                                                                \
+            return Z_OK;                                                                                        \
+        }                                                                                                       \
+                                                                                                                \
+        if (leaf->hdr.count < (uint32_t)zbtree_leaf_cap_##Name)                                                 \
+        {                                                                                                       \
+            uint32_t tail = leaf->hdr.count - pos;                                                              \
+            memmove(&leaf->keys[pos + 1], &leaf->keys[pos], tail * sizeof(Key));                                \
+            memmove(&leaf->vals[pos + 1], &leaf->vals[pos], tail * sizeof(Val));                                \
+            leaf->keys[pos] = k;                                                                                \
+            leaf->vals[pos] = v;                                                                                \
+            leaf->hdr.count++;                                                                                  \
+            t->size++;                                                                                          \
+            return Z_OK;                                                                                        \
+        }                                                                                                       \
+                                                                                                                \
+        /* Count the full ancestors that will split too, plus a new root if all of them do. */                  \
+        uint32_t splits = 0;                                                                                    \
+        while (splits < depth && path[depth - 1 - splits]->hdr.count == (uint32_t)zbtree_inner_cap_##Name)      \
+        {                                                                                                       \
+            splits++;                                                                                           \
+        }                                                                                                       \
+        uint32_t need_inner = splits + (splits == depth ? 1 : 0);                                               \
+        zbtree_inner_##Name *spare[ZBTREE_MAX_DEPTH + 1];                                                       \
+        zbtree_leaf_##Name *right = zbtree__new_leaf_##Name(t);                                                 \
+        uint32_t got = 0;                                                                                       \
+        while (right && got < need_inner && NULL != (spare[got] = zbtree__new_inner_##Name(t)))                 \
+        {                                                                                                       \
+            got++;                                                                                              \
+        }                                                                                                       \
+        if (!right || got < need_inner)                                                                         \
+        {                                                                                                       \
+            while (got > 0)                                                                                     \
+            {                                                                                                   \
+                got--;                                                                                          \
+                ZBTREE_RELEASE__(t, inner_pool, spare[got]);                                                    \
+            }                                                                                                   \
+            if (right)                                                                                          \
+            {                                                                                                   \
+                ZBTREE_RELEASE__(t, leaf_pool, right);                                                          \
+            }                                                                                                   \
+            return Z_ENOMEM;                                                                                    \
+        }                                                                                                       \
+                                                                                                                \
+        /* Appending past the last leaf starts a new one instead of halving, so ascending */                    \
+        /* (time-ordered) inserts leave full leaves behind. */                                                  \
+        uint32_t cap = (uint32_t)zbtree_leaf_cap_##Name;                                                        \
+        uint32_t keep = (!leaf->next && pos == cap) ? cap : (cap + 1) / 2;                                      \
+        if (pos < keep)                                                                                         \
+        {                                                                                                       \
+            uint32_t moved = cap - (keep - 1);                                                                  \
+            memcpy(right->keys, &leaf->keys[keep - 1], moved * sizeof(Key));                                    \
+            memcpy(right->vals, &leaf->vals[keep - 1], moved * sizeof(Val));                                    \
+            right->hdr.count = moved;                                                                           \
+            leaf->hdr.count = keep - 1;                                                                         \
+            uint32_t tail = leaf->hdr.count - pos;                                                              \
+            memmove(&leaf->keys[pos + 1], &leaf->keys[pos], tail * sizeof(Key));                                \
+            memmove(&leaf->vals[pos + 1], &leaf->vals[pos], tail * sizeof(Val));                                \
+            leaf->keys[pos] = k;                                                                                \
+            leaf->vals[pos] = v;                                                                                \
+            leaf->hdr.count++;                                                                                  \
+        }                                                                                                       \
+        else                                                                                                    \
+        {                                                                                                       \
+            uint32_t moved = cap - keep;                                                                        \
+            uint32_t at = pos - keep;                                                                           \
+            memcpy(right->keys, &leaf->keys[keep], at * sizeof(Key));                                           \
+            memcpy(right->vals, &leaf->vals[keep], at * sizeof(Val));                                           \
+            right->keys[at] = k;                                                                                \
+            right->vals[at] = v;                                                                                \
+            memcpy(&right->keys[at + 1], &leaf->keys[pos], (moved - at) * sizeof(Key));                         \
+            memcpy(&right->vals[at + 1], &leaf->vals[pos], (moved - at) * sizeof(Val));                         \
+            right->hdr.count = moved + 1;                                                                       \
+            leaf->hdr.count = keep;                                                                             \
+        }                                                                                                       \
+        right->next = leaf->next;                                                                               \
+        right->prev = leaf;                                                                                     \
+        if (leaf->next)                                                                                         \
+        {                                                                                                       \
+            leaf->next->prev = right;                                                                           \
+        }                                                                                                       \
+        else                                                                                                    \
+        {                                                                                                       \
+            t->last = right;                                                                                    \
+        }                                                                                                       \
+        leaf->next = right;                                                                                     \
+        t->size++;                                                                                              \
+                                                                                                                \
+        /* Push the separator up; each full ancestor splits around its middle key. */                           \
+        Key sep = right->keys[0];                                                                               \
+        zbtree_node_##Name *child = &right->hdr;                                                                \
+        uint32_t used = 0;                                                                                      \
+        while (depth > 0)                                                                                       \
+        {                                                                                                       \
+            depth--;                                                                                            \
+            zbtree_inner_##Name *in = path[depth];                                                              \
+            uint32_t i = slot[depth];                                                                           \
+            uint32_t cnt = in->hdr.count;                                                                       \
+            if (cnt < (uint32_t)zbtree_inner_cap_##Name)                                                        \
+            {                                                                                                   \
+                memmove(&in->keys[i + 1], &in->keys[i], (cnt - i) * sizeof(Key));                               \
+                memmove(&in->kids[i + 2], &in->kids[i + 1], (cnt - i) * sizeof(in->kids[0]));                   \
+                in->keys[i] = sep;                                                                              \
+                in->kids[i + 1] = child;                                                                        \
+                in->hdr.count++;                                                                                \
+                return Z_OK;                                                                                    \
+            }                                                                                                   \
+                                                                                                                \
+            Key tk[zbtree_inner_cap_##Name + 1];                                                                \
+            zbtree_node_##Name *tc[zbtree_inner_cap_##Name + 2];                                                \
+            memcpy(tk, in->keys, i * sizeof(Key));                                                              \
+            tk[i] = sep;                                                                                        \
+            memcpy(&tk[i + 1], &in->keys[i], (cnt - i) * sizeof(Key));                                          \
+            memcpy(tc, in->kids, (i + 1) * sizeof(tc[0]));                                                      \
+            tc[i + 1] = child;                                                                                  \
+            memcpy(&tc[i + 2], &in->kids[i + 1], (cnt - i) * sizeof(tc[0]));                                    \
+                                                                                                                \
+            uint32_t mid = (cnt + 1) / 2;                                                                       \
+            zbtree_inner_##Name *sib = spare[used++];                                                           \
+            memcpy(in->keys, tk, mid * sizeof(Key));                                                            \
+            memcpy(in->kids, tc, (mid + 1) * sizeof(tc[0]));                                                    \
+            in->hdr.count = mid;                                                                                \
+            sib->hdr.count = cnt - mid;                                                                         \
+            memcpy(sib->keys, &tk[mid + 1], sib->hdr.count * sizeof(Key));                                      \
+            memcpy(sib->kids, &tc[mid + 1], (sib->hdr.count + 1) * sizeof(tc[0]));                              \
+            sep = tk[mid];                                                                                      \
+            child = &sib->hdr;                                                                                  \
+        }                                                                                                       \
+                                                                                                                \
+        zbtree_inner_##Name *root = spare[used];                                                                \
+        root->keys[0] = sep;                                                                                    \
+        root->kids[0] = t->root;                                                                                \
+        root->kids[1] = child;                                                                                  \
+        root->hdr.count = 1;                                                                                    \
+        t->root = &root->hdr;                                                                                   \
+        t->height++;                                                                                            \
+        return Z_OK;                                                                                            \
+    }                                                                                                           \
+                                                                                                                \
+    /* Drops key i and the child right of it from an inner node. */                                             \
+    static inline void zbtree__inner_drop_##Name(zbtree_inner_##Name *in, uint32_t i)                           \
+    {                                                                                                           \
+        uint32_t cnt = in->hdr.count;                                                                           \
+        memmove(&in->keys[i], &in->keys[i + 1], (cnt - i - 1) * sizeof(Key));                                   \
+        memmove(&in->kids[i + 1], &in->kids[i + 2], (cnt - i - 1) * sizeof(in->kids[0]));                       \
+        in->hdr.count--;                                                                                        \
+    }                                                                                                           \
+                                                                                                                \
+    /* Refills an underfull leaf from a sibling, or merges it away. */                                          \
+    static inline void zbtree__fix_leaf_##Name(zbtree_##Name *t, zbtree_leaf_##Name *l,                         \
+                                               zbtree_inner_##Name *p, uint32_t i)                              \
+    {                                                                                                           \
+        zbtree_leaf_##Name *left = (i > 0) ? (zbtree_leaf_##Name *)p->kids[i - 1] : NULL;                       \
+        zbtree_leaf_##Name *right = (i < p->hdr.count) ? (zbtree_leaf_##Name *)p->kids[i + 1] : NULL;           \
+        if (left && left->hdr.count > (uint32_t)zbtree_leaf_min_##Name)                                         \
+        {                                                                                                       \
+            memmove(&l->keys[1], &l->keys[0], l->hdr.count * sizeof(Key));                                      \
+            memmove(&l->vals[1], &l->vals[0], l->hdr.count * sizeof(Val));                                      \
+            left->hdr.count--;                                                                                  \
+            l->keys[0] = left->keys[left->hdr.count];                                                           \
+            l->vals[0] = left->vals[left->hdr.count];                                                           \
+            l->hdr.count++;                                                                                     \
+            p->keys[i - 1] = l->keys[0];                                                                        \
+            return;                                                                                             \
+        }                                                                                                       \
+        if (right && right->hdr.count > (uint32_t)zbtree_leaf_min_##Name)                                       \
+        {                                                                                                       \
+            l->keys[l->hdr.count] = right->keys[0];                                                             \
+            l->vals[l->hdr.count] = right->vals[0];                                                             \
+            l->hdr.count++;                                                                                     \
+            right->hdr.count--;                                                                                 \
+            memmove(&right->keys[0], &right->keys[1], right->hdr.count * sizeof(Key));                          \
+            memmove(&right->vals[0], &right->vals[1], right->hdr.count * sizeof(Val));                          \
+            p->keys[i] = right->keys[0];                                                                        \
+            return;                                                                                             \
+        }                                                                                                       \
+        if (left)                                                                                               \
+        {                                                                                                       \
+            right = l;                                                                                          \
+            l = left;                                                                                           \
+            i--;                                                                                                \
+        }                                                                                                       \
+        else if (!right)                                                                                        \
+        {                                                                                                       \
+            return;                                                                                             \
+        }                                                                                                       \
+        memcpy(&l->keys[l->hdr.count], right->keys, right->hdr.count * sizeof(Key));                            \
+        memcpy(&l->vals[l->hdr.count], right->vals, right->hdr.count * sizeof(Val));                            \
+        l->hdr.count += right->hdr.count;                                                                       \
+        l->next = right->next;                                                                                  \
+        if (right->next)                                                                                        \
+        {                                                                                                       \
+            right->next->prev = l;                                                                              \
+        }                                                                                                       \
+        else                                                                                                    \
+        {                                                                                                       \
+            t->last = l;                                                                                        \
+        }                                                                                                       \
+        ZBTREE_RELEASE__(t, leaf_pool, right);                                                                  \
+        zbtree__inner_drop_##Name(p, i);                                                                        \
+    }                                                                                                           \
+                                                                                                                \
+    /* Same for an inner node: rotate a key through the parent, or merge around it. */                          \
+    static inline void zbtree__fix_inner_##Name(zbtree_##Name *t, zbtree_inner_##Name *n,                       \
+                                                zbtree_inner_##Name *p, uint32_t i)                             \
+    {                                                                                                           \
+        (void)t;                                                                                                \
+        zbtree_inner_##Name *left = (i > 0) ? (zbtree_inner_##Name *)p->kids[i - 1] : NULL;                     \
+        zbtree_inner_##Name *right = (i < p->hdr.count) ? (zbtree_inner_##Name *)p->kids[i + 1] : NULL;         \
+        if (left && left->hdr.count > (uint32_t)zbtree_inner_min_##Name)                                        \
+        {                                                                                                       \
+            memmove(&n->keys[1], &n->keys[0], n->hdr.count * sizeof(Key));                                      \
+            memmove(&n->kids[1], &n->kids[0], (n->hdr.count + 1) * sizeof(n->kids[0]));                         \
+            n->keys[0] = p->keys[i - 1];                                                                        \
+            n->kids[0] = left->kids[left->hdr.count];                                                           \
+            n->hdr.count++;                                                                                     \
+            p->keys[i - 1] = left->keys[left->hdr.count - 1];                                                   \
+            left->hdr.count--;                                                                                  \
+            return;                                                                                             \
+        }                                                                                                       \
+        if (right && right->hdr.count > (uint32_t)zbtree_inner_min_##Name)                                      \
+        {                                                                                                       \
+            n->keys[n->hdr.count] = p->keys[i];                                                                 \
+            n->kids[n->hdr.count + 1] = right->kids[0];                                                         \
+            n->hdr.count++;                                                                                     \
+            p->keys[i] = right->keys[0];                                                                        \
+            memmove(&right->keys[0], &right->keys[1], (right->hdr.count - 1) * sizeof(Key));                    \
+            memmove(&right->kids[0], &right->kids[1], right->hdr.count * sizeof(right->kids[0]));               \
+            right->hdr.count--;                                                                                 \
+            return;                                                                                             \
+        }                                                                                                       \
+        if (left)                                                                                               \
+        {                                                                                                       \
+            right = n;                                                                                          \
+            n = left;                                                                                           \
+            i--;                                                                                                \
+        }                                                                                                       \
+        else if (!right)                                                                                        \
+        {                                                                                                       \
+            return;                                                                                             \
+        }                                                                                                       \
+        n->keys[n->hdr.count] = p->keys[i];                                                                     \
+        memcpy(&n->keys[n->hdr.count + 1], right->keys, right->hdr.count * sizeof(Key));                        \
+        memcpy(&n->kids[n->hdr.count + 1], right->kids, (right->hdr.count + 1) * sizeof(n->kids[0]));           \
+        n->hdr.count += 1 + right->hdr.count;                                                                   \
+        ZBTREE_RELEASE__(t, inner_pool, right);                                                                 \
+        zbtree__inner_drop_##Name(p, i);                                                                        \
+    }                                                                                                           \
+                                                                                                                \
+    static inline void zbtree_remove_##Name(zbtree_##Name *t, Key k)                                            \
+    {                                                                                                           \
+        if (!t->root)                                                                                           \
+        {                                                                                                       \
+            return;                                                                                             \
+        }                                                                                                       \
+                                                                                                                \
+        zbtree_inner_##Name *path[ZBTREE_MAX_DEPTH];                                                            \
+        uint32_t slot[ZBTREE_MAX_DEPTH];                                                                        \
+        uint32_t depth = 0;                                                                                     \
+        zbtree_node_##Name *n = t->root;                                                                        \
+        for (uint32_t h = t->height; h > 1; h--)                                                                \
+        {                                                                                                       \
+            zbtree_inner_##Name *in = (zbtree_inner_##Name *)n;                                                 \
+            uint32_t i = zbtree__search_##Name(in->keys, in->hdr.count, &k, 1);                                 \
+            path[depth] = in;                                                                                   \
+            slot[depth] = i;                                                                                    \
+            depth++;                                                                                            \
+            n = in->kids[i];                                                                                    \
+        }                                                                                                       \
+                                                                                                                \
+        zbtree_leaf_##Name *leaf = (zbtree_leaf_##Name *)n;                                                     \
+        uint32_t pos = zbtree__search_##Name(leaf->keys, leaf->hdr.count, &k, 0);                               \
+        if (pos >= leaf->hdr.count || 0 != Cmp(&leaf->keys[pos], &k))                                           \
+        {                                                                                                       \
+            return;                                                                                             \
+        }                                                                                                       \
+        uint32_t tail = leaf->hdr.count - pos - 1;                                                              \
+        memmove(&leaf->keys[pos], &leaf->keys[pos + 1], tail * sizeof(Key));                                    \
+        memmove(&leaf->vals[pos], &leaf->vals[pos + 1], tail * sizeof(Val));                                    \
+        leaf->hdr.count--;                                                                                      \
+        t->size--;                                                                                              \
+                                                                                                                \
+        if (0 == depth)                                                                                         \
+        {                                                                                                       \
+            if (0 == leaf->hdr.count)                                                                           \
+            {                                                                                                   \
+                ZBTREE_RELEASE__(t, leaf_pool, leaf);                                                           \
+                t->root = NULL;                                                                                 \
+                t->first = t->last = NULL;                                                                      \
+                t->height = 0;                                                                                  \
+            }                                                                                                   \
+            return;                                                                                             \
+        }                                                                                                       \
+        if (leaf->hdr.count >= (uint32_t)zbtree_leaf_min_##Name)                                                \
+        {                                                                                                       \
+            return;                                                                                             \
+        }                                                                                                       \
+                                                                                                                \
+        zbtree__fix_leaf_##Name(t, leaf, path[depth - 1], slot[depth - 1]);                                     \
+        while (--depth > 0)                                                                                     \
+        {                                                                                                       \
+            zbtree_inner_##Name *in = path[depth];                                                              \
+            if (in->hdr.count >= (uint32_t)zbtree_inner_min_##Name)                                             \
+            {                                                                                                   \
+                return;                                                                                         \
+            }                                                                                                   \
+            zbtree__fix_inner_##Name(t, in, path[depth - 1], slot[depth - 1]);                                  \
+        }                                                                                                       \
+                                                                                                                \
+        zbtree_inner_##Name *root = path[0];                                                                    \
+        if (0 == root->hdr.count)                                                                               \
+        {                                                                                                       \
+            t->root = root->kids[0];                                                                            \
+            t->height--;                                                                                        \
+            ZBTREE_RELEASE__(t, inner_pool, root);                                                              \
+        }                                                                                                       \
+    }                                                                                                           \
+                                                                                                                \
+    /* Builds the tree from n strictly ascending keys in O(n), with evenly filled nodes. */                     \
+    /* The tree must be empty; unsorted or duplicate input returns Z_EINVAL. */                                 \
+    static inline int zbtree_bulk_load_##Name(zbtree_##Name *t, Key *keys, Val *vals, size_t n)                 \
+    {                                                                                                           \
+        if (t->root)                                                                                            \
+        {                                                                                                       \
+            return Z_EINVAL;                                                                                    \
+        }                                                                                                       \
+        for (size_t i = 1; i < n; i++)                                                                          \
+        {                                                                                                       \
+            if (Cmp(&keys[i - 1], &keys[i]) >= 0)                                                               \
+            {                                                                                                   \
+                return Z_EINVAL;                                                                                \
+            }                                                                                                   \
+        }                                                                                                       \
+        if (0 == n)                                                                                             \
+        {                                                                                                       \
+            return Z_OK;                                                                                        \
+        }                                                                                                       \
+                                                                                                                \
+        size_t count = (n + zbtree_leaf_cap_##Name - 1) / zbtree_leaf_cap_##Name;                               \
+        size_t slots = count; /* count shrinks per level; the scratch keeps its size */                         \
+        zbtree_node_##Name **level = (zbtree_node_##Name **)Z_HMALLOC(t->allocator,                             \
+            slots * sizeof(zbtree_node_##Name *), ZTREE_MALLOC(slots * sizeof(zbtree_node_##Name *)));          \
+        Key *mins = (Key *)Z_HMALLOC(t->allocator, slots * sizeof(Key), ZTREE_MALLOC(slots * sizeof(Key)));     \
+        if (!level || !mins)                                                                                    \
+        {                                                                                                       \
+            Z_HFREE(t->allocator, level, slots * sizeof(zbtree_node_##Name *), ZTREE_FREE(level));              \
+            Z_HFREE(t->allocator, mins, slots * sizeof(Key), ZTREE_FREE(mins));                                 \
+            return Z_ENOMEM;                                                                                    \
+        }                                                                                                       \
+                                                                                                                \
+        size_t src = 0;                                                                                         \
+        zbtree_leaf_##Name *prev = NULL;                                                                        \
+        for (size_t j = 0; j < count; j++)                                                                      \
+        {                                                                                                       \
+            zbtree_leaf_##Name *l = zbtree__new_leaf_##Name(t);                                                 \
+            if (!l)                                                                                             \
+            {                                                                                                   \
+                for (size_t q = 0; q < j; q++)                                                                  \
+                {                                                                                               \
+                    zbtree__free_rec_##Name(t, level[q], 1);                                                    \
+                }                                                                                               \
+                t->first = NULL;                                                                                \
+                Z_HFREE(t->allocator, level, slots * sizeof(zbtree_node_##Name *), ZTREE_FREE(level));          \
+                Z_HFREE(t->allocator, mins, slots * sizeof(Key), ZTREE_FREE(mins));                             \
+                return Z_ENOMEM;                                                                                \
+            }                                                                                                   \
+            uint32_t take = (uint32_t)(n / count + (j < n % count ? 1 : 0));                                    \
+            memcpy(l->keys, &keys[src], take * sizeof(Key));                                                    \
+            memcpy(l->vals, &vals[src], take * sizeof(Val));                                                    \
+            l->hdr.count = take;                                                                                \
+            src += take;                                                                                        \
+            l->prev = prev;                                                                                     \
+            if (prev)                                                                                           \
+            {                                                                                                   \
+                prev->next = l;                                                                                 \
+            }                                                                                                   \
+            else                                                                                                \
+            {                                                                                                   \
+                t->first = l;                                                                                   \
+            }                                                                                                   \
+            prev = l;                                                                                           \
+            level[j] = &l->hdr;                                                                                 \
+            mins[j] = l->keys[0];                                                                               \
+        }                                                                                                       \
+        t->last = prev;                                                                                         \
+                                                                                                                \
+        uint32_t height = 1;                                                                                    \
+        while (count > 1)                                                                                       \
+        {                                                                                                       \
+            size_t fan = (size_t)zbtree_inner_cap_##Name + 1;                                                   \
+            size_t parents = (count + fan - 1) / fan;                                                           \
+            size_t j = 0;                                                                                       \
+            for (size_t p = 0; p < parents; p++)                                                                \
+            {                                                                                                   \
+                zbtree_inner_##Name *in = zbtree__new_inner_##Name(t);                                          \
+                if (!in)                                                                                        \
+                {                                                                                               \
+                    for (size_t q = 0; q < p; q++)                                                              \
+                    {                                                                                           \
+                        zbtree__free_rec_##Name(t, level[q], height + 1);                                       \
+                    }                                                                                           \
+                    for (; j < count; j++)                                                                      \
+                    {                                                                                           \
+                        zbtree__free_rec_##Name(t, level[j], height);                                           \
+                    }                                                                                           \
+                    Z_HFREE(t->allocator, level, slots * sizeof(zbtree_node_##Name *), ZTREE_FREE(level));      \
+                    Z_HFREE(t->allocator, mins, slots * sizeof(Key), ZTREE_FREE(mins));                         \
+                    t->first = t->last = NULL;                                                                  \
+                    return Z_ENOMEM;                                                                            \
+                }                                                                                               \
+                size_t kids = count / parents + (p < count % parents ? 1 : 0);                                  \
+                Key lo = mins[j];                                                                               \
+                for (size_t c = 0; c < kids; c++)                                                               \
+                {                                                                                               \
+                    in->kids[c] = level[j + c];                                                                 \
+                    if (c > 0)                                                                                  \
+                    {                                                                                           \
+                        in->keys[c - 1] = mins[j + c];                                                          \
+                    }                                                                                           \
+                }                                                                                               \
+                in->hdr.count = (uint32_t)(kids - 1);                                                           \
+                j += kids;                                                                                      \
+                level[p] = &in->hdr;                                                                            \
+                mins[p] = lo;                                                                                   \
+            }                                                                                                   \
+            count = parents;                                                                                    \
+            height++;                                                                                           \
+        }                                                                                                       \
+                                                                                                                \
+        t->root = level[0];                                                                                     \
+        t->height = height;                                                                                     \
+        t->size = n;                                                                                            \
+        Z_HFREE(t->allocator, level, slots * sizeof(zbtree_node_##Name *), ZTREE_FREE(level));                  \
+        Z_HFREE(t->allocator, mins, slots * sizeof(Key), ZTREE_FREE(mins));                                     \
+        return Z_OK;                                                                                            \
+    }                                                                                                           \
+                                                                                                                \
+    static inline zbtree_iter_##Name zbtree_first_##Name(zbtree_##Name *t)                                      \
+    {                                                                                                           \
+        zbtree_iter_##Name it = { t->first, 0 };                                                                \
+        return it;                                                                                              \
+    }                                                                                                           \
+                                                                                                                \
+    static inline zbtree_iter_##Name zbtree_last_##Name(zbtree_##Name *t)                                       \
+    {                                                                                                           \
+        zbtree_iter_##Name it = { t->last, t->last ? t->last->hdr.count - 1 : 0 };                              \
+        return it;                                                                                              \
+    }                                                                                                           \
+                                                                                                                \
+    static inline zbtree_iter_##Name zbtree__bound_##Name(zbtree_##Name *t, Key *k, int upper)                  \
+    {                                                                                                           \
+        zbtree_iter_##Name it = { NULL, 0 };                                                                    \
+        if (!t->root)                                                                                           \
+        {                                                                                                       \
+            return it;                                                                                          \
+        }                                                                                                       \
+        zbtree_leaf_##Name *l = zbtree__leaf_for_##Name(t, k);                                                  \
+        uint32_t i = zbtree__search_##Name(l->keys, l->hdr.count, k, upper);                                    \
+        if (i == l->hdr.count)                                                                                  \
+        {                                                                                                       \
+            l = l->next;                                                                                        \
+            i = 0;                                                                                              \
+        }                                                                                                       \
+        it.leaf = l;                                                                                            \
+        it.idx = i;                                                                                             \
+        return it;                                                                                              \
+    }                                                                                                           \
+                                                                                                                \
+    /* First entry with key >= k (invalid iterator when there is none). */                                      \
+    static inline zbtree_iter_##Name zbtree_lower_bound_##Name(zbtree_##Name *t, Key k)                         \
+    {                                                                                                           \
+        return zbtree__bound_##Name(t, &k, 0);                                                                  \
+    }                                                                                                           \
+                                                                                                                \
+    /* First entry with key > k. */                                                                             \
+    static inline zbtree_iter_##Name zbtree_upper_bound_##Name(zbtree_##Name *t, Key k)                         \
+    {                                                                                                           \
+        return zbtree__bound_##Name(t, &k, 1);                                                                  \
+    }                                                                                                           \
+                                                                                                                \
+    static inline bool zbtree_iter_valid_##Name(const zbtree_iter_##Name *it)                                   \
+    {                                                                                                           \
+        return NULL != it->leaf;                                                                                \
+    }                                                                                                           \
+                                                                                                                \
+    static inline Key *zbtree_iter_key_##Name(const zbtree_iter_##Name *it)                                     \
+    {                                                                                                           \
+        return &it->leaf->keys[it->idx];                                                                        \
+    }                                                                                                           \
+                                                                                                                \
+    static inline Val *zbtree_iter_value_##Name(const zbtree_iter_##Name *it)                                   \
+    {                                                                                                           \
+        return &it->leaf->vals[it->idx];                                                                        \
+    }                                                                                                           \
+                                                                                                                \
+    static inline void zbtree_iter_next_##Name(zbtree_iter_##Name *it)                                          \
+    {                                                                                                           \
+        if (++it->idx >= it->leaf->hdr.count)                                                                   \
+        {                                                                                                       \
+            it->leaf = it->leaf->next;                                                                          \
+            it->idx = 0;                                                                                        \
+        }                                                                                                       \
+    }                                                                                                           \
+                                                                                                                \
+    static inline void zbtree_iter_prev_##Name(zbtree_iter_##Name *it)                                          \
+    {                                                                                                           \
+        if (0 == it->idx)                                                                                       \
+        {                                                                                                       \
+            it->leaf = it->leaf->prev;                                                                          \
+            it->idx = it->leaf ? it->leaf->hdr.count - 1 : 0;                                                   \
+            return;                                                                                             \
+        }                                                                                                       \
+        it->idx--;                                                                                              \
+    }                                                                                                           \
+                                                                                                                \
+    /* True while the iterator is valid and its key is below hi: the range scan test. */                        \
+    static inline bool zbtree_iter_before_##Name(const zbtree_iter_##Name *it, Key hi)                          \
+    {                                                                                                           \
+        return it->leaf && Cmp(&it->leaf->keys[it->idx], &hi) < 0;                                              \
+    }
+
+#ifndef REGISTER_ZBTREE_TYPES
+#   define REGISTER_ZBTREE_TYPES(X)
+#endif
+
+#ifndef Z_AUTOGEN_BTREES
+#   define Z_AUTOGEN_BTREES(X)
+#endif
+
+#define Z_ALL_BTREES(X) Z_AUTOGEN_BTREES(X) REGISTER_ZBTREE_TYPES(X)
+
+Z_ALL_BTREES(ZBTREE_GENERATE_IMPL)
+
+#define B_INSERT_ENTRY(K, V, Name, Cmp)   zbtree_##Name*: zbtree_insert_##Name,
+#define B_FIND_ENTRY(K, V, Name, Cmp)     zbtree_##Name*: zbtree_find_##Name,
+#define B_HAS_ENTRY(K, V, Name, Cmp)      zbtree_##Name*: zbtree_contains_##Name,
+#define B_REM_ENTRY(K, V, Name, Cmp)      zbtree_##Name*: zbtree_remove_##Name,
+#define B_CLEAR_ENTRY(K, V, Name, Cmp)    zbtree_##Name*: zbtree_clear_##Name,
+#define B_SIZE_ENTRY(K, V, Name, Cmp)     zbtree_##Name*: zbtree_size_##Name,
+#define B_BULK_ENTRY(K, V, Name, Cmp)     zbtree_##Name*: zbtree_bulk_load_##Name,
+#define B_LB_ENTRY(K, V, Name, Cmp)       zbtree_##Name*: zbtree_lower_bound_##Name,
+#define B_UB_ENTRY(K, V, Name, Cmp)       zbtree_##Name*: zbtree_upper_bound_##Name,
+#define B_FIRST_ENTRY(K, V, Name, Cmp)    zbtree_##Name*: zbtree_first_##Name,
+#define B_LAST_ENTRY(K, V, Name, Cmp)     zbtree_##Name*: zbtree_last_##Name,
+#define B_VALID_ENTRY(K, V, Name, Cmp)    zbtree_iter_##Name*: zbtree_iter_valid_##Name,
+#define B_KEY_ENTRY(K, V, Name, Cmp)      zbtree_iter_##Name*: zbtree_iter_key_##Name,
+#define B_VALUE_ENTRY(K, V, Name, Cmp)    zbtree_iter_##Name*: zbtree_iter_value_##Name,
+#define B_NEXT_ENTRY(K, V, Name, Cmp)     zbtree_iter_##Name*: zbtree_iter_next_##Name,
+#define B_PREV_ENTRY(K, V, Name, Cmp)     zbtree_iter_##Name*: zbtree_iter_prev_##Name,
+#define B_BEFORE_ENTRY(K, V, Name, Cmp)   zbtree_iter_##Name*: zbtree_iter_before_##Name,
+
+#define zbtree_init(Name)       zbtree_init_##Name()
+#define zbtree_init_pool(Name, per_block) zbtree_init_pool_##Name(per_block)
+
+#if defined(__GNUC__) || defined(__clang__)
+#   define zbtree_autofree(Name) __attribute__((cleanup(zbtree_clear_##Name))) zbtree_##Name
+#endif
+
+#define zbtree_insert(t, k, v)         _Generic((t), Z_ALL_BTREES(B_INSERT_ENTRY) default: 0)       (t, k, v)
+#define zbtree_remove(t, k)            _Generic((t), Z_ALL_BTREES(B_REM_ENTRY)    default: (void)0) (t, k)
+#define zbtree_find(t, k)              _Generic((t), Z_ALL_BTREES(B_FIND_ENTRY)   default: NULL)    (t, k)
+#define zbtree_contains(t, k)          _Generic((t), Z_ALL_BTREES(B_HAS_ENTRY)    default: 0)       (t, k)
+#define zbtree_clear(t)                _Generic((t), Z_ALL_BTREES(B_CLEAR_ENTRY)  default: (void)0) (t)
+#define zbtree_size(t)                 _Generic((t), Z_ALL_BTREES(B_SIZE_ENTRY)   default: 0)       (t)
+#define zbtree_bulk_load(t, k, v, n)   _Generic((t), Z_ALL_BTREES(B_BULK_ENTRY)   default: 0)       (t, k, v, n)
+#define zbtree_lower_bound(t, k)       _Generic((t), Z_ALL_BTREES(B_LB_ENTRY)     default: NULL)    (t, k)
+#define zbtree_upper_bound(t, k)       _Generic((t), Z_ALL_BTREES(B_UB_ENTRY)     default: NULL)    (t, k)
+#define zbtree_first(t)                _Generic((t), Z_ALL_BTREES(B_FIRST_ENTRY)  default: NULL)    (t)
+#define zbtree_last(t)                 _Generic((t), Z_ALL_BTREES(B_LAST_ENTRY)   default: NULL)    (t)
+#define zbtree_iter_valid(it)          _Generic((it), Z_ALL_BTREES(B_VALID_ENTRY) default: 0)       (it)
+#define zbtree_iter_key(it)            _Generic((it), Z_ALL_BTREES(B_KEY_ENTRY)   default: NULL)    (it)
+#define zbtree_iter_value(it)          _Generic((it), Z_ALL_BTREES(B_VALUE_ENTRY) default: NULL)    (it)
+#define zbtree_iter_next(it)           _Generic((it), Z_ALL_BTREES(B_NEXT_ENTRY)  default: (void)0) (it)
+#define zbtree_iter_prev(it)           _Generic((it), Z_ALL_BTREES(B_PREV_ENTRY)  default: (void)0) (it)
+#define zbtree_iter_before(it, hi)     _Generic((it), Z_ALL_BTREES(B_BEFORE_ENTRY) default: 0)      (it, hi)
+
+// Runtime allocator (Z_ALLOCATOR_HANDLE, C only): t must still be empty and unpooled.
+#if defined(Z_ALLOCATOR_HANDLE) && !defined(__cplusplus)
+#   define B_ALLOC_ENTRY(K, V, Name, Cmp) zbtree_##Name*: zbtree_set_allocator_##Name,
+#   define zbtree_set_allocator(t, a) _Generic((t), Z_ALL_BTREES(B_ALLOC_ENTRY) default: (void)0) (t, a)
+#endif
+
+// Iteration macros: the whole tree in order, or the keys in [lo, hi).
+#if defined(__GNUC__) || defined(__clang__)
+
+#   define zbtree_foreach(t, it) \
+        for (__typeof__(zbtree_first(t)) it = zbtree_first(t); zbtree_iter_valid(&(it)); zbtree_iter_next(&(it)))
+
+#   define zbtree_foreach_range(t, lo, hi, it)                                       \
+        for (__typeof__(zbtree_first(t)) it = zbtree_lower_bound(t, lo);             \
+             zbtree_iter_before(&(it), hi);                                          \
+             zbtree_iter_next(&(it)))
+#else
+
+#   define zbtree_foreach(t, it) \
+        for ((it) = zbtree_first(t); zbtree_iter_valid(&(it)); zbtree_iter_next(&(it)))
+
+#   define zbtree_foreach_range(t, lo, hi, it)                                       \
+        for ((it) = zbtree_lower_bound(t, lo); zbtree_iter_before(&(it), hi); zbtree_iter_next(&(it)))
+#endif
+
 #ifdef ZTREE_SHORT_NAMES
 #   define tree(Name)              ztree_##Name
 #   define tree_init        ztree_init
@@ -974,6 +2347,10 @@ Z_ALL_TREES(ZTREE_GENERATE_IMPL)
 #   define tree_max         ztree_max
 #   define tree_next        ztree_next
 #   define tree_prev        ztree_prev
+#   define tree_init_pool   ztree_init_pool
+#   define tree_rank        ztree_rank
+#   define tree_select      ztree_select
+#   define tree_count_range ztree_count_range
 #   define tree_foreach     ztree_foreach
 #   define tree_foreach_safe ztree_foreach_safe
 #endif
@@ -982,6 +2359,15 @@ Z_ALL_TREES(ZTREE_GENERATE_IMPL)
 } // extern "C"
 namespace z_tree 
 {
+#   ifdef ZTREE_AUGMENTED
+#       define ZTREE_CPP_AUG_TRAITS__(Name)                                  \
+            static constexpr auto rank = ::ztree_rank_##Name;               \
+            static constexpr auto select = ::ztree_select_##Name;           \
+            static constexpr auto count_range = ::ztree_count_range_##Name;
+#   else
+#       define ZTREE_CPP_AUG_TRAITS__(Name)
+#   endif
+
 #   define ZTREE_CPP_TRAITS(Key, Val, Name, Cmp)                            \
         template<> struct traits<Key, Val>                                  \
         {                                                                   \
@@ -997,8 +2383,30 @@ namespace z_tree
             static constexpr auto max = ::ztree_max_##Name;                 \
             static constexpr auto next = ::ztree_next_##Name;               \
             static constexpr auto prev = ::ztree_prev_##Name;               \
+            ZTREE_CPP_AUG_TRAITS__(Name)                                    \
         };
     Z_ALL_TREES(ZTREE_CPP_TRAITS)
+
+#   define ZBTREE_CPP_TRAITS(Key, Val, Name, Cmp)                               \
+        template<> struct btree_traits<Key, Val>                                \
+        {                                                                       \
+            using tree_type = ::zbtree_##Name;                                  \
+            using iter_type = ::zbtree_iter_##Name;                             \
+            static constexpr auto init = ::zbtree_init_##Name;                  \
+            static constexpr auto insert = ::zbtree_insert_##Name;              \
+            static constexpr auto bulk_load = ::zbtree_bulk_load_##Name;        \
+            static constexpr auto remove = ::zbtree_remove_##Name;              \
+            static constexpr auto find = ::zbtree_find_##Name;                  \
+            static constexpr auto contains = ::zbtree_contains_##Name;          \
+            static constexpr auto lower_bound = ::zbtree_lower_bound_##Name;    \
+            static constexpr auto upper_bound = ::zbtree_upper_bound_##Name;    \
+            static constexpr auto first = ::zbtree_first_##Name;                \
+            static constexpr auto clear = ::zbtree_clear_##Name;                \
+            static constexpr auto iter_key = ::zbtree_iter_key_##Name;          \
+            static constexpr auto iter_value = ::zbtree_iter_value_##Name;      \
+            static constexpr auto iter_next = ::zbtree_iter_next_##Name;        \
+        };
+    Z_ALL_BTREES(ZBTREE_CPP_TRAITS)
 }
 #endif
 #endif // ZTREE_H
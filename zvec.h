@@ -144,6 +144,58 @@
 
 
 #endif // Z_COMMON_BUNDLED
+
+// Runtime allocator handle. Not part of zcommon yet, so it stays outside the bundled block
+// above (regenerated from upstream); every ZDK header carries the same guarded copy.
+#ifndef Z_ALLOCATOR_HANDLE_DEFINED
+#define Z_ALLOCATOR_HANDLE_DEFINED
+
+/* * zalloc_t routes one container's memory through any allocator (arena, pool, ...).
+ * Containers only carry a handle when Z_ALLOCATOR_HANDLE is defined before the first
+ * ZDK include; otherwise they are laid out and compiled exactly as before.
+ * A NULL handle means the compile-time *_MALLOC macros. realloc and free also receive
+ * the old size, for allocators that do not track it.
+ */
+#ifndef Z_ALLOC_T_DEFINED
+#define Z_ALLOC_T_DEFINED
+typedef struct zalloc_t
+{
+    void *(*alloc)(void *ctx, size_t size);
+    void *(*realloc)(void *ctx, void *ptr, size_t old_size, size_t new_size);
+    void  (*free)(void *ctx, void *ptr, size_t size);
+    void *ctx;
+} zalloc_t;
+#endif
+
+#ifdef Z_ALLOCATOR_HANDLE
+#   define Z_ALLOCATOR_FIELD                   const zalloc_t *allocator;
+#   define Z_ALLOCATOR_INIT                    , NULL
+#   define Z_HMALLOC(h, sz, dflt)              ((h) ? (h)->alloc((h)->ctx, (sz)) : (dflt))
+#   define Z_HCALLOC(h, n, sz, dflt)           ((h) ? z_hcalloc__((h), (n), (sz)) : (dflt))
+#   define Z_HREALLOC(h, p, old_sz, sz, dflt)  ((h) ? (h)->realloc((h)->ctx, (p), (old_sz), (sz)) : (dflt))
+#   define Z_HFREE(h, p, sz, dflt)             ((h) ? ((p) ? (h)->free((h)->ctx, (p), (sz)) : (void)0) : (void)(dflt))
+    // Setter for a generated container; call it while the container owns no memory yet.
+#   define Z_GEN_SET_ALLOCATOR(Type, Fn)       static inline void Fn(Type *c, const zalloc_t *a) { c->allocator = a; }
+
+static inline void *z_hcalloc__(const zalloc_t *h, size_t n, size_t sz)
+{
+    if (0 != n && sz > SIZE_MAX / n) return NULL;
+    void *p = h->alloc(h->ctx, n * sz);
+    if (p) memset(p, 0, n * sz);
+    return p;
+}
+#else
+#   define Z_ALLOCATOR_FIELD
+#   define Z_ALLOCATOR_INIT
+#   define Z_HMALLOC(h, sz, dflt)              (dflt)
+#   define Z_HCALLOC(h, n, sz, dflt)           (dflt)
+#   define Z_HREALLOC(h, p, old_sz, sz, dflt)  (dflt)
+#   define Z_HFREE(h, p, sz, dflt)             (dflt)
+#   define Z_GEN_SET_ALLOCATOR(Type, Fn)
+#endif
+
+#endif // Z_ALLOCATOR_HANDLE_DEFINED
+
 /* ============================================================================ */
 
 /*
@@ -159,6 +211,7 @@
  * • Full RAII C++ wrapper in namespace z_vec::vector<T>
  * • Fast path (asserts + int error codes) and safe path (zres<T>)
  * • Optional short names via ZVEC_SHORT_NAMES
+ * • Small vectors with inline storage (REGISTER_ZVEC_SMALL_TYPES)
  * • Automatic type registration via z_registry.h or manual DEFINE_ macros
  *
  * License: MIT
@@ -183,6 +236,11 @@
 #   define Z_HAS_ZERROR 0
 #endif
 
+// Scanner marker for small vectors (not part of the bundled zcommon block yet).
+#ifndef DEFINE_SMALL_VEC_TYPE
+#   define DEFINE_SMALL_VEC_TYPE(T, N, Name)
+#endif
+
 // C++ interop preamble.
 #ifdef __cplusplus
 #include <initializer_list>
@@ -246,8 +304,8 @@ namespace z_vec
 
         vector(vector &&other) noexcept
         {
-            inner = other.inner;
-            Traits::init(other.inner);
+            Traits::init(inner);
+            Traits::move(inner, other.inner);
         }
 
         ~vector() 
@@ -271,8 +329,7 @@ namespace z_vec
             if (&other != this)
             {
                 Traits::free(inner);
-                inner = other.inner;
-                Traits::init(other.inner);
+                Traits::move(inner, other.inner);
             }
             return *this;
         }
@@ -441,6 +498,11 @@ extern "C" {
     #define ZVEC_FREE(p)         Z_FREE(p)
 #endif
 
+// Element storage goes through the vector's zalloc_t handle when it carries one.
+#define ZVEC_HMALLOC__(v, sz)           Z_HMALLOC((v)->allocator, sz, ZVEC_MALLOC(sz))
+#define ZVEC_HREALLOC__(v, p, old, sz)  Z_HREALLOC((v)->allocator, p, old, sz, ZVEC_REALLOC(p, sz))
+#define ZVEC_HFREE__(v, p, sz)          Z_HFREE((v)->allocator, p, sz, ZVEC_FREE(p))
+
 /*
  * Safe API generation (requires zerror.h).
  *
@@ -461,16 +523,14 @@ extern "C" {
         static inline zres zvec_push_safe_##Name(zvec_##Name *v, T value,                       \
                                                 const char *f, int l, const char *fn)           \
         {                                                                                       \
+            zvec_anchor_##Name##__(v);                                                          \
             if (v->length >= v->capacity)                                                       \
             {                                                                                   \
                 size_t new_cap = Z_GROWTH_FACTOR(v->capacity);                                  \
-                T *new_data = (T *)ZVEC_REALLOC(v->data, new_cap * sizeof(T));                  \
-                if (!new_data)                                                                  \
+                if (Z_OK != zvec_reserve_##Name(v, new_cap))                                    \
                 {                                                                               \
                     return zres_err(zvec_err_impl(Z_ENOMEM, "Vector Push OOM", f, l, fn));      \
                 }                                                                               \
-                v->data = new_data;                                                             \
-                v->capacity = new_cap;                                                          \
             }                                                                                   \
             v->data[v->length++] = value;                                                       \
             return zres_ok();                                                                   \
@@ -479,23 +539,17 @@ extern "C" {
         static inline zres zvec_reserve_safe_##Name(zvec_##Name *v, size_t cap,                 \
                                                    const char *f, int l, const char *fn)        \
         {                                                                                       \
-            if (cap <= v->capacity)                                                             \
-            {                                                                                   \
-                return zres_ok();                                                               \
-            }                                                                                   \
-            T *new_data = (T *)ZVEC_REALLOC(v->data, cap * sizeof(T));                          \
-            if (!new_data)                                                                      \
+            if (Z_OK != zvec_reserve_##Name(v, cap))                                            \
             {                                                                                   \
                 return zres_err(zvec_err_impl(Z_ENOMEM, "Vector Reserve OOM", f, l, fn));       \
             }                                                                                   \
-            v->data = new_data;                                                                 \
-            v->capacity = cap;                                                                  \
             return zres_ok();                                                                   \
         }                                                                                       \
                                                                                                 \
         static inline Res_##Name zvec_pop_safe_##Name(zvec_##Name *v,                           \
                                                      const char *f, int l, const char *fn)      \
         {                                                                                       \
+            zvec_anchor_##Name##__(v);                                                          \
             if (0 == v->length)                                                                 \
             {                                                                                   \
                 return Res_##Name##_err(zvec_err_impl(Z_EEMPTY, "Pop empty vec", f, l, fn));    \
@@ -506,6 +560,7 @@ extern "C" {
         static inline Res_##Name zvec_at_safe_##Name(zvec_##Name *v, size_t i,                  \
                                                     const char *f, int l, const char *fn)       \
         {                                                                                       \
+            zvec_anchor_##Name##__(v);                                                          \
             if (i >= v->length)                                                                 \
             {                                                                                   \
                 return Res_##Name##_err(zvec_err_impl(Z_EOOB, "Index out of bounds", f, l, fn));\
@@ -516,6 +571,7 @@ extern "C" {
         static inline Res_##Name zvec_last_safe_##Name(zvec_##Name *v,                          \
                                                       const char *f, int l, const char *fn)     \
         {                                                                                       \
+            zvec_anchor_##Name##__(v);                                                          \
             if (0 == v->length)                                                                 \
             {                                                                                   \
                 return Res_##Name##_err(zvec_err_impl(Z_EEMPTY, "Vector is empty", f, l, fn));  \
@@ -530,6 +586,14 @@ extern "C" {
 // C++ compatibility layers.
 
 #ifdef __cplusplus
+#   define ZVEC_MOVE__(x)             std::move(x)
+#   define ZVEC_SWAP__(T, a, b)       std::swap((a), (b))
+#   define ZVEC_SCRATCH_ALLOC__(T, n) new (std::nothrow) T[n]
+#   define ZVEC_SCRATCH_FREE__(p)     delete[] (p)
+#   define ZVEC_ZERO_INIT__(S, v)     S v = S()
+    // new[]/delete[] run constructors, so C++ vectors never route through a zalloc_t.
+#   define ZVEC_GEN_SET_ALLOCATOR__(Name)
+
 #   define ZVEC_IMPL_ALLOC(T, Name)                                             \
         static inline int zvec_reserve_##Name(zvec_##Name *v, size_t new_cap)   \
         {                                                                       \
@@ -603,6 +667,103 @@ extern "C" {
             catch (...) {}                                                      \
         }
 
+#   define ZVEC_IMPL_SMALL_ALLOC(T, Name)                                       \
+        static inline int zvec_reserve_##Name(zvec_##Name *v, size_t new_cap)   \
+        {                                                                       \
+            zvec_anchor_##Name##__(v);                                          \
+            if (new_cap <= v->capacity)                                         \
+            {                                                                   \
+                return Z_OK;                                                    \
+            }                                                                   \
+            try {                                                               \
+                T* new_data = new T[new_cap];                                   \
+                for (size_t i = 0; i < v->length; ++i)                          \
+                {                                                               \
+                    new_data[i] = std::move(v->data[i]);                        \
+                }                                                               \
+                if (v->data != v->inline_buf)                                   \
+                {                                                               \
+                    delete[] v->data;                                           \
+                }                                                               \
+                else                                                            \
+                {                                                               \
+                    for (size_t i = 0; i < v->length; ++i)                      \
+                    {                                                           \
+                        v->inline_buf[i] = T();                                 \
+                    }                                                           \
+                }                                                               \
+                v->data = new_data;                                             \
+                v->capacity = new_cap;                                          \
+            } catch (...) { return Z_ENOMEM; }                                  \
+            return Z_OK;                                                        \
+        }                                                                       \
+                                                                                \
+        static inline void zvec_free_##Name(zvec_##Name *v)                     \
+        {                                                                       \
+            zvec_anchor_##Name##__(v);                                          \
+            if (v->data != v->inline_buf)                                       \
+            {                                                                   \
+                delete[] v->data;                                               \
+            }                                                                   \
+            else                                                                \
+            {                                                                   \
+                for (size_t i = 0; i < v->length; ++i)                          \
+                {                                                               \
+                    v->inline_buf[i] = T();                                     \
+                }                                                               \
+            }                                                                   \
+            v->data = v->inline_buf;                                            \
+            v->length = 0;                                                      \
+            v->capacity = ZVEC_SMALL_CAP_##Name;                                \
+        }                                                                       \
+                                                                                \
+        static inline void zvec_remove_##Name(zvec_##Name *v, size_t index)     \
+        {                                                                       \
+            zvec_anchor_##Name##__(v);                                          \
+            if (index >= v->length)                                             \
+            {                                                                   \
+                return;                                                         \
+            }                                                                   \
+            for (size_t i = index; i < v->length - 1; ++i)                      \
+            {                                                                   \
+                v->data[i] = std::move(v->data[i + 1]);                         \
+            }                                                                   \
+            v->data[v->length - 1] = T();                                       \
+            v->length--;                                                        \
+        }                                                                       \
+                                                                                \
+        static inline void zvec_shrink_to_fit_##Name(zvec_##Name *v)            \
+        {                                                                       \
+            zvec_anchor_##Name##__(v);                                          \
+            if (v->data == v->inline_buf || v->length == v->capacity)           \
+            {                                                                   \
+                return;                                                         \
+            }                                                                   \
+            if (v->length <= ZVEC_SMALL_CAP_##Name)                             \
+            {                                                                   \
+                for (size_t i = 0; i < v->length; ++i)                          \
+                {                                                               \
+                    v->inline_buf[i] = std::move(v->data[i]);                   \
+                }                                                               \
+                delete[] v->data;                                               \
+                v->data = v->inline_buf;                                        \
+                v->capacity = ZVEC_SMALL_CAP_##Name;                            \
+                return;                                                         \
+            }                                                                   \
+            try                                                                 \
+            {                                                                   \
+                T* new_data = new T[v->length];                                 \
+                for (size_t i = 0; i < v->length; ++i)                          \
+                {                                                               \
+                    new_data[i] = std::move(v->data[i]);                        \
+                }                                                               \
+                delete[] v->data;                                               \
+                v->data = new_data;                                             \
+                v->capacity = v->length;                                        \
+            }                                                                   \
+            catch (...) {}                                                      \
+        }
+
     // C++ dispatch: generates inline overloads so C++ can find functions without _Generic.
 #   define ZVEC_CPP_DISPATCH_IMPL(T, Name)                                                  \
         static inline int zvec_reserve_dispatch(zvec_##Name *v, size_t n)                   \
@@ -703,6 +864,13 @@ extern "C" {
             return zvec_lower_bound_##Name(v, k, cmp);                                      \
         }
 #else
+#   define ZVEC_MOVE__(x)             (x)
+#   define ZVEC_SWAP__(T, a, b)       do { T swap_tmp__ = (a); (a) = (b); (b) = swap_tmp__; } while (0)
+#   define ZVEC_SCRATCH_ALLOC__(T, n) (T *)ZVEC_MALLOC((n) * sizeof(T))
+#   define ZVEC_SCRATCH_FREE__(p)     ZVEC_FREE(p)
+#   define ZVEC_ZERO_INIT__(S, v)     S v; memset(&v, 0, sizeof(S))
+#   define ZVEC_GEN_SET_ALLOCATOR__(Name) Z_GEN_SET_ALLOCATOR(zvec_##Name, zvec_set_allocator_##Name)
+
     // C implementation: uses realloc / memmove / free.
     #define ZVEC_IMPL_ALLOC(T, Name)                                                            \
         static inline int zvec_reserve_##Name(zvec_##Name *v, size_t new_cap)                   \
@@ -711,7 +879,8 @@ extern "C" {
             {                                                                                   \
                 return Z_OK;                                                                    \
             }                                                                                   \
-            T* new_data = (T*)ZVEC_REALLOC(v->data, new_cap * sizeof(T));                       \
+            T* new_data = (T*)ZVEC_HREALLOC__(v, v->data, v->capacity * sizeof(T),              \
+                                              new_cap * sizeof(T));                             \
             if (!new_data)                                                                      \
             {                                                                                   \
                 return Z_ENOMEM;                                                                \
@@ -723,8 +892,10 @@ extern "C" {
                                                                                                 \
         static inline void zvec_free_##Name(zvec_##Name *v)                                     \
         {                                                                                       \
-            ZVEC_FREE(v->data);                                                                 \
-            memset(v, 0, sizeof(zvec_##Name));                                                  \
+            ZVEC_HFREE__(v, v->data, v->capacity * sizeof(T));                                  \
+            v->data = NULL;                                                                     \
+            v->length = 0;                                                                      \
+            v->capacity = 0;                                                                    \
         }                                                                                       \
                                                                                                 \
         static inline void zvec_remove_##Name(zvec_##Name *v, size_t index)                     \
@@ -748,7 +919,87 @@ extern "C" {
                 zvec_free_##Name(v);                                                            \
                 return;                                                                         \
             }                                                                                   \
-            T* new_data = (T*)ZVEC_REALLOC(v->data, v->length * sizeof(T));                     \
+            T* new_data = (T*)ZVEC_HREALLOC__(v, v->data, v->capacity * sizeof(T),              \
+                                              v->length * sizeof(T));                           \
+            if (new_data)                                                                       \
+            {                                                                                   \
+                v->data = new_data;                                                             \
+                v->capacity = v->length;                                                        \
+            }                                                                                   \
+        }
+
+    // Small vectors: inline buffer until the first spill, then the same realloc path.
+    #define ZVEC_IMPL_SMALL_ALLOC(T, Name)                                                      \
+        static inline int zvec_reserve_##Name(zvec_##Name *v, size_t new_cap)                   \
+        {                                                                                       \
+            zvec_anchor_##Name##__(v);                                                          \
+            if (new_cap <= v->capacity)                                                         \
+            {                                                                                   \
+                return Z_OK;                                                                    \
+            }                                                                                   \
+            T* new_data;                                                                        \
+            if (v->data == v->inline_buf)                                                       \
+            {                                                                                   \
+                new_data = (T*)ZVEC_HMALLOC__(v, new_cap * sizeof(T));                          \
+                if (new_data)                                                                   \
+                {                                                                               \
+                    memcpy(new_data, v->inline_buf, v->length * sizeof(T));                     \
+                }                                                                               \
+            }                                                                                   \
+            else                                                                                \
+            {                                                                                   \
+                new_data = (T*)ZVEC_HREALLOC__(v, v->data, v->capacity * sizeof(T),             \
+                                               new_cap * sizeof(T));                            \
+            }                                                                                   \
+            if (!new_data)                                                                      \
+            {                                                                                   \
+                return Z_ENOMEM;                                                                \
+            }                                                                                   \
+            v->data = new_data;                                                                 \
+            v->capacity = new_cap;                                                              \
+            return Z_OK;                                                                        \
+        }                                                                                       \
+                                                                                                \
+        static inline void zvec_free_##Name(zvec_##Name *v)                                     \
+        {                                                                                       \
+            zvec_anchor_##Name##__(v);                                                          \
+            if (v->data != v->inline_buf)                                                       \
+            {                                                                                   \
+                ZVEC_HFREE__(v, v->data, v->capacity * sizeof(T));                              \
+            }                                                                                   \
+            v->data = v->inline_buf;                                                            \
+            v->length = 0;                                                                      \
+            v->capacity = ZVEC_SMALL_CAP_##Name;                                                \
+        }                                                                                       \
+                                                                                                \
+        static inline void zvec_remove_##Name(zvec_##Name *v, size_t index)                     \
+        {                                                                                       \
+            zvec_anchor_##Name##__(v);                                                          \
+            if (index >= v->length)                                                             \
+            {                                                                                   \
+                return;                                                                         \
+            }                                                                                   \
+            memmove(&v->data[index], &v->data[index + 1], (v->length - index - 1) * sizeof(T)); \
+            v->length--;                                                                        \
+        }                                                                                       \
+                                                                                                \
+        static inline void zvec_shrink_to_fit_##Name(zvec_##Name *v)                            \
+        {                                                                                       \
+            zvec_anchor_##Name##__(v);                                                          \
+            if (v->data == v->inline_buf || v->length == v->capacity)                           \
+            {                                                                                   \
+                return;                                                                         \
+            }                                                                                   \
+            if (v->length <= ZVEC_SMALL_CAP_##Name)                                             \
+            {                                                                                   \
+                memcpy(v->inline_buf, v->data, v->length * sizeof(T));                          \
+                ZVEC_HFREE__(v, v->data, v->capacity * sizeof(T));                              \
+                v->data = v->inline_buf;                                                        \
+                v->capacity = ZVEC_SMALL_CAP_##Name;                                            \
+                return;                                                                         \
+            }                                                                                   \
+            T* new_data = (T*)ZVEC_HREALLOC__(v, v->data, v->capacity * sizeof(T),              \
+                                              v->length * sizeof(T));                           \
             if (new_data)                                                                       \
             {                                                                                   \
                 v->data = new_data;                                                             \
@@ -760,46 +1011,152 @@ extern "C" {
 #endif
 
 /*
- * ZVEC_GENERATE_IMPL(T, Name)
- *
- * Primary generation macro.
- *
- * Use manually via:
- * #define REGISTER_ZVEC_TYPES(X)   \
- * X(int, Int)                      \
- * X(float, Float)                  \
- * X(MyType, MyType)
- * #include "zvec.h"
- *
- * This creates:
- * • struct zvec_Int / zvec_Float, etc.
- * • All functions: zvec_push_Int, zvec_reserve_Float, etc.
- * • Full _Generic dispatch.
- * • C++ traits specialization for z_vec::vector<T>
- *
- * Fast path: returns int (Z_OK / Z_ENOMEM), asserts on logic errors.
- * Safe path (when zerror.h present): returns zres / zresult<T>.
+ * Sorting.
+ * zvec_sort_##Name runs a per-type introsort (median-of-3 quicksort, heapsort fallback,
+ * insertion sort for short runs) instead of qsort, so elements are swapped as T rather than
+ * byte-by-byte and C++ elements are moved instead of memcpy'd.
+ * ZVEC_GENERATE_SORT_BY / ZVEC_GENERATE_RADIX_SORT_BY (below) inline the ordering entirely.
  */
-#define ZVEC_GENERATE_IMPL(T, Name)                                                         \
-                                                                                            \
-    typedef T zvec_T_##Name;                                                                \
-                                                                                            \
-    typedef struct                                                                          \
+#ifndef ZVEC_SORT_INSERTION_THRESHOLD
+#   define ZVEC_SORT_INSERTION_THRESHOLD 16
+#endif
+
+// LESS(a, b) takes two const T pointers and returns non-zero when *a orders before *b.
+#define ZVEC_GEN_SORT_CORE__(T, Tag, LESS)                                                  \
+    static inline void zvec_isort_##Tag(T *a, size_t n,                                     \
+                                        int (*compar)(const T *, const T *))                \
     {                                                                                       \
-        T *data;                                                                            \
-        size_t length;                                                                      \
-        size_t capacity;                                                                    \
-    } zvec_##Name;                                                                          \
+        (void)compar;                                                                       \
+        for (size_t i = 1; i < n; i++)                                                      \
+        {                                                                                   \
+            if (!(LESS(&a[i], &a[i - 1])))                                                  \
+            {                                                                               \
+                continue;                                                                   \
+            }                                                                               \
+            T x = ZVEC_MOVE__(a[i]);                                                        \
+            size_t j = i;                                                                   \
+            do                                                                              \
+            {                                                                               \
+                a[j] = ZVEC_MOVE__(a[j - 1]);                                               \
+                j--;                                                                        \
+            } while (j > 0 && (LESS(&x, &a[j - 1])));                                       \
+            a[j] = ZVEC_MOVE__(x);                                                          \
+        }                                                                                   \
+    }                                                                                       \
                                                                                             \
-    /* Forward declaration for C++ allocators to see. */                                    \
-    static inline int zvec_reserve_##Name(zvec_##Name *v, size_t new_cap);                  \
+    static inline void zvec_sift_##Tag(T *a, size_t root, size_t n,                         \
+                                       int (*compar)(const T *, const T *))                 \
+    {                                                                                       \
+        (void)compar;                                                                       \
+        T x = ZVEC_MOVE__(a[root]);                                                         \
+        for (;;)                                                                            \
+        {                                                                                   \
+            size_t child = 2 * root + 1;                                                    \
+            if (child >= n)                                                                 \
+            {                                                                               \
+                break;                                                                      \
+            }                                                                               \
+            if (child + 1 < n && (LESS(&a[child], &a[child + 1])))                          \
+            {                                                                               \
+                child++;                                                                    \
+            }                                                                               \
+            if (!(LESS(&x, &a[child])))                                                     \
+            {                                                                               \
+                break;                                                                      \
+            }                                                                               \
+            a[root] = ZVEC_MOVE__(a[child]);                                                \
+            root = child;                                                                   \
+        }                                                                                   \
+        a[root] = ZVEC_MOVE__(x);                                                           \
+    }                                                                                       \
                                                                                             \
-    ZVEC_IMPL_ALLOC(T, Name)                                                                \
+    static inline void zvec_heapsort_##Tag(T *a, size_t n,                                  \
+                                           int (*compar)(const T *, const T *))             \
+    {                                                                                       \
+        for (size_t i = n / 2; i-- > 0;)                                                    \
+        {                                                                                   \
+            zvec_sift_##Tag(a, i, n, compar);                                               \
+        }                                                                                   \
+        for (size_t end = n - 1; end > 0; end--)                                            \
+        {                                                                                   \
+            ZVEC_SWAP__(T, a[0], a[end]);                                                   \
+            zvec_sift_##Tag(a, 0, end, compar);                                             \
+        }                                                                                   \
+    }                                                                                       \
                                                                                             \
+    static inline void zvec_introsort_##Tag(T *a, size_t n,                                 \
+                                            int (*compar)(const T *, const T *))            \
+    {                                                                                       \
+        (void)compar;                                                                       \
+        size_t depth = 0;                                                                   \
+        for (size_t k = n; k > 1; k >>= 1)                                                  \
+        {                                                                                   \
+            depth += 2;                                                                     \
+        }                                                                                   \
+        while (n > ZVEC_SORT_INSERTION_THRESHOLD)                                           \
+        {                                                                                   \
+            if (0 == depth--)                                                               \
+            {                                                                               \
+                zvec_heapsort_##Tag(a, n, compar);                                          \
+                return;                                                                     \
+            }                                                                               \
+            size_t mid = n / 2;                                                             \
+            if (LESS(&a[mid], &a[0]))                                                       \
+            {                                                                               \
+                ZVEC_SWAP__(T, a[mid], a[0]);                                               \
+            }                                                                               \
+            if (LESS(&a[n - 1], &a[mid]))                                                   \
+            {                                                                               \
+                ZVEC_SWAP__(T, a[n - 1], a[mid]);                                           \
+                if (LESS(&a[mid], &a[0]))                                                   \
+                {                                                                           \
+                    ZVEC_SWAP__(T, a[mid], a[0]);                                           \
+                }                                                                           \
+            }                                                                               \
+            /* Hoare partition around a copy of the median; a[0] and a[n - 1] bound it. */  \
+            T pivot = a[mid];                                                               \
+            size_t i = 0;                                                                   \
+            size_t j = n - 1;                                                               \
+            for (;;)                                                                        \
+            {                                                                               \
+                do                                                                          \
+                {                                                                           \
+                    i++;                                                                    \
+                } while (LESS(&a[i], &pivot));                                              \
+                do                                                                          \
+                {                                                                           \
+                    j--;                                                                    \
+                } while (LESS(&pivot, &a[j]));                                              \
+                if (i >= j)                                                                 \
+                {                                                                           \
+                    break;                                                                  \
+                }                                                                           \
+                ZVEC_SWAP__(T, a[i], a[j]);                                                 \
+            }                                                                               \
+            /* [0, j] <= pivot <= [j + 1, n); recurse into the smaller side. */             \
+            size_t left = j + 1;                                                            \
+            if (left < n - left)                                                            \
+            {                                                                               \
+                zvec_introsort_##Tag(a, left, compar);                                      \
+                a += left;                                                                  \
+                n -= left;                                                                  \
+            }                                                                               \
+            else                                                                            \
+            {                                                                               \
+                zvec_introsort_##Tag(a + left, n - left, compar);                           \
+                n = left;                                                                   \
+            }                                                                               \
+        }                                                                                   \
+        zvec_isort_##Tag(a, n, compar);                                                     \
+    }
+
+#define ZVEC_CMP_LESS__(a, b) (compar((a), (b)) < 0)
+
+// Operations shared by plain and small vectors; zvec_anchor_##Name##__ is the only difference.
+#define ZVEC_GEN_OPS__(T, Name)                                                             \
     static inline zvec_##Name zvec_init_capacity_##Name(size_t cap)                         \
     {                                                                                       \
-        zvec_##Name v;                                                                      \
-        memset(&v, 0, sizeof(zvec_##Name));                                                 \
+        ZVEC_ZERO_INIT__(zvec_##Name, v);                                                   \
         if (cap > 0)                                                                        \
         {                                                                                   \
             zvec_reserve_##Name(&v, cap);                                                   \
@@ -807,9 +1164,12 @@ extern "C" {
         return v;                                                                           \
     }                                                                                       \
                                                                                             \
+    ZVEC_GEN_SET_ALLOCATOR__(Name)                                                          \
+                                                                                            \
     static inline zvec_##Name zvec_from_array_##Name(const T *arr, size_t count)            \
     {                                                                                       \
         zvec_##Name v = zvec_init_capacity_##Name(count);                                   \
+        zvec_anchor_##Name##__(&v);                                                         \
         if (v.data)                                                                         \
         {                                                                                   \
             size_t i;                                                                       \
@@ -829,6 +1189,7 @@ extern "C" {
                                                                                             \
     static inline T *zvec_push_slot_##Name(zvec_##Name *v)                                  \
     {                                                                                       \
+        zvec_anchor_##Name##__(v);                                                          \
         if (v->length >= v->capacity)                                                       \
         {                                                                                   \
             size_t new_cap = Z_GROWTH_FACTOR(v->capacity);                                  \
@@ -853,6 +1214,7 @@ extern "C" {
                                                                                             \
     static inline int zvec_extend_##Name(zvec_##Name *v, const T *items, size_t count)      \
     {                                                                                       \
+        zvec_anchor_##Name##__(v);                                                          \
         if (v->length + count > v->capacity)                                                \
         {                                                                                   \
             size_t new_cap = v->capacity ? v->capacity : Z_GROWTH_FACTOR(0);                \
@@ -882,27 +1244,32 @@ extern "C" {
                                                                                             \
     static inline T zvec_pop_get_##Name(zvec_##Name *v)                                     \
     {                                                                                       \
+        zvec_anchor_##Name##__(v);                                                          \
         assert(v->length > 0 && "Vector is empty");                                         \
         return v->data[--v->length];                                                        \
     }                                                                                       \
                                                                                             \
     static inline T *zvec_at_##Name(zvec_##Name *v, size_t index)                           \
     {                                                                                       \
+        zvec_anchor_##Name##__(v);                                                          \
         return (index < v->length) ? &v->data[index] : NULL;                                \
     }                                                                                       \
                                                                                             \
     static inline T *zvec_data_##Name(zvec_##Name *v)                                       \
     {                                                                                       \
+        zvec_anchor_##Name##__(v);                                                          \
         return v->data;                                                                     \
     }                                                                                       \
                                                                                             \
     static inline T *zvec_last_##Name(zvec_##Name *v)                                       \
     {                                                                                       \
+        zvec_anchor_##Name##__(v);                                                          \
         return (v->length > 0) ? &v->data[v->length - 1] : NULL;                            \
     }                                                                                       \
                                                                                             \
     static inline void zvec_swap_remove_##Name(zvec_##Name *v, size_t index)                \
     {                                                                                       \
+        zvec_anchor_##Name##__(v);                                                          \
         if (index >= v->length) return;                                                     \
         v->data[index] = v->data[--v->length];                                              \
     }                                                                                       \
@@ -914,6 +1281,7 @@ extern "C" {
                                                                                             \
     static inline void zvec_reverse_##Name(zvec_##Name *v)                                  \
     {                                                                                       \
+        zvec_anchor_##Name##__(v);                                                          \
         if (v->length < 2)                                                                  \
         {                                                                                   \
             return;                                                                         \
@@ -930,30 +1298,48 @@ extern "C" {
         }                                                                                   \
     }                                                                                       \
                                                                                             \
+    ZVEC_GEN_SORT_CORE__(T, Name, ZVEC_CMP_LESS__)                                          \
+                                                                                            \
     static inline void zvec_sort_##Name(zvec_##Name *v,                                     \
                                         int (*compar)(const T *, const T *))                \
     {                                                                                       \
+        zvec_anchor_##Name##__(v);                                                          \
         if (v->length > 1)                                                                  \
         {                                                                                   \
-            qsort(v->data, v->length, sizeof(T),                                            \
-                (int(*)(const void *, const void *))compar);                                \
+            zvec_introsort_##Name(v->data, v->length, compar);                              \
         }                                                                                   \
     }                                                                                       \
                                                                                             \
     static inline T *zvec_bsearch_##Name(zvec_##Name *v, const T *key,                      \
                                          int (*compar)(const T *, const T *))               \
     {                                                                                       \
-        if (0 == v->length)                                                                 \
+        zvec_anchor_##Name##__(v);                                                          \
+        size_t l = 0;                                                                       \
+        size_t r = v->length;                                                               \
+        while (l < r)                                                                       \
         {                                                                                   \
-            return NULL;                                                                    \
+            size_t mid = l + (r - l) / 2;                                                   \
+            int c = compar((const T *)&v->data[mid], key);                                  \
+            if (0 == c)                                                                     \
+            {                                                                               \
+                return &v->data[mid];                                                       \
+            }                                                                               \
+            if (c < 0)                                                                      \
+            {                                                                               \
+                l = mid + 1;                                                                \
+            }                                                                               \
+            else                                                                            \
+            {                                                                               \
+                r = mid;                                                                    \
+            }                                                                               \
         }                                                                                   \
-        return (T *)bsearch(key, v->data, v->length, sizeof(T),                             \
-                            (int(*)(const void *, const void *))compar);                    \
+        return NULL;                                                                        \
     }                                                                                       \
                                                                                             \
     static inline T *zvec_lower_bound_##Name(zvec_##Name *v, const T *key,                  \
                                              int (*compar)(const T *, const T *))           \
     {                                                                                       \
+        zvec_anchor_##Name##__(v);                                                          \
         size_t l = 0;                                                                       \
         size_t r = v->length;                                                               \
         while (l < r)                                                                       \
@@ -971,9 +1357,685 @@ extern "C" {
         return (l < v->length) ? &v->data[l] : NULL;                                        \
     }                                                                                       \
                                                                                             \
+    ZVEC_GEN_PAR__(T, Name)                                                                 \
+                                                                                            \
     /* Inject safe API. */                                                                  \
     ZVEC_GEN_SAFE_IMPL(T, Name)
 
+/*
+ * ZVEC_GENERATE_IMPL(T, Name)
+ *
+ * Primary generation macro.
+ *
+ * Use manually via:
+ * #define REGISTER_ZVEC_TYPES(X)   \
+ * X(int, Int)                      \
+ * X(float, Float)                  \
+ * X(MyType, MyType)
+ * #include "zvec.h"
+ *
+ * This creates:
+ * • struct zvec_Int / zvec_Float, etc.
+ * • All functions: zvec_push_Int, zvec_reserve_Float, etc.
+ * • Full _Generic dispatch.
+ * • C++ traits specialization for z_vec::vector<T>
+ *
+ * Fast path: returns int (Z_OK / Z_ENOMEM), asserts on logic errors.
+ * Safe path (when zerror.h present): returns zres / zresult<T>.
+ */
+#define ZVEC_GENERATE_IMPL(T, Name)                                                         \
+                                                                                            \
+    typedef T zvec_T_##Name;                                                                \
+                                                                                            \
+    typedef struct                                                                          \
+    {                                                                                       \
+        T *data;                                                                            \
+        size_t length;                                                                      \
+        size_t capacity;                                                                    \
+        Z_ALLOCATOR_FIELD                                                                   \
+    } zvec_##Name;                                                                          \
+                                                                                            \
+    /* Heap-only layout: data never points into the struct. */                              \
+    static inline void zvec_anchor_##Name##__(zvec_##Name *v)                               \
+    {                                                                                       \
+        (void)v;                                                                            \
+    }                                                                                       \
+                                                                                            \
+    static inline const T *zvec_cdata_##Name##__(const zvec_##Name *v)                      \
+    {                                                                                       \
+        return v->data;                                                                     \
+    }                                                                                       \
+                                                                                            \
+    /* Forward declaration for C++ allocators to see. */                                    \
+    static inline int zvec_reserve_##Name(zvec_##Name *v, size_t new_cap);                  \
+                                                                                            \
+    ZVEC_IMPL_ALLOC(T, Name)                                                                \
+                                                                                            \
+    ZVEC_GEN_OPS__(T, Name)
+
+/*
+ * ZVEC_GENERATE_SMALL_IMPL(T, Name)
+ *
+ * Small-buffer variant: the first ZVEC_SMALL_CAP_##Name elements live inside the struct and
+ * the vector only touches the heap once it grows past that. The generated type and functions
+ * are the same as ZVEC_GENERATE_IMPL, so _Generic dispatch, zops.h and z_vec::vector<T> work
+ * unchanged.
+ *
+ * #define ZVEC_SMALL_CAP_Token 8
+ * #define REGISTER_ZVEC_SMALL_TYPES(X) \
+ * X(Token, Token)
+ * #include "zvec.h"
+ *
+ * While inline, data points at the struct's own buffer; every zvec_* function that touches
+ * the elements re-points it first, so vectors can be returned by value. After such a copy,
+ * read data through zvec_data_##Name (or any zvec_* call) rather than straight off the field.
+ */
+#define ZVEC_GENERATE_SMALL_IMPL(T, Name)                                                   \
+                                                                                            \
+    typedef T zvec_T_##Name;                                                                \
+                                                                                            \
+    typedef struct                                                                          \
+    {                                                                                       \
+        T *data;                                                                            \
+        size_t length;                                                                      \
+        size_t capacity;                                                                    \
+        Z_ALLOCATOR_FIELD                                                                   \
+        T inline_buf[ZVEC_SMALL_CAP_##Name];                                                \
+    } zvec_##Name;                                                                          \
+                                                                                            \
+    /* Inline iff capacity fits the buffer (heap capacity is always larger). */             \
+    static inline void zvec_anchor_##Name##__(zvec_##Name *v)                               \
+    {                                                                                       \
+        if (v->capacity <= ZVEC_SMALL_CAP_##Name)                                           \
+        {                                                                                   \
+            v->data = v->inline_buf;                                                        \
+            v->capacity = ZVEC_SMALL_CAP_##Name;                                            \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    /* Read-only counterpart of the anchor, for const views of a moved vector. */           \
+    static inline const T *zvec_cdata_##Name##__(const zvec_##Name *v)                      \
+    {                                                                                       \
+        return (v->capacity <= ZVEC_SMALL_CAP_##Name) ? v->inline_buf : v->data;            \
+    }                                                                                       \
+                                                                                            \
+    static inline int zvec_reserve_##Name(zvec_##Name *v, size_t new_cap);                  \
+                                                                                            \
+    ZVEC_IMPL_SMALL_ALLOC(T, Name)                                                          \
+                                                                                            \
+    ZVEC_GEN_OPS__(T, Name)
+
+// Order-preserving unsigned keys for ZVEC_GENERATE_RADIX_SORT_BY.
+static inline uint32_t zvec_radix_key_u32(uint32_t x)
+{
+    return x;
+}
+
+static inline uint32_t zvec_radix_key_i32(int32_t x)
+{
+    return (uint32_t)x ^ 0x80000000u;
+}
+
+static inline uint32_t zvec_radix_key_f32(float x)
+{
+    uint32_t u;
+    memcpy(&u, &x, sizeof(u));
+    return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+static inline uint64_t zvec_radix_key_u64(uint64_t x)
+{
+    return x;
+}
+
+static inline uint64_t zvec_radix_key_i64(int64_t x)
+{
+    return (uint64_t)x ^ 0x8000000000000000ull;
+}
+
+static inline uint64_t zvec_radix_key_f64(double x)
+{
+    uint64_t u;
+    memcpy(&u, &x, sizeof(u));
+    return (u & 0x8000000000000000ull) ? ~u : (u | 0x8000000000000000ull);
+}
+
+/*
+ * ZVEC_GENERATE_SORT_BY(T, Name, By, LESS)
+ *
+ * Generates sort/search functions for zvec_##Name with the ordering inlined:
+ * • zvec_sort_##Name##_by_##By(v)
+ * • zvec_lower_bound_##Name##_by_##By(v, key)
+ * • zvec_bsearch_##Name##_by_##By(v, key)
+ * LESS(a, b) receives two const T pointers, e.g.
+ * #define BY_SCORE(a, b) ((a)->score < (b)->score)
+ * ZVEC_GENERATE_SORT_BY(Player, Player, Score, BY_SCORE)
+ */
+#define ZVEC_GENERATE_SORT_BY(T, Name, By, LESS)                                            \
+    ZVEC_GEN_SORT_CORE__(T, Name##_by_##By, LESS)                                           \
+                                                                                            \
+    static inline void zvec_sort_##Name##_by_##By(zvec_##Name *v)                           \
+    {                                                                                       \
+        zvec_anchor_##Name##__(v);                                                          \
+        if (v->length > 1)                                                                  \
+        {                                                                                   \
+            zvec_introsort_##Name##_by_##By(v->data, v->length, NULL);                      \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    static inline T *zvec_lower_bound_##Name##_by_##By(zvec_##Name *v, const T *key)        \
+    {                                                                                       \
+        zvec_anchor_##Name##__(v);                                                          \
+        size_t l = 0;                                                                       \
+        size_t r = v->length;                                                               \
+        while (l < r)                                                                       \
+        {                                                                                   \
+            size_t mid = l + (r - l) / 2;                                                   \
+            if (LESS((const T *)&v->data[mid], key))                                        \
+            {                                                                               \
+                l = mid + 1;                                                                \
+            }                                                                               \
+            else                                                                            \
+            {                                                                               \
+                r = mid;                                                                    \
+            }                                                                               \
+        }                                                                                   \
+        return (l < v->length) ? &v->data[l] : NULL;                                        \
+    }                                                                                       \
+                                                                                            \
+    static inline T *zvec_bsearch_##Name##_by_##By(zvec_##Name *v, const T *key)            \
+    {                                                                                       \
+        T *p = zvec_lower_bound_##Name##_by_##By(v, key);                                   \
+        return (p && !(LESS(key, (const T *)p))) ? p : NULL;                                \
+    }                                                                                       \
+                                                                                            \
+    ZVEC_GEN_PAR_SORT_BY__(T, Name, By, LESS)
+
+/*
+ * ZVEC_GENERATE_RADIX_SORT_BY(T, Name, By, KEY)
+ *
+ * Generates int zvec_radix_sort_##Name##_by_##By(v): a stable LSD radix sort.
+ * KEY(p) maps a const T pointer to an unsigned integer (up to 64 bits) whose natural order is
+ * the sort order; zvec_radix_key_{u,i,f}{32,64} cover plain numbers, e.g.
+ * #define PRICE_KEY(p) zvec_radix_key_f64((p)->price)
+ * One pass per key byte, skipping bytes that are equal across the vector.
+ * Needs length * sizeof(T) scratch; returns Z_ENOMEM (vector untouched) if that fails.
+ */
+#define ZVEC_GENERATE_RADIX_SORT_BY(T, Name, By, KEY)                                       \
+    static inline int zvec_radix_sort_##Name##_by_##By(zvec_##Name *v)                      \
+    {                                                                                       \
+        zvec_anchor_##Name##__(v);                                                          \
+        size_t n = v->length;                                                               \
+        if (n < 2)                                                                          \
+        {                                                                                   \
+            return Z_OK;                                                                    \
+        }                                                                                   \
+        T *tmp = ZVEC_SCRATCH_ALLOC__(T, n);                                                \
+        if (!tmp)                                                                           \
+        {                                                                                   \
+            return Z_ENOMEM;                                                                \
+        }                                                                                   \
+        const unsigned passes = (unsigned)sizeof(KEY((const T *)&v->data[0]));              \
+        size_t counts[8][256];                                                              \
+        memset(counts, 0, sizeof(counts));                                                  \
+        for (size_t i = 0; i < n; i++)                                                      \
+        {                                                                                   \
+            uint64_t k = (uint64_t)KEY((const T *)&v->data[i]);                             \
+            for (unsigned p = 0; p < passes; p++)                                           \
+            {                                                                               \
+                counts[p][(k >> (p * 8)) & 0xFF]++;                                         \
+            }                                                                               \
+        }                                                                                   \
+        T *src = v->data;                                                                   \
+        T *dst = tmp;                                                                       \
+        for (unsigned p = 0; p < passes; p++)                                               \
+        {                                                                                   \
+            unsigned shift = p * 8;                                                         \
+            size_t *c = counts[p];                                                          \
+            if (n == c[((uint64_t)KEY((const T *)&src[0]) >> shift) & 0xFF])                \
+            {                                                                               \
+                continue;                                                                   \
+            }                                                                               \
+            size_t off = 0;                                                                 \
+            for (size_t d = 0; d < 256; d++)                                                \
+            {                                                                               \
+                size_t cnt = c[d];                                                          \
+                c[d] = off;                                                                 \
+                off += cnt;                                                                 \
+            }                                                                               \
+            for (size_t i = 0; i < n; i++)                                                  \
+            {                                                                               \
+                dst[c[((uint64_t)KEY((const T *)&src[i]) >> shift) & 0xFF]++] = ZVEC_MOVE__(src[i]);\
+            }                                                                               \
+            T *swap = src;                                                                  \
+            src = dst;                                                                      \
+            dst = swap;                                                                     \
+        }                                                                                   \
+        if (src != v->data)                                                                 \
+        {                                                                                   \
+            for (size_t i = 0; i < n; i++)                                                  \
+            {                                                                               \
+                v->data[i] = ZVEC_MOVE__(src[i]);                                           \
+            }                                                                               \
+        }                                                                                   \
+        ZVEC_SCRATCH_FREE__(tmp);                                                           \
+        return Z_OK;                                                                        \
+    }
+
+/*
+ * Parallel algorithms (generated only when zthread.h is included before zvec.h).
+ * • zvec_par_for_each_##Name(v, fn, ctx, threads): fn(&elem, ctx) on every element.
+ * • zvec_par_transform_##Name(dst, src, fn, ctx, threads): fn(&src[i], &dst[i], ctx).
+ * • zvec_par_reduce_##Name(v, acc, op, ctx, threads): folds v into *acc with op(acc, &x, ctx);
+ *   op must be associative (chunks are folded separately, then combined in order).
+ * • zvec_par_sort_##Name(v, compar, threads): one introsorted slice per worker, then pairwise
+ *   merges where every merge is split across all workers.
+ * The element-wise calls hand out ZVEC_PAR_CHUNK_BYTES chunks to whichever worker is free.
+ * Workers are tasks on the process-wide zexec executor, so no threads are created per call.
+ * The calling thread is one of the workers; below ZVEC_PAR_MIN_PARALLEL elements or with
+ * fewer than 2 threads everything runs inline. ZVEC_GENERATE_SORT_BY adds
+ * zvec_par_sort_##Name##_by_##By(v, threads) as well.
+ */
+#ifdef ZTHREAD_H
+
+#ifndef ZVEC_PAR_MIN_PARALLEL
+#   define ZVEC_PAR_MIN_PARALLEL 16384
+#endif
+#ifndef ZVEC_PAR_CHUNK_BYTES
+#   define ZVEC_PAR_CHUNK_BYTES (64 * 1024)
+#endif
+#define ZVEC_PAR_MAX_THREADS 64
+
+// Runs fn on `count` workers through the shared executor (zexec_default), the caller running
+// tasks[0]; inline if the executor cannot be created. size is the task stride; 0 hands every
+// worker the same task.
+static inline void zvec_par_run(void (*fn)(void *), void *tasks, size_t size, size_t count)
+{
+    zexec_run(zexec_default(), fn, tasks, size, count);
+}
+
+// Start of part c when n elements are split into `parts` near-equal parts (c in [0, parts]).
+static inline size_t zvec_par_bound(size_t n, size_t parts, size_t c)
+{
+    return (n / parts) * c + (n % parts) * c / parts;
+}
+
+static inline size_t zvec_par_threads(size_t threads)
+{
+    size_t tcount = 1;
+    while (tcount * 2 <= threads && tcount < ZVEC_PAR_MAX_THREADS)
+    {
+        tcount *= 2;
+    }
+    return tcount;
+}
+
+#   define ZVEC_GEN_PAR_SORT_CORE__(T, Tag, LESS)                                           \
+        typedef struct                                                                      \
+        {                                                                                   \
+            T *src;                                                                         \
+            T *dst;                                                                         \
+            size_t n;                                                                       \
+            size_t tcount;                                                                  \
+            size_t tid;                                                                     \
+            int phase; /* 0: sort own slice, 1: merge a/b ranges into out, 2: move. */      \
+            size_t a;                                                                       \
+            size_t a_end;                                                                   \
+            size_t b;                                                                       \
+            size_t b_end;                                                                   \
+            size_t out;                                                                     \
+            int (*compar)(const T *, const T *);                                            \
+        } zvec_par_sort_task_##Tag;                                                         \
+                                                                                            \
+        /* Number of A elements among the first d outputs of a stable merge of A and B. */  \
+        static inline size_t zvec_par_corank_##Tag(T *A, size_t na, T *B, size_t nb,        \
+                                                   size_t d,                                \
+                                                   int (*compar)(const T *, const T *))     \
+        {                                                                                   \
+            size_t lo = (d > nb) ? d - nb : 0;                                              \
+            size_t hi = (d < na) ? d : na;                                                  \
+            (void)compar;                                                                   \
+            while (lo < hi)                                                                 \
+            {                                                                               \
+                size_t i = lo + (hi - lo) / 2;                                              \
+                size_t j = d - i;                                                           \
+                if (j > 0 && !LESS((const T *)&B[j - 1], (const T *)&A[i]))                 \
+                {                                                                           \
+                    lo = i + 1;                                                             \
+                }                                                                           \
+                else                                                                        \
+                {                                                                           \
+                    hi = i;                                                                 \
+                }                                                                           \
+            }                                                                               \
+            return lo;                                                                      \
+        }                                                                                   \
+                                                                                            \
+        static inline void zvec_par_sort_worker_##Tag(void *arg)                            \
+        {                                                                                   \
+            zvec_par_sort_task_##Tag *t = (zvec_par_sort_task_##Tag *)arg;                  \
+            int (*compar)(const T *, const T *) = t->compar;                                \
+            (void)compar;                                                                   \
+            if (1 != t->phase)                                                              \
+            {                                                                               \
+                size_t lo = zvec_par_bound(t->n, t->tcount, t->tid);                        \
+                size_t hi = zvec_par_bound(t->n, t->tcount, t->tid + 1);                    \
+                if (0 == t->phase)                                                          \
+                {                                                                           \
+                    if (hi - lo > 1)                                                        \
+                    {                                                                       \
+                        zvec_introsort_##Tag(t->src + lo, hi - lo, compar);                 \
+                    }                                                                       \
+                    return;                                                                 \
+                }                                                                           \
+                for (size_t i = lo; i < hi; i++)                                            \
+                {                                                                           \
+                    t->dst[i] = ZVEC_MOVE__(t->src[i]);                                     \
+                }                                                                           \
+                return;                                                                     \
+            }                                                                               \
+            T *src = t->src;                                                                \
+            T *out = t->dst + t->out;                                                       \
+            size_t i = t->a;                                                                \
+            size_t j = t->b;                                                                \
+            while (i < t->a_end && j < t->b_end)                                            \
+            {                                                                               \
+                if (LESS((const T *)&src[j], (const T *)&src[i]))                           \
+                {                                                                           \
+                    *out++ = ZVEC_MOVE__(src[j++]);                                         \
+                }                                                                           \
+                else                                                                        \
+                {                                                                           \
+                    *out++ = ZVEC_MOVE__(src[i++]);                                         \
+                }                                                                           \
+            }                                                                               \
+            while (i < t->a_end)                                                            \
+            {                                                                               \
+                *out++ = ZVEC_MOVE__(src[i++]);                                             \
+            }                                                                               \
+            while (j < t->b_end)                                                            \
+            {                                                                               \
+                *out++ = ZVEC_MOVE__(src[j++]);                                             \
+            }                                                                               \
+        }                                                                                   \
+                                                                                            \
+        /* Cuts every merge into equal output parts up front, so workers never read         \
+           elements that another worker is moving out of. */                                \
+        static inline void zvec_par_sort_split_##Tag(zvec_par_sort_task_##Tag *tasks,       \
+                                                     size_t width)                          \
+        {                                                                                   \
+            size_t n = tasks[0].n;                                                          \
+            size_t tcount = tasks[0].tcount;                                                \
+            size_t group = width * 2;                                                       \
+            int (*compar)(const T *, const T *) = tasks[0].compar;                          \
+            for (size_t t = 0; t < tcount; t++)                                             \
+            {                                                                               \
+                zvec_par_sort_task_##Tag *task = &tasks[t];                                 \
+                size_t first = (t / group) * group;                                         \
+                size_t k = t % group;                                                       \
+                size_t a0 = zvec_par_bound(n, tcount, first);                               \
+                size_t a1 = zvec_par_bound(n, tcount, first + width);                       \
+                size_t b1 = zvec_par_bound(n, tcount, first + group);                       \
+                T *A = task->src + a0;                                                      \
+                T *B = task->src + a1;                                                      \
+                size_t d0 = zvec_par_bound(b1 - a0, group, k);                              \
+                size_t d1 = zvec_par_bound(b1 - a0, group, k + 1);                          \
+                size_t i0 = zvec_par_corank_##Tag(A, a1 - a0, B, b1 - a1, d0, compar);      \
+                size_t i1 = zvec_par_corank_##Tag(A, a1 - a0, B, b1 - a1, d1, compar);      \
+                task->a = a0 + i0;                                                          \
+                task->a_end = a0 + i1;                                                      \
+                task->b = a1 + (d0 - i0);                                                   \
+                task->b_end = a1 + (d1 - i1);                                               \
+                task->out = a0 + d0;                                                        \
+            }                                                                               \
+        }                                                                                   \
+                                                                                            \
+        static inline void zvec_par_sort_run_##Tag(T *a, size_t n,                          \
+                                                   int (*compar)(const T *, const T *),     \
+                                                   size_t threads)                          \
+        {                                                                                   \
+            /* At least one chunk per slice, or thread start-up dominates. */               \
+            size_t per = ZVEC_PAR_CHUNK_BYTES / sizeof(T);                                  \
+            size_t cap = (per && n / per < threads) ? n / per : threads;                    \
+            size_t tcount = zvec_par_threads(cap);                                          \
+            T *tmp = NULL;                                                                  \
+            if (tcount >= 2 && n >= ZVEC_PAR_MIN_PARALLEL)                                  \
+            {                                                                               \
+                tmp = ZVEC_SCRATCH_ALLOC__(T, n);                                           \
+            }                                                                               \
+            if (!tmp)                                                                       \
+            {                                                                               \
+                if (n > 1)                                                                  \
+                {                                                                           \
+                    zvec_introsort_##Tag(a, n, compar);                                     \
+                }                                                                           \
+                return;                                                                     \
+            }                                                                               \
+            zvec_par_sort_task_##Tag tasks[ZVEC_PAR_MAX_THREADS];                           \
+            for (size_t t = 0; t < tcount; t++)                                             \
+            {                                                                               \
+                tasks[t].src = a;                                                           \
+                tasks[t].dst = tmp;                                                         \
+                tasks[t].n = n;                                                             \
+                tasks[t].tcount = tcount;                                                   \
+                tasks[t].tid = t;                                                           \
+                tasks[t].phase = 0;                                                         \
+                tasks[t].compar = compar;                                                   \
+            }                                                                               \
+            zvec_par_run(zvec_par_sort_worker_##Tag, tasks, sizeof(tasks[0]), tcount);      \
+            T *src = a;                                                                     \
+            T *dst = tmp;                                                                   \
+            for (size_t width = 1; width < tcount; width *= 2)                              \
+            {                                                                               \
+                for (size_t t = 0; t < tcount; t++)                                         \
+                {                                                                           \
+                    tasks[t].src = src;                                                     \
+                    tasks[t].dst = dst;                                                     \
+                    tasks[t].phase = 1;                                                     \
+                }                                                                           \
+                zvec_par_sort_split_##Tag(tasks, width);                                    \
+                zvec_par_run(zvec_par_sort_worker_##Tag, tasks, sizeof(tasks[0]), tcount);  \
+                T *swap = src;                                                              \
+                src = dst;                                                                  \
+                dst = swap;                                                                 \
+            }                                                                               \
+            if (src != a)                                                                   \
+            {                                                                               \
+                for (size_t t = 0; t < tcount; t++)                                         \
+                {                                                                           \
+                    tasks[t].src = src;                                                     \
+                    tasks[t].dst = a;                                                       \
+                    tasks[t].phase = 2;                                                     \
+                }                                                                           \
+                zvec_par_run(zvec_par_sort_worker_##Tag, tasks, sizeof(tasks[0]), tcount);  \
+            }                                                                               \
+            ZVEC_SCRATCH_FREE__(tmp);                                                       \
+        }
+
+#   define ZVEC_GEN_PAR__(T, Name)                                                          \
+        typedef struct                                                                      \
+        {                                                                                   \
+            zmutex_t lock;                                                                  \
+            size_t next;                                                                    \
+            size_t chunks;                                                                  \
+            size_t chunk;                                                                   \
+            size_t n;                                                                       \
+            T *data;                                                                        \
+            const T *src;                                                                   \
+            T *partials;                                                                    \
+            void (*each)(T *, void *);                                                      \
+            void (*map)(const T *, T *, void *);                                            \
+            void (*op)(T *, const T *, void *);                                             \
+            void *ctx;                                                                      \
+        } zvec_par_task_##Name;                                                             \
+                                                                                            \
+        static inline void zvec_par_worker_##Name(void *arg)                                \
+        {                                                                                   \
+            zvec_par_task_##Name *t = (zvec_par_task_##Name *)arg;                          \
+            for (;;)                                                                        \
+            {                                                                               \
+                zmutex_lock(&t->lock);                                                      \
+                size_t c = t->next++;                                                       \
+                zmutex_unlock(&t->lock);                                                    \
+                if (c >= t->chunks)                                                         \
+                {                                                                           \
+                    return;                                                                 \
+                }                                                                           \
+                size_t lo = c * t->chunk;                                                   \
+                size_t hi = (t->n - lo > t->chunk) ? lo + t->chunk : t->n;                  \
+                if (t->op)                                                                  \
+                {                                                                           \
+                    T *acc = &t->partials[c];                                               \
+                    *acc = t->src[lo];                                                      \
+                    for (size_t i = lo + 1; i < hi; i++)                                    \
+                    {                                                                       \
+                        t->op(acc, &t->src[i], t->ctx);                                     \
+                    }                                                                       \
+                }                                                                           \
+                else if (t->map)                                                            \
+                {                                                                           \
+                    for (size_t i = lo; i < hi; i++)                                        \
+                    {                                                                       \
+                        t->map(&t->src[i], &t->data[i], t->ctx);                            \
+                    }                                                                       \
+                }                                                                           \
+                else                                                                        \
+                {                                                                           \
+                    for (size_t i = lo; i < hi; i++)                                        \
+                    {                                                                       \
+                        t->each(&t->data[i], t->ctx);                                       \
+                    }                                                                       \
+                }                                                                           \
+            }                                                                               \
+        }                                                                                   \
+                                                                                            \
+        /* Zeroes and chunks the task; false means the work should just run inline. */      \
+        static inline bool zvec_par_prepare_##Name(zvec_par_task_##Name *t, size_t n,       \
+                                                   size_t threads)                          \
+        {                                                                                   \
+            memset((void *)t, 0, sizeof(*t));                                               \
+            size_t chunk = ZVEC_PAR_CHUNK_BYTES / sizeof(T);                                \
+            t->n = n;                                                                       \
+            t->chunk = chunk ? chunk : 1;                                                   \
+            t->chunks = (n + t->chunk - 1) / t->chunk;                                      \
+            return threads >= 2 && n >= ZVEC_PAR_MIN_PARALLEL && t->chunks >= 2;            \
+        }                                                                                   \
+                                                                                            \
+        static inline void zvec_par_launch_##Name(zvec_par_task_##Name *t, size_t threads)  \
+        {                                                                                   \
+            size_t count = (threads < t->chunks) ? threads : t->chunks;                     \
+            if (count > ZVEC_PAR_MAX_THREADS)                                               \
+            {                                                                               \
+                count = ZVEC_PAR_MAX_THREADS;                                               \
+            }                                                                               \
+            zmutex_init(&t->lock);                                                          \
+            zvec_par_run(zvec_par_worker_##Name, t, 0, count);                              \
+            zmutex_destroy(&t->lock);                                                       \
+        }                                                                                   \
+                                                                                            \
+        static inline void zvec_par_for_each_##Name(zvec_##Name *v,                         \
+                                                    void (*fn)(T *, void *),                \
+                                                    void *ctx, size_t threads)              \
+        {                                                                                   \
+            zvec_anchor_##Name##__(v);                                                      \
+            zvec_par_task_##Name task;                                                      \
+            if (!zvec_par_prepare_##Name(&task, v->length, threads))                        \
+            {                                                                               \
+                for (size_t i = 0; i < v->length; i++)                                      \
+                {                                                                           \
+                    fn(&v->data[i], ctx);                                                   \
+                }                                                                           \
+                return;                                                                     \
+            }                                                                               \
+            task.data = v->data;                                                            \
+            task.each = fn;                                                                 \
+            task.ctx = ctx;                                                                 \
+            zvec_par_launch_##Name(&task, threads);                                         \
+        }                                                                                   \
+                                                                                            \
+        static inline int zvec_par_transform_##Name(zvec_##Name *dst, zvec_##Name *src,     \
+                                                    void (*fn)(const T *, T *, void *),     \
+                                                    void *ctx, size_t threads)              \
+        {                                                                                   \
+            zvec_anchor_##Name##__(src);                                                    \
+            if (Z_OK != zvec_reserve_##Name(dst, src->length))                              \
+            {                                                                               \
+                return Z_ENOMEM;                                                            \
+            }                                                                               \
+            size_t n = src->length;                                                         \
+            dst->length = n;                                                                \
+            zvec_par_task_##Name task;                                                      \
+            if (!zvec_par_prepare_##Name(&task, n, threads))                                \
+            {                                                                               \
+                for (size_t i = 0; i < n; i++)                                              \
+                {                                                                           \
+                    fn(&src->data[i], &dst->data[i], ctx);                                  \
+                }                                                                           \
+                return Z_OK;                                                                \
+            }                                                                               \
+            task.data = dst->data;                                                          \
+            task.src = src->data;                                                           \
+            task.map = fn;                                                                  \
+            task.ctx = ctx;                                                                 \
+            zvec_par_launch_##Name(&task, threads);                                         \
+            return Z_OK;                                                                    \
+        }                                                                                   \
+                                                                                            \
+        static inline void zvec_par_reduce_##Name(zvec_##Name *v, T *acc,                   \
+                                                  void (*op)(T *, const T *, void *),       \
+                                                  void *ctx, size_t threads)                \
+        {                                                                                   \
+            zvec_anchor_##Name##__(v);                                                      \
+            zvec_par_task_##Name task;                                                      \
+            T *partials = NULL;                                                             \
+            if (zvec_par_prepare_##Name(&task, v->length, threads))                         \
+            {                                                                               \
+                partials = ZVEC_SCRATCH_ALLOC__(T, task.chunks);                            \
+            }                                                                               \
+            if (!partials)                                                                  \
+            {                                                                               \
+                for (size_t i = 0; i < v->length; i++)                                      \
+                {                                                                           \
+                    op(acc, &v->data[i], ctx);                                              \
+                }                                                                           \
+                return;                                                                     \
+            }                                                                               \
+            task.src = v->data;                                                             \
+            task.partials = partials;                                                       \
+            task.op = op;                                                                   \
+            task.ctx = ctx;                                                                 \
+            zvec_par_launch_##Name(&task, threads);                                         \
+            for (size_t c = 0; c < task.chunks; c++)                                        \
+            {                                                                               \
+                op(acc, &partials[c], ctx);                                                 \
+            }                                                                               \
+            ZVEC_SCRATCH_FREE__(partials);                                                  \
+        }                                                                                   \
+                                                                                            \
+        ZVEC_GEN_PAR_SORT_CORE__(T, Name, ZVEC_CMP_LESS__)                                  \
+                                                                                            \
+        static inline void zvec_par_sort_##Name(zvec_##Name *v,                             \
+                                                int (*compar)(const T *, const T *),        \
+                                                size_t threads)                             \
+        {                                                                                   \
+            zvec_anchor_##Name##__(v);                                                      \
+            zvec_par_sort_run_##Name(v->data, v->length, compar, threads);                  \
+        }
+
+#   define ZVEC_GEN_PAR_SORT_BY__(T, Name, By, LESS)                                        \
+        ZVEC_GEN_PAR_SORT_CORE__(T, Name##_by_##By, LESS)                                   \
+                                                                                            \
+        static inline void zvec_par_sort_##Name##_by_##By(zvec_##Name *v, size_t threads)   \
+        {                                                                                   \
+            zvec_anchor_##Name##__(v);                                                      \
+            zvec_par_sort_run_##Name##_by_##By(v->data, v->length, NULL, threads);          \
+        }
+
+#else
+#   define ZVEC_GEN_PAR__(T, Name)
+#   define ZVEC_GEN_PAR_SORT_BY__(T, Name, By, LESS)
+#endif // ZTHREAD_H
+
 // Dispatch table entries for _Generic.
 #define PUSH_ENTRY(T, Name)         zvec_##Name *: zvec_push_##Name,
 #define PUSH_SLOT_ENTRY(T, Name)    zvec_##Name *: zvec_push_slot_##Name,
@@ -1017,11 +2079,27 @@ extern "C" {
 #   define Z_AUTOGEN_VECS(X)
 #endif
 
+#ifndef REGISTER_ZVEC_SMALL_TYPES
+#   define REGISTER_ZVEC_SMALL_TYPES(X)
+#endif
+
+#ifndef Z_AUTOGEN_SMALL_VECS
+#   define Z_AUTOGEN_SMALL_VECS(X)
+#endif
+
+#define Z_ALL_SMALL_VECS(X)         \
+    Z_AUTOGEN_SMALL_VECS(X)         \
+    REGISTER_ZVEC_SMALL_TYPES(X)
+
+// Small vectors are listed with the rest; only the generator below tells them apart.
 #define Z_ALL_VECS(X)       \
     Z_AUTOGEN_VECS(X)       \
-    REGISTER_ZVEC_TYPES(X)
+    REGISTER_ZVEC_TYPES(X)  \
+    Z_ALL_SMALL_VECS(X)
 
-Z_ALL_VECS(ZVEC_GENERATE_IMPL)
+Z_AUTOGEN_VECS(ZVEC_GENERATE_IMPL)
+REGISTER_ZVEC_TYPES(ZVEC_GENERATE_IMPL)
+Z_ALL_SMALL_VECS(ZVEC_GENERATE_SMALL_IMPL)
 
 // Public convenience macros.
 
@@ -1082,11 +2160,17 @@ Z_ALL_VECS(ZVEC_GENERATE_IMPL)
 #   define zvec_lower_bound(v, k, c)  _Generic((v), Z_ALL_VECS(LOWER_BOUND_ENTRY)   default: (void *)0)(v, k, c)
 #endif
 
+// Runtime allocator (Z_ALLOCATOR_HANDLE, C only): v must not own memory yet.
+#if defined(Z_ALLOCATOR_HANDLE) && !defined(__cplusplus)
+#   define SET_ALLOCATOR_ENTRY(T, Name) zvec_##Name *: zvec_set_allocator_##Name,
+#   define zvec_set_allocator(v, a)   _Generic((v), Z_ALL_VECS(SET_ALLOCATOR_ENTRY) default: (void)0)(v, a)
+#endif
+
 /* * Explicit declaration macro (portable C99)
  * Usage: zvec_foreach_decl(Int, &vec, it) { ... }
  */
 #define zvec_foreach_decl(Name, v, iter)                                        \
-    for (zvec_T_##Name *iter = (v)->data;                                       \
+    for (zvec_T_##Name *iter = zvec_data_##Name(v);                             \
          iter < (v)->data + (v)->length;                                        \
          ++iter)
 
@@ -1094,7 +2178,7 @@ Z_ALL_VECS(ZVEC_GENERATE_IMPL)
 #if defined(__GNUC__) || defined(__clang__)
 
     #define zvec_foreach(v, iter)                                               \
-        for (__typeof__((v)->data) iter = (v)->data;                            \
+        for (__typeof__((v)->data) iter = zvec_data(v);                         \
              iter < (v)->data + (v)->length;                                    \
              ++iter)
 
@@ -1104,7 +2188,7 @@ Z_ALL_VECS(ZVEC_GENERATE_IMPL)
      * Usage: int *it; zvec_foreach(&vec, it) { ... }
      */
     #define zvec_foreach(v, iter)                                               \
-        for ((iter) = (v)->data;                                                \
+        for ((iter) = zvec_data(v);                                             \
              (iter) < (v)->data + (v)->length;                                  \
              ++(iter))
 
@@ -1184,11 +2268,20 @@ namespace z_vec
             static inline void init(c_type &v)                              \
             {                                                               \
                 v = ::zvec_init_capacity_##Name(0);                         \
+                ::zvec_anchor_##Name##__(&v);                               \
             }                                                               \
                                                                             \
             static inline void init_cap(c_type &v, size_t c)                \
             {                                                               \
                 v = ::zvec_init_capacity_##Name(c);                         \
+                ::zvec_anchor_##Name##__(&v);                               \
+            }                                                               \
+                                                                            \
+            static inline void move(c_type &dst, c_type &src)               \
+            {                                                               \
+                dst = std::move(src);                                       \
+                ::zvec_anchor_##Name##__(&dst);                             \
+                init(src);                                                  \
             }                                                               \
                                                                             \
             static inline void free(c_type &v)                              \